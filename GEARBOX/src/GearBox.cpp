@@ -42,6 +42,7 @@ GearBox::GearBox(QWidget* parent)
 	m_RenderSurfaceCI.vSync = true;
 	m_RenderSurfaceCI.samples = Image::SampleCountBit::SAMPLE_COUNT_8_BIT;
 	m_RenderSurfaceCI.graphicsDebugger = debug::GraphicsDebugger::DebuggerType::NONE;
+	m_RenderSurfaceCI.framesInFlight = 2;
 	m_RenderSurface = gear::CreateRef<RenderSurface>(&m_RenderSurfaceCI);
 	ui.scenePlayerDockWidgetContents->UpdateRenderingLabels(m_RenderSurface);
 
@@ -50,7 +51,7 @@ GearBox::GearBox(QWidget* parent)
 	mbmCI.defaultBlockSize = Allocator::BlockSize::BLOCK_SIZE_128MB;
 	AllocatorManager::Initialise(&mbmCI);
 
-	m_Renderer = gear::CreateRef<Renderer>(m_RenderSurface->GetContext());
+	m_Renderer = gear::CreateRef<Renderer>(m_RenderSurface->GetContext(), m_RenderSurface->GetFramesInFlight());
 	m_Renderer->InitialiseRenderPipelines({ "res/pipelines/PBROpaque.grpf.json", "res/pipelines/Cube.grpf.json" }, (float)m_RenderSurface->GetWidth(), (float)m_RenderSurface->GetHeight(), m_RenderSurface->GetCreateInfo().samples, m_RenderSurface->GetRenderPass());
 
 	Skybox::CreateInfo skyboxCI;
@@ -97,6 +98,7 @@ GearBox::GearBox(QWidget* parent)
 		texCI.dataType = Texture::DataType::FILE;
 		texCI.file.filepaths = &filepath;
 		texCI.file.count = 1;
+		texCI.file.flipVertically = false;
 		texCI.mipLevels = 1;
 		texCI.arrayLayers = 1;
 		texCI.type = miru::crossplatform::Image::Type::TYPE_2D;
@@ -235,7 +237,7 @@ void GearBox::Render()
 	m_ActiveScene->OnUpdate(m_Renderer, m_GearTimer);
 
 	m_Renderer->SubmitFramebuffer(m_RenderSurface->GetFramebuffers());
-	m_Renderer->Upload(true, false, true, false);
+	m_Renderer->Upload();
 	m_Renderer->Flush();
 
 	m_Renderer->Present(m_RenderSurface->GetSwapchain(), windowResize);
@@ -0,0 +1,46 @@
+#include "msc_common.h"
+#include "UniformBufferStructures.h"
+#include "StorageBufferMacros.h"
+
+MIRU_UNIFORM_BUFFER(0, 0, CullInfo, cullInfo);
+MIRU_STRUCTURED_BUFFER(0, 1, DrawInstance, drawInstances);
+MIRU_RW_STRUCTURED_BUFFER(0, 2, DrawIndexedIndirectCommand, drawCommands);
+MIRU_RW_STRUCTURED_BUFFER(0, 3, uint, drawCounts);
+
+bool IsSphereInFrustum(float3 centre, float radius)
+{
+	for (uint i = 0; i < 6; i++)
+	{
+		if (dot(cullInfo.frustumPlanes[i].xyz, centre) + cullInfo.frustumPlanes[i].w < -radius)
+			return false;
+	}
+	return true;
+}
+
+//One thread per instance. Visible instances append a draw command to their batch's range, so each batch's 
+//commands are compacted to the front of its range. The order within a batch is not deterministic.
+MIRU_COMPUTE_LAYOUT(64, 1, 1)
+void cull(uint3 threadID : MIRU_DISPATCH_THREAD_ID)
+{
+	uint instanceIndex = threadID.x;
+	if (instanceIndex >= cullInfo.instanceCount)
+		return;
+
+	DrawInstance instance = drawInstances[instanceIndex];
+	float4x4 modl = transpose(instance.modl);
+	float3 centre = mul(modl, float4(instance.boundingSphere.xyz, 1.0)).xyz;
+	float scale = max(max(length(modl._m00_m10_m20), length(modl._m01_m11_m21)), length(modl._m02_m12_m22));
+	if (!IsSphereInFrustum(centre, instance.boundingSphere.w * scale))
+		return;
+
+	uint slot;
+	InterlockedAdd(drawCounts[instance.batchIndex], 1, slot);
+
+	DrawIndexedIndirectCommand command;
+	command.indexCount = instance.indexCount;
+	command.instanceCount = 1;
+	command.firstIndex = instance.firstIndex;
+	command.vertexOffset = instance.vertexOffset;
+	command.firstInstance = instanceIndex;
+	drawCommands[instance.batchOffset + slot] = command;
+}
\ No newline at end of file
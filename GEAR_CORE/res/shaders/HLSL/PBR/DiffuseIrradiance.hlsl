@@ -1,9 +1,10 @@
 #include "msc_common.h"
 #include "PBRFunctions.h"
 #include "../CubeFunctions.h"
+#include "../StorageImageFormat.h"
 
 MIRU_COMBINED_IMAGE_SAMPLER(MIRU_IMAGE_CUBE, 0, 0, float4, environment);
-MIRU_RW_IMAGE_2D_ARRAY(0, 1, float4, diffuseIrradiance);
+GEAR_STORAGE_IMAGE_FORMAT MIRU_RW_IMAGE_2D_ARRAY(0, 1, float4, diffuseIrradiance);
 
 static const uint NumSamples = 64 * 1024;
 
@@ -2,7 +2,24 @@
 #include "UniformBufferStructures.h"
 #include "PBRFunctions.h"
 #include "../CubeFunctions.h"
+#include "../StorageBufferMacros.h"
 
+//The GPU-driven variant reads its per instance data from a storage buffer and needs bindless materials.
+#if defined(GEAR_GPU_DRIVEN) && !defined(GEAR_BINDLESS)
+#define GEAR_BINDLESS
+#endif
+
+#if defined(GEAR_QUANTISED_VERTEX)
+//Matches ModelLoader::QuantisedVertex: unorm16 positions in the bounds of the mesh, a snorm16 tangent frame quaternion,
+//half texture coordinates and a unorm8 colour.
+struct VS_IN
+{
+	MIRU_LOCATION(0, uint2, positions, POSITION0);
+	MIRU_LOCATION(1, uint2, tangentFrames, TANGENT1);
+	MIRU_LOCATION(2, uint, texCoords, TEXCOORD2);
+	MIRU_LOCATION(3, uint, colours, COLOR3);
+};
+#else
 struct VS_IN
 {
 	MIRU_LOCATION(0, float4, positions, POSITION0);
@@ -12,6 +29,7 @@ struct VS_IN
 	MIRU_LOCATION(4, float4, binormals, BINORMAL4);
 	MIRU_LOCATION(5, float4, colours, COLOR5);
 };
+#endif
 
 struct VS_OUT
 {
@@ -21,6 +39,9 @@ struct VS_OUT
 	MIRU_LOCATION(6, float4, worldSpace, POSITION6);
 	MIRU_LOCATION(7, float4, vertexToCamera, POSITION7);
 	MIRU_LOCATION(8, float4, colour, COLOR8);
+#if defined(GEAR_GPU_DRIVEN)
+	MIRU_LOCATION(9, nointerpolation uint, materialID, MATERIALID9);
+#endif
 };
 typedef VS_OUT PS_IN;
 
@@ -35,8 +56,23 @@ MIRU_COMBINED_IMAGE_SAMPLER(MIRU_IMAGE_CUBE, 0, 2, float4, diffuseIrradiance);
 MIRU_COMBINED_IMAGE_SAMPLER(MIRU_IMAGE_CUBE, 0, 3, float4, specularIrradiance);
 MIRU_COMBINED_IMAGE_SAMPLER(MIRU_IMAGE_2D, 0, 4, float4, specularBRDF_LUT);
 
+#if defined(GEAR_GPU_DRIVEN)
+MIRU_STRUCTURED_BUFFER(1, 0, DrawInstance, drawInstances);
+#else
 MIRU_UNIFORM_BUFFER(1, 0, Model, model);
+#endif
 
+#if defined(GEAR_BINDLESS)
+//All materials share one set: a table of materials and a table of textures, indexed by the material ID.
+MIRU_STRUCTURED_BUFFER(2, 0, BindlessMaterial, bindlessMaterials);
+MIRU_COMBINED_IMAGE_SAMPLER_ARRAY(MIRU_IMAGE_2D, 2, 1, float4, bindlessTextures, MAX_BINDLESS_TEXTURES);
+#if defined(GEAR_GPU_DRIVEN)
+#define GEAR_MATERIAL_ID(IN) IN.materialID
+#else
+MIRU_PUSH_CONSTANT(MaterialIndex, materialIndex);
+#define GEAR_MATERIAL_ID(IN) materialIndex.materialID
+#endif
+#else
 MIRU_UNIFORM_BUFFER(2, 0, PBRConstants, pbrConstants);
 MIRU_COMBINED_IMAGE_SAMPLER(MIRU_IMAGE_2D, 2, 1, float4, normal);
 MIRU_COMBINED_IMAGE_SAMPLER(MIRU_IMAGE_2D, 2, 2, float4, albedo);
@@ -44,24 +80,94 @@ MIRU_COMBINED_IMAGE_SAMPLER(MIRU_IMAGE_2D, 2, 3, float4, metallic);
 MIRU_COMBINED_IMAGE_SAMPLER(MIRU_IMAGE_2D, 2, 4, float4, roughness);
 MIRU_COMBINED_IMAGE_SAMPLER(MIRU_IMAGE_2D, 2, 5, float4, ambientOcclusion);
 MIRU_COMBINED_IMAGE_SAMPLER(MIRU_IMAGE_2D, 2, 6, float4, emissive);
+#endif
 
 static const uint MAX_LIGHTS = 8;
 
-VS_OUT vs_main(VS_IN IN)
+VS_OUT vs_main(VS_IN IN
+#if defined(GEAR_GPU_DRIVEN)
+	, uint instanceID : SV_InstanceID
+#endif
+	)
 {
 	VS_OUT OUT;
+#if defined(GEAR_GPU_DRIVEN)
+	//On Vulkan the instance ID includes the firstInstance of the draw, which the cull pass sets to the instance's index.
+	DrawInstance model = drawInstances[instanceID];
+	OUT.materialID = model.materialID;
+#endif
+
+#if defined(GEAR_QUANTISED_VERTEX)
+	const float3 quantisedPosition = float3(IN.positions.x & 0xFFFF, IN.positions.x >> 16, IN.positions.y & 0xFFFF);
+	const float4 positions = float4(model.positionOffset.xyz + quantisedPosition * model.positionScale.xyz, 1.0);
+	
+	//Sign extend the snorm16 components of the quaternion. A negative w marks a reflected binormal.
+	const int4 tangentFrame = int4(int(IN.tangentFrames.x << 16) >> 16, int(IN.tangentFrames.x) >> 16, int(IN.tangentFrames.y << 16) >> 16, int(IN.tangentFrames.y) >> 16);
+	const float4 q = normalize(max(float4(tangentFrame) / 32767.0, -1.0));
+	const float reflection = q.w < 0.0 ? -1.0 : 1.0;
+	const float4 tangents = float4(1.0 - 2.0 * (q.y * q.y + q.z * q.z), 2.0 * (q.x * q.y + q.w * q.z), 2.0 * (q.x * q.z - q.w * q.y), 0.0);
+	const float4 binormals = float4(2.0 * (q.x * q.y - q.w * q.z), 1.0 - 2.0 * (q.x * q.x + q.z * q.z), 2.0 * (q.y * q.z + q.w * q.x), 0.0) * reflection;
+	const float4 normals = float4(2.0 * (q.x * q.z + q.w * q.y), 2.0 * (q.y * q.z - q.w * q.x), 1.0 - 2.0 * (q.x * q.x + q.y * q.y), 0.0);
 	
-	OUT.position = mul(mul(mul(transpose(camera.proj), transpose(camera.view)), transpose(model.modl)), IN.positions);
-	OUT.texCoord = float2(model.texCoordScale0.x * IN.texCoords.x, model.texCoordScale0.y * IN.texCoords.y);
-	OUT.tbn = transpose(float3x3(mul(transpose(model.modl), IN.tangents).xyz, mul(transpose(model.modl), IN.binormals).xyz, mul(transpose(model.modl), IN.normals).xyz));
-	OUT.worldSpace = mul(transpose(model.modl), IN.positions);	
+	const float2 texCoords = f16tof32(uint2(IN.texCoords & 0xFFFF, IN.texCoords >> 16));
+	const float4 colours = float4(IN.colours & 0xFF, (IN.colours >> 8) & 0xFF, (IN.colours >> 16) & 0xFF, IN.colours >> 24) / 255.0;
+#else
+	const float4 positions = IN.positions;
+	const float4 normals = IN.normals;
+	const float4 tangents = IN.tangents;
+	const float4 binormals = IN.binormals;
+	const float2 texCoords = IN.texCoords;
+	const float4 colours = IN.colours;
+#endif
+	
+	OUT.position = mul(mul(mul(transpose(camera.proj), transpose(camera.view)), transpose(model.modl)), positions);
+	OUT.texCoord = float2(model.texCoordScale0.x * texCoords.x, model.texCoordScale0.y * texCoords.y);
+	OUT.tbn = transpose(float3x3(mul(transpose(model.modl), tangents).xyz, mul(transpose(model.modl), binormals).xyz, mul(transpose(model.modl), normals).xyz));
+	OUT.worldSpace = mul(transpose(model.modl), positions);	
 	OUT.vertexToCamera = normalize(camera.cameraPosition - OUT.worldSpace);
-	OUT.colour = IN.colours;
+	OUT.colour = colours;
 	
 	return OUT;
 }
 
 //Helper functions:
+#if defined(GEAR_BINDLESS)
+float4 SampleBindlessTexture(uint textureIndex, float2 texCoord)
+{
+	return bindlessTextures_ImageCIS[textureIndex].Sample(bindlessTextures_SamplerCIS[textureIndex], texCoord);
+}
+float3 GetNormal(PS_IN IN)
+{
+	float3 N = SampleBindlessTexture(bindlessMaterials[GEAR_MATERIAL_ID(IN)].textureIndices0.x, IN.texCoord).xyz;
+	N = normalize(2.0 * N - 1.0);
+	return normalize(mul(IN.tbn, N));
+}
+float3 GetAlbedo(PS_IN IN) 
+{ 
+	BindlessMaterial material = bindlessMaterials[GEAR_MATERIAL_ID(IN)];
+	return material.pbrConstants.albedo.rgb * SampleBindlessTexture(material.textureIndices0.y, IN.texCoord).rgb; 
+}
+float GetMetallic(PS_IN IN) 
+{ 
+	BindlessMaterial material = bindlessMaterials[GEAR_MATERIAL_ID(IN)];
+	return material.pbrConstants.metallic * SampleBindlessTexture(material.textureIndices0.z, IN.texCoord).r; 
+}
+float GetRoughness(PS_IN IN) 
+{
+	BindlessMaterial material = bindlessMaterials[GEAR_MATERIAL_ID(IN)];
+	return material.pbrConstants.roughness * SampleBindlessTexture(material.textureIndices0.w, IN.texCoord).r; 
+}
+float GetAmbientOcclusion(PS_IN IN) 
+{
+	BindlessMaterial material = bindlessMaterials[GEAR_MATERIAL_ID(IN)];
+	return material.pbrConstants.ambientOcclusion * SampleBindlessTexture(material.textureIndices1.x, IN.texCoord).r; 
+}
+float3 GetEmissive(PS_IN IN) 
+{
+	BindlessMaterial material = bindlessMaterials[GEAR_MATERIAL_ID(IN)];
+	return material.pbrConstants.emissive.rgb * SampleBindlessTexture(material.textureIndices1.y, IN.texCoord).rgb; 
+}
+#else
 float3 GetNormal(PS_IN IN)
 {
 	float3 N = normal_ImageCIS.Sample(normal_SamplerCIS, IN.texCoord).xyz;
@@ -88,6 +194,7 @@ float3 GetEmissive(PS_IN IN)
 {
 	return pbrConstants.emissive.rgb * emissive_ImageCIS.Sample(emissive_SamplerCIS, IN.texCoord).rgb; 
 }
+#endif
 
 PS_OUT ps_main(PS_IN IN)
 {
@@ -2,9 +2,10 @@
 #include "UniformBufferStructures.h"
 #include "PBRFunctions.h"
 #include "../CubeFunctions.h"
+#include "../StorageImageFormat.h"
 
 MIRU_COMBINED_IMAGE_SAMPLER(MIRU_IMAGE_CUBE, 0, 0, float4, environment);
-MIRU_RW_IMAGE_2D_ARRAY(0, 1, float4, specularIrradiance);
+GEAR_STORAGE_IMAGE_FORMAT MIRU_RW_IMAGE_2D_ARRAY(0, 1, float4, specularIrradiance);
 MIRU_UNIFORM_BUFFER(0, 2, SpecularIrradianceInfo, specularIrradianceInfo);
 
 static const uint NumSamples = 1024;
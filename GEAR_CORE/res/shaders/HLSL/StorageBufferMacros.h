@@ -0,0 +1,15 @@
+//Fallbacks for MIRU_SHADER_COMPILER versions whose msc_common.h does not define these.
+#ifndef MIRU_STRUCTURED_BUFFER
+#define MIRU_STRUCTURED_BUFFER(set, binding, type, name) [[vk::binding(binding, set)]] StructuredBuffer<type> name : register(t##binding, space##set)
+#endif
+#ifndef MIRU_RW_STRUCTURED_BUFFER
+#define MIRU_RW_STRUCTURED_BUFFER(set, binding, type, name) [[vk::binding(binding, set)]] RWStructuredBuffer<type> name : register(u##binding, space##set)
+#endif
+#ifndef MIRU_COMBINED_IMAGE_SAMPLER_ARRAY
+#define MIRU_COMBINED_IMAGE_SAMPLER_ARRAY(type, set, binding, ret_type, name, count) \
+	[[vk::combinedImageSampler]][[vk::binding(binding, set)]] type<ret_type> name##_ImageCIS[count] : register(t##binding, space##set); \
+	[[vk::combinedImageSampler]][[vk::binding(binding, set)]] SamplerState name##_SamplerCIS[count] : register(s##binding, space##set)
+#endif
+#ifndef MIRU_PUSH_CONSTANT
+#define MIRU_PUSH_CONSTANT(type, name) [[vk::push_constant]] ConstantBuffer<type> name : register(b0, space15)
+#endif
\ No newline at end of file
@@ -0,0 +1,13 @@
+//The format of the storage images written by the image processing shaders, which is selected by the macros of the
+//pipeline. Each storage format has its own pipeline, as Vulkan only writes storage images that are declared without a
+//format on devices with shaderStorageImageWriteWithoutFormat. GEAR_STORAGE_IMAGE_FORMAT_ANY declares them without one,
+//for the formats that have no pipeline of their own. The attribute is ignored when compiling for D3D12.
+#if defined(GEAR_STORAGE_IMAGE_FORMAT_RGBA8)
+#define GEAR_STORAGE_IMAGE_FORMAT [[vk::image_format("rgba8")]]
+#elif defined(GEAR_STORAGE_IMAGE_FORMAT_RGBA32F)
+#define GEAR_STORAGE_IMAGE_FORMAT [[vk::image_format("rgba32f")]]
+#elif defined(GEAR_STORAGE_IMAGE_FORMAT_ANY)
+#define GEAR_STORAGE_IMAGE_FORMAT
+#else
+#define GEAR_STORAGE_IMAGE_FORMAT [[vk::image_format("rgba16f")]]
+#endif
\ No newline at end of file
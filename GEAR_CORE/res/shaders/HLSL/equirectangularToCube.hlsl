@@ -1,8 +1,9 @@
 #include "msc_common.h"
 #include "CubeFunctions.h"
+#include "StorageImageFormat.h"
 
 MIRU_COMBINED_IMAGE_SAMPLER(MIRU_IMAGE_2D, 0, 0, float4, equirectangularImage);
-MIRU_RW_IMAGE_2D_ARRAY(0, 1, float4, cubeImage);
+GEAR_STORAGE_IMAGE_FORMAT MIRU_RW_IMAGE_2D_ARRAY(0, 1, float4, cubeImage);
 
 MIRU_COMPUTE_LAYOUT(32, 32, 1)
 void main(uint3 threadID : MIRU_DISPATCH_THREAD_ID)
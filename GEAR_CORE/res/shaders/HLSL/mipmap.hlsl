@@ -1,10 +1,11 @@
 #include "msc_common.h"
+#include "StorageImageFormat.h"
 
 MIRU_IMAGE_2D(0, 0, float4, inputImage);
-MIRU_RW_IMAGE_2D(0, 1, float4, outputImage);
+GEAR_STORAGE_IMAGE_FORMAT MIRU_RW_IMAGE_2D(0, 1, float4, outputImage);
 
 MIRU_IMAGE_2D_ARRAY(0, 0, float4, inputImageArray);
-MIRU_RW_IMAGE_2D_ARRAY(0, 1, float4, outputImageArray);
+GEAR_STORAGE_IMAGE_FORMAT MIRU_RW_IMAGE_2D_ARRAY(0, 1, float4, outputImageArray);
 
 float4 ColateColour(uint2 threadID)
 {
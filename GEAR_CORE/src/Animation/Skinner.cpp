@@ -0,0 +1,558 @@
+#include "gear_core_common.h"
+#include "Skinner.h"
+#include "Objects/Mesh.h"
+
+#include <unordered_map>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define GEAR_SKINNER_SSE
+#include <immintrin.h>
+#endif
+
+using namespace gear;
+using namespace animation;
+
+//Meshes with fewer vertices than this are skinned on the calling thread, as they take less time than handing them to the workers.
+static const size_t s_MinParallelVertexCount = 4096;
+
+//Rows of an affine transform of column vectors.
+struct Affine
+{
+	float m[3][4];
+};
+
+static Affine Identity()
+{
+	return { { { 1.0f, 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f, 0.0f } } };
+}
+
+static Affine Multiply(const Affine& a, const Affine& b)
+{
+	Affine c;
+	for (size_t r = 0; r < 3; r++)
+	{
+		for (size_t j = 0; j < 4; j++)
+			c.m[r][j] = a.m[r][0] * b.m[0][j] + a.m[r][1] * b.m[1][j] + a.m[r][2] * b.m[2][j] + (j == 3 ? a.m[r][3] : 0.0f);
+	}
+	return c;
+}
+
+static Affine Inverse(const Affine& a)
+{
+	//The inverse of the upper 3x3 from its adjugate, and the translation taken back through it.
+	const float (&m)[3][4] = a.m;
+	const float cofactors[3][3] = {
+		{ m[1][1] * m[2][2] - m[1][2] * m[2][1], m[1][2] * m[2][0] - m[1][0] * m[2][2], m[1][0] * m[2][1] - m[1][1] * m[2][0] },
+		{ m[0][2] * m[2][1] - m[0][1] * m[2][2], m[0][0] * m[2][2] - m[0][2] * m[2][0], m[0][1] * m[2][0] - m[0][0] * m[2][1] },
+		{ m[0][1] * m[1][2] - m[0][2] * m[1][1], m[0][2] * m[1][0] - m[0][0] * m[1][2], m[0][0] * m[1][1] - m[0][1] * m[1][0] } };
+	const float determinant = m[0][0] * cofactors[0][0] + m[0][1] * cofactors[0][1] + m[0][2] * cofactors[0][2];
+	if (determinant == 0.0f)
+		return Identity();
+
+	Affine inverse;
+	for (size_t r = 0; r < 3; r++)
+	{
+		for (size_t j = 0; j < 3; j++)
+			inverse.m[r][j] = cofactors[j][r] / determinant;
+		inverse.m[r][3] = -(inverse.m[r][0] * m[0][3] + inverse.m[r][1] * m[1][3] + inverse.m[r][2] * m[2][3]);
+	}
+	return inverse;
+}
+
+static Affine ToAffine(const mars::Mat4& modl)
+{
+	return { { { modl.a, modl.b, modl.c, modl.d }, { modl.e, modl.f, modl.g, modl.h }, { modl.i, modl.j, modl.k, modl.l } } };
+}
+
+//Translation * Rotation * Scale, as TransformToMat4().
+static Affine ToAffine(const objects::Transform& transform)
+{
+	float q[4] = { static_cast<float>(transform.orientation.i), static_cast<float>(transform.orientation.j), static_cast<float>(transform.orientation.k), static_cast<float>(transform.orientation.s) };
+	const float length = std::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+	for (size_t i = 0; i < 4; i++)
+		q[i] = length > 0.0f ? q[i] / length : (i == 3 ? 1.0f : 0.0f);
+
+	const float x = q[0], y = q[1], z = q[2], w = q[3];
+	const float rotation[3][3] = {
+		{ 1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y - z * w), 2.0f * (x * z + y * w) },
+		{ 2.0f * (x * y + z * w), 1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z - x * w) },
+		{ 2.0f * (x * z - y * w), 2.0f * (y * z + x * w), 1.0f - 2.0f * (x * x + y * y) } };
+	const float scale[3] = { transform.scale.x, transform.scale.y, transform.scale.z };
+	const float translation[3] = { transform.translation.x, transform.translation.y, transform.translation.z };
+
+	Affine affine;
+	for (size_t r = 0; r < 3; r++)
+	{
+		for (size_t j = 0; j < 3; j++)
+			affine.m[r][j] = rotation[r][j] * scale[j];
+		affine.m[r][3] = translation[r];
+	}
+	return affine;
+}
+
+//Interpolates the channel's component of the transform at the tick. Rotations are normalised linear interpolations
+//along the shorter arc, which is close to a slerp between keyframes.
+static void Sample(const NodeAnimation& nodeAnimation, double tick, objects::Transform& transform)
+{
+	const NodeAnimation::Keyframes& keyframes = nodeAnimation.keyframes;
+	if (keyframes.empty())
+		return;
+
+	auto next = std::upper_bound(keyframes.begin(), keyframes.end(), tick, [](double t, const NodeAnimation::Keyframe& keyframe) { return t < keyframe.first; });
+	const NodeAnimation::Keyframe& kf1 = next == keyframes.begin() ? *next : *(next - 1);
+	const NodeAnimation::Keyframe& kf2 = next == keyframes.end() ? kf1 : *next;
+	const float t = kf2.first > kf1.first ? static_cast<float>(std::min(std::max((tick - kf1.first) / (kf2.first - kf1.first), 0.0), 1.0)) : 0.0f;
+
+	if (nodeAnimation.type == NodeAnimation::Type::TRANSLATION)
+	{
+		transform.translation = kf1.second.translation + (kf2.second.translation - kf1.second.translation) * t;
+	}
+	else if (nodeAnimation.type == NodeAnimation::Type::ROTATION)
+	{
+		const mars::Quat& q1 = kf1.second.orientation;
+		const mars::Quat& q2 = kf2.second.orientation;
+		const float a[4] = { static_cast<float>(q1.s), static_cast<float>(q1.i), static_cast<float>(q1.j), static_cast<float>(q1.k) };
+		const float b[4] = { static_cast<float>(q2.s), static_cast<float>(q2.i), static_cast<float>(q2.j), static_cast<float>(q2.k) };
+		const float sign = a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3] < 0.0f ? -1.0f : 1.0f;
+		float q[4];
+		for (size_t i = 0; i < 4; i++)
+			q[i] = a[i] * (1.0f - t) + b[i] * sign * t;
+		transform.orientation = mars::Quat(q[0], q[1], q[2], q[3]); //Normalised by ToAffine().
+	}
+	else if (nodeAnimation.type == NodeAnimation::Type::SCALE)
+	{
+		transform.scale = kf1.second.scale + (kf2.second.scale - kf1.second.scale) * t;
+	}
+}
+
+typedef std::unordered_map<std::string, std::vector<const NodeAnimation*>> Channels;
+
+static void PoseNode(const ModelLoader::Node& node, const Affine& parent, const Channels& channels, double tick, std::unordered_map<std::string, Affine>& nodeTransforms, std::vector<Affine>& meshNodeTransforms)
+{
+	Affine local;
+	auto it = channels.find(node.name);
+	if (it != channels.end())
+	{
+		objects::Transform transform;
+		for (const NodeAnimation* nodeAnimation : it->second)
+			Sample(*nodeAnimation, tick, transform);
+		local = ToAffine(transform);
+	}
+	else
+	{
+		local = ToAffine(node.transform);
+	}
+
+	const Affine global = Multiply(parent, local);
+	nodeTransforms[node.name] = global;
+	if (node.meshIndex < meshNodeTransforms.size())
+		meshNodeTransforms[node.meshIndex] = global;
+
+	for (const ModelLoader::Node& child : node.children)
+		PoseNode(child, global, channels, tick, nodeTransforms, meshNodeTransforms);
+}
+
+static float GetRestWeight(const ModelLoader::BoneInfluence& influence)
+{
+	const int32_t sum = int32_t(influence.weights[0]) + int32_t(influence.weights[1]) + int32_t(influence.weights[2]) + int32_t(influence.weights[3]);
+	return static_cast<float>(65535 - sum) * (1.0f / 65535.0f);
+}
+
+#if defined(GEAR_SKINNER_SSE)
+template<int i>
+static inline __m128 Splat_SSE2(__m128 v)
+{
+	return _mm_shuffle_ps(v, v, _MM_SHUFFLE(i, i, i, i));
+}
+
+static inline __m128 LoadWeights_SSE2(const ModelLoader::BoneInfluence& influence)
+{
+	const __m128i weights = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(influence.weights));
+	return _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(weights, _mm_setzero_si128())), _mm_set1_ps(1.0f / 65535.0f));
+}
+
+//The w of the result is 0.
+static inline __m128 Cross_SSE2(__m128 a, __m128 b)
+{
+	const __m128 c = _mm_sub_ps(_mm_mul_ps(a, _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1))), _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1)), b));
+	return _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1));
+}
+
+//The dot product in every lane.
+static inline __m128 Dot_SSE2(__m128 a, __m128 b)
+{
+	__m128 d = _mm_mul_ps(a, b);
+	d = _mm_add_ps(d, _mm_shuffle_ps(d, d, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_add_ps(d, _mm_shuffle_ps(d, d, _MM_SHUFFLE(1, 0, 3, 2)));
+}
+
+static inline __m128 TransformLinearBlend_SSE2(const __m128 columns[4], const mars::Vec4& v)
+{
+	const __m128 x = _mm_loadu_ps(&v.x);
+	__m128 result = _mm_mul_ps(columns[0], Splat_SSE2<0>(x));
+	result = _mm_add_ps(result, _mm_mul_ps(columns[1], Splat_SSE2<1>(x)));
+	result = _mm_add_ps(result, _mm_mul_ps(columns[2], Splat_SSE2<2>(x)));
+	return _mm_add_ps(result, _mm_mul_ps(columns[3], Splat_SSE2<3>(x)));
+}
+
+static void SkinLinearBlend_SSE2(const ModelLoader::Vertex* src, const ModelLoader::BoneInfluence* influences, size_t count, const Skinner::BoneMatrix* palette, ModelLoader::Vertex* dst)
+{
+	const __m128 identity[4] = { _mm_setr_ps(1.0f, 0.0f, 0.0f, 0.0f), _mm_setr_ps(0.0f, 1.0f, 0.0f, 0.0f), _mm_setr_ps(0.0f, 0.0f, 1.0f, 0.0f), _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f) };
+	for (size_t i = 0; i < count; i++)
+	{
+		const ModelLoader::BoneInfluence& influence = influences[i];
+		const __m128 weights = LoadWeights_SSE2(influence);
+		const __m128 w[4] = { Splat_SSE2<0>(weights), Splat_SSE2<1>(weights), Splat_SSE2<2>(weights), Splat_SSE2<3>(weights) };
+		const __m128 rest = _mm_set1_ps(GetRestWeight(influence));
+		const Skinner::BoneMatrix* bones[4] = { &palette[influence.indices[0]], &palette[influence.indices[1]], &palette[influence.indices[2]], &palette[influence.indices[3]] };
+
+		__m128 columns[4];
+		for (size_t j = 0; j < 4; j++)
+		{
+			__m128 column = _mm_mul_ps(identity[j], rest);
+			for (size_t k = 0; k < 4; k++)
+				column = _mm_add_ps(column, _mm_mul_ps(_mm_loadu_ps(bones[k]->columns[j]), w[k]));
+			columns[j] = column;
+		}
+
+		const ModelLoader::Vertex& source = src[i];
+		ModelLoader::Vertex& vertex = dst[i];
+		_mm_storeu_ps(&vertex.position.x, TransformLinearBlend_SSE2(columns, source.position));
+		vertex.texCoord = source.texCoord;
+		_mm_storeu_ps(&vertex.normal.x, TransformLinearBlend_SSE2(columns, source.normal));
+		_mm_storeu_ps(&vertex.tangent.x, TransformLinearBlend_SSE2(columns, source.tangent));
+		_mm_storeu_ps(&vertex.binormal.x, TransformLinearBlend_SSE2(columns, source.binormal));
+		vertex.colour = source.colour;
+	}
+}
+
+//v + 2 * cross(real, cross(real, v) + real.w * v) + translation * v.w, keeping the w of v.
+static inline __m128 TransformDualQuaternion_SSE2(__m128 real, __m128 realW, __m128 translation, const mars::Vec4& v)
+{
+	const __m128 x = _mm_loadu_ps(&v.x);
+	const __m128 c = Cross_SSE2(real, _mm_add_ps(Cross_SSE2(real, x), _mm_mul_ps(realW, x)));
+	return _mm_add_ps(_mm_add_ps(x, _mm_add_ps(c, c)), _mm_mul_ps(translation, Splat_SSE2<3>(x)));
+}
+
+static void SkinDualQuaternion_SSE2(const ModelLoader::Vertex* src, const ModelLoader::BoneInfluence* influences, size_t count, const Skinner::DualQuaternion* palette, ModelLoader::Vertex* dst)
+{
+	const __m128 identity = _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f);
+	const __m128 signBit = _mm_set1_ps(-0.0f);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	for (size_t i = 0; i < count; i++)
+	{
+		const ModelLoader::BoneInfluence& influence = influences[i];
+		const __m128 weights = LoadWeights_SSE2(influence);
+		const __m128 w[4] = { Splat_SSE2<0>(weights), Splat_SSE2<1>(weights), Splat_SSE2<2>(weights), Splat_SSE2<3>(weights) };
+
+		//Each rotation is flipped into the hemisphere of the first, so that the blend takes the shorter arc.
+		const __m128 first = _mm_loadu_ps(palette[influence.indices[0]].real);
+		__m128 real = _mm_mul_ps(identity, _mm_set1_ps(GetRestWeight(influence)));
+		__m128 dual = zero;
+		for (size_t k = 0; k < 4; k++)
+		{
+			const Skinner::DualQuaternion& bone = palette[influence.indices[k]];
+			const __m128 boneReal = _mm_loadu_ps(bone.real);
+			const __m128 weight = _mm_xor_ps(w[k], _mm_and_ps(_mm_cmplt_ps(Dot_SSE2(boneReal, first), zero), signBit));
+			real = _mm_add_ps(real, _mm_mul_ps(boneReal, weight));
+			dual = _mm_add_ps(dual, _mm_mul_ps(_mm_loadu_ps(bone.dual), weight));
+		}
+		const __m128 inverseLength = _mm_div_ps(one, _mm_sqrt_ps(Dot_SSE2(real, real)));
+		real = _mm_mul_ps(real, inverseLength);
+		dual = _mm_mul_ps(dual, inverseLength);
+
+		//2 * (real.w * dual - dual.w * real + cross(real, dual)), whose w is 0.
+		const __m128 realW = Splat_SSE2<3>(real);
+		__m128 translation = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(realW, dual), _mm_mul_ps(Splat_SSE2<3>(dual), real)), Cross_SSE2(real, dual));
+		translation = _mm_add_ps(translation, translation);
+
+		const ModelLoader::Vertex& source = src[i];
+		ModelLoader::Vertex& vertex = dst[i];
+		_mm_storeu_ps(&vertex.position.x, TransformDualQuaternion_SSE2(real, realW, translation, source.position));
+		vertex.texCoord = source.texCoord;
+		_mm_storeu_ps(&vertex.normal.x, TransformDualQuaternion_SSE2(real, realW, translation, source.normal));
+		_mm_storeu_ps(&vertex.tangent.x, TransformDualQuaternion_SSE2(real, realW, translation, source.tangent));
+		_mm_storeu_ps(&vertex.binormal.x, TransformDualQuaternion_SSE2(real, realW, translation, source.binormal));
+		vertex.colour = source.colour;
+	}
+}
+#endif
+
+Skinner::Skinner(CreateInfo* pCreateInfo)
+{
+	m_CI = *pCreateInfo;
+
+	m_ThreadPoolCI.debugName = "GEAR_CORE_ThreadPool_Skinner: " + m_CI.debugName;
+	m_ThreadPoolCI.workerCount = m_CI.workerCount;
+	m_ThreadPool = CreateRef<core::ThreadPool>(&m_ThreadPoolCI);
+}
+
+Skinner::~Skinner()
+{
+}
+
+void Skinner::BuildBonePalettes(const ModelLoader::ModelData& modelData, const Animation* animation, double time, std::vector<std::vector<BoneMatrix>>& palettes)
+{
+	//Assimp's default rate is used for animations without one.
+	Channels channels;
+	double tick = 0.0;
+	if (animation)
+	{
+		for (const NodeAnimation& nodeAnimation : animation->nodeAnimations)
+			channels[nodeAnimation.name].push_back(&nodeAnimation);
+
+		tick = time * (animation->framesPerSecond ? static_cast<double>(animation->framesPerSecond) : 25.0);
+		if (animation->duration > 0.0)
+		{
+			tick = std::fmod(tick, animation->duration);
+			if (tick < 0.0)
+				tick += animation->duration;
+		}
+	}
+
+	std::unordered_map<std::string, Affine> nodeTransforms;
+	std::vector<Affine> meshNodeTransforms(modelData.meshes.size(), Identity());
+	PoseNode(modelData.nodeGraph, Identity(), channels, tick, nodeTransforms, meshNodeTransforms);
+
+	palettes.resize(modelData.meshes.size());
+	for (size_t i = 0; i < modelData.meshes.size(); i++)
+	{
+		const std::vector<ModelLoader::Bone>& bones = modelData.meshes[i].bones;
+		const Affine inverseMeshNodeTransform = Inverse(meshNodeTransforms[i]);
+		std::vector<BoneMatrix>& palette = palettes[i];
+		palette.resize(bones.size());
+		for (size_t j = 0; j < bones.size(); j++)
+		{
+			//Bones without a node stay in the bind pose.
+			auto it = nodeTransforms.find(bones[j].name);
+			const Affine transform = it != nodeTransforms.end() ? Multiply(inverseMeshNodeTransform, Multiply(it->second, ToAffine(bones[j].transform))) : Identity();
+			for (size_t c = 0; c < 4; c++)
+			{
+				for (size_t r = 0; r < 3; r++)
+					palette[j].columns[c][r] = transform.m[r][c];
+				palette[j].columns[c][3] = c == 3 ? 1.0f : 0.0f;
+			}
+		}
+	}
+}
+
+void Skinner::Skin(objects::Mesh& mesh, const std::vector<std::vector<BoneMatrix>>& palettes, Method method)
+{
+	if (mesh.GetVertexFormat() != ModelLoader::VertexFormat::FULL)
+	{
+		GEAR_WARN(ErrorCode::OBJECTS | ErrorCode::NOT_SUPPORTED, "%s: Only meshes with VertexFormat::FULL can be skinned.", mesh.m_CI.debugName.c_str());
+		return;
+	}
+
+	const std::vector<ModelLoader::MeshData>& meshes = mesh.GetModelData().meshes;
+	for (size_t i = 0; i < meshes.size() && i < palettes.size(); i++)
+	{
+		const ModelLoader::MeshData& meshData = meshes[i];
+		if (meshData.bones.empty() || meshData.boneInfluences.size() != meshData.vertices.size())
+			continue;
+		if (palettes[i].size() < std::min<size_t>(meshData.bones.size(), 256))
+		{
+			GEAR_WARN(ErrorCode::OBJECTS | ErrorCode::INVALID_VALUE, "%s: The palette of %s has %zu of its %zu bones.", mesh.m_CI.debugName.c_str(), meshData.meshName.c_str(), palettes[i].size(), meshData.bones.size());
+			continue;
+		}
+
+		ModelLoader::Vertex* dst = reinterpret_cast<ModelLoader::Vertex*>(mesh.GetMeshPool()->UpdateVertices(mesh.GetAllocations()[i]));
+		if (dst)
+			Skin(meshData.vertices.data(), meshData.boneInfluences.data(), meshData.vertices.size(), palettes[i].data(), palettes[i].size(), method, dst);
+	}
+}
+
+void Skinner::Skin(const ModelLoader::Vertex* src, const ModelLoader::BoneInfluence* influences, size_t count, const BoneMatrix* palette, size_t boneCount, Method method, ModelLoader::Vertex* dst)
+{
+	if (count == 0)
+		return;
+
+	std::vector<DualQuaternion> dualQuaternions;
+	if (method == Method::DUAL_QUATERNION)
+	{
+		dualQuaternions.resize(boneCount);
+		ConvertToDualQuaternions(palette, boneCount, dualQuaternions.data());
+	}
+
+	auto SkinRange = [&](size_t begin, size_t end, uint32_t)
+	{
+		if (method == Method::DUAL_QUATERNION)
+			SkinDualQuaternion(src + begin, influences + begin, end - begin, dualQuaternions.data(), dst + begin);
+		else
+			SkinLinearBlend(src + begin, influences + begin, end - begin, palette, dst + begin);
+	};
+	if (count < s_MinParallelVertexCount)
+		SkinRange(0, count, 0);
+	else
+		m_ThreadPool->ParallelFor(count, SkinRange);
+}
+
+void Skinner::ConvertToDualQuaternions(const BoneMatrix* matrices, size_t count, DualQuaternion* dualQuaternions)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		//The rotation is taken from the normalised columns.
+		float m[3][3];
+		for (size_t c = 0; c < 3; c++)
+		{
+			const float* column = matrices[i].columns[c];
+			const float length = std::sqrt(column[0] * column[0] + column[1] * column[1] + column[2] * column[2]);
+			for (size_t r = 0; r < 3; r++)
+				m[r][c] = length > 0.0f ? column[r] / length : (r == c ? 1.0f : 0.0f);
+		}
+
+		float q[4]; //xyzw
+		const float trace = m[0][0] + m[1][1] + m[2][2];
+		if (trace > 0.0f)
+		{
+			const float s = std::sqrt(trace + 1.0f) * 2.0f;
+			q[0] = (m[2][1] - m[1][2]) / s; q[1] = (m[0][2] - m[2][0]) / s; q[2] = (m[1][0] - m[0][1]) / s; q[3] = 0.25f * s;
+		}
+		else if (m[0][0] > m[1][1] && m[0][0] > m[2][2])
+		{
+			const float s = std::sqrt(1.0f + m[0][0] - m[1][1] - m[2][2]) * 2.0f;
+			q[0] = 0.25f * s; q[1] = (m[0][1] + m[1][0]) / s; q[2] = (m[0][2] + m[2][0]) / s; q[3] = (m[2][1] - m[1][2]) / s;
+		}
+		else if (m[1][1] > m[2][2])
+		{
+			const float s = std::sqrt(1.0f + m[1][1] - m[0][0] - m[2][2]) * 2.0f;
+			q[0] = (m[0][1] + m[1][0]) / s; q[1] = 0.25f * s; q[2] = (m[1][2] + m[2][1]) / s; q[3] = (m[0][2] - m[2][0]) / s;
+		}
+		else
+		{
+			const float s = std::sqrt(1.0f + m[2][2] - m[0][0] - m[1][1]) * 2.0f;
+			q[0] = (m[0][2] + m[2][0]) / s; q[1] = (m[1][2] + m[2][1]) / s; q[2] = 0.25f * s; q[3] = (m[1][0] - m[0][1]) / s;
+		}
+		const float length = std::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+		for (size_t j = 0; j < 4; j++)
+			q[j] /= length;
+
+		//dual = 0.5 * (translation, 0) * real
+		const float* t = matrices[i].columns[3];
+		DualQuaternion& dualQuaternion = dualQuaternions[i];
+		memcpy(dualQuaternion.real, q, sizeof(q));
+		dualQuaternion.dual[0] = 0.5f * (q[3] * t[0] + t[1] * q[2] - t[2] * q[1]);
+		dualQuaternion.dual[1] = 0.5f * (q[3] * t[1] + t[2] * q[0] - t[0] * q[2]);
+		dualQuaternion.dual[2] = 0.5f * (q[3] * t[2] + t[0] * q[1] - t[1] * q[0]);
+		dualQuaternion.dual[3] = -0.5f * (t[0] * q[0] + t[1] * q[1] + t[2] * q[2]);
+	}
+}
+
+void Skinner::SkinLinearBlend(const ModelLoader::Vertex* src, const ModelLoader::BoneInfluence* influences, size_t count, const BoneMatrix* palette, ModelLoader::Vertex* dst)
+{
+#if defined(GEAR_SKINNER_SSE)
+	SkinLinearBlend_SSE2(src, influences, count, palette, dst);
+#else
+	SkinLinearBlendReference(src, influences, count, palette, dst);
+#endif
+}
+
+void Skinner::SkinDualQuaternion(const ModelLoader::Vertex* src, const ModelLoader::BoneInfluence* influences, size_t count, const DualQuaternion* palette, ModelLoader::Vertex* dst)
+{
+#if defined(GEAR_SKINNER_SSE)
+	SkinDualQuaternion_SSE2(src, influences, count, palette, dst);
+#else
+	SkinDualQuaternionReference(src, influences, count, palette, dst);
+#endif
+}
+
+void Skinner::SkinLinearBlendReference(const ModelLoader::Vertex* src, const ModelLoader::BoneInfluence* influences, size_t count, const BoneMatrix* palette, ModelLoader::Vertex* dst)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		const ModelLoader::BoneInfluence& influence = influences[i];
+		const float rest = GetRestWeight(influence);
+
+		float columns[4][4];
+		for (size_t j = 0; j < 4; j++)
+		{
+			for (size_t r = 0; r < 4; r++)
+				columns[j][r] = j == r ? rest : 0.0f;
+		}
+		for (size_t k = 0; k < 4; k++)
+		{
+			const float weight = static_cast<float>(influence.weights[k]) * (1.0f / 65535.0f);
+			const BoneMatrix& bone = palette[influence.indices[k]];
+			for (size_t j = 0; j < 4; j++)
+			{
+				for (size_t r = 0; r < 4; r++)
+					columns[j][r] += bone.columns[j][r] * weight;
+			}
+		}
+
+		auto Transform = [&columns](const mars::Vec4& v) -> mars::Vec4
+		{
+			float result[4];
+			for (size_t r = 0; r < 4; r++)
+				result[r] = columns[0][r] * v.x + columns[1][r] * v.y + columns[2][r] * v.z + columns[3][r] * v.w;
+			return mars::Vec4(result[0], result[1], result[2], result[3]);
+		};
+
+		const ModelLoader::Vertex& source = src[i];
+		ModelLoader::Vertex& vertex = dst[i];
+		vertex.position = Transform(source.position);
+		vertex.texCoord = source.texCoord;
+		vertex.normal = Transform(source.normal);
+		vertex.tangent = Transform(source.tangent);
+		vertex.binormal = Transform(source.binormal);
+		vertex.colour = source.colour;
+	}
+}
+
+void Skinner::SkinDualQuaternionReference(const ModelLoader::Vertex* src, const ModelLoader::BoneInfluence* influences, size_t count, const DualQuaternion* palette, ModelLoader::Vertex* dst)
+{
+	auto Cross = [](const float a[3], const float b[3], float c[3]) { c[0] = a[1] * b[2] - a[2] * b[1]; c[1] = a[2] * b[0] - a[0] * b[2]; c[2] = a[0] * b[1] - a[1] * b[0]; };
+
+	for (size_t i = 0; i < count; i++)
+	{
+		const ModelLoader::BoneInfluence& influence = influences[i];
+		const float rest = GetRestWeight(influence);
+
+		const float* first = palette[influence.indices[0]].real;
+		float real[4] = { 0.0f, 0.0f, 0.0f, rest };
+		float dual[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		for (size_t k = 0; k < 4; k++)
+		{
+			const DualQuaternion& bone = palette[influence.indices[k]];
+			const float dot = bone.real[0] * first[0] + bone.real[1] * first[1] + bone.real[2] * first[2] + bone.real[3] * first[3];
+			const float weight = static_cast<float>(influence.weights[k]) * (1.0f / 65535.0f) * (dot < 0.0f ? -1.0f : 1.0f);
+			for (size_t j = 0; j < 4; j++)
+			{
+				real[j] += bone.real[j] * weight;
+				dual[j] += bone.dual[j] * weight;
+			}
+		}
+		const float inverseLength = 1.0f / std::sqrt(real[0] * real[0] + real[1] * real[1] + real[2] * real[2] + real[3] * real[3]);
+		for (size_t j = 0; j < 4; j++)
+		{
+			real[j] *= inverseLength;
+			dual[j] *= inverseLength;
+		}
+
+		float translation[3];
+		Cross(real, dual, translation);
+		for (size_t j = 0; j < 3; j++)
+			translation[j] = 2.0f * (real[3] * dual[j] - dual[3] * real[j] + translation[j]);
+
+		auto Transform = [&](const mars::Vec4& v) -> mars::Vec4
+		{
+			const float x[3] = { v.x, v.y, v.z };
+			float a[3], b[3];
+			Cross(real, x, a);
+			for (size_t j = 0; j < 3; j++)
+				a[j] += real[3] * x[j];
+			Cross(real, a, b);
+			return mars::Vec4(x[0] + 2.0f * b[0] + translation[0] * v.w, x[1] + 2.0f * b[1] + translation[1] * v.w, x[2] + 2.0f * b[2] + translation[2] * v.w, v.w);
+		};
+
+		const ModelLoader::Vertex& source = src[i];
+		ModelLoader::Vertex& vertex = dst[i];
+		vertex.position = Transform(source.position);
+		vertex.texCoord = source.texCoord;
+		vertex.normal = Transform(source.normal);
+		vertex.tangent = Transform(source.tangent);
+		vertex.binormal = Transform(source.binormal);
+		vertex.colour = source.colour;
+	}
+}
\ No newline at end of file
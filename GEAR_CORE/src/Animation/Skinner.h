@@ -0,0 +1,89 @@
+#pragma once
+
+#include "gear_core_common.h"
+#include "Animation.h"
+#include "Core/ThreadPool.h"
+#include "Utils/ModelLoader.h"
+
+namespace gear
+{
+
+//Forward Declaration
+namespace objects
+{
+	class Mesh;
+}
+
+namespace animation
+{
+	//Deforms the vertices of meshes by their bones on the CPU. The pose of every bone of a mesh is flattened into a
+	//palette, and the vertices are skinned by their packed BoneInfluences in ranges on a pool of worker threads.
+	//Linear blend skinning blends the bones' matrices, so it supports scaled bones, but it loses volume around twisting
+	//joints. Dual quaternion skinning keeps the volume, but only the rotation and translation of each bone are used.
+	//The kernels use SSE2 where it is available.
+	class Skinner
+	{
+	public:
+		struct CreateInfo
+		{
+			std::string	debugName;
+			uint32_t	workerCount;	//0 uses the hardware thread count.
+		};
+
+		enum class Method : uint32_t
+		{
+			LINEAR_BLEND,
+			DUAL_QUATERNION
+		};
+
+		//An affine transform of column vectors, stored by column. The columns' w is 0, except for the translation's, which is 1.
+		struct BoneMatrix
+		{
+			float	columns[4][4];
+		};
+		//A rigid transform as a unit rotation quaternion and its dual part, both xyzw.
+		struct DualQuaternion
+		{
+			float	real[4];
+			float	dual[4];
+		};
+
+	private:
+		CreateInfo m_CI;
+
+		Ref<core::ThreadPool> m_ThreadPool;
+		core::ThreadPool::CreateInfo m_ThreadPoolCI;
+
+	public:
+		Skinner(CreateInfo* pCreateInfo);
+		~Skinner();
+
+		const CreateInfo& GetCreateInfo() { return m_CI; }
+		inline const Ref<core::ThreadPool>& GetThreadPool() const { return m_ThreadPool; }
+
+		//Builds the palette of every mesh of the model, posed by the animation at the time in seconds, which wraps around the
+		//animation's duration. palettes[i] holds one matrix per bone of mesh i, which takes the mesh's vertices to its bone in
+		//the bind pose, out to the posed bone's node, and back into the space of the mesh's node. Nodes without channels keep
+		//their transform, and a null animation gives the bind pose.
+		static void BuildBonePalettes(const ModelLoader::ModelData& modelData, const Animation* animation, double time, std::vector<std::vector<BoneMatrix>>& palettes);
+
+		//Skins every sub-mesh with bones straight into the staging memory of its vertices in the Mesh's MeshPool, which is
+		//uploaded on the next call to MeshPool::Upload() to a new range, so that the frames in flight keep their vertices.
+		//The Mesh must use VertexFormat::FULL.
+		void Skin(objects::Mesh& mesh, const std::vector<std::vector<BoneMatrix>>& palettes, Method method);
+		//Skins the vertices into dst in parallel, and returns once they are written. The palette must hold a matrix for every bone index of the influences.
+		void Skin(const ModelLoader::Vertex* src, const ModelLoader::BoneInfluence* influences, size_t count, const BoneMatrix* palette, size_t boneCount, Method method, ModelLoader::Vertex* dst);
+
+		//Any scale of the matrices is removed.
+		static void ConvertToDualQuaternions(const BoneMatrix* matrices, size_t count, DualQuaternion* dualQuaternions);
+
+		//Kernels. Every vec4 attribute is transformed with its w, so positions are moved and directions are only rotated.
+		//The directions are not renormalised. Any weight that is not assigned to a bone is given to the identity.
+		static void SkinLinearBlend(const ModelLoader::Vertex* src, const ModelLoader::BoneInfluence* influences, size_t count, const BoneMatrix* palette, ModelLoader::Vertex* dst);
+		static void SkinDualQuaternion(const ModelLoader::Vertex* src, const ModelLoader::BoneInfluence* influences, size_t count, const DualQuaternion* palette, ModelLoader::Vertex* dst);
+		//Scalar versions of the kernels, which the SIMD versions are tested against.
+		static void SkinLinearBlendReference(const ModelLoader::Vertex* src, const ModelLoader::BoneInfluence* influences, size_t count, const BoneMatrix* palette, ModelLoader::Vertex* dst);
+		static void SkinDualQuaternionReference(const ModelLoader::Vertex* src, const ModelLoader::BoneInfluence* influences, size_t count, const DualQuaternion* palette, ModelLoader::Vertex* dst);
+	};
+}
+}
\ No newline at end of file
@@ -0,0 +1,99 @@
+#include "gear_core_common.h"
+#include "ThreadPool.h"
+
+using namespace gear;
+using namespace core;
+
+static thread_local const ThreadPool* t_WorkerThreadPool = nullptr;
+
+ThreadPool::ThreadPool(CreateInfo* pCreateInfo)
+{
+	m_CI = *pCreateInfo;
+
+	uint32_t workerCount = m_CI.workerCount ? m_CI.workerCount : GetHardwareThreadCount();
+	for (uint32_t i = 0; i < workerCount; i++)
+		m_Workers.emplace_back(&ThreadPool::WorkerLoop, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::unique_lock<std::mutex> lock(m_TasksMutex);
+		m_Stop = true;
+	}
+	m_TasksCondition.notify_all();
+
+	for (auto& worker : m_Workers)
+		worker.join();
+}
+
+std::future<void> ThreadPool::Submit(const std::function<void()>& task)
+{
+	std::packaged_task<void()> packagedTask(task);
+	std::future<void> future = packagedTask.get_future();
+	{
+		std::unique_lock<std::mutex> lock(m_TasksMutex);
+		m_Tasks.emplace_back(std::move(packagedTask));
+	}
+	m_TasksCondition.notify_one();
+	return future;
+}
+
+void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t, size_t, uint32_t)>& function)
+{
+	if (count == 0)
+		return;
+
+	if (IsWorkerThread())
+	{
+		function(0, count, 0);
+		return;
+	}
+
+	size_t rangeCount = std::min(count, static_cast<size_t>(std::max(GetWorkerCount(), uint32_t(1))));
+	size_t rangeSize = (count + rangeCount - 1) / rangeCount;
+
+	std::vector<std::future<void>> futures;
+	for (size_t i = 0; i < rangeCount; i++)
+	{
+		size_t begin = i * rangeSize;
+		size_t end = std::min(begin + rangeSize, count);
+		if (begin >= end)
+			break;
+
+		uint32_t rangeIndex = static_cast<uint32_t>(i);
+		futures.push_back(Submit([&function, begin, end, rangeIndex]() { function(begin, end, rangeIndex); }));
+	}
+
+	for (auto& future : futures)
+		future.get();
+}
+
+bool ThreadPool::IsWorkerThread() const
+{
+	return t_WorkerThreadPool == this;
+}
+
+uint32_t ThreadPool::GetHardwareThreadCount()
+{
+	return std::max(std::thread::hardware_concurrency(), 1U);
+}
+
+void ThreadPool::WorkerLoop()
+{
+	t_WorkerThreadPool = this;
+	while (true)
+	{
+		std::packaged_task<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(m_TasksMutex);
+			m_TasksCondition.wait(lock, [this]() { return m_Stop || !m_Tasks.empty(); });
+			if (m_Stop && m_Tasks.empty())
+				return;
+
+			task = std::move(m_Tasks.front());
+			m_Tasks.pop_front();
+		}
+		task();
+	}
+}
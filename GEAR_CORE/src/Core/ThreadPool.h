@@ -0,0 +1,50 @@
+#pragma once
+
+#include "gear_core_common.h"
+
+namespace gear 
+{
+namespace core 
+{
+	//Fixed size pool of worker threads. Tasks are executed in submission order by the first available worker.
+	class ThreadPool
+	{
+	public:
+		struct CreateInfo
+		{
+			std::string	debugName;
+			uint32_t	workerCount; //0 uses the hardware thread count.
+		};
+
+	private:
+		CreateInfo m_CI;
+
+		std::vector<std::thread> m_Workers;
+		std::deque<std::packaged_task<void()>> m_Tasks;
+		std::mutex m_TasksMutex;
+		std::condition_variable m_TasksCondition;
+		bool m_Stop = false;
+
+	public:
+		ThreadPool(CreateInfo* pCreateInfo);
+		~ThreadPool();
+
+		const CreateInfo& GetCreateInfo() { return m_CI; }
+
+		std::future<void> Submit(const std::function<void()>& task);
+
+		//Splits [0, count) into at most one range per worker and blocks until all ranges have been processed.
+		//The function is called with (begin, end, rangeIndex). rangeIndex is unique per call and less than the worker count.
+		//Called from one of the pool's own workers, the whole range is processed on that worker, as waiting on the others could deadlock.
+		void ParallelFor(size_t count, const std::function<void(size_t, size_t, uint32_t)>& function);
+
+		inline uint32_t GetWorkerCount() const { return static_cast<uint32_t>(m_Workers.size()); }
+		bool IsWorkerThread() const;
+
+		static uint32_t GetHardwareThreadCount();
+
+	private:
+		void WorkerLoop();
+	};
+}
+}
@@ -0,0 +1,88 @@
+#include "gear_core_common.h"
+#include "BufferCopyBatch.h"
+
+using namespace gear;
+using namespace graphics;
+
+using namespace miru;
+using namespace miru::crossplatform;
+
+BufferCopyBatch::BufferCopyBatch()
+{
+}
+
+BufferCopyBatch::~BufferCopyBatch()
+{
+}
+
+void BufferCopyBatch::Add(const Ref<Buffer>& srcBuffer, const Ref<Buffer>& dstBuffer, const Buffer::Copy& region)
+{
+	if (!srcBuffer || !dstBuffer || region.size == 0)
+		return;
+
+	auto it = m_CopyIndices.find({ srcBuffer.get(), dstBuffer.get() });
+	if (it == m_CopyIndices.end())
+	{
+		it = m_CopyIndices.insert({ { srcBuffer.get(), dstBuffer.get() }, m_Copies.size() }).first;
+		m_Copies.push_back({ srcBuffer, dstBuffer, {} });
+	}
+	m_Copies[it->second].regions.push_back(region);
+}
+
+void BufferCopyBatch::Add(const Ref<Buffer>& srcBuffer, const Ref<Buffer>& dstBuffer, const std::vector<Buffer::Copy>& regions)
+{
+	for (auto& region : regions)
+		Add(srcBuffer, dstBuffer, region);
+}
+
+void BufferCopyBatch::GetBuffers(std::vector<Ref<Buffer>>& srcBuffers, std::vector<Ref<Buffer>>& dstBuffers) const
+{
+	srcBuffers.clear();
+	dstBuffers.clear();
+	std::set<const Buffer*> added;
+	for (auto& copies : m_Copies)
+	{
+		if (added.insert(copies.srcBuffer.get()).second)
+			srcBuffers.push_back(copies.srcBuffer);
+	}
+	added.clear();
+	for (auto& copies : m_Copies)
+	{
+		if (added.insert(copies.dstBuffer.get()).second)
+			dstBuffers.push_back(copies.dstBuffer);
+	}
+}
+
+void BufferCopyBatch::Record(const Ref<CommandBuffer>& cmdBuffer, uint32_t cmdBufferIndex)
+{
+	for (auto& copies : m_Copies)
+	{
+		//Merge regions that are contiguous in both buffers.
+		std::vector<Buffer::Copy>& regions = copies.regions;
+		std::sort(regions.begin(), regions.end(), [](const Buffer::Copy& a, const Buffer::Copy& b) { return a.dstOffset < b.dstOffset; });
+
+		size_t mergedCount = 0;
+		for (size_t i = 0; i < regions.size(); i++)
+		{
+			m_Statistics.bytes += regions[i].size;
+			if (mergedCount > 0)
+			{
+				Buffer::Copy& previous = regions[mergedCount - 1];
+				if (previous.srcOffset + previous.size == regions[i].srcOffset && previous.dstOffset + previous.size == regions[i].dstOffset)
+				{
+					previous.size += regions[i].size;
+					continue;
+				}
+			}
+			regions[mergedCount++] = regions[i];
+		}
+		regions.resize(mergedCount);
+
+		cmdBuffer->CopyBuffer(cmdBufferIndex, copies.srcBuffer, copies.dstBuffer, regions);
+		m_Statistics.copyCommands++;
+		m_Statistics.regions += static_cast<uint32_t>(regions.size());
+	}
+
+	m_Copies.clear();
+	m_CopyIndices.clear();
+}
\ No newline at end of file
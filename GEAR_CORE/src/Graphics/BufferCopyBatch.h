@@ -0,0 +1,51 @@
+#pragma once
+
+#include "gear_core_common.h"
+
+namespace gear
+{
+namespace graphics
+{
+	//Collects buffer copies, so that all the regions copied between the same source and destination buffers
+	//are recorded by one CopyBuffer. Adjacent regions are merged into one.
+	class BufferCopyBatch
+	{
+	public:
+		struct Statistics
+		{
+			uint64_t	bytes;
+			uint32_t	copyCommands;
+			uint32_t	regions;
+		};
+
+	private:
+		struct Copies
+		{
+			Ref<miru::crossplatform::Buffer>			srcBuffer;
+			Ref<miru::crossplatform::Buffer>			dstBuffer;
+			std::vector<miru::crossplatform::Buffer::Copy>	regions;
+		};
+
+		std::vector<Copies> m_Copies;
+		std::map<std::pair<const miru::crossplatform::Buffer*, const miru::crossplatform::Buffer*>, size_t> m_CopyIndices;
+		Statistics m_Statistics = {};
+
+	public:
+		BufferCopyBatch();
+		~BufferCopyBatch();
+
+		void Add(const Ref<miru::crossplatform::Buffer>& srcBuffer, const Ref<miru::crossplatform::Buffer>& dstBuffer, const miru::crossplatform::Buffer::Copy& region);
+		void Add(const Ref<miru::crossplatform::Buffer>& srcBuffer, const Ref<miru::crossplatform::Buffer>& dstBuffer, const std::vector<miru::crossplatform::Buffer::Copy>& regions);
+
+		//Records one CopyBuffer per pair of buffers, in the order the pairs were first added, and empties the batch.
+		void Record(const Ref<miru::crossplatform::CommandBuffer>& cmdBuffer, uint32_t cmdBufferIndex = 0);
+
+		//Returns the buffers of the copies added since the last call to Record(), each once, in the order they were first added.
+		void GetBuffers(std::vector<Ref<miru::crossplatform::Buffer>>& srcBuffers, std::vector<Ref<miru::crossplatform::Buffer>>& dstBuffers) const;
+
+		inline bool Empty() const { return m_Copies.empty(); }
+		//Accumulated over every call to Record().
+		inline const Statistics& GetStatistics() const { return m_Statistics; }
+	};
+}
+}
\ No newline at end of file
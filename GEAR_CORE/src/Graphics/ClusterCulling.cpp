@@ -0,0 +1,103 @@
+#include "gear_core_common.h"
+#include "ClusterCulling.h"
+
+using namespace gear;
+using namespace graphics;
+
+using namespace mars;
+
+ClusterCulling::View ClusterCulling::GetView(const std::array<Vec4, 6>& planes, const Vec3& position, const Mat4& modl, bool backfaceCulling)
+{
+	//Rows of the matrix, which transforms column vectors.
+	const float m[3][4] = {
+		{ modl.a, modl.b, modl.c, modl.d },
+		{ modl.e, modl.f, modl.g, modl.h },
+		{ modl.i, modl.j, modl.k, modl.l } };
+
+	//A world space plane n.x + w = 0 is (M^T n).x + (n.t + w) = 0 in object space, renormalised.
+	View view;
+	for (size_t p = 0; p < planes.size(); p++)
+	{
+		const float n[3] = { planes[p].x, planes[p].y, planes[p].z };
+		float plane[4];
+		for (size_t j = 0; j < 3; j++)
+			plane[j] = m[0][j] * n[0] + m[1][j] * n[1] + m[2][j] * n[2];
+		plane[3] = n[0] * m[0][3] + n[1] * m[1][3] + n[2] * m[2][3] + planes[p].w;
+
+		const float length = std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+		const float scale = length > 0.0f ? 1.0f / length : 0.0f;
+		view.planes[p] = Vec4(plane[0] * scale, plane[1] * scale, plane[2] * scale, plane[3] * scale);
+	}
+
+	//The position is taken to object space with the inverse of the upper 3x3, from its adjugate.
+	const float cofactors[3][3] = {
+		{ m[1][1] * m[2][2] - m[1][2] * m[2][1], m[1][2] * m[2][0] - m[1][0] * m[2][2], m[1][0] * m[2][1] - m[1][1] * m[2][0] },
+		{ m[0][2] * m[2][1] - m[0][1] * m[2][2], m[0][0] * m[2][2] - m[0][2] * m[2][0], m[0][1] * m[2][0] - m[0][0] * m[2][1] },
+		{ m[0][1] * m[1][2] - m[0][2] * m[1][1], m[0][2] * m[1][0] - m[0][0] * m[1][2], m[0][0] * m[1][1] - m[0][1] * m[1][0] } };
+	const float determinant = m[0][0] * cofactors[0][0] + m[0][1] * cofactors[0][1] + m[0][2] * cofactors[0][2];
+	const float d[3] = { position.x - m[0][3], position.y - m[1][3], position.z - m[2][3] };
+	float objectPosition[3] = { 0.0f, 0.0f, 0.0f };
+	if (determinant != 0.0f)
+	{
+		for (size_t i = 0; i < 3; i++)
+			objectPosition[i] = (cofactors[0][i] * d[0] + cofactors[1][i] * d[1] + cofactors[2][i] * d[2]) / determinant;
+	}
+	view.position = Vec3(objectPosition[0], objectPosition[1], objectPosition[2]);
+
+	//Which side of a triangle faces a point is unchanged by an affine transform, unless it mirrors.
+	view.backfaceCulling = backfaceCulling && determinant > 0.0f;
+	return view;
+}
+
+size_t ClusterCulling::Cull(const View& view, const ModelLoader::Meshlet* meshlets, size_t count, uint8_t* visible)
+{
+	size_t visibleCount = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		const Vec4& sphere = meshlets[i].boundingSphere;
+		bool outside = false;
+		for (size_t p = 0; p < view.planes.size() && !outside; p++)
+			outside = view.planes[p].x * sphere.x + view.planes[p].y * sphere.y + view.planes[p].z * sphere.z + view.planes[p].w < -sphere.w;
+
+		//Every triangle is back facing from every point of the sphere if the direction from the view to the centre is
+		//within the complement of the cone's half angle of the axis, with the radius as margin.
+		const Vec4& cone = meshlets[i].cone;
+		if (!outside && view.backfaceCulling && cone.w < 1.0f)
+		{
+			const float d[3] = { sphere.x - view.position.x, sphere.y - view.position.y, sphere.z - view.position.z };
+			const float distance = std::sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+			outside = d[0] * cone.x + d[1] * cone.y + d[2] * cone.z >= cone.w * distance + sphere.w;
+		}
+
+		visible[i] = outside ? 0 : 1;
+		visibleCount += visible[i];
+	}
+	return visibleCount;
+}
+
+size_t ClusterCulling::EmitDrawCommands(const ModelLoader::Meshlet* meshlets, size_t count, const uint8_t* visible, uint32_t firstIndex, int32_t vertexOffset,
+	UniformBufferStructures::DrawIndexedIndirectCommand* commands)
+{
+	//Meshlets are contiguous in the index buffer, so runs of visible meshlets merge into one draw.
+	size_t commandCount = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		if (!visible[i])
+			continue;
+
+		UniformBufferStructures::DrawIndexedIndirectCommand* previous = commandCount ? &commands[commandCount - 1] : nullptr;
+		if (previous && previous->firstIndex + previous->indexCount == firstIndex + meshlets[i].firstIndex)
+		{
+			previous->indexCount += meshlets[i].indexCount;
+			continue;
+		}
+
+		UniformBufferStructures::DrawIndexedIndirectCommand& command = commands[commandCount++];
+		command.indexCount = meshlets[i].indexCount;
+		command.instanceCount = 1;
+		command.firstIndex = firstIndex + meshlets[i].firstIndex;
+		command.vertexOffset = vertexOffset;
+		command.firstInstance = 0;
+	}
+	return commandCount;
+}
\ No newline at end of file
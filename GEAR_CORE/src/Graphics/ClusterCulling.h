@@ -0,0 +1,38 @@
+#pragma once
+
+#include "gear_core_common.h"
+#include "Graphics/UniformBufferStructures.h"
+#include "Utils/ModelLoader.h"
+
+namespace gear
+{
+namespace graphics
+{
+	class ClusterCulling
+	{
+	public:
+		//The camera in the object space of one model, so that the meshlets are tested without transforming their bounds.
+		struct View
+		{
+			std::array<mars::Vec4, 6>	planes;			//Normalised, with inward facing normals.
+			mars::Vec3					position;
+			bool						backfaceCulling;
+		};
+
+	public:
+		//planes and position are in world space, as returned by Camera::GetFrustumPlanes() and the camera's transform.
+		//Back face culling assumes counter-clockwise front faces, and is disabled for transforms that mirror.
+		static View GetView(const std::array<mars::Vec4, 6>& planes, const mars::Vec3& position, const mars::Mat4& modl, bool backfaceCulling);
+
+		//Sets visible[i] to 1 if meshlets[i] may be visible, otherwise 0. A meshlet is culled if its bounding sphere is
+		//outside the frustum, or if every position in its sphere sees every triangle from behind. Returns the number of visible meshlets.
+		static size_t Cull(const View& view, const ModelLoader::Meshlet* meshlets, size_t count, uint8_t* visible);
+
+		//Writes one command per run of consecutive visible meshlets. The meshlets' indices are offset by firstIndex, and
+		//the commands draw one instance with the given vertexOffset. Returns the number of commands written, which is at
+		//most (count + 1) / 2.
+		static size_t EmitDrawCommands(const ModelLoader::Meshlet* meshlets, size_t count, const uint8_t* visible, uint32_t firstIndex, int32_t vertexOffset,
+			UniformBufferStructures::DrawIndexedIndirectCommand* commands);
+	};
+}
+}
\ No newline at end of file
@@ -0,0 +1,224 @@
+#include "gear_core_common.h"
+#include "DescriptorAllocator.h"
+
+using namespace gear;
+using namespace graphics;
+
+using namespace miru;
+using namespace miru::crossplatform;
+
+DescriptorAllocator::DescriptorAllocator(CreateInfo* pCreateInfo)
+{
+	m_CI = *pCreateInfo;
+	m_CI.initialSetsPerPool = std::max(m_CI.initialSetsPerPool, uint32_t(1));
+}
+
+DescriptorAllocator::~DescriptorAllocator()
+{
+}
+
+Ref<DescriptorSet> DescriptorAllocator::Acquire(const Ref<DescriptorSetLayout>& layout, const std::vector<Write>& writes, const std::string& debugName)
+{
+	uint64_t hash = Hash(layout, writes);
+	auto range = m_Cache.equal_range(hash);
+	for (auto it = range.first; it != range.second; it++)
+	{
+		CachedSet& cachedSet = it->second;
+		if (cachedSet.layout == layout && Equal(cachedSet.writes, writes))
+		{
+			cachedSet.refCount++;
+			return cachedSet.set;
+		}
+	}
+
+	Ref<DescriptorSet> set = Allocate(layout, writes, debugName);
+	for (auto& write : writes)
+	{
+		if (!write.bufferInfos.empty())
+			set->AddBuffer(0, write.binding, write.bufferInfos);
+		if (!write.imageInfos.empty())
+			set->AddImage(0, write.binding, write.imageInfos);
+	}
+	set->Update();
+
+	m_Cache.insert({ hash, { set, layout, writes, 1 } });
+	m_CacheHashes[set.get()] = hash;
+	return set;
+}
+
+void DescriptorAllocator::Release(const Ref<DescriptorSet>& set)
+{
+	auto hashIt = m_CacheHashes.find(set.get());
+	if (hashIt == m_CacheHashes.end())
+	{
+		GEAR_ASSERT(ErrorCode::GRAPHICS | ErrorCode::INVALID_VALUE, "DescriptorSet was not acquired from DescriptorAllocator: %s.", m_CI.debugName.c_str());
+		return;
+	}
+
+	auto range = m_Cache.equal_range(hashIt->second);
+	for (auto it = range.first; it != range.second; it++)
+	{
+		CachedSet& cachedSet = it->second;
+		if (cachedSet.set != set)
+			continue;
+
+		if (--cachedSet.refCount == 0)
+		{
+			m_ReleasedSets.push_back({ cachedSet.set, cachedSet.layout, std::move(cachedSet.writes), m_FrameCount });
+			m_CacheHashes.erase(hashIt);
+			m_Cache.erase(it);
+		}
+		return;
+	}
+}
+
+void DescriptorAllocator::NextFrame()
+{
+	m_FrameCount++;
+	while (!m_ReleasedSets.empty() && m_FrameCount - m_ReleasedSets.front().releaseFrame >= m_CI.frameLatency)
+	{
+		ReleasedSet& releasedSet = m_ReleasedSets.front();
+		m_FreeSets[releasedSet.layout.get()].push_back(releasedSet.set);
+		m_ReleasedSets.pop_front();
+	}
+}
+
+Ref<DescriptorSet> DescriptorAllocator::Allocate(const Ref<DescriptorSetLayout>& layout, const std::vector<Write>& writes, const std::string& debugName)
+{
+	//Recycle a released set with the same layout, if the writes replace all of its descriptors.
+	auto freeIt = m_FreeSets.find(layout.get());
+	if (freeIt != m_FreeSets.end() && !freeIt->second.empty() && WritesAllDescriptors(layout, writes))
+	{
+		Ref<DescriptorSet> set = freeIt->second.back();
+		freeIt->second.pop_back();
+		return set;
+	}
+
+	std::map<DescriptorType, uint32_t> descriptorCounts;
+	for (auto& binding : layout->GetCreateInfo().descriptorSetLayoutBinding)
+		descriptorCounts[binding.type] += binding.descriptorCount;
+
+	for (auto& descriptorCount : descriptorCounts)
+		m_TotalDescriptors[descriptorCount.first] += descriptorCount.second;
+	m_TotalSets++;
+
+	Pool& pool = GetPool(descriptorCounts);
+	pool.remainingSets--;
+	for (auto& descriptorCount : descriptorCounts)
+		pool.remainingDescriptors[descriptorCount.first] -= descriptorCount.second;
+
+	DescriptorSet::CreateInfo setCI;
+	setCI.debugName = debugName;
+	setCI.pDescriptorPool = pool.pool;
+	setCI.pDescriptorSetLayouts = { layout };
+	return DescriptorSet::Create(&setCI);
+}
+
+DescriptorAllocator::Pool& DescriptorAllocator::GetPool(const std::map<DescriptorType, uint32_t>& descriptorCounts)
+{
+	if (!m_Pools.empty())
+	{
+		Pool& pool = m_Pools.back();
+		bool fits = pool.remainingSets > 0;
+		for (auto& descriptorCount : descriptorCounts)
+			fits &= pool.remainingDescriptors[descriptorCount.first] >= descriptorCount.second;
+
+		if (fits)
+			return pool;
+	}
+
+	//The previous pools are kept alive, as sets allocated from them may still be in use.
+	uint32_t setCount = m_Pools.empty() ? m_CI.initialSetsPerPool : m_Pools.back().poolCI.maxSets * 2;
+
+	m_Pools.push_back({});
+	Pool& pool = m_Pools.back();
+	pool.poolCI.debugName = m_CI.debugName + "_DescriptorPool_" + std::to_string(m_Pools.size() - 1);
+	pool.poolCI.device = m_CI.device;
+	pool.poolCI.maxSets = setCount;
+	for (auto& totalDescriptor : m_TotalDescriptors)
+	{
+		uint64_t averageCount = (totalDescriptor.second * setCount + m_TotalSets - 1) / m_TotalSets;
+		uint32_t requiredCount = descriptorCounts.find(totalDescriptor.first) != descriptorCounts.end() ? descriptorCounts.at(totalDescriptor.first) : 0;
+		uint32_t count = std::max(static_cast<uint32_t>(std::min(averageCount, uint64_t(UINT32_MAX))), requiredCount);
+
+		pool.poolCI.poolSizes.push_back({ totalDescriptor.first, count });
+		pool.remainingDescriptors[totalDescriptor.first] = count;
+	}
+	pool.remainingSets = setCount;
+	pool.pool = DescriptorPool::Create(&pool.poolCI);
+	return pool;
+}
+
+uint64_t DescriptorAllocator::Hash(const Ref<DescriptorSetLayout>& layout, const std::vector<Write>& writes)
+{
+	//FNV-1a over the identities of the layout and the written resources.
+	uint64_t hash = 14695981039346656037ULL;
+	auto Combine = [&hash](uint64_t value)
+	{
+		for (size_t i = 0; i < sizeof(uint64_t); i++)
+		{
+			hash ^= (value >> (i * 8)) & 0xFF;
+			hash *= 1099511628211ULL;
+		}
+	};
+
+	Combine(reinterpret_cast<uint64_t>(layout.get()));
+	for (auto& write : writes)
+	{
+		Combine(write.binding);
+		for (auto& bufferInfo : write.bufferInfos)
+			Combine(reinterpret_cast<uint64_t>(bufferInfo.bufferView.get()));
+		for (auto& imageInfo : write.imageInfos)
+		{
+			Combine(reinterpret_cast<uint64_t>(imageInfo.sampler.get()));
+			Combine(reinterpret_cast<uint64_t>(imageInfo.imageView.get()));
+			Combine(static_cast<uint64_t>(imageInfo.layout));
+		}
+	}
+	return hash;
+}
+
+bool DescriptorAllocator::Equal(const std::vector<Write>& a, const std::vector<Write>& b)
+{
+	if (a.size() != b.size())
+		return false;
+
+	for (size_t i = 0; i < a.size(); i++)
+	{
+		const Write& writeA = a[i];
+		const Write& writeB = b[i];
+		if (writeA.binding != writeB.binding || writeA.bufferInfos.size() != writeB.bufferInfos.size() || writeA.imageInfos.size() != writeB.imageInfos.size())
+			return false;
+
+		for (size_t j = 0; j < writeA.bufferInfos.size(); j++)
+		{
+			if (writeA.bufferInfos[j].bufferView != writeB.bufferInfos[j].bufferView)
+				return false;
+		}
+		for (size_t j = 0; j < writeA.imageInfos.size(); j++)
+		{
+			const DescriptorSet::DescriptorImageInfo& imageInfoA = writeA.imageInfos[j];
+			const DescriptorSet::DescriptorImageInfo& imageInfoB = writeB.imageInfos[j];
+			if (imageInfoA.sampler != imageInfoB.sampler || imageInfoA.imageView != imageInfoB.imageView || imageInfoA.layout != imageInfoB.layout)
+				return false;
+		}
+	}
+	return true;
+}
+
+
+bool DescriptorAllocator::WritesAllDescriptors(const Ref<DescriptorSetLayout>& layout, const std::vector<Write>& writes)
+{
+	for (auto& binding : layout->GetCreateInfo().descriptorSetLayoutBinding)
+	{
+		size_t descriptorCount = 0;
+		for (auto& write : writes)
+		{
+			if (write.binding == binding.binding)
+				descriptorCount += write.bufferInfos.size() + write.imageInfos.size();
+		}
+		if (descriptorCount < binding.descriptorCount)
+			return false;
+	}
+	return true;
+}
\ No newline at end of file
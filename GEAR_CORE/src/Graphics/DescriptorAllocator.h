@@ -0,0 +1,93 @@
+#pragma once
+
+#include "gear_core_common.h"
+
+namespace gear
+{
+namespace graphics
+{
+	//Allocates DescriptorSets from a chain of DescriptorPools, which grows when the current pool is exhausted.
+	//Sets with identical layouts and writes are shared and reference counted. Released sets are recycled
+	//for the same layout once they can no longer be in use by the GPU, but only by writes that rewrite every
+	//descriptor of the layout, so no descriptor of the set's previous use is left behind.
+	class DescriptorAllocator
+	{
+	public:
+		struct CreateInfo
+		{
+			std::string	debugName;
+			void*		device;
+			uint32_t	initialSetsPerPool;	//Each new pool holds twice as many sets as the previous one.
+			uint32_t	frameLatency;		//Number of frames a released set is held before it is reused.
+		};
+
+		struct Write
+		{
+			uint32_t													binding;
+			std::vector<miru::crossplatform::DescriptorSet::DescriptorBufferInfo>	bufferInfos;
+			std::vector<miru::crossplatform::DescriptorSet::DescriptorImageInfo>	imageInfos;
+		};
+
+	private:
+		struct Pool
+		{
+			Ref<miru::crossplatform::DescriptorPool>			pool;
+			miru::crossplatform::DescriptorPool::CreateInfo		poolCI;
+			uint32_t											remainingSets;
+			std::map<miru::crossplatform::DescriptorType, uint32_t>	remainingDescriptors;
+		};
+		struct CachedSet
+		{
+			Ref<miru::crossplatform::DescriptorSet>			set;
+			Ref<miru::crossplatform::DescriptorSetLayout>	layout;
+			std::vector<Write>								writes; //Holds the written resources alive, so their addresses stay unique while cached.
+			uint32_t										refCount;
+		};
+		struct ReleasedSet
+		{
+			Ref<miru::crossplatform::DescriptorSet>			set;
+			Ref<miru::crossplatform::DescriptorSetLayout>	layout;
+			std::vector<Write>								writes; //Holds the written resources alive, until the GPU has finished with the set.
+			uint64_t										releaseFrame;
+		};
+
+		CreateInfo m_CI;
+
+		std::vector<Pool> m_Pools;
+		std::multimap<uint64_t, CachedSet> m_Cache;
+		std::map<const miru::crossplatform::DescriptorSet*, uint64_t> m_CacheHashes;
+		std::deque<ReleasedSet> m_ReleasedSets;
+		std::map<const miru::crossplatform::DescriptorSetLayout*, std::vector<Ref<miru::crossplatform::DescriptorSet>>> m_FreeSets;
+
+		//Running totals used to size new pools in proportion to the descriptors requested so far.
+		std::map<miru::crossplatform::DescriptorType, uint64_t> m_TotalDescriptors;
+		uint64_t m_TotalSets = 0;
+
+		uint64_t m_FrameCount = 0;
+
+	public:
+		DescriptorAllocator(CreateInfo* pCreateInfo);
+		~DescriptorAllocator();
+
+		const CreateInfo& GetCreateInfo() { return m_CI; }
+
+		//Returns a set for the layout with the writes applied. An existing set is shared if the layout and writes match.
+		//Each acquired reference is given back with Release() by its owner.
+		Ref<miru::crossplatform::DescriptorSet> Acquire(const Ref<miru::crossplatform::DescriptorSetLayout>& layout, const std::vector<Write>& writes, const std::string& debugName);
+		void Release(const Ref<miru::crossplatform::DescriptorSet>& set);
+
+		//Call once per frame. Sets released frameLatency frames ago become available for reuse.
+		void NextFrame();
+
+		inline uint32_t GetPoolCount() const { return static_cast<uint32_t>(m_Pools.size()); }
+		inline uint32_t GetCachedSetCount() const { return static_cast<uint32_t>(m_Cache.size()); }
+
+	private:
+		Ref<miru::crossplatform::DescriptorSet> Allocate(const Ref<miru::crossplatform::DescriptorSetLayout>& layout, const std::vector<Write>& writes, const std::string& debugName);
+		Pool& GetPool(const std::map<miru::crossplatform::DescriptorType, uint32_t>& descriptorCounts);
+		static uint64_t Hash(const Ref<miru::crossplatform::DescriptorSetLayout>& layout, const std::vector<Write>& writes);
+		static bool Equal(const std::vector<Write>& a, const std::vector<Write>& b);
+		static bool WritesAllDescriptors(const Ref<miru::crossplatform::DescriptorSetLayout>& layout, const std::vector<Write>& writes);
+	};
+}
+}
@@ -2,6 +2,8 @@
 
 #include "FrameGraph.h"
 #include "Graphics/AllocatorManager.h"
+#include "Graphics/Storagebuffer.h"
+#include "Graphics/MeshPool.h"
 
 #include "Objects/Camera.h"
 #include "Objects/Skybox.h"
@@ -18,19 +20,6 @@ using namespace miru::crossplatform;
 GPUTask::GPUTask(CreateInfo* pCreateInfo)
 {
 	m_CI = *pCreateInfo;
-
-	if (m_CI.submitCmdBuffer)
-	{
-		m_CmdBufferFenceCI.debugName = "GEAR_CORE_Fence_" + m_CI.debugName;
-		m_CmdBufferFenceCI.device = AllocatorManager::GetCreateInfo().pContext->GetDevice();
-		m_CmdBufferFenceCI.signaled = false;
-		m_CmdBufferFenceCI.timeout = UINT64_MAX;
-		m_CmdBufferFence = Fence::Create(&m_CmdBufferFenceCI);
-
-		m_SignalSemaphoreCI.debugName = "GEAR_CORE_Semaphore_" + m_CI.debugName;
-		m_SignalSemaphoreCI.device = m_CmdBufferFenceCI.device;
-		m_SignalSemaphore = Semaphore::Create(&m_SignalSemaphoreCI);
-	}
 }
 
 GPUTask::~GPUTask()
@@ -72,11 +61,16 @@ void GPUTask::Execute()
 		for (const auto& lastSubmitNodes : LastSubmitGPUTasks(m_CI.srcPipelineStages, m_CI.srcGPUTasks))
 		{
 			waitSrcPipelineStages.push_back(lastSubmitNodes.first);
-			waitSrcSemaphores.push_back(lastSubmitNodes.second->m_SignalSemaphore);
+			waitSrcSemaphores.push_back(lastSubmitNodes.second->m_CI.signalSemaphore);
 		}
 
+		std::vector<Ref<Semaphore>> signalSemaphores;
+		if (m_CI.signalSemaphore)
+			signalSemaphores.push_back(m_CI.signalSemaphore);
+
 		m_CI.cmdBuffer->End(m_CI.cmdBufferIndex);
-		m_CI.cmdBuffer->Submit({ m_CI.cmdBufferIndex }, waitSrcSemaphores, waitSrcPipelineStages, { m_SignalSemaphore }, m_CmdBufferFence);
+		m_CI.fence->Reset();
+		m_CI.cmdBuffer->Submit({ m_CI.cmdBufferIndex }, waitSrcSemaphores, waitSrcPipelineStages, signalSemaphores, m_CI.fence);
 	}
 }
 
@@ -107,40 +101,768 @@ void GPUTask::TransitionResources()
 	m_CI.cmdBuffer->PipelineBarrier(m_CI.cmdBufferIndex, transResourcesTI->srcPipelineStage, transResourcesTI->dstPipelineStage, DependencyBit::NONE_BIT, transResourcesTI->barriers);
 }
 
+void GPUTask::AddBufferCopies(UploadResourceTaskInfo& uploadResourcesTI)
+{
+	//Buffers are only copied if they have been changed since their last upload.
+	//The copies are batched, so regions that share a source and a destination are recorded by one CopyBuffer.
+	BufferCopyBatch& copyBatch = uploadResourcesTI.copyBatch;
+
+	if (uploadResourcesTI.camera)
+		uploadResourcesTI.camera->GetUB()->Upload(copyBatch, uploadResourcesTI.cameraForce);
+
+	if (uploadResourcesTI.fontCamera)
+		uploadResourcesTI.fontCamera->GetUB()->Upload(copyBatch, uploadResourcesTI.fontCameraForce);
+
+	if (uploadResourcesTI.skybox)
+		uploadResourcesTI.skybox->GetUB()->Upload(copyBatch, uploadResourcesTI.skyboxForce);
+
+	for (auto& light : uploadResourcesTI.lights)
+		light->GetUB()->Upload(copyBatch, uploadResourcesTI.lightsForce);
+
+	for (auto& meshPool : uploadResourcesTI.meshPools)
+		meshPool->Upload(copyBatch);
+
+	for (auto& model : uploadResourcesTI.models)
+	{
+		model->GetUB()->Upload(copyBatch, uploadResourcesTI.modelsForce);
+		
+		for (auto& material : model->GetMesh()->GetMaterials())
+			material->GetUB()->Upload(copyBatch, uploadResourcesTI.materialsForce);
+	}
+
+	if (uploadResourcesTI.bindlessMaterials)
+		uploadResourcesTI.bindlessMaterials->Upload(copyBatch);
+}
+
 void GPUTask::UploadResources()
 {
 	UploadResourceTaskInfo* uploadResourcesTI = reinterpret_cast<UploadResourceTaskInfo*>(m_CI.pTaskInfo);
 
-	if (uploadResourcesTI->camera)
-		uploadResourcesTI->camera->GetUB()->Upload(m_CI.cmdBuffer, m_CI.cmdBufferIndex, uploadResourcesTI->cameraForce);
+	//Only the textures scheduled by the TextureStreamer are uploaded.
+	for (auto& texture : uploadResourcesTI->textures)
+		texture->Upload(m_CI.cmdBuffer, m_CI.cmdBufferIndex, true);
+
+	uploadResourcesTI->copyBatch.Record(m_CI.cmdBuffer, m_CI.cmdBufferIndex);
+	uploadResourcesTI->copyStatistics = uploadResourcesTI->copyBatch.GetStatistics();
+}
 
-	if (uploadResourcesTI->fontCamera)
-		uploadResourcesTI->fontCamera->GetUB()->Upload(m_CI.cmdBuffer, m_CI.cmdBufferIndex, uploadResourcesTI->fontCameraForce);
 
-	if (uploadResourcesTI->skybox)
-		uploadResourcesTI->skybox->GetUB()->Upload(m_CI.cmdBuffer, m_CI.cmdBufferIndex, uploadResourcesTI->skyboxForce);
+//FrameGraph
 
-	for (auto& light : uploadResourcesTI->lights)
-		light->GetUB()->Upload(m_CI.cmdBuffer, m_CI.cmdBufferIndex, uploadResourcesTI->lightsForce);
+static bool IsWriteAccess(Barrier::AccessBit access)
+{
+	const uint32_t writeAccesses = static_cast<uint32_t>(Barrier::AccessBit::SHADER_WRITE_BIT)
+		| static_cast<uint32_t>(Barrier::AccessBit::COLOUR_ATTACHMENT_WRITE_BIT)
+		| static_cast<uint32_t>(Barrier::AccessBit::DEPTH_STENCIL_ATTACHMENT_WRITE_BIT)
+		| static_cast<uint32_t>(Barrier::AccessBit::TRANSFER_WRITE_BIT)
+		| static_cast<uint32_t>(Barrier::AccessBit::HOST_WRITE_BIT)
+		| static_cast<uint32_t>(Barrier::AccessBit::MEMORY_WRITE_BIT);
+	return (static_cast<uint32_t>(access) & writeAccesses) != 0;
+}
 
-	for (auto& model : uploadResourcesTI->models)
+static PipelineStageBit CombinePipelineStages(PipelineStageBit a, PipelineStageBit b)
+{
+	return static_cast<PipelineStageBit>(static_cast<uint32_t>(a) | static_cast<uint32_t>(b));
+}
+
+//Graphics queues can execute everything a compute queue can, and compute queues everything a transfer queue can.
+static uint32_t QueueCapability(CommandPool::QueueType queueType)
+{
+	switch (queueType)
 	{
-		for (auto& vb : model->GetMesh()->GetVertexBuffers())
-			vb->Upload(m_CI.cmdBuffer, m_CI.cmdBufferIndex, uploadResourcesTI->modelsForce);
-		for (auto& ib : model->GetMesh()->GetIndexBuffers())
-			ib->Upload(m_CI.cmdBuffer, m_CI.cmdBufferIndex, uploadResourcesTI->modelsForce);
+	case CommandPool::QueueType::GRAPHICS:
+		return 2;
+	case CommandPool::QueueType::COMPUTE:
+		return 1;
+	case CommandPool::QueueType::TRANSFER:
+	default:
+		return 0;
+	}
+}
 
-		model->GetUB()->Upload(m_CI.cmdBuffer, m_CI.cmdBufferIndex, uploadResourcesTI->modelsForce);
+FrameGraph::FrameGraph(CreateInfo* pCreateInfo)
+{
+	m_CI = *pCreateInfo;
+}
+
+FrameGraph::~FrameGraph()
+{
+}
+
+void FrameGraph::ImportResource(const Ref<Texture>& texture, const ResourceState& initialState)
+{
+	ResourceUsage usage = { texture, nullptr };
+	Resource& resource = GetResource(usage);
+	resource.initialState = initialState;
+	resource.imported = true;
+}
+
+void FrameGraph::ImportResource(const Ref<Buffer>& buffer, const ResourceState& initialState)
+{
+	ResourceUsage usage = { nullptr, buffer };
+	Resource& resource = GetResource(usage);
+	resource.initialState = initialState;
+	resource.imported = true;
+}
+
+void FrameGraph::ExportResource(const Ref<Texture>& texture, const ResourceState& finalState)
+{
+	ResourceUsage usage = { texture, nullptr };
+	Resource& resource = GetResource(usage);
+	resource.finalState = finalState;
+	resource.exported = true;
+}
+
+void FrameGraph::ExportResource(const Ref<Buffer>& buffer, const ResourceState& finalState)
+{
+	ResourceUsage usage = { nullptr, buffer };
+	Resource& resource = GetResource(usage);
+	resource.finalState = finalState;
+	resource.exported = true;
+}
+
+void FrameGraph::AddPass(const PassCreateInfo& passCI)
+{
+	if (m_Compiled)
+	{
+		GEAR_ASSERT(ErrorCode::GRAPHICS | ErrorCode::INVALID_STATE, "FrameGraph: %s is already compiled. Call Reset() before adding passes.", m_CI.debugName.c_str());
+		return;
+	}
+	if (m_CI.cmdBuffers.find(passCI.queueType) == m_CI.cmdBuffers.end() && !passCI.hostTask)
+	{
+		GEAR_ASSERT(ErrorCode::GRAPHICS | ErrorCode::INVALID_VALUE, "FrameGraph: No CommandBuffer provided for the queue used by %s.", passCI.debugName.c_str());
+		return;
+	}
+
+	Pass pass;
+	pass.CI = passCI;
+	pass.culled = false;
+	pass.submissionIndex = 0;
+	m_Passes.push_back(pass);
+
+	for (auto& usage : m_Passes.back().CI.reads)
+		GetResource(usage);
+	for (auto& usage : m_Passes.back().CI.writes)
+		GetResource(usage);
+}
+
+void FrameGraph::Compile()
+{
+	if (m_Compiled)
+		return;
+
+	//Dependencies: Read after write, write after write and write after read.
+	std::map<void*, size_t> lastWriters;
+	std::map<void*, std::vector<size_t>> readersSinceLastWrite;
+	for (size_t i = 0; i < m_Passes.size(); i++)
+	{
+		Pass& pass = m_Passes[i];
+		for (auto& usage : pass.CI.reads)
+		{
+			void* key = usage.texture ? (void*)usage.texture.get() : (void*)usage.buffer.get();
+			if (lastWriters.find(key) != lastWriters.end())
+				pass.dependencies.insert(lastWriters[key]);
+			readersSinceLastWrite[key].push_back(i);
+		}
+		for (auto& usage : pass.CI.writes)
+		{
+			void* key = usage.texture ? (void*)usage.texture.get() : (void*)usage.buffer.get();
+			if (lastWriters.find(key) != lastWriters.end())
+				pass.dependencies.insert(lastWriters[key]);
+			for (auto& reader : readersSinceLastWrite[key])
+			{
+				if (reader != i)
+					pass.dependencies.insert(reader);
+			}
+			readersSinceLastWrite[key].clear();
+			lastWriters[key] = i;
+		}
+	}
+
+	CullPasses();
+	BuildSubmissions(SortPasses());
+	DeriveBarriers();
+	if (m_CI.join)
+		AddJoin();
+
+	//Binary semaphores must be waited on before they are signalled again, so only signal those that are waited on.
+	for (auto& submission : m_Submissions)
+	{
+		if (submission.host)
+			continue;
+		for (auto& dependency : submission.dependencies)
+			m_Submissions[dependency].signalSemaphore = !m_Submissions[dependency].host;
+	}
+
+	//Assign CommandBuffer indices
+	std::map<CommandPool::QueueType, size_t> queueSubmissionCounts;
+	for (auto& submissionIndex : m_ExecutionOrder)
+	{
+		Submission& submission = m_Submissions[submissionIndex];
+		if (submission.host)
+			continue;
+
+		const std::vector<uint32_t>& cmdBufferIndices = m_CI.cmdBuffers[submission.queueType].cmdBufferIndices;
+		size_t& count = queueSubmissionCounts[submission.queueType];
+		if (count >= cmdBufferIndices.size())
+		{
+			GEAR_ASSERT(ErrorCode::GRAPHICS | ErrorCode::INVALID_STATE, "FrameGraph: %s requires more CommandBuffers than were provided for a queue.", m_CI.debugName.c_str());
+			return;
+		}
+		submission.cmdBufferIndex = cmdBufferIndices[count];
+		count++;
+	}
+
+	m_Compiled = true;
+}
+
+void FrameGraph::Execute()
+{
+	if (!m_Compiled)
+		Compile();
+
+	Wait();
+	m_GPUTasks.clear();
+	m_Transitions.clear();
+
+	size_t syncIndex = 0;
+	for (auto& submissionIndex : m_ExecutionOrder)
+	{
+		Submission& submission = m_Submissions[submissionIndex];
+		if (submission.host)
+		{
+			for (auto& dependency : submission.dependencies)
+			{
+				if (!m_Submissions[dependency].host)
+					m_Submissions[dependency].lastGPUTask->GetFence()->Wait();
+			}
+			for (auto& passIndex : submission.passIndices)
+				m_Passes[passIndex].CI.hostTask();
+
+			continue;
+		}
+
+		std::vector<GPUTask::CreateInfo> gpuTaskCIs;
+		GPUTask::CreateInfo gpuTaskCI;
+		gpuTaskCI.srcGPUTasks = {};
+		gpuTaskCI.srcPipelineStages = {};
+		gpuTaskCI.cmdBuffer = m_CI.cmdBuffers[submission.queueType].cmdBuffer;
+		gpuTaskCI.cmdBufferIndex = submission.cmdBufferIndex;
+		gpuTaskCI.resetCmdBuffer = false;
+		gpuTaskCI.submitCmdBuffer = false;
+		gpuTaskCI.skipTask = false;
+		gpuTaskCI.fence = nullptr;
+		gpuTaskCI.signalSemaphore = nullptr;
 		
-		for (auto& material : model->GetMesh()->GetMaterials())
+		for (size_t i = 0; i < submission.passIndices.size(); i++)
 		{
-			material->GetUB()->Upload(m_CI.cmdBuffer, m_CI.cmdBufferIndex, uploadResourcesTI->materialsForce);
-			
-			for (auto& texture : material->GetTextures())
+			const PassCreateInfo& passCI = m_Passes[submission.passIndices[i]].CI;
+			for (auto& transition : submission.preBarriers[i])
 			{
-				texture.second->Upload(m_CI.cmdBuffer, m_CI.cmdBufferIndex, uploadResourcesTI->materialsForce);
+				gpuTaskCI.debugName = "Pre-" + passCI.debugName;
+				gpuTaskCI.task = GPUTask::Task::TRANSITION_RESOURCES;
+				gpuTaskCI.pTaskInfo = CreateBarriers(transition);
+				gpuTaskCIs.push_back(gpuTaskCI);
 			}
+			gpuTaskCI.debugName = passCI.debugName;
+			gpuTaskCI.task = passCI.task;
+			gpuTaskCI.pTaskInfo = passCI.pTaskInfo;
+			gpuTaskCIs.push_back(gpuTaskCI);
+		}
+		for (auto& transition : submission.postBarriers)
+		{
+			gpuTaskCI.debugName = "Post-" + submission.debugName;
+			gpuTaskCI.task = GPUTask::Task::TRANSITION_RESOURCES;
+			gpuTaskCI.pTaskInfo = CreateBarriers(transition);
+			gpuTaskCIs.push_back(gpuTaskCI);
+		}
+		if (gpuTaskCIs.empty())
+		{
+			//Submissions with nothing to record only wait and signal.
+			gpuTaskCI.debugName = submission.debugName;
+			gpuTaskCI.task = GPUTask::Task::NONE;
+			gpuTaskCI.pTaskInfo = nullptr;
+			gpuTaskCIs.push_back(gpuTaskCI);
+		}
+
+		if (syncIndex == m_Fences.size())
+		{
+			Fence::CreateInfo fenceCI;
+			fenceCI.debugName = "GEAR_CORE_Fence_" + m_CI.debugName + "_" + std::to_string(syncIndex);
+			fenceCI.device = AllocatorManager::GetCreateInfo().pContext->GetDevice();
+			fenceCI.signaled = false;
+			fenceCI.timeout = UINT64_MAX;
+			m_Fences.push_back(Fence::Create(&fenceCI));
+
+			Semaphore::CreateInfo semaphoreCI;
+			semaphoreCI.debugName = "GEAR_CORE_Semaphore_" + m_CI.debugName + "_" + std::to_string(syncIndex);
+			semaphoreCI.device = fenceCI.device;
+			m_Semaphores.push_back(Semaphore::Create(&semaphoreCI));
+		}
+
+		gpuTaskCIs.front().resetCmdBuffer = true;
+		GPUTask::CreateInfo& lastGPUTaskCI = gpuTaskCIs.back();
+		lastGPUTaskCI.debugName = submission.debugName;
+		lastGPUTaskCI.submitCmdBuffer = true;
+		lastGPUTaskCI.fence = m_Fences[syncIndex];
+		lastGPUTaskCI.signalSemaphore = submission.signalSemaphore ? m_Semaphores[syncIndex] : nullptr;
+		syncIndex++;
+		for (auto& dependency : submission.dependencies)
+		{
+			//Host submissions have already waited on their own work.
+			if (m_Submissions[dependency].host)
+				continue;
+			lastGPUTaskCI.srcGPUTasks.push_back(m_Submissions[dependency].lastGPUTask);
+			lastGPUTaskCI.srcPipelineStages.push_back(submission.waitPipelineStage);
+		}
+
+		for (auto& CI : gpuTaskCIs)
+		{
+			m_GPUTasks.push_back(CreateRef<GPUTask>(&CI));
+			m_GPUTasks.back()->Execute();
 		}
+		submission.lastGPUTask = m_GPUTasks.back();
 	}
+	m_SubmittedFenceCount = syncIndex;
 }
 
+void FrameGraph::Wait()
+{
+	for (size_t i = 0; i < m_SubmittedFenceCount; i++)
+		m_Fences[i]->Wait();
+	m_SubmittedFenceCount = 0;
+}
+
+void FrameGraph::Reset()
+{
+	m_Resources.clear();
+	m_Passes.clear();
+	m_Submissions.clear();
+	m_ExecutionOrder.clear();
+	m_GPUTasks.clear();
+	m_Transitions.clear();
+	m_Compiled = false;
+	m_CulledPassCount = 0;
+}
+
+FrameGraph::Resource& FrameGraph::GetResource(const ResourceUsage& usage)
+{
+	void* key = usage.texture ? (void*)usage.texture.get() : (void*)usage.buffer.get();
+	auto it = m_Resources.find(key);
+	if (it == m_Resources.end())
+	{
+		Resource resource;
+		resource.texture = usage.texture;
+		resource.buffer = usage.buffer;
+		resource.initialState = { Barrier::AccessBit::NONE_BIT, Image::Layout::UNKNOWN, PipelineStageBit::TOP_OF_PIPE_BIT, CommandPool::QueueType::GRAPHICS };
+		resource.finalState = resource.initialState;
+		resource.imported = false;
+		resource.exported = false;
+		it = m_Resources.insert({ key, resource }).first;
+	}
+	return it->second;
+}
+
+void FrameGraph::CullPasses()
+{
+	for (auto& pass : m_Passes)
+	{
+		pass.culled = !pass.CI.hasSideEffects;
+		for (auto& usage : pass.CI.writes)
+		{
+			if (GetResource(usage).exported)
+				pass.culled = false;
+		}
+	}
+
+	//Dependencies always point to earlier passes, so a single reverse sweep reaches every producer.
+	for (size_t i = m_Passes.size(); i > 0; i--)
+	{
+		const Pass& pass = m_Passes[i - 1];
+		if (pass.culled)
+			continue;
+		for (auto& dependency : pass.dependencies)
+			m_Passes[dependency].culled = false;
+	}
+
+	m_CulledPassCount = 0;
+	for (auto& pass : m_Passes)
+	{
+		if (pass.culled)
+			m_CulledPassCount++;
+	}
+}
+
+std::vector<size_t> FrameGraph::SortPasses()
+{
+	std::vector<size_t> sortedPassIndices;
+	std::vector<size_t> inDegrees(m_Passes.size(), 0);
+	std::vector<std::vector<size_t>> dependants(m_Passes.size());
+	std::set<size_t> ready;
+
+	for (size_t i = 0; i < m_Passes.size(); i++)
+	{
+		if (m_Passes[i].culled)
+			continue;
+		for (auto& dependency : m_Passes[i].dependencies)
+		{
+			inDegrees[i]++;
+			dependants[dependency].push_back(i);
+		}
+		if (inDegrees[i] == 0)
+			ready.insert(i);
+	}
+
+	//Kahn's algorithm. Prefer passes on the same queue as the previous pass, so that they can be merged into one submission.
+	bool previousIsHost = true;
+	CommandPool::QueueType previousQueueType = CommandPool::QueueType::GRAPHICS;
+	while (!ready.empty())
+	{
+		size_t next = *ready.begin();
+		if (!previousIsHost)
+		{
+			for (auto& candidate : ready)
+			{
+				const PassCreateInfo& candidateCI = m_Passes[candidate].CI;
+				if (!candidateCI.hostTask && candidateCI.queueType == previousQueueType)
+				{
+					next = candidate;
+					break;
+				}
+			}
+		}
+		ready.erase(next);
+		sortedPassIndices.push_back(next);
+		previousIsHost = static_cast<bool>(m_Passes[next].CI.hostTask);
+		previousQueueType = m_Passes[next].CI.queueType;
+
+		for (auto& dependant : dependants[next])
+		{
+			if (--inDegrees[dependant] == 0)
+				ready.insert(dependant);
+		}
+	}
+
+	return sortedPassIndices;
+}
+
+void FrameGraph::BuildSubmissions(const std::vector<size_t>& sortedPassIndices)
+{
+	for (auto& passIndex : sortedPassIndices)
+	{
+		Pass& pass = m_Passes[passIndex];
+		bool host = static_cast<bool>(pass.CI.hostTask);
+
+		bool merge = !m_Submissions.empty() && !host && !m_Submissions.back().host && m_Submissions.back().queueType == pass.CI.queueType;
+		if (!merge)
+		{
+			Submission submission;
+			submission.debugName = pass.CI.debugName;
+			submission.queueType = pass.CI.queueType;
+			submission.host = host;
+			submission.waitPipelineStage = PipelineStageBit::TOP_OF_PIPE_BIT;
+			submission.cmdBufferIndex = 0;
+			submission.signalSemaphore = false;
+			m_ExecutionOrder.push_back(m_Submissions.size());
+			m_Submissions.push_back(submission);
+		}
+		else
+		{
+			m_Submissions.back().debugName += " + " + pass.CI.debugName;
+		}
+
+		size_t submissionIndex = m_Submissions.size() - 1;
+		Submission& submission = m_Submissions.back();
+		submission.passIndices.push_back(passIndex);
+		submission.preBarriers.push_back({});
+		pass.submissionIndex = submissionIndex;
+
+		for (auto& dependency : pass.dependencies)
+		{
+			if (m_Passes[dependency].submissionIndex != submissionIndex)
+				submission.dependencies.insert(m_Passes[dependency].submissionIndex);
+		}
+		for (auto& usage : pass.CI.reads)
+			submission.waitPipelineStage = CombinePipelineStages(submission.waitPipelineStage, usage.pipelineStage);
+		for (auto& usage : pass.CI.writes)
+			submission.waitPipelineStage = CombinePipelineStages(submission.waitPipelineStage, usage.pipelineStage);
+	}
+}
+
+void FrameGraph::DeriveBarriers()
+{
+	struct TrackedState
+	{
+		ResourceState	state;
+		bool			owned;			//The state was last set by a queue in this graph or by an import.
+		bool			hasSubmission;
+		size_t			lastSubmissionIndex;
+	};
+	std::map<void*, TrackedState> trackedStates;
+	for (auto& resource : m_Resources)
+		trackedStates[resource.first] = { resource.second.initialState, resource.second.imported, false, 0 };
+
+	//Barrier-only submissions for queues with no passes in the graph, created on demand.
+	std::map<CommandPool::QueueType, size_t> prologues;
+	std::map<CommandPool::QueueType, size_t> epilogues;
+	auto GetBarrierSubmission = [&](std::map<CommandPool::QueueType, size_t>& barrierSubmissions, CommandPool::QueueType queueType, bool prologue) -> size_t
+	{
+		if (barrierSubmissions.find(queueType) == barrierSubmissions.end())
+		{
+			Submission submission;
+			submission.debugName = m_CI.debugName + (prologue ? " Prologue" : " Epilogue");
+			submission.queueType = queueType;
+			submission.host = false;
+			submission.waitPipelineStage = PipelineStageBit::TOP_OF_PIPE_BIT;
+			submission.cmdBufferIndex = 0;
+			submission.signalSemaphore = false;
+			barrierSubmissions[queueType] = m_Submissions.size();
+			if (prologue)
+				m_ExecutionOrder.insert(m_ExecutionOrder.begin(), m_Submissions.size());
+			else
+				m_ExecutionOrder.push_back(m_Submissions.size());
+			m_Submissions.push_back(submission);
+		}
+		return barrierSubmissions[queueType];
+	};
+
+	//Transitions the resource from the tracked state to dstState for use on dstSubmissionIndex. If the queue changes, the 
+	//barrier is recorded on the more capable of the two queues, or split into a release and acquire pair for queue ownership transfers.
+	auto Transition = [&](Resource& resource, TrackedState& tracked, const ResourceState& dstState, size_t dstSubmissionIndex, std::vector<TransitionInfo>& dstTransitions)
+	{
+		const ResourceState& srcState = tracked.state;
+		bool layoutChange = resource.texture && srcState.layout != dstState.layout;
+		bool hazard = IsWriteAccess(srcState.access) || IsWriteAccess(dstState.access);
+		bool queueChange = tracked.owned && srcState.queueType != dstState.queueType;
+
+		if (queueChange)
+		{
+			size_t srcSubmissionIndex = tracked.hasSubmission ? tracked.lastSubmissionIndex : GetBarrierSubmission(prologues, srcState.queueType, true);
+			if (!m_Submissions[srcSubmissionIndex].host && m_Submissions[srcSubmissionIndex].queueType == srcState.queueType)
+			{
+				m_Submissions[dstSubmissionIndex].dependencies.insert(srcSubmissionIndex);
+				Submission& srcSubmission = m_Submissions[srcSubmissionIndex];
+
+				uint32_t srcQueueFamilyIndex = GetQueueFamilyIndex(srcState.queueType);
+				uint32_t dstQueueFamilyIndex = GetQueueFamilyIndex(dstState.queueType);
+				if (srcQueueFamilyIndex != dstQueueFamilyIndex)
+				{
+					//Release on the source queue and acquire on the destination queue.
+					AddBarrier(srcSubmission.postBarriers, resource, srcState, { Barrier::AccessBit::NONE_BIT, dstState.layout, srcState.pipelineStage, srcState.queueType }, srcQueueFamilyIndex, dstQueueFamilyIndex);
+					AddBarrier(dstTransitions, resource, { Barrier::AccessBit::NONE_BIT, srcState.layout, dstState.pipelineStage, dstState.queueType }, dstState, srcQueueFamilyIndex, dstQueueFamilyIndex);
+				}
+				else if (QueueCapability(srcState.queueType) > QueueCapability(dstState.queueType))
+				{
+					AddBarrier(srcSubmission.postBarriers, resource, srcState, { dstState.access, dstState.layout, dstState.pipelineStage, srcState.queueType }, MIRU_QUEUE_FAMILY_IGNORED, MIRU_QUEUE_FAMILY_IGNORED);
+				}
+				else
+				{
+					AddBarrier(dstTransitions, resource, { srcState.access, srcState.layout, m_Submissions[dstSubmissionIndex].waitPipelineStage, dstState.queueType }, dstState, MIRU_QUEUE_FAMILY_IGNORED, MIRU_QUEUE_FAMILY_IGNORED);
+				}
+				return;
+			}
+		}
+
+		if (layoutChange || hazard)
+		{
+			//Work from other queues has been waited on by the submission's semaphores or by a host fence wait.
+			PipelineStageBit srcPipelineStage = srcState.queueType == dstState.queueType ? srcState.pipelineStage : m_Submissions[dstSubmissionIndex].waitPipelineStage;
+			AddBarrier(dstTransitions, resource, { srcState.access, srcState.layout, srcPipelineStage, dstState.queueType }, dstState, MIRU_QUEUE_FAMILY_IGNORED, MIRU_QUEUE_FAMILY_IGNORED);
+		}
+	};
+
+	const std::vector<size_t> executionOrder = m_ExecutionOrder;
+	for (auto& submissionIndex : executionOrder)
+	{
+		for (size_t i = 0; i < m_Submissions[submissionIndex].passIndices.size(); i++)
+		{
+			const Pass& pass = m_Passes[m_Submissions[submissionIndex].passIndices[i]];
+			bool host = m_Submissions[submissionIndex].host;
+
+			std::vector<const ResourceUsage*> usages;
+			for (auto& usage : pass.CI.reads)
+				usages.push_back(&usage);
+			for (auto& usage : pass.CI.writes)
+				usages.push_back(&usage);
+
+			for (auto& usage : usages)
+			{
+				void* key = usage->texture ? (void*)usage->texture.get() : (void*)usage->buffer.get();
+				Resource& resource = m_Resources[key];
+				TrackedState& tracked = trackedStates[key];
+				ResourceState dstState = { usage->access, usage->layout, usage->pipelineStage, pass.CI.queueType };
+
+				//Host tasks transition their own resources.
+				if (!host)
+					Transition(resource, tracked, dstState, submissionIndex, m_Submissions[submissionIndex].preBarriers[i]);
+
+				tracked.state = dstState;
+				tracked.owned = !host;
+				tracked.hasSubmission = true;
+				tracked.lastSubmissionIndex = submissionIndex;
+			}
+		}
+	}
+
+	//Exported resources
+	for (auto& resource : m_Resources)
+	{
+		if (!resource.second.exported)
+			continue;
+
+		TrackedState& tracked = trackedStates[resource.first];
+		const ResourceState& finalState = resource.second.finalState;
+		bool layoutChange = resource.second.texture && tracked.state.layout != finalState.layout;
+		bool queueChange = tracked.owned && tracked.state.queueType != finalState.queueType;
+		if (!layoutChange && !queueChange && tracked.state.access == finalState.access)
+			continue;
+
+		//Record on the last submission if it is on the final queue and used the resource, otherwise on the epilogue.
+		size_t dstSubmissionIndex = m_ExecutionOrder.empty() ? 0 : m_ExecutionOrder.back();
+		bool useLastSubmission = !m_ExecutionOrder.empty() && tracked.hasSubmission && tracked.lastSubmissionIndex == dstSubmissionIndex
+			&& !m_Submissions[dstSubmissionIndex].host && m_Submissions[dstSubmissionIndex].queueType == finalState.queueType;
+		if (!useLastSubmission)
+		{
+			dstSubmissionIndex = GetBarrierSubmission(epilogues, finalState.queueType, false);
+			if (tracked.hasSubmission)
+				m_Submissions[dstSubmissionIndex].dependencies.insert(tracked.lastSubmissionIndex);
+		}
+		m_Submissions[dstSubmissionIndex].waitPipelineStage = CombinePipelineStages(m_Submissions[dstSubmissionIndex].waitPipelineStage, finalState.pipelineStage);
+
+		Transition(resource.second, tracked, finalState, dstSubmissionIndex, m_Submissions[dstSubmissionIndex].postBarriers);
+		tracked.state = finalState;
+	}
+}
+
+void FrameGraph::AddJoin()
+{
+	//Work on the GRAPHICS queue is already ordered by submission, so only other queues with no GPU submission waiting on them are joined.
+	std::set<size_t> waited;
+	for (auto& submission : m_Submissions)
+	{
+		if (!submission.host)
+			waited.insert(submission.dependencies.begin(), submission.dependencies.end());
+	}
+
+	Submission join;
+	join.debugName = m_CI.debugName + " Join";
+	join.queueType = CommandPool::QueueType::GRAPHICS;
+	join.host = false;
+	join.waitPipelineStage = PipelineStageBit::ALL_COMMANDS_BIT;
+	join.cmdBufferIndex = 0;
+	join.signalSemaphore = false;
+	for (auto& submissionIndex : m_ExecutionOrder)
+	{
+		const Submission& submission = m_Submissions[submissionIndex];
+		if (!submission.host && submission.queueType != CommandPool::QueueType::GRAPHICS && waited.find(submissionIndex) == waited.end())
+			join.dependencies.insert(submissionIndex);
+	}
+	if (!join.dependencies.empty())
+	{
+		if (m_CI.cmdBuffers.find(CommandPool::QueueType::GRAPHICS) == m_CI.cmdBuffers.end())
+		{
+			GEAR_ASSERT(ErrorCode::GRAPHICS | ErrorCode::INVALID_VALUE, "FrameGraph: %s requires a GRAPHICS CommandBuffer to join.", m_CI.debugName.c_str());
+			return;
+		}
+		m_ExecutionOrder.push_back(m_Submissions.size());
+		m_Submissions.push_back(join);
+	}
+
+	bool otherQueues = std::any_of(m_Submissions.begin(), m_Submissions.end(),
+		[](const Submission& submission) -> bool { return !submission.host && submission.queueType != CommandPool::QueueType::GRAPHICS; });
+	auto last = std::find_if(m_ExecutionOrder.rbegin(), m_ExecutionOrder.rend(),
+		[&](size_t submissionIndex) -> bool { return !m_Submissions[submissionIndex].host && m_Submissions[submissionIndex].queueType == CommandPool::QueueType::GRAPHICS; });
+	if (!otherQueues || last == m_ExecutionOrder.rend())
+		return;
+
+	//A semaphore wait only orders the commands of the batch that waits on it. Every other queue's work is waited on by a 
+	//GRAPHICS submission, so a full memory barrier at the end of the last one orders all later graphics work after it.
+	Resource memory;
+	memory.texture = nullptr;
+	memory.buffer = nullptr;
+	AddBarrier(m_Submissions[*last].postBarriers, memory,
+		{ Barrier::AccessBit::MEMORY_WRITE_BIT, Image::Layout::UNKNOWN, PipelineStageBit::ALL_COMMANDS_BIT, CommandPool::QueueType::GRAPHICS },
+		{ Barrier::AccessBit::MEMORY_READ_BIT | Barrier::AccessBit::MEMORY_WRITE_BIT, Image::Layout::UNKNOWN, PipelineStageBit::ALL_COMMANDS_BIT, CommandPool::QueueType::GRAPHICS },
+		MIRU_QUEUE_FAMILY_IGNORED, MIRU_QUEUE_FAMILY_IGNORED);
+}
+
+void FrameGraph::AddBarrier(std::vector<TransitionInfo>& transitions, const Resource& resource, const ResourceState& srcState, const ResourceState& dstState, uint32_t srcQueueFamilyIndex, uint32_t dstQueueFamilyIndex)
+{
+	auto it = std::find_if(transitions.begin(), transitions.end(), 
+		[&](const TransitionInfo& transition) -> bool 
+		{ 
+			return transition.srcPipelineStage == srcState.pipelineStage && transition.dstPipelineStage == dstState.pipelineStage;
+		});
+	if (it == transitions.end())
+	{
+		transitions.push_back({ srcState.pipelineStage, dstState.pipelineStage, {} });
+		it = transitions.end() - 1;
+	}
+
+	it->barriers.push_back({ resource.texture, resource.buffer, srcState, dstState, srcQueueFamilyIndex, dstQueueFamilyIndex });
+}
+
+GPUTask::TransitionResourcesTaskInfo* FrameGraph::CreateBarriers(const TransitionInfo& transition)
+{
+	m_Transitions.push_back({ transition.srcPipelineStage, transition.dstPipelineStage, {} });
+	GPUTask::TransitionResourcesTaskInfo& transitionResourcesTI = m_Transitions.back();
+
+	for (auto& barrier : transition.barriers)
+	{
+		if (barrier.texture)
+		{
+			barrier.texture->TransitionSubResources(transitionResourcesTI.barriers, 
+				{ { barrier.srcState.access, barrier.dstState.access, barrier.srcState.layout, barrier.dstState.layout, {}, true } }, 
+				barrier.srcQueueFamilyIndex, barrier.dstQueueFamilyIndex);
+			continue;
+		}
+
+		Barrier::CreateInfo barrierCI;
+		barrierCI.type = barrier.buffer ? Barrier::Type::BUFFER : Barrier::Type::MEMORY;
+		barrierCI.srcAccess = barrier.srcState.access;
+		barrierCI.dstAccess = barrier.dstState.access;
+		barrierCI.srcQueueFamilyIndex = barrier.srcQueueFamilyIndex;
+		barrierCI.dstQueueFamilyIndex = barrier.dstQueueFamilyIndex;
+		barrierCI.pBuffer = barrier.buffer;
+		barrierCI.offset = 0;
+		barrierCI.size = barrier.buffer ? barrier.buffer->GetCreateInfo().size : 0;
+		barrierCI.pImage = nullptr;
+		barrierCI.oldLayout = Image::Layout::UNKNOWN;
+		barrierCI.newLayout = Image::Layout::UNKNOWN;
+		barrierCI.subresoureRange = {};
+		transitionResourcesTI.barriers.emplace_back(Barrier::Create(&barrierCI));
+	}
+	return &transitionResourcesTI;
+}
+
+//Matches the queue family selection of the CommandPools: The first dedicated family for the queue type, otherwise the first capable family.
+uint32_t FrameGraph::GetQueueFamilyIndex(CommandPool::QueueType queueType)
+{
+	if (!m_CI.queueOwnershipTransfers || !GraphicsAPI::IsVulkan())
+		return MIRU_QUEUE_FAMILY_IGNORED;
+
+	VkQueueFlags required = 0;
+	VkQueueFlags excluded = 0;
+	switch (queueType)
+	{
+	case CommandPool::QueueType::GRAPHICS:
+		required = VK_QUEUE_GRAPHICS_BIT; break;
+	case CommandPool::QueueType::COMPUTE:
+		required = VK_QUEUE_COMPUTE_BIT; excluded = VK_QUEUE_GRAPHICS_BIT; break;
+	case CommandPool::QueueType::TRANSFER:
+		required = VK_QUEUE_TRANSFER_BIT; excluded = VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT; break;
+	}
+
+	const std::vector<VkQueueFamilyProperties>& queueFamilyProperties = ref_cast<vulkan::Context>(AllocatorManager::GetCreateInfo().pContext)->m_QueueFamilyProperties;
+	for (uint32_t i = 0; i < static_cast<uint32_t>(queueFamilyProperties.size()); i++)
+	{
+		if ((queueFamilyProperties[i].queueFlags & required) == required && (queueFamilyProperties[i].queueFlags & excluded) == 0)
+			return i;
+	}
+	for (uint32_t i = 0; i < static_cast<uint32_t>(queueFamilyProperties.size()); i++)
+	{
+		if ((queueFamilyProperties[i].queueFlags & required) == required)
+			return i;
+	}
+	return MIRU_QUEUE_FAMILY_IGNORED;
+}
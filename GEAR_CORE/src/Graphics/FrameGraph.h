@@ -1,6 +1,8 @@
 #pragma once
 
 #include "gear_core_common.h"
+#include "Graphics/UniformBufferStructures.h"
+#include "Graphics/BufferCopyBatch.h"
 
 namespace gear
 {
@@ -12,6 +14,13 @@ namespace gear
 		class Model;
 	}
 
+	namespace graphics
+	{
+		class Texture;
+		class MeshPool;
+		template<typename T> class Storagebuffer;
+	}
+
 	namespace graphics
 	{
 		class GPUTask
@@ -40,6 +49,11 @@ namespace gear
 				std::vector<Ref<objects::Model>>		models;
 				bool									modelsForce;
 				bool									materialsForce;
+				std::vector<Ref<Texture>>				textures;
+				std::vector<Ref<MeshPool>>				meshPools;
+				Ref<Storagebuffer<UniformBufferStructures::BindlessMaterials>>	bindlessMaterials;
+				BufferCopyBatch							copyBatch;		//Filled by AddBufferCopies() and recorded by the task.
+				BufferCopyBatch::Statistics				copyStatistics;	//Written by the task.
 			};
 			struct TransitionResourcesTaskInfo
 			{
@@ -60,28 +74,27 @@ namespace gear
 				bool												resetCmdBuffer;
 				bool												submitCmdBuffer;
 				bool												skipTask;
+				Ref<miru::crossplatform::Fence>						fence;				//Required if submitCmdBuffer is true.
+				Ref<miru::crossplatform::Semaphore>					signalSemaphore;	//Optional: Only signalled if a later submission waits on it.
 			};
 
 		private:
 			CreateInfo m_CI;
 
-			Ref<miru::crossplatform::Fence> m_CmdBufferFence;
-			miru::crossplatform::Fence::CreateInfo m_CmdBufferFenceCI;
-
-			Ref<miru::crossplatform::Semaphore> m_SignalSemaphore;
-			miru::crossplatform::Semaphore::CreateInfo m_SignalSemaphoreCI;
-
-
 		public:
 			GPUTask(CreateInfo* pCreateInfo);
 			~GPUTask();
 
 			void Execute();
 
+			//Adds the copies of the buffers that have changed since their last upload to the task info's copyBatch. Call
+			//before the task is executed, so that the copied buffers can be declared to the FrameGraph that executes it.
+			static void AddBufferCopies(UploadResourceTaskInfo& uploadResourcesTI);
+
 			inline const CreateInfo& GetCreateInfo() const { return m_CI; }
 
-			inline const Ref<miru::crossplatform::Fence>& GetFence() const { return m_CmdBufferFence; }
-			inline const Ref<miru::crossplatform::Semaphore>& GetSemaphore() const { return m_SignalSemaphore; }
+			inline const Ref<miru::crossplatform::Fence>& GetFence() const { return m_CI.fence; }
+			inline const Ref<miru::crossplatform::Semaphore>& GetSemaphore() const { return m_CI.signalSemaphore; }
 
 		private:
 			std::vector<std::pair<miru::crossplatform::PipelineStageBit, Ref<GPUTask>>> LastSubmitGPUTasks(
@@ -90,5 +103,165 @@ namespace gear
 			void UploadResources();
 
 		};
+
+		//Declarative frame graph built on top of GPUTask. Passes declare the resources they read and write, and Compile() 
+		//derives the barriers and queue ownership transfers, culls passes with no consumers, orders the passes topologically 
+		//and merges adjacent passes on the same queue into a single submission.
+		class FrameGraph
+		{
+		public:
+			struct ResourceState
+			{
+				miru::crossplatform::Barrier::AccessBit		access;
+				miru::crossplatform::Image::Layout			layout;			//Ignored for buffers.
+				miru::crossplatform::PipelineStageBit		pipelineStage;
+				miru::crossplatform::CommandPool::QueueType	queueType;
+			};
+
+			//Provide either a texture or a buffer.
+			struct ResourceUsage
+			{
+				Ref<Texture>								texture;
+				Ref<miru::crossplatform::Buffer>			buffer;
+				miru::crossplatform::Barrier::AccessBit		access;
+				miru::crossplatform::Image::Layout			layout;			//Ignored for buffers.
+				miru::crossplatform::PipelineStageBit		pipelineStage;
+			};
+
+			struct PassCreateInfo
+			{
+				std::string									debugName;
+				miru::crossplatform::CommandPool::QueueType	queueType;
+				GPUTask::Task								task;
+				void*										pTaskInfo;		//Must outlive Execute().
+				std::function<void()>						hostTask;		//Used instead of task for passes that submit their own work i.e. ImageProcessing. These transition their own resources.
+				std::vector<ResourceUsage>					reads;
+				std::vector<ResourceUsage>					writes;
+				bool										hasSideEffects; //Pass is never culled.
+			};
+
+			struct CommandBufferInfo
+			{
+				Ref<miru::crossplatform::CommandBuffer>		cmdBuffer;
+				std::vector<uint32_t>						cmdBufferIndices; //One index is used per submission on that queue.
+			};
+
+			struct CreateInfo
+			{
+				std::string																debugName;
+				std::map<miru::crossplatform::CommandPool::QueueType, CommandBufferInfo>	cmdBuffers;
+				bool																	queueOwnershipTransfers;
+				bool																	join;	//Ends with a GRAPHICS submission that waits on all other queues and records a full memory barrier, so later graphics work is ordered after the graph without a host wait.
+			};
+
+			//Barriers are described by Compile() and created by Execute(). A barrier with neither a texture nor a buffer is a memory barrier.
+			struct BarrierInfo
+			{
+				Ref<Texture>						texture;
+				Ref<miru::crossplatform::Buffer>	buffer;
+				ResourceState						srcState;
+				ResourceState						dstState;
+				uint32_t							srcQueueFamilyIndex;
+				uint32_t							dstQueueFamilyIndex;
+			};
+
+			struct TransitionInfo
+			{
+				miru::crossplatform::PipelineStageBit	srcPipelineStage;
+				miru::crossplatform::PipelineStageBit	dstPipelineStage;
+				std::vector<BarrierInfo>				barriers;
+			};
+
+			struct Submission
+			{
+				std::string											debugName;
+				miru::crossplatform::CommandPool::QueueType			queueType;
+				bool												host;
+				std::vector<size_t>									passIndices;
+				std::set<size_t>									dependencies;	//Submission indices.
+				miru::crossplatform::PipelineStageBit				waitPipelineStage;
+				std::vector<std::vector<TransitionInfo>>			preBarriers;	//preBarriers[i] is recorded before passIndices[i].
+				std::vector<TransitionInfo>							postBarriers;	//Queue ownership releases and exported state transitions.
+				uint32_t											cmdBufferIndex;
+				bool												signalSemaphore;	//A later GPU submission waits on this one.
+				Ref<GPUTask>										lastGPUTask;
+			};
+
+		private:
+			struct Resource
+			{
+				Ref<Texture>						texture;
+				Ref<miru::crossplatform::Buffer>	buffer;
+				ResourceState						initialState;
+				ResourceState						finalState;
+				bool								imported;
+				bool								exported;
+			};
+
+			struct Pass
+			{
+				PassCreateInfo						CI;
+				std::set<size_t>					dependencies;
+				bool								culled;
+				size_t								submissionIndex;
+			};
+
+			CreateInfo m_CI;
+
+			std::map<void*, Resource> m_Resources;
+			std::vector<Pass> m_Passes;
+			std::vector<Submission> m_Submissions;
+			std::vector<size_t> m_ExecutionOrder;
+			std::vector<Ref<GPUTask>> m_GPUTasks;
+			std::deque<GPUTask::TransitionResourcesTaskInfo> m_Transitions; //Task infos of the barriers created by Execute().
+
+			//Reused by each execution, indexed by the order of the GPU submissions.
+			std::vector<Ref<miru::crossplatform::Fence>> m_Fences;
+			std::vector<Ref<miru::crossplatform::Semaphore>> m_Semaphores;
+			size_t m_SubmittedFenceCount = 0;
+
+			bool m_Compiled = false;
+			size_t m_CulledPassCount = 0;
+
+		public:
+			FrameGraph(CreateInfo* pCreateInfo);
+			~FrameGraph();
+
+			inline const CreateInfo& GetCreateInfo() const { return m_CI; }
+
+			//Sets the state the resource is in before the first pass. Resources that are not imported are assumed to be undefined.
+			void ImportResource(const Ref<Texture>& texture, const ResourceState& initialState);
+			void ImportResource(const Ref<miru::crossplatform::Buffer>& buffer, const ResourceState& initialState);
+			
+			//Marks the resource as consumed outside of the graph and transitions it to finalState after its last use.
+			void ExportResource(const Ref<Texture>& texture, const ResourceState& finalState);
+			void ExportResource(const Ref<miru::crossplatform::Buffer>& buffer, const ResourceState& finalState);
+
+			void AddPass(const PassCreateInfo& passCI);
+
+			void Compile();
+			//Waits for the previous execution, as its CommandBuffers and synchronisation objects are reused.
+			void Execute();
+			void Wait();
+			void Reset();
+
+			inline size_t GetPassCount() const { return m_Passes.size(); }
+			inline size_t GetCulledPassCount() const { return m_CulledPassCount; }
+			inline size_t GetSubmissionCount() const { return m_Submissions.size(); }
+			inline bool IsPassCulled(size_t passIndex) const { return m_Passes[passIndex].culled; }
+			inline const std::vector<Submission>& GetSubmissions() const { return m_Submissions; }
+			inline const std::vector<size_t>& GetExecutionOrder() const { return m_ExecutionOrder; }
+
+		private:
+			Resource& GetResource(const ResourceUsage& usage);
+			void CullPasses();
+			std::vector<size_t> SortPasses();
+			void BuildSubmissions(const std::vector<size_t>& sortedPassIndices);
+			void DeriveBarriers();
+			void AddJoin();
+			void AddBarrier(std::vector<TransitionInfo>& transitions, const Resource& resource, const ResourceState& srcState, const ResourceState& dstState, uint32_t srcQueueFamilyIndex, uint32_t dstQueueFamilyIndex);
+			GPUTask::TransitionResourcesTaskInfo* CreateBarriers(const TransitionInfo& transition);
+			uint32_t GetQueueFamilyIndex(miru::crossplatform::CommandPool::QueueType queueType);
+		};
 	}
 }
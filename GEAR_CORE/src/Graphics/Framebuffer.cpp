@@ -47,6 +47,7 @@ void Framebuffer::AddColourTextureAttachment(size_t attachment)
 	colourTextureCI.data.width = m_CI.width;
 	colourTextureCI.data.height = m_CI.height;
 	colourTextureCI.data.depth = 1;
+	colourTextureCI.data.mipLevels = 1;
 	colourTextureCI.mipLevels = 1;
 	colourTextureCI.arrayLayers = 1;
 	colourTextureCI.type = m_CI.cubemap ? miru::crossplatform::Image::Type::TYPE_CUBE : miru::crossplatform::Image::Type::TYPE_2D;
@@ -70,6 +71,7 @@ void Framebuffer::AddDepthTextureAttachment(size_t attachment)
 	depthTextureCI.data.width = m_CI.width;
 	depthTextureCI.data.height = m_CI.height;
 	depthTextureCI.data.depth = 1;
+	depthTextureCI.data.mipLevels = 1;
 	depthTextureCI.mipLevels = 1;
 	depthTextureCI.arrayLayers = 1;
 	depthTextureCI.type = m_CI.cubemap ? miru::crossplatform::Image::Type::TYPE_CUBE : miru::crossplatform::Image::Type::TYPE_2D;
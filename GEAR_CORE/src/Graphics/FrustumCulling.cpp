@@ -0,0 +1,158 @@
+#include "gear_core_common.h"
+#include "FrustumCulling.h"
+
+#if defined(GEAR_PLATFORM_WINDOWS_X64) || defined(__SSE2__)
+#define GEAR_FRUSTUM_CULLING_SSE
+#include <xmmintrin.h>
+#endif
+
+using namespace gear;
+using namespace graphics;
+
+using namespace mars;
+
+FrustumCulling::Bounds FrustumCulling::Merge(const std::vector<Bounds>& bounds)
+{
+	if (bounds.empty())
+		return { Vec3(0.0f, 0.0f, 0.0f), Vec3(0.0f, 0.0f, 0.0f), Vec4(0.0f, 0.0f, 0.0f, 0.0f) };
+
+	Bounds result = bounds[0];
+	for (const Bounds& b : bounds)
+	{
+		result.boxMin.x = std::min(result.boxMin.x, b.boxMin.x);
+		result.boxMin.y = std::min(result.boxMin.y, b.boxMin.y);
+		result.boxMin.z = std::min(result.boxMin.z, b.boxMin.z);
+		result.boxMax.x = std::max(result.boxMax.x, b.boxMax.x);
+		result.boxMax.y = std::max(result.boxMax.y, b.boxMax.y);
+		result.boxMax.z = std::max(result.boxMax.z, b.boxMax.z);
+	}
+
+	const Vec3 centre((result.boxMin.x + result.boxMax.x) * 0.5f, (result.boxMin.y + result.boxMax.y) * 0.5f, (result.boxMin.z + result.boxMax.z) * 0.5f);
+	float radius = 0.0f;
+	for (const Bounds& b : bounds)
+	{
+		const float dx = b.sphere.x - centre.x;
+		const float dy = b.sphere.y - centre.y;
+		const float dz = b.sphere.z - centre.z;
+		radius = std::max(radius, std::sqrt(dx * dx + dy * dy + dz * dz) + b.sphere.w);
+	}
+	result.sphere = Vec4(centre, radius);
+	return result;
+}
+
+FrustumCulling::Bounds FrustumCulling::Transform(const Bounds& bounds, const Mat4& modl)
+{
+	//Rows of the matrix, which transforms column vectors.
+	const float m[3][4] = {
+		{ modl.a, modl.b, modl.c, modl.d },
+		{ modl.e, modl.f, modl.g, modl.h },
+		{ modl.i, modl.j, modl.k, modl.l } };
+
+	//Arvo: the new extent along each axis is the sum of the absolute contributions of the old extents.
+	const float centre[3] = { (bounds.boxMin.x + bounds.boxMax.x) * 0.5f, (bounds.boxMin.y + bounds.boxMax.y) * 0.5f, (bounds.boxMin.z + bounds.boxMax.z) * 0.5f };
+	const float extent[3] = { (bounds.boxMax.x - bounds.boxMin.x) * 0.5f, (bounds.boxMax.y - bounds.boxMin.y) * 0.5f, (bounds.boxMax.z - bounds.boxMin.z) * 0.5f };
+	const float sphereCentre[3] = { bounds.sphere.x, bounds.sphere.y, bounds.sphere.z };
+
+	Bounds result;
+	float boxCentre[3], boxExtent[3], newSphereCentre[3];
+	for (size_t i = 0; i < 3; i++)
+	{
+		boxCentre[i] = m[i][0] * centre[0] + m[i][1] * centre[1] + m[i][2] * centre[2] + m[i][3];
+		boxExtent[i] = std::abs(m[i][0]) * extent[0] + std::abs(m[i][1]) * extent[1] + std::abs(m[i][2]) * extent[2];
+		newSphereCentre[i] = m[i][0] * sphereCentre[0] + m[i][1] * sphereCentre[1] + m[i][2] * sphereCentre[2] + m[i][3];
+	}
+	result.boxMin = Vec3(boxCentre[0] - boxExtent[0], boxCentre[1] - boxExtent[1], boxCentre[2] - boxExtent[2]);
+	result.boxMax = Vec3(boxCentre[0] + boxExtent[0], boxCentre[1] + boxExtent[1], boxCentre[2] + boxExtent[2]);
+
+	float maxScaleSquared = 0.0f;
+	for (size_t j = 0; j < 3; j++)
+		maxScaleSquared = std::max(maxScaleSquared, m[0][j] * m[0][j] + m[1][j] * m[1][j] + m[2][j] * m[2][j]);
+	result.sphere = Vec4(newSphereCentre[0], newSphereCentre[1], newSphereCentre[2], bounds.sphere.w * std::sqrt(maxScaleSquared));
+	return result;
+}
+
+size_t FrustumCulling::Cull(const std::array<Vec4, 6>& planes, const Bounds* bounds, size_t count, uint8_t* visible)
+{
+	size_t visibleCount = 0;
+	size_t i = 0;
+
+#if defined(GEAR_FRUSTUM_CULLING_SSE)
+	__m128 planeX[6], planeY[6], planeZ[6], planeW[6];
+	for (size_t p = 0; p < 6; p++)
+	{
+		planeX[p] = _mm_set1_ps(planes[p].x);
+		planeY[p] = _mm_set1_ps(planes[p].y);
+		planeZ[p] = _mm_set1_ps(planes[p].z);
+		planeW[p] = _mm_set1_ps(planes[p].w);
+	}
+
+	for (; i + 4 <= count; i += 4)
+	{
+		const Bounds& b0 = bounds[i + 0];
+		const Bounds& b1 = bounds[i + 1];
+		const Bounds& b2 = bounds[i + 2];
+		const Bounds& b3 = bounds[i + 3];
+
+		//Spheres: outside if the signed distance to any plane is less than -radius.
+		const __m128 centreX = _mm_setr_ps(b0.sphere.x, b1.sphere.x, b2.sphere.x, b3.sphere.x);
+		const __m128 centreY = _mm_setr_ps(b0.sphere.y, b1.sphere.y, b2.sphere.y, b3.sphere.y);
+		const __m128 centreZ = _mm_setr_ps(b0.sphere.z, b1.sphere.z, b2.sphere.z, b3.sphere.z);
+		const __m128 negRadius = _mm_setr_ps(-b0.sphere.w, -b1.sphere.w, -b2.sphere.w, -b3.sphere.w);
+
+		__m128 outside = _mm_setzero_ps();
+		for (size_t p = 0; p < 6; p++)
+		{
+			__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[p], centreX), _mm_mul_ps(planeY[p], centreY)), _mm_add_ps(_mm_mul_ps(planeZ[p], centreZ), planeW[p]));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, negRadius));
+		}
+
+		//Boxes: outside if the corner furthest along a plane's normal is behind it.
+		if (_mm_movemask_ps(outside) != 0xF)
+		{
+			const __m128 minX = _mm_setr_ps(b0.boxMin.x, b1.boxMin.x, b2.boxMin.x, b3.boxMin.x);
+			const __m128 minY = _mm_setr_ps(b0.boxMin.y, b1.boxMin.y, b2.boxMin.y, b3.boxMin.y);
+			const __m128 minZ = _mm_setr_ps(b0.boxMin.z, b1.boxMin.z, b2.boxMin.z, b3.boxMin.z);
+			const __m128 maxX = _mm_setr_ps(b0.boxMax.x, b1.boxMax.x, b2.boxMax.x, b3.boxMax.x);
+			const __m128 maxY = _mm_setr_ps(b0.boxMax.y, b1.boxMax.y, b2.boxMax.y, b3.boxMax.y);
+			const __m128 maxZ = _mm_setr_ps(b0.boxMax.z, b1.boxMax.z, b2.boxMax.z, b3.boxMax.z);
+			for (size_t p = 0; p < 6; p++)
+			{
+				const __m128 cornerX = planes[p].x >= 0.0f ? maxX : minX;
+				const __m128 cornerY = planes[p].y >= 0.0f ? maxY : minY;
+				const __m128 cornerZ = planes[p].z >= 0.0f ? maxZ : minZ;
+				__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[p], cornerX), _mm_mul_ps(planeY[p], cornerY)), _mm_add_ps(_mm_mul_ps(planeZ[p], cornerZ), planeW[p]));
+				outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, _mm_setzero_ps()));
+			}
+		}
+
+		const int outsideMask = _mm_movemask_ps(outside);
+		for (size_t j = 0; j < 4; j++)
+		{
+			visible[i + j] = (outsideMask & (1 << j)) ? 0 : 1;
+			visibleCount += visible[i + j];
+		}
+	}
+#endif
+
+	//Scalar path for the remainder, or all bounds without SSE.
+	for (; i < count; i++)
+	{
+		const Bounds& b = bounds[i];
+		bool inside = true;
+		for (const Vec4& plane : planes)
+			inside &= plane.x * b.sphere.x + plane.y * b.sphere.y + plane.z * b.sphere.z + plane.w >= -b.sphere.w;
+
+		for (size_t p = 0; p < 6 && inside; p++)
+		{
+			const Vec4& plane = planes[p];
+			const float cornerX = plane.x >= 0.0f ? b.boxMax.x : b.boxMin.x;
+			const float cornerY = plane.y >= 0.0f ? b.boxMax.y : b.boxMin.y;
+			const float cornerZ = plane.z >= 0.0f ? b.boxMax.z : b.boxMin.z;
+			inside &= plane.x * cornerX + plane.y * cornerY + plane.z * cornerZ + plane.w >= 0.0f;
+		}
+
+		visible[i] = inside ? 1 : 0;
+		visibleCount += visible[i];
+	}
+	return visibleCount;
+}
\ No newline at end of file
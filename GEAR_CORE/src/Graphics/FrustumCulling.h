@@ -0,0 +1,33 @@
+#pragma once
+
+#include "gear_core_common.h"
+
+namespace gear
+{
+namespace graphics
+{
+	class FrustumCulling
+	{
+	public:
+		struct Bounds
+		{
+			mars::Vec3	boxMin;		//Axis aligned bounding box.
+			mars::Vec3	boxMax;
+			mars::Vec4	sphere;		//Centre (xyz) and radius (w).
+		};
+
+	public:
+		//Returns the union of the bounds. The sphere encloses all of the spheres, centred on the union of the boxes.
+		static Bounds Merge(const std::vector<Bounds>& bounds);
+
+		//Transforms object space bounds to world space. The box is re-fitted around the transformed box
+		//and the sphere's radius is scaled by the largest axis scale of the matrix.
+		static Bounds Transform(const Bounds& bounds, const mars::Mat4& modl);
+
+		//Sets visible[i] to 1 if bounds[i] intersects the frustum, otherwise 0. The planes are (normal, distance) with
+		//inward facing normals, as returned by Camera::GetFrustumPlanes(). Bounds are tested four at a time:
+		//the spheres first, then the boxes of any group with a surviving sphere. Returns the number of visible bounds.
+		static size_t Cull(const std::array<mars::Vec4, 6>& planes, const Bounds* bounds, size_t count, uint8_t* visible);
+	};
+}
+}
\ No newline at end of file
@@ -0,0 +1,595 @@
+#include "gear_core_common.h"
+#include "ImageDecoder.h"
+#include "Graphics/Texture.h"
+#include "stb_image.h"
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define GEAR_IMAGE_DECODER_SSE
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define GEAR_TARGET_SSSE3
+#define GEAR_TARGET_F16C
+#else
+#define GEAR_TARGET_SSSE3 __attribute__((target("ssse3")))
+#define GEAR_TARGET_F16C __attribute__((target("f16c")))
+#endif
+#endif
+
+using namespace gear;
+using namespace graphics;
+
+using namespace miru;
+using namespace miru::crossplatform;
+
+static uint16_t FloatToHalf(float value)
+{
+	uint32_t f;
+	memcpy(&f, &value, sizeof(float));
+	const uint32_t sign = f & 0x80000000;
+	f ^= sign;
+
+	uint32_t half;
+	if (f >= 0x47800000) //Infinity, NaN or too large for a half.
+	{
+		half = f > 0x7F800000 ? 0x7E00 : 0x7C00;
+	}
+	else if (f < 0x38800000) //Subnormal half. Adding 0.5 rounds the mantissa into the low bits.
+	{
+		float subnormal;
+		memcpy(&subnormal, &f, sizeof(float));
+		subnormal += 0.5f;
+		memcpy(&half, &subnormal, sizeof(float));
+		half -= 0x3F000000;
+	}
+	else //Normal half. Rebias the exponent and round to nearest even.
+	{
+		const uint32_t mantissaOdd = (f >> 13) & 1;
+		f += 0xC8000FFF + mantissaOdd;
+		half = f >> 13;
+	}
+	return static_cast<uint16_t>(half | (sign >> 16));
+}
+
+static float HalfToFloat(uint16_t half)
+{
+	const uint32_t sign = uint32_t(half & 0x8000) << 16;
+	const uint32_t exponent = (half >> 10) & 0x1F;
+	const uint32_t mantissa = half & 0x3FF;
+
+	uint32_t f;
+	if (exponent == 0x1F)
+	{
+		f = sign | 0x7F800000 | (mantissa << 13);
+	}
+	else if (exponent == 0)
+	{
+		const float value = static_cast<float>(mantissa) * (1.0f / 16777216.0f); //2^-24
+		memcpy(&f, &value, sizeof(float));
+		f |= sign;
+	}
+	else
+	{
+		f = sign | ((exponent + 112) << 23) | (mantissa << 13);
+	}
+
+	float value;
+	memcpy(&value, &f, sizeof(float));
+	return value;
+}
+
+//Shared exponent constants from EXT_texture_shared_exponent: 9 mantissa bits, an exponent bias of 15 and a maximum of 31.
+static constexpr float RGB9E5_MAX = 65408.0f;
+
+static uint32_t FloatToRGB9E5(const float* rgb)
+{
+	//The largest channel sets the exponent. floor(log2(x)) is read from its exponent bits.
+	float channels[3];
+	for (int c = 0; c < 3; c++)
+		channels[c] = rgb[c] > 0.0f ? std::min(rgb[c], RGB9E5_MAX) : 0.0f;
+	const float maxChannel = std::max({ channels[0], channels[1], channels[2] });
+
+	uint32_t maxBits;
+	memcpy(&maxBits, &maxChannel, sizeof(float));
+	int32_t exponent = std::max(static_cast<int32_t>(maxBits >> 23) - 127, -16) + 16;
+
+	//The scale is 2^-(exponent - 24), built from its exponent bits.
+	uint32_t scaleBits = uint32_t(151 - exponent) << 23;
+	float scale;
+	memcpy(&scale, &scaleBits, sizeof(float));
+	if (static_cast<uint32_t>(maxChannel * scale + 0.5f) == 512)
+	{
+		exponent++;
+		scaleBits -= 1 << 23;
+		memcpy(&scale, &scaleBits, sizeof(float));
+	}
+
+	uint32_t packed = uint32_t(exponent) << 27;
+	for (int c = 0; c < 3; c++)
+		packed |= static_cast<uint32_t>(channels[c] * scale + 0.5f) << (9 * c);
+	return packed;
+}
+
+static void RGB9E5ToFloat(uint32_t packed, float* rgb)
+{
+	const uint32_t scaleBits = ((packed >> 27) + 103) << 23; //2^(exponent - 24)
+	float scale;
+	memcpy(&scale, &scaleBits, sizeof(float));
+	for (int c = 0; c < 3; c++)
+		rgb[c] = static_cast<float>((packed >> (9 * c)) & 0x1FF) * scale;
+}
+
+#if defined(GEAR_IMAGE_DECODER_SSE)
+static bool HasSSSE3()
+{
+	static const bool ssse3 = []()
+	{
+	#if defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 1);
+		return (info[2] & (1 << 9)) != 0;
+	#else
+		return __builtin_cpu_supports("ssse3") != 0;
+	#endif
+	}();
+	return ssse3;
+}
+
+static bool HasF16C()
+{
+	static const bool f16c = []()
+	{
+	#if defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 1);
+		return (info[2] & (1 << 29)) != 0;
+	#else
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("f16c") != 0;
+	#endif
+	}();
+	return f16c;
+}
+
+//Each kernel converts as many texels as it can without reading past the end of the row, and returns the count converted.
+GEAR_TARGET_SSSE3 static size_t ConvertRGBToRGBA8_SSSE3(const uint8_t* src, uint8_t* dst, size_t texelCount)
+{
+	const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+	const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xFF000000));
+
+	//16 bytes are loaded for every 12 that are used, so the last texels are left to the scalar loop.
+	size_t i = 0;
+	for (; i + 6 <= texelCount; i += 4)
+	{
+		__m128i rgb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 3 * i));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 4 * i), _mm_or_si128(_mm_shuffle_epi8(rgb, shuffle), alpha));
+	}
+	return i;
+}
+
+static size_t ConvertGreyToRGBA8_SSE2(const uint8_t* src, uint8_t* dst, size_t texelCount)
+{
+	const __m128i alpha = _mm_set1_epi8(-1);
+
+	size_t i = 0;
+	for (; i + 16 <= texelCount; i += 16)
+	{
+		__m128i g = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+		__m128i ggLo = _mm_unpacklo_epi8(g, g);
+		__m128i ggHi = _mm_unpackhi_epi8(g, g);
+		__m128i gaLo = _mm_unpacklo_epi8(g, alpha);
+		__m128i gaHi = _mm_unpackhi_epi8(g, alpha);
+		__m128i* out = reinterpret_cast<__m128i*>(dst + 4 * i);
+		_mm_storeu_si128(out + 0, _mm_unpacklo_epi16(ggLo, gaLo));
+		_mm_storeu_si128(out + 1, _mm_unpackhi_epi16(ggLo, gaLo));
+		_mm_storeu_si128(out + 2, _mm_unpacklo_epi16(ggHi, gaHi));
+		_mm_storeu_si128(out + 3, _mm_unpackhi_epi16(ggHi, gaHi));
+	}
+	return i;
+}
+
+static size_t ConvertGreyAlphaToRGBA8_SSE2(const uint8_t* src, uint8_t* dst, size_t texelCount)
+{
+	const __m128i lowByte = _mm_set1_epi16(0x00FF);
+
+	//Each 16-bit lane holds one texel. The grey byte is duplicated and interleaved with the original lane.
+	size_t i = 0;
+	for (; i + 8 <= texelCount; i += 8)
+	{
+		__m128i ga = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2 * i));
+		__m128i g = _mm_and_si128(ga, lowByte);
+		__m128i gg = _mm_or_si128(g, _mm_slli_epi16(g, 8));
+		__m128i* out = reinterpret_cast<__m128i*>(dst + 4 * i);
+		_mm_storeu_si128(out + 0, _mm_unpacklo_epi16(gg, ga));
+		_mm_storeu_si128(out + 1, _mm_unpackhi_epi16(gg, ga));
+	}
+	return i;
+}
+
+static size_t ConvertRGBA8ToRGBA32F_SSE2(const uint8_t* src, float* dst, size_t texelCount)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128 scale = _mm_set1_ps(1.0f / 255.0f);
+
+	size_t i = 0;
+	for (; i + 4 <= texelCount; i += 4)
+	{
+		__m128i rgba = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 4 * i));
+		__m128i lo = _mm_unpacklo_epi8(rgba, zero);
+		__m128i hi = _mm_unpackhi_epi8(rgba, zero);
+		float* out = dst + 4 * i;
+		_mm_storeu_ps(out + 0, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), scale));
+		_mm_storeu_ps(out + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), scale));
+		_mm_storeu_ps(out + 8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), scale));
+		_mm_storeu_ps(out + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), scale));
+	}
+	return i;
+}
+
+GEAR_TARGET_F16C static size_t ConvertRGBA32FToRGBA16F_F16C(const float* src, uint16_t* dst, size_t texelCount)
+{
+	size_t i = 0;
+	for (; i + 2 <= texelCount; i += 2)
+	{
+		__m128i halfs0 = _mm_cvtps_ph(_mm_loadu_ps(src + 4 * i + 0), _MM_FROUND_TO_NEAREST_INT);
+		__m128i halfs1 = _mm_cvtps_ph(_mm_loadu_ps(src + 4 * i + 4), _MM_FROUND_TO_NEAREST_INT);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 4 * i), _mm_unpacklo_epi64(halfs0, halfs1));
+	}
+	return i;
+}
+
+GEAR_TARGET_F16C static size_t ConvertRGBA16FToRGBA32F_F16C(const uint16_t* src, float* dst, size_t texelCount)
+{
+	size_t i = 0;
+	for (; i + 2 <= texelCount; i += 2)
+	{
+		__m128i halfs = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 4 * i));
+		_mm_storeu_ps(dst + 4 * i + 0, _mm_cvtph_ps(halfs));
+		_mm_storeu_ps(dst + 4 * i + 4, _mm_cvtph_ps(_mm_unpackhi_epi64(halfs, halfs)));
+	}
+	return i;
+}
+
+//The same steps as FloatToHalf(), with selects in place of the branches. Returns the halfs sign extended to 32 bits.
+static __m128i FloatToHalf_SSE2(__m128 f)
+{
+	const __m128i infinityOrNaNLimit = _mm_set1_epi32(0x47800000);
+	const __m128i normalLimit = _mm_set1_epi32(0x38800000);
+	const __m128i subnormalMagic = _mm_set1_epi32(0x3F000000);
+	const __m128i normalBias = _mm_set1_epi32(static_cast<int>(0xC8000FFF));
+
+	__m128 sign = _mm_and_ps(f, _mm_castsi128_ps(_mm_set1_epi32(static_cast<int>(0x80000000))));
+	__m128 absF = _mm_xor_ps(f, sign);
+	__m128i absBits = _mm_castps_si128(absF);
+
+	__m128i isNaN = _mm_castps_si128(_mm_cmpunord_ps(absF, absF));
+	__m128i isRegular = _mm_cmpgt_epi32(infinityOrNaNLimit, absBits);
+	__m128i infinityOrNaN = _mm_or_si128(_mm_and_si128(isNaN, _mm_set1_epi32(0x200)), _mm_set1_epi32(0x7C00));
+
+	__m128i isSubnormal = _mm_cmpgt_epi32(normalLimit, absBits);
+	__m128i subnormal = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(absF, _mm_castsi128_ps(subnormalMagic))), subnormalMagic);
+
+	__m128i mantissaOdd = _mm_and_si128(_mm_srli_epi32(absBits, 13), _mm_set1_epi32(1));
+	__m128i normal = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(absBits, normalBias), mantissaOdd), 13);
+
+	__m128i finite = _mm_or_si128(_mm_and_si128(isSubnormal, subnormal), _mm_andnot_si128(isSubnormal, normal));
+	__m128i half = _mm_or_si128(_mm_and_si128(isRegular, finite), _mm_andnot_si128(isRegular, infinityOrNaN));
+	return _mm_or_si128(half, _mm_srai_epi32(_mm_castps_si128(sign), 16));
+}
+
+static size_t ConvertRGBA32FToRGBA16F_SSE2(const float* src, uint16_t* dst, size_t texelCount)
+{
+	//The sign extended halfs pack to 16 bits without saturating.
+	size_t i = 0;
+	for (; i + 2 <= texelCount; i += 2)
+	{
+		__m128i halfs0 = FloatToHalf_SSE2(_mm_loadu_ps(src + 4 * i + 0));
+		__m128i halfs1 = FloatToHalf_SSE2(_mm_loadu_ps(src + 4 * i + 4));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 4 * i), _mm_packs_epi32(halfs0, halfs1));
+	}
+	return i;
+}
+
+static size_t ConvertRGBA32FToRGB9E5_SSE2(const float* src, uint32_t* dst, size_t texelCount)
+{
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 maxValue = _mm_set1_ps(RGB9E5_MAX);
+	const __m128 half = _mm_set1_ps(0.5f);
+
+	//Four texels are transposed so that each register holds one channel. The steps match FloatToRGB9E5().
+	size_t i = 0;
+	for (; i + 4 <= texelCount; i += 4)
+	{
+		__m128 r = _mm_loadu_ps(src + 4 * i + 0);
+		__m128 g = _mm_loadu_ps(src + 4 * i + 4);
+		__m128 b = _mm_loadu_ps(src + 4 * i + 8);
+		__m128 a = _mm_loadu_ps(src + 4 * i + 12);
+		_MM_TRANSPOSE4_PS(r, g, b, a);
+
+		//_mm_max_ps returns its second operand for NaNs, so NaNs become 0.
+		r = _mm_min_ps(_mm_max_ps(r, zero), maxValue);
+		g = _mm_min_ps(_mm_max_ps(g, zero), maxValue);
+		b = _mm_min_ps(_mm_max_ps(b, zero), maxValue);
+		__m128 maxChannel = _mm_max_ps(_mm_max_ps(r, g), b);
+
+		__m128i exponent = _mm_sub_epi32(_mm_srli_epi32(_mm_castps_si128(maxChannel), 23), _mm_set1_epi32(127));
+		__m128i belowMin = _mm_cmplt_epi32(exponent, _mm_set1_epi32(-16));
+		exponent = _mm_or_si128(_mm_and_si128(belowMin, _mm_set1_epi32(-16)), _mm_andnot_si128(belowMin, exponent));
+		exponent = _mm_add_epi32(exponent, _mm_set1_epi32(16));
+
+		__m128i scaleBits = _mm_slli_epi32(_mm_sub_epi32(_mm_set1_epi32(151), exponent), 23);
+		__m128i maxScaled = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(maxChannel, _mm_castsi128_ps(scaleBits)), half));
+		__m128i overflow = _mm_cmpeq_epi32(maxScaled, _mm_set1_epi32(512));
+		exponent = _mm_sub_epi32(exponent, overflow);
+		scaleBits = _mm_sub_epi32(scaleBits, _mm_and_si128(overflow, _mm_set1_epi32(1 << 23)));
+		__m128 scale = _mm_castsi128_ps(scaleBits);
+
+		__m128i rs = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(r, scale), half));
+		__m128i gs = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(g, scale), half));
+		__m128i bs = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(b, scale), half));
+		__m128i packed = _mm_or_si128(_mm_or_si128(rs, _mm_slli_epi32(gs, 9)), _mm_or_si128(_mm_slli_epi32(bs, 18), _mm_slli_epi32(exponent, 27)));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), packed);
+	}
+	return i;
+}
+
+static size_t ConvertRGBToRGBA32F_SSE2(const float* src, float* dst, size_t texelCount)
+{
+	const __m128 rgbMask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+	const __m128 alpha = _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f);
+
+	//Each load reads the first channel of the next texel, so the last texel is left to the scalar loop.
+	size_t i = 0;
+	for (; i + 1 < texelCount; i++)
+	{
+		__m128 rgb = _mm_loadu_ps(src + 3 * i);
+		_mm_storeu_ps(dst + 4 * i, _mm_or_ps(_mm_and_ps(rgb, rgbMask), alpha));
+	}
+	return i;
+}
+#endif
+
+ImageDecoder::ImageDecoder(CreateInfo* pCreateInfo)
+{
+	m_CI = *pCreateInfo;
+
+	m_ThreadPoolCI.debugName = "GEAR_CORE_ThreadPool_ImageDecoder: " + m_CI.debugName;
+	m_ThreadPoolCI.workerCount = m_CI.workerCount;
+	m_ThreadPool = CreateRef<core::ThreadPool>(&m_ThreadPoolCI);
+}
+
+ImageDecoder::~ImageDecoder()
+{
+}
+
+const Ref<ImageDecoder>& ImageDecoder::GetImageDecoder()
+{
+	static const Ref<ImageDecoder> imageDecoder = []()
+	{
+		CreateInfo imageDecoderCI;
+		imageDecoderCI.debugName = "GEAR_CORE_ImageDecoder";
+		imageDecoderCI.workerCount = 0;
+		return CreateRef<ImageDecoder>(&imageDecoderCI);
+	}();
+	return imageDecoder;
+}
+
+bool ImageDecoder::Decode(const std::string* filepaths, uint32_t count, uint32_t width, uint32_t height, Image::Format format,
+	bool flipVertically, uint8_t* dstData, size_t layerSize)
+{
+	if (count == 1)
+		return DecodeImage(filepaths[0], width, height, format, flipVertically, dstData);
+
+	std::atomic<bool> result = true;
+	m_ThreadPool->ParallelFor(count,
+		[&](size_t begin, size_t end, uint32_t)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				if (!DecodeImage(filepaths[i], width, height, format, flipVertically, dstData + i * layerSize))
+					result = false;
+			}
+		});
+	return result;
+}
+
+bool ImageDecoder::GetImageInfo(const std::string& filepath, ImageInfo& info)
+{
+	int width = 0, height = 0, channels = 0;
+	if (!stbi_info(filepath.c_str(), &width, &height, &channels))
+	{
+		GEAR_WARN(ErrorCode::GRAPHICS | ErrorCode::LOAD_FAILED, "Unable to read %s: %s.", filepath.c_str(), stbi_failure_reason());
+		return false;
+	}
+
+	info.width = static_cast<uint32_t>(width);
+	info.height = static_cast<uint32_t>(height);
+	info.channels = static_cast<uint32_t>(channels);
+	info.hdr = stbi_is_hdr(filepath.c_str());
+	return true;
+}
+
+bool ImageDecoder::DecodeImage(const std::string& filepath, uint32_t width, uint32_t height, Image::Format format, bool flipVertically, uint8_t* dstData)
+{
+	if (!IsOutputFormat(format))
+	{
+		GEAR_WARN(ErrorCode::GRAPHICS | ErrorCode::NOT_SUPPORTED, "Unable to decode %s. The format is not supported.", filepath.c_str());
+		return false;
+	}
+
+	//Files are decoded in their own channels, as the kernels below expand them faster than stbi.
+	const bool floatOutput = format == Image::Format::R32G32B32A32_SFLOAT || format == Image::Format::R16G16B16A16_SFLOAT || format == Image::Format::E5B9G9R9_UFLOAT_PACK32;
+	const bool hdrInput = floatOutput && stbi_is_hdr(filepath.c_str());
+	int w = 0, h = 0, channels = 0;
+	void* stbiBuffer = hdrInput
+		? (void*)stbi_loadf(filepath.c_str(), &w, &h, &channels, 0)
+		: (void*)stbi_load(filepath.c_str(), &w, &h, &channels, 0);
+	if (!stbiBuffer)
+	{
+		GEAR_WARN(ErrorCode::GRAPHICS | ErrorCode::LOAD_FAILED, "Unable to load %s: %s.", filepath.c_str(), stbi_failure_reason());
+		return false;
+	}
+	if (static_cast<uint32_t>(w) != width || static_cast<uint32_t>(h) != height)
+	{
+		GEAR_WARN(ErrorCode::GRAPHICS | ErrorCode::INVALID_VALUE, "The extent of %s does not match the other layers. It is skipped.", filepath.c_str());
+		stbi_image_free(stbiBuffer);
+		return false;
+	}
+
+	//Compact HDR formats are converted from a row of floats.
+	const size_t dstRowSize = size_t(width) * Texture::GetTexelSize(format);
+	std::vector<uint8_t> rowRGBA8((floatOutput && !hdrInput) ? size_t(width) * 4 : 0);
+	std::vector<float> rowRGBA32F((floatOutput && format != Image::Format::R32G32B32A32_SFLOAT) ? size_t(width) * 4 : 0);
+	for (uint32_t y = 0; y < height; y++)
+	{
+		uint8_t* dstRow = dstData + dstRowSize * (flipVertically ? height - 1 - y : y);
+		float* floatRow = rowRGBA32F.empty() ? reinterpret_cast<float*>(dstRow) : rowRGBA32F.data();
+		if (hdrInput)
+		{
+			const float* srcRow = reinterpret_cast<const float*>(stbiBuffer) + size_t(width) * channels * y;
+			ConvertRowToRGBA32F(srcRow, channels, floatRow, width);
+		}
+		else
+		{
+			const uint8_t* srcRow = reinterpret_cast<const uint8_t*>(stbiBuffer) + size_t(width) * channels * y;
+			if (floatOutput)
+			{
+				ConvertRowToRGBA8(srcRow, channels, rowRGBA8.data(), width);
+				ConvertRGBA8ToRGBA32F(rowRGBA8.data(), floatRow, width);
+			}
+			else
+			{
+				ConvertRowToRGBA8(srcRow, channels, dstRow, width);
+			}
+		}
+
+		if (format == Image::Format::R16G16B16A16_SFLOAT)
+			ConvertRGBA32FToRGBA16F(floatRow, reinterpret_cast<uint16_t*>(dstRow), width);
+		else if (format == Image::Format::E5B9G9R9_UFLOAT_PACK32)
+			ConvertRGBA32FToRGB9E5(floatRow, reinterpret_cast<uint32_t*>(dstRow), width);
+	}
+
+	stbi_image_free(stbiBuffer);
+	return true;
+}
+
+bool ImageDecoder::IsOutputFormat(Image::Format format)
+{
+	switch (format)
+	{
+	case Image::Format::R8G8B8A8_UNORM:
+	case Image::Format::R8G8B8A8_SRGB:
+	case Image::Format::R16G16B16A16_SFLOAT:
+	case Image::Format::R32G32B32A32_SFLOAT:
+	case Image::Format::E5B9G9R9_UFLOAT_PACK32:
+		return true;
+	default:
+		return false;
+	}
+}
+
+void ImageDecoder::ConvertRowToRGBA8(const uint8_t* src, uint32_t channels, uint8_t* dst, size_t texelCount)
+{
+	if (channels == 4)
+	{
+		memcpy(dst, src, texelCount * 4);
+		return;
+	}
+
+	size_t i = 0;
+#if defined(GEAR_IMAGE_DECODER_SSE)
+	if (channels == 3 && HasSSSE3())
+		i = ConvertRGBToRGBA8_SSSE3(src, dst, texelCount);
+	else if (channels == 2)
+		i = ConvertGreyAlphaToRGBA8_SSE2(src, dst, texelCount);
+	else if (channels == 1)
+		i = ConvertGreyToRGBA8_SSE2(src, dst, texelCount);
+#endif
+
+	for (; i < texelCount; i++)
+	{
+		const uint8_t* texel = src + i * channels;
+		dst[4 * i + 0] = texel[0];
+		dst[4 * i + 1] = channels > 2 ? texel[1] : texel[0];
+		dst[4 * i + 2] = channels > 2 ? texel[2] : texel[0];
+		dst[4 * i + 3] = channels == 2 ? texel[1] : 255;
+	}
+}
+
+void ImageDecoder::ConvertRowToRGBA32F(const float* src, uint32_t channels, float* dst, size_t texelCount)
+{
+	if (channels == 4)
+	{
+		memcpy(dst, src, texelCount * 4 * sizeof(float));
+		return;
+	}
+
+	size_t i = 0;
+#if defined(GEAR_IMAGE_DECODER_SSE)
+	if (channels == 3)
+		i = ConvertRGBToRGBA32F_SSE2(src, dst, texelCount);
+#endif
+
+	for (; i < texelCount; i++)
+	{
+		const float* texel = src + i * channels;
+		dst[4 * i + 0] = texel[0];
+		dst[4 * i + 1] = channels > 2 ? texel[1] : texel[0];
+		dst[4 * i + 2] = channels > 2 ? texel[2] : texel[0];
+		dst[4 * i + 3] = channels == 2 ? texel[1] : 1.0f;
+	}
+}
+
+void ImageDecoder::ConvertRGBA8ToRGBA32F(const uint8_t* src, float* dst, size_t texelCount)
+{
+	size_t i = 0;
+#if defined(GEAR_IMAGE_DECODER_SSE)
+	i = ConvertRGBA8ToRGBA32F_SSE2(src, dst, texelCount);
+#endif
+
+	for (i *= 4; i < texelCount * 4; i++)
+		dst[i] = static_cast<float>(src[i]) * (1.0f / 255.0f);
+}
+
+void ImageDecoder::ConvertRGBA32FToRGBA16F(const float* src, uint16_t* dst, size_t texelCount)
+{
+	size_t i = 0;
+#if defined(GEAR_IMAGE_DECODER_SSE)
+	i = HasF16C() ? ConvertRGBA32FToRGBA16F_F16C(src, dst, texelCount) : ConvertRGBA32FToRGBA16F_SSE2(src, dst, texelCount);
+#endif
+
+	for (i *= 4; i < texelCount * 4; i++)
+		dst[i] = FloatToHalf(src[i]);
+}
+
+void ImageDecoder::ConvertRGBA16FToRGBA32F(const uint16_t* src, float* dst, size_t texelCount)
+{
+	size_t i = 0;
+#if defined(GEAR_IMAGE_DECODER_SSE)
+	if (HasF16C())
+		i = ConvertRGBA16FToRGBA32F_F16C(src, dst, texelCount);
+#endif
+
+	for (i *= 4; i < texelCount * 4; i++)
+		dst[i] = HalfToFloat(src[i]);
+}
+
+void ImageDecoder::ConvertRGBA32FToRGB9E5(const float* src, uint32_t* dst, size_t texelCount)
+{
+	size_t i = 0;
+#if defined(GEAR_IMAGE_DECODER_SSE)
+	i = ConvertRGBA32FToRGB9E5_SSE2(src, dst, texelCount);
+#endif
+
+	for (; i < texelCount; i++)
+		dst[i] = FloatToRGB9E5(src + 4 * i);
+}
+
+void ImageDecoder::ConvertRGB9E5ToRGBA32F(const uint32_t* src, float* dst, size_t texelCount)
+{
+	for (size_t i = 0; i < texelCount; i++)
+	{
+		RGB9E5ToFloat(src[i], dst + 4 * i);
+		dst[4 * i + 3] = 1.0f;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "gear_core_common.h"
+#include "Core/ThreadPool.h"
+
+namespace gear
+{
+namespace graphics
+{
+	//Decodes image files on a pool of worker threads straight into caller provided memory, such as the data of a Texture.
+	//Every image is converted to the output format, and can be flipped vertically, as its rows are written out, so no
+	//intermediate copy is made. The output formats are R8G8B8A8_UNORM/SRGB and R32G32B32A32_SFLOAT, and for compact HDR
+	//storage R16G16B16A16_SFLOAT (8 bytes per texel) and E5B9G9R9_UFLOAT_PACK32 (4 bytes per texel, no alpha).
+	//The row kernels use SSE2, SSSE3 and F16C where they are available.
+	class ImageDecoder
+	{
+	public:
+		struct CreateInfo
+		{
+			std::string	debugName;
+			uint32_t	workerCount;	//0 uses the hardware thread count.
+		};
+
+		struct ImageInfo
+		{
+			uint32_t	width;
+			uint32_t	height;
+			uint32_t	channels;		//Channels stored in the file.
+			bool		hdr;
+		};
+
+	private:
+		CreateInfo m_CI;
+
+		Ref<core::ThreadPool> m_ThreadPool;
+		core::ThreadPool::CreateInfo m_ThreadPoolCI;
+
+	public:
+		ImageDecoder(CreateInfo* pCreateInfo);
+		~ImageDecoder();
+
+		const CreateInfo& GetCreateInfo() { return m_CI; }
+		inline const Ref<core::ThreadPool>& GetThreadPool() const { return m_ThreadPool; }
+
+		//Returns the shared decoder, which is created on first use.
+		static const Ref<ImageDecoder>& GetImageDecoder();
+
+		//Decodes one image per layer in parallel. Layer i is written layerSize bytes after layer i - 1. Images whose extent
+		//does not match width and height are skipped and their layers are left untouched. Returns false if any image failed.
+		bool Decode(const std::string* filepaths, uint32_t count, uint32_t width, uint32_t height, miru::crossplatform::Image::Format format,
+			bool flipVertically, uint8_t* dstData, size_t layerSize);
+
+		//Reads the extent and channels of the image without decoding it.
+		static bool GetImageInfo(const std::string& filepath, ImageInfo& info);
+		//Decodes the image into dstData, which must hold width * height texels of the format.
+		static bool DecodeImage(const std::string& filepath, uint32_t width, uint32_t height, miru::crossplatform::Image::Format format, bool flipVertically, uint8_t* dstData);
+		static bool IsOutputFormat(miru::crossplatform::Image::Format format);
+
+		//Row kernels. Missing colour channels are copied from the first channel, and a missing alpha is set to 1.
+		static void ConvertRowToRGBA8(const uint8_t* src, uint32_t channels, uint8_t* dst, size_t texelCount);
+		static void ConvertRowToRGBA32F(const float* src, uint32_t channels, float* dst, size_t texelCount);
+		//Converts RGBA8 texels to floats in [0, 1]. No colour space conversion is applied.
+		static void ConvertRGBA8ToRGBA32F(const uint8_t* src, float* dst, size_t texelCount);
+		//Rounds to the nearest half. Values out of range become infinity, and NaNs stay NaNs.
+		static void ConvertRGBA32FToRGBA16F(const float* src, uint16_t* dst, size_t texelCount);
+		static void ConvertRGBA16FToRGBA32F(const uint16_t* src, float* dst, size_t texelCount);
+		//Follows the encoding of EXT_texture_shared_exponent. Negative values and NaNs become 0, large values are clamped
+		//to 65408 and alpha is discarded.
+		static void ConvertRGBA32FToRGB9E5(const float* src, uint32_t* dst, size_t texelCount);
+		static void ConvertRGB9E5ToRGBA32F(const uint32_t* src, float* dst, size_t texelCount);
+	};
+}
+}
\ No newline at end of file
@@ -14,11 +14,11 @@ using namespace graphics;
 using namespace miru;
 using namespace miru::crossplatform;
 
-Ref<RenderPipeline> ImageProcessing::s_PipelineMipMap;
-Ref<RenderPipeline> ImageProcessing::s_PipelineMipMapArray;
-Ref<RenderPipeline> ImageProcessing::s_PipelineEquirectangularToCube;
-Ref<RenderPipeline> ImageProcessing::s_PipelineDiffuseIrradiance;
-Ref<RenderPipeline> ImageProcessing::s_PipelineSpecularIrradiance;
+ImageProcessing::PipelinesPerFormat ImageProcessing::s_PipelineMipMap;
+ImageProcessing::PipelinesPerFormat ImageProcessing::s_PipelineMipMapArray;
+ImageProcessing::PipelinesPerFormat ImageProcessing::s_PipelineEquirectangularToCube;
+ImageProcessing::PipelinesPerFormat ImageProcessing::s_PipelineDiffuseIrradiance;
+ImageProcessing::PipelinesPerFormat ImageProcessing::s_PipelineSpecularIrradiance;
 Ref<RenderPipeline> ImageProcessing::s_PipelineSpecularBRDF_LUT;
 
 ImageProcessing::ImageProcessing()
@@ -34,29 +34,6 @@ void ImageProcessing::GenerateMipMaps(const TextureResourceInfo& TRI)
 	if (!TRI.texture->m_GenerateMipMaps || TRI.texture->m_Generated)
 		return;
 
-	if(!s_PipelineMipMap)
-	{ 
-		RenderPipeline::LoadInfo s_PipelineLI;
-		s_PipelineLI.device = AllocatorManager::GetCreateInfo().pContext->GetDevice();
-		s_PipelineLI.filepath = "res/pipelines/Mipmap.grpf.json";
-		s_PipelineLI.viewportWidth = 0.0f;
-		s_PipelineLI.viewportHeight = 0.0f;
-		s_PipelineLI.renderPass = nullptr;
-		s_PipelineLI.subpassIndex = 0;
-		s_PipelineMipMap = CreateRef<RenderPipeline>(&s_PipelineLI);
-	}
-	if (!s_PipelineMipMapArray)
-	{
-		RenderPipeline::LoadInfo s_PipelineLI;
-		s_PipelineLI.device = AllocatorManager::GetCreateInfo().pContext->GetDevice();
-		s_PipelineLI.filepath = "res/pipelines/MipmapArray.grpf.json";
-		s_PipelineLI.viewportWidth = 0.0f;
-		s_PipelineLI.viewportHeight = 0.0f;
-		s_PipelineLI.renderPass = nullptr;
-		s_PipelineLI.subpassIndex = 0;
-		s_PipelineMipMapArray = CreateRef<RenderPipeline>(&s_PipelineLI);
-	}
-
 	CommandPool::CreateInfo m_ComputeCmdPoolCI;
 	m_ComputeCmdPoolCI.debugName = "GEAR_CORE_CommandPool_MipMap_Compute";
 	m_ComputeCmdPoolCI.pContext = AllocatorManager::GetCreateInfo().pContext;
@@ -75,9 +52,7 @@ void ImageProcessing::GenerateMipMaps(const TextureResourceInfo& TRI)
 	const uint32_t& levels = TRI.texture->GetCreateInfo().mipLevels;
 	const uint32_t& layers = TRI.texture->GetCreateInfo().arrayLayers;
 
-	Ref<RenderPipeline>& pipeline = s_PipelineMipMap;
-	if (layers > 1)
-		pipeline = s_PipelineMipMapArray;
+	const Ref<RenderPipeline>& pipeline = layers > 1 ? GetPipeline(s_PipelineMipMapArray, "res/pipelines/MipmapArray", TRI) : GetPipeline(s_PipelineMipMap, "res/pipelines/Mipmap", TRI);
 
 	std::vector<Ref<ImageView>> m_ImageViews;
 	m_ImageViews.reserve(levels);
@@ -86,7 +61,7 @@ void ImageProcessing::GenerateMipMaps(const TextureResourceInfo& TRI)
 	m_ImageViewCI.debugName = "GEAR_CORE_ImageView_MipMap";
 	m_ImageViewCI.device = m_ComputeCmdPoolCI.pContext->GetDevice();
 	m_ImageViewCI.pImage = TRI.texture->GetTexture();
-	m_ImageViewCI.viewType = pipeline == s_PipelineMipMapArray ? Image::Type::TYPE_2D_ARRAY : Image::Type::TYPE_2D;
+	m_ImageViewCI.viewType = layers > 1 ? Image::Type::TYPE_2D_ARRAY : Image::Type::TYPE_2D;
 	for (uint32_t i = 0; i < levels; i++)
 	{
 		m_ImageViewCI.subresourceRange = { Image::AspectBit::COLOUR_BIT, i, 1, 0, layers };
@@ -199,17 +174,9 @@ void ImageProcessing::GenerateMipMaps(const TextureResourceInfo& TRI)
 
 void ImageProcessing::EquirectangularToCube(const TextureResourceInfo& environmentCubemapTRI, const TextureResourceInfo& equirectangularTRI)
 {
-	if (!s_PipelineEquirectangularToCube)
-	{
-		RenderPipeline::LoadInfo s_PipelineLI;
-		s_PipelineLI.device = AllocatorManager::GetCreateInfo().pContext->GetDevice();
-		s_PipelineLI.filepath = "res/pipelines/EquirectangularToCube.grpf.json";
-		s_PipelineLI.viewportWidth = 0.0f;
-		s_PipelineLI.viewportHeight = 0.0f;
-		s_PipelineLI.renderPass = nullptr;
-		s_PipelineLI.subpassIndex = 0;
-		s_PipelineEquirectangularToCube = CreateRef<RenderPipeline>(&s_PipelineLI);
-	}
+	CheckStorageFormat(environmentCubemapTRI);
+
+	const Ref<RenderPipeline>& pipeline = GetPipeline(s_PipelineEquirectangularToCube, "res/pipelines/EquirectangularToCube", environmentCubemapTRI);
 
 	CommandPool::CreateInfo m_ComputeCmdPoolCI;
 	m_ComputeCmdPoolCI.debugName = "GEAR_CORE_CommandPool_EquirectangularToCube_Compute";
@@ -254,7 +221,7 @@ void ImageProcessing::EquirectangularToCube(const TextureResourceInfo& environme
 	DescriptorSet::CreateInfo m_DescSetCI;
 	m_DescSetCI.debugName = "GEAR_CORE_DescriptorSet_EquirectangularToCube";
 	m_DescSetCI.pDescriptorPool = m_DescPool;
-	m_DescSetCI.pDescriptorSetLayouts = s_PipelineEquirectangularToCube->GetDescriptorSetLayouts();
+	m_DescSetCI.pDescriptorSetLayouts = pipeline->GetDescriptorSetLayouts();
 	m_DescSet = DescriptorSet::Create(&m_DescSetCI);
 	Image::Layout m_EquirectangularImageLayout = GraphicsAPI::IsD3D12() ? Image::Layout::D3D12_NON_PIXEL_SHADER_READ_ONLY_OPTIMAL : Image::Layout::SHADER_READ_ONLY_OPTIMAL;
 	Image::Layout m_CubeImageLayout = GraphicsAPI::IsD3D12() ? Image::Layout::D3D12_UNORDERED_ACCESS : Image::Layout::GENERAL;
@@ -291,7 +258,7 @@ void ImageProcessing::EquirectangularToCube(const TextureResourceInfo& environme
 			m_ComputeCmdBuffer->PipelineBarrier(0, equirectangularTRI.srcStage, PipelineStageBit::COMPUTE_SHADER_BIT, DependencyBit::NONE_BIT, barriers);
 		}
 
-		m_ComputeCmdBuffer->BindPipeline(0, s_PipelineEquirectangularToCube->GetPipeline());
+		m_ComputeCmdBuffer->BindPipeline(0, pipeline->GetPipeline());
 		Texture::SubresouresTransitionInfo cubePreDispatch;
 		cubePreDispatch.srcAccess = environmentCubemapTRI.srcAccess;
 		cubePreDispatch.dstAccess = Barrier::AccessBit::SHADER_READ_BIT | Barrier::AccessBit::SHADER_WRITE_BIT;
@@ -307,7 +274,7 @@ void ImageProcessing::EquirectangularToCube(const TextureResourceInfo& environme
 			m_ComputeCmdBuffer->PipelineBarrier(0, environmentCubemapTRI.srcStage, PipelineStageBit::COMPUTE_SHADER_BIT, DependencyBit::NONE_BIT, barriers);
 		}
 
-		m_ComputeCmdBuffer->BindDescriptorSets(0, { m_DescSet }, s_PipelineEquirectangularToCube->GetPipeline());
+		m_ComputeCmdBuffer->BindDescriptorSets(0, { m_DescSet }, pipeline->GetPipeline());
 		uint32_t width = std::max(environmentCubemapTRI.texture->GetWidth() / 32, uint32_t(1));
 		uint32_t height = std::max(environmentCubemapTRI.texture->GetHeight() / 32, uint32_t(1));
 		uint32_t depth = 6;
@@ -352,17 +319,9 @@ void ImageProcessing::EquirectangularToCube(const TextureResourceInfo& environme
 
 void ImageProcessing::DiffuseIrradiance(const TextureResourceInfo& diffuseIrradianceTRI, const TextureResourceInfo& environmentCubemapTRI)
 {
-	if (!s_PipelineDiffuseIrradiance)
-	{
-		RenderPipeline::LoadInfo s_PipelineLI;
-		s_PipelineLI.device = AllocatorManager::GetCreateInfo().pContext->GetDevice();
-		s_PipelineLI.filepath = "res/pipelines/DiffuseIrradiance.grpf.json";
-		s_PipelineLI.viewportWidth = 0.0f;
-		s_PipelineLI.viewportHeight = 0.0f;
-		s_PipelineLI.renderPass = nullptr;
-		s_PipelineLI.subpassIndex = 0;
-		s_PipelineDiffuseIrradiance = CreateRef<RenderPipeline>(&s_PipelineLI);
-	}
+	CheckStorageFormat(diffuseIrradianceTRI);
+
+	const Ref<RenderPipeline>& pipeline = GetPipeline(s_PipelineDiffuseIrradiance, "res/pipelines/DiffuseIrradiance", diffuseIrradianceTRI);
 
 	CommandPool::CreateInfo m_ComputeCmdPoolCI;
 	m_ComputeCmdPoolCI.debugName = "GEAR_CORE_CommandPool_DiffuseIrradiance_Compute";
@@ -407,7 +366,7 @@ void ImageProcessing::DiffuseIrradiance(const TextureResourceInfo& diffuseIrradi
 	DescriptorSet::CreateInfo m_DescSetCI;
 	m_DescSetCI.debugName = "GEAR_CORE_DescriptorSet_DiffuseIrradiance";
 	m_DescSetCI.pDescriptorPool = m_DescPool;
-	m_DescSetCI.pDescriptorSetLayouts = s_PipelineDiffuseIrradiance->GetDescriptorSetLayouts();
+	m_DescSetCI.pDescriptorSetLayouts = pipeline->GetDescriptorSetLayouts();
 	m_DescSet = DescriptorSet::Create(&m_DescSetCI);
 	Image::Layout m_EnvironmentImageLayout = GraphicsAPI::IsD3D12() ? Image::Layout::D3D12_NON_PIXEL_SHADER_READ_ONLY_OPTIMAL : Image::Layout::SHADER_READ_ONLY_OPTIMAL;
 	Image::Layout m_DiffuseIrradianceImageLayout = GraphicsAPI::IsD3D12() ? Image::Layout::D3D12_UNORDERED_ACCESS : Image::Layout::GENERAL;
@@ -441,7 +400,7 @@ void ImageProcessing::DiffuseIrradiance(const TextureResourceInfo& diffuseIrradi
 		environmentCubemapTRI.texture->TransitionSubResources(barriers, { environmentPreDispatch });
 		m_ComputeCmdBuffer->PipelineBarrier(0, environmentCubemapTRI.srcStage, PipelineStageBit::COMPUTE_SHADER_BIT, DependencyBit::NONE_BIT, barriers);
 
-		m_ComputeCmdBuffer->BindPipeline(0, s_PipelineDiffuseIrradiance->GetPipeline());
+		m_ComputeCmdBuffer->BindPipeline(0, pipeline->GetPipeline());
 		Texture::SubresouresTransitionInfo diffuseCubePreDispatch;
 		diffuseCubePreDispatch.srcAccess = diffuseIrradianceTRI.srcAccess;
 		diffuseCubePreDispatch.dstAccess = Barrier::AccessBit::SHADER_READ_BIT | Barrier::AccessBit::SHADER_WRITE_BIT;
@@ -454,7 +413,7 @@ void ImageProcessing::DiffuseIrradiance(const TextureResourceInfo& diffuseIrradi
 		diffuseIrradianceTRI.texture->TransitionSubResources(barriers, { diffuseCubePreDispatch });
 		m_ComputeCmdBuffer->PipelineBarrier(0, diffuseIrradianceTRI.srcStage, PipelineStageBit::COMPUTE_SHADER_BIT, DependencyBit::NONE_BIT, barriers);
 
-		m_ComputeCmdBuffer->BindDescriptorSets(0, { m_DescSet }, s_PipelineDiffuseIrradiance->GetPipeline());
+		m_ComputeCmdBuffer->BindDescriptorSets(0, { m_DescSet }, pipeline->GetPipeline());
 		uint32_t width = std::max(diffuseIrradianceTRI.texture->GetWidth() / 32, uint32_t(1));
 		uint32_t height = std::max(diffuseIrradianceTRI.texture->GetHeight() / 32, uint32_t(1));
 		uint32_t depth = 6;
@@ -493,17 +452,9 @@ void ImageProcessing::DiffuseIrradiance(const TextureResourceInfo& diffuseIrradi
 
 void ImageProcessing::SpecularIrradiance(const TextureResourceInfo& specularIrradianceTRI, const TextureResourceInfo& environmentCubemapTRI)
 {
-	if (!s_PipelineSpecularIrradiance)
-	{
-		RenderPipeline::LoadInfo s_PipelineLI;
-		s_PipelineLI.device = AllocatorManager::GetCreateInfo().pContext->GetDevice();
-		s_PipelineLI.filepath = "res/pipelines/SpecularIrradiance.grpf.json";
-		s_PipelineLI.viewportWidth = 0.0f;
-		s_PipelineLI.viewportHeight = 0.0f;
-		s_PipelineLI.renderPass = nullptr;
-		s_PipelineLI.subpassIndex = 0;
-		s_PipelineSpecularIrradiance = CreateRef<RenderPipeline>(&s_PipelineLI);
-	}
+	CheckStorageFormat(specularIrradianceTRI);
+
+	const Ref<RenderPipeline>& pipeline = GetPipeline(s_PipelineSpecularIrradiance, "res/pipelines/SpecularIrradiance", specularIrradianceTRI);
 
 	CommandPool::CreateInfo m_ComputeCmdPoolCI;
 	m_ComputeCmdPoolCI.debugName = "GEAR_CORE_CommandPool_SpecularIrradiance_Compute";
@@ -552,6 +503,7 @@ void ImageProcessing::SpecularIrradiance(const TextureResourceInfo& specularIrra
 	ubCI.debugName = "GEAR_CORE_Buffer_SpecularIrradianceInfoUB";
 	ubCI.device = m_ComputeCmdPoolCI.pContext->GetDevice();
 	ubCI.data = zero;
+	ubCI.perFrame = false;
 	for (uint32_t i = 0; i < levels; i++)
 	{
 		m_SpecularIrradianceInfoUBs[i] = CreateRef<Uniformbuffer<SpecularIrradianceInfoUB>>(&ubCI);
@@ -570,7 +522,7 @@ void ImageProcessing::SpecularIrradiance(const TextureResourceInfo& specularIrra
 	DescriptorSet::CreateInfo m_DescSetCI;
 	m_DescSetCI.debugName = "GEAR_CORE_DescriptorSet_SpecularIrradiance";
 	m_DescSetCI.pDescriptorPool = m_DescPool;
-	m_DescSetCI.pDescriptorSetLayouts = s_PipelineSpecularIrradiance->GetDescriptorSetLayouts();
+	m_DescSetCI.pDescriptorSetLayouts = pipeline->GetDescriptorSetLayouts();
 	Image::Layout m_EnvironmentImageLayout = GraphicsAPI::IsD3D12() ? Image::Layout::D3D12_NON_PIXEL_SHADER_READ_ONLY_OPTIMAL : Image::Layout::SHADER_READ_ONLY_OPTIMAL;
 	Image::Layout m_SpecularIrradianceImageLayout = GraphicsAPI::IsD3D12() ? Image::Layout::D3D12_UNORDERED_ACCESS : Image::Layout::GENERAL;
 	for (uint32_t i = 0; i < m_DescPoolCI.maxSets; i++)
@@ -608,7 +560,7 @@ void ImageProcessing::SpecularIrradiance(const TextureResourceInfo& specularIrra
 		environmentCubemapTRI.texture->TransitionSubResources(barriers, { environmentPreDispatch });
 		m_ComputeCmdBuffer->PipelineBarrier(0, environmentCubemapTRI.srcStage, PipelineStageBit::COMPUTE_SHADER_BIT, DependencyBit::NONE_BIT, barriers);
 
-		m_ComputeCmdBuffer->BindPipeline(0, s_PipelineSpecularIrradiance->GetPipeline());
+		m_ComputeCmdBuffer->BindPipeline(0, pipeline->GetPipeline());
 		Texture::SubresouresTransitionInfo specularCubePreDispatch;
 		specularCubePreDispatch.srcAccess = specularIrradianceTRI.srcAccess;
 		specularCubePreDispatch.dstAccess = Barrier::AccessBit::SHADER_READ_BIT | Barrier::AccessBit::SHADER_WRITE_BIT;
@@ -638,7 +590,7 @@ void ImageProcessing::SpecularIrradiance(const TextureResourceInfo& specularIrra
 				m_ComputeCmdBuffer->PipelineBarrier(0, PipelineStageBit::COMPUTE_SHADER_BIT, PipelineStageBit::COMPUTE_SHADER_BIT, DependencyBit::NONE_BIT, { b });
 			};
 
-			m_ComputeCmdBuffer->BindDescriptorSets(0, { m_DescSets[i] }, s_PipelineSpecularIrradiance->GetPipeline());
+			m_ComputeCmdBuffer->BindDescriptorSets(0, { m_DescSets[i] }, pipeline->GetPipeline());
 			uint32_t width = std::max((specularIrradianceTRI.texture->GetWidth() >> i) / 32, uint32_t(1));
 			uint32_t height = std::max((specularIrradianceTRI.texture->GetHeight() >> i) / 32, uint32_t(1));
 			uint32_t depth = 6;
@@ -678,6 +630,8 @@ void ImageProcessing::SpecularIrradiance(const TextureResourceInfo& specularIrra
 
 void ImageProcessing::SpecularBRDF_LUT(const TextureResourceInfo& TRI)
 {
+	CheckStorageFormat(TRI);
+
 	if (!s_PipelineSpecularBRDF_LUT)
 	{
 		RenderPipeline::LoadInfo s_PipelineLI;
@@ -788,14 +742,44 @@ void ImageProcessing::SpecularBRDF_LUT(const TextureResourceInfo& TRI)
 void ImageProcessing::RecompileRenderPipelineShaders()
 {
 	AllocatorManager::GetCreateInfo().pContext->DeviceWaitIdle();
-	if(s_PipelineMipMap)
-		s_PipelineMipMap->RecompileShaders();
-	if (s_PipelineMipMapArray)
-		s_PipelineMipMapArray->RecompileShaders();
-	if (s_PipelineEquirectangularToCube)
-		s_PipelineEquirectangularToCube->RecompileShaders();
-	if (s_PipelineDiffuseIrradiance)
-		s_PipelineDiffuseIrradiance->RecompileShaders();
-	if (s_PipelineSpecularIrradiance)
-		s_PipelineSpecularIrradiance->RecompileShaders();
+	for (PipelinesPerFormat* pipelines : { &s_PipelineMipMap, &s_PipelineMipMapArray, &s_PipelineEquirectangularToCube, &s_PipelineDiffuseIrradiance, &s_PipelineSpecularIrradiance })
+	{
+		for (auto& pipeline : *pipelines)
+			pipeline.second->RecompileShaders();
+	}
+}
+
+void ImageProcessing::CheckStorageFormat(const TextureResourceInfo& TRI)
+{
+	if (!Texture::IsStorageFormat(TRI.texture->GetCreateInfo().format))
+	{
+		GEAR_ASSERT(ErrorCode::GRAPHICS | ErrorCode::NOT_SUPPORTED, "Texture: %s can not be written by ImageProcessing, as its format is not a storage format.", TRI.texture->GetCreateInfo().debugName.c_str());
+	}
+}
+
+const Ref<RenderPipeline>& ImageProcessing::GetPipeline(PipelinesPerFormat& pipelines, const std::string& filepath, const TextureResourceInfo& TRI)
+{
+	const Image::Format format = TRI.texture->GetCreateInfo().format;
+	Ref<RenderPipeline>& pipeline = pipelines[format];
+	if (!pipeline)
+	{
+		//The pipeline files without a suffix are for R16G16B16A16_SFLOAT.
+		std::string suffix = "_ANY";
+		if (format == Image::Format::R16G16B16A16_SFLOAT)
+			suffix = "";
+		else if (format == Image::Format::R8G8B8A8_UNORM)
+			suffix = "_RGBA8";
+		else if (format == Image::Format::R32G32B32A32_SFLOAT)
+			suffix = "_RGBA32F";
+
+		RenderPipeline::LoadInfo s_PipelineLI;
+		s_PipelineLI.device = AllocatorManager::GetCreateInfo().pContext->GetDevice();
+		s_PipelineLI.filepath = filepath + suffix + ".grpf.json";
+		s_PipelineLI.viewportWidth = 0.0f;
+		s_PipelineLI.viewportHeight = 0.0f;
+		s_PipelineLI.renderPass = nullptr;
+		s_PipelineLI.subpassIndex = 0;
+		pipeline = CreateRef<RenderPipeline>(&s_PipelineLI);
+	}
+	return pipeline;
 }
@@ -8,6 +8,10 @@ namespace graphics
 	class Texture;
 	class RenderPipeline;
 
+	//The generated textures are written as storage images with float4 texels, so any storage format works, such as the compact
+	//R16G16B16A16_SFLOAT for HDR. The source textures are only sampled, so they can also be E5B9G9R9_UFLOAT_PACK32.
+	//The storage images are declared with their format, so each format has its own pipeline. R8G8B8A8_UNORM, R16G16B16A16_SFLOAT
+	//and R32G32B32A32_SFLOAT have their own. Other formats use the _ANY pipelines, which need shaderStorageImageWriteWithoutFormat.
 	class ImageProcessing
 	{
 	public:
@@ -20,11 +24,12 @@ namespace graphics
 		};
 
 	private:
-		static Ref<RenderPipeline> s_PipelineMipMap;
-		static Ref<RenderPipeline> s_PipelineMipMapArray;
-		static Ref<RenderPipeline> s_PipelineEquirectangularToCube;
-		static Ref<RenderPipeline> s_PipelineDiffuseIrradiance;
-		static Ref<RenderPipeline> s_PipelineSpecularIrradiance;
+		typedef std::map<miru::crossplatform::Image::Format, Ref<RenderPipeline>> PipelinesPerFormat;
+		static PipelinesPerFormat s_PipelineMipMap;
+		static PipelinesPerFormat s_PipelineMipMapArray;
+		static PipelinesPerFormat s_PipelineEquirectangularToCube;
+		static PipelinesPerFormat s_PipelineDiffuseIrradiance;
+		static PipelinesPerFormat s_PipelineSpecularIrradiance;
 		static Ref<RenderPipeline> s_PipelineSpecularBRDF_LUT;
 
 	public:
@@ -47,6 +52,11 @@ namespace graphics
 		static void SpecularBRDF_LUT(const TextureResourceInfo& TRI);
 
 		static void RecompileRenderPipelineShaders();
+
+	private:
+		static void CheckStorageFormat(const TextureResourceInfo& TRI);
+		//Returns the pipeline for the format of the texture, which is loaded on first use. The filepath has no extension.
+		static const Ref<RenderPipeline>& GetPipeline(PipelinesPerFormat& pipelines, const std::string& filepath, const TextureResourceInfo& TRI);
 	};
 }
 }
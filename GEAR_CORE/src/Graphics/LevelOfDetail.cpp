@@ -0,0 +1,48 @@
+#include "gear_core_common.h"
+#include "LevelOfDetail.h"
+#include "Objects/Camera.h"
+#include "Objects/Mesh.h"
+
+#include <cfloat>
+
+using namespace gear;
+using namespace graphics;
+
+using namespace mars;
+
+LevelOfDetail::View LevelOfDetail::GetView(const objects::Camera& camera, float viewportHeight)
+{
+	//proj.f maps view space y to clip space y, which spans viewportHeight / 2 pixels either side of the centre.
+	View view;
+	view.position = camera.m_CI.transform.translation;
+	view.pixelsPerUnit = std::abs(camera.GetUB()->proj.f) * viewportHeight * 0.5f;
+	view.perspective = camera.m_CI.projectionType == objects::Camera::ProjectionType::PERSPECTIVE;
+	view.zNear = view.perspective ? camera.m_CI.perspectiveParams.zNear : camera.m_CI.orthographicsParams.near;
+	return view;
+}
+
+float LevelOfDetail::ProjectError(const View& view, const Vec4& worldSphere, float worldError)
+{
+	if (!view.perspective)
+		return worldError * view.pixelsPerUnit;
+
+	const Vec3 offset(worldSphere.x - view.position.x, worldSphere.y - view.position.y, worldSphere.z - view.position.z);
+	const float distance = std::sqrt(offset.x * offset.x + offset.y * offset.y + offset.z * offset.z) - worldSphere.w;
+	return worldError * view.pixelsPerUnit / std::max(distance, std::max(view.zNear, FLT_EPSILON));
+}
+
+uint32_t LevelOfDetail::Select(const View& view, const objects::Mesh& mesh, const FrustumCulling::Bounds& worldBounds, float pixelThreshold)
+{
+	const float objectRadius = mesh.GetBounds().sphere.w;
+	const float scale = objectRadius > 0.0f ? worldBounds.sphere.w / objectRadius : 1.0f;
+
+	//The errors increase with the level, so stop at the first level that is too coarse.
+	uint32_t level = 0;
+	for (uint32_t i = 1; i < mesh.GetLevelOfDetailCount(); i++)
+	{
+		if (ProjectError(view, worldBounds.sphere, mesh.GetLevelOfDetailError(i) * scale) > pixelThreshold)
+			break;
+		level = i;
+	}
+	return level;
+}
\ No newline at end of file
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "gear_core_common.h"
+#include "Graphics/FrustumCulling.h"
+
+namespace gear
+{
+namespace objects
+{
+	class Camera;
+	class Mesh;
+}
+namespace graphics
+{
+	class LevelOfDetail
+	{
+	public:
+		//Converts world space errors to pixels on the screen.
+		struct View
+		{
+			mars::Vec3	position;
+			float		pixelsPerUnit;	//At a distance of 1 for perspective projections, and at any distance for orthographic ones.
+			float		zNear;
+			bool		perspective;
+		};
+
+	public:
+		//viewportHeight is in pixels.
+		static View GetView(const objects::Camera& camera, float viewportHeight);
+
+		//Returns the size in pixels of a world space error on the closest point of the bounding sphere to the view.
+		//Views inside the sphere project the error as if it were at zNear.
+		static float ProjectError(const View& view, const mars::Vec4& worldSphere, float worldError);
+
+		//Returns the coarsest level of the mesh whose error projects to at most pixelThreshold pixels. The object space
+		//errors of the mesh are scaled by the ratio of the radii of the world and object space bounding spheres.
+		static uint32_t Select(const View& view, const objects::Mesh& mesh, const FrustumCulling::Bounds& worldBounds, float pixelThreshold);
+	};
+}
+}
\ No newline at end of file
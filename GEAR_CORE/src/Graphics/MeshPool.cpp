@@ -0,0 +1,480 @@
+#include "gear_core_common.h"
+#include "MeshPool.h"
+#include "Graphics/AllocatorManager.h"
+#include "Utils/ModelLoader.h"
+
+using namespace gear;
+using namespace graphics;
+
+using namespace miru;
+using namespace miru::crossplatform;
+
+std::map<std::pair<void*, size_t>, Ref<MeshPool>> MeshPool::s_MeshPools;
+
+//FreeList
+
+void MeshPool::FreeList::Reset(uint32_t capacity, uint32_t usedCount)
+{
+	m_FreeByOffset.clear();
+	m_FreeBySize.clear();
+	m_Capacity = capacity;
+	m_FreeCount = 0;
+	if (usedCount < capacity)
+		Insert(usedCount, capacity - usedCount);
+}
+
+bool MeshPool::FreeList::Allocate(uint32_t count, uint32_t& offset)
+{
+	offset = 0;
+	if (count == 0)
+		return true;
+
+	//Best-fit: The smallest free range that can hold the count.
+	auto sizeIt = m_FreeBySize.lower_bound(count);
+	if (sizeIt == m_FreeBySize.end())
+		return false;
+
+	offset = sizeIt->second;
+	const uint32_t size = sizeIt->first;
+	Erase(m_FreeByOffset.find(offset));
+	if (size > count)
+		Insert(offset + count, size - count);
+	return true;
+}
+
+void MeshPool::FreeList::Free(uint32_t offset, uint32_t count)
+{
+	if (count == 0)
+		return;
+
+	//Coalesce with the adjacent free ranges.
+	auto nextIt = m_FreeByOffset.find(offset + count);
+	if (nextIt != m_FreeByOffset.end())
+	{
+		count += nextIt->second;
+		Erase(nextIt);
+	}
+	auto prevIt = m_FreeByOffset.lower_bound(offset);
+	if (prevIt != m_FreeByOffset.begin())
+	{
+		prevIt--;
+		if (prevIt->first + prevIt->second == offset)
+		{
+			offset = prevIt->first;
+			count += prevIt->second;
+			Erase(prevIt);
+		}
+	}
+	Insert(offset, count);
+}
+
+void MeshPool::FreeList::Insert(uint32_t offset, uint32_t count)
+{
+	m_FreeByOffset[offset] = count;
+	m_FreeBySize.insert({ count, offset });
+	m_FreeCount += count;
+}
+
+void MeshPool::FreeList::Erase(std::map<uint32_t, uint32_t>::iterator it)
+{
+	auto range = m_FreeBySize.equal_range(it->second);
+	for (auto sizeIt = range.first; sizeIt != range.second; sizeIt++)
+	{
+		if (sizeIt->second == it->first)
+		{
+			m_FreeBySize.erase(sizeIt);
+			break;
+		}
+	}
+	m_FreeCount -= it->second;
+	m_FreeByOffset.erase(it);
+}
+
+//MeshPool
+
+MeshPool::MeshPool(CreateInfo* pCreateInfo)
+{
+	m_CI = *pCreateInfo;
+	m_CI.verticesPerBlock = std::max(m_CI.verticesPerBlock, uint32_t(1));
+	m_CI.indicesPerBlock = std::max(m_CI.indicesPerBlock, uint32_t(1));
+
+	if (m_CI.indexStride != 2 && m_CI.indexStride != 4)
+	{
+		GEAR_ASSERT(ErrorCode::GRAPHICS | ErrorCode::INVALID_VALUE, "Index stride is not 2 or 4: %s.", m_CI.debugName.c_str());
+	}
+}
+
+MeshPool::~MeshPool()
+{
+}
+
+const Ref<MeshPool>& MeshPool::GetMeshPool(void* device, size_t vertexStride)
+{
+	if (vertexStride == 0)
+		vertexStride = ModelLoader::GetSizeOfVertex();
+
+	Ref<MeshPool>& meshPool = s_MeshPools[{ device, vertexStride }];
+	if (!meshPool)
+	{
+		CreateInfo meshPoolCI;
+		meshPoolCI.debugName = "GEAR_CORE_MeshPool";
+		meshPoolCI.device = device;
+		meshPoolCI.vertexStride = vertexStride;
+		meshPoolCI.indexStride = ModelLoader::GetSizeOfIndex();
+		meshPoolCI.verticesPerBlock = 256 * 1024;
+		meshPoolCI.indicesPerBlock = 1024 * 1024;
+		meshPoolCI.frameLatency = 3;
+		meshPoolCI.compactionThreshold = 0.5f;
+		meshPool = CreateRef<MeshPool>(&meshPoolCI);
+	}
+	return meshPool;
+}
+
+std::vector<Ref<MeshPool>> MeshPool::GetMeshPools(void* device)
+{
+	std::vector<Ref<MeshPool>> meshPools;
+	for (auto& meshPool : s_MeshPools)
+	{
+		if (meshPool.first.first == device)
+			meshPools.push_back(meshPool.second);
+	}
+	return meshPools;
+}
+
+void MeshPool::ReleaseMeshPools(void* device)
+{
+	for (auto it = s_MeshPools.begin(); it != s_MeshPools.end();)
+	{
+		if (it->first.first == device)
+			it = s_MeshPools.erase(it);
+		else
+			it++;
+	}
+}
+
+Ref<MeshPool::Allocation> MeshPool::Allocate(const void* vertexData, uint32_t vertexCount, const void* indexData, uint32_t indexCount)
+{
+	Ref<Allocation> allocation = CreateRef<Allocation>();
+	allocation->blockIndex = UINT32_MAX;
+	allocation->vertexCount = vertexCount;
+	allocation->indexCount = indexCount;
+	allocation->uploaded = false;
+
+	for (uint32_t i = 0; i < static_cast<uint32_t>(m_Blocks.size()); i++)
+	{
+		Block& block = m_Blocks[i];
+		if (!block.vertices.Allocate(vertexCount, allocation->vertexOffset))
+			continue;
+		if (!block.indices.Allocate(indexCount, allocation->firstIndex))
+		{
+			block.vertices.Free(allocation->vertexOffset, vertexCount);
+			continue;
+		}
+		allocation->blockIndex = i;
+		break;
+	}
+	if (allocation->blockIndex == UINT32_MAX)
+	{
+		allocation->blockIndex = CreateBlock(std::max(vertexCount, m_CI.verticesPerBlock), std::max(indexCount, m_CI.indicesPerBlock));
+		Block& block = m_Blocks[allocation->blockIndex];
+		block.vertices.Allocate(vertexCount, allocation->vertexOffset);
+		block.indices.Allocate(indexCount, allocation->firstIndex);
+	}
+	m_Blocks[allocation->blockIndex].allocations.insert(allocation.get());
+
+	//The data is staged now, so the caller does not need to keep it alive until the upload.
+	const size_t vertexDataSize = vertexCount * m_CI.vertexStride;
+	const size_t indexDataSize = indexCount * m_CI.indexStride;
+	PendingUpload pendingUpload;
+	pendingUpload.allocation = allocation.get();
+	pendingUpload.vertexDataOffset = m_StagingData.size();
+	pendingUpload.indexDataOffset = pendingUpload.vertexDataOffset + vertexDataSize;
+	m_StagingData.resize(pendingUpload.indexDataOffset + indexDataSize);
+	if (vertexDataSize)
+		memcpy(m_StagingData.data() + pendingUpload.vertexDataOffset, vertexData, vertexDataSize);
+	if (indexDataSize)
+		memcpy(m_StagingData.data() + pendingUpload.indexDataOffset, indexData, indexDataSize);
+	m_PendingUploads.push_back(pendingUpload);
+
+	return allocation;
+}
+
+void* MeshPool::UpdateVertices(const Ref<Allocation>& allocation)
+{
+	if (!allocation || allocation->blockIndex >= m_Blocks.size() || allocation->vertexCount == 0)
+		return nullptr;
+
+	for (const PendingUpload& pendingUpload : m_PendingUploads)
+	{
+		if (pendingUpload.allocation == allocation.get())
+			return m_StagingData.data() + pendingUpload.vertexDataOffset;
+	}
+
+	//The uploaded range may still be read by the frames in flight, so the vertices are moved to a new range in the block,
+	//and the old range is freed like that of a freed allocation. A full block is compacted into new buffers instead.
+	if (allocation->uploaded)
+	{
+		Block& block = m_Blocks[allocation->blockIndex];
+		uint32_t vertexOffset = 0;
+		if (block.vertices.Allocate(allocation->vertexCount, vertexOffset))
+		{
+			m_FreedRanges.push_back({ allocation->blockIndex, allocation->vertexOffset, allocation->vertexCount, 0, 0, m_FrameCount });
+			allocation->vertexOffset = vertexOffset;
+		}
+		else
+		{
+			block.compact = true;
+		}
+	}
+
+	PendingUpload pendingUpload;
+	pendingUpload.allocation = allocation.get();
+	pendingUpload.vertexDataOffset = m_StagingData.size();
+	pendingUpload.indexDataOffset = SIZE_MAX;
+	m_StagingData.resize(pendingUpload.vertexDataOffset + allocation->vertexCount * m_CI.vertexStride);
+	m_PendingUploads.push_back(pendingUpload);
+	return m_StagingData.data() + pendingUpload.vertexDataOffset;
+}
+
+void MeshPool::Free(const Ref<Allocation>& allocation)
+{
+	if (!allocation || allocation->blockIndex >= m_Blocks.size())
+		return;
+
+	Block& block = m_Blocks[allocation->blockIndex];
+	if (block.allocations.erase(allocation.get()) == 0)
+	{
+		GEAR_ASSERT(ErrorCode::GRAPHICS | ErrorCode::INVALID_VALUE, "Allocation was not allocated from MeshPool: %s.", m_CI.debugName.c_str());
+		return;
+	}
+
+	m_PendingUploads.erase(std::remove_if(m_PendingUploads.begin(), m_PendingUploads.end(),
+		[&allocation](const PendingUpload& pendingUpload) { return pendingUpload.allocation == allocation.get(); }), m_PendingUploads.end());
+
+	m_FreedRanges.push_back({ allocation->blockIndex, allocation->vertexOffset, allocation->vertexCount, allocation->firstIndex, allocation->indexCount, m_FrameCount });
+	allocation->blockIndex = UINT32_MAX;
+}
+
+void MeshPool::Compact()
+{
+	for (auto& block : m_Blocks)
+		block.compact = true;
+}
+
+void MeshPool::NextFrame()
+{
+	m_FrameCount++;
+	while (!m_FreedRanges.empty() && m_FrameCount - m_FreedRanges.front().freeFrame >= m_CI.frameLatency)
+	{
+		const FreedRange& freedRange = m_FreedRanges.front();
+		Block& block = m_Blocks[freedRange.blockIndex];
+		block.vertices.Free(freedRange.vertexOffset, freedRange.vertexCount);
+		block.indices.Free(freedRange.firstIndex, freedRange.indexCount);
+
+		//Compact when the free space is split into ranges too small to be reused.
+		auto Fragmented = [this](const FreeList& freeList) -> bool
+		{
+			return freeList.GetFreeCount() > 0 && static_cast<float>(freeList.GetLargestFreeRange()) < m_CI.compactionThreshold * static_cast<float>(freeList.GetFreeCount());
+		};
+		block.compact |= Fragmented(block.vertices) || Fragmented(block.indices);
+
+		m_FreedRanges.pop_front();
+	}
+	while (!m_RetiredBuffers.empty() && m_FrameCount - m_RetiredBuffers.front().retireFrame >= m_CI.frameLatency)
+	{
+		m_RetiredBuffers.pop_front();
+	}
+}
+
+void MeshPool::Upload(BufferCopyBatch& copyBatch)
+{
+	for (uint32_t i = 0; i < static_cast<uint32_t>(m_Blocks.size()); i++)
+	{
+		if (m_Blocks[i].compact)
+			CompactBlock(copyBatch, i);
+	}
+
+	m_UploadedSize = 0;
+	m_UploadTime = 0.0;
+	if (m_PendingUploads.empty())
+	{
+		m_StagingData.clear();
+		return;
+	}
+
+	//One upload buffer per frame of latency. Buffers dropped by a lower latency may still be read by the GPU.
+	const size_t uploadBufferCount = std::max(m_CI.frameLatency, uint32_t(1));
+	for (size_t i = uploadBufferCount; i < m_UploadBuffers.size(); i++)
+	{
+		if (m_UploadBuffers[i].buffer)
+			m_RetiredBuffers.push_back({ { m_UploadBuffers[i].buffer }, {}, m_FrameCount });
+	}
+	m_UploadBuffers.resize(uploadBufferCount);
+
+	const auto start = std::chrono::high_resolution_clock::now();
+	Ref<Buffer> upload;
+	UploadBuffer& uploadBuffer = m_UploadBuffers[m_FrameCount % uploadBufferCount];
+	if (uploadBuffer.buffer && m_FrameCount - uploadBuffer.uploadFrame < m_CI.frameLatency)
+	{
+		Buffer::CreateInfo uploadCI;
+		upload = CreateBuffer(uploadCI, m_CI.debugName + "_Upload", Buffer::UsageBit::TRANSFER_SRC_BIT, m_StagingData.size(), m_StagingData.data(), true);
+		m_RetiredBuffers.push_back({ { upload }, {}, m_FrameCount });
+		m_UploadBufferCount++;
+	}
+	else
+	{
+		//The buffer is grown geometrically, so that staging data that grows slowly does not recreate it every time.
+		if (!uploadBuffer.buffer || uploadBuffer.bufferCI.size < m_StagingData.size())
+		{
+			const size_t size = std::max(m_StagingData.size(), uploadBuffer.buffer ? 2 * uploadBuffer.bufferCI.size : size_t(0));
+			const std::string debugName = m_CI.debugName + "_Upload_" + std::to_string(m_FrameCount % uploadBufferCount);
+			uploadBuffer.buffer = CreateBuffer(uploadBuffer.bufferCI, debugName, Buffer::UsageBit::TRANSFER_SRC_BIT, size, nullptr, true);
+			m_UploadBufferCount++;
+		}
+		uploadBuffer.bufferCI.pAllocator->SubmitData(uploadBuffer.buffer->GetAllocation(), m_StagingData.size(), m_StagingData.data());
+		uploadBuffer.uploadFrame = m_FrameCount;
+		upload = uploadBuffer.buffer;
+	}
+	m_UploadedSize = m_StagingData.size();
+	m_UploadTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	for (auto& pendingUpload : m_PendingUploads)
+	{
+		Allocation* allocation = pendingUpload.allocation;
+		const Block& block = m_Blocks[allocation->blockIndex];
+		if (allocation->vertexCount)
+			copyBatch.Add(upload, block.vertexBuffer, { pendingUpload.vertexDataOffset, allocation->vertexOffset * m_CI.vertexStride, allocation->vertexCount * m_CI.vertexStride });
+		if (allocation->indexCount && pendingUpload.indexDataOffset != SIZE_MAX)
+			copyBatch.Add(upload, block.indexBuffer, { pendingUpload.indexDataOffset, allocation->firstIndex * m_CI.indexStride, allocation->indexCount * m_CI.indexStride });
+		allocation->uploaded = true;
+	}
+	m_PendingUploads.clear();
+	m_StagingData.clear();
+}
+
+MeshPool::Statistics MeshPool::GetStatistics() const
+{
+	Statistics statistics = {};
+	statistics.blocks = static_cast<uint32_t>(m_Blocks.size());
+	statistics.compactions = m_Compactions;
+	statistics.uploadedSize = m_UploadedSize;
+	statistics.uploadTime = m_UploadTime;
+	statistics.uploadBuffers = m_UploadBufferCount;
+	for (auto& block : m_Blocks)
+	{
+		statistics.allocations += static_cast<uint32_t>(block.allocations.size());
+		statistics.usedVertices += block.vertices.GetCapacity() - block.vertices.GetFreeCount();
+		statistics.usedIndices += block.indices.GetCapacity() - block.indices.GetFreeCount();
+		statistics.freeVertices += block.vertices.GetFreeCount();
+		statistics.freeIndices += block.indices.GetFreeCount();
+	}
+	return statistics;
+}
+
+uint32_t MeshPool::CreateBlock(uint32_t vertexCount, uint32_t indexCount)
+{
+	const uint32_t blockIndex = static_cast<uint32_t>(m_Blocks.size());
+	const std::string blockName = m_CI.debugName + "_Block_" + std::to_string(blockIndex);
+
+	m_Blocks.push_back({});
+	Block& block = m_Blocks.back();
+	block.vertexBuffer = CreateBuffer(block.vertexBufferCI, blockName + "_VertexBuffer", Buffer::UsageBit::TRANSFER_SRC_BIT | Buffer::UsageBit::TRANSFER_DST_BIT | Buffer::UsageBit::VERTEX_BIT, vertexCount * m_CI.vertexStride, nullptr, false);
+	block.vertexBufferViewCI.debugName = blockName + "_VertexBufferView";
+	block.vertexBufferViewCI.device = m_CI.device;
+	block.vertexBufferViewCI.type = BufferView::Type::VERTEX;
+	block.vertexBufferViewCI.pBuffer = block.vertexBuffer;
+	block.vertexBufferViewCI.offset = 0;
+	block.vertexBufferViewCI.size = block.vertexBufferCI.size;
+	block.vertexBufferViewCI.stride = m_CI.vertexStride;
+	block.vertexBufferView = BufferView::Create(&block.vertexBufferViewCI);
+
+	block.indexBuffer = CreateBuffer(block.indexBufferCI, blockName + "_IndexBuffer", Buffer::UsageBit::TRANSFER_SRC_BIT | Buffer::UsageBit::TRANSFER_DST_BIT | Buffer::UsageBit::INDEX_BIT, indexCount * m_CI.indexStride, nullptr, false);
+	block.indexBufferViewCI.debugName = blockName + "_IndexBufferView";
+	block.indexBufferViewCI.device = m_CI.device;
+	block.indexBufferViewCI.type = BufferView::Type::INDEX;
+	block.indexBufferViewCI.pBuffer = block.indexBuffer;
+	block.indexBufferViewCI.offset = 0;
+	block.indexBufferViewCI.size = block.indexBufferCI.size;
+	block.indexBufferViewCI.stride = m_CI.indexStride;
+	block.indexBufferView = BufferView::Create(&block.indexBufferViewCI);
+
+	block.vertices.Reset(vertexCount, 0);
+	block.indices.Reset(indexCount, 0);
+	block.compact = false;
+	return blockIndex;
+}
+
+bool MeshPool::NeedsCompaction() const
+{
+	for (auto& block : m_Blocks)
+	{
+		if (block.compact)
+			return true;
+	}
+	return false;
+}
+
+void MeshPool::CompactBlock(BufferCopyBatch& copyBatch, uint32_t blockIndex)
+{
+	//Ranges can not be moved within a buffer, as the source and destination of a copy may not overlap.
+	//The live ranges are packed into new buffers, and the old ones are retired until the GPU has finished with them.
+	Block& block = m_Blocks[blockIndex];
+	m_RetiredBuffers.push_back({ { block.vertexBuffer, block.indexBuffer }, { block.vertexBufferView, block.indexBufferView }, m_FrameCount });
+
+	block.vertexBuffer = Buffer::Create(&block.vertexBufferCI);
+	block.vertexBufferViewCI.pBuffer = block.vertexBuffer;
+	block.vertexBufferView = BufferView::Create(&block.vertexBufferViewCI);
+	block.indexBuffer = Buffer::Create(&block.indexBufferCI);
+	block.indexBufferViewCI.pBuffer = block.indexBuffer;
+	block.indexBufferView = BufferView::Create(&block.indexBufferViewCI);
+
+	std::vector<Allocation*> allocations(block.allocations.begin(), block.allocations.end());
+	std::sort(allocations.begin(), allocations.end(), [](const Allocation* a, const Allocation* b) { return a->vertexOffset < b->vertexOffset; });
+
+	//Vertices that are pending again are not copied, as they are overwritten by the upload.
+	std::set<const Allocation*> pendingAllocations;
+	for (const PendingUpload& pendingUpload : m_PendingUploads)
+		pendingAllocations.insert(pendingUpload.allocation);
+
+	std::vector<Buffer::Copy> vertexCopies;
+	std::vector<Buffer::Copy> indexCopies;
+	uint32_t vertexOffset = 0;
+	uint32_t firstIndex = 0;
+	for (Allocation* allocation : allocations)
+	{
+		//Ranges that are still pending are uploaded to their new offsets.
+		if (allocation->uploaded && allocation->vertexCount && pendingAllocations.find(allocation) == pendingAllocations.end())
+			vertexCopies.push_back({ allocation->vertexOffset * m_CI.vertexStride, vertexOffset * m_CI.vertexStride, allocation->vertexCount * m_CI.vertexStride });
+		if (allocation->uploaded && allocation->indexCount)
+			indexCopies.push_back({ allocation->firstIndex * m_CI.indexStride, firstIndex * m_CI.indexStride, allocation->indexCount * m_CI.indexStride });
+
+		allocation->vertexOffset = vertexOffset;
+		allocation->firstIndex = firstIndex;
+		vertexOffset += allocation->vertexCount;
+		firstIndex += allocation->indexCount;
+	}
+
+	const RetiredBuffers& oldBuffers = m_RetiredBuffers.back();
+	copyBatch.Add(oldBuffers.buffers[0], block.vertexBuffer, vertexCopies);
+	copyBatch.Add(oldBuffers.buffers[1], block.indexBuffer, indexCopies);
+
+	//Ranges freed in this block, but not yet released, were in the old buffers.
+	m_FreedRanges.erase(std::remove_if(m_FreedRanges.begin(), m_FreedRanges.end(),
+		[blockIndex](const FreedRange& freedRange) { return freedRange.blockIndex == blockIndex; }), m_FreedRanges.end());
+
+	block.vertices.Reset(block.vertices.GetCapacity(), vertexOffset);
+	block.indices.Reset(block.indices.GetCapacity(), firstIndex);
+	block.compact = false;
+	m_Compactions++;
+}
+
+Ref<Buffer> MeshPool::CreateBuffer(Buffer::CreateInfo& bufferCI, const std::string& debugName, Buffer::UsageBit usage, size_t size, const void* data, bool upload)
+{
+	bufferCI.debugName = debugName;
+	bufferCI.device = m_CI.device;
+	bufferCI.usage = usage;
+	bufferCI.size = size;
+	bufferCI.data = const_cast<void*>(data);
+	bufferCI.pAllocator = AllocatorManager::GetAllocator(upload ? AllocatorManager::AllocatorType::CPU : AllocatorManager::AllocatorType::GPU);
+	return Buffer::Create(&bufferCI);
+}
\ No newline at end of file
@@ -0,0 +1,189 @@
+#pragma once
+
+#include "gear_core_common.h"
+#include "Graphics/BufferCopyBatch.h"
+
+namespace gear
+{
+namespace graphics
+{
+	//Sub-allocates the vertices and indices of meshes from a few large device local buffers. Each block holds one
+	//vertex buffer and one index buffer, and ranges within them are managed by a best-fit free list with coalescing.
+	//Sub-meshes in the same block share their buffers, so they can be drawn with a single bind or one indirect draw.
+	class MeshPool
+	{
+	public:
+		struct CreateInfo
+		{
+			std::string	debugName;
+			void*		device;
+			size_t		vertexStride;
+			size_t		indexStride;
+			uint32_t	verticesPerBlock;		//Larger ranges get a block of their own.
+			uint32_t	indicesPerBlock;
+			uint32_t	frameLatency;			//Number of frames a freed range is held before it is reused.
+			float		compactionThreshold;	//A block is compacted when its largest free range is less than this fraction of its free space.
+		};
+
+		//A range of vertices and indices in a block. The indices are relative to vertexOffset.
+		//The offsets are updated when the block is compacted, so they should be read when recording.
+		struct Allocation
+		{
+			uint32_t	blockIndex;
+			uint32_t	vertexOffset;
+			uint32_t	vertexCount;
+			uint32_t	firstIndex;
+			uint32_t	indexCount;
+			bool		uploaded;
+		};
+
+		struct Statistics
+		{
+			uint32_t	blocks;
+			uint32_t	allocations;
+			uint64_t	usedVertices;
+			uint64_t	usedIndices;
+			uint64_t	freeVertices;
+			uint64_t	freeIndices;
+			uint32_t	compactions;
+			uint64_t	uploadedSize;		//In the last call to Upload().
+			double		uploadTime;			//In milliseconds, writing the staging data to the upload buffer in the last call to Upload().
+			uint32_t	uploadBuffers;		//Created since the pool was created.
+		};
+
+	private:
+		//Ranges in elements. Free ranges are indexed by offset for coalescing and by size for best-fit.
+		class FreeList
+		{
+		private:
+			std::map<uint32_t, uint32_t> m_FreeByOffset;
+			std::multimap<uint32_t, uint32_t> m_FreeBySize;
+			uint32_t m_Capacity = 0;
+			uint32_t m_FreeCount = 0;
+
+		public:
+			void Reset(uint32_t capacity, uint32_t usedCount);
+			bool Allocate(uint32_t count, uint32_t& offset);
+			void Free(uint32_t offset, uint32_t count);
+
+			inline uint32_t GetCapacity() const { return m_Capacity; }
+			inline uint32_t GetFreeCount() const { return m_FreeCount; }
+			inline uint32_t GetLargestFreeRange() const { return m_FreeBySize.empty() ? 0 : m_FreeBySize.rbegin()->first; }
+
+		private:
+			void Insert(uint32_t offset, uint32_t count);
+			void Erase(std::map<uint32_t, uint32_t>::iterator it);
+		};
+
+		struct Block
+		{
+			Ref<miru::crossplatform::Buffer>			vertexBuffer;
+			miru::crossplatform::Buffer::CreateInfo		vertexBufferCI;
+			Ref<miru::crossplatform::BufferView>		vertexBufferView;
+			miru::crossplatform::BufferView::CreateInfo	vertexBufferViewCI;
+			Ref<miru::crossplatform::Buffer>			indexBuffer;
+			miru::crossplatform::Buffer::CreateInfo		indexBufferCI;
+			Ref<miru::crossplatform::BufferView>		indexBufferView;
+			miru::crossplatform::BufferView::CreateInfo	indexBufferViewCI;
+
+			FreeList									vertices;
+			FreeList									indices;
+			std::set<Allocation*>						allocations;
+			bool										compact;
+		};
+		struct PendingUpload
+		{
+			Allocation*	allocation;
+			size_t		vertexDataOffset;	//Into the staging data.
+			size_t		indexDataOffset;	//SIZE_MAX if only the vertices are uploaded.
+		};
+		struct FreedRange
+		{
+			uint32_t	blockIndex;
+			uint32_t	vertexOffset;
+			uint32_t	vertexCount;
+			uint32_t	firstIndex;
+			uint32_t	indexCount;
+			uint64_t	freeFrame;
+		};
+		//Host visible buffers that the staging data is written to, reused every frameLatency frames.
+		struct UploadBuffer
+		{
+			Ref<miru::crossplatform::Buffer>		buffer;
+			miru::crossplatform::Buffer::CreateInfo	bufferCI;
+			uint64_t								uploadFrame;
+		};
+		struct RetiredBuffers
+		{
+			std::vector<Ref<miru::crossplatform::Buffer>>		buffers;
+			std::vector<Ref<miru::crossplatform::BufferView>>	bufferViews;
+			uint64_t											retireFrame;
+		};
+
+		CreateInfo m_CI;
+
+		std::vector<Block> m_Blocks;
+		std::vector<PendingUpload> m_PendingUploads;
+		std::vector<uint8_t> m_StagingData;	//The data of the pending uploads, written to the frame's upload buffer by Upload().
+		std::vector<UploadBuffer> m_UploadBuffers;
+		std::deque<FreedRange> m_FreedRanges;
+		std::deque<RetiredBuffers> m_RetiredBuffers;
+
+		uint64_t m_FrameCount = 0;
+		uint32_t m_Compactions = 0;
+		uint64_t m_UploadedSize = 0;
+		double m_UploadTime = 0.0;
+		uint32_t m_UploadBufferCount = 0;
+
+		static std::map<std::pair<void*, size_t>, Ref<MeshPool>> s_MeshPools;
+
+	public:
+		MeshPool(CreateInfo* pCreateInfo);
+		~MeshPool();
+
+		const CreateInfo& GetCreateInfo() { return m_CI; }
+		inline void SetFrameLatency(uint32_t frameLatency) { m_CI.frameLatency = frameLatency; }
+
+		//Returns the shared pool of the device for vertices of the stride, which is created on first use.
+		//A vertexStride of 0 selects ModelLoader::Vertex.
+		static const Ref<MeshPool>& GetMeshPool(void* device, size_t vertexStride = 0);
+		//Returns the shared pools of the device for every vertex stride.
+		static std::vector<Ref<MeshPool>> GetMeshPools(void* device);
+		//Releases the shared pools of the device, which must be idle. Call before the device is destroyed.
+		static void ReleaseMeshPools(void* device);
+
+		//The data is copied and uploaded on the next call to Upload().
+		Ref<Allocation> Allocate(const void* vertexData, uint32_t vertexCount, const void* indexData, uint32_t indexCount);
+		//Returns the staging memory of the vertices of the allocation, so that they can be written in place. On the next call to
+		//Upload(), they are copied to the upload buffer along with the rest of the staging data. Uploaded vertices are moved to a
+		//new range, as the frames in flight may still read the old one, so the allocation's vertexOffset changes. The indices are
+		//left untouched. The memory is not initialised, unless the allocation is already pending, and is valid until the next call
+		//to Allocate(), UpdateVertices() or Upload().
+		void* UpdateVertices(const Ref<Allocation>& allocation);
+		//The range is reused once it can no longer be in use by the GPU.
+		void Free(const Ref<Allocation>& allocation);
+		//Packs the live ranges of every block on the next call to Upload().
+		void Compact();
+
+		//Call once per frame. Ranges freed and buffers retired frameLatency frames ago are released.
+		void NextFrame();
+		//Adds the compaction of fragmented blocks and the copies of newly allocated ranges to the batch.
+		//The staging data of all pending ranges is written to the frame's upload buffer, so each block receives one copy
+		//per buffer. The upload buffers are kept and reused in turn, and only recreated when the staging data outgrows them.
+		//A second call within a frame uses a temporary upload buffer, as the frame's buffer may still be read by the GPU.
+		void Upload(BufferCopyBatch& copyBatch);
+		inline bool HasPendingUploads() const { return !m_PendingUploads.empty() || NeedsCompaction(); }
+
+		inline const Ref<miru::crossplatform::BufferView>& GetVertexBufferView(uint32_t blockIndex) const { return m_Blocks[blockIndex].vertexBufferView; }
+		inline const Ref<miru::crossplatform::BufferView>& GetIndexBufferView(uint32_t blockIndex) const { return m_Blocks[blockIndex].indexBufferView; }
+		inline uint32_t GetBlockCount() const { return static_cast<uint32_t>(m_Blocks.size()); }
+		Statistics GetStatistics() const;
+
+	private:
+		uint32_t CreateBlock(uint32_t vertexCount, uint32_t indexCount);
+		bool NeedsCompaction() const;
+		void CompactBlock(BufferCopyBatch& copyBatch, uint32_t blockIndex);
+		Ref<miru::crossplatform::Buffer> CreateBuffer(miru::crossplatform::Buffer::CreateInfo& bufferCI, const std::string& debugName, miru::crossplatform::Buffer::UsageBit usage, size_t size, const void* data, bool upload);
+	};
+}
+}
\ No newline at end of file
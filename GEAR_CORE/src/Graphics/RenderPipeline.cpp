@@ -118,6 +118,20 @@ RenderPipeline::RenderPipeline(LoadInfo* pLoadInfo)
 		rpCI.shaderCreateInfo.push_back(shaderCI);
 	}
 
+	//PushConstantRanges
+	for (auto& pushConstantRange : pipeline_grpf_json["pushConstantRanges"])
+	{
+		Shader::StageBit stages = Shader::StageBit(0);
+		for (auto& stage : pushConstantRange["stages"])
+			stages |= ShaderStageBitStrings[stage];
+
+		rpCI.pushConstantRanges.push_back({
+			stages,
+			pushConstantRange["offset"],
+			pushConstantRange["size"]
+			});
+	}
+
 	//Compute Pipelines are completed here.
 	if (rpCI.shaderCreateInfo.size() == 1 && rpCI.shaderCreateInfo.back().stage == Shader::StageBit::COMPUTE_BIT)
 	{
@@ -298,7 +312,7 @@ void RenderPipeline::FinalisePipline()
 		m_PipelineCI.colourBlendState = m_CI.colourBlendState;
 		m_PipelineCI.dynamicStates = {};
 		m_PipelineCI.layout.descriptorSetLayouts = m_DescSetLayouts;
-		m_PipelineCI.layout.pushConstantRanges = {};
+		m_PipelineCI.layout.pushConstantRanges = m_CI.pushConstantRanges;
 		m_PipelineCI.renderPass = m_CI.renderPass;
 		m_PipelineCI.subpassIndex = m_CI.subpassIndex;
 		m_Pipeline = crossplatform::Pipeline::Create(&m_PipelineCI);
@@ -334,7 +348,7 @@ void RenderPipeline::FinalisePipline()
 		m_PipelineCI.type = PipelineType::COMPUTE;
 		m_PipelineCI.shaders = m_Shaders;
 		m_PipelineCI.layout.descriptorSetLayouts = m_DescSetLayouts;
-		m_PipelineCI.layout.pushConstantRanges = {};
+		m_PipelineCI.layout.pushConstantRanges = m_CI.pushConstantRanges;
 		m_Pipeline = crossplatform::Pipeline::Create(&m_PipelineCI);
 	}
 }
@@ -26,6 +26,7 @@ namespace graphics
 			miru::crossplatform::Pipeline::MultisampleState			multisampleState;
 			miru::crossplatform::Pipeline::DepthStencilState		depthStencilState;
 			miru::crossplatform::Pipeline::ColourBlendState			colourBlendState;
+			std::vector<miru::crossplatform::Pipeline::PushConstantRange>	pushConstantRanges;
 			Ref<miru::crossplatform::RenderPass>				renderPass;
 			uint32_t												subpassIndex;
 		};
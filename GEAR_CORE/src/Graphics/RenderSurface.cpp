@@ -13,6 +13,7 @@ using namespace miru::crossplatform;
 RenderSurface::RenderSurface(CreateInfo* pCreateInfo)
 {
 	m_CI = *pCreateInfo;
+	m_CI.framesInFlight = std::max(m_CI.framesInFlight, uint32_t(2));
 
 	m_CurrentWidth = m_CI.width;
 	m_CurrentHeight = m_CI.height;
@@ -43,7 +44,7 @@ RenderSurface::RenderSurface(CreateInfo* pCreateInfo)
 	m_SwapchainCI.pWindow = m_CI.window;
 	m_SwapchainCI.width = m_CurrentWidth;
 	m_SwapchainCI.height = m_CurrentHeight;
-	m_SwapchainCI.swapchainCount = 2;
+	m_SwapchainCI.swapchainCount = m_CI.framesInFlight;
 	m_SwapchainCI.vSync = m_CI.vSync;
 	m_SwapchainCI.bpcColourSpace = m_CI.bpcColourSpace;
 	m_Swapchain = Swapchain::Create(&m_SwapchainCI);
@@ -250,7 +251,8 @@ std::string RenderSurface::GetDeviceName() const
 
 void RenderSurface::CreateFramebuffer()
 {
-	for (size_t i = 0; i < _countof(m_Framebuffers); i++)
+	m_Framebuffers.resize(m_CI.framesInFlight);
+	for (size_t i = 0; i < m_Framebuffers.size(); i++)
 	{
 		m_FramebufferCI.debugName = "GEAR_CORE_Framebuffer_Default";
 		m_FramebufferCI.device = m_Context->GetDevice();
@@ -20,6 +20,7 @@ namespace graphics
 			miru::crossplatform::Swapchain::BPC_ColourSpace bpcColourSpace;
 			miru::crossplatform::Image::SampleCountBit		samples;
 			miru::debug::GraphicsDebugger::DebuggerType		graphicsDebugger;
+			uint32_t										framesInFlight;		//Number of swapchain images. The Renderer must be created with the same count.
 		};
 
 	private:
@@ -45,7 +46,7 @@ namespace graphics
 		//RenderPass and Framebuffer
 		Ref<miru::crossplatform::RenderPass> m_RenderPass;
 		miru::crossplatform::RenderPass::CreateInfo m_RenderPassCI;
-		Ref<miru::crossplatform::Framebuffer> m_Framebuffers[2];
+		std::vector<Ref<miru::crossplatform::Framebuffer>> m_Framebuffers;
 		miru::crossplatform::Framebuffer::CreateInfo m_FramebufferCI;
 
 		CreateInfo m_CI;
@@ -65,7 +66,8 @@ namespace graphics
 		inline const Ref<miru::crossplatform::RenderPass>& GetRenderPass() const { return m_RenderPass; }
 		inline const Ref<miru::crossplatform::ImageView>& GetSwapchainImageView(size_t index) const { return m_Swapchain->m_SwapchainImageViews[index]; }
 		inline const Ref<miru::crossplatform::ImageView>& GetSwapchainDepthImageView() const { return m_DepthImageView; }
-		inline const Ref<miru::crossplatform::Framebuffer>* GetFramebuffers() { return m_Framebuffers; }
+		inline const Ref<miru::crossplatform::Framebuffer>* GetFramebuffers() { return m_Framebuffers.data(); }
+		inline uint32_t GetFramesInFlight() const { return m_CI.framesInFlight; }
 
 		inline const miru::crossplatform::GraphicsAPI::API& GetGraphicsAPI() const { return m_CI.api; }
 		inline bool IsD3D12() const { return miru::crossplatform::GraphicsAPI::IsD3D12(); }
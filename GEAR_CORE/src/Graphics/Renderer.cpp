@@ -2,7 +2,6 @@
 #include "Renderer.h"
 #include "ARC/src/StringConversion.h"
 #include "ImageProcessing.h"
-#include "FrameGraph.h"
 
 using namespace gear;
 using namespace graphics;
@@ -11,8 +10,26 @@ using namespace objects;
 using namespace miru;
 using namespace miru::crossplatform;
 
-Renderer::Renderer(const Ref<Context>& context)
+template<typename K, typename V>
+static const V& FindOrNull(const std::map<K, V>& map, const typename std::map<K, V>::key_type& key)
 {
+	static const V null = V();
+	auto it = map.find(key);
+	return it != map.end() ? it->second : null;
+}
+
+template<typename K>
+static const Ref<DescriptorSet>& FindOrNull(const std::map<K, std::vector<Ref<DescriptorSet>>>& map, const typename std::map<K, std::vector<Ref<DescriptorSet>>>::key_type& key, uint32_t frameIndex)
+{
+	static const Ref<DescriptorSet> null = nullptr;
+	auto it = map.find(key);
+	return it != map.end() && frameIndex < it->second.size() ? it->second[frameIndex] : null;
+}
+
+Renderer::Renderer(const Ref<Context>& context, uint32_t framesInFlight)
+{
+	m_FramesInFlight = std::max(framesInFlight, uint32_t(1));
+
 	//Renderer and Transfer CmdPools and CmdBuffers
 	m_CmdPoolCI.debugName = "GEAR_CORE_CommandPool_Renderer";
 	m_CmdPoolCI.pContext = context;
@@ -23,7 +40,7 @@ Renderer::Renderer(const Ref<Context>& context)
 	m_CmdBufferCI.debugName = "GEAR_CORE_CommandBuffer_Renderer";
 	m_CmdBufferCI.pCommandPool = m_CmdPool;
 	m_CmdBufferCI.level = CommandBuffer::Level::PRIMARY;
-	m_CmdBufferCI.commandBufferCount = 4;
+	m_CmdBufferCI.commandBufferCount = 4 * m_FramesInFlight; //Per frame: One draw and three upload CommandBuffers.
 	m_CmdBufferCI.allocateNewCommandPoolPerBuffer = GraphicsAPI::IsD3D12();
 	m_CmdBuffer = CommandBuffer::Create(&m_CmdBufferCI);
 
@@ -36,7 +53,7 @@ Renderer::Renderer(const Ref<Context>& context)
 	m_TransCmdBufferCI.debugName = "GEAR_CORE_CommandBuffer_Renderer_Transfer";
 	m_TransCmdBufferCI.pCommandPool = m_TransCmdPool;
 	m_TransCmdBufferCI.level = CommandBuffer::Level::PRIMARY;
-	m_TransCmdBufferCI.commandBufferCount = 1;
+	m_TransCmdBufferCI.commandBufferCount = m_FramesInFlight;
 	m_TransCmdBufferCI.allocateNewCommandPoolPerBuffer = GraphicsAPI::IsD3D12();
 	m_TransCmdBuffer = CommandBuffer::Create(&m_TransCmdBufferCI);
 
@@ -48,21 +65,75 @@ Renderer::Renderer(const Ref<Context>& context)
 	m_DrawFenceCI.device = m_Device;
 	m_DrawFenceCI.signaled = true;
 	m_DrawFenceCI.timeout = UINT64_MAX;
-	m_DrawFences = { Fence::Create(&m_DrawFenceCI), Fence::Create(&m_DrawFenceCI) };
 
 	m_AcquireSemaphoreCI.debugName = "GEAR_CORE_Seamphore_Renderer_Acquire";
 	m_AcquireSemaphoreCI.device = m_Device;
-	m_AcquireSemaphores = { Semaphore::Create(&m_AcquireSemaphoreCI), Semaphore::Create(&m_AcquireSemaphoreCI) };
 
 	m_SubmitSemaphoreCI.debugName = "GEAR_CORE_Seamphore_Renderer_Submit";
 	m_SubmitSemaphoreCI.device = m_Device;
-	m_SubmitSemaphores = { Semaphore::Create(&m_SubmitSemaphoreCI), Semaphore::Create(&m_SubmitSemaphoreCI) };
 
+	for (uint32_t i = 0; i < m_FramesInFlight; i++)
+	{
+		m_DrawFences.push_back(Fence::Create(&m_DrawFenceCI));
+		m_AcquireSemaphores.push_back(Semaphore::Create(&m_AcquireSemaphoreCI));
+		m_SubmitSemaphores.push_back(Semaphore::Create(&m_SubmitSemaphoreCI));
+	}
+
+	//Upload FrameGraphs: The graphics CommandBuffers after the draw CommandBuffers are split between the frames.
+	//Each graph joins on the graphics queue and ends with a full memory barrier, so the frame's draw is ordered after its uploads by the GPU.
+	m_UploadFrameGraphCIs.resize(m_FramesInFlight);
+	for (uint32_t i = 0; i < m_FramesInFlight; i++)
+	{
+		const uint32_t uploadCmdBufferIndex = m_FramesInFlight + 3 * i;
+		FrameGraph::CreateInfo& uploadFrameGraphCI = m_UploadFrameGraphCIs[i];
+		uploadFrameGraphCI.debugName = "GEAR_CORE_FrameGraph_Renderer_Upload_" + std::to_string(i);
+		uploadFrameGraphCI.cmdBuffers[CommandPool::QueueType::GRAPHICS] = { m_CmdBuffer, { uploadCmdBufferIndex, uploadCmdBufferIndex + 1, uploadCmdBufferIndex + 2 } };
+		uploadFrameGraphCI.cmdBuffers[CommandPool::QueueType::TRANSFER] = { m_TransCmdBuffer, { i } };
+		uploadFrameGraphCI.queueOwnershipTransfers = GraphicsAPI::IsVulkan();
+		uploadFrameGraphCI.join = true;
+		m_UploadFrameGraphs.push_back(CreateRef<FrameGraph>(&uploadFrameGraphCI));
+	}
+
+	//Descriptor Allocator
+	m_DescAllocatorCI.debugName = "GEAR_CORE_DescriptorAllocator_Renderer";
+	m_DescAllocatorCI.device = m_Device;
+	m_DescAllocatorCI.initialSetsPerPool = 64;
+	m_DescAllocatorCI.frameLatency = static_cast<uint32_t>(m_DrawFences.size());
+	m_DescAllocator = CreateRef<DescriptorAllocator>(&m_DescAllocatorCI);
+
+	//Texture Streamer
+	m_TextureStreamerCI.debugName = "GEAR_CORE_TextureStreamer_Renderer";
+	m_TextureStreamerCI.budgetPerFrame = 64 * 1024 * 1024;
+	m_TextureStreamerCI.timeBudgetPerFrame = 4.0;
+	m_TextureStreamerCI.framesInFlight = m_FramesInFlight;
+	m_TextureStreamer = CreateRef<TextureStreamer>(&m_TextureStreamerCI);
+	m_UploadPassTimes.resize(m_FramesInFlight, 0.0);
+
+	//Uniform Ring
+	m_UniformRing = UniformRing::GetUniformRing(m_Device);
+	m_UniformRing->SetFramesInFlight(m_FramesInFlight);
+
+	//Texture Cache
+	m_TextureCache = TextureCache::GetTextureCache(m_Device);
 }
 
 Renderer::~Renderer()
 {
 	m_Context->DeviceWaitIdle();
+
+	for (auto& descSetsPerModel : m_DescSetPerModel)
+		descSetsPerModel.first->RemoveDestroyCallback(this);
+	for (auto& descSetsPerMaterial : m_DescSetPerMaterial)
+		descSetsPerMaterial.first->RemoveDestroyCallback(this);
+	for (auto& bindlessMaterialID : m_BindlessMaterialIDs)
+		bindlessMaterialID.first->RemoveDestroyCallback(this);
+
+	//The shared MeshPools', UniformRing's and TextureCache's resources must be destroyed before the device.
+	MeshPool::ReleaseMeshPools(m_Device);
+	m_UniformRing = nullptr;
+	UniformRing::ReleaseUniformRing(m_Device);
+	m_TextureCache = nullptr;
+	TextureCache::ReleaseTextureCache(m_Device);
 }
 
 void Renderer::InitialiseRenderPipelines(const std::vector<std::string>& filepaths, float viewportWidth, float viewportHeight, Image::SampleCountBit samples, const Ref<RenderPass>& renderPass)
@@ -80,6 +151,44 @@ void Renderer::InitialiseRenderPipelines(const std::vector<std::string>& filepat
 		renderPipelineLI.subpassIndex = 0;
 		Ref<RenderPipeline> renderPipeline = CreateRef<RenderPipeline>(&renderPipelineLI);
 		m_RenderPipelines[renderPipeline->m_CI.debugName] = renderPipeline;
+
+		const std::vector<std::vector<Shader::ResourceBindingDescription>>& rbds = renderPipeline->GetRBDs();
+		if (rbds.size() > 2)
+		{
+			for (auto& rbd : rbds[2])
+			{
+				if (arc::ToUpper(rbd.name).find("BINDLESSTEXTURES") != 0)
+					continue;
+
+				const uint32_t deviceLimit = GetDeviceBindlessTextureLimit(rbds, rbd);
+				if (rbd.descriptorCount > deviceLimit)
+				{
+					GEAR_ASSERT(ErrorCode::GRAPHICS | ErrorCode::NOT_SUPPORTED, "Bindless RenderPipeline %s declares %u textures, but the device can only bind %u alongside its other descriptors. Lower MAX_BINDLESS_TEXTURES.",
+						renderPipeline->m_CI.debugName.c_str(), rbd.descriptorCount, deviceLimit);
+				}
+
+				const uint32_t maxBindlessTextures = std::min(rbd.descriptorCount, deviceLimit);
+				if (maxBindlessTextures < m_MaxBindlessTextures)
+				{
+					GEAR_WARN(ErrorCode::GRAPHICS | ErrorCode::INVALID_VALUE, "The bindless texture table is limited to %u textures by RenderPipeline %s. MAX_BINDLESS_TEXTURES is %u.",
+						maxBindlessTextures, renderPipeline->m_CI.debugName.c_str(), UniformBufferStructures::MAX_BINDLESS_TEXTURES);
+					m_MaxBindlessTextures = maxBindlessTextures;
+				}
+			}
+		}
+		if (rbds.size() < 2)
+			continue;
+
+		for (auto& rbd : rbds[1])
+		{
+			if (arc::ToUpper(rbd.name).compare("DRAWINSTANCES") != 0)
+				continue;
+
+			//The vertex shader indexes the instances with SV_InstanceID, which only includes the draw's firstInstance on Vulkan.
+			if (!GraphicsAPI::IsVulkan())
+				GEAR_WARN(ErrorCode::GRAPHICS | ErrorCode::NOT_SUPPORTED, "GPU-driven RenderPipeline %s requires Vulkan. Its models will not be drawn.", renderPipeline->m_CI.debugName.c_str());
+			m_GPUDrivenPipelines.insert(renderPipeline.get());
+		}
 	}
 }
 
@@ -116,14 +225,27 @@ void Renderer::SubmitModel(const Ref<Model>& obj)
 
 void Renderer::Upload(bool forceUploadCamera, bool forceUploadLights, bool forceUploadSkybox, bool forceUploadMeshes)
 {
-	//Get Texture Barries and/or Reload Textures
+	const FrameGraph::ResourceState shaderReadOnlyState = { Barrier::AccessBit::SHADER_READ_BIT, Image::Layout::SHADER_READ_ONLY_OPTIMAL, PipelineStageBit::FRAGMENT_SHADER_BIT, CommandPool::QueueType::GRAPHICS };
+	const FrameGraph::ResourceState bufferReadState = { 
+		Barrier::AccessBit::VERTEX_ATTRIBUTE_READ_BIT | Barrier::AccessBit::INDEX_READ_BIT | Barrier::AccessBit::UNIFORM_READ_BIT | Barrier::AccessBit::SHADER_READ_BIT, Image::Layout::UNKNOWN,
+		PipelineStageBit::VERTEX_INPUT_BIT | PipelineStageBit::VERTEX_SHADER_BIT | PipelineStageBit::FRAGMENT_SHADER_BIT | PipelineStageBit::COMPUTE_SHADER_BIT, CommandPool::QueueType::GRAPHICS };
+	
+	//Wait on this frame slot's previous uploads, so that the completion callbacks of their textures can be raised.
+	//The wait is timed before the draw fence's, so that the TextureStreamer's budget only adapts to the uploads.
+	const Ref<FrameGraph>& uploadFrameGraph = m_UploadFrameGraphs[m_FrameIndex];
+	auto uploadWaitStart = std::chrono::high_resolution_clock::now();
+	uploadFrameGraph->Wait();
+	const double uploadWaitTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - uploadWaitStart).count();
+	uploadFrameGraph->Reset();
+	m_TextureStreamer->Complete(m_FrameIndex, m_UploadPassTimes[m_FrameIndex] + uploadWaitTime);
+
+	//Wait on this frame slot's previous draws, as its copies of the buffers are rewritten below.
+	m_DrawFences[m_FrameIndex]->Wait();
+	
 	std::set<Ref<Texture>> texturesToProcess;
 	std::vector<Ref<Texture>> texturesToGenerateMipmaps;
-
-	std::vector<Ref<Barrier>> textureShaderReadOnlyBarrierToTransferDst;
-	std::vector<Ref<Barrier>> textureUnknownToTransferDstBarrier;
-	std::vector<Ref<Barrier>> textureTransferDstToShaderReadOnlyBarrier;
-	std::vector<Ref<Barrier>> textureGeneralToShaderReadOnlyBarrier;
+	std::vector<FrameGraph::ResourceUsage> textureUploads;
+	std::vector<FrameGraph::ResourceUsage> textureComputeWrites;
 
 	//Get all unique textures
 	for (auto& model : m_RenderQueue)
@@ -138,140 +260,98 @@ void Renderer::Upload(bool forceUploadCamera, bool forceUploadLights, bool force
 	}
 
 	//Deal with Skybox Textures first
+	bool generateSkybox = !m_Skybox->m_Cubemap && !m_Skybox->m_Generated;
 	{
-		if (!m_Skybox->m_Cubemap && !m_Skybox->m_Generated)
-		{
-			m_Skybox->GetGeneratedSpecularBRDF_LUT()->TransitionSubResources(textureGeneralToShaderReadOnlyBarrier,
-				{ { Barrier::AccessBit::SHADER_WRITE_BIT, Barrier::AccessBit::SHADER_READ_BIT | Barrier::AccessBit::SHADER_WRITE_BIT,
-				Image::Layout::GENERAL, Image::Layout::SHADER_READ_ONLY_OPTIMAL, {}, true } });
-
-			m_Skybox->GetGeneratedSpecularCubemap()->TransitionSubResources(textureGeneralToShaderReadOnlyBarrier,
-				{ { Barrier::AccessBit::SHADER_WRITE_BIT, Barrier::AccessBit::SHADER_READ_BIT | Barrier::AccessBit::SHADER_WRITE_BIT,
-				Image::Layout::GENERAL, Image::Layout::SHADER_READ_ONLY_OPTIMAL, {}, true } });
-			
-			m_Skybox->GetGeneratedDiffuseCubemap()->TransitionSubResources(textureGeneralToShaderReadOnlyBarrier,
-				{ { Barrier::AccessBit::SHADER_WRITE_BIT, Barrier::AccessBit::SHADER_READ_BIT | Barrier::AccessBit::SHADER_WRITE_BIT,
-				Image::Layout::GENERAL, Image::Layout::SHADER_READ_ONLY_OPTIMAL, {}, true } });
-			
-			m_Skybox->GetGeneratedCubemap()->TransitionSubResources(textureGeneralToShaderReadOnlyBarrier,
-				{ { Barrier::AccessBit::SHADER_WRITE_BIT, Barrier::AccessBit::SHADER_READ_BIT | Barrier::AccessBit::SHADER_WRITE_BIT,
-				Image::Layout::GENERAL, Image::Layout::SHADER_READ_ONLY_OPTIMAL, {}, true } });
-	
-			m_Skybox->GetTexture()->TransitionSubResources(textureUnknownToTransferDstBarrier,
-				{ { Barrier::AccessBit::NONE_BIT, Barrier::AccessBit::TRANSFER_WRITE_BIT,
-				Image::Layout::UNKNOWN, Image::Layout::TRANSFER_DST_OPTIMAL, {}, true } });
+		const std::vector<Ref<Texture>> skyboxTextures = {
+			m_Skybox->GetGeneratedSpecularBRDF_LUT(),
+			m_Skybox->GetGeneratedSpecularCubemap(),
+			m_Skybox->GetGeneratedDiffuseCubemap(),
+			m_Skybox->GetGeneratedCubemap(),
+			m_Skybox->GetTexture() };
+
+		if (generateSkybox)
+		{
+			textureUploads.push_back({ m_Skybox->GetTexture(), nullptr, Barrier::AccessBit::TRANSFER_WRITE_BIT, Image::Layout::TRANSFER_DST_OPTIMAL, PipelineStageBit::TRANSFER_BIT });
 			m_Skybox->GetTexture()->m_PreUpload = false;
-	
-			m_Skybox->GetTexture()->TransitionSubResources(textureGeneralToShaderReadOnlyBarrier,
-				{ { Barrier::AccessBit::SHADER_WRITE_BIT, Barrier::AccessBit::SHADER_READ_BIT,
-				Image::Layout::GENERAL, Image::Layout::SHADER_READ_ONLY_OPTIMAL, {}, true } });
+
+			for (auto& texture : skyboxTextures)
+			{
+				textureComputeWrites.push_back({ texture, nullptr, Barrier::AccessBit::SHADER_WRITE_BIT, Image::Layout::GENERAL, PipelineStageBit::COMPUTE_SHADER_BIT });
+				uploadFrameGraph->ExportResource(texture, shaderReadOnlyState);
+			}
 		}
-		texturesToProcess.erase(m_Skybox->GetGeneratedSpecularBRDF_LUT());
-		texturesToProcess.erase(m_Skybox->GetGeneratedSpecularCubemap());
-		texturesToProcess.erase(m_Skybox->GetGeneratedDiffuseCubemap());
-		texturesToProcess.erase(m_Skybox->GetGeneratedCubemap());
-		texturesToProcess.erase(m_Skybox->GetTexture());
+		for (auto& texture : skyboxTextures)
+			texturesToProcess.erase(texture);
 	}
 
-	//Process them
+	//Queue the textures that are not resident. The default textures are the placeholders, so they are uploaded immediately.
 	for (auto& texture : texturesToProcess)
 	{
 		if (m_ReloadTextures)
 		{
 			texture->Reload();
-			texture->m_ShaderReadable = false;
-			texture->TransitionSubResources(textureShaderReadOnlyBarrierToTransferDst,
-				{ { Barrier::AccessBit::SHADER_READ_BIT, Barrier::AccessBit::TRANSFER_WRITE_BIT,
-				Image::Layout::SHADER_READ_ONLY_OPTIMAL, Image::Layout::TRANSFER_DST_OPTIMAL, {}, true } });
+			texture->m_PreUpload = true;
 		}
 
 		if (texture->m_PreUpload)
-		{
-			texture->TransitionSubResources(textureUnknownToTransferDstBarrier,
-				{ { Barrier::AccessBit::NONE_BIT, Barrier::AccessBit::TRANSFER_WRITE_BIT,
-				Image::Layout::UNKNOWN, Image::Layout::TRANSFER_DST_OPTIMAL, {}, true } });
-			texture->m_PreUpload = false;
-		}
-
-		if (!texture->m_ShaderReadable)
-		{
-			if (texture->m_GenerateMipMaps && !texture->m_Generated)
-			{
-				texturesToGenerateMipmaps.push_back(texture);
-				texture->TransitionSubResources(textureGeneralToShaderReadOnlyBarrier,
-					{ { Barrier::AccessBit::SHADER_WRITE_BIT, Barrier::AccessBit::SHADER_READ_BIT,
-					Image::Layout::GENERAL, Image::Layout::SHADER_READ_ONLY_OPTIMAL, {}, true } });
-			}
-			else
-			{
-				texture->TransitionSubResources(textureTransferDstToShaderReadOnlyBarrier,
-					{ { Barrier::AccessBit::TRANSFER_WRITE_BIT, Barrier::AccessBit::SHADER_READ_BIT,
-					Image::Layout::TRANSFER_DST_OPTIMAL, Image::Layout::SHADER_READ_ONLY_OPTIMAL, {}, true } });
-			}
-			texture->m_ShaderReadable = true;
-		}
+			m_TextureStreamer->Request(texture);
 	}
 	m_ReloadTextures = false;
 
-	bool preTransferGraphicsTask = textureShaderReadOnlyBarrierToTransferDst.size();
-	bool preUploadTransferTask = textureUnknownToTransferDstBarrier.size();
-
-	bool transferTask = forceUploadCamera || forceUploadLights || forceUploadMeshes || forceUploadSkybox;
-	bool asyncComputeTask = texturesToGenerateMipmaps.size() || !m_Skybox->m_Generated;
-
-	bool postComputeGraphicsTask = textureGeneralToShaderReadOnlyBarrier.size();
-	bool postTransferGraphicsTask = textureTransferDstToShaderReadOnlyBarrier.size();
-
-	Ref<GPUTask> preTransferGraphicsGPUTask, preUploadForTextrueTransferGPUTask, uploadTransferGPUTask, postComputeGraphicsGPUTask, postTransferGraphicsGPUTask;
-	GPUTask::TransitionResourcesTaskInfo trti;
+	for (Material::TextureType type : { Material::TextureType::ALBEDO, Material::TextureType::NORMAL, Material::TextureType::EMISSIVE })
+	{
+		const Ref<Texture>& texture = Material::GetDefaultTexture(type);
+		if (texture && texture->m_PreUpload)
+			m_TextureStreamer->Request(texture, nullptr, true);
+	}
 
-	//Pre-Transfer Graphics Task
+	//Upload the textures that fit in this frame's budget.
+	std::vector<Ref<Texture>> texturesToUpload = m_TextureStreamer->Schedule(m_FrameIndex);
+	for (auto& texture : texturesToUpload)
 	{
-		trti.srcPipelineStage = PipelineStageBit::FRAGMENT_SHADER_BIT;
-		trti.dstPipelineStage = PipelineStageBit::TRANSFER_BIT;
-		trti.barriers = textureShaderReadOnlyBarrierToTransferDst;
+		//Reloaded textures are still in their shader read only layout.
+		if (texture->m_ShaderReadable)
+		{
+			uploadFrameGraph->ImportResource(texture, shaderReadOnlyState);
+			texture->m_ShaderReadable = false;
+		}
 
-		GPUTask::CreateInfo preTransferGraphicsGPUTaskCI;
-		preTransferGraphicsGPUTaskCI.debugName = "Pre-Transfer - Graphics";
-		preTransferGraphicsGPUTaskCI.task = GPUTask::Task::TRANSITION_RESOURCES;
-		preTransferGraphicsGPUTaskCI.pTaskInfo = &trti;
-		preTransferGraphicsGPUTaskCI.srcGPUTasks = {};
-		preTransferGraphicsGPUTaskCI.srcPipelineStages = {};
-		preTransferGraphicsGPUTaskCI.cmdBuffer = m_CmdBuffer;
-		preTransferGraphicsGPUTaskCI.cmdBufferIndex = 3;
-		preTransferGraphicsGPUTaskCI.resetCmdBuffer = true;
-		preTransferGraphicsGPUTaskCI.submitCmdBuffer = true;
-		preTransferGraphicsGPUTaskCI.skipTask = !preTransferGraphicsTask;
+		texture->m_PreUpload = false;
+		textureUploads.push_back({ texture, nullptr, Barrier::AccessBit::TRANSFER_WRITE_BIT, Image::Layout::TRANSFER_DST_OPTIMAL, PipelineStageBit::TRANSFER_BIT });
 
-		preTransferGraphicsGPUTask = CreateRef<GPUTask>(&preTransferGraphicsGPUTaskCI);
-		preTransferGraphicsGPUTask->Execute();
+		if (texture->m_GenerateMipMaps && !texture->m_Generated)
+		{
+			texturesToGenerateMipmaps.push_back(texture);
+			textureComputeWrites.push_back({ texture, nullptr, Barrier::AccessBit::SHADER_WRITE_BIT, Image::Layout::GENERAL, PipelineStageBit::COMPUTE_SHADER_BIT });
+		}
+		uploadFrameGraph->ExportResource(texture, shaderReadOnlyState);
+		texture->m_ShaderReadable = true;
 	}
 
-	//Pre-Upload Transfer Task
-	{
-		trti.srcPipelineStage = PipelineStageBit::TOP_OF_PIPE_BIT;
-		trti.dstPipelineStage = PipelineStageBit::TRANSFER_BIT;
-		trti.barriers = textureUnknownToTransferDstBarrier;
+	//Materials bound with placeholders are rewritten once their textures are uploaded, as their keys change.
+	UpdateBindlessMaterials();
 
-		GPUTask::CreateInfo preUploadForTextrueTransferGPUTaskCI;
-		preUploadForTextrueTransferGPUTaskCI.debugName = "Pre-Upload - Transfer";
-		preUploadForTextrueTransferGPUTaskCI.task = GPUTask::Task::TRANSITION_RESOURCES;
-		preUploadForTextrueTransferGPUTaskCI.pTaskInfo = &trti;
-		preUploadForTextrueTransferGPUTaskCI.srcGPUTasks = { preTransferGraphicsGPUTask };
-		preUploadForTextrueTransferGPUTaskCI.srcPipelineStages = { PipelineStageBit::TRANSFER_BIT };
-		preUploadForTextrueTransferGPUTaskCI.cmdBuffer = m_TransCmdBuffer;
-		preUploadForTextrueTransferGPUTaskCI.cmdBufferIndex = 0;
-		preUploadForTextrueTransferGPUTaskCI.resetCmdBuffer = true;
-		preUploadForTextrueTransferGPUTaskCI.submitCmdBuffer = false;
-		preUploadForTextrueTransferGPUTaskCI.skipTask = !preUploadTransferTask;
+	//Get all unique MeshPools. Every pool is ticked each frame, so that ranges freed by meshes that are no longer
+	//submitted are still reclaimed. Newly allocated ranges and compactions are recorded into the upload.
+	const std::vector<Ref<MeshPool>> sharedMeshPools = MeshPool::GetMeshPools(m_Device);
+	std::set<Ref<MeshPool>> meshPools(sharedMeshPools.begin(), sharedMeshPools.end());
+	for (auto& model : m_RenderQueue)
+		meshPools.insert(model->GetMesh()->GetMeshPool());
 
-		preUploadForTextrueTransferGPUTask = CreateRef<GPUTask>(&preUploadForTextrueTransferGPUTaskCI);
-		preUploadForTextrueTransferGPUTask->Execute();
+	for (auto& meshPool : meshPools)
+	{
+		//Freed ranges must outlive the draws of every frame in flight.
+		meshPool->SetFrameLatency(std::max(meshPool->GetCreateInfo().frameLatency, m_FramesInFlight + 1));
+		meshPool->NextFrame();
 	}
 
-	//Upload Transfer Task
+	//Evicted textures must not be in use by any frame in flight either.
+	m_TextureCache->SetFrameLatency(std::max(m_TextureCache->GetCreateInfo().frameLatency, m_FramesInFlight + 1));
+	m_TextureCache->NextFrame();
+
+	//Upload Transfer Pass
+	GPUTask::UploadResourceTaskInfo urti;
 	{
-		GPUTask::UploadResourceTaskInfo urti;
 		urti.camera = m_Camera;
 		urti.cameraForce = forceUploadCamera;
 		urti.fontCamera = m_FontCamera;
@@ -283,35 +363,62 @@ void Renderer::Upload(bool forceUploadCamera, bool forceUploadLights, bool force
 		urti.models = m_RenderQueue;
 		urti.modelsForce = forceUploadMeshes;
 		urti.materialsForce = false;
+		urti.textures = texturesToUpload;
+		urti.meshPools = std::vector<Ref<MeshPool>>(meshPools.begin(), meshPools.end());
+		urti.bindlessMaterials = m_BindlessMaterials.empty() ? nullptr : m_BindlessMaterials[m_FrameIndex];
+		urti.copyStatistics = {};
+		GPUTask::AddBufferCopies(urti);
+
+		//The copied buffers are declared, so that the FrameGraph transfers their ownership to the TRANSFER queue and back.
+		//Sources in GPU memory are the blocks of compacted MeshPools. The upload buffers in CPU memory are only used by the copies.
+		std::vector<Ref<Buffer>> srcBuffers, dstBuffers;
+		urti.copyBatch.GetBuffers(srcBuffers, dstBuffers);
+		std::vector<FrameGraph::ResourceUsage> bufferReads;
+		std::vector<FrameGraph::ResourceUsage> bufferWrites;
+		for (auto& buffer : dstBuffers)
+		{
+			uploadFrameGraph->ImportResource(buffer, bufferReadState);
+			bufferWrites.push_back({ nullptr, buffer, Barrier::AccessBit::TRANSFER_WRITE_BIT, Image::Layout::UNKNOWN, PipelineStageBit::TRANSFER_BIT });
+			uploadFrameGraph->ExportResource(buffer, bufferReadState);
+		}
+		const Ref<Allocator>& gpuAllocator = AllocatorManager::GetAllocator(AllocatorManager::AllocatorType::GPU);
+		for (auto& buffer : srcBuffers)
+		{
+			if (buffer->GetCreateInfo().pAllocator != gpuAllocator || std::find(dstBuffers.begin(), dstBuffers.end(), buffer) != dstBuffers.end())
+				continue;
 
-		GPUTask::CreateInfo uploadTransferGPUTaskCI;
-		uploadTransferGPUTaskCI.debugName = "Upload - Transfer";
-		uploadTransferGPUTaskCI.task = GPUTask::Task::UPLOAD_RESOURCES;
-		uploadTransferGPUTaskCI.pTaskInfo = &urti;
-		uploadTransferGPUTaskCI.srcGPUTasks = { preUploadForTextrueTransferGPUTask };
-		uploadTransferGPUTaskCI.srcPipelineStages = { (PipelineStageBit)0 };
-		uploadTransferGPUTaskCI.cmdBuffer = m_TransCmdBuffer;
-		uploadTransferGPUTaskCI.cmdBufferIndex = 0;
-		uploadTransferGPUTaskCI.resetCmdBuffer = false;
-		uploadTransferGPUTaskCI.submitCmdBuffer = true;
-		uploadTransferGPUTaskCI.skipTask = !transferTask;
+			uploadFrameGraph->ImportResource(buffer, bufferReadState);
+			bufferReads.push_back({ nullptr, buffer, Barrier::AccessBit::TRANSFER_READ_BIT, Image::Layout::UNKNOWN, PipelineStageBit::TRANSFER_BIT });
+		}
 
-		uploadTransferGPUTask = CreateRef<GPUTask>(&uploadTransferGPUTaskCI);
-		uploadTransferGPUTask->Execute();
+		FrameGraph::PassCreateInfo uploadPassCI;
+		uploadPassCI.debugName = "Upload - Transfer";
+		uploadPassCI.queueType = CommandPool::QueueType::TRANSFER;
+		uploadPassCI.task = GPUTask::Task::UPLOAD_RESOURCES;
+		uploadPassCI.pTaskInfo = &urti;
+		uploadPassCI.hostTask = nullptr;
+		uploadPassCI.reads = bufferReads;
+		uploadPassCI.writes = textureUploads;
+		uploadPassCI.writes.insert(uploadPassCI.writes.end(), bufferWrites.begin(), bufferWrites.end());
+		uploadPassCI.hasSideEffects = false; //The pass is kept by its exported textures and buffers.
+		uploadFrameGraph->AddPass(uploadPassCI);
 	}
 
-	//Async Compute Task
+	//Async Compute Pass: ImageProcessing submits and waits on its own CommandBuffers.
+	if (!texturesToGenerateMipmaps.empty() || generateSkybox)
 	{
-		if (asyncComputeTask && transferTask)
-			uploadTransferGPUTask->GetFence()->Wait();
-
-		if (asyncComputeTask)
+		FrameGraph::PassCreateInfo computePassCI;
+		computePassCI.debugName = "Async Compute - ImageProcessing";
+		computePassCI.queueType = CommandPool::QueueType::COMPUTE;
+		computePassCI.task = GPUTask::Task::NONE;
+		computePassCI.pTaskInfo = nullptr;
+		computePassCI.hostTask = [this, texturesToGenerateMipmaps, generateSkybox]() mutable
 		{
 			for (auto& texture : texturesToGenerateMipmaps)
 			{
 				ImageProcessing::GenerateMipMaps({ texture, Barrier::AccessBit::TRANSFER_WRITE_BIT, Image::Layout::TRANSFER_DST_OPTIMAL, PipelineStageBit::TRANSFER_BIT });
 			}
-			if (!m_Skybox->m_Cubemap && !m_Skybox->m_Generated)
+			if (generateSkybox)
 			{
 				ImageProcessing::EquirectangularToCube(
 					{ m_Skybox->GetGeneratedCubemap(), Barrier::AccessBit::NONE_BIT, Image::Layout::UNKNOWN, PipelineStageBit::TOP_OF_PIPE_BIT },
@@ -331,334 +438,1156 @@ void Renderer::Upload(bool forceUploadCamera, bool forceUploadLights, bool force
 				ImageProcessing::SpecularBRDF_LUT(
 					{ m_Skybox->GetGeneratedSpecularBRDF_LUT(), Barrier::AccessBit::NONE_BIT, Image::Layout::UNKNOWN, PipelineStageBit::TOP_OF_PIPE_BIT });
 			}
+		};
+		computePassCI.reads = {};
+		computePassCI.writes = textureComputeWrites;
+		computePassCI.hasSideEffects = false;
+		uploadFrameGraph->AddPass(computePassCI);
+	}
+
+	//The shader read only transitions of the exported textures are derived by the FrameGraph.
+	//Execute() only waits on this frame slot's previous uploads. The join's memory barrier orders this frame's draw after the uploads on the GPU.
+	auto uploadPassStart = std::chrono::high_resolution_clock::now();
+	uploadFrameGraph->Compile();
+	uploadFrameGraph->Execute();
+	m_UploadPassTimes[m_FrameIndex] = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - uploadPassStart).count();
+	m_UploadCopyStatistics = urti.copyStatistics;
+	m_BindlessMaterialsChanged = false;
+}
+
+void Renderer::Flush()
+{
+	//Record Present CmdBuffers
+	m_DrawFences[m_FrameIndex]->Wait();
+	{
+		auto recordingStart = std::chrono::high_resolution_clock::now();
+
+		BuildDrawItems();
+		BuildDrawInstances();
+		if (m_ClusterCulling && m_Camera)
+		{
+			m_ClusterCullPlanes = m_Camera->GetFrustumPlanes();
+			m_ClusterCullPosition = m_Camera->m_CI.transform.translation;
+			m_ClusterCullMirrored = m_Camera->m_CI.flipX != m_Camera->m_CI.flipY;
+		}
+		m_UniformRing->Submit(m_FrameIndex);
+		UpdateDescriptorSets();
+
+		m_CmdBuffer->Reset(m_FrameIndex, false);
+		m_CmdBuffer->Begin(m_FrameIndex, CommandBuffer::UsageBit::SIMULTANEOUS);
+		if (!m_GPUDrivenBatches.empty())
+			RecordGPUDrivenCull(m_CmdBuffer, m_FrameIndex);
+		//A render pass that executes secondary CommandBuffers can not have any commands recorded inline.
+		const Ref<miru::crossplatform::Framebuffer>& framebuffer = m_Framebuffers[m_FrameIndex];
+		const bool parallelRecording = m_RecordingThreadPool && m_DrawItems.size() > 1;
+		m_CmdBuffer->BeginRenderPass(m_FrameIndex, framebuffer, { {0.25f, 0.25f, 0.25f, 1.0f}, {1.0f, 0} }, 
+			parallelRecording ? CommandBuffer::SubpassContents::SECONDARY_COMMAND_BUFFERS : CommandBuffer::SubpassContents::INLINE);
+
+		Statistics statistics = {};
+		if (parallelRecording)
+		{
+			//Each worker records a contiguous range of the sorted draws, so executing the ranges in order preserves the sort order.
+			//Bind state is tracked per range, as each secondary CommandBuffer starts with no state bound.
+			//The secondary CommandBuffers continue subpass 0 of the frame's render pass, which they must inherit.
+			CommandBuffer::InheritanceInfo inheritanceInfo;
+			inheritanceInfo.renderPass = framebuffer->GetCreateInfo().renderPass;
+			inheritanceInfo.subpassIndex = 0;
+			inheritanceInfo.framebuffer = framebuffer;
+
+			std::vector<Statistics> rangeStatistics(m_RecordingWorkerCount, Statistics{});
+			std::atomic<uint32_t> usedSecondaryCmdBufferCount = 0;
+			m_RecordingThreadPool->ParallelFor(m_DrawItems.size(), 
+				[&](size_t begin, size_t end, uint32_t rangeIndex)
+				{
+					const Ref<CommandBuffer>& secondaryCmdBuffer = m_SecondaryCmdBuffers[rangeIndex];
+					secondaryCmdBuffer->Reset(m_FrameIndex, false);
+					secondaryCmdBuffer->Begin(m_FrameIndex, CommandBuffer::UsageBit::RENDER_PASS_CONTINUE, &inheritanceInfo);
+					
+					RecordDrawCalls(secondaryCmdBuffer, m_FrameIndex, begin, end, rangeStatistics[rangeIndex]);
+					if (end == m_DrawItems.size())
+					{
+						RecordGPUDrivenDrawCalls(secondaryCmdBuffer, m_FrameIndex, rangeStatistics[rangeIndex]);
+						DrawCoordinateAxes(secondaryCmdBuffer, m_FrameIndex);
+					}
+					
+					secondaryCmdBuffer->End(m_FrameIndex);
+
+					uint32_t count = usedSecondaryCmdBufferCount.load();
+					while (count < rangeIndex + 1 && !usedSecondaryCmdBufferCount.compare_exchange_weak(count, rangeIndex + 1)) {}
+				});
+
+			for (uint32_t i = 0; i < usedSecondaryCmdBufferCount.load(); i++)
+				m_CmdBuffer->ExecuteSecondaryCommandBuffers(m_FrameIndex, m_SecondaryCmdBuffers[i], { m_FrameIndex });
+
+			for (const Statistics& range : rangeStatistics)
+			{
+				statistics.drawCalls += range.drawCalls;
+				statistics.pipelineBinds += range.pipelineBinds;
+				statistics.pipelineBindsSaved += range.pipelineBindsSaved;
+				statistics.descriptorSetBinds += range.descriptorSetBinds;
+				statistics.descriptorSetBindsSaved += range.descriptorSetBindsSaved;
+				statistics.vertexBufferBinds += range.vertexBufferBinds;
+				statistics.vertexBufferBindsSaved += range.vertexBufferBindsSaved;
+				statistics.indexBufferBinds += range.indexBufferBinds;
+				statistics.indexBufferBindsSaved += range.indexBufferBindsSaved;
+				statistics.indirectDrawCalls += range.indirectDrawCalls;
+				statistics.clusters += range.clusters;
+				statistics.clustersCulled += range.clustersCulled;
+				statistics.clusterTrianglesCulled += range.clusterTrianglesCulled;
+			}
+		}
+		else
+		{
+			RecordDrawCalls(m_CmdBuffer, m_FrameIndex, 0, m_DrawItems.size(), statistics);
+			RecordGPUDrivenDrawCalls(m_CmdBuffer, m_FrameIndex, statistics);
+			DrawCoordinateAxes(m_CmdBuffer, m_FrameIndex);
 		}
+
+		m_CmdBuffer->EndRenderPass(m_FrameIndex);
+		m_CmdBuffer->End(m_FrameIndex);
+
+		statistics.recordingTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - recordingStart).count();
+		statistics.recordingWorkerCount = m_RecordingWorkerCount;
+		statistics.gpuDrivenInstances = !m_GPUDrivenBatches.empty() ? static_cast<uint32_t>(m_DrawInstances[m_FrameIndex]->GetCount()) : 0;
+		statistics.gpuDrivenBatches = static_cast<uint32_t>(m_GPUDrivenBatches.size());
+		statistics.uploadBytes = m_UploadCopyStatistics.bytes;
+		statistics.uploadCopyCommands = m_UploadCopyStatistics.copyCommands;
+		m_Statistics = statistics;
 	}
+	m_RenderQueue.clear();
+}
 
-	//Post-Compute Graphics Task
+//Sort key layout, most significant bit first:
+//Opaque:      0 | pipeline (8) | material (14) | mesh (14) | depth (24), so state changes are minimised and then drawn front-to-back.
+//Translucent: 1 | inverted depth (24) | pipeline (8) | material (14) | mesh (14), so they are drawn after all opaques and back-to-front.
+//IDs are compacted per frame and clamped to their field width. A clamped ID only costs sort quality, as binds compare the actual objects.
+static constexpr uint64_t SortKeyTranslucentBit = uint64_t(1) << 63;
+static constexpr uint64_t SortKeyPipelineMask = 0xFF;
+static constexpr uint64_t SortKeyMaterialMask = 0x3FFF;
+static constexpr uint64_t SortKeyMeshMask = 0x3FFF;
+static constexpr uint64_t SortKeyDepthMask = 0xFFFFFF;
+
+void Renderer::BuildDrawItems()
+{
+	std::map<const RenderPipeline*, uint64_t> pipelineIDs;
+	for (auto& renderPipeline : m_RenderPipelines)
+		pipelineIDs[renderPipeline.second.get()] = std::min(static_cast<uint64_t>(pipelineIDs.size()), SortKeyPipelineMask);
+
+	std::map<const Material*, uint64_t> materialIDs;
+	std::map<const BufferView*, uint64_t> meshIDs;
+	auto GetID = [](auto& ids, const auto* ptr, uint64_t mask) -> uint64_t
 	{
-		trti.srcPipelineStage = PipelineStageBit::COMPUTE_SHADER_BIT;
-		trti.dstPipelineStage = PipelineStageBit::FRAGMENT_SHADER_BIT;
-		trti.barriers = textureGeneralToShaderReadOnlyBarrier;
+		auto it = ids.find(ptr);
+		if (it == ids.end())
+			it = ids.insert({ ptr, std::min(static_cast<uint64_t>(ids.size()), mask) }).first;
+		return it->second;
+	};
+
+	mars::Vec3 cameraPosition(0.0f, 0.0f, 0.0f);
+	float zFar = 1.0f;
+	if (m_Camera)
+	{
+		cameraPosition = m_Camera->m_CI.transform.translation;
+		zFar = m_Camera->m_CI.projectionType == Camera::ProjectionType::PERSPECTIVE ? m_Camera->m_CI.perspectiveParams.zFar : m_Camera->m_CI.orthographicsParams.far;
+		zFar = zFar > 0.0f ? zFar : 1.0f;
+	}
 
-		GPUTask::CreateInfo postComputeGraphicsGPUTaskCI;
-		postComputeGraphicsGPUTaskCI.debugName = "Post-Compute - Graphics";
-		postComputeGraphicsGPUTaskCI.task = GPUTask::Task::TRANSITION_RESOURCES;
-		postComputeGraphicsGPUTaskCI.pTaskInfo = &trti;
-		postComputeGraphicsGPUTaskCI.srcGPUTasks = { uploadTransferGPUTask };
-		postComputeGraphicsGPUTaskCI.srcPipelineStages = { PipelineStageBit::COMPUTE_SHADER_BIT };
-		postComputeGraphicsGPUTaskCI.cmdBuffer = m_CmdBuffer;
-		postComputeGraphicsGPUTaskCI.cmdBufferIndex = 2;
-		postComputeGraphicsGPUTaskCI.resetCmdBuffer = true;
-		postComputeGraphicsGPUTaskCI.submitCmdBuffer = false;
-		postComputeGraphicsGPUTaskCI.skipTask = !postComputeGraphicsTask;
+	m_DrawItems.clear();
+	for (size_t j = 0; j < m_RenderQueue.size(); j++)
+	{
+		const Ref<Model>& model = m_RenderQueue[j];
+		const Ref<graphics::RenderPipeline>& renderPipeline = FindOrNull(m_RenderPipelines, model->GetPipelineName());
+		if (m_GPUDrivenPipelines.find(renderPipeline.get()) != m_GPUDrivenPipelines.end())
+			continue;
+
+		const uint64_t pipelineID = pipelineIDs[renderPipeline.get()];
+		const bool translucent = !renderPipeline->m_CI.depthStencilState.depthWriteEnable;
+		const bool bindless = m_BindlessPipelines.find(renderPipeline.get()) != m_BindlessPipelines.end();
+
+		const mars::Vec3& position = model->m_CI.transform.translation;
+		const float dx = position.x - cameraPosition.x;
+		const float dy = position.y - cameraPosition.y;
+		const float dz = position.z - cameraPosition.z;
+		const float normalisedDepth = std::min(std::max(std::sqrt(dx * dx + dy * dy + dz * dz) / zFar, 0.0f), 1.0f);
+		const uint64_t depth = static_cast<uint64_t>(normalisedDepth * static_cast<float>(SortKeyDepthMask)) & SortKeyDepthMask;
+
+		const Ref<Mesh>& mesh = model->GetMesh();
+		for (size_t i = 0; i < mesh->GetAllocations().size(); i++)
+		{
+			//Bindless materials share one Descriptor Set, so they do not split batches.
+			//Sub-meshes in the same MeshPool block share their buffers, so they do not split batches either.
+			const uint64_t materialID = bindless ? 0 : GetID(materialIDs, mesh->GetMaterials()[i].get(), SortKeyMaterialMask);
+			const uint64_t meshID = GetID(meshIDs, mesh->GetMeshPool()->GetVertexBufferView(mesh->GetAllocations()[i]->blockIndex).get(), SortKeyMeshMask);
+
+			uint64_t sortKey = 0;
+			if (translucent)
+				sortKey = SortKeyTranslucentBit | ((~depth & SortKeyDepthMask) << 36) | (pipelineID << 28) | (materialID << 14) | meshID;
+			else
+				sortKey = (pipelineID << 52) | (materialID << 38) | (meshID << 24) | depth;
 
-		postComputeGraphicsGPUTask = CreateRef<GPUTask>(&postComputeGraphicsGPUTaskCI);
-		postComputeGraphicsGPUTask->Execute();
+			m_DrawItems.push_back({ sortKey, static_cast<uint32_t>(j), static_cast<uint32_t>(i) });
+		}
 	}
 
-	//Post-Transfer Graphics CmdBuffer
+	RadixSortDrawItems(m_DrawItems, m_DrawItemsScratch);
+}
+
+void Renderer::RadixSortDrawItems(std::vector<DrawItem>& drawItems, std::vector<DrawItem>& scratch)
+{
+	//LSD radix sort on 8 bit digits. It is stable, so draws with equal keys keep their submission order.
+	constexpr size_t digitCount = sizeof(uint64_t);
+	uint32_t histograms[digitCount][256] = {};
+	for (const DrawItem& drawItem : drawItems)
 	{
-		trti.srcPipelineStage = PipelineStageBit::TRANSFER_BIT;
-		trti.dstPipelineStage = PipelineStageBit::FRAGMENT_SHADER_BIT;
-		trti.barriers = textureTransferDstToShaderReadOnlyBarrier;
-	
-		GPUTask::CreateInfo postTransferGraphicsGPUTaskCI;
-		postTransferGraphicsGPUTaskCI.debugName = "Post-Transfer - Graphics";
-		postTransferGraphicsGPUTaskCI.task = GPUTask::Task::TRANSITION_RESOURCES;
-		postTransferGraphicsGPUTaskCI.pTaskInfo = &trti;
-		postTransferGraphicsGPUTaskCI.srcGPUTasks = { postComputeGraphicsGPUTask };
-		postTransferGraphicsGPUTaskCI.srcPipelineStages = { (PipelineStageBit)0 };
-		postTransferGraphicsGPUTaskCI.cmdBuffer = m_CmdBuffer;
-		postTransferGraphicsGPUTaskCI.cmdBufferIndex = 2;
-		postTransferGraphicsGPUTaskCI.resetCmdBuffer = false;
-		postTransferGraphicsGPUTaskCI.submitCmdBuffer = true;
-		postTransferGraphicsGPUTaskCI.skipTask = !postTransferGraphicsTask;
-	
-		postTransferGraphicsGPUTask = CreateRef<GPUTask>(&postTransferGraphicsGPUTaskCI);
-		postTransferGraphicsGPUTask->Execute();
+		for (size_t d = 0; d < digitCount; d++)
+			histograms[d][(drawItem.sortKey >> (d * 8)) & 0xFF]++;
 	}
 
-	//Wait for all Task Fences
-	preTransferGraphicsGPUTask->GetFence()->Wait();
-	uploadTransferGPUTask->GetFence()->Wait();
-	postTransferGraphicsGPUTask->GetFence()->Wait();
+	scratch.resize(drawItems.size());
+	for (size_t d = 0; d < digitCount; d++)
+	{
+		uint32_t* histogram = histograms[d];
+
+		//Skip digits that are the same for every key, e.g. unused ID bits.
+		if (drawItems.empty() || histogram[(drawItems[0].sortKey >> (d * 8)) & 0xFF] == drawItems.size())
+			continue;
+
+		uint32_t offset = 0;
+		for (size_t b = 0; b < 256; b++)
+		{
+			uint32_t count = histogram[b];
+			histogram[b] = offset;
+			offset += count;
+		}
+
+		for (const DrawItem& drawItem : drawItems)
+			scratch[histogram[(drawItem.sortKey >> (d * 8)) & 0xFF]++] = drawItem;
+
+		drawItems.swap(scratch);
+	}
 }
 
-void Renderer::Flush()
+void Renderer::RecordDrawCalls(const Ref<CommandBuffer>& cmdBuffer, uint32_t cmdBufferIndex, size_t drawItemBegin, size_t drawItemEnd, Statistics& statistics)
 {
-	if(!m_BuiltDescPoolsAndSets)
+	//Only const lookups are used on the shared maps, as this may be called from multiple threads.
+	const Pipeline* boundPipeline = nullptr;
+	const DescriptorSet* boundDescSets[3] = { nullptr, nullptr, nullptr };
+	const BufferView* boundVertexBuffer = nullptr;
+	const BufferView* boundIndexBuffer = nullptr;
+	uint32_t pushedMaterialID = UINT32_MAX;
+	std::vector<uint8_t> clusterVisibility;
+	std::vector<DrawIndexedIndirectCommand> clusterDrawCommands;
+
+	for (size_t k = drawItemBegin; k < drawItemEnd; k++)
 	{
-		//Desriptor Pool
-		std::map<DescriptorType, uint32_t> poolSizesMap;
-		size_t m_RenderQueueMaterialCount = 0;
-		for (auto& model : m_RenderQueue)
+		const DrawItem& drawItem = m_DrawItems[k];
+		const Ref<Model>& model = m_RenderQueue[drawItem.modelIndex];
+		const uint32_t& i = drawItem.subMeshIndex;
+		const Ref<graphics::RenderPipeline>& renderPipeline = FindOrNull(m_RenderPipelines, model->GetPipelineName());
+		const Ref<Pipeline>& pipeline = renderPipeline->GetPipeline();
+
+		//Binding a Pipeline invalidates the bound DescriptorSets, so they are rebound too.
+		bool pipelineChanged = boundPipeline != pipeline.get();
+		if (pipelineChanged)
+		{
+			cmdBuffer->BindPipeline(cmdBufferIndex, pipeline);
+			boundPipeline = pipeline.get();
+			statistics.pipelineBinds++;
+		}
+		else
+			statistics.pipelineBindsSaved++;
+
+		const Ref<objects::Material>& material = model->GetMesh()->GetMaterials()[i];
+		const Ref<DescriptorSet>& descSetPerView = FindOrNull(m_DescSetPerView, renderPipeline, m_FrameIndex);
+		const Ref<DescriptorSet>& descSetPerModel = FindOrNull(m_DescSetPerModel, model.get(), m_FrameIndex);
+		const bool bindless = m_BindlessPipelines.find(renderPipeline.get()) != m_BindlessPipelines.end();
+		const Ref<DescriptorSet>& descSetPerMaterial = bindless ? FindOrNull(m_DescSetBindless, renderPipeline, m_FrameIndex) : GetDescriptorSetPerMaterial(material.get());
+		if (pipelineChanged || boundDescSets[0] != descSetPerView.get() || boundDescSets[1] != descSetPerModel.get() || boundDescSets[2] != descSetPerMaterial.get())
 		{
-			const Ref<Pipeline>& pipeline = m_RenderPipelines[model->GetPipelineName()]->GetPipeline();
-			const std::vector<std::vector<Shader::ResourceBindingDescription>> rbds = m_RenderPipelines[model->GetPipelineName()]->GetRBDs();
-			size_t materialCount = model->GetMesh()->GetMaterials().size();
-			m_RenderQueueMaterialCount += materialCount;
+			cmdBuffer->BindDescriptorSets(cmdBufferIndex, { descSetPerView, descSetPerModel, descSetPerMaterial }, pipeline);
+			boundDescSets[0] = descSetPerView.get();
+			boundDescSets[1] = descSetPerModel.get();
+			boundDescSets[2] = descSetPerMaterial.get();
+			statistics.descriptorSetBinds++;
+		}
+		else
+			statistics.descriptorSetBindsSaved++;
 
-			uint32_t set = 0;
-			uint32_t binding = 0;
-			for (auto& set_rbds : rbds)
+		if (bindless && !renderPipeline->m_CI.pushConstantRanges.empty())
+		{
+			uint32_t materialID = FindOrNull(m_BindlessMaterialIDs, material.get());
+			if (pipelineChanged || pushedMaterialID != materialID)
 			{
-				for (auto& binding_rbds : set_rbds)
-				{
-					uint32_t& descCount = poolSizesMap[binding_rbds.type];
-					descCount += (binding_rbds.descriptorCount * (set == 2 ? static_cast<uint32_t>(materialCount) : 1));
-					binding++;
-				}
-				set++;
+				const Pipeline::PushConstantRange& pushConstantRange = renderPipeline->m_CI.pushConstantRanges[0];
+				cmdBuffer->PushConstants(cmdBufferIndex, pipeline, pushConstantRange.stages, pushConstantRange.offset, sizeof(UniformBufferStructures::MaterialIndex), &materialID);
+				pushedMaterialID = materialID;
 			}
 		}
-		m_DescPoolCI.debugName = "GEAR_CORE_DescriptorPool_Renderer";
-		m_DescPoolCI.device = m_Device;
-		for (auto& poolSize : poolSizesMap)
-			m_DescPoolCI.poolSizes.push_back({ poolSize.first, poolSize.second });
-		m_DescPoolCI.maxSets = static_cast<uint32_t>(m_RenderPipelines.size() + m_RenderQueue.size() + m_RenderQueueMaterialCount);
-		m_DescPool = DescriptorPool::Create(&m_DescPoolCI);
 
-		//Per view Descriptor Set
-		for (auto& pipeline : m_RenderPipelines)
+		const Ref<MeshPool>& meshPool = model->GetMesh()->GetMeshPool();
+		const MeshPool::Allocation& allocation = *model->GetMesh()->GetAllocations()[i];
+		const Ref<BufferView>& vertexBufferView = meshPool->GetVertexBufferView(allocation.blockIndex);
+		if (boundVertexBuffer != vertexBufferView.get())
 		{
-			const std::vector<Ref<DescriptorSetLayout>>& descriptorSetLayouts = pipeline.second->GetDescriptorSetLayouts();
-			const std::vector<std::vector<Shader::ResourceBindingDescription>> rbds = pipeline.second->GetRBDs();
+			cmdBuffer->BindVertexBuffers(cmdBufferIndex, { vertexBufferView });
+			boundVertexBuffer = vertexBufferView.get();
+			statistics.vertexBufferBinds++;
+		}
+		else
+			statistics.vertexBufferBindsSaved++;
 
-			if (descriptorSetLayouts.empty() || rbds.empty())
-				continue;
+		const Ref<BufferView>& indexBufferView = meshPool->GetIndexBufferView(allocation.blockIndex);
+		if (boundIndexBuffer != indexBufferView.get())
+		{
+			cmdBuffer->BindIndexBuffer(cmdBufferIndex, indexBufferView);
+			boundIndexBuffer = indexBufferView.get();
+			statistics.indexBufferBinds++;
+		}
+		else
+			statistics.indexBufferBindsSaved++;
 
-			DescriptorSet::CreateInfo descSetPerViewCI;
-			descSetPerViewCI.debugName = "GEAR_CORE_DescriptorSet_PerView: " + pipeline.second->GetPipeline()->GetCreateInfo().debugName;
-			descSetPerViewCI.pDescriptorPool = m_DescPool;
-			descSetPerViewCI.pDescriptorSetLayouts = { descriptorSetLayouts[0] };
-			m_DescSetPerView[pipeline.second] = DescriptorSet::Create(&descSetPerViewCI);
-			
-			for (auto& rbd : rbds[0])
+		const Mesh::LevelOfDetail& levelOfDetail = model->GetMesh()->GetLevelOfDetail(i, model->GetLevelOfDetail());
+		const ModelLoader::MeshData& meshData = model->GetMesh()->GetModelData().meshes[i];
+		if (m_ClusterCulling && m_Camera && model->GetLevelOfDetail() == 0 && !meshData.meshlets.empty() && meshData.bones.empty())
+		{
+			//The meshlets are in the object space of the mesh, and are contiguous in level 0 of the index range.
+			const Pipeline::RasterisationState& rasterisationState = renderPipeline->m_CI.rasterisationState;
+			const bool backfaceCulling = rasterisationState.cullMode == CullModeBit::BACK_BIT && rasterisationState.frontFace == FrontFace::COUNTER_CLOCKWISE && !m_ClusterCullMirrored;
+			const ClusterCulling::View view = ClusterCulling::GetView(m_ClusterCullPlanes, m_ClusterCullPosition, model->GetModlMatrix(), backfaceCulling);
+
+			const std::vector<ModelLoader::Meshlet>& meshlets = meshData.meshlets;
+			clusterVisibility.resize(meshlets.size());
+			clusterDrawCommands.resize(meshlets.size());
+			const size_t visibleCount = ClusterCulling::Cull(view, meshlets.data(), meshlets.size(), clusterVisibility.data());
+			const size_t commandCount = ClusterCulling::EmitDrawCommands(meshlets.data(), meshlets.size(), clusterVisibility.data(), allocation.firstIndex, static_cast<int32_t>(allocation.vertexOffset), clusterDrawCommands.data());
+
+			uint32_t drawnIndexCount = 0;
+			for (size_t c = 0; c < commandCount; c++)
 			{
-				const uint32_t& binding = rbd.binding;
-				const std::string& name = arc::ToUpper(rbd.name);
-				if (rbd.structSize > 0)
-				{
-					if (SetUpdateTypeMap.find(name) == SetUpdateTypeMap.end())
-						continue;
-					if (SetUpdateTypeMap[name] != SetUpdateType::PER_VIEW)
-						continue;
-				}
+				const DrawIndexedIndirectCommand& command = clusterDrawCommands[c];
+				cmdBuffer->DrawIndexed(cmdBufferIndex, command.indexCount, 1, command.firstIndex, command.vertexOffset, 0);
+				drawnIndexCount += command.indexCount;
+				statistics.drawCalls++;
+			}
+			statistics.clusters += static_cast<uint32_t>(meshlets.size());
+			statistics.clustersCulled += static_cast<uint32_t>(meshlets.size() - visibleCount);
+			statistics.clusterTrianglesCulled += (levelOfDetail.indexCount - drawnIndexCount) / 3;
+		}
+		else
+		{
+			cmdBuffer->DrawIndexed(cmdBufferIndex, levelOfDetail.indexCount, 1, allocation.firstIndex + levelOfDetail.firstIndex, static_cast<int32_t>(allocation.vertexOffset), 0);
+			statistics.drawCalls++;
+		}
+	}
+}
 
-				if (name.compare("CAMERA") == 0)
-				{
-					m_DescSetPerView[pipeline.second]->AddBuffer(0, binding, { { m_Camera->GetUB()->GetBufferView() } });
-				}
-				else if (name.compare("FONTCAMERA") == 0)
-				{
-					m_DescSetPerView[pipeline.second]->AddBuffer(0, binding, { { m_FontCamera->GetUB()->GetBufferView() } });
-				}
-				else if (name.compare("LIGHTS") == 0)
-				{
-					m_DescSetPerView[pipeline.second]->AddBuffer(0, binding, { { m_Lights[0]->GetUB()->GetBufferView() } });
-				}
+void Renderer::BuildDrawInstances()
+{
+	m_GPUDrivenBatches.clear();
+	if (m_GPUDrivenPipelines.empty() || !GraphicsAPI::IsVulkan() || !m_Camera)
+		return;
 
-				else if (name.find("DIFFUSEIRRADIANCE") == 0)
-				{
-					const Ref<Texture>& skyboxTexture = m_Skybox->GetGeneratedDiffuseCubemap();
-					m_DescSetPerView[pipeline.second]->AddImage(0, binding, { { skyboxTexture->GetTextureSampler(), skyboxTexture->GetTextureImageView(), Image::Layout::SHADER_READ_ONLY_OPTIMAL } });
-				}
-				else if (name.find("SPECULARIRRADIANCE") == 0)
-				{
-					const Ref<Texture>& skyboxTexture = m_Skybox->GetGeneratedSpecularCubemap();
-					m_DescSetPerView[pipeline.second]->AddImage(0, binding, { { skyboxTexture->GetTextureSampler(), skyboxTexture->GetTextureImageView(), Image::Layout::SHADER_READ_ONLY_OPTIMAL } });
-				}
-				else if (name.find("SPECULARBRDF_LUT") == 0)
-				{
-					const Ref<Texture>& skyboxTexture = m_Skybox->GetGeneratedSpecularBRDF_LUT();
-					m_DescSetPerView[pipeline.second]->AddImage(0, binding, { { skyboxTexture->GetTextureSampler(), skyboxTexture->GetTextureImageView(), Image::Layout::SHADER_READ_ONLY_OPTIMAL } });
-				}
-			
-				
-				else
-					continue;
+	//Group the sub-meshes of GPU-driven models into batches.
+	std::map<std::tuple<const RenderPipeline*, const BufferView*, const BufferView*>, uint32_t> batchIndices;
+	std::vector<uint32_t> instanceBatchIndices;
+	for (auto& model : m_RenderQueue)
+	{
+		const Ref<graphics::RenderPipeline>& renderPipeline = FindOrNull(m_RenderPipelines, model->GetPipelineName());
+		if (m_GPUDrivenPipelines.find(renderPipeline.get()) == m_GPUDrivenPipelines.end())
+			continue;
+
+		const Ref<Mesh>& mesh = model->GetMesh();
+		for (auto& allocation : mesh->GetAllocations())
+		{
+			const Ref<BufferView>& vertexBufferView = mesh->GetMeshPool()->GetVertexBufferView(allocation->blockIndex);
+			const Ref<BufferView>& indexBufferView = mesh->GetMeshPool()->GetIndexBufferView(allocation->blockIndex);
+			auto it = batchIndices.find({ renderPipeline.get(), vertexBufferView.get(), indexBufferView.get() });
+			if (it == batchIndices.end())
+			{
+				it = batchIndices.insert({ { renderPipeline.get(), vertexBufferView.get(), indexBufferView.get() }, static_cast<uint32_t>(m_GPUDrivenBatches.size()) }).first;
+				m_GPUDrivenBatches.push_back({ renderPipeline, vertexBufferView, indexBufferView, 0, 0 });
 			}
-			m_DescSetPerView[pipeline.second]->Update();
+			m_GPUDrivenBatches[it->second].maxDrawCount++;
+			instanceBatchIndices.push_back(it->second);
 		}
+	}
+	if (m_GPUDrivenBatches.empty())
+		return;
 
-		//Per model Descriptor Sets
-		for (auto& model : m_RenderQueue)
+	if (!m_GPUDrivenCullPipeline)
+	{
+		RenderPipeline::LoadInfo cullPipelineLI;
+		cullPipelineLI.device = m_Device;
+		cullPipelineLI.filepath = "res/pipelines/GPUDrivenCull.grpf.json";
+		cullPipelineLI.viewportWidth = 0.0f;
+		cullPipelineLI.viewportHeight = 0.0f;
+		cullPipelineLI.renderPass = nullptr;
+		cullPipelineLI.subpassIndex = 0;
+		m_GPUDrivenCullPipeline = CreateRef<RenderPipeline>(&cullPipelineLI);
+
+		float zero[sizeof(CullInfoUB)] = { 0 };
+		m_CullInfoCI.debugName = "GEAR_CORE_Renderer_CullInfo";
+		m_CullInfoCI.device = m_Device;
+		m_CullInfoCI.data = zero;
+		m_CullInfoCI.perFrame = true;
+		m_CullInfo = CreateRef<Uniformbuffer<CullInfoUB>>(&m_CullInfoCI);
+
+		for (uint32_t i = 0; i < m_FramesInFlight; i++)
 		{
-			const std::vector<Ref<DescriptorSetLayout>>& descriptorSetLayouts = m_RenderPipelines[model->GetPipelineName()]->GetDescriptorSetLayouts();
-			const std::vector<std::vector<Shader::ResourceBindingDescription>> rbds = m_RenderPipelines[model->GetPipelineName()]->GetRBDs();
+			m_DrawInstancesCI.debugName = "GEAR_CORE_Renderer_DrawInstances: Frame " + std::to_string(i);
+			m_DrawInstancesCI.device = m_Device;
+			m_DrawInstancesCI.count = 0;
+			m_DrawInstancesCI.additionalUsage = Buffer::UsageBit(0);
+			m_DrawInstances.push_back(CreateRef<GrowableStoragebuffer<DrawInstance>>(&m_DrawInstancesCI));
+
+			m_DrawCommandsCI.debugName = "GEAR_CORE_Renderer_DrawCommands: Frame " + std::to_string(i);
+			m_DrawCommandsCI.device = m_Device;
+			m_DrawCommandsCI.count = 0;
+			m_DrawCommandsCI.additionalUsage = Buffer::UsageBit::INDIRECT_BIT;
+			m_DrawCommands.push_back(CreateRef<GrowableStoragebuffer<DrawIndexedIndirectCommand>>(&m_DrawCommandsCI));
+
+			m_DrawCountsCI.debugName = "GEAR_CORE_Renderer_DrawCounts: Frame " + std::to_string(i);
+			m_DrawCountsCI.device = m_Device;
+			m_DrawCountsCI.count = 0;
+			m_DrawCountsCI.additionalUsage = Buffer::UsageBit(0);
+			m_DrawCounts.push_back(CreateRef<GrowableStoragebuffer<uint32_t>>(&m_DrawCountsCI));
+		}
+	}
+	const Ref<GrowableStoragebuffer<DrawInstance>>& drawInstances = m_DrawInstances[m_FrameIndex];
+	const Ref<GrowableStoragebuffer<DrawIndexedIndirectCommand>>& drawCommands = m_DrawCommands[m_FrameIndex];
+	const Ref<GrowableStoragebuffer<uint32_t>>& drawCounts = m_DrawCounts[m_FrameIndex];
 
-			if (descriptorSetLayouts.empty() || rbds.empty())
-				continue;
+	//Each batch owns a range of draw commands large enough for all of its instances.
+	uint32_t batchOffset = 0;
+	for (GPUDrivenBatch& batch : m_GPUDrivenBatches)
+	{
+		batch.batchOffset = batchOffset;
+		batchOffset += batch.maxDrawCount;
+	}
 
-			DescriptorSet::CreateInfo descSetPerModelCI;
-			descSetPerModelCI.debugName = "GEAR_CORE_DescriptorSet_PerModel: " + model->GetDebugName();
-			descSetPerModelCI.pDescriptorPool = m_DescPool;
-			descSetPerModelCI.pDescriptorSetLayouts = { descriptorSetLayouts[1] };
-			m_DescSetPerModel[model] = DescriptorSet::Create(&descSetPerModelCI);
+	//The draw commands and counts are left zeroed on the CPU. Uploading them resets the results of this frame slot's
+	//previous use, so the unused tail of each range is made of zero instance draws.
+	const size_t instanceCount = instanceBatchIndices.size();
+	drawInstances->Resize(instanceCount);
+	drawCommands->Resize(instanceCount);
+	drawCounts->Resize(m_GPUDrivenBatches.size());
 
-			for (auto& rbd : rbds[1])
-			{
-				const uint32_t& binding = rbd.binding;
-				const std::string& name = arc::ToUpper(rbd.name);
-				if (rbd.structSize > 0)
-				{
-					if (SetUpdateTypeMap.find(name) == SetUpdateTypeMap.end())
-						continue;
-					if (SetUpdateTypeMap[name] != SetUpdateType::PER_MODEL)
-						continue;
+	size_t instanceIndex = 0;
+	for (auto& model : m_RenderQueue)
+	{
+		const Ref<graphics::RenderPipeline>& renderPipeline = FindOrNull(m_RenderPipelines, model->GetPipelineName());
+		if (m_GPUDrivenPipelines.find(renderPipeline.get()) == m_GPUDrivenPipelines.end())
+			continue;
 
-					if (name.compare("MODEL") == 0)
-					{
-						m_DescSetPerModel[model]->AddBuffer(0, binding, { { model->GetUB()->GetBufferView() } });
-					}
-					else
-						continue;
-				}
-			}
-			m_DescSetPerModel[model]->Update();
+		const Ref<Mesh>& mesh = model->GetMesh();
+		for (size_t i = 0; i < mesh->GetAllocations().size(); i++, instanceIndex++)
+		{
+			const MeshPool::Allocation& allocation = *mesh->GetAllocations()[i];
+			const uint32_t batchIndex = instanceBatchIndices[instanceIndex];
+			DrawInstance& drawInstance = (*drawInstances)[instanceIndex];
+			drawInstance.modl = model->GetUB()->modl;
+			drawInstance.boundingSphere = mesh->GetModelData().meshes[i].boundingSphere;
+			drawInstance.texCoordScale0 = model->GetUB()->texCoordScale0;
+			drawInstance.texCoordScale1 = model->GetUB()->texCoordScale1;
+			drawInstance.positionScale = model->GetUB()->positionScale;
+			drawInstance.positionOffset = model->GetUB()->positionOffset;
+			const Mesh::LevelOfDetail& levelOfDetail = mesh->GetLevelOfDetail(i, model->GetLevelOfDetail());
+			drawInstance.indexCount = levelOfDetail.indexCount;
+			drawInstance.firstIndex = allocation.firstIndex + levelOfDetail.firstIndex;
+			drawInstance.vertexOffset = static_cast<int32_t>(allocation.vertexOffset);
+			drawInstance.materialID = FindOrNull(m_BindlessMaterialIDs, mesh->GetMaterials()[i].get());
+			drawInstance.batchIndex = batchIndex;
+			drawInstance.batchOffset = m_GPUDrivenBatches[batchIndex].batchOffset;
 		}
+	}
+
+	const std::array<mars::Vec4, 6> frustumPlanes = m_Camera->GetFrustumPlanes();
+	for (size_t i = 0; i < frustumPlanes.size(); i++)
+		m_CullInfo->frustumPlanes[i] = frustumPlanes[i];
+	m_CullInfo->instanceCount = static_cast<uint32_t>(instanceCount);
+	m_CullInfo->batchCount = static_cast<uint32_t>(m_GPUDrivenBatches.size());
+	m_CullInfo->SubmitData();
+
+	drawInstances->SubmitData();
+	drawCommands->SubmitData();
+	drawCounts->SubmitData();
+}
+
+void Renderer::RecordGPUDrivenCull(const Ref<CommandBuffer>& cmdBuffer, uint32_t cmdBufferIndex)
+{
+	auto CreateBarrier = [](const Ref<Buffer>& buffer, Barrier::AccessBit srcAccess, Barrier::AccessBit dstAccess) -> Ref<Barrier>
+	{
+		Barrier::CreateInfo barrierCI;
+		barrierCI.type = Barrier::Type::BUFFER;
+		barrierCI.srcAccess = srcAccess;
+		barrierCI.dstAccess = dstAccess;
+		barrierCI.srcQueueFamilyIndex = MIRU_QUEUE_FAMILY_IGNORED;
+		barrierCI.dstQueueFamilyIndex = MIRU_QUEUE_FAMILY_IGNORED;
+		barrierCI.pBuffer = buffer;
+		barrierCI.offset = 0;
+		barrierCI.size = buffer->GetCreateInfo().size;
+		return Barrier::Create(&barrierCI);
+	};
+	const Barrier::AccessBit shaderReadWrite = Barrier::AccessBit::SHADER_READ_BIT | Barrier::AccessBit::SHADER_WRITE_BIT;
+
+	//The buffers belong to this frame slot, whose previous cull pass and draws have completed, as its draw fence has been waited on.
+	const Ref<GrowableStoragebuffer<DrawInstance>>& drawInstances = m_DrawInstances[m_FrameIndex];
+	const Ref<GrowableStoragebuffer<DrawIndexedIndirectCommand>>& drawCommands = m_DrawCommands[m_FrameIndex];
+	const Ref<GrowableStoragebuffer<uint32_t>>& drawCounts = m_DrawCounts[m_FrameIndex];
+	drawInstances->Upload(cmdBuffer, cmdBufferIndex);
+	drawCommands->Upload(cmdBuffer, cmdBufferIndex);
+	drawCounts->Upload(cmdBuffer, cmdBufferIndex);
+
+	cmdBuffer->PipelineBarrier(cmdBufferIndex, PipelineStageBit::TRANSFER_BIT, PipelineStageBit::COMPUTE_SHADER_BIT | PipelineStageBit::VERTEX_SHADER_BIT, DependencyBit::NONE_BIT, {
+		CreateBarrier(drawInstances->GetBuffer(), Barrier::AccessBit::TRANSFER_WRITE_BIT, Barrier::AccessBit::SHADER_READ_BIT),
+		CreateBarrier(drawCommands->GetBuffer(), Barrier::AccessBit::TRANSFER_WRITE_BIT, shaderReadWrite),
+		CreateBarrier(drawCounts->GetBuffer(), Barrier::AccessBit::TRANSFER_WRITE_BIT, shaderReadWrite) });
+
+	const Ref<Pipeline>& pipeline = m_GPUDrivenCullPipeline->GetPipeline();
+	cmdBuffer->BindPipeline(cmdBufferIndex, pipeline);
+	cmdBuffer->BindDescriptorSets(cmdBufferIndex, { m_DescSetCull[m_FrameIndex] }, pipeline);
+	cmdBuffer->Dispatch(cmdBufferIndex, (static_cast<uint32_t>(drawInstances->GetCount()) + 63) / 64, 1, 1);
+
+	cmdBuffer->PipelineBarrier(cmdBufferIndex, PipelineStageBit::COMPUTE_SHADER_BIT, PipelineStageBit::DRAW_INDIRECT_BIT, DependencyBit::NONE_BIT, {
+		CreateBarrier(drawCommands->GetBuffer(), Barrier::AccessBit::SHADER_WRITE_BIT, Barrier::AccessBit::INDIRECT_COMMAND_READ_BIT) });
+}
 
-		//Per material Descriptor Sets
-		for (auto& model : m_RenderQueue)
+void Renderer::RecordGPUDrivenDrawCalls(const Ref<CommandBuffer>& cmdBuffer, uint32_t cmdBufferIndex, Statistics& statistics)
+{
+	//One indirect draw per batch. Batches of the same pipeline are adjacent, as the batch map is ordered by pipeline first.
+	const Pipeline* boundPipeline = nullptr;
+	for (const GPUDrivenBatch& batch : m_GPUDrivenBatches)
+	{
+		const Ref<Pipeline>& pipeline = batch.renderPipeline->GetPipeline();
+		if (boundPipeline != pipeline.get())
 		{
-			const std::vector<Ref<DescriptorSetLayout>>& descriptorSetLayouts = m_RenderPipelines[model->GetPipelineName()]->GetDescriptorSetLayouts();
-			const std::vector<std::vector<Shader::ResourceBindingDescription>> rbds = m_RenderPipelines[model->GetPipelineName()]->GetRBDs();
-			
-			if (descriptorSetLayouts.empty() || rbds.empty())
+			cmdBuffer->BindPipeline(cmdBufferIndex, pipeline);
+			cmdBuffer->BindDescriptorSets(cmdBufferIndex, { 
+				FindOrNull(m_DescSetPerView, batch.renderPipeline, m_FrameIndex), 
+				FindOrNull(m_DescSetDrawInstances, batch.renderPipeline, m_FrameIndex), 
+				FindOrNull(m_DescSetBindless, batch.renderPipeline, m_FrameIndex) }, pipeline);
+			boundPipeline = pipeline.get();
+		}
+
+		cmdBuffer->BindVertexBuffers(cmdBufferIndex, { batch.vertexBufferView });
+		cmdBuffer->BindIndexBuffer(cmdBufferIndex, batch.indexBufferView);
+		cmdBuffer->DrawIndexedIndirect(cmdBufferIndex, m_DrawCommands[m_FrameIndex]->GetBuffer(), batch.batchOffset * sizeof(DrawIndexedIndirectCommand), batch.maxDrawCount, sizeof(DrawIndexedIndirectCommand));
+		statistics.indirectDrawCalls++;
+	}
+}
+
+void Renderer::CullDrawInstances(const UniformBufferStructures::CullInfo& cullInfo, const UniformBufferStructures::DrawInstance* drawInstances, 
+	UniformBufferStructures::DrawIndexedIndirectCommand* drawCommands, uint32_t* drawCounts)
+{
+	for (uint32_t instanceIndex = 0; instanceIndex < cullInfo.instanceCount; instanceIndex++)
+	{
+		const DrawInstance& instance = drawInstances[instanceIndex];
+		const mars::Mat4& modl = instance.modl;
+		const mars::Vec4 centre = modl * mars::Vec4(instance.boundingSphere.x, instance.boundingSphere.y, instance.boundingSphere.z, 1.0f);
+		const float scale = std::sqrt(std::max(std::max(
+			modl.a * modl.a + modl.e * modl.e + modl.i * modl.i,
+			modl.b * modl.b + modl.f * modl.f + modl.j * modl.j),
+			modl.c * modl.c + modl.g * modl.g + modl.k * modl.k));
+		const float radius = instance.boundingSphere.w * scale;
+
+		bool visible = true;
+		for (const mars::Vec4& plane : cullInfo.frustumPlanes)
+			visible &= plane.x * centre.x + plane.y * centre.y + plane.z * centre.z + plane.w >= -radius;
+		if (!visible)
+			continue;
+
+		const uint32_t slot = drawCounts[instance.batchIndex]++;
+		drawCommands[instance.batchOffset + slot] = { instance.indexCount, 1, instance.firstIndex, instance.vertexOffset, instanceIndex };
+	}
+}
+
+void Renderer::UpdateBindlessMaterials()
+{
+	m_BindlessPipelines.clear();
+	for (auto& renderPipeline : m_RenderPipelines)
+	{
+		const std::vector<std::vector<Shader::ResourceBindingDescription>>& rbds = renderPipeline.second->GetRBDs();
+		if (rbds.size() < 3)
+			continue;
+
+		for (auto& rbd : rbds[2])
+		{
+			if (arc::ToUpper(rbd.name).find("BINDLESSMATERIALS") == 0)
+				m_BindlessPipelines.insert(renderPipeline.second.get());
+		}
+	}
+	if (m_BindlessPipelines.empty())
+		return;
+
+	if (m_BindlessMaterials.empty())
+	{
+		m_BindlessMaterialsData = CreateScope<BindlessMaterialsSB>();
+		memset(m_BindlessMaterialsData.get(), 0, sizeof(BindlessMaterialsSB));
+		for (uint32_t i = 0; i < m_FramesInFlight; i++)
+		{
+			m_BindlessMaterialsCI.debugName = "GEAR_CORE_Renderer_BindlessMaterials: Frame " + std::to_string(i);
+			m_BindlessMaterialsCI.device = m_Device;
+			m_BindlessMaterialsCI.data = nullptr;
+			m_BindlessMaterials.push_back(CreateRef<Storagebuffer<BindlessMaterialsSB>>(&m_BindlessMaterialsCI));
+		}
+		m_BindlessMaterialsStale.resize(m_FramesInFlight, true);
+	}
+
+	//Release the retired textures, which are no longer in the descriptor sets of any frame in flight.
+	while (!m_RetiredBindlessTextures.empty() && m_FrameCount - m_RetiredBindlessTextures.front().second > m_FramesInFlight)
+		m_RetiredBindlessTextures.pop_front();
+
+	//Assign IDs to new materials.
+	for (auto& model : m_RenderQueue)
+	{
+		const Ref<graphics::RenderPipeline>& renderPipeline = FindOrNull(m_RenderPipelines, model->GetPipelineName());
+		if (m_BindlessPipelines.find(renderPipeline.get()) == m_BindlessPipelines.end())
+			continue;
+
+		for (auto& material : model->GetMesh()->GetMaterials())
+		{
+			if (m_BindlessMaterialIDs.find(material.get()) != m_BindlessMaterialIDs.end())
 				continue;
 
-			for (auto& material : model->GetMesh()->GetMaterials())
+			uint32_t materialID = static_cast<uint32_t>(m_BindlessMaterialIDs.size());
+			if (!m_FreeBindlessMaterialIDs.empty())
+			{
+				materialID = m_FreeBindlessMaterialIDs.back();
+				m_FreeBindlessMaterialIDs.pop_back();
+			}
+			if (materialID >= UniformBufferStructures::MAX_BINDLESS_MATERIALS)
 			{
-				DescriptorSet::CreateInfo descSetPerMaterialCI;
-				descSetPerMaterialCI.debugName = "GEAR_CORE_DescriptorSet_PerMaterial: " + material->GetDebugName();
-				descSetPerMaterialCI.pDescriptorPool = m_DescPool;
-				descSetPerMaterialCI.pDescriptorSetLayouts = { descriptorSetLayouts[2] };
-				m_DescSetPerMaterial[material] = DescriptorSet::Create(&descSetPerMaterialCI);
+				GEAR_ASSERT(ErrorCode::GRAPHICS | ErrorCode::INVALID_VALUE, "Too many bindless materials. The maximum is %u.", UniformBufferStructures::MAX_BINDLESS_MATERIALS);
+				continue;
+			}
+			m_BindlessMaterialIDs[material.get()] = materialID;
+			m_BindlessMaterialsChanged = true;
+			material->AddDestroyCallback(this, [this](const Material* material) { OnMaterialDestroyed(material); });
+		}
+	}
 
-				for (auto& rbd : rbds[2])
-				{
-					const uint32_t& binding = rbd.binding;
-					const std::string& name = arc::ToUpper(rbd.name);
-					if (rbd.structSize > 0)
-					{
-						if (SetUpdateTypeMap.find(name) == SetUpdateTypeMap.end())
-							continue;
-						if (SetUpdateTypeMap[name] != SetUpdateType::PER_MATERIAL)
-							continue;
-					}
-					
-					if (name.compare("SKYBOXINFO") == 0)
-					{
-						const Ref<Material>& material = m_Skybox->GetModel()->GetMesh()->GetMaterials()[0];
-						m_DescSetPerMaterial[material]->AddBuffer(0, binding, { { m_Skybox->GetUB()->GetBufferView() } });
-					}
-					else if (name.find("SKYBOX") == 0)
-					{
-						const Ref<Material>& material = m_Skybox->GetModel()->GetMesh()->GetMaterials()[0];
-						const Ref<Texture>& skyboxTexture = m_Skybox->GetGeneratedCubemap();
-						m_DescSetPerMaterial[material]->AddImage(0, binding, { { skyboxTexture->GetTextureSampler(), skyboxTexture->GetTextureImageView(), Image::Layout::SHADER_READ_ONLY_OPTIMAL } });
-					}
+	//Copy the texture IDs and the PBRConstants of all materials, as streamed textures replace their placeholders and
+	//the constants can be changed with Material::Update().
+	for (auto& bindlessMaterialID : m_BindlessMaterialIDs)
+	{
+		const Material* material = bindlessMaterialID.first;
+		UniformBufferStructures::BindlessMaterial& bindlessMaterial = m_BindlessMaterialsData->materials[bindlessMaterialID.second];
+		const UniformBufferStructures::BindlessMaterial previousBindlessMaterial = bindlessMaterial;
+		bindlessMaterial.textureIndices0.x = GetBindlessTextureID(GetResidentTexture(material, Material::TextureType::NORMAL));
+		bindlessMaterial.textureIndices0.y = GetBindlessTextureID(GetResidentTexture(material, Material::TextureType::ALBEDO));
+		bindlessMaterial.textureIndices0.z = GetBindlessTextureID(GetResidentTexture(material, Material::TextureType::METALLIC));
+		bindlessMaterial.textureIndices0.w = GetBindlessTextureID(GetResidentTexture(material, Material::TextureType::ROUGHNESS));
+		bindlessMaterial.textureIndices1.x = GetBindlessTextureID(GetResidentTexture(material, Material::TextureType::AMBIENT_OCCLUSION));
+		bindlessMaterial.textureIndices1.y = GetBindlessTextureID(GetResidentTexture(material, Material::TextureType::EMISSIVE));
+		if (memcmp(&previousBindlessMaterial, &bindlessMaterial, sizeof(UniformBufferStructures::BindlessMaterial)) != 0)
+			m_BindlessMaterialsChanged = true;
+
+		const UniformBufferStructures::PBRConstants& pbrConstants = *material->GetUB();
+		UniformBufferStructures::PBRConstants& dstPBRConstants = bindlessMaterial.pbrConstants;
+		if (memcmp(&dstPBRConstants, &pbrConstants, sizeof(UniformBufferStructures::PBRConstants)) != 0)
+		{
+			memcpy(&dstPBRConstants, &pbrConstants, sizeof(UniformBufferStructures::PBRConstants));
+			m_BindlessMaterialsChanged = true;
+		}
+	}
 
-					else if (name.find("FONTATLAS") == 0)
-					{
-						const Ref<Texture>& texture = material->GetTextures()[Material::TextureType::ALBEDO];
-						m_DescSetPerMaterial[material]->AddImage(0, binding, { { texture->GetTextureSampler(), texture->GetTextureImageView(), Image::Layout::SHADER_READ_ONLY_OPTIMAL } });
-					}
+	//Free the IDs of textures that no material in the table references. The IDs of materials are freed by their destroy callbacks.
+	std::vector<bool> referencedTextureIDs(m_BindlessTextures.size(), false);
+	for (auto& bindlessMaterialID : m_BindlessMaterialIDs)
+	{
+		const UniformBufferStructures::BindlessMaterial& bindlessMaterial = m_BindlessMaterialsData->materials[bindlessMaterialID.second];
+		for (uint32_t textureID : { bindlessMaterial.textureIndices0.x, bindlessMaterial.textureIndices0.y, bindlessMaterial.textureIndices0.z, bindlessMaterial.textureIndices0.w,
+			bindlessMaterial.textureIndices1.x, bindlessMaterial.textureIndices1.y })
+		{
+			if (textureID < referencedTextureIDs.size())
+				referencedTextureIDs[textureID] = true;
+		}
+	}
+	for (uint32_t i = 0; i < static_cast<uint32_t>(m_BindlessTextures.size()); i++)
+	{
+		if (m_BindlessTextures[i] && !referencedTextureIDs[i])
+		{
+			m_BindlessTextureIDs.erase(m_BindlessTextures[i].get());
+			m_RetiredBindlessTextures.push_back({ std::move(m_BindlessTextures[i]), m_FrameCount });
+			m_BindlessTextures[i] = nullptr;
+			m_FreeBindlessTextureIDs.push_back(i);
+			m_BindlessTexturesChanged = true;
+		}
+	}
 
-					else if (name.compare("PBRCONSTANTS") == 0)
-					{
-						m_DescSetPerMaterial[material]->AddBuffer(0, binding, { { material->GetUB()->GetBufferView() } });
-					}
-					else if (name.find("NORMAL") == 0)
-					{
-						const Ref<Texture>& texture = material->GetTextures()[Material::TextureType::NORMAL];
-						m_DescSetPerMaterial[material]->AddImage(0, binding, { {texture->GetTextureSampler(), texture->GetTextureImageView(), Image::Layout::SHADER_READ_ONLY_OPTIMAL } }); continue;
-					}
-					else if (name.find("ALBEDO") == 0)
-					{
-						const Ref<Texture>& texture = material->GetTextures()[Material::TextureType::ALBEDO];
-						m_DescSetPerMaterial[material]->AddImage(0, binding, { {texture->GetTextureSampler(), texture->GetTextureImageView(), Image::Layout::SHADER_READ_ONLY_OPTIMAL } }); continue;
-					}
-					else if (name.find("METALLIC") == 0)
-					{
-						const Ref<Texture>& texture = material->GetTextures()[Material::TextureType::METALLIC];
-						m_DescSetPerMaterial[material]->AddImage(0, binding, { {texture->GetTextureSampler(), texture->GetTextureImageView(), Image::Layout::SHADER_READ_ONLY_OPTIMAL } }); continue;
-					}
-					else if (name.find("ROUGHNESS") == 0)
-					{
-						const Ref<Texture>& texture = material->GetTextures()[Material::TextureType::ROUGHNESS];
-						m_DescSetPerMaterial[material]->AddImage(0, binding, { {texture->GetTextureSampler(), texture->GetTextureImageView(), Image::Layout::SHADER_READ_ONLY_OPTIMAL } }); continue;
-					}
-					else if (name.find("AMBIENTOCCLUSION") == 0)
-					{
-						const Ref<Texture>& texture = material->GetTextures()[Material::TextureType::AMBIENT_OCCLUSION];
-						m_DescSetPerMaterial[material]->AddImage(0, binding, { {texture->GetTextureSampler(), texture->GetTextureImageView(), Image::Layout::SHADER_READ_ONLY_OPTIMAL } }); continue;
-					}
-					else if (name.find("EMISSIVE") == 0)
-					{
-						const Ref<Texture>& texture = material->GetTextures()[Material::TextureType::EMISSIVE];
-						m_DescSetPerMaterial[material]->AddImage(0, binding, { {texture->GetTextureSampler(), texture->GetTextureImageView(), Image::Layout::SHADER_READ_ONLY_OPTIMAL } }); continue;
-					}
-					else
-						continue;
-				
-				}
-				m_DescSetPerMaterial[material]->Update();
+	//Only this frame's copy is rewritten. The copies of the other frames are rewritten in their turn.
+	if (m_BindlessMaterialsChanged)
+		m_BindlessMaterialsStale.assign(m_FramesInFlight, true);
+	m_BindlessMaterialsChanged = m_BindlessMaterialsStale[m_FrameIndex];
+	if (m_BindlessMaterialsChanged)
+	{
+		m_BindlessMaterials[m_FrameIndex]->SubmitData(m_BindlessMaterialsData.get(), sizeof(BindlessMaterialsSB));
+		m_BindlessMaterialsStale[m_FrameIndex] = false;
+	}
+}
+
+const Ref<Texture>& Renderer::GetResidentTexture(const Material* material, Material::TextureType type)
+{
+	//Textures still queued by the TextureStreamer are replaced by the default texture of the type.
+	const Ref<Texture>& texture = FindOrNull(material->GetTextures(), type);
+	return texture && !texture->m_PreUpload ? texture : Material::GetDefaultTexture(type);
+}
+
+std::string Renderer::GetMaterialKey(const Material* material)
+{
+	//The resident textures and the constants, which are all that the per material writes depend on.
+	std::string key;
+	for (Material::TextureType type : { Material::TextureType::NORMAL, Material::TextureType::ALBEDO, Material::TextureType::METALLIC, 
+		Material::TextureType::ROUGHNESS, Material::TextureType::AMBIENT_OCCLUSION, Material::TextureType::EMISSIVE })
+	{
+		const Texture* texture = GetResidentTexture(material, type).get();
+		key.append(reinterpret_cast<const char*>(&texture), sizeof(texture));
+	}
+	const UniformBufferStructures::PBRConstants& pbrConstants = *material->GetUB();
+	key.append(reinterpret_cast<const char*>(&pbrConstants), sizeof(UniformBufferStructures::PBRConstants));
+	return key;
+}
+
+void Renderer::OnModelDestroyed(const Model* model)
+{
+	auto it = m_DescSetPerModel.find(model);
+	if (it == m_DescSetPerModel.end())
+		return;
+
+	for (auto& descSet : it->second)
+	{
+		if (descSet)
+			m_DescAllocator->Release(descSet);
+	}
+	m_DescSetPerModel.erase(it);
+}
+
+void Renderer::OnMaterialDestroyed(const Material* material)
+{
+	//Sets of other materials that are written with the constants of this one are reacquired when they are next used.
+	for (auto& descSetsPerMaterial : m_DescSetPerMaterial)
+	{
+		for (auto& descSet : descSetsPerMaterial.second)
+		{
+			if (descSet.set && (descSetsPerMaterial.first == material || descSet.constantsMaterial == material))
+			{
+				m_DescAllocator->Release(descSet.set);
+				descSet = MaterialDescriptorSet();
 			}
 		}
+	}
+	m_DescSetPerMaterial.erase(material);
 
-		m_BuiltDescPoolsAndSets = true;
+	auto it = m_BindlessMaterialIDs.find(material);
+	if (it != m_BindlessMaterialIDs.end())
+	{
+		m_FreeBindlessMaterialIDs.push_back(it->second);
+		m_BindlessMaterialIDs.erase(it);
 	}
+}
 
-	//Record Present CmdBuffers
-	m_DrawFences[m_FrameIndex]->Wait();
+uint32_t Renderer::GetBindlessTextureID(const Ref<Texture>& texture)
+{
+	if (!texture)
+		return 0;
+
+	auto it = m_BindlessTextureIDs.find(texture.get());
+	if (it != m_BindlessTextureIDs.end())
+		return it->second;
+
+	uint32_t textureID = static_cast<uint32_t>(m_BindlessTextures.size());
+	if (!m_FreeBindlessTextureIDs.empty())
 	{
-		m_CmdBuffer->Reset(m_FrameIndex, false);
-		m_CmdBuffer->Begin(m_FrameIndex, CommandBuffer::UsageBit::SIMULTANEOUS);
-		m_CmdBuffer->BeginRenderPass(m_FrameIndex, m_Framebuffers[m_FrameIndex], { {0.25f, 0.25f, 0.25f, 1.0f}, {1.0f, 0} });
+		textureID = m_FreeBindlessTextureIDs.back();
+		m_FreeBindlessTextureIDs.pop_back();
+	}
+	if (textureID >= m_MaxBindlessTextures)
+	{
+		GEAR_ASSERT(ErrorCode::GRAPHICS | ErrorCode::INVALID_VALUE, "Too many bindless textures. The maximum is %u.", m_MaxBindlessTextures);
+		return 0;
+	}
 
-		for (auto& model : m_RenderQueue)
+	if (textureID == m_BindlessTextures.size())
+		m_BindlessTextures.push_back(texture);
+	else
+		m_BindlessTextures[textureID] = texture;
+	m_BindlessTextureIDs[texture.get()] = textureID;
+	m_BindlessTexturesChanged = true;
+	return textureID;
+}
+
+uint32_t Renderer::GetDeviceBindlessTextureLimit(const std::vector<std::vector<Shader::ResourceBindingDescription>>& rbds, const Shader::ResourceBindingDescription& bindlessTexturesRBD) const
+{
+	//Count the pipeline's other descriptors, which share the per stage and per set limits with the array.
+	uint32_t otherSampledImages = 0;
+	uint32_t otherSamplers = 0;
+	uint32_t otherResources = 0;
+	for (auto& set : rbds)
+	{
+		for (auto& rbd : set)
 		{
-			const Ref<graphics::RenderPipeline>& renderPipeline = m_RenderPipelines[model->GetPipelineName()];
-			const Ref<Pipeline>& pipeline = renderPipeline->GetPipeline();
+			if (&rbd == &bindlessTexturesRBD)
+				continue;
+
+			if (rbd.type == DescriptorType::COMBINED_IMAGE_SAMPLER || rbd.type == DescriptorType::SAMPLED_IMAGE)
+				otherSampledImages += rbd.descriptorCount;
+			if (rbd.type == DescriptorType::COMBINED_IMAGE_SAMPLER || rbd.type == DescriptorType::SAMPLER)
+				otherSamplers += rbd.descriptorCount;
+			if (rbd.type != DescriptorType::SAMPLER)
+				otherResources += rbd.descriptorCount;
+		}
+	}
+
+	uint32_t maxSampledImages = 0;
+	uint32_t maxSamplers = 0;
+	uint32_t maxResources = 0;
+	if (GraphicsAPI::IsVulkan())
+	{
+		const Ref<vulkan::Context>& context = ref_cast<vulkan::Context>(m_Context);
+		const VkPhysicalDeviceLimits& limits = context->m_PhysicalDevices.m_PhysicalDeviceProperties[0].limits;
+		maxSampledImages = std::min(limits.maxPerStageDescriptorSampledImages, limits.maxDescriptorSetSampledImages);
+		maxSamplers = std::min(limits.maxPerStageDescriptorSamplers, limits.maxDescriptorSetSamplers);
+		maxResources = limits.maxPerStageResources;
+
+		//Update after bind layouts have their own limits, which are respected too in case the array is created with them.
+		if (context->m_PhysicalDevices.m_PhysicalDeviceProperties[0].apiVersion >= VK_API_VERSION_1_2)
+		{
+			VkPhysicalDeviceDescriptorIndexingProperties descriptorIndexingProperties = {};
+			descriptorIndexingProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+			VkPhysicalDeviceProperties2 properties = {};
+			properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+			properties.pNext = &descriptorIndexingProperties;
+			vkGetPhysicalDeviceProperties2(context->m_PhysicalDevices.m_PhysicalDevices[0], &properties);
+
+			maxSampledImages = std::min({ maxSampledImages, descriptorIndexingProperties.maxPerStageDescriptorUpdateAfterBindSampledImages, descriptorIndexingProperties.maxDescriptorSetUpdateAfterBindSampledImages });
+			maxSamplers = std::min({ maxSamplers, descriptorIndexingProperties.maxPerStageDescriptorUpdateAfterBindSamplers, descriptorIndexingProperties.maxDescriptorSetUpdateAfterBindSamplers });
+			maxResources = std::min(maxResources, descriptorIndexingProperties.maxPerStageUpdateAfterBindResources);
+		}
+	}
+	else
+	{
+		//Tier 1 binds a fixed number of SRVs and samplers per stage. Higher tiers are limited by the shader visible heaps.
+		D3D12_FEATURE_DATA_D3D12_OPTIONS options = {};
+		reinterpret_cast<ID3D12Device*>(m_Device)->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS, &options, sizeof(options));
+		if (options.ResourceBindingTier == D3D12_RESOURCE_BINDING_TIER_1)
+		{
+			maxSampledImages = D3D12_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT;
+			maxSamplers = D3D12_COMMONSHADER_SAMPLER_SLOT_COUNT;
+		}
+		else
+		{
+			maxSampledImages = D3D12_MAX_SHADER_VISIBLE_DESCRIPTOR_HEAP_SIZE_TIER_1;
+			maxSamplers = D3D12_MAX_SHADER_VISIBLE_SAMPLER_HEAP_SIZE;
+		}
+		maxResources = maxSampledImages;
+	}
+
+	//Combined image samplers count against both the sampled image and the sampler limits.
+	auto Remaining = [](uint32_t limit, uint32_t used) -> uint32_t { return limit > used ? limit - used : 0; };
+	uint32_t limit = Remaining(maxSampledImages, otherSampledImages);
+	if (bindlessTexturesRBD.type == DescriptorType::COMBINED_IMAGE_SAMPLER)
+		limit = std::min(limit, Remaining(maxSamplers, otherSamplers));
+	limit = std::min(limit, Remaining(maxResources, otherResources));
+	return limit;
+}
+
+void Renderer::UpdateDescriptorSets()
+{
+	m_DescAllocator->NextFrame();
+
+	//Per view Descriptor Sets
+	for (auto& pipeline : m_RenderPipelines)
+	{
+		const std::vector<Ref<DescriptorSetLayout>>& descriptorSetLayouts = pipeline.second->GetDescriptorSetLayouts();
+		if (descriptorSetLayouts.size() < 1)
+			continue;
+
+		std::vector<Ref<DescriptorSet>>& descSetsPerView = m_DescSetPerView[pipeline.second];
+		descSetsPerView.resize(m_FramesInFlight);
+		if (descSetsPerView[m_FrameIndex])
+			continue;
+
+		descSetsPerView[m_FrameIndex] = m_DescAllocator->Acquire(descriptorSetLayouts[0], GetDescriptorWrites(pipeline.second, 0, nullptr, nullptr),
+			"GEAR_CORE_DescriptorSet_PerView: " + pipeline.second->GetPipeline()->GetCreateInfo().debugName);
+	}
+
+	//Bindless Descriptor Sets, one per frame in flight as they reference the frame's material table. All of them are
+	//released when the texture table changes, and each is reacquired in its frame's turn.
+	for (auto& renderPipeline : m_RenderPipelines)
+	{
+		if (m_BindlessPipelines.find(renderPipeline.second.get()) == m_BindlessPipelines.end() || m_BindlessTextureIDs.empty())
+			continue;
+
+		std::vector<Ref<DescriptorSet>>& descSetsBindless = m_DescSetBindless[renderPipeline.second];
+		descSetsBindless.resize(m_FramesInFlight);
+		if (m_BindlessTexturesChanged)
+		{
+			for (auto& descSetBindless : descSetsBindless)
+			{
+				if (descSetBindless)
+					m_DescAllocator->Release(descSetBindless);
+				descSetBindless = nullptr;
+			}
+		}
+		if (descSetsBindless[m_FrameIndex])
+			continue;
+
+		descSetsBindless[m_FrameIndex] = m_DescAllocator->Acquire(renderPipeline.second->GetDescriptorSetLayouts()[2], GetDescriptorWrites(renderPipeline.second, 2, nullptr, nullptr),
+			"GEAR_CORE_DescriptorSet_Bindless: " + renderPipeline.second->GetPipeline()->GetCreateInfo().debugName + ": Frame " + std::to_string(m_FrameIndex));
+	}
+	m_BindlessTexturesChanged = false;
+
+	//GPU-driven Descriptor Sets, reacquired every frame as the storage buffers may have been reallocated. Unchanged sets are found in the cache.
+	if (!m_GPUDrivenBatches.empty())
+	{
+		for (auto& renderPipeline : m_RenderPipelines)
+		{
+			if (m_GPUDrivenPipelines.find(renderPipeline.second.get()) == m_GPUDrivenPipelines.end())
+				continue;
+
+			std::vector<Ref<DescriptorSet>>& descSetsDrawInstances = m_DescSetDrawInstances[renderPipeline.second];
+			descSetsDrawInstances.resize(m_FramesInFlight);
+			Ref<DescriptorSet>& descSetDrawInstances = descSetsDrawInstances[m_FrameIndex];
+			Ref<DescriptorSet> previousDescSet = descSetDrawInstances;
+			descSetDrawInstances = m_DescAllocator->Acquire(renderPipeline.second->GetDescriptorSetLayouts()[1], GetDescriptorWrites(renderPipeline.second, 1, nullptr, nullptr),
+				"GEAR_CORE_DescriptorSet_DrawInstances: " + renderPipeline.second->GetPipeline()->GetCreateInfo().debugName);
+			if (previousDescSet)
+				m_DescAllocator->Release(previousDescSet);
+		}
+
+		m_DescSetCull.resize(m_FramesInFlight);
+		Ref<DescriptorSet> previousDescSet = m_DescSetCull[m_FrameIndex];
+		m_DescSetCull[m_FrameIndex] = m_DescAllocator->Acquire(m_GPUDrivenCullPipeline->GetDescriptorSetLayouts()[0], {
+			{ 0, { { m_CullInfo->GetBufferView() } }, {} },
+			{ 1, { { m_DrawInstances[m_FrameIndex]->GetBufferView() } }, {} },
+			{ 2, { { m_DrawCommands[m_FrameIndex]->GetBufferView() } }, {} },
+			{ 3, { { m_DrawCounts[m_FrameIndex]->GetBufferView() } }, {} } },
+			"GEAR_CORE_DescriptorSet_GPUDrivenCull: Frame " + std::to_string(m_FrameIndex));
+		if (previousDescSet)
+			m_DescAllocator->Release(previousDescSet);
+	}
 
-			m_CmdBuffer->BindPipeline(m_FrameIndex, pipeline);
+	//Per model and per material Descriptor Sets, allocated the first time they are submitted. Per material sets are
+	//reacquired when the material's key or the material whose constants they bind changes. A material keeps binding
+	//the constants of the same material for as long as their keys match, so that the sharing is stable across frames.
+	std::map<std::string, const Material*> constantsMaterials;
+	for (auto& model : m_RenderQueue)
+	{
+		const Ref<graphics::RenderPipeline>& renderPipeline = FindOrNull(m_RenderPipelines, model->GetPipelineName());
+		if (!renderPipeline)
+			continue;
 
-			for (size_t i = 0; i < model->GetMesh()->GetVertexBuffers().size(); i++)
+		const std::vector<Ref<DescriptorSetLayout>>& descriptorSetLayouts = renderPipeline->GetDescriptorSetLayouts();
+		if (m_GPUDrivenPipelines.find(renderPipeline.get()) != m_GPUDrivenPipelines.end())
+			continue;
+
+		if (descriptorSetLayouts.size() > 1)
+		{
+			std::vector<Ref<DescriptorSet>>& descSetsPerModel = m_DescSetPerModel[model.get()];
+			if (descSetsPerModel.empty())
+				model->AddDestroyCallback(this, [this](const Model* model) { OnModelDestroyed(model); });
+			descSetsPerModel.resize(m_FramesInFlight);
+			if (!descSetsPerModel[m_FrameIndex])
 			{
-				Ref<objects::Material> material = model->GetMesh()->GetMaterials()[i];
-				m_CmdBuffer->BindDescriptorSets(m_FrameIndex, { m_DescSetPerView[renderPipeline], m_DescSetPerModel[model], m_DescSetPerMaterial[material] }, pipeline);
-				
-				m_CmdBuffer->BindVertexBuffers(m_FrameIndex, { model->GetMesh()->GetVertexBuffers()[i]->GetVertexBufferView() });
-				m_CmdBuffer->BindIndexBuffer(m_FrameIndex, model->GetMesh()->GetIndexBuffers()[i]->GetIndexBufferView());
+				descSetsPerModel[m_FrameIndex] = m_DescAllocator->Acquire(descriptorSetLayouts[1], GetDescriptorWrites(renderPipeline, 1, model, nullptr),
+					"GEAR_CORE_DescriptorSet_PerModel: " + model->GetDebugName());
+			}
+		}
+
+		if (descriptorSetLayouts.size() < 3 || m_BindlessPipelines.find(renderPipeline.get()) != m_BindlessPipelines.end())
+			continue;
 
-				m_CmdBuffer->DrawIndexed(m_FrameIndex, model->GetMesh()->GetIndexBuffers()[i]->GetCount());
+		for (auto& material : model->GetMesh()->GetMaterials())
+		{
+			std::vector<MaterialDescriptorSet>& descSetsPerMaterial = m_DescSetPerMaterial[material.get()];
+			if (descSetsPerMaterial.empty())
+				material->AddDestroyCallback(this, [this](const Material* material) { OnMaterialDestroyed(material); });
+			descSetsPerMaterial.resize(m_FramesInFlight);
+			MaterialDescriptorSet& descSetPerMaterial = descSetsPerMaterial[m_FrameIndex];
+
+			const std::string key = GetMaterialKey(material.get());
+			auto it = constantsMaterials.find(key);
+			if (it == constantsMaterials.end())
+			{
+				const bool keepConstantsMaterial = descSetPerMaterial.set && descSetPerMaterial.key == key && GetMaterialKey(descSetPerMaterial.constantsMaterial) == key;
+				it = constantsMaterials.insert({ key, keepConstantsMaterial ? descSetPerMaterial.constantsMaterial : material.get() }).first;
 			}
+			if (descSetPerMaterial.set && descSetPerMaterial.key == key && descSetPerMaterial.constantsMaterial == it->second)
+				continue;
+
+			if (descSetPerMaterial.set)
+				m_DescAllocator->Release(descSetPerMaterial.set);
+			descSetPerMaterial.set = m_DescAllocator->Acquire(descriptorSetLayouts[2], GetDescriptorWrites(renderPipeline, 2, model, it->second),
+				"GEAR_CORE_DescriptorSet_PerMaterial: " + material->GetDebugName());
+			descSetPerMaterial.constantsMaterial = it->second;
+			descSetPerMaterial.key = key;
 		}
+	}
+}
 
-		DrawCoordinateAxes();
+const Ref<DescriptorSet>& Renderer::GetDescriptorSetPerMaterial(const Material* material) const
+{
+	static const Ref<DescriptorSet> null = nullptr;
+	auto it = m_DescSetPerMaterial.find(material);
+	return it != m_DescSetPerMaterial.end() && m_FrameIndex < it->second.size() ? it->second[m_FrameIndex].set : null;
+}
 
-		m_CmdBuffer->EndRenderPass(m_FrameIndex);
-		m_CmdBuffer->End(m_FrameIndex);
+std::vector<DescriptorAllocator::Write> Renderer::GetDescriptorWrites(const Ref<graphics::RenderPipeline>& renderPipeline, uint32_t set, const Ref<Model>& model, const Material* material)
+{
+	std::vector<DescriptorAllocator::Write> writes;
+	const std::vector<std::vector<Shader::ResourceBindingDescription>>& rbds = renderPipeline->GetRBDs();
+	if (set >= rbds.size())
+		return writes;
+
+	const SetUpdateType setUpdateType = set == 0 ? SetUpdateType::PER_VIEW : set == 1 ? SetUpdateType::PER_MODEL : SetUpdateType::PER_MATERIAL;
+	auto AddBuffer = [&](uint32_t binding, const Ref<BufferView>& bufferView) { writes.push_back({ binding, { { bufferView } }, {} }); };
+	auto AddImage = [&](uint32_t binding, const Ref<Texture>& texture) { writes.push_back({ binding, {}, { { texture->GetTextureSampler(), texture->GetTextureImageView(), Image::Layout::SHADER_READ_ONLY_OPTIMAL } } }); };
+
+	for (auto& rbd : rbds[set])
+	{
+		const uint32_t& binding = rbd.binding;
+		const std::string& name = arc::ToUpper(rbd.name);
+		if (rbd.structSize > 0)
+		{
+			auto it = SetUpdateTypeMap.find(name);
+			if (it == SetUpdateTypeMap.end() || it->second != setUpdateType)
+				continue;
+		}
+
+		if (set == 0)
+		{
+			if (name.compare("CAMERA") == 0)
+				AddBuffer(binding, m_Camera->GetUB()->GetBufferView());
+			else if (name.compare("FONTCAMERA") == 0)
+				AddBuffer(binding, m_FontCamera->GetUB()->GetBufferView());
+			else if (name.compare("LIGHTS") == 0)
+				AddBuffer(binding, m_Lights[0]->GetUB()->GetBufferView());
+
+			else if (name.find("DIFFUSEIRRADIANCE") == 0)
+				AddImage(binding, m_Skybox->GetGeneratedDiffuseCubemap());
+			else if (name.find("SPECULARIRRADIANCE") == 0)
+				AddImage(binding, m_Skybox->GetGeneratedSpecularCubemap());
+			else if (name.find("SPECULARBRDF_LUT") == 0)
+				AddImage(binding, m_Skybox->GetGeneratedSpecularBRDF_LUT());
+		}
+		else if (set == 1)
+		{
+			if (name.compare("MODEL") == 0)
+				AddBuffer(binding, model->GetUB()->GetBufferView());
+			else if (name.compare("DRAWINSTANCES") == 0)
+				AddBuffer(binding, m_DrawInstances[m_FrameIndex]->GetBufferView());
+		}
+		else if (set == 2)
+		{
+			if (name.find("BINDLESSMATERIALS") == 0)
+				AddBuffer(binding, m_BindlessMaterials[m_FrameIndex]->GetBufferView());
+			else if (name.find("BINDLESSTEXTURES") == 0)
+			{
+				//Unused entries point at a valid texture, so that the whole array is written.
+				const Ref<Texture>& fallbackTexture = *std::find_if(m_BindlessTextures.begin(), m_BindlessTextures.end(), [](const Ref<Texture>& texture) { return texture != nullptr; });
+				DescriptorAllocator::Write write = { binding, {}, {} };
+				for (uint32_t i = 0; i < rbd.descriptorCount; i++)
+				{
+					const Ref<Texture>& texture = i < m_BindlessTextures.size() && m_BindlessTextures[i] ? m_BindlessTextures[i] : fallbackTexture;
+					write.imageInfos.push_back({ texture->GetTextureSampler(), texture->GetTextureImageView(), Image::Layout::SHADER_READ_ONLY_OPTIMAL });
+				}
+				writes.push_back(write);
+			}
+
+			else if (name.compare("SKYBOXINFO") == 0)
+				AddBuffer(binding, m_Skybox->GetUB()->GetBufferView());
+			else if (name.find("SKYBOX") == 0)
+				AddImage(binding, m_Skybox->GetGeneratedCubemap());
+
+			else if (name.find("FONTATLAS") == 0)
+				AddImage(binding, GetResidentTexture(material, Material::TextureType::ALBEDO));
+
+			else if (name.compare("PBRCONSTANTS") == 0)
+				AddBuffer(binding, material->GetUB()->GetBufferView());
+			else if (name.find("NORMAL") == 0)
+				AddImage(binding, GetResidentTexture(material, Material::TextureType::NORMAL));
+			else if (name.find("ALBEDO") == 0)
+				AddImage(binding, GetResidentTexture(material, Material::TextureType::ALBEDO));
+			else if (name.find("METALLIC") == 0)
+				AddImage(binding, GetResidentTexture(material, Material::TextureType::METALLIC));
+			else if (name.find("ROUGHNESS") == 0)
+				AddImage(binding, GetResidentTexture(material, Material::TextureType::ROUGHNESS));
+			else if (name.find("AMBIENTOCCLUSION") == 0)
+				AddImage(binding, GetResidentTexture(material, Material::TextureType::AMBIENT_OCCLUSION));
+			else if (name.find("EMISSIVE") == 0)
+				AddImage(binding, GetResidentTexture(material, Material::TextureType::EMISSIVE));
+		}
 	}
-	m_RenderQueue.clear();
+	return writes;
 }
 
 void Renderer::Present(const Ref<Swapchain>& swapchain, bool& windowResize)
 {
-	m_CmdBuffer->Present({ 0, 1 }, swapchain, m_DrawFences, m_AcquireSemaphores, m_SubmitSemaphores, windowResize);
-	m_FrameIndex = (m_FrameIndex + 1) % swapchain->GetCreateInfo().swapchainCount;
+	if (swapchain->GetCreateInfo().swapchainCount != m_FramesInFlight)
+	{
+		GEAR_ASSERT(ErrorCode::GRAPHICS | ErrorCode::INVALID_VALUE, "Swapchain image count does not match the Renderer's frames in flight.");
+	}
+
+	std::vector<uint32_t> cmdBufferIndices(m_FramesInFlight);
+	for (uint32_t i = 0; i < m_FramesInFlight; i++)
+		cmdBufferIndices[i] = i;
+
+	m_CmdBuffer->Present(cmdBufferIndices, swapchain, m_DrawFences, m_AcquireSemaphores, m_SubmitSemaphores, windowResize);
+	m_FrameIndex = (m_FrameIndex + 1) % m_FramesInFlight;
 	m_FrameCount++;
 }
 
-void Renderer::DrawCoordinateAxes()
+void Renderer::DrawCoordinateAxes(const Ref<CommandBuffer>& cmdBuffer, uint32_t cmdBufferIndex)
 {
-	const Ref<graphics::RenderPipeline>& renderPipeline = m_RenderPipelines["DebugCoordinateAxes"];
+	const Ref<graphics::RenderPipeline>& renderPipeline = FindOrNull(m_RenderPipelines, std::string("DebugCoordinateAxes"));
 	const Ref<Pipeline>& pipeline = renderPipeline->GetPipeline();
 
-	m_CmdBuffer->BindPipeline(m_FrameIndex, pipeline);
-	m_CmdBuffer->BindDescriptorSets(m_FrameIndex, { m_DescSetPerView[renderPipeline] }, pipeline);
-	m_CmdBuffer->Draw(m_FrameIndex, 6);
+	cmdBuffer->BindPipeline(cmdBufferIndex, pipeline);
+	cmdBuffer->BindDescriptorSets(cmdBufferIndex, { FindOrNull(m_DescSetPerView, renderPipeline, m_FrameIndex) }, pipeline);
+	cmdBuffer->Draw(cmdBufferIndex, 6);
+}
+
+void Renderer::SetRecordingWorkerCount(uint32_t workerCount)
+{
+	workerCount = std::max(workerCount, uint32_t(1));
+	if (workerCount == m_RecordingWorkerCount)
+		return;
+
+	m_Context->DeviceWaitIdle();
+	m_RecordingWorkerCount = workerCount;
+	m_RecordingThreadPool = nullptr;
+	m_SecondaryCmdBuffers.clear();
+	m_SecondaryCmdBufferCIs.clear();
+	m_SecondaryCmdPools.clear();
+	m_SecondaryCmdPoolCIs.clear();
+
+	if (m_RecordingWorkerCount == 1)
+		return;
+
+	m_RecordingThreadPoolCI.debugName = "GEAR_CORE_ThreadPool_Renderer_Recording";
+	m_RecordingThreadPoolCI.workerCount = m_RecordingWorkerCount;
+	m_RecordingThreadPool = CreateRef<core::ThreadPool>(&m_RecordingThreadPoolCI);
+
+	//CommandPools are externally synchronised, so each worker gets its own.
+	m_SecondaryCmdPoolCIs.resize(m_RecordingWorkerCount);
+	m_SecondaryCmdBufferCIs.resize(m_RecordingWorkerCount);
+	for (uint32_t i = 0; i < m_RecordingWorkerCount; i++)
+	{
+		CommandPool::CreateInfo& secondaryCmdPoolCI = m_SecondaryCmdPoolCIs[i];
+		secondaryCmdPoolCI.debugName = "GEAR_CORE_CommandPool_Renderer_Secondary_" + std::to_string(i);
+		secondaryCmdPoolCI.pContext = m_Context;
+		secondaryCmdPoolCI.flags = CommandPool::FlagBit::RESET_COMMAND_BUFFER_BIT;
+		secondaryCmdPoolCI.queueType = CommandPool::QueueType::GRAPHICS;
+		m_SecondaryCmdPools.push_back(CommandPool::Create(&secondaryCmdPoolCI));
+
+		CommandBuffer::CreateInfo& secondaryCmdBufferCI = m_SecondaryCmdBufferCIs[i];
+		secondaryCmdBufferCI.debugName = "GEAR_CORE_CommandBuffer_Renderer_Secondary_" + std::to_string(i);
+		secondaryCmdBufferCI.pCommandPool = m_SecondaryCmdPools.back();
+		secondaryCmdBufferCI.level = CommandBuffer::Level::SECONDARY;
+		secondaryCmdBufferCI.commandBufferCount = static_cast<uint32_t>(m_DrawFences.size());
+		secondaryCmdBufferCI.allocateNewCommandPoolPerBuffer = GraphicsAPI::IsD3D12();
+		m_SecondaryCmdBuffers.push_back(CommandBuffer::Create(&secondaryCmdBufferCI));
+	}
 }
 
 void Renderer::ResizeRenderPipelineViewports(uint32_t width, uint32_t height)
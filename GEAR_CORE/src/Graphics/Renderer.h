@@ -1,8 +1,18 @@
 #pragma once
 
 #include "gear_core_common.h"
+#include "Graphics/ClusterCulling.h"
+#include "Graphics/DescriptorAllocator.h"
 #include "Graphics/Framebuffer.h"
+#include "Graphics/FrameGraph.h"
+#include "Graphics/MeshPool.h"
+#include "Core/ThreadPool.h"
 #include "Graphics/RenderPipeline.h"
+#include "Graphics/Storagebuffer.h"
+#include "Graphics/TextureCache.h"
+#include "Graphics/TextureStreamer.h"
+#include "Graphics/Uniformbuffer.h"
+#include "Graphics/UniformRing.h"
 #include "Objects/Camera.h"
 #include "Objects/Light.h"
 #include "Objects/Skybox.h"
@@ -14,7 +24,67 @@ namespace graphics
 {
 	class Renderer
 	{
+	public:
+		struct Statistics
+		{
+			double		recordingTime;			//In milliseconds.
+			uint32_t	recordingWorkerCount;
+			uint32_t	drawCalls;
+
+			//Binds recorded and redundant binds skipped by the sorted draw submission.
+			uint32_t	pipelineBinds;
+			uint32_t	pipelineBindsSaved;
+			uint32_t	descriptorSetBinds;
+			uint32_t	descriptorSetBindsSaved;
+			uint32_t	vertexBufferBinds;
+			uint32_t	vertexBufferBindsSaved;
+			uint32_t	indexBufferBinds;
+			uint32_t	indexBufferBindsSaved;
+
+			//Sub-meshes submitted to the GPU-driven path, the batches they were grouped into and the indirect draws issued.
+			uint32_t	gpuDrivenInstances;
+			uint32_t	gpuDrivenBatches;
+			uint32_t	indirectDrawCalls;
+
+			//Buffer copies recorded by the last upload. Only the buffers changed since their previous upload are copied.
+			uint64_t	uploadBytes;
+			uint32_t	uploadCopyCommands;
+
+			//Meshlets tested by cluster culling, those culled, and the triangles that were not drawn as a result.
+			uint32_t	clusters;
+			uint32_t	clustersCulled;
+			uint32_t	clusterTrianglesCulled;
+		};
+
 	private:
+		//One per sub-mesh in the render queue. Draws are recorded in ascending sort key order.
+		struct DrawItem
+		{
+			uint64_t	sortKey;
+			uint32_t	modelIndex;
+			uint32_t	subMeshIndex;
+		};
+
+		//Sub-meshes of GPU-driven pipelines that share a pipeline and MeshPool block. Each batch owns a contiguous
+		//range of draw commands, one per instance, which the cull pass compacts to the front of the range.
+		struct GPUDrivenBatch
+		{
+			Ref<graphics::RenderPipeline>	renderPipeline;
+			Ref<miru::crossplatform::BufferView>	vertexBufferView;
+			Ref<miru::crossplatform::BufferView>	indexBufferView;
+			uint32_t						batchOffset;
+			uint32_t						maxDrawCount;
+		};
+
+		//A per material set and what it was acquired for. Materials with identical resident textures and constants are
+		//written with the constants of one of them, so that the DescriptorAllocator shares a single set between them.
+		struct MaterialDescriptorSet
+		{
+			Ref<miru::crossplatform::DescriptorSet>	set;
+			const objects::Material*				constantsMaterial;
+			std::string								key;
+		};
+
 		//Context and Device
 		void* m_Device;
 		Ref<miru::crossplatform::Context> m_Context;
@@ -30,15 +100,87 @@ namespace graphics
 		Ref<miru::crossplatform::CommandBuffer> m_TransCmdBuffer;
 		miru::crossplatform::CommandBuffer::CreateInfo m_TransCmdBufferCI;
 
-		//Descriptor Pool and Sets
-		Ref<miru::crossplatform::DescriptorPool> m_DescPool;
-		miru::crossplatform::DescriptorPool::CreateInfo m_DescPoolCI;
+		//Parallel Recording: One CommandPool and secondary CommandBuffer per worker.
+		Ref<core::ThreadPool> m_RecordingThreadPool;
+		core::ThreadPool::CreateInfo m_RecordingThreadPoolCI;
+		std::vector<Ref<miru::crossplatform::CommandPool>> m_SecondaryCmdPools;
+		std::vector<miru::crossplatform::CommandPool::CreateInfo> m_SecondaryCmdPoolCIs;
+		std::vector<Ref<miru::crossplatform::CommandBuffer>> m_SecondaryCmdBuffers;
+		std::vector<miru::crossplatform::CommandBuffer::CreateInfo> m_SecondaryCmdBufferCIs;
+		uint32_t m_RecordingWorkerCount = 1;
+
+		//Upload FrameGraphs: One per frame in flight, so a frame's uploads are only waited on when its slot is reused.
+		std::vector<Ref<FrameGraph>> m_UploadFrameGraphs;
+		std::vector<FrameGraph::CreateInfo> m_UploadFrameGraphCIs;
+
+		//Texture Streamer: Textures are uploaded over several frames within a byte budget, which adapts to the time of the uploads.
+		Ref<TextureStreamer> m_TextureStreamer;
+		TextureStreamer::CreateInfo m_TextureStreamerCI;
+		std::vector<double> m_UploadPassTimes;	//Per frame in flight.
+
+		//Uniform Ring: Written to the current frame's buffers once the frame's previous submission has completed.
+		Ref<UniformRing> m_UniformRing;
 
-		std::map<Ref<graphics::RenderPipeline>, Ref<miru::crossplatform::DescriptorSet>> m_DescSetPerView;
-		std::map<Ref<objects::Model>, Ref<miru::crossplatform::DescriptorSet>> m_DescSetPerModel;
-		std::map<Ref<objects::Material>, Ref<miru::crossplatform::DescriptorSet>> m_DescSetPerMaterial;
+		//Texture Cache: Unused textures are evicted once they can no longer be in use by a frame in flight.
+		Ref<TextureCache> m_TextureCache;
+
+		//Descriptor Allocator and Sets
+		Ref<DescriptorAllocator> m_DescAllocator;
+		DescriptorAllocator::CreateInfo m_DescAllocatorCI;
+
+		//One set per frame in flight, as they reference the per-frame uniform blocks of the UniformRing.
+		//Models and Materials do not hold references. Their sets are released by their destroy callbacks.
+		std::map<Ref<graphics::RenderPipeline>, std::vector<Ref<miru::crossplatform::DescriptorSet>>> m_DescSetPerView;
+		std::map<const objects::Model*, std::vector<Ref<miru::crossplatform::DescriptorSet>>> m_DescSetPerModel;
+		std::map<const objects::Material*, std::vector<MaterialDescriptorSet>> m_DescSetPerMaterial;
+
+		//Bindless Materials: Pipelines with a BindlessMaterials binding share one material table and one texture table.
+		typedef UniformBufferStructures::BindlessMaterials BindlessMaterialsSB;
+		//Each frame in flight has its own copy of the table, which is rewritten from m_BindlessMaterialsData once the frame's
+		//previous draws have completed.
+		Scope<BindlessMaterialsSB> m_BindlessMaterialsData;
+		std::vector<Ref<Storagebuffer<BindlessMaterialsSB>>> m_BindlessMaterials;
+		std::vector<bool> m_BindlessMaterialsStale;
+		Storagebuffer<BindlessMaterialsSB>::CreateInfo m_BindlessMaterialsCI;
+		std::set<const graphics::RenderPipeline*> m_BindlessPipelines;
+		std::map<const objects::Material*, uint32_t> m_BindlessMaterialIDs;
+		std::vector<uint32_t> m_FreeBindlessMaterialIDs;
+		//A texture is held while a material in the table references it, and then until every frame in flight has rewritten
+		//its descriptor sets. Whether anything else holds it does not matter, so the TextureCache can evict it afterwards.
+		std::vector<Ref<Texture>> m_BindlessTextures;
+		std::deque<std::pair<Ref<Texture>, uint32_t>> m_RetiredBindlessTextures;	//With the frame they were retired in.
+		std::map<const Texture*, uint32_t> m_BindlessTextureIDs;
+		std::vector<uint32_t> m_FreeBindlessTextureIDs;
+		uint32_t m_MaxBindlessTextures = UniformBufferStructures::MAX_BINDLESS_TEXTURES; //Clamped to the pipelines' arrays and the device's limits.
+		std::map<Ref<graphics::RenderPipeline>, std::vector<Ref<miru::crossplatform::DescriptorSet>>> m_DescSetBindless;
+		bool m_BindlessMaterialsChanged = false;
+		bool m_BindlessTexturesChanged = false;
+
+		//GPU-driven: Pipelines with a DrawInstances binding are frustum culled by a compute pass and drawn indirectly.
+		typedef UniformBufferStructures::DrawInstance DrawInstance;
+		typedef UniformBufferStructures::DrawIndexedIndirectCommand DrawIndexedIndirectCommand;
+		typedef UniformBufferStructures::CullInfo CullInfoUB;
+		std::set<const graphics::RenderPipeline*> m_GPUDrivenPipelines;
+		Ref<graphics::RenderPipeline> m_GPUDrivenCullPipeline;
+		Ref<Uniformbuffer<CullInfoUB>> m_CullInfo;
+		Uniformbuffer<CullInfoUB>::CreateInfo m_CullInfoCI;
+		//One set of buffers and Descriptor Sets per frame in flight, as the cull pass and the draws of the previous frames may still be reading theirs.
+		std::vector<Ref<GrowableStoragebuffer<DrawInstance>>> m_DrawInstances;
+		GrowableStoragebuffer<DrawInstance>::CreateInfo m_DrawInstancesCI;
+		std::vector<Ref<GrowableStoragebuffer<DrawIndexedIndirectCommand>>> m_DrawCommands;
+		GrowableStoragebuffer<DrawIndexedIndirectCommand>::CreateInfo m_DrawCommandsCI;
+		std::vector<Ref<GrowableStoragebuffer<uint32_t>>> m_DrawCounts;
+		GrowableStoragebuffer<uint32_t>::CreateInfo m_DrawCountsCI;
+		std::vector<GPUDrivenBatch> m_GPUDrivenBatches;
+		std::map<Ref<graphics::RenderPipeline>, std::vector<Ref<miru::crossplatform::DescriptorSet>>> m_DescSetDrawInstances;
+		std::vector<Ref<miru::crossplatform::DescriptorSet>> m_DescSetCull;
+
+		//Cluster culling: The camera of the current frame, which the meshlets of the CPU recorded draws are culled against.
+		bool m_ClusterCulling = false;
+		std::array<mars::Vec4, 6> m_ClusterCullPlanes;
+		mars::Vec3 m_ClusterCullPosition;
+		bool m_ClusterCullMirrored = false;
 
-		bool m_BuiltDescPoolsAndSets = false;
 		bool m_ReloadTextures = false;
 
 		//Renderering Objects
@@ -49,6 +191,8 @@ namespace graphics
 		std::vector<Ref<objects::Light>> m_Lights;
 		Ref<objects::Skybox> m_Skybox;
 		std::vector<Ref<objects::Model>> m_RenderQueue;
+		std::vector<DrawItem> m_DrawItems;
+		std::vector<DrawItem> m_DrawItemsScratch;
 
 		//Present Synchronisation Primitives
 		std::vector<Ref<miru::crossplatform::Fence>> m_DrawFences;
@@ -58,11 +202,16 @@ namespace graphics
 		std::vector<Ref<miru::crossplatform::Semaphore>>m_SubmitSemaphores;
 		miru::crossplatform::Semaphore::CreateInfo m_SubmitSemaphoreCI;
 
+		uint32_t m_FramesInFlight;
 		uint32_t m_FrameIndex = 0;
 		uint32_t m_FrameCount = 0;
 
+		Statistics m_Statistics = {};
+		BufferCopyBatch::Statistics m_UploadCopyStatistics = {};
+
 	public:
-		Renderer(const Ref<miru::crossplatform::Context>& context);
+		//framesInFlight must match the swapchain image count.
+		Renderer(const Ref<miru::crossplatform::Context>& context, uint32_t framesInFlight = 2);
 		virtual ~Renderer();
 
 		void InitialiseRenderPipelines(const std::vector<std::string>& filepaths, float viewportWidth, float viewportHeight, miru::crossplatform::Image::SampleCountBit samples, const Ref<miru::crossplatform::RenderPass>& renderPass);
@@ -74,11 +223,22 @@ namespace graphics
 		void SubmitSkybox(const Ref<objects::Skybox>& skybox);
 		void SubmitModel(const Ref<objects::Model>& obj);
 
-		void Upload(bool forceUploadCamera, bool forceUploadLights, bool forceUploadSkybox, bool forceUploadMeshes);
+		//Buffers are uploaded when they have changed since their last upload. The force flags upload them regardless.
+		void Upload(bool forceUploadCamera = false, bool forceUploadLights = false, bool forceUploadSkybox = false, bool forceUploadMeshes = false);
 		void Flush();
 		void Present(const Ref<miru::crossplatform::Swapchain>& swapchain, bool& windowResize);
 
-		void DrawCoordinateAxes();
+		void DrawCoordinateAxes(const Ref<miru::crossplatform::CommandBuffer>& cmdBuffer, uint32_t cmdBufferIndex);
+
+		//A worker count of 1 records on the calling thread into the primary CommandBuffer.
+		void SetRecordingWorkerCount(uint32_t workerCount);
+		inline uint32_t GetRecordingWorkerCount() const { return m_RecordingWorkerCount; }
+
+		//Sub-meshes with meshlets are drawn as the runs of their meshlets that survive frustum and back face culling, when
+		//they are drawn at their full level of detail by the CPU recorded path. Skinned sub-meshes are not cluster culled,
+		//as their meshlet bounds are in the bind pose. Disabled by default.
+		inline void SetClusterCulling(bool enable) { m_ClusterCulling = enable; }
+		inline bool GetClusterCulling() const { return m_ClusterCulling; }
 
 		void ResizeRenderPipelineViewports(uint32_t width, uint32_t height);
 		void RecompileRenderPipelineShaders();
@@ -86,10 +246,38 @@ namespace graphics
 
 		inline std::vector<Ref<objects::Model>>& GetRenderQueue() { return m_RenderQueue; };
 		inline const Ref<miru::crossplatform::CommandBuffer>& GetCmdBuffer() { return m_CmdBuffer; };
+		inline const Ref<FrameGraph>& GetUploadFrameGraph() const { return m_UploadFrameGraphs[m_FrameIndex]; }
+		inline const Ref<TextureStreamer>& GetTextureStreamer() const { return m_TextureStreamer; }
 		inline const std::map<std::string, Ref<graphics::RenderPipeline>>& GetRenderPipelines() const { return m_RenderPipelines; }
 
+		inline uint32_t GetFramesInFlight() const { return m_FramesInFlight; }
 		inline const uint32_t& GetFrameIndex() const { return m_FrameIndex; }
 		inline const uint32_t& GetFrameCount() const { return m_FrameCount; }
+		inline const Statistics& GetStatistics() const { return m_Statistics; }
+
+		//CPU reference of GPUDrivenCull.hlsl. drawCounts must be zeroed and sized to cullInfo.batchCount. 
+		//The order of the commands within a batch may differ from the GPU, but the set of commands matches.
+		static void CullDrawInstances(const UniformBufferStructures::CullInfo& cullInfo, const UniformBufferStructures::DrawInstance* drawInstances, 
+			UniformBufferStructures::DrawIndexedIndirectCommand* drawCommands, uint32_t* drawCounts);
+
+	private:
+		void UpdateBindlessMaterials();
+		uint32_t GetBindlessTextureID(const Ref<Texture>& texture);
+		//Returns how many textures the device can bind in the bindless texture array alongside the pipeline's other descriptors.
+		uint32_t GetDeviceBindlessTextureLimit(const std::vector<std::vector<miru::crossplatform::Shader::ResourceBindingDescription>>& rbds, const miru::crossplatform::Shader::ResourceBindingDescription& bindlessTexturesRBD) const;
+		static const Ref<Texture>& GetResidentTexture(const objects::Material* material, objects::Material::TextureType type);
+		static std::string GetMaterialKey(const objects::Material* material);
+		void OnModelDestroyed(const objects::Model* model);
+		void OnMaterialDestroyed(const objects::Material* material);
+		void UpdateDescriptorSets();
+		const Ref<miru::crossplatform::DescriptorSet>& GetDescriptorSetPerMaterial(const objects::Material* material) const;
+		std::vector<DescriptorAllocator::Write> GetDescriptorWrites(const Ref<graphics::RenderPipeline>& renderPipeline, uint32_t set, const Ref<objects::Model>& model, const objects::Material* material);
+		void BuildDrawItems();
+		static void RadixSortDrawItems(std::vector<DrawItem>& drawItems, std::vector<DrawItem>& scratch);
+		void RecordDrawCalls(const Ref<miru::crossplatform::CommandBuffer>& cmdBuffer, uint32_t cmdBufferIndex, size_t drawItemBegin, size_t drawItemEnd, Statistics& statistics);
+		void BuildDrawInstances();
+		void RecordGPUDrivenCull(const Ref<miru::crossplatform::CommandBuffer>& cmdBuffer, uint32_t cmdBufferIndex);
+		void RecordGPUDrivenDrawCalls(const Ref<miru::crossplatform::CommandBuffer>& cmdBuffer, uint32_t cmdBufferIndex, Statistics& statistics);
 	};
 }
 }
\ No newline at end of file
@@ -1,6 +1,9 @@
 #pragma once
 
 #include "gear_core_common.h"
+#include "Graphics/AllocatorManager.h"
+#include "Graphics/BufferCopyBatch.h"
+#include "Graphics/UniformBufferStructures.h"
 
 namespace gear 
 {
@@ -26,6 +29,10 @@ namespace graphics
 
 		CreateInfo m_CI;
 
+		//Bumped by SubmitData(). Upload() only copies when the version has changed since the last upload.
+		mutable uint64_t m_Version = 1;
+		uint64_t m_UploadedVersion = 0;
+
 	public:
 		Storagebuffer(CreateInfo* pCreateInfo) 
 		{
@@ -49,7 +56,7 @@ namespace graphics
 
 			m_ShaderStorageBufferViewCI.debugName = "GEAR_CORE_ShaderStorageViewUsage: " + m_CI.debugName;
 			m_ShaderStorageBufferViewCI.device = m_CI.device;
-			m_ShaderStorageBufferViewCI.type = miru::crossplatform::BufferView::Type::UNIFORM;
+			m_ShaderStorageBufferViewCI.type = miru::crossplatform::BufferView::Type::STORAGE;
 			m_ShaderStorageBufferViewCI.pBuffer = m_ShaderStorageBuffer;
 			m_ShaderStorageBufferViewCI.offset = 0;
 			m_ShaderStorageBufferViewCI.size = GetSize();
@@ -63,14 +70,27 @@ namespace graphics
 		void SubmitData(const void* data, size_t  size) const
 		{
 			m_ShaderStorageBufferUploadCI.pAllocator->SubmitData(m_ShaderStorageBufferUpload->GetAllocation(), (size_t)size, (void*)data);
+			m_Version++;
 		}
 		void AccessData(void* data, size_t size) const 
 		{
 			m_ShaderStorageBufferUploadCI.pAllocator->AccessData(m_ShaderStorageBufferUpload->GetAllocation(), size, data);
 		}
-		void Upload(const Ref<miru::crossplatform::CommandBuffer>& cmdBuffer, uint32_t cmdBufferIndex = 0)
+		void Upload(const Ref<miru::crossplatform::CommandBuffer>& cmdBuffer, uint32_t cmdBufferIndex = 0, bool force = false)
 		{
-			cmdBuffer->CopyBuffer(cmdBufferIndex, m_ShaderStorageBufferUpload, m_ShaderStorageBuffer, { {0, 0, GetSize()} });
+			if (m_Version != m_UploadedVersion || force)
+			{
+				cmdBuffer->CopyBuffer(cmdBufferIndex, m_ShaderStorageBufferUpload, m_ShaderStorageBuffer, { {0, 0, GetSize()} });
+				m_UploadedVersion = m_Version;
+			}
+		}
+		void Upload(BufferCopyBatch& copyBatch, bool force = false)
+		{
+			if (m_Version != m_UploadedVersion || force)
+			{
+				copyBatch.Add(m_ShaderStorageBufferUpload, m_ShaderStorageBuffer, { 0, 0, GetSize() });
+				m_UploadedVersion = m_Version;
+			}
 		}
 		void Download(const Ref<miru::crossplatform::CommandBuffer>& cmdBuffer, uint32_t cmdBufferIndex = 0)
 		{
@@ -80,7 +100,123 @@ namespace graphics
 		inline const Ref<miru::crossplatform::Buffer>& GetBuffer() const { return m_ShaderStorageBuffer; };
 		inline const Ref<miru::crossplatform::BufferView>& GetBufferView() const { return m_ShaderStorageBufferView; };
 
-		inline size_t GetSize() { return sizeof(T); }
+		inline size_t GetSize() const { return sizeof(T); }
+		inline uint64_t GetVersion() const { return m_Version; }
+	};
+
+	//A Storagebuffer of a runtime sized array of T, kept on the CPU and uploaded as a whole.
+	//The buffers are recreated with at least double the capacity when Resize() exceeds it,
+	//so Descriptor Sets referencing GetBufferView() must be rewritten after a Resize().
+	template<typename T>
+	class GrowableStoragebuffer
+	{
+	public:
+		struct CreateInfo
+		{
+			std::string								debugName;
+			void*									device;
+			size_t									count;
+			miru::crossplatform::Buffer::UsageBit	additionalUsage;	//e.g. INDIRECT_BIT for draw arguments.
+		};
+
+	private:
+		Ref<miru::crossplatform::Buffer> m_ShaderStorageBuffer, m_ShaderStorageBufferUpload;
+		miru::crossplatform::Buffer::CreateInfo m_ShaderStorageBufferCI, m_ShaderStorageBufferUploadCI;
+
+		Ref<miru::crossplatform::BufferView> m_ShaderStorageBufferView;
+		miru::crossplatform::BufferView::CreateInfo m_ShaderStorageBufferViewCI;
+
+		CreateInfo m_CI;
+
+		std::vector<T> m_Data;
+		size_t m_Capacity = 0;
+
+	public:
+		GrowableStoragebuffer(CreateInfo* pCreateInfo)
+		{
+			m_CI = *pCreateInfo;
+			m_Data.resize(m_CI.count);
+			Reallocate(std::max(m_CI.count, size_t(1)));
+		}
+		~GrowableStoragebuffer() {}
+
+		const CreateInfo& GetCreateInfo() { return m_CI; }
+
+		//Returns true if the buffers were recreated.
+		bool Resize(size_t count)
+		{
+			m_Data.resize(count);
+			if (count <= m_Capacity)
+				return false;
+
+			Reallocate(std::max(count, m_Capacity * 2));
+			return true;
+		}
+
+		inline T& operator[](size_t index) { return m_Data[index]; }
+		inline const T& operator[](size_t index) const { return m_Data[index]; }
+		inline T* GetData() { return m_Data.data(); }
+		inline const T* GetData() const { return m_Data.data(); }
+		inline size_t GetCount() const { return m_Data.size(); }
+		inline size_t GetCapacity() const { return m_Capacity; }
+
+		void SubmitData() const
+		{
+			if (GetSize() > 0)
+				m_ShaderStorageBufferUploadCI.pAllocator->SubmitData(m_ShaderStorageBufferUpload->GetAllocation(), GetSize(), (void*)m_Data.data());
+		}
+		void Upload(const Ref<miru::crossplatform::CommandBuffer>& cmdBuffer, uint32_t cmdBufferIndex = 0)
+		{
+			if (GetSize() > 0)
+				cmdBuffer->CopyBuffer(cmdBufferIndex, m_ShaderStorageBufferUpload, m_ShaderStorageBuffer, { {0, 0, GetSize()} });
+		}
+		//Copies the GPU's results back into the upload buffer. AccessData() reads them into the CPU array once the copy has completed.
+		void Download(const Ref<miru::crossplatform::CommandBuffer>& cmdBuffer, uint32_t cmdBufferIndex = 0)
+		{
+			if (GetSize() > 0)
+				cmdBuffer->CopyBuffer(cmdBufferIndex, m_ShaderStorageBuffer, m_ShaderStorageBufferUpload, { {0, 0, GetSize()} });
+		}
+		void AccessData()
+		{
+			if (GetSize() > 0)
+				m_ShaderStorageBufferUploadCI.pAllocator->AccessData(m_ShaderStorageBufferUpload->GetAllocation(), GetSize(), (void*)m_Data.data());
+		}
+
+		inline const Ref<miru::crossplatform::Buffer>& GetBuffer() const { return m_ShaderStorageBuffer; };
+		inline const Ref<miru::crossplatform::BufferView>& GetBufferView() const { return m_ShaderStorageBufferView; };
+
+		inline size_t GetSize() const { return m_Data.size() * sizeof(T); }
+
+	private:
+		void Reallocate(size_t capacity)
+		{
+			m_Capacity = capacity;
+
+			m_ShaderStorageBufferUploadCI.debugName = "GEAR_CORE_ShaderStorageBufferUpload: " + m_CI.debugName;
+			m_ShaderStorageBufferUploadCI.device = m_CI.device;
+			m_ShaderStorageBufferUploadCI.usage = miru::crossplatform::Buffer::UsageBit::TRANSFER_SRC_BIT | miru::crossplatform::Buffer::UsageBit::TRANSFER_DST_BIT;
+			m_ShaderStorageBufferUploadCI.size = m_Capacity * sizeof(T);
+			m_ShaderStorageBufferUploadCI.data = nullptr;
+			m_ShaderStorageBufferUploadCI.pAllocator = AllocatorManager::GetAllocator(AllocatorManager::AllocatorType::CPU);
+			m_ShaderStorageBufferUpload = miru::crossplatform::Buffer::Create(&m_ShaderStorageBufferUploadCI);
+
+			m_ShaderStorageBufferCI.debugName = "GEAR_CORE_ShaderStorageBuffer: " + m_CI.debugName;
+			m_ShaderStorageBufferCI.device = m_CI.device;
+			m_ShaderStorageBufferCI.usage = miru::crossplatform::Buffer::UsageBit::TRANSFER_SRC_BIT | miru::crossplatform::Buffer::UsageBit::TRANSFER_DST_BIT | miru::crossplatform::Buffer::UsageBit::STORAGE_BIT | m_CI.additionalUsage;
+			m_ShaderStorageBufferCI.size = m_Capacity * sizeof(T);
+			m_ShaderStorageBufferCI.data = nullptr;
+			m_ShaderStorageBufferCI.pAllocator = AllocatorManager::GetAllocator(AllocatorManager::AllocatorType::GPU);
+			m_ShaderStorageBuffer = miru::crossplatform::Buffer::Create(&m_ShaderStorageBufferCI);
+
+			m_ShaderStorageBufferViewCI.debugName = "GEAR_CORE_ShaderStorageViewUsage: " + m_CI.debugName;
+			m_ShaderStorageBufferViewCI.device = m_CI.device;
+			m_ShaderStorageBufferViewCI.type = miru::crossplatform::BufferView::Type::STORAGE;
+			m_ShaderStorageBufferViewCI.pBuffer = m_ShaderStorageBuffer;
+			m_ShaderStorageBufferViewCI.offset = 0;
+			m_ShaderStorageBufferViewCI.size = m_Capacity * sizeof(T);
+			m_ShaderStorageBufferViewCI.stride = sizeof(T);
+			m_ShaderStorageBufferView = miru::crossplatform::BufferView::Create(&m_ShaderStorageBufferViewCI);
+		}
 	};
 }
 }
\ No newline at end of file
@@ -1,8 +1,9 @@
 #include "gear_core_common.h"
-#include "stb_image.h"
 #include "Texture.h"
 #include "Graphics/AllocatorManager.h"
+#include "Graphics/ImageDecoder.h"
 #include "ImageProcessing.h"
+#include "Utils/AssetDatabase.h"
 
 using namespace gear;
 using namespace graphics;
@@ -27,7 +28,25 @@ Texture::Texture(CreateInfo* pCreateInfo)
 	LoadImageData(imageData);
 
 	//Calculate Mipmap details
-	if (!mars::Utility::IsPowerOf2(m_Width) && !mars::Utility::IsPowerOf2(m_Height))
+	if (m_UploadMipLevels > 1)
+	{
+		//A provided mip chain defines the levels of the image, so non-power of 2 textures keep their mips as well.
+		//A partial chain is not completed, as block compressed levels can not be generated.
+		const uint32_t maxLevels = static_cast<uint32_t>(log2(static_cast<double>(std::max({ m_Width, m_Height, m_Depth, 1U })))) + 1;
+		if (m_UploadMipLevels < maxLevels)
+		{
+			GEAR_WARN(ErrorCode::GRAPHICS | ErrorCode::INVALID_VALUE, "Texture: %s provides %d of %d mip levels. The smaller levels are missing, so it is only sampled down to level %d.", m_CI.debugName.c_str(), m_UploadMipLevels, maxLevels, m_UploadMipLevels - 1);
+		}
+		m_CI.mipLevels = m_UploadMipLevels;
+		m_CI.generateMipMaps = false;
+	}
+	else if (!IsStorageFormat(m_CI.format))
+	{
+		//Block compressed and shared exponent images can not be storage images, so their mips can only come with their data.
+		m_CI.mipLevels = 1;
+		m_CI.generateMipMaps = false;
+	}
+	else if (!mars::Utility::IsPowerOf2(m_Width) && !mars::Utility::IsPowerOf2(m_Height))
 	{
 		m_CI.mipLevels = 1;
 		m_CI.generateMipMaps = false;
@@ -38,6 +57,10 @@ Texture::Texture(CreateInfo* pCreateInfo)
 		m_CI.mipLevels = std::min(maxLevels, m_CI.mipLevels);
 	}
 	m_GenerateMipMaps = m_CI.mipLevels > 1 && m_CI.generateMipMaps;
+	if (IsBlockCompressed(m_CI.format) && (m_Width % 4 != 0 || m_Height % 4 != 0))
+	{
+		GEAR_WARN(ErrorCode::GRAPHICS | ErrorCode::INVALID_VALUE, "The extent of block compressed Texture: %s is not a multiple of 4. Some APIs will fail to create it.", m_CI.debugName.c_str());
+	}
 
 	//Upload buffer
 	m_TextureUploadBufferCI.debugName = "GEAR_CORE_TextureUploadBuffer: " + m_CI.debugName;
@@ -100,23 +123,9 @@ void Texture::Upload(const Ref<CommandBuffer>& cmdBuffer, uint32_t cmdBufferInde
 {
 	if (!m_Upload || force)
 	{
-		std::vector<Image::BufferImageCopy> bics;
-		for (size_t level = 0; level < 1/*m_CI.mipLevels*/; level++)
-		{
-			Image::BufferImageCopy bic;
-			bic.bufferOffset = level == 0 ? 0 : (m_CI.arrayLayers * (m_Width >> (level - 1)) * (m_Height >> (level - 1)) * 4) + bics.back().bufferOffset;
-			bic.bufferRowLength = 0;
-			bic.bufferImageHeight = 0;
-			bic.imageSubresource.aspectMask = m_DepthTexture ? Image::AspectBit::DEPTH_BIT : Image::AspectBit::COLOUR_BIT;
-			bic.imageSubresource.mipLevel = (uint32_t)level;
-			bic.imageSubresource.baseArrayLayer = 0;
-			bic.imageSubresource.arrayLayerCount = (uint32_t)m_CI.arrayLayers;
-			bic.imageOffset = { 0, 0, 0 };
-			bic.imageExtent = { m_Width >> level, m_Height >> level, m_Depth };
-			bics.push_back(bic);
-		}
-
-		cmdBuffer->CopyBufferToImage(cmdBufferIndex, m_TextureUploadBuffer, m_Texture, Image::Layout::TRANSFER_DST_OPTIMAL, bics);
+		//All the provided levels are copied by one command. The image has exactly these levels, unless only level 0 was
+		//provided and m_GenerateMipMaps is set, in which case the Renderer generates the rest from it.
+		cmdBuffer->CopyBufferToImage(cmdBufferIndex, m_TextureUploadBuffer, m_Texture, Image::Layout::TRANSFER_DST_OPTIMAL, GetBufferImageCopies(m_UploadMipLevels));
 		m_Upload = true;
 	}
 }
@@ -125,28 +134,17 @@ void Texture::Download(const Ref<CommandBuffer>& cmdBuffer, uint32_t cmdBufferIn
 {
 	if (m_Upload || force)
 	{
-		std::vector<Image::BufferImageCopy> bics;
-		for (size_t level = 0; level < m_CI.mipLevels; level++)
-		{
-			Image::BufferImageCopy bic;
-			bic.bufferOffset = level == 0 ? 0 : (m_CI.arrayLayers * (m_Width >> (level - 1)) * (m_Height >> (level - 1)) * 4) + bics.back().bufferOffset;
-			bic.bufferRowLength = 0;
-			bic.bufferImageHeight = 0;
-			bic.imageSubresource.aspectMask = m_DepthTexture ? Image::AspectBit::DEPTH_BIT : Image::AspectBit::COLOUR_BIT;
-			bic.imageSubresource.mipLevel = (uint32_t)level;
-			bic.imageSubresource.baseArrayLayer = 0;
-			bic.imageSubresource.arrayLayerCount = (uint32_t)m_CI.arrayLayers;
-			bic.imageOffset = { 0, 0, 0 };
-			bic.imageExtent = { m_Width >> level, m_Height >> level , m_Depth };
-			bics.push_back(bic);
-		}
-		
-		cmdBuffer->CopyImageToBuffer(cmdBufferIndex, m_Texture, m_TextureUploadBuffer, Image::Layout::TRANSFER_SRC_OPTIMAL, bics);
+		cmdBuffer->CopyImageToBuffer(cmdBufferIndex, m_Texture, m_TextureUploadBuffer, Image::Layout::TRANSFER_SRC_OPTIMAL, GetBufferImageCopies(m_CI.mipLevels));
 		m_Upload = false;
 	}
 }
 
 void Texture::TransitionSubResources(std::vector<Ref<Barrier>>& barriers, const std::vector<SubresouresTransitionInfo>& transitionInfos)
+{
+	TransitionSubResources(barriers, transitionInfos, MIRU_QUEUE_FAMILY_IGNORED, MIRU_QUEUE_FAMILY_IGNORED);
+}
+
+void Texture::TransitionSubResources(std::vector<Ref<Barrier>>& barriers, const std::vector<SubresouresTransitionInfo>& transitionInfos, uint32_t srcQueueFamilyIndex, uint32_t dstQueueFamilyIndex)
 {
 	Barrier::CreateInfo barrierCI;
 	for (auto& transitionInfo : transitionInfos)
@@ -154,8 +152,8 @@ void Texture::TransitionSubResources(std::vector<Ref<Barrier>>& barriers, const
 		barrierCI.type = Barrier::Type::IMAGE;
 		barrierCI.srcAccess = transitionInfo.srcAccess;
 		barrierCI.dstAccess = transitionInfo.dstAccess;
-		barrierCI.srcQueueFamilyIndex = MIRU_QUEUE_FAMILY_IGNORED;
-		barrierCI.dstQueueFamilyIndex = MIRU_QUEUE_FAMILY_IGNORED;
+		barrierCI.srcQueueFamilyIndex = srcQueueFamilyIndex;
+		barrierCI.dstQueueFamilyIndex = dstQueueFamilyIndex;
 		barrierCI.pImage = m_Texture;
 		barrierCI.oldLayout = transitionInfo.oldLayout;
 		barrierCI.newLayout = transitionInfo.newLayout;
@@ -182,6 +180,7 @@ void Texture::Reload()
 {
 	std::vector<uint8_t> imageData;
 	LoadImageData(imageData);
+	m_UploadMipLevels = std::min(m_UploadMipLevels, m_CI.mipLevels);
 
 	m_TextureUploadBufferCI.pAllocator->SubmitData(m_TextureUploadBuffer->GetAllocation(), imageData.size(), imageData.data());
 
@@ -231,59 +230,235 @@ void Texture::CreateSampler()
 	m_Sampler = Sampler::Create(&m_SamplerCI);
 }
 
-void Texture::LoadImageData(std::vector<uint8_t>& imageData)
+std::vector<Image::BufferImageCopy> Texture::GetBufferImageCopies(uint32_t mipLevels)
+{
+	std::vector<Image::BufferImageCopy> bics;
+	for (uint32_t level = 0; level < mipLevels; level++)
+	{
+		Image::BufferImageCopy bic;
+		bic.bufferOffset = GetMipChainSize(m_CI.format, m_Width, m_Height, m_Depth, m_CI.arrayLayers, level);
+		bic.bufferRowLength = 0;
+		bic.bufferImageHeight = 0;
+		bic.imageSubresource.aspectMask = m_DepthTexture ? Image::AspectBit::DEPTH_BIT : Image::AspectBit::COLOUR_BIT;
+		bic.imageSubresource.mipLevel = level;
+		bic.imageSubresource.baseArrayLayer = 0;
+		bic.imageSubresource.arrayLayerCount = m_CI.arrayLayers;
+		bic.imageOffset = { 0, 0, 0 };
+		bic.imageExtent = { std::max(m_Width >> level, 1U), std::max(m_Height >> level, 1U), std::max(m_Depth >> level, 1U) };
+		bics.push_back(bic);
+	}
+	return bics;
+}
+
+size_t Texture::GetTexelSize(Image::Format format)
+{
+	switch (format)
+	{
+	case Image::Format::R8_UNORM:
+		return 1;
+	case Image::Format::BC1_RGBA_UNORM_BLOCK:
+	case Image::Format::BC1_RGBA_SRGB_BLOCK:
+	case Image::Format::BC4_UNORM_BLOCK:
+		return 8;
+	case Image::Format::BC3_UNORM_BLOCK:
+	case Image::Format::BC3_SRGB_BLOCK:
+	case Image::Format::BC5_UNORM_BLOCK:
+	case Image::Format::BC6H_UFLOAT_BLOCK:
+	case Image::Format::BC6H_SFLOAT_BLOCK:
+	case Image::Format::BC7_UNORM_BLOCK:
+	case Image::Format::BC7_SRGB_BLOCK:
+		return 16;
+	case Image::Format::R8G8_UNORM:
+	case Image::Format::D16_UNORM:
+		return 2;
+	case Image::Format::R16G16B16A16_SFLOAT:
+		return 8;
+	case Image::Format::R32G32B32A32_SFLOAT:
+		return 16;
+	case Image::Format::R8G8B8A8_UNORM:
+	case Image::Format::R8G8B8A8_SRGB:
+	case Image::Format::B8G8R8A8_UNORM:
+	case Image::Format::R32_SFLOAT:
+	case Image::Format::E5B9G9R9_UFLOAT_PACK32:
+	case Image::Format::B10G11R11_UFLOAT_PACK32:
+	case Image::Format::D32_SFLOAT:
+	default:
+		return 4;
+	}
+}
+
+bool Texture::IsStorageFormat(Image::Format format)
+{
+	return !IsBlockCompressed(format) && format != Image::Format::E5B9G9R9_UFLOAT_PACK32;
+}
+
+bool Texture::IsBlockCompressed(Image::Format format)
 {
-	if (m_CI.dataType == DataType::FILE && m_CI.file.filepaths && m_CI.file.count)
+	switch (format)
 	{
-		m_HDR = stbi_is_hdr(m_CI.file.filepaths[0].c_str());
-		uint8_t* stbiBuffer = nullptr;
-		float* stbiBufferf = nullptr;
+	case Image::Format::BC1_RGBA_UNORM_BLOCK:
+	case Image::Format::BC1_RGBA_SRGB_BLOCK:
+	case Image::Format::BC3_UNORM_BLOCK:
+	case Image::Format::BC3_SRGB_BLOCK:
+	case Image::Format::BC4_UNORM_BLOCK:
+	case Image::Format::BC5_UNORM_BLOCK:
+	case Image::Format::BC6H_UFLOAT_BLOCK:
+	case Image::Format::BC6H_SFLOAT_BLOCK:
+	case Image::Format::BC7_UNORM_BLOCK:
+	case Image::Format::BC7_SRGB_BLOCK:
+		return true;
+	default:
+		return false;
+	}
+}
+
+size_t Texture::GetRowPitch(Image::Format format, uint32_t width)
+{
+	if (IsBlockCompressed(format))
+		return ((static_cast<size_t>(width) + 3) / 4) * GetTexelSize(format);
+	else
+		return static_cast<size_t>(width) * GetTexelSize(format);
+}
+
+size_t Texture::GetMipLevelSize(Image::Format format, uint32_t width, uint32_t height, uint32_t depth, uint32_t arrayLayers, uint32_t level)
+{
+	const uint32_t levelWidth = std::max(width >> level, 1U);
+	const size_t levelHeight = std::max(height >> level, 1U);
+	const size_t levelDepth = std::max(depth >> level, 1U);
+	const size_t rows = IsBlockCompressed(format) ? (levelHeight + 3) / 4 : levelHeight;
+	return GetRowPitch(format, levelWidth) * rows * levelDepth * std::max(arrayLayers, 1U);
+}
+
+size_t Texture::GetMipChainSize(Image::Format format, uint32_t width, uint32_t height, uint32_t depth, uint32_t arrayLayers, uint32_t mipLevels)
+{
+	size_t size = 0;
+	for (uint32_t level = 0; level < mipLevels; level++)
+		size += GetMipLevelSize(format, width, height, depth, arrayLayers, level);
+	return size;
+}
+
+bool Texture::WriteCookedTexture(const std::string& filepath, CookedHeader header, const uint8_t* data)
+{
+	header.magic = GEAR_TEXTURE_COOKED_MAGIC;
+	header.version = GEAR_TEXTURE_COOKED_VERSION;
 
-		if (!m_Cubemap)
+	std::ofstream stream(filepath, std::ios::binary);
+	if (!stream.is_open())
+	{
+		GEAR_WARN(ErrorCode::GRAPHICS | ErrorCode::NO_FILE, "Unable to open %s.", filepath.c_str());
+		return false;
+	}
+	stream.write((const char*)&header, sizeof(CookedHeader));
+	stream.write((const char*)data, header.size);
+	stream.close();
+	return true;
+}
+
+bool Texture::IsCookedTextureFile(const std::string& filepath)
+{
+	const std::string extension = GEAR_TEXTURE_COOKED_FILE_EXTENSION;
+	return filepath.size() > extension.size() && filepath.compare(filepath.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+bool Texture::ReadCookedTexture(const std::string& filepath, CookedHeader& header, std::vector<uint8_t>& data)
+{
+	std::ifstream stream(filepath, std::ios::binary);
+	if (!stream.is_open())
+	{
+		GEAR_WARN(ErrorCode::GRAPHICS | ErrorCode::NO_FILE, "Unable to open %s.", filepath.c_str());
+		return false;
+	}
+
+	stream.read((char*)&header, sizeof(CookedHeader));
+	if (!stream || header.magic != GEAR_TEXTURE_COOKED_MAGIC || header.version != GEAR_TEXTURE_COOKED_VERSION
+		|| header.size < GetMipChainSize(header.format, header.width, header.height, header.depth, header.arrayLayers, header.mipLevels))
+	{
+		GEAR_WARN(ErrorCode::GRAPHICS | ErrorCode::LOAD_FAILED, "%s is not valid.", filepath.c_str());
+		return false;
+	}
+
+	data.resize(header.size);
+	stream.read((char*)data.data(), header.size);
+	if (!stream)
+	{
+		GEAR_WARN(ErrorCode::GRAPHICS | ErrorCode::LOAD_FAILED, "%s is not valid.", filepath.c_str());
+		return false;
+	}
+	return true;
+}
+
+Image::Format Texture::GetDecodeFormat(Image::Format format, bool hdrFile)
+{
+	const bool hdrFormat = format == Image::Format::R32G32B32A32_SFLOAT || format == Image::Format::R16G16B16A16_SFLOAT || format == Image::Format::E5B9G9R9_UFLOAT_PACK32;
+	return hdrFormat ? format : (hdrFile ? Image::Format::R32G32B32A32_SFLOAT : Image::Format::R8G8B8A8_UNORM);
+}
+
+bool Texture::LoadCookedTexture(const std::string& filepath, std::vector<uint8_t>& imageData)
+{
+	CookedHeader header;
+	if (!ReadCookedTexture(filepath, header, imageData))
+		return false;
+
+	if (header.arrayLayers != m_CI.arrayLayers || header.format != m_CI.format)
+	{
+		GEAR_WARN(ErrorCode::GRAPHICS | ErrorCode::INVALID_VALUE, "%s does not match the arrayLayers and format of Texture: %s. The cooked values are used.", filepath.c_str(), m_CI.debugName.c_str());
+		m_CI.arrayLayers = header.arrayLayers;
+		m_CI.format = header.format;
+	}
+
+	m_Width = header.width;
+	m_Height = header.height;
+	m_Depth = header.depth;
+	m_UploadMipLevels = std::max(header.mipLevels, 1U);
+	m_HDR = header.format == Image::Format::R32G32B32A32_SFLOAT || header.format == Image::Format::R16G16B16A16_SFLOAT || header.format == Image::Format::E5B9G9R9_UFLOAT_PACK32
+		|| header.format == Image::Format::BC6H_UFLOAT_BLOCK || header.format == Image::Format::BC6H_SFLOAT_BLOCK;
+	return true;
+}
+
+void Texture::LoadImageData(std::vector<uint8_t>& imageData)
+{
+	m_UploadMipLevels = 1;
+	if (m_CI.dataType == DataType::FILE && m_CI.file.filepaths && m_CI.file.count && IsCookedTextureFile(m_CI.file.filepaths[0]))
+	{
+		LoadCookedTexture(m_CI.file.filepaths[0], imageData);
+	}
+	else if (m_CI.dataType == DataType::FILE && m_CI.file.filepaths && m_CI.file.count)
+	{
+		//Cubemaps need a file per face. Other types load as many layers as there are files.
+		const uint32_t layerCount = static_cast<uint32_t>(std::min(m_CI.file.count, static_cast<size_t>(m_CI.arrayLayers)));
+		if (m_Cubemap && layerCount < m_CI.arrayLayers)
 		{
-			if (m_HDR)
-			{
-				stbiBufferf = stbi_loadf(m_CI.file.filepaths[0].c_str(), (int*)&m_Width, (int*)&m_Height, (int*)&m_BPP, 4);
-				imageData.resize(m_Width * m_Height * 4 * sizeof(float));
-				memcpy(imageData.data(), stbiBufferf, imageData.size());
-			}
-			else
-			{
-				stbiBuffer = stbi_load(m_CI.file.filepaths[0].c_str(), (int*)&m_Width, (int*)&m_Height, (int*)&m_BPP, 4);
-				imageData.resize(m_Width * m_Height * 4 * sizeof(uint8_t));
-				memcpy(imageData.data(), stbiBuffer, imageData.size());
-			}
+			GEAR_WARN(ErrorCode::GRAPHICS | ErrorCode::INVALID_VALUE, "Texture: %s has %d files for %d array layers. The remaining layers are blank.", m_CI.debugName.c_str(), layerCount, m_CI.arrayLayers);
 		}
-		else
+
+		ImageDecoder::ImageInfo info;
+		if (ImageDecoder::GetImageInfo(m_CI.file.filepaths[0], info))
 		{
-			for (size_t i = 0; i < m_CI.arrayLayers; i++)
+			const Image::Format decodeFormat = GetDecodeFormat(m_CI.format, info.hdr);
+			m_HDR = info.hdr || decodeFormat != Image::Format::R8G8B8A8_UNORM;
+			m_Width = info.width;
+			m_Height = info.height;
+			m_Depth = 1;
+			m_BPP = info.channels;
+			const size_t layerSize = size_t(m_Width) * size_t(m_Height) * GetTexelSize(decodeFormat);
+
+			//A single image is read already decoded from its cooked file in the asset database, if that is up to date.
+			bool decoded = false;
+			if (layerCount == 1 && AssetDatabase::GetAssetDatabase())
 			{
-				if (m_HDR)
-				{
-					stbiBufferf = stbi_loadf(m_CI.file.filepaths[i].c_str(), (int*)&m_Width, (int*)&m_Height, (int*)&m_BPP, 4);
-					if (i == 0)
-						imageData.resize(m_CI.arrayLayers * m_Width * m_Height * 4 * sizeof(float));
-
-					memcpy(imageData.data() + (i * (imageData.size() / m_CI.arrayLayers)), stbiBufferf, (imageData.size() / 6));
-				}
-				else
-				{
-					stbiBuffer = stbi_load(m_CI.file.filepaths[i].c_str(), (int*)&m_Width, (int*)&m_Height, (int*)&m_BPP, 4);
-					if (i == 0)
-						imageData.resize(m_CI.arrayLayers * m_Width * m_Height * 4 * sizeof(uint8_t));
-
-					memcpy(imageData.data() + (i * (imageData.size() / m_CI.arrayLayers)), stbiBuffer, (imageData.size() / 6));
-				}
+				const std::string cookedFilepath = AssetDatabase::GetAssetDatabase()->GetTexture(m_CI.file.filepaths[0], decodeFormat, m_CI.file.flipVertically);
+				CookedHeader header;
+				decoded = !cookedFilepath.empty() && ReadCookedTexture(cookedFilepath, header, imageData)
+					&& header.format == decodeFormat && header.width == m_Width && header.height == m_Height && header.size == layerSize;
 			}
 
+			//Every layer is decoded by a worker straight into its place in the data, converted to the decode format on the way.
+			if (!decoded)
+				imageData.clear();
+			imageData.resize(layerSize * m_CI.arrayLayers);
+			if (!decoded)
+				ImageDecoder::GetImageDecoder()->Decode(m_CI.file.filepaths, layerCount, m_Width, m_Height, decodeFormat, m_CI.file.flipVertically, imageData.data(), layerSize);
 		}
-
-		if (stbiBufferf)
-			stbi_image_free(stbiBufferf);
-		if (stbiBuffer)
-			stbi_image_free(stbiBuffer);
-
-		m_Depth = 1;
 	}
 	else if (m_CI.dataType == Texture::DataType::DATA)
 	{
@@ -295,10 +470,20 @@ void Texture::LoadImageData(std::vector<uint8_t>& imageData)
 		{
 			imageData.resize(m_CI.data.size);
 			memcpy(imageData.data(), m_CI.data.data, m_CI.data.size);
+
+			if (m_CI.data.mipLevels > 1)
+			{
+				const uint32_t maxLevels = static_cast<uint32_t>(log2(static_cast<double>(std::max({ m_Width, m_Height, m_Depth, 1U })))) + 1;
+				const uint32_t mipLevels = std::min(m_CI.data.mipLevels, maxLevels);
+				if (m_CI.data.size >= GetMipChainSize(m_CI.format, m_Width, m_Height, m_Depth, m_CI.arrayLayers, mipLevels))
+					m_UploadMipLevels = mipLevels;
+				else
+					GEAR_WARN(ErrorCode::GRAPHICS | ErrorCode::INVALID_VALUE, "Data is too small for %d mip levels in Texture: %s. Only level 0 is uploaded.", mipLevels, m_CI.debugName.c_str());
+			}
 		}
 		else
 		{
-			imageData.resize(m_CI.arrayLayers * m_Width * m_Height * 4 * sizeof(uint8_t)); //TODO: Channel and data type should based on the format.
+			imageData.resize(GetMipLevelSize(m_CI.format, m_Width, m_Height, m_Depth, m_CI.arrayLayers, 0));
 		}
 	}
 	else
@@ -22,14 +22,19 @@ namespace graphics
 			uint32_t		width;
 			uint32_t		height;
 			uint32_t		depth;
+			uint32_t		mipLevels;	//Levels present in data, largest first. Each level holds all its array layers. 0 or 1 for only the top level.
 		};
 		struct DataTypeFileParameters
 		{
-			const std::string*	filepaths;
+			const std::string*	filepaths;	//One per array layer. Every file must have the same extent.
 			size_t				count;
+			bool				flipVertically;
 		};
 
 		//Provide either filepaths or data, size and image dimension details.
+		//Files are decoded in parallel into RGBA texels, which are 32-bit floats for HDR files. HDR data is stored in the compact
+		//R16G16B16A16_SFLOAT or E5B9G9R9_UFLOAT_PACK32 formats when one of them is the format.
+		//A filepath ending in GEAR_TEXTURE_COOKED_FILE_EXTENSION is loaded as a cooked texture with all its levels and layers.
 		struct CreateInfo
 		{
 			std::string									debugName;
@@ -50,6 +55,23 @@ namespace graphics
 		};
 		#define GEAR_TEXTURE_MAX_MIP_LEVEL 16
 
+		//Header of a cooked texture file. The data of every level follows it, largest first, each level holding all its array layers.
+		struct CookedHeader
+		{
+			uint32_t							magic;
+			uint32_t							version;
+			miru::crossplatform::Image::Format	format;
+			uint32_t							width;
+			uint32_t							height;
+			uint32_t							depth;
+			uint32_t							mipLevels;
+			uint32_t							arrayLayers;
+			uint64_t							size;
+		};
+		#define GEAR_TEXTURE_COOKED_FILE_EXTENSION ".gtex"
+		#define GEAR_TEXTURE_COOKED_MAGIC 0x58455447 //'GTEX'
+		#define GEAR_TEXTURE_COOKED_VERSION 1
+
 		struct SubresouresTransitionInfo
 		{
 			miru::crossplatform::Barrier::AccessBit			srcAccess;
@@ -84,6 +106,7 @@ namespace graphics
 		bool m_DepthTexture = false;
 
 		bool m_Upload = false;
+		uint32_t m_UploadMipLevels = 1; //Levels present in the upload buffer.
 
 		float m_AnisotrophicValue = 1.0f;
 
@@ -105,6 +128,7 @@ namespace graphics
 		void Upload(const Ref<miru::crossplatform::CommandBuffer>& cmdBuffer, uint32_t cmdBufferIndex = 0, bool force = false);
 		void Download(const Ref<miru::crossplatform::CommandBuffer>& cmdBuffer, uint32_t cmdBufferIndex = 0, bool force = false);
 		void TransitionSubResources(std::vector<Ref<miru::crossplatform::Barrier>>& barriers, const std::vector<SubresouresTransitionInfo>& transitionInfos);
+		void TransitionSubResources(std::vector<Ref<miru::crossplatform::Barrier>>& barriers, const std::vector<SubresouresTransitionInfo>& transitionInfos, uint32_t srcQueueFamilyIndex, uint32_t dstQueueFamilyIndex);
 		void Reload();
 
 		void SubmitImageData(std::vector<uint8_t>& imageData);
@@ -121,14 +145,39 @@ namespace graphics
 		inline bool IsCubemap() const { return m_Cubemap; }
 		inline bool IsDepthTexture() const { return m_DepthTexture; }
 		inline bool IsUploaded() const { return m_Upload; }
+		inline size_t GetUploadSize() const { return m_TextureUploadBufferCI.size; }
+		inline uint32_t GetUploadMipLevels() const { return m_UploadMipLevels; }
+		inline size_t GetImageSize() const { return GetMipChainSize(m_CI.format, m_Width, m_Height, m_Depth, m_CI.arrayLayers, m_CI.mipLevels); }
 		inline const CreateInfo& GetCreateInfo() const { return m_CI; }
 
 		inline void SetAnisotrophicValue(float anisostrphicVal) { m_AnisotrophicValue = anisostrphicVal; CreateSampler(); };
 		inline float GetAnisotrophicValue() const { return m_AnisotrophicValue; };
 		inline std::string GetAnisotrophicValue() { return std::to_string(static_cast<int>(m_AnisotrophicValue)); }
 
+		//For block compressed formats, this is the size of a 4x4 block.
+		static size_t GetTexelSize(miru::crossplatform::Image::Format format);
+		static bool IsBlockCompressed(miru::crossplatform::Image::Format format);
+		//Block compressed and shared exponent formats can only be sampled, so their mips can not be generated.
+		static bool IsStorageFormat(miru::crossplatform::Image::Format format);
+		//Size in bytes of one row of texels, or one row of blocks for block compressed formats.
+		static size_t GetRowPitch(miru::crossplatform::Image::Format format, uint32_t width);
+		//Size in bytes of one mip level, including all its array layers. Block compressed levels are rounded up to whole blocks.
+		static size_t GetMipLevelSize(miru::crossplatform::Image::Format format, uint32_t width, uint32_t height, uint32_t depth, uint32_t arrayLayers, uint32_t level);
+		//Size in bytes of the first mipLevels levels. This is also the offset of level mipLevels in the upload buffer.
+		static size_t GetMipChainSize(miru::crossplatform::Image::Format format, uint32_t width, uint32_t height, uint32_t depth, uint32_t arrayLayers, uint32_t mipLevels);
+
+		//Writes the header and size bytes of data to a cooked texture file. The header's magic and version are set by this function.
+		static bool WriteCookedTexture(const std::string& filepath, CookedHeader header, const uint8_t* data);
+		//Reads and validates the header and data of a cooked texture file.
+		static bool ReadCookedTexture(const std::string& filepath, CookedHeader& header, std::vector<uint8_t>& data);
+		static bool IsCookedTextureFile(const std::string& filepath);
+		//The format that image files are decoded to for a texture of the format. hdrFile is whether the file holds HDR data.
+		static miru::crossplatform::Image::Format GetDecodeFormat(miru::crossplatform::Image::Format format, bool hdrFile);
+
 	private:
 		void CreateSampler();
+		std::vector<miru::crossplatform::Image::BufferImageCopy> GetBufferImageCopies(uint32_t mipLevels);
+		bool LoadCookedTexture(const std::string& filepath, std::vector<uint8_t>& imageData);
 
 		//This populates the parameter imageData. This should only be called in the constructor and Reload().
 		void LoadImageData(std::vector<uint8_t>& imageData);
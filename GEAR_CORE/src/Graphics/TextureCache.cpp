@@ -0,0 +1,199 @@
+#include "gear_core_common.h"
+#include "TextureCache.h"
+#include "Graphics/ImageDecoder.h"
+
+#include <filesystem>
+
+using namespace gear;
+using namespace graphics;
+
+using namespace miru;
+using namespace miru::crossplatform;
+
+std::map<void*, Ref<TextureCache>> TextureCache::s_TextureCaches;
+
+bool TextureCache::Key::operator<(const Key& other) const
+{
+	return std::tie(filepaths, format, type, mipLevels, arrayLayers, samples, usage, generateMipMaps, flipVertically)
+		< std::tie(other.filepaths, other.format, other.type, other.mipLevels, other.arrayLayers, other.samples, other.usage, other.generateMipMaps, other.flipVertically);
+}
+
+TextureCache::TextureCache(CreateInfo* pCreateInfo)
+{
+	m_CI = *pCreateInfo;
+}
+
+TextureCache::~TextureCache()
+{
+}
+
+const Ref<TextureCache>& TextureCache::GetTextureCache(void* device)
+{
+	Ref<TextureCache>& textureCache = s_TextureCaches[device];
+	if (!textureCache)
+	{
+		CreateInfo textureCacheCI;
+		textureCacheCI.debugName = "GEAR_CORE_TextureCache";
+		textureCacheCI.device = device;
+		textureCacheCI.memoryBudget = 1024 * 1024 * 1024;
+		textureCacheCI.frameLatency = 3;
+		textureCache = CreateRef<TextureCache>(&textureCacheCI);
+	}
+	return textureCache;
+}
+
+void TextureCache::ReleaseTextureCache(void* device)
+{
+	s_TextureCaches.erase(device);
+}
+
+Ref<Texture> TextureCache::GetTexture(Texture::CreateInfo* pCreateInfo)
+{
+	if (pCreateInfo->dataType != Texture::DataType::FILE || !pCreateInfo->file.filepaths || !pCreateInfo->file.count)
+		return CreateRef<Texture>(pCreateInfo);
+
+	Key key;
+	for (size_t i = 0; i < pCreateInfo->file.count; i++)
+	{
+		std::error_code error;
+		std::filesystem::path filepath = std::filesystem::weakly_canonical(pCreateInfo->file.filepaths[i], error);
+		key.filepaths.push_back(error ? pCreateInfo->file.filepaths[i] : filepath.string());
+	}
+	key.format = pCreateInfo->format;
+	key.type = pCreateInfo->type;
+	key.mipLevels = pCreateInfo->mipLevels;
+	key.arrayLayers = pCreateInfo->arrayLayers;
+	key.samples = pCreateInfo->samples;
+	key.usage = pCreateInfo->usage;
+	key.generateMipMaps = pCreateInfo->generateMipMaps;
+	key.flipVertically = pCreateInfo->file.flipVertically;
+
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	auto it = m_Entries.find(key);
+	if (it != m_Entries.end())
+	{
+		Entry& entry = it->second;
+		entry.lastUsedFrame = m_FrameCount;
+		m_LRU.splice(m_LRU.end(), m_LRU, entry.lruIterator);
+		m_Statistics.hits++;
+		if (entry.texture)
+			return entry.texture;
+
+		std::shared_future<Ref<Texture>> creation = entry.creation;
+		lock.unlock();
+		return creation.get();
+	}
+
+	//The texture is created without holding the lock, so that other textures can be loaded in parallel.
+	std::promise<Ref<Texture>> promise;
+	Entry entry;
+	entry.texture = nullptr;
+	entry.creation = promise.get_future().share();
+	entry.size = 0;
+	entry.lastUsedFrame = m_FrameCount;
+	it = m_Entries.emplace(std::move(key), std::move(entry)).first;
+	it->second.lruIterator = m_LRU.insert(m_LRU.end(), &it->first);
+	m_Statistics.misses++;
+	lock.unlock();
+
+	Ref<Texture> texture;
+	try
+	{
+		texture = CreateRef<Texture>(pCreateInfo);
+	}
+	catch (...)
+	{
+		//Threads waiting on the entry receive the exception, and the next request tries again.
+		promise.set_exception(std::current_exception());
+		lock.lock();
+		m_LRU.erase(it->second.lruIterator);
+		m_Entries.erase(it);
+		throw;
+	}
+	promise.set_value(texture);
+
+	lock.lock();
+	it->second.texture = texture;
+	it->second.creation = {};
+	it->second.size = texture->GetImageSize();
+	m_Statistics.residentBytes += it->second.size;
+
+	//Make room for the new texture, which is in use.
+	Evict(m_CI.memoryBudget);
+	return texture;
+}
+
+std::vector<Ref<Texture>> TextureCache::GetTextures(const std::vector<Texture::CreateInfo*>& createInfos)
+{
+	//Each texture is created on one worker, which also decodes all of its layers.
+	std::vector<Ref<Texture>> textures(createInfos.size());
+	ImageDecoder::GetImageDecoder()->GetThreadPool()->ParallelFor(createInfos.size(),
+		[&](size_t begin, size_t end, uint32_t)
+		{
+			for (size_t i = begin; i < end; i++)
+				textures[i] = GetTexture(createInfos[i]);
+		});
+	return textures;
+}
+
+void TextureCache::NextFrame()
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	m_FrameCount++;
+
+	//A texture is in use while anything other than the cache holds a reference to it.
+	//Textures in use are moved to the back, so only the entries present at the start are visited.
+	auto it = m_LRU.begin();
+	for (size_t i = m_LRU.size(); i > 0; i--)
+	{
+		auto next = std::next(it);
+		Entry& entry = m_Entries.at(**it);
+		if (!entry.texture || entry.texture.use_count() > 1)
+		{
+			entry.lastUsedFrame = m_FrameCount;
+			m_LRU.splice(m_LRU.end(), m_LRU, it);
+		}
+		it = next;
+	}
+
+	Evict(m_CI.memoryBudget);
+}
+
+void TextureCache::EvictUnused()
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	Evict(0);
+}
+
+TextureCache::Statistics TextureCache::GetStatistics()
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	Statistics statistics = m_Statistics;
+	statistics.textures = static_cast<uint32_t>(m_Entries.size());
+	statistics.unusedTextures = 0;
+	for (auto& entry : m_Entries)
+	{
+		if (entry.second.texture && entry.second.texture.use_count() == 1)
+			statistics.unusedTextures++;
+	}
+	return statistics;
+}
+
+void TextureCache::Evict(size_t targetSize)
+{
+	for (auto it = m_LRU.begin(); it != m_LRU.end() && m_Statistics.residentBytes > targetSize;)
+	{
+		auto entryIt = m_Entries.find(**it);
+		const Entry& entry = entryIt->second;
+		if (!entry.texture || entry.texture.use_count() > 1 || m_FrameCount - entry.lastUsedFrame < m_CI.frameLatency)
+		{
+			it++;
+			continue;
+		}
+
+		m_Statistics.residentBytes -= entry.size;
+		m_Statistics.evictions++;
+		it = m_LRU.erase(it);
+		m_Entries.erase(entryIt);
+	}
+}
\ No newline at end of file
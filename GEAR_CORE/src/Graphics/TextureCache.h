@@ -0,0 +1,100 @@
+#pragma once
+
+#include "gear_core_common.h"
+#include "Graphics/Texture.h"
+
+namespace gear
+{
+namespace graphics
+{
+	//Shares textures loaded from files. Textures are keyed by their canonical filepaths and the settings that change
+	//their contents, so every request for the same image gets the same Texture. The cache holds a reference to each
+	//texture, and once no one else does, the texture can be evicted in least recently used order to stay in the budget.
+	class TextureCache
+	{
+	public:
+		struct CreateInfo
+		{
+			std::string	debugName;
+			void*		device;
+			size_t		memoryBudget;	//In bytes of GPU memory. Textures in use are never evicted, so this can be exceeded.
+			uint32_t	frameLatency;	//Number of frames a texture must be unused for before it can be evicted.
+		};
+
+		struct Statistics
+		{
+			uint64_t	hits;
+			uint64_t	misses;
+			uint64_t	evictions;
+			uint64_t	residentBytes;
+			uint32_t	textures;
+			uint32_t	unusedTextures;
+		};
+
+	private:
+		struct Key
+		{
+			std::vector<std::string>					filepaths;
+			miru::crossplatform::Image::Format			format;
+			miru::crossplatform::Image::Type			type;
+			uint32_t									mipLevels;
+			uint32_t									arrayLayers;
+			miru::crossplatform::Image::SampleCountBit	samples;
+			miru::crossplatform::Image::UsageBit		usage;
+			bool										generateMipMaps;
+			bool										flipVertically;
+
+			bool operator<(const Key& other) const;
+		};
+
+		struct Entry
+		{
+			Ref<Texture>						texture;	//Null while the texture is being created.
+			std::shared_future<Ref<Texture>>	creation;	//Waited on by requests made during its creation.
+			size_t								size;
+			uint64_t							lastUsedFrame;
+			std::list<const Key*>::iterator		lruIterator;
+		};
+
+		CreateInfo m_CI;
+
+		std::mutex m_Mutex;
+		std::map<Key, Entry> m_Entries;
+		std::list<const Key*> m_LRU;	//Least recently used first.
+		uint64_t m_FrameCount = 0;
+		Statistics m_Statistics = {};
+
+		static std::map<void*, Ref<TextureCache>> s_TextureCaches;
+
+	public:
+		TextureCache(CreateInfo* pCreateInfo);
+		~TextureCache();
+
+		const CreateInfo& GetCreateInfo() { return m_CI; }
+		inline void SetMemoryBudget(size_t memoryBudget) { m_CI.memoryBudget = memoryBudget; }
+		inline void SetFrameLatency(uint32_t frameLatency) { m_CI.frameLatency = frameLatency; }
+
+		//Returns the shared cache of the device, which is created on first use.
+		static const Ref<TextureCache>& GetTextureCache(void* device);
+		//Releases the shared cache of the device, which must be idle. Call before the device is destroyed.
+		static void ReleaseTextureCache(void* device);
+
+		//Returns the cached texture of the files, or creates it. Textures from DATA are not cached and are always created.
+		//This is thread safe. Different textures are created in parallel, and concurrent requests for one texture wait on its creation.
+		Ref<Texture> GetTexture(Texture::CreateInfo* pCreateInfo);
+		//Returns a texture for each CreateInfo, which are created in parallel on the workers of the shared ImageDecoder.
+		std::vector<Ref<Texture>> GetTextures(const std::vector<Texture::CreateInfo*>& createInfos);
+
+		//Call once per frame. Marks the textures in use and evicts unused textures, least recently used first, until the
+		//resident textures fit in the budget.
+		void NextFrame();
+		//Evicts every texture that has been unused for frameLatency frames, regardless of the budget.
+		void EvictUnused();
+
+		Statistics GetStatistics();
+
+	private:
+		void Evict(size_t targetSize);
+	};
+}
+}
\ No newline at end of file
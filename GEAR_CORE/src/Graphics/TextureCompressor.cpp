@@ -0,0 +1,1063 @@
+#include "gear_core_common.h"
+#include "TextureCompressor.h"
+#include "Graphics/Texture.h"
+#include "stb_image.h"
+
+#include <cfloat>
+#include <filesystem>
+#include <limits>
+
+using namespace gear;
+using namespace graphics;
+
+using namespace miru;
+using namespace miru::crossplatform;
+
+//Helpers
+
+//128-bit block, written and read least significant bit first.
+struct BlockBits
+{
+	uint64_t data[2] = { 0, 0 };
+	uint32_t position = 0;
+
+	void Write(uint32_t value, uint32_t bitCount)
+	{
+		for (uint32_t i = 0; i < bitCount; i++, position++)
+			data[position / 64] |= uint64_t((value >> i) & 1) << (position % 64);
+	}
+	uint32_t Read(uint32_t bitCount)
+	{
+		uint32_t value = 0;
+		for (uint32_t i = 0; i < bitCount; i++, position++)
+			value |= uint32_t((data[position / 64] >> (position % 64)) & 1) << i;
+		return value;
+	}
+};
+
+//One mip level of one array layer.
+struct Surface
+{
+	size_t		srcOffset;
+	size_t		dstOffset;
+	uint32_t	width;
+	uint32_t	height;
+	uint32_t	blocksX;
+	size_t		firstBlock;
+};
+
+static const uint32_t BC7Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+static std::vector<Surface> GetSurfaces(Image::Format format, Image::Format texelFormat, uint32_t width, uint32_t height, uint32_t arrayLayers, uint32_t mipLevels, size_t& blockCount)
+{
+	std::vector<Surface> surfaces;
+	blockCount = 0;
+	for (uint32_t level = 0; level < mipLevels; level++)
+	{
+		const uint32_t levelWidth = std::max(width >> level, 1U);
+		const uint32_t levelHeight = std::max(height >> level, 1U);
+		const uint32_t blocksX = (levelWidth + 3) / 4;
+		const uint32_t blocksY = (levelHeight + 3) / 4;
+		const size_t texelLevelOffset = Texture::GetMipChainSize(texelFormat, width, height, 1, arrayLayers, level);
+		const size_t blockLevelOffset = Texture::GetMipChainSize(format, width, height, 1, arrayLayers, level);
+
+		for (uint32_t layer = 0; layer < arrayLayers; layer++)
+		{
+			Surface surface;
+			surface.srcOffset = texelLevelOffset + layer * Texture::GetMipLevelSize(texelFormat, levelWidth, levelHeight, 1, 1, 0);
+			surface.dstOffset = blockLevelOffset + layer * Texture::GetMipLevelSize(format, levelWidth, levelHeight, 1, 1, 0);
+			surface.width = levelWidth;
+			surface.height = levelHeight;
+			surface.blocksX = blocksX;
+			surface.firstBlock = blockCount;
+			surfaces.push_back(surface);
+			blockCount += size_t(blocksX) * blocksY;
+		}
+	}
+	return surfaces;
+}
+
+static float HalfToFloat(uint16_t half)
+{
+	uint32_t sign = uint32_t(half & 0x8000) << 16;
+	uint32_t exponent = (half >> 10) & 0x1F;
+	uint32_t mantissa = half & 0x3FF;
+	uint32_t bits;
+	if (exponent == 0)
+	{
+		if (mantissa == 0)
+		{
+			bits = sign;
+		}
+		else
+		{
+			exponent = 113;
+			while (!(mantissa & 0x400))
+			{
+				mantissa <<= 1;
+				exponent--;
+			}
+			bits = sign | (exponent << 23) | ((mantissa & 0x3FF) << 13);
+		}
+	}
+	else if (exponent == 31)
+		bits = sign | 0x7F800000 | (mantissa << 13);
+	else
+		bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+
+	float value;
+	memcpy(&value, &bits, sizeof(float));
+	return value;
+}
+
+//Unsigned half with round to nearest even, clamped to the largest finite value as BC6H can not store infinities.
+static uint16_t FloatToUnsignedHalf(float value)
+{
+	if (!(value > 0.0f))
+		return 0;
+
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(float));
+	int32_t exponent = int32_t((bits >> 23) & 0xFF) - 127 + 15;
+	uint32_t mantissa = bits & 0x7FFFFF;
+	if (exponent >= 31)
+		return 0x7BFF;
+
+	if (exponent <= 0)
+	{
+		if (exponent < -10)
+			return 0;
+		mantissa |= 0x800000;
+		const uint32_t shift = uint32_t(14 - exponent);
+		uint32_t half = mantissa >> shift;
+		const uint32_t remainder = mantissa & ((1U << shift) - 1);
+		const uint32_t midpoint = 1U << (shift - 1);
+		if (remainder > midpoint || (remainder == midpoint && (half & 1)))
+			half++;
+		return uint16_t(half);
+	}
+
+	uint32_t half = (uint32_t(exponent) << 10) | (mantissa >> 13);
+	const uint32_t remainder = mantissa & 0x1FFF;
+	if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+		half++;
+	return uint16_t(std::min(half, 0x7BFFU));
+}
+
+//Copies the 4x4 block at (blockX, blockY), repeating the last row and column past the edge of the surface.
+template<typename T>
+static void FetchBlock(const T* texels, uint32_t width, uint32_t height, uint32_t blockX, uint32_t blockY, float block[16][4])
+{
+	for (uint32_t y = 0; y < 4; y++)
+	{
+		const uint32_t texelY = std::min(blockY * 4 + y, height - 1);
+		for (uint32_t x = 0; x < 4; x++)
+		{
+			const uint32_t texelX = std::min(blockX * 4 + x, width - 1);
+			const T* texel = texels + (size_t(texelY) * width + texelX) * 4;
+			for (uint32_t c = 0; c < 4; c++)
+				block[y * 4 + x][c] = static_cast<float>(texel[c]);
+		}
+	}
+}
+
+template<typename T>
+static void StoreBlock(T* texels, uint32_t width, uint32_t height, uint32_t blockX, uint32_t blockY, const float block[16][4])
+{
+	for (uint32_t y = 0; y < 4 && blockY * 4 + y < height; y++)
+	{
+		for (uint32_t x = 0; x < 4 && blockX * 4 + x < width; x++)
+		{
+			T* texel = texels + (size_t(blockY * 4 + y) * width + (blockX * 4 + x)) * 4;
+			for (uint32_t c = 0; c < 4; c++)
+				texel[c] = static_cast<T>(block[y * 4 + x][c]);
+		}
+	}
+}
+
+//Finds the endpoints of the line through the texels' principal axis, which bound the projections of the texels.
+static void FindEndpoints(const float block[16][4], uint32_t channelCount, float endpoint0[4], float endpoint1[4])
+{
+	float mean[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	for (uint32_t i = 0; i < 16; i++)
+		for (uint32_t c = 0; c < channelCount; c++)
+			mean[c] += block[i][c] / 16.0f;
+
+	float covariance[4][4] = {};
+	for (uint32_t i = 0; i < 16; i++)
+		for (uint32_t a = 0; a < channelCount; a++)
+			for (uint32_t b = 0; b < channelCount; b++)
+				covariance[a][b] += (block[i][a] - mean[a]) * (block[i][b] - mean[b]);
+
+	//Power iteration for the principal axis.
+	float axis[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+	for (uint32_t iteration = 0; iteration < 8; iteration++)
+	{
+		float next[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		float length = 0.0f;
+		for (uint32_t a = 0; a < channelCount; a++)
+		{
+			for (uint32_t b = 0; b < channelCount; b++)
+				next[a] += covariance[a][b] * axis[b];
+			length = std::max(length, std::abs(next[a]));
+		}
+		if (length == 0.0f)
+			break;
+		for (uint32_t c = 0; c < channelCount; c++)
+			axis[c] = next[c] / length;
+	}
+
+	float minProjection = FLT_MAX, maxProjection = -FLT_MAX;
+	for (uint32_t i = 0; i < 16; i++)
+	{
+		float projection = 0.0f;
+		for (uint32_t c = 0; c < channelCount; c++)
+			projection += (block[i][c] - mean[c]) * axis[c];
+		minProjection = std::min(minProjection, projection);
+		maxProjection = std::max(maxProjection, projection);
+	}
+
+	float axisLengthSq = 0.0f;
+	for (uint32_t c = 0; c < channelCount; c++)
+		axisLengthSq += axis[c] * axis[c];
+	axisLengthSq = std::max(axisLengthSq, FLT_MIN);
+
+	for (uint32_t c = 0; c < channelCount; c++)
+	{
+		endpoint0[c] = mean[c] + axis[c] * maxProjection / axisLengthSq;
+		endpoint1[c] = mean[c] + axis[c] * minProjection / axisLengthSq;
+	}
+}
+
+//Solves for the endpoints that minimise the error of the given weights of endpoint1, in [0, 1].
+static bool RefineEndpoints(const float block[16][4], uint32_t channelCount, const float weights[16], float endpoint0[4], float endpoint1[4])
+{
+	float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+	float ax[4] = {}, bx[4] = {};
+	for (uint32_t i = 0; i < 16; i++)
+	{
+		const float b = weights[i];
+		const float a = 1.0f - b;
+		aa += a * a;
+		ab += a * b;
+		bb += b * b;
+		for (uint32_t c = 0; c < channelCount; c++)
+		{
+			ax[c] += a * block[i][c];
+			bx[c] += b * block[i][c];
+		}
+	}
+	const float determinant = aa * bb - ab * ab;
+	if (std::abs(determinant) < 1e-6f)
+		return false;
+
+	for (uint32_t c = 0; c < channelCount; c++)
+	{
+		endpoint0[c] = (bb * ax[c] - ab * bx[c]) / determinant;
+		endpoint1[c] = (aa * bx[c] - ab * ax[c]) / determinant;
+	}
+	return true;
+}
+
+//BC1 colour
+
+static uint16_t PackRGB565(const float colour[4])
+{
+	const uint32_t r = static_cast<uint32_t>(std::clamp(colour[0], 0.0f, 255.0f) * 31.0f / 255.0f + 0.5f);
+	const uint32_t g = static_cast<uint32_t>(std::clamp(colour[1], 0.0f, 255.0f) * 63.0f / 255.0f + 0.5f);
+	const uint32_t b = static_cast<uint32_t>(std::clamp(colour[2], 0.0f, 255.0f) * 31.0f / 255.0f + 0.5f);
+	return uint16_t((r << 11) | (g << 5) | b);
+}
+
+static void UnpackRGB565(uint16_t packed, float colour[4])
+{
+	const uint32_t r = (packed >> 11) & 0x1F;
+	const uint32_t g = (packed >> 5) & 0x3F;
+	const uint32_t b = packed & 0x1F;
+	colour[0] = static_cast<float>((r << 3) | (r >> 2));
+	colour[1] = static_cast<float>((g << 2) | (g >> 4));
+	colour[2] = static_cast<float>((b << 3) | (b >> 2));
+	colour[3] = 255.0f;
+}
+
+static void GetColourPalette(uint16_t colour0, uint16_t colour1, bool fourColours, float palette[4][4])
+{
+	UnpackRGB565(colour0, palette[0]);
+	UnpackRGB565(colour1, palette[1]);
+	for (uint32_t c = 0; c < 4; c++)
+	{
+		if (fourColours)
+		{
+			palette[2][c] = std::floor((2.0f * palette[0][c] + palette[1][c]) / 3.0f);
+			palette[3][c] = std::floor((palette[0][c] + 2.0f * palette[1][c]) / 3.0f);
+		}
+		else
+		{
+			palette[2][c] = std::floor((palette[0][c] + palette[1][c]) / 2.0f);
+			palette[3][c] = 0.0f;
+		}
+	}
+}
+
+static float FindIndices(const float block[16][4], const float palette[][4], uint32_t paletteSize, uint32_t channelCount, uint32_t indices[16])
+{
+	float totalError = 0.0f;
+	for (uint32_t i = 0; i < 16; i++)
+	{
+		float bestError = FLT_MAX;
+		for (uint32_t p = 0; p < paletteSize; p++)
+		{
+			float error = 0.0f;
+			for (uint32_t c = 0; c < channelCount; c++)
+				error += (block[i][c] - palette[p][c]) * (block[i][c] - palette[p][c]);
+			if (error < bestError)
+			{
+				bestError = error;
+				indices[i] = p;
+			}
+		}
+		totalError += bestError;
+	}
+	return totalError;
+}
+
+//Always encodes in four colour mode, which is the only mode of the colour block of BC3.
+static void EncodeColourBlock(const float block[16][4], uint8_t* dst)
+{
+	float endpoint0[4], endpoint1[4];
+	FindEndpoints(block, 3, endpoint0, endpoint1);
+
+	uint16_t colour0 = PackRGB565(endpoint0);
+	uint16_t colour1 = PackRGB565(endpoint1);
+	if (colour0 < colour1)
+		std::swap(colour0, colour1);
+
+	float palette[4][4];
+	uint32_t indices[16];
+	GetColourPalette(colour0, colour1, true, palette);
+	float error = FindIndices(block, palette, 4, 3, indices);
+
+	//One least squares refinement of the endpoints from the chosen indices.
+	static const float weights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+	float indexWeights[16];
+	for (uint32_t i = 0; i < 16; i++)
+		indexWeights[i] = weights[indices[i]];
+	if (colour0 != colour1 && RefineEndpoints(block, 3, indexWeights, endpoint0, endpoint1))
+	{
+		uint16_t refinedColour0 = PackRGB565(endpoint0);
+		uint16_t refinedColour1 = PackRGB565(endpoint1);
+		if (refinedColour0 < refinedColour1)
+			std::swap(refinedColour0, refinedColour1);
+
+		float refinedPalette[4][4];
+		uint32_t refinedIndices[16];
+		GetColourPalette(refinedColour0, refinedColour1, true, refinedPalette);
+		const float refinedError = FindIndices(block, refinedPalette, 4, 3, refinedIndices);
+		if (refinedError < error && refinedColour0 != refinedColour1)
+		{
+			colour0 = refinedColour0;
+			colour1 = refinedColour1;
+			memcpy(indices, refinedIndices, sizeof(indices));
+		}
+	}
+
+	uint32_t packedIndices = 0;
+	if (colour0 != colour1)
+	{
+		for (uint32_t i = 0; i < 16; i++)
+			packedIndices |= indices[i] << (2 * i);
+	}
+	memcpy(dst + 0, &colour0, sizeof(uint16_t));
+	memcpy(dst + 2, &colour1, sizeof(uint16_t));
+	memcpy(dst + 4, &packedIndices, sizeof(uint32_t));
+}
+
+static void DecodeColourBlock(const uint8_t* src, bool forceFourColours, float block[16][4])
+{
+	uint16_t colour0, colour1;
+	uint32_t packedIndices;
+	memcpy(&colour0, src + 0, sizeof(uint16_t));
+	memcpy(&colour1, src + 2, sizeof(uint16_t));
+	memcpy(&packedIndices, src + 4, sizeof(uint32_t));
+
+	float palette[4][4];
+	GetColourPalette(colour0, colour1, forceFourColours || colour0 > colour1, palette);
+	for (uint32_t i = 0; i < 16; i++)
+	{
+		const uint32_t index = (packedIndices >> (2 * i)) & 0x3;
+		for (uint32_t c = 0; c < 3; c++)
+			block[i][c] = palette[index][c];
+		block[i][3] = (!forceFourColours && colour0 <= colour1 && index == 3) ? 0.0f : 255.0f;
+	}
+}
+
+//BC4 single channel
+
+static void GetSingleChannelPalette(uint32_t value0, uint32_t value1, float palette[8][4])
+{
+	palette[0][0] = float(value0);
+	palette[1][0] = float(value1);
+	for (uint32_t i = 2; i < 8; i++)
+	{
+		if (value0 > value1)
+			palette[i][0] = float(((8 - i) * value0 + (i - 1) * value1) / 7);
+		else if (i < 6)
+			palette[i][0] = float(((6 - i) * value0 + (i - 1) * value1) / 5);
+		else
+			palette[i][0] = i == 6 ? 0.0f : 255.0f;
+	}
+}
+
+static void EncodeSingleChannelBlock(const float block[16][4], uint32_t channel, uint8_t* dst)
+{
+	float values[16][4];
+	float minValue = 255.0f, maxValue = 0.0f;
+	for (uint32_t i = 0; i < 16; i++)
+	{
+		values[i][0] = block[i][channel];
+		minValue = std::min(minValue, values[i][0]);
+		maxValue = std::max(maxValue, values[i][0]);
+	}
+
+	const uint32_t value0 = static_cast<uint32_t>(std::clamp(maxValue, 0.0f, 255.0f) + 0.5f);
+	const uint32_t value1 = static_cast<uint32_t>(std::clamp(minValue, 0.0f, 255.0f) + 0.5f);
+	uint32_t indices[16] = {};
+	if (value0 != value1)
+	{
+		float palette[8][4];
+		GetSingleChannelPalette(value0, value1, palette);
+		FindIndices(values, palette, 8, 1, indices);
+	}
+
+	uint64_t packedIndices = 0;
+	for (uint32_t i = 0; i < 16; i++)
+		packedIndices |= uint64_t(indices[i]) << (3 * i);
+
+	dst[0] = uint8_t(value0);
+	dst[1] = uint8_t(value1);
+	for (uint32_t i = 0; i < 6; i++)
+		dst[2 + i] = uint8_t(packedIndices >> (8 * i));
+}
+
+static void DecodeSingleChannelBlock(const uint8_t* src, uint32_t channel, float block[16][4])
+{
+	float palette[8][4];
+	GetSingleChannelPalette(src[0], src[1], palette);
+
+	uint64_t packedIndices = 0;
+	for (uint32_t i = 0; i < 6; i++)
+		packedIndices |= uint64_t(src[2 + i]) << (8 * i);
+
+	for (uint32_t i = 0; i < 16; i++)
+		block[i][channel] = palette[(packedIndices >> (3 * i)) & 0x7][0];
+}
+
+//BC7 mode 6: 7-bit RGBA endpoints with a p-bit each and 4-bit indices.
+
+static void QuantiseBC7Endpoint(const float endpoint[4], uint32_t quantised[4], uint32_t& pBit)
+{
+	float bestError = FLT_MAX;
+	for (uint32_t p = 0; p < 2; p++)
+	{
+		uint32_t candidate[4];
+		float error = 0.0f;
+		for (uint32_t c = 0; c < 4; c++)
+		{
+			candidate[c] = static_cast<uint32_t>(std::clamp((endpoint[c] - float(p)) / 2.0f + 0.5f, 0.0f, 127.0f));
+			const float reconstructed = float((candidate[c] << 1) | p);
+			error += (reconstructed - endpoint[c]) * (reconstructed - endpoint[c]);
+		}
+		if (error < bestError)
+		{
+			bestError = error;
+			pBit = p;
+			memcpy(quantised, candidate, sizeof(candidate));
+		}
+	}
+}
+
+static void GetBC7Palette(const uint32_t quantised0[4], uint32_t pBit0, const uint32_t quantised1[4], uint32_t pBit1, float palette[16][4])
+{
+	for (uint32_t c = 0; c < 4; c++)
+	{
+		const uint32_t value0 = (quantised0[c] << 1) | pBit0;
+		const uint32_t value1 = (quantised1[c] << 1) | pBit1;
+		for (uint32_t i = 0; i < 16; i++)
+			palette[i][c] = float(((64 - BC7Weights4[i]) * value0 + BC7Weights4[i] * value1 + 32) >> 6);
+	}
+}
+
+static void EncodeBC7Block(const float block[16][4], uint8_t* dst)
+{
+	float endpoint0[4], endpoint1[4];
+	FindEndpoints(block, 4, endpoint0, endpoint1);
+
+	uint32_t quantised0[4], quantised1[4], pBit0, pBit1;
+	QuantiseBC7Endpoint(endpoint0, quantised0, pBit0);
+	QuantiseBC7Endpoint(endpoint1, quantised1, pBit1);
+
+	float palette[16][4];
+	uint32_t indices[16];
+	GetBC7Palette(quantised0, pBit0, quantised1, pBit1, palette);
+	float error = FindIndices(block, palette, 16, 4, indices);
+
+	float indexWeights[16];
+	for (uint32_t i = 0; i < 16; i++)
+		indexWeights[i] = float(BC7Weights4[indices[i]]) / 64.0f;
+	if (RefineEndpoints(block, 4, indexWeights, endpoint0, endpoint1))
+	{
+		uint32_t refinedQuantised0[4], refinedQuantised1[4], refinedPBit0, refinedPBit1;
+		QuantiseBC7Endpoint(endpoint0, refinedQuantised0, refinedPBit0);
+		QuantiseBC7Endpoint(endpoint1, refinedQuantised1, refinedPBit1);
+
+		float refinedPalette[16][4];
+		uint32_t refinedIndices[16];
+		GetBC7Palette(refinedQuantised0, refinedPBit0, refinedQuantised1, refinedPBit1, refinedPalette);
+		const float refinedError = FindIndices(block, refinedPalette, 16, 4, refinedIndices);
+		if (refinedError < error)
+		{
+			memcpy(quantised0, refinedQuantised0, sizeof(quantised0));
+			memcpy(quantised1, refinedQuantised1, sizeof(quantised1));
+			pBit0 = refinedPBit0;
+			pBit1 = refinedPBit1;
+			memcpy(indices, refinedIndices, sizeof(indices));
+		}
+	}
+
+	//The most significant bit of the first index is implicitly 0.
+	if (indices[0] & 0x8)
+	{
+		std::swap(quantised0, quantised1);
+		std::swap(pBit0, pBit1);
+		for (uint32_t i = 0; i < 16; i++)
+			indices[i] = 15 - indices[i];
+	}
+
+	BlockBits bits;
+	bits.Write(1 << 6, 7);
+	for (uint32_t c = 0; c < 4; c++)
+	{
+		bits.Write(quantised0[c], 7);
+		bits.Write(quantised1[c], 7);
+	}
+	bits.Write(pBit0, 1);
+	bits.Write(pBit1, 1);
+	for (uint32_t i = 0; i < 16; i++)
+		bits.Write(indices[i], i == 0 ? 3 : 4);
+	memcpy(dst, bits.data, sizeof(bits.data));
+}
+
+static bool DecodeBC7Block(const uint8_t* src, float block[16][4])
+{
+	BlockBits bits;
+	memcpy(bits.data, src, sizeof(bits.data));
+	if (bits.Read(7) != (1 << 6))
+		return false;
+
+	uint32_t quantised0[4], quantised1[4];
+	for (uint32_t c = 0; c < 4; c++)
+	{
+		quantised0[c] = bits.Read(7);
+		quantised1[c] = bits.Read(7);
+	}
+	const uint32_t pBit0 = bits.Read(1);
+	const uint32_t pBit1 = bits.Read(1);
+
+	float palette[16][4];
+	GetBC7Palette(quantised0, pBit0, quantised1, pBit1, palette);
+	for (uint32_t i = 0; i < 16; i++)
+		memcpy(block[i], palette[bits.Read(i == 0 ? 3 : 4)], sizeof(block[i]));
+	return true;
+}
+
+//BC6H mode 11: 10-bit unsigned RGB endpoints and 4-bit indices. Texels are compared as half floats bit patterns,
+//which are close to logarithmic, so the error is spread evenly over the range of the block.
+
+static uint32_t UnquantiseBC6H(uint32_t value)
+{
+	if (value == 0)
+		return 0;
+	if (value == 1023)
+		return 0xFFFF;
+	return ((value << 16) + 0x8000) >> 10;
+}
+
+static void GetBC6HPalette(const uint32_t quantised0[3], const uint32_t quantised1[3], float palette[16][4])
+{
+	for (uint32_t c = 0; c < 3; c++)
+	{
+		const uint32_t value0 = UnquantiseBC6H(quantised0[c]);
+		const uint32_t value1 = UnquantiseBC6H(quantised1[c]);
+		for (uint32_t i = 0; i < 16; i++)
+			palette[i][c] = float((((((64 - BC7Weights4[i]) * value0 + BC7Weights4[i] * value1 + 32) >> 6)) * 31) >> 6);
+	}
+	for (uint32_t i = 0; i < 16; i++)
+		palette[i][3] = 0.0f;
+}
+
+static void QuantiseBC6HEndpoint(const float endpoint[4], uint32_t quantised[3])
+{
+	for (uint32_t c = 0; c < 3; c++)
+		quantised[c] = static_cast<uint32_t>(std::clamp((endpoint[c] * 64.0f / 31.0f - 32.0f) / 64.0f + 0.5f, 0.0f, 1023.0f));
+}
+
+static void EncodeBC6HBlock(const float block[16][4], uint8_t* dst)
+{
+	float halfBlock[16][4];
+	for (uint32_t i = 0; i < 16; i++)
+	{
+		for (uint32_t c = 0; c < 3; c++)
+			halfBlock[i][c] = float(FloatToUnsignedHalf(block[i][c]));
+		halfBlock[i][3] = 0.0f;
+	}
+
+	float endpoint0[4], endpoint1[4];
+	FindEndpoints(halfBlock, 3, endpoint0, endpoint1);
+
+	uint32_t quantised0[3], quantised1[3];
+	QuantiseBC6HEndpoint(endpoint0, quantised0);
+	QuantiseBC6HEndpoint(endpoint1, quantised1);
+
+	float palette[16][4];
+	uint32_t indices[16];
+	GetBC6HPalette(quantised0, quantised1, palette);
+	float error = FindIndices(halfBlock, palette, 16, 3, indices);
+
+	float indexWeights[16];
+	for (uint32_t i = 0; i < 16; i++)
+		indexWeights[i] = float(BC7Weights4[indices[i]]) / 64.0f;
+	if (RefineEndpoints(halfBlock, 3, indexWeights, endpoint0, endpoint1))
+	{
+		uint32_t refinedQuantised0[3], refinedQuantised1[3];
+		QuantiseBC6HEndpoint(endpoint0, refinedQuantised0);
+		QuantiseBC6HEndpoint(endpoint1, refinedQuantised1);
+
+		float refinedPalette[16][4];
+		uint32_t refinedIndices[16];
+		GetBC6HPalette(refinedQuantised0, refinedQuantised1, refinedPalette);
+		const float refinedError = FindIndices(halfBlock, refinedPalette, 16, 3, refinedIndices);
+		if (refinedError < error)
+		{
+			memcpy(quantised0, refinedQuantised0, sizeof(quantised0));
+			memcpy(quantised1, refinedQuantised1, sizeof(quantised1));
+			memcpy(indices, refinedIndices, sizeof(indices));
+		}
+	}
+
+	if (indices[0] & 0x8)
+	{
+		std::swap(quantised0, quantised1);
+		for (uint32_t i = 0; i < 16; i++)
+			indices[i] = 15 - indices[i];
+	}
+
+	BlockBits bits;
+	bits.Write(0x03, 5);
+	for (uint32_t c = 0; c < 3; c++)
+		bits.Write(quantised0[c], 10);
+	for (uint32_t c = 0; c < 3; c++)
+		bits.Write(quantised1[c], 10);
+	for (uint32_t i = 0; i < 16; i++)
+		bits.Write(indices[i], i == 0 ? 3 : 4);
+	memcpy(dst, bits.data, sizeof(bits.data));
+}
+
+static bool DecodeBC6HBlock(const uint8_t* src, float block[16][4])
+{
+	BlockBits bits;
+	memcpy(bits.data, src, sizeof(bits.data));
+	if (bits.Read(5) != 0x03)
+		return false;
+
+	uint32_t quantised0[3], quantised1[3];
+	for (uint32_t c = 0; c < 3; c++)
+		quantised0[c] = bits.Read(10);
+	for (uint32_t c = 0; c < 3; c++)
+		quantised1[c] = bits.Read(10);
+
+	float palette[16][4];
+	GetBC6HPalette(quantised0, quantised1, palette);
+	for (uint32_t i = 0; i < 16; i++)
+	{
+		const uint32_t index = bits.Read(i == 0 ? 3 : 4);
+		for (uint32_t c = 0; c < 3; c++)
+			block[i][c] = HalfToFloat(uint16_t(palette[index][c]));
+		block[i][3] = 1.0f;
+	}
+	return true;
+}
+
+static void EncodeBlock(Image::Format format, const float block[16][4], uint8_t* dst)
+{
+	switch (format)
+	{
+	case Image::Format::BC1_RGBA_UNORM_BLOCK:
+	case Image::Format::BC1_RGBA_SRGB_BLOCK:
+		EncodeColourBlock(block, dst);
+		break;
+	case Image::Format::BC3_UNORM_BLOCK:
+	case Image::Format::BC3_SRGB_BLOCK:
+		EncodeSingleChannelBlock(block, 3, dst);
+		EncodeColourBlock(block, dst + 8);
+		break;
+	case Image::Format::BC4_UNORM_BLOCK:
+		EncodeSingleChannelBlock(block, 0, dst);
+		break;
+	case Image::Format::BC5_UNORM_BLOCK:
+		EncodeSingleChannelBlock(block, 0, dst);
+		EncodeSingleChannelBlock(block, 1, dst + 8);
+		break;
+	case Image::Format::BC6H_UFLOAT_BLOCK:
+		EncodeBC6HBlock(block, dst);
+		break;
+	case Image::Format::BC7_UNORM_BLOCK:
+	case Image::Format::BC7_SRGB_BLOCK:
+		EncodeBC7Block(block, dst);
+		break;
+	default:
+		break;
+	}
+}
+
+static bool DecodeBlock(Image::Format format, const uint8_t* src, float block[16][4])
+{
+	for (uint32_t i = 0; i < 16; i++)
+	{
+		block[i][0] = block[i][1] = block[i][2] = 0.0f;
+		block[i][3] = 255.0f;
+	}
+
+	switch (format)
+	{
+	case Image::Format::BC1_RGBA_UNORM_BLOCK:
+	case Image::Format::BC1_RGBA_SRGB_BLOCK:
+		DecodeColourBlock(src, false, block);
+		return true;
+	case Image::Format::BC3_UNORM_BLOCK:
+	case Image::Format::BC3_SRGB_BLOCK:
+		DecodeColourBlock(src + 8, true, block);
+		DecodeSingleChannelBlock(src, 3, block);
+		return true;
+	case Image::Format::BC4_UNORM_BLOCK:
+		DecodeSingleChannelBlock(src, 0, block);
+		return true;
+	case Image::Format::BC5_UNORM_BLOCK:
+		DecodeSingleChannelBlock(src, 0, block);
+		DecodeSingleChannelBlock(src + 8, 1, block);
+		return true;
+	case Image::Format::BC6H_UFLOAT_BLOCK:
+		return DecodeBC6HBlock(src, block);
+	case Image::Format::BC7_UNORM_BLOCK:
+	case Image::Format::BC7_SRGB_BLOCK:
+		return DecodeBC7Block(src, block);
+	default:
+		return false;
+	}
+}
+
+//TextureCompressor
+
+TextureCompressor::TextureCompressor(CreateInfo* pCreateInfo)
+{
+	m_CI = *pCreateInfo;
+
+	m_ThreadPoolCI.debugName = "GEAR_CORE_ThreadPool_TextureCompressor: " + m_CI.debugName;
+	m_ThreadPoolCI.workerCount = m_CI.workerCount;
+	m_ThreadPool = CreateRef<core::ThreadPool>(&m_ThreadPoolCI);
+}
+
+TextureCompressor::~TextureCompressor()
+{
+}
+
+bool TextureCompressor::Encode(Image::Format dstFormat, const uint8_t* srcData, uint32_t width, uint32_t height, uint32_t arrayLayers, uint32_t mipLevels,
+	std::vector<uint8_t>& dstData, Statistics* pStatistics, bool computePSNR)
+{
+	//Mode 11 endpoints are unsigned, so BC6H_SFLOAT_BLOCK is not encoded.
+	if (!Texture::IsBlockCompressed(dstFormat) || dstFormat == Image::Format::BC6H_SFLOAT_BLOCK || !srcData || width == 0 || height == 0)
+	{
+		GEAR_WARN(ErrorCode::GRAPHICS | ErrorCode::NOT_SUPPORTED, "Unable to encode %s in TextureCompressor: %s.", GetFormatName(dstFormat).c_str(), m_CI.debugName.c_str());
+		return false;
+	}
+
+	const bool hdr = IsHDRFormat(dstFormat);
+	const Image::Format texelFormat = hdr ? Image::Format::R32G32B32A32_SFLOAT : Image::Format::R8G8B8A8_UNORM;
+	const size_t blockSize = Texture::GetTexelSize(dstFormat);
+
+	size_t blockCount = 0;
+	const std::vector<Surface> surfaces = GetSurfaces(dstFormat, texelFormat, width, height, arrayLayers, mipLevels, blockCount);
+	dstData.resize(Texture::GetMipChainSize(dstFormat, width, height, 1, arrayLayers, mipLevels));
+
+	auto start = std::chrono::high_resolution_clock::now();
+	m_ThreadPool->ParallelFor(blockCount,
+		[&](size_t begin, size_t end, uint32_t)
+		{
+			size_t surfaceIndex = std::upper_bound(surfaces.begin(), surfaces.end(), begin, [](size_t block, const Surface& surface) { return block < surface.firstBlock; }) - surfaces.begin() - 1;
+			float block[16][4];
+			for (size_t i = begin; i < end; i++)
+			{
+				while (surfaceIndex + 1 < surfaces.size() && i >= surfaces[surfaceIndex + 1].firstBlock)
+					surfaceIndex++;
+
+				const Surface& surface = surfaces[surfaceIndex];
+				const uint32_t blockIndex = static_cast<uint32_t>(i - surface.firstBlock);
+				const uint32_t blockX = blockIndex % surface.blocksX;
+				const uint32_t blockY = blockIndex / surface.blocksX;
+
+				if (hdr)
+					FetchBlock(reinterpret_cast<const float*>(srcData + surface.srcOffset), surface.width, surface.height, blockX, blockY, block);
+				else
+					FetchBlock(srcData + surface.srcOffset, surface.width, surface.height, blockX, blockY, block);
+
+				EncodeBlock(dstFormat, block, dstData.data() + surface.dstOffset + blockIndex * blockSize);
+			}
+		});
+	auto end = std::chrono::high_resolution_clock::now();
+
+	if (pStatistics)
+	{
+		*pStatistics = {};
+		for (auto& surface : surfaces)
+			pStatistics->texels += uint64_t(surface.width) * surface.height;
+		pStatistics->encodeTime = std::chrono::duration<double, std::milli>(end - start).count();
+		pStatistics->megaTexelsPerSecond = pStatistics->encodeTime > 0.0 ? double(pStatistics->texels) / (pStatistics->encodeTime * 1000.0) : 0.0;
+
+		std::vector<uint8_t> decodedData;
+		if (computePSNR && Decode(dstFormat, dstData.data(), width, height, arrayLayers, mipLevels, decodedData))
+			pStatistics->psnr = ComputePSNR(srcData, decodedData.data(), size_t(pStatistics->texels), hdr, GetChannelCount(dstFormat));
+	}
+	return true;
+}
+
+bool TextureCompressor::Decode(Image::Format srcFormat, const uint8_t* srcData, uint32_t width, uint32_t height, uint32_t arrayLayers, uint32_t mipLevels, std::vector<uint8_t>& dstData)
+{
+	if (!Texture::IsBlockCompressed(srcFormat) || !srcData)
+		return false;
+
+	const bool hdr = IsHDRFormat(srcFormat);
+	const Image::Format texelFormat = hdr ? Image::Format::R32G32B32A32_SFLOAT : Image::Format::R8G8B8A8_UNORM;
+	const size_t blockSize = Texture::GetTexelSize(srcFormat);
+
+	size_t blockCount = 0;
+	const std::vector<Surface> surfaces = GetSurfaces(srcFormat, texelFormat, width, height, arrayLayers, mipLevels, blockCount);
+	dstData.resize(Texture::GetMipChainSize(texelFormat, width, height, 1, arrayLayers, mipLevels));
+
+	std::atomic<bool> result = true;
+	m_ThreadPool->ParallelFor(surfaces.size(),
+		[&](size_t begin, size_t end, uint32_t)
+		{
+			float block[16][4];
+			for (size_t i = begin; i < end; i++)
+			{
+				const Surface& surface = surfaces[i];
+				const uint32_t blocksY = (surface.height + 3) / 4;
+				for (uint32_t blockY = 0; blockY < blocksY; blockY++)
+				{
+					for (uint32_t blockX = 0; blockX < surface.blocksX; blockX++)
+					{
+						const uint8_t* src = srcData + surface.dstOffset + (size_t(blockY) * surface.blocksX + blockX) * blockSize;
+						if (!DecodeBlock(srcFormat, src, block))
+							result = false;
+
+						if (hdr)
+							StoreBlock(reinterpret_cast<float*>(dstData.data() + surface.srcOffset), surface.width, surface.height, blockX, blockY, block);
+						else
+							StoreBlock(dstData.data() + surface.srcOffset, surface.width, surface.height, blockX, blockY, block);
+					}
+				}
+			}
+		});
+
+	if (!result)
+	{
+		GEAR_WARN(ErrorCode::GRAPHICS | ErrorCode::NOT_SUPPORTED, "TextureCompressor: %s can only decode the block modes that it encodes.", m_CI.debugName.c_str());
+	}
+	return result;
+}
+
+std::string TextureCompressor::Cook(const std::string& filepath, Image::Format format, Statistics* pStatistics)
+{
+	if (!std::filesystem::exists(filepath))
+	{
+		GEAR_WARN(ErrorCode::GRAPHICS | ErrorCode::NO_FILE, "Unable to open %s.", filepath.c_str());
+		return "";
+	}
+
+	//The cooked file is named after the image and a hash of its path and format.
+	char hash[17];
+	snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(std::hash<std::string>()(filepath + ":" + GetFormatName(format))));
+	const std::filesystem::path cookedFilepath = std::filesystem::path(m_CI.cacheDirectory) / (std::filesystem::path(filepath).stem().string() + "_" + hash + GEAR_TEXTURE_COOKED_FILE_EXTENSION);
+	if (std::filesystem::exists(cookedFilepath) && std::filesystem::last_write_time(cookedFilepath) >= std::filesystem::last_write_time(filepath))
+	{
+		if (pStatistics)
+			*pStatistics = {};
+		return cookedFilepath.string();
+	}
+
+	const bool hdr = IsHDRFormat(format);
+	const size_t texelSize = hdr ? 4 * sizeof(float) : 4 * sizeof(uint8_t);
+	uint32_t width = 0, height = 0, channels = 0;
+	void* stbiBuffer = hdr
+		? (void*)stbi_loadf(filepath.c_str(), (int*)&width, (int*)&height, (int*)&channels, 4)
+		: (void*)stbi_load(filepath.c_str(), (int*)&width, (int*)&height, (int*)&channels, 4);
+	if (!stbiBuffer)
+	{
+		GEAR_WARN(ErrorCode::GRAPHICS | ErrorCode::LOAD_FAILED, "%s is not valid.", filepath.c_str());
+		return "";
+	}
+
+	std::vector<uint8_t> data(size_t(width) * height * texelSize);
+	memcpy(data.data(), stbiBuffer, data.size());
+	stbi_image_free(stbiBuffer);
+
+	const uint32_t mipLevels = static_cast<uint32_t>(log2(static_cast<double>(std::max(width, height)))) + 1;
+	GenerateMipMaps(data, hdr, width, height, 1, mipLevels);
+
+	std::vector<uint8_t> encodedData;
+	if (!Encode(format, data.data(), width, height, 1, mipLevels, encodedData, pStatistics))
+		return "";
+
+	Texture::CookedHeader header;
+	header.format = format;
+	header.width = width;
+	header.height = height;
+	header.depth = 1;
+	header.mipLevels = mipLevels;
+	header.arrayLayers = 1;
+	header.size = encodedData.size();
+
+	std::filesystem::create_directories(m_CI.cacheDirectory);
+	if (!Texture::WriteCookedTexture(cookedFilepath.string(), header, encodedData.data()))
+		return "";
+
+	return cookedFilepath.string();
+}
+
+void TextureCompressor::GenerateMipMaps(std::vector<uint8_t>& data, bool hdr, uint32_t width, uint32_t height, uint32_t arrayLayers, uint32_t mipLevels)
+{
+	const Image::Format texelFormat = hdr ? Image::Format::R32G32B32A32_SFLOAT : Image::Format::R8G8B8A8_UNORM;
+	data.resize(Texture::GetMipChainSize(texelFormat, width, height, 1, arrayLayers, mipLevels));
+
+	for (uint32_t level = 1; level < mipLevels; level++)
+	{
+		const uint32_t srcWidth = std::max(width >> (level - 1), 1U);
+		const uint32_t srcHeight = std::max(height >> (level - 1), 1U);
+		const uint32_t dstWidth = std::max(width >> level, 1U);
+		const uint32_t dstHeight = std::max(height >> level, 1U);
+		const size_t srcLayerSize = Texture::GetMipLevelSize(texelFormat, srcWidth, srcHeight, 1, 1, 0);
+		const size_t dstLayerSize = Texture::GetMipLevelSize(texelFormat, dstWidth, dstHeight, 1, 1, 0);
+		const size_t srcLevelOffset = Texture::GetMipChainSize(texelFormat, width, height, 1, arrayLayers, level - 1);
+		const size_t dstLevelOffset = Texture::GetMipChainSize(texelFormat, width, height, 1, arrayLayers, level);
+
+		for (uint32_t layer = 0; layer < arrayLayers; layer++)
+		{
+			const uint8_t* src = data.data() + srcLevelOffset + layer * srcLayerSize;
+			uint8_t* dst = data.data() + dstLevelOffset + layer * dstLayerSize;
+			for (uint32_t y = 0; y < dstHeight; y++)
+			{
+				const uint32_t srcY[2] = { std::min(2 * y, srcHeight - 1), std::min(2 * y + 1, srcHeight - 1) };
+				for (uint32_t x = 0; x < dstWidth; x++)
+				{
+					const uint32_t srcX[2] = { std::min(2 * x, srcWidth - 1), std::min(2 * x + 1, srcWidth - 1) };
+					for (uint32_t c = 0; c < 4; c++)
+					{
+						float sum = 0.0f;
+						for (uint32_t i = 0; i < 4; i++)
+						{
+							const size_t srcIndex = (size_t(srcY[i / 2]) * srcWidth + srcX[i % 2]) * 4 + c;
+							sum += hdr ? reinterpret_cast<const float*>(src)[srcIndex] : float(src[srcIndex]);
+						}
+
+						const size_t dstIndex = (size_t(y) * dstWidth + x) * 4 + c;
+						if (hdr)
+							reinterpret_cast<float*>(dst)[dstIndex] = sum / 4.0f;
+						else
+							dst[dstIndex] = uint8_t(sum / 4.0f + 0.5f);
+					}
+				}
+			}
+		}
+	}
+}
+
+double TextureCompressor::ComputePSNR(const uint8_t* dataA, const uint8_t* dataB, size_t texelCount, bool hdr, uint32_t channelCount)
+{
+	double squaredError = 0.0;
+	for (size_t i = 0; i < texelCount; i++)
+	{
+		for (uint32_t c = 0; c < channelCount; c++)
+		{
+			double a, b;
+			if (hdr)
+			{
+				a = reinterpret_cast<const float*>(dataA)[i * 4 + c];
+				b = reinterpret_cast<const float*>(dataB)[i * 4 + c];
+				a = 255.0 * std::max(a, 0.0) / (1.0 + std::max(a, 0.0));
+				b = 255.0 * std::max(b, 0.0) / (1.0 + std::max(b, 0.0));
+			}
+			else
+			{
+				a = dataA[i * 4 + c];
+				b = dataB[i * 4 + c];
+			}
+			squaredError += (a - b) * (a - b);
+		}
+	}
+
+	const double meanSquaredError = squaredError / double(std::max(texelCount * channelCount, size_t(1)));
+	if (meanSquaredError == 0.0)
+		return std::numeric_limits<double>::infinity();
+	return 10.0 * log10(255.0 * 255.0 / meanSquaredError);
+}
+
+std::string TextureCompressor::GetFormatName(Image::Format format)
+{
+	switch (format)
+	{
+	case Image::Format::BC1_RGBA_UNORM_BLOCK:
+		return "BC1";
+	case Image::Format::BC1_RGBA_SRGB_BLOCK:
+		return "BC1_SRGB";
+	case Image::Format::BC3_UNORM_BLOCK:
+		return "BC3";
+	case Image::Format::BC3_SRGB_BLOCK:
+		return "BC3_SRGB";
+	case Image::Format::BC4_UNORM_BLOCK:
+		return "BC4";
+	case Image::Format::BC5_UNORM_BLOCK:
+		return "BC5";
+	case Image::Format::BC6H_UFLOAT_BLOCK:
+		return "BC6H";
+	case Image::Format::BC6H_SFLOAT_BLOCK:
+		return "BC6H_SFLOAT";
+	case Image::Format::BC7_UNORM_BLOCK:
+		return "BC7";
+	case Image::Format::BC7_SRGB_BLOCK:
+		return "BC7_SRGB";
+	default:
+		return "FORMAT_" + std::to_string(static_cast<uint32_t>(format));
+	}
+}
+
+bool TextureCompressor::IsHDRFormat(Image::Format format)
+{
+	return format == Image::Format::BC6H_UFLOAT_BLOCK || format == Image::Format::BC6H_SFLOAT_BLOCK;
+}
+
+uint32_t TextureCompressor::GetChannelCount(Image::Format format)
+{
+	switch (format)
+	{
+	case Image::Format::BC4_UNORM_BLOCK:
+		return 1;
+	case Image::Format::BC5_UNORM_BLOCK:
+		return 2;
+	case Image::Format::BC1_RGBA_UNORM_BLOCK:
+	case Image::Format::BC1_RGBA_SRGB_BLOCK:
+	case Image::Format::BC6H_UFLOAT_BLOCK:
+	case Image::Format::BC6H_SFLOAT_BLOCK:
+		return 3;
+	default:
+		return 4;
+	}
+}
\ No newline at end of file
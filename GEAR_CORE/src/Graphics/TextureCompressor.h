@@ -0,0 +1,67 @@
+#pragma once
+
+#include "gear_core_common.h"
+#include "Core/ThreadPool.h"
+
+namespace gear
+{
+namespace graphics
+{
+	//Encodes mip chains into block compressed formats on the CPU, spread over a pool of worker threads, and cooks image
+	//files into cooked texture files in a cache directory, which Texture uploads directly.
+	//BC1 (opaque), BC3, BC4, BC5 and BC7 are encoded from R8G8B8A8_UNORM data, and BC6H_UFLOAT from R32G32B32A32_SFLOAT data.
+	//BC7 blocks are encoded in mode 6 and BC6H blocks in mode 11, which use a single pair of endpoints per block.
+	class TextureCompressor
+	{
+	public:
+		struct CreateInfo
+		{
+			std::string	debugName;
+			uint32_t	workerCount;	//0 uses the hardware thread count.
+			std::string	cacheDirectory;	//For cooked texture files.
+		};
+
+		struct Statistics
+		{
+			uint64_t	texels;
+			double		encodeTime;		//In milliseconds.
+			double		megaTexelsPerSecond;
+			double		psnr;			//In decibels, if requested. HDR data is compared after the x/(1+x) tonemap.
+		};
+
+	private:
+		CreateInfo m_CI;
+
+		Ref<core::ThreadPool> m_ThreadPool;
+		core::ThreadPool::CreateInfo m_ThreadPoolCI;
+
+	public:
+		TextureCompressor(CreateInfo* pCreateInfo);
+		~TextureCompressor();
+
+		const CreateInfo& GetCreateInfo() { return m_CI; }
+
+		//Encodes a chain of mipLevels levels, largest first, each level holding all its array layers, into dstData.
+		//Edge blocks of levels that are not a multiple of 4 are padded by repeating the last row and column.
+		bool Encode(miru::crossplatform::Image::Format dstFormat, const uint8_t* srcData, uint32_t width, uint32_t height, uint32_t arrayLayers, uint32_t mipLevels,
+			std::vector<uint8_t>& dstData, Statistics* pStatistics = nullptr, bool computePSNR = false);
+		//Decodes data encoded by Encode() into R8G8B8A8_UNORM, or R32G32B32A32_SFLOAT for BC6H.
+		bool Decode(miru::crossplatform::Image::Format srcFormat, const uint8_t* srcData, uint32_t width, uint32_t height, uint32_t arrayLayers, uint32_t mipLevels,
+			std::vector<uint8_t>& dstData);
+
+		//Returns the path of the cooked texture file of the image, with a full mip chain in the format. The cooked file is
+		//reused while it is newer than the image, otherwise the image is loaded, its mips are generated and it is encoded.
+		//Returns an empty string on failure.
+		std::string Cook(const std::string& filepath, miru::crossplatform::Image::Format format, Statistics* pStatistics = nullptr);
+
+		//Box filters level 0 of R8G8B8A8_UNORM or R32G32B32A32_SFLOAT data into the levels below it. data is resized for the chain.
+		static void GenerateMipMaps(std::vector<uint8_t>& data, bool hdr, uint32_t width, uint32_t height, uint32_t arrayLayers, uint32_t mipLevels);
+		static double ComputePSNR(const uint8_t* dataA, const uint8_t* dataB, size_t texelCount, bool hdr, uint32_t channelCount = 4);
+		static std::string GetFormatName(miru::crossplatform::Image::Format format);
+
+	private:
+		static bool IsHDRFormat(miru::crossplatform::Image::Format format);
+		static uint32_t GetChannelCount(miru::crossplatform::Image::Format format);
+	};
+}
+}
\ No newline at end of file
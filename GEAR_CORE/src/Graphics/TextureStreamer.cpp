@@ -0,0 +1,129 @@
+#include "gear_core_common.h"
+#include "TextureStreamer.h"
+#include "Graphics/Texture.h"
+
+using namespace gear;
+using namespace graphics;
+
+TextureStreamer::TextureStreamer(CreateInfo* pCreateInfo)
+{
+	m_CI = *pCreateInfo;
+	m_CI.framesInFlight = std::max(m_CI.framesInFlight, uint32_t(1));
+	m_InFlight.resize(m_CI.framesInFlight);
+	m_InFlightBytes.resize(m_CI.framesInFlight, 0);
+	m_Budget = m_CI.budgetPerFrame;
+	m_Statistics.budget = m_Budget;
+}
+
+TextureStreamer::~TextureStreamer()
+{
+}
+
+void TextureStreamer::Request(const Ref<Texture>& texture, const CompletionCallback& callback, bool immediate)
+{
+	if (!texture)
+		return;
+
+	//The Renderer requests every texture that is not resident each frame, so repeated requests return early.
+	if (!immediate && !callback && IsQueued(texture))
+		return;
+
+	auto it = Find(m_ImmediateQueue, texture);
+	if (it == m_ImmediateQueue.end())
+	{
+		it = Find(m_Queue, texture);
+		if (it != m_Queue.end() && immediate)
+		{
+			m_ImmediateQueue.push_back(std::move(*it));
+			m_Queue.erase(it);
+			it = m_ImmediateQueue.end() - 1;
+		}
+		else if (it == m_Queue.end())
+		{
+			std::deque<QueuedTexture>& queue = immediate ? m_ImmediateQueue : m_Queue;
+			queue.push_back({ texture, {} });
+			it = queue.end() - 1;
+		}
+	}
+
+	if (callback)
+		it->callbacks.push_back(callback);
+	m_QueuedTextures.insert(texture.get());
+
+	m_Statistics.queuedTextures = static_cast<uint32_t>(m_Queue.size() + m_ImmediateQueue.size());
+}
+
+bool TextureStreamer::IsQueued(const Ref<Texture>& texture) const
+{
+	return m_QueuedTextures.find(texture.get()) != m_QueuedTextures.end();
+}
+
+std::vector<Ref<Texture>> TextureStreamer::Schedule(uint32_t frameIndex)
+{
+	std::vector<QueuedTexture>& inFlight = m_InFlight[frameIndex % m_CI.framesInFlight];
+	std::vector<Ref<Texture>> textures;
+
+	m_Statistics.scheduledBytes = 0;
+	for (auto& request : m_ImmediateQueue)
+	{
+		m_Statistics.scheduledBytes += request.texture->GetUploadSize();
+		m_QueuedTextures.erase(request.texture.get());
+		textures.push_back(request.texture);
+		inFlight.push_back(std::move(request));
+	}
+	m_ImmediateQueue.clear();
+
+	while (!m_Queue.empty())
+	{
+		const size_t size = m_Queue.front().texture->GetUploadSize();
+		if (!textures.empty() && m_Statistics.scheduledBytes + size > m_Budget)
+			break;
+
+		m_Statistics.scheduledBytes += size;
+		m_QueuedTextures.erase(m_Queue.front().texture.get());
+		textures.push_back(m_Queue.front().texture);
+		inFlight.push_back(std::move(m_Queue.front()));
+		m_Queue.pop_front();
+	}
+
+	m_InFlightBytes[frameIndex % m_CI.framesInFlight] += m_Statistics.scheduledBytes;
+	m_Statistics.scheduledTextures = static_cast<uint32_t>(textures.size());
+	m_Statistics.queuedTextures = static_cast<uint32_t>(m_Queue.size());
+	m_Statistics.inFlightTextures = 0;
+	for (auto& requests : m_InFlight)
+		m_Statistics.inFlightTextures += static_cast<uint32_t>(requests.size());
+	return textures;
+}
+
+void TextureStreamer::Complete(uint32_t frameIndex, double uploadTime)
+{
+	//Only frames that uploaded textures adapt the budget, as the time of the others does not depend on it.
+	uint64_t& inFlightBytes = m_InFlightBytes[frameIndex % m_CI.framesInFlight];
+	if (m_CI.timeBudgetPerFrame > 0.0 && inFlightBytes > 0)
+	{
+		if (uploadTime > m_CI.timeBudgetPerFrame)
+			m_Budget = std::max(m_Budget / 2, m_CI.budgetPerFrame / 64);
+		else
+			m_Budget = std::min(m_Budget + m_CI.budgetPerFrame / 8, m_CI.budgetPerFrame);
+		m_Statistics.budget = m_Budget;
+		m_Statistics.uploadTime = uploadTime;
+	}
+	inFlightBytes = 0;
+
+	//The requests are moved out first, as a callback may request more textures.
+	std::vector<QueuedTexture> completed = std::move(m_InFlight[frameIndex % m_CI.framesInFlight]);
+	m_InFlight[frameIndex % m_CI.framesInFlight].clear();
+
+	for (auto& request : completed)
+	{
+		for (auto& callback : request.callbacks)
+			callback(request.texture);
+	}
+	m_Statistics.completedTextures += static_cast<uint32_t>(completed.size());
+	m_Statistics.inFlightTextures -= std::min(m_Statistics.inFlightTextures, static_cast<uint32_t>(completed.size()));
+}
+
+std::deque<TextureStreamer::QueuedTexture>::iterator TextureStreamer::Find(std::deque<QueuedTexture>& queue, const Ref<Texture>& texture)
+{
+	return std::find_if(queue.begin(), queue.end(), [&texture](const QueuedTexture& request) { return request.texture == texture; });
+}
\ No newline at end of file
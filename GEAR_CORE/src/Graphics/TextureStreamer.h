@@ -0,0 +1,82 @@
+#pragma once
+
+#include "gear_core_common.h"
+
+namespace gear
+{
+namespace graphics
+{
+	class Texture;
+
+	//Spreads texture uploads over several frames. Requested textures are queued, and each frame Schedule() returns the
+	//oldest requests that fit in the byte budget. These are uploaded on the transfer queue by the Renderer's upload
+	//FrameGraph. Until a texture is scheduled, the Renderer binds the Material's default texture of the same type.
+	//With a time budget, the byte budget adapts to the measured upload time passed to Complete(): It is halved when a
+	//frame's uploads took longer than the time budget, and regrown by an eighth of budgetPerFrame while they do not.
+	class TextureStreamer
+	{
+	public:
+		typedef std::function<void(const Ref<Texture>&)> CompletionCallback;
+
+		struct CreateInfo
+		{
+			std::string	debugName;
+			size_t		budgetPerFrame;		//In bytes. At least one texture is scheduled per frame, so larger textures are not starved.
+			double		timeBudgetPerFrame;	//In milliseconds. 0 only uses the byte budget.
+			uint32_t	framesInFlight;
+		};
+
+		struct Statistics
+		{
+			uint32_t	queuedTextures;
+			uint32_t	inFlightTextures;
+			uint32_t	scheduledTextures;	//In the last call to Schedule().
+			uint64_t	scheduledBytes;		//In the last call to Schedule().
+			uint32_t	completedTextures;	//Since creation.
+			uint64_t	budget;				//The byte budget of the next call to Schedule().
+			double		uploadTime;			//In milliseconds, of the last completed frame that uploaded textures.
+		};
+
+	private:
+		struct QueuedTexture
+		{
+			Ref<Texture>					texture;
+			std::vector<CompletionCallback>	callbacks;
+		};
+
+		CreateInfo m_CI;
+
+		std::deque<QueuedTexture> m_Queue;
+		std::deque<QueuedTexture> m_ImmediateQueue;
+		std::set<const Texture*> m_QueuedTextures;
+		std::vector<std::vector<QueuedTexture>> m_InFlight;	//Per frame in flight.
+		std::vector<uint64_t> m_InFlightBytes;				//Per frame in flight.
+		size_t m_Budget;
+		Statistics m_Statistics = {};
+
+	public:
+		TextureStreamer(CreateInfo* pCreateInfo);
+		~TextureStreamer();
+
+		const CreateInfo& GetCreateInfo() { return m_CI; }
+		inline void SetBudgetPerFrame(size_t budgetPerFrame) { m_CI.budgetPerFrame = m_Budget = budgetPerFrame; }
+		inline void SetTimeBudgetPerFrame(double timeBudgetPerFrame) { m_CI.timeBudgetPerFrame = timeBudgetPerFrame; }
+
+		//Queues the texture if it is not already queued. Immediate requests are scheduled in the next frame regardless of the budget.
+		//The callback is called once the upload has completed on the GPU.
+		void Request(const Ref<Texture>& texture, const CompletionCallback& callback = nullptr, bool immediate = false);
+		bool IsQueued(const Ref<Texture>& texture) const;
+
+		//Returns the textures to upload in this frame. Call once per frame after Complete().
+		std::vector<Ref<Texture>> Schedule(uint32_t frameIndex);
+		//Call once the previous uploads of the frame have completed. Raises the callbacks of the textures scheduled in them.
+		//The upload time, in milliseconds, is the CPU time of the frame's upload pass and of the wait on its completion.
+		void Complete(uint32_t frameIndex, double uploadTime = 0.0);
+
+		inline const Statistics& GetStatistics() const { return m_Statistics; }
+
+	private:
+		static std::deque<QueuedTexture>::iterator Find(std::deque<QueuedTexture>& queue, const Ref<Texture>& texture);
+	};
+}
+}
\ No newline at end of file
@@ -115,6 +115,8 @@ namespace gear
 				GEAR_FLOAT4X4	modl;
 				GEAR_FLOAT2		texCoordScale0;
 				GEAR_FLOAT2		texCoordScale1;
+				GEAR_FLOAT4		positionScale;		//Dequantises GEAR_QUANTISED_VERTEX positions.
+				GEAR_FLOAT4		positionOffset;
 			};
 
 			//Per material - Set 2
@@ -147,6 +149,68 @@ namespace gear
 			#endif	
 
 			};
+
+			//Bindless materials - Set 2
+
+			static const GEAR_UINT MAX_BINDLESS_MATERIALS = 1024;
+			static const GEAR_UINT MAX_BINDLESS_TEXTURES = 4096;
+
+			struct BindlessMaterial
+			{
+				PBRConstants	pbrConstants;
+				GEAR_UINT4		textureIndices0;	//Normal, Albedo, Metallic, Roughness
+				GEAR_UINT4		textureIndices1;	//AmbientOcclusion, Emissive, Unused, Unused
+			};
+
+			struct BindlessMaterials
+			{
+				BindlessMaterial	materials[MAX_BINDLESS_MATERIALS];
+			};
+
+			//Push constant
+			struct MaterialIndex
+			{
+				GEAR_UINT		materialID;
+			};
+
+			//GPU-driven - Set 1 and the cull pass
+
+			struct DrawInstance
+			{
+				GEAR_FLOAT4X4	modl;
+				GEAR_FLOAT4		boundingSphere;		//Object space centre and radius.
+				GEAR_FLOAT2		texCoordScale0;
+				GEAR_FLOAT2		texCoordScale1;
+				GEAR_FLOAT4		positionScale;
+				GEAR_FLOAT4		positionOffset;
+				GEAR_UINT		indexCount;
+				GEAR_UINT		firstIndex;
+				GEAR_INT		vertexOffset;
+				GEAR_UINT		materialID;
+				GEAR_UINT		batchIndex;			//Index into the draw counts.
+				GEAR_UINT		batchOffset;		//First draw command of the batch.
+				GEAR_UINT		pad0;
+				GEAR_UINT		pad1;
+			};
+
+			//Matches VkDrawIndexedIndirectCommand and D3D12_DRAW_INDEXED_ARGUMENTS.
+			struct DrawIndexedIndirectCommand
+			{
+				GEAR_UINT		indexCount;
+				GEAR_UINT		instanceCount;
+				GEAR_UINT		firstIndex;
+				GEAR_INT		vertexOffset;
+				GEAR_UINT		firstInstance;
+			};
+
+			struct CullInfo
+			{
+				GEAR_FLOAT4		frustumPlanes[6];	//Left, right, bottom, top, near, far.
+				GEAR_UINT		instanceCount;
+				GEAR_UINT		batchCount;
+				GEAR_UINT		pad0;
+				GEAR_UINT		pad1;
+			};
 #ifdef __cplusplus
 		};
 
@@ -165,7 +229,9 @@ namespace gear
 			{ "LIGHTS",			SetUpdateType::PER_VIEW		},
 			{ "SKYBOXINFO",		SetUpdateType::PER_MATERIAL	},
 			{ "MODEL",			SetUpdateType::PER_MODEL	},
-			{ "PBRCONSTANTS",	SetUpdateType::PER_MATERIAL }
+			{ "PBRCONSTANTS",	SetUpdateType::PER_MATERIAL },
+			{ "BINDLESSMATERIALS",	SetUpdateType::PER_MATERIAL },
+			{ "DRAWINSTANCES",	SetUpdateType::PER_MODEL	}
 		};
 	}
 }
@@ -0,0 +1,234 @@
+#include "gear_core_common.h"
+#include "UniformRing.h"
+#include "Graphics/AllocatorManager.h"
+
+using namespace gear;
+using namespace graphics;
+
+using namespace miru;
+using namespace miru::crossplatform;
+
+std::map<void*, Ref<UniformRing>> UniformRing::s_UniformRings;
+
+UniformRing::UniformRing(CreateInfo* pCreateInfo)
+{
+	m_CI = *pCreateInfo;
+	m_CI.alignment = std::max(m_CI.alignment, size_t(1));
+	m_CI.blockSize = std::max(m_CI.blockSize, m_CI.alignment);
+	m_CI.framesInFlight = std::max(m_CI.framesInFlight, uint32_t(1));
+
+	if ((m_CI.alignment & (m_CI.alignment - 1)) != 0)
+	{
+		GEAR_ASSERT(ErrorCode::GRAPHICS | ErrorCode::INVALID_VALUE, "Alignment is not a power of 2: %s.", m_CI.debugName.c_str());
+	}
+}
+
+UniformRing::~UniformRing()
+{
+}
+
+const Ref<UniformRing>& UniformRing::GetUniformRing(void* device)
+{
+	Ref<UniformRing>& uniformRing = s_UniformRings[device];
+	if (!uniformRing)
+	{
+		CreateInfo uniformRingCI;
+		uniformRingCI.debugName = "GEAR_CORE_UniformRing";
+		uniformRingCI.device = device;
+		uniformRingCI.blockSize = 4 * 1024 * 1024;
+		uniformRingCI.alignment = 256;
+		uniformRingCI.framesInFlight = 2;
+		uniformRing = CreateRef<UniformRing>(&uniformRingCI);
+	}
+	return uniformRing;
+}
+
+void UniformRing::ReleaseUniformRing(void* device)
+{
+	s_UniformRings.erase(device);
+}
+
+void UniformRing::SetFramesInFlight(uint32_t framesInFlight)
+{
+	framesInFlight = std::max(framesInFlight, uint32_t(1));
+	if (m_CI.framesInFlight == framesInFlight)
+		return;
+
+	m_CI.framesInFlight = framesInFlight;
+	m_FrameIndex = 0;
+	for (auto& block : m_Blocks)
+	{
+		block.buffers.clear();
+		block.bufferCIs.clear();
+		for (auto& allocation : block.allocations)
+			allocation->bufferViews.clear();
+	}
+}
+
+Ref<UniformRing::Allocation> UniformRing::Allocate(size_t size)
+{
+	const size_t alignedSize = (size + m_CI.alignment - 1) & ~(m_CI.alignment - 1);
+
+	Ref<Allocation> allocation = CreateRef<Allocation>();
+	allocation->blockIndex = UINT32_MAX;
+	allocation->offset = 0;
+	allocation->size = size;
+
+	for (uint32_t i = 0; i < static_cast<uint32_t>(m_Blocks.size()); i++)
+	{
+		Block& block = m_Blocks[i];
+		auto freeSlotIt = block.freeSlots.find(alignedSize);
+		if (freeSlotIt != block.freeSlots.end())
+		{
+			allocation->blockIndex = i;
+			allocation->offset = freeSlotIt->second;
+			block.freeSlots.erase(freeSlotIt);
+			break;
+		}
+		if (block.usedSize + alignedSize <= block.data.size())
+		{
+			allocation->blockIndex = i;
+			allocation->offset = block.usedSize;
+			block.usedSize += alignedSize;
+			break;
+		}
+	}
+	if (allocation->blockIndex == UINT32_MAX)
+	{
+		allocation->blockIndex = CreateBlock(std::max(m_CI.blockSize, alignedSize));
+		allocation->offset = 0;
+		m_Blocks[allocation->blockIndex].usedSize = alignedSize;
+	}
+
+	Block& block = m_Blocks[allocation->blockIndex];
+	memset(block.data.data() + allocation->offset, 0, alignedSize);
+	block.version++;
+	block.allocations.insert(allocation.get());
+	return allocation;
+}
+
+void UniformRing::Free(const Ref<Allocation>& allocation)
+{
+	if (!allocation || allocation->blockIndex >= m_Blocks.size())
+		return;
+
+	Block& block = m_Blocks[allocation->blockIndex];
+	if (block.allocations.erase(allocation.get()) == 0)
+	{
+		GEAR_WARN(ErrorCode::GRAPHICS | ErrorCode::INVALID_VALUE, "Allocation was not allocated from UniformRing: %s.", m_CI.debugName.c_str());
+		return;
+	}
+
+	const size_t alignedSize = (allocation->size + m_CI.alignment - 1) & ~(m_CI.alignment - 1);
+	block.freeSlots.insert({ alignedSize, allocation->offset });
+	allocation->blockIndex = UINT32_MAX;
+	allocation->bufferViews.clear();
+}
+
+void UniformRing::Write(const Ref<Allocation>& allocation, const void* data)
+{
+	Block& block = m_Blocks[allocation->blockIndex];
+	memcpy(block.data.data() + allocation->offset, data, allocation->size);
+	block.version++;
+}
+
+void UniformRing::Submit(uint32_t frameIndex)
+{
+	auto submitStart = std::chrono::high_resolution_clock::now();
+
+	m_FrameIndex = frameIndex % m_CI.framesInFlight;
+	m_SubmitStatistics = {};
+	for (uint32_t i = 0; i < static_cast<uint32_t>(m_Blocks.size()); i++)
+	{
+		Block& block = m_Blocks[i];
+		if (block.allocations.empty())
+			continue;
+
+		CreateBuffers(i);
+		if (block.submittedVersions[m_FrameIndex] == block.version)
+			continue;
+
+		block.submittedVersions[m_FrameIndex] = block.version;
+		block.bufferCIs[m_FrameIndex].pAllocator->SubmitData(block.buffers[m_FrameIndex]->GetAllocation(), block.usedSize, block.data.data());
+		m_SubmitStatistics.submittedSize += block.usedSize;
+		m_SubmitStatistics.submitCalls++;
+	}
+
+	m_SubmitStatistics.submitTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - submitStart).count();
+}
+
+const Ref<Buffer>& UniformRing::GetBuffer(const Ref<Allocation>& allocation)
+{
+	CreateBuffers(allocation->blockIndex);
+	return m_Blocks[allocation->blockIndex].buffers[m_FrameIndex];
+}
+
+const Ref<BufferView>& UniformRing::GetBufferView(const Ref<Allocation>& allocation)
+{
+	if (allocation->bufferViews.size() != m_CI.framesInFlight)
+	{
+		CreateBuffers(allocation->blockIndex);
+		Block& block = m_Blocks[allocation->blockIndex];
+
+		allocation->bufferViews.resize(m_CI.framesInFlight);
+		for (uint32_t i = 0; i < m_CI.framesInFlight; i++)
+		{
+			BufferView::CreateInfo bufferViewCI;
+			bufferViewCI.debugName = m_CI.debugName + "_Block_" + std::to_string(allocation->blockIndex) + "_BufferView_" + std::to_string(allocation->offset) + "_Frame_" + std::to_string(i);
+			bufferViewCI.device = m_CI.device;
+			bufferViewCI.type = BufferView::Type::UNIFORM;
+			bufferViewCI.pBuffer = block.buffers[i];
+			bufferViewCI.offset = allocation->offset;
+			bufferViewCI.size = allocation->size;
+			bufferViewCI.stride = 0;
+			allocation->bufferViews[i] = BufferView::Create(&bufferViewCI);
+		}
+	}
+	return allocation->bufferViews[m_FrameIndex];
+}
+
+UniformRing::Statistics UniformRing::GetStatistics() const
+{
+	Statistics statistics = m_SubmitStatistics;
+	statistics.blocks = static_cast<uint32_t>(m_Blocks.size());
+	statistics.allocations = 0;
+	statistics.usedSize = 0;
+	for (auto& block : m_Blocks)
+	{
+		statistics.allocations += static_cast<uint32_t>(block.allocations.size());
+		statistics.usedSize += block.usedSize;
+	}
+	return statistics;
+}
+
+uint32_t UniformRing::CreateBlock(size_t size)
+{
+	m_Blocks.push_back({});
+	Block& block = m_Blocks.back();
+	block.data.resize(size, 0);
+	block.version = 0;
+	block.usedSize = 0;
+	return static_cast<uint32_t>(m_Blocks.size() - 1);
+}
+
+void UniformRing::CreateBuffers(uint32_t blockIndex)
+{
+	Block& block = m_Blocks[blockIndex];
+	if (block.buffers.size() == m_CI.framesInFlight)
+		return;
+
+	block.buffers.resize(m_CI.framesInFlight);
+	block.bufferCIs.resize(m_CI.framesInFlight);
+	block.submittedVersions.assign(m_CI.framesInFlight, UINT64_MAX);
+	for (uint32_t i = 0; i < m_CI.framesInFlight; i++)
+	{
+		Buffer::CreateInfo& bufferCI = block.bufferCIs[i];
+		bufferCI.debugName = m_CI.debugName + "_Block_" + std::to_string(blockIndex) + "_Frame_" + std::to_string(i);
+		bufferCI.device = m_CI.device;
+		bufferCI.usage = Buffer::UsageBit::UNIFORM_BIT;
+		bufferCI.size = block.data.size();
+		bufferCI.data = block.data.data();
+		bufferCI.pAllocator = AllocatorManager::GetAllocator(AllocatorManager::AllocatorType::CPU);
+		block.buffers[i] = Buffer::Create(&bufferCI);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "gear_core_common.h"
+
+namespace gear
+{
+namespace graphics
+{
+	//Sub-allocates uniform blocks from a few large host visible buffers, one per frame in flight for each block.
+	//Objects write their data into the CPU copy of the block, and Submit() writes the used range of every block to
+	//the buffers of the frame being recorded with one call per block. The GPU reads the uniforms straight from these
+	//buffers, so no staging copies or barriers are recorded, and each frame only overwrites its own buffers.
+	class UniformRing
+	{
+	public:
+		struct CreateInfo
+		{
+			std::string	debugName;
+			void*		device;
+			size_t		blockSize;			//Larger allocations get a block of their own.
+			size_t		alignment;			//Offset alignment of the allocations. 256 bytes satisfies all supported APIs.
+			uint32_t	framesInFlight;
+		};
+
+		//A slot in a block. The slot keeps its offset for its lifetime, so the views of it only change with the frame index.
+		struct Allocation
+		{
+			uint32_t											blockIndex;
+			size_t												offset;
+			size_t												size;
+			std::vector<Ref<miru::crossplatform::BufferView>>	bufferViews;	//One per frame in flight, created on first use.
+		};
+
+		struct Statistics
+		{
+			uint32_t	blocks;
+			uint32_t	allocations;
+			uint64_t	usedSize;
+			uint64_t	submittedSize;		//In the last call to Submit().
+			uint32_t	submitCalls;		//In the last call to Submit().
+			double		submitTime;			//In milliseconds, in the last call to Submit().
+		};
+
+	private:
+		struct Block
+		{
+			std::vector<uint8_t>									data;
+			std::vector<Ref<miru::crossplatform::Buffer>>			buffers;
+			std::vector<miru::crossplatform::Buffer::CreateInfo>	bufferCIs;
+
+			uint64_t												version;			//Bumped by every write to the block.
+			std::vector<uint64_t>									submittedVersions;	//The version last written to each frame's buffer.
+
+			size_t													usedSize;	//Allocations are bumped from the end of the used range.
+			std::multimap<size_t, size_t>							freeSlots;	//Freed slots by size, reused by allocations of the same size.
+			std::set<Allocation*>									allocations;
+		};
+
+		CreateInfo m_CI;
+
+		std::vector<Block> m_Blocks;
+		uint32_t m_FrameIndex = 0;
+		Statistics m_SubmitStatistics = {};
+
+		static std::map<void*, Ref<UniformRing>> s_UniformRings;
+
+	public:
+		UniformRing(CreateInfo* pCreateInfo);
+		~UniformRing();
+
+		const CreateInfo& GetCreateInfo() { return m_CI; }
+
+		//Returns the shared ring of the device, which is created on first use.
+		static const Ref<UniformRing>& GetUniformRing(void* device);
+		//Releases the shared ring of the device, which must be idle. Call before the device is destroyed.
+		static void ReleaseUniformRing(void* device);
+
+		//Set by the Renderer before recording its first frame. The buffers and views are recreated on their next use.
+		void SetFramesInFlight(uint32_t framesInFlight);
+
+		//The slot is zeroed and can be reused immediately once freed, as every frame writes its own buffers.
+		Ref<Allocation> Allocate(size_t size);
+		void Free(const Ref<Allocation>& allocation);
+		//Copies the data into the CPU copy of the block. It reaches the GPU on the next call to Submit().
+		void Write(const Ref<Allocation>& allocation, const void* data);
+
+		//Call once per frame, after the frame's previous submission has completed and before its descriptors are updated.
+		//Only blocks written since they were last submitted to this frame's buffers are submitted.
+		void Submit(uint32_t frameIndex);
+
+		//Returns the buffer or view of the allocation for the frame of the last call to Submit().
+		const Ref<miru::crossplatform::Buffer>& GetBuffer(const Ref<Allocation>& allocation);
+		const Ref<miru::crossplatform::BufferView>& GetBufferView(const Ref<Allocation>& allocation);
+		Statistics GetStatistics() const;
+
+	private:
+		uint32_t CreateBlock(size_t size);
+		void CreateBuffers(uint32_t blockIndex);
+	};
+}
+}
\ No newline at end of file
@@ -2,6 +2,8 @@
 
 #include "gear_core_common.h"
 #include "Graphics/AllocatorManager.h"
+#include "Graphics/BufferCopyBatch.h"
+#include "Graphics/UniformRing.h"
 #include "Graphics/UniformBufferStructures.h"
 
 namespace gear 
@@ -17,6 +19,7 @@ namespace graphics
 			std::string debugName;
 			void*		device;
 			void*		data;
+			bool		perFrame;	//Sub-allocates the block from the device's UniformRing, which the GPU reads directly. Upload() is not required.
 		};
 
 	private:
@@ -26,15 +29,29 @@ namespace graphics
 		Ref<miru::crossplatform::BufferView> m_UniformBufferView;
 		miru::crossplatform::BufferView::CreateInfo m_UniformBufferViewCI;
 
+		Ref<UniformRing> m_UniformRing;
+		Ref<UniformRing::Allocation> m_UniformRingAllocation;
+
 		CreateInfo m_CI;
 
-		bool m_Upload = false;
+		//Bumped by SubmitData(). Upload() only copies when the version has changed since the last upload.
+		mutable uint64_t m_Version = 1;
+		uint64_t m_UploadedVersion = 0;
 
 	public:
 		Uniformbuffer(CreateInfo* pCreateInfo)
 		{
 			m_CI = *pCreateInfo;
 
+			if (m_CI.perFrame)
+			{
+				m_UniformRing = UniformRing::GetUniformRing(m_CI.device);
+				m_UniformRingAllocation = m_UniformRing->Allocate(GetSize());
+				if (m_CI.data)
+					m_UniformRing->Write(m_UniformRingAllocation, m_CI.data);
+				return;
+			}
+
 			m_UniformBufferUploadCI.debugName = "GEAR_CORE_UniformBufferUpload: " + m_CI.debugName;
 			m_UniformBufferUploadCI.device = m_CI.device;
 			m_UniformBufferUploadCI.usage = miru::crossplatform::Buffer::UsageBit::TRANSFER_SRC_BIT;
@@ -60,25 +77,46 @@ namespace graphics
 			m_UniformBufferViewCI.stride = 0;
 			m_UniformBufferView = miru::crossplatform::BufferView::Create(&m_UniformBufferViewCI);
 		}
-		~Uniformbuffer() {}
+		~Uniformbuffer()
+		{
+			if (m_UniformRing)
+				m_UniformRing->Free(m_UniformRingAllocation);
+		}
 
 		const CreateInfo& GetCreateInfo() { return m_CI; }
 
 		void SubmitData() const
 		{
+			if (m_UniformRing)
+			{
+				m_UniformRing->Write(m_UniformRingAllocation, static_cast<const T*>(this));
+				return;
+			}
 			m_UniformBufferUploadCI.pAllocator->SubmitData(m_UniformBufferUpload->GetAllocation(), GetSize(), (void*)this);
+			m_Version++;
 		}
 		void Upload(const Ref<miru::crossplatform::CommandBuffer>& cmdBuffer, uint32_t cmdBufferIndex = 0, bool force = false)
 		{
-			if (!m_Upload || force)
+			if (NeedsUpload(force))
 			{
 				cmdBuffer->CopyBuffer(cmdBufferIndex, m_UniformBufferUpload, m_UniformBuffer, { {0, 0, GetSize()} });
-				m_Upload = true;
+				m_UploadedVersion = m_Version;
+			}
+		}
+		void Upload(BufferCopyBatch& copyBatch, bool force = false)
+		{
+			if (NeedsUpload(force))
+			{
+				copyBatch.Add(m_UniformBufferUpload, m_UniformBuffer, { 0, 0, GetSize() });
+				m_UploadedVersion = m_Version;
 			}
 		}
+		inline bool NeedsUpload(bool force = false) const { return !m_UniformRing && (m_Version != m_UploadedVersion || force); }
+		inline uint64_t GetVersion() const { return m_Version; }
 
-		inline const Ref<miru::crossplatform::Buffer>& GetBuffer() const { return m_UniformBuffer; };
-		inline const Ref<miru::crossplatform::BufferView>& GetBufferView() const { return m_UniformBufferView; };
+		//Per-frame blocks return the buffer or view of the frame being recorded.
+		inline const Ref<miru::crossplatform::Buffer>& GetBuffer() const { return m_UniformRing ? m_UniformRing->GetBuffer(m_UniformRingAllocation) : m_UniformBuffer; };
+		inline const Ref<miru::crossplatform::BufferView>& GetBufferView() const { return m_UniformRing ? m_UniformRing->GetBufferView(m_UniformRingAllocation) : m_UniformBufferView; };
 
 		inline constexpr size_t GetSize() const { return sizeof(T); }
 	};
@@ -127,6 +127,7 @@ bool Window::Init()
 	m_RenderSurfaceCI.bpcColourSpace = Swapchain::BPC_ColourSpace::B8G8R8A8_UNORM_SRGB_NONLINEAR;
 	m_RenderSurfaceCI.samples = m_CI.samples;
 	m_RenderSurfaceCI.graphicsDebugger = m_CI.graphicsDebugger;
+	m_RenderSurfaceCI.framesInFlight = m_CI.framesInFlight;
 	m_RenderSurface = CreateRef<RenderSurface>(&m_RenderSurfaceCI);
 	
 	GLFWimage icon[1];
@@ -27,6 +27,7 @@ namespace graphics
 			miru::crossplatform::Image::SampleCountBit	samples;
 			std::string									iconFilepath;
 			miru::debug::GraphicsDebugger::DebuggerType graphicsDebugger;
+			uint32_t									framesInFlight;
 		};
 	
 	private:
@@ -69,6 +70,7 @@ namespace graphics
 		inline const Ref<miru::crossplatform::ImageView>& GetSwapchainImageView(size_t index) const { return m_RenderSurface->GetSwapchainImageView(index); }
 		inline const Ref<miru::crossplatform::ImageView>& GetSwapchainDepthImageView() const { return m_RenderSurface->GetSwapchainDepthImageView(); }
 		inline const Ref<miru::crossplatform::Framebuffer>* GetFramebuffers() { return m_RenderSurface->GetFramebuffers(); }
+		inline uint32_t GetFramesInFlight() const { return m_RenderSurface->GetFramesInFlight(); }
 	
 		inline const miru::crossplatform::GraphicsAPI::API& GetGraphicsAPI() const { m_RenderSurface->GetGraphicsAPI(); }
 		inline bool IsD3D12() const { return miru::crossplatform::GraphicsAPI::IsD3D12(); }
@@ -26,6 +26,25 @@ void Camera::Update()
 	m_UB->SubmitData();
 }
 
+std::array<Vec4, 6> Camera::GetFrustumPlanes() const
+{
+	//Gribb-Hartmann: the planes are sums and differences of the rows of the view-projection matrix.
+	const Mat4 viewProj = m_UB->proj * m_UB->view;
+	const Vec4 row0(viewProj.a, viewProj.b, viewProj.c, viewProj.d);
+	const Vec4 row1(viewProj.e, viewProj.f, viewProj.g, viewProj.h);
+	const Vec4 row2(viewProj.i, viewProj.j, viewProj.k, viewProj.l);
+	const Vec4 row3(viewProj.m, viewProj.n, viewProj.o, viewProj.p);
+
+	//The near plane assumes a [-1, 1] depth range, which is conservative for a [0, 1] depth range.
+	std::array<Vec4, 6> planes = { row3 + row0, row3 - row0, row3 + row1, row3 - row1, row3 + row2, row3 - row2 };
+	for (Vec4& plane : planes)
+	{
+		const float length = std::sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+		plane = length > 0.0f ? plane * (1.0f / length) : plane;
+	}
+	return planes;
+}
+
 void Camera::DefineProjection()
 {
 	if (m_CI.projectionType == ProjectionType::ORTHOGRAPHIC)
@@ -79,5 +98,6 @@ void Camera::InitialiseUB()
 	ubCI.debugName = "GEAR_CORE_Camera_CameraUB: " + m_CI.debugName;
 	ubCI.device = m_CI.device;
 	ubCI.data = zero;
+	ubCI.perFrame = true;
 	m_UB = CreateRef<Uniformbuffer<CameraUB>>(&ubCI);
 }
\ No newline at end of file
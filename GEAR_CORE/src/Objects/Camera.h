@@ -72,6 +72,10 @@ namespace objects
 
 		const Ref<graphics::Uniformbuffer<CameraUB>>& GetUB() const { return m_UB; };
 
+		//World space planes of the view frustum as (normal, distance). Normals point inwards and are normalised.
+		//Order: left, right, bottom, top, near, far.
+		std::array<mars::Vec4, 6> GetFrustumPlanes() const;
+
 	private:
 		void DefineProjection();
 		void DefineView();
@@ -111,6 +111,7 @@ Ref<FontLibrary::Font> FontLibrary::GenerateFont(const GenerateInfo& GI)
 	data.width = GI.generatedTextureSize;
 	data.height = GI.generatedTextureSize;
 	data.depth = 1;
+	data.mipLevels = 1;
 
 	Ref<Font>result = CreateRef<Font>();
 	result->textureAtlas = GenerateTextureAtlas(GI, data);
@@ -168,6 +169,7 @@ Ref<FontLibrary::Font> FontLibrary::LoadGeneratedFont(const GenerateInfo& GI)
 			data.data = stbi_load(filepathPNG.c_str(), (int*)&data.width, (int*)&data.height, (int*)&bpp, 4);
 			data.size = data.width * data.height * 4;
 			data.depth = 1;
+			data.mipLevels = 1;
 			result->textureAtlas = GenerateTextureAtlas(GI, data);
 			result->fontHeightPx = GI.fontHeightPx;
 		}
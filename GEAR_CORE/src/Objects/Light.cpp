@@ -54,6 +54,7 @@ void Light::InitialiseUB()
 		ubCI.debugName = "GEAR_CORE_Light_LightUBType: " + m_CI.debugName;
 		ubCI.device = m_CI.device;
 		ubCI.data = zero0;
+		ubCI.perFrame = true;
 		s_UB = CreateRef<Uniformbuffer<LightUB>>(&ubCI);
 	}
 }
\ No newline at end of file
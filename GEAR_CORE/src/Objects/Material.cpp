@@ -23,6 +23,8 @@ Material::Material(CreateInfo* pCreateInfo)
 
 Material::~Material()
 {
+	for (auto& destroyCallback : m_DestroyCallbacks)
+		destroyCallback.second(this);
 }
 
 void Material::Update()
@@ -69,10 +71,24 @@ void Material::InitialiseUB()
 	ubCI.debugName = "GEAR_CORE_Material_PBRConstants: " + m_CI.debugName;
 	ubCI.device = m_CI.device;
 	ubCI.data = zero;
+	ubCI.perFrame = true;
 
 	m_UB = CreateRef<Uniformbuffer<PBRConstantsUB>>(&ubCI);
 }
 
+const Ref<Texture>& Material::GetDefaultTexture(TextureType type)
+{
+	switch (type)
+	{
+	case TextureType::NORMAL:
+		return s_BlueNormalTexture;
+	case TextureType::EMISSIVE:
+		return s_BlackTexture;
+	default:
+		return s_WhiteTexture;
+	}
+}
+
 void Material::CreateDefaultColourTextures()
 {
 	if (s_WhiteTexture && s_BlueNormalTexture && s_BlackTexture)
@@ -88,6 +104,7 @@ void Material::CreateDefaultColourTextures()
 	texCI.data.width = 1;
 	texCI.data.height = 1;
 	texCI.data.depth = 1;
+	texCI.data.mipLevels = 1;
 	texCI.mipLevels = 1;
 	texCI.arrayLayers = 1;
 	texCI.type = miru::crossplatform::Image::Type::TYPE_2D;
@@ -12,6 +12,8 @@ namespace objects
 	class Material
 	{
 	public:
+		typedef std::function<void(const Material*)> DestroyCallback;
+
 		enum class TextureType : uint32_t
 		{
 			UNKNOWN = 0,		//Pre-Initialised value
@@ -31,15 +33,6 @@ namespace objects
 			graphics::UniformBufferStructures::PBRConstants	pbrConstants;
 		};
 	
-	private:
-		static Ref<graphics::Texture> s_WhiteTexture;
-		static Ref<graphics::Texture> s_BlueNormalTexture;
-		static Ref<graphics::Texture> s_BlackTexture;
-		static std::map<std::string, Ref<Material>> s_LoadedMaterials;
-		
-		typedef graphics::UniformBufferStructures::PBRConstants PBRConstantsUB;
-		Ref<graphics::Uniformbuffer<PBRConstantsUB>> m_UB;
-	
 		struct Properties
 		{
 			std::string name;
@@ -58,7 +51,20 @@ namespace objects
 			mars::Vec4	colourEmissive;
 			mars::Vec4	colourTransparent;
 			mars::Vec4	colourReflective;
-		} m_Properties;
+		};
+	
+	private:
+		static Ref<graphics::Texture> s_WhiteTexture;
+		static Ref<graphics::Texture> s_BlueNormalTexture;
+		static Ref<graphics::Texture> s_BlackTexture;
+		static std::map<std::string, Ref<Material>> s_LoadedMaterials;
+		
+		typedef graphics::UniformBufferStructures::PBRConstants PBRConstantsUB;
+		Ref<graphics::Uniformbuffer<PBRConstantsUB>> m_UB;
+	
+		Properties m_Properties;
+
+		mutable std::map<const void*, DestroyCallback> m_DestroyCallbacks;
 	
 	public:
 		CreateInfo m_CI;
@@ -77,6 +83,14 @@ namespace objects
 		inline const Ref<graphics::Uniformbuffer<PBRConstantsUB>>& GetUB() const { return m_UB; }
 
 		inline std::string GetDebugName() const { return "GEAR_CORE_Material: " + m_CI.debugName; }
+
+		//Called by the destructor, so that the holders of resources for the Material can release them. There is one callback
+		//per holder, which must remove it if the holder is destroyed first.
+		inline void AddDestroyCallback(const void* holder, const DestroyCallback& callback) const { m_DestroyCallbacks[holder] = callback; }
+		inline void RemoveDestroyCallback(const void* holder) const { m_DestroyCallbacks.erase(holder); }
+
+		//Returns the texture used when none is provided for the type. These are null until the first Material is created.
+		static const Ref<graphics::Texture>& GetDefaultTexture(TextureType type);
 	
 		inline static void AddMaterial(std::string name, const Ref<Material>& material) { s_LoadedMaterials.insert({ name, material }); }
 		inline static Ref<Material> FindMaterial(const std::string& name) 
@@ -16,30 +16,82 @@ Mesh::Mesh(CreateInfo* pCreateInfo)
 	if(!m_CI.filepath.empty())
 		m_CI.data = ModelLoader::LoadModelData(m_CI.filepath);
 
-	graphics::Vertexbuffer::CreateInfo vbCI;
-	vbCI.debugName = "GEAR_CORE_Mesh: " + m_CI.debugName;
-	vbCI.device = m_CI.device;
-	vbCI.stride = ModelLoader::GetSizeOfVertex();
-
-	graphics::Indexbuffer::CreateInfo ibCI;
-	ibCI.debugName = "GEAR_CORE_Mesh: " + m_CI.debugName;
-	ibCI.device = m_CI.device;
-	ibCI.stride = ModelLoader::GetSizeOfIndex();
+	m_MeshPool = m_CI.pMeshPool ? m_CI.pMeshPool : graphics::MeshPool::GetMeshPool(m_CI.device, ModelLoader::GetSizeOfVertex(m_CI.vertexFormat));
+	if (m_MeshPool->GetCreateInfo().vertexStride != ModelLoader::GetSizeOfVertex(m_CI.vertexFormat))
+	{
+		GEAR_ASSERT(/*Level::ERROR,*/ ErrorCode::OBJECTS | ErrorCode::INVALID_VALUE, "The vertex stride of the MeshPool does not match the vertex format of the Mesh.");
+	}
 	
+	std::vector<graphics::FrustumCulling::Bounds> bounds;
+	for (auto& mesh : m_CI.data.meshes)
+	{
+		//Imported meshes have their bounds calculated by the ModelLoader.
+		if (m_CI.filepath.empty())
+			ModelLoader::CalculateBounds(mesh);
+		bounds.push_back({ mesh.boundingBoxMin, mesh.boundingBoxMax, mesh.boundingSphere });
+	}
+	m_Bounds = graphics::FrustumCulling::Merge(bounds);
+
+	//All of the sub-meshes are quantised to the bounds of the Mesh, so that they share one dequantisation.
+	std::vector<ModelLoader::QuantisedVertex> quantisedVertices;
+	if (m_CI.vertexFormat == ModelLoader::VertexFormat::QUANTISED)
+	{
+		const mars::Vec3 extent = m_Bounds.boxMax - m_Bounds.boxMin;
+		m_PositionScale = mars::Vec4(extent.x / 65535.0f, extent.y / 65535.0f, extent.z / 65535.0f, 0.0f);
+		m_PositionOffset = mars::Vec4(m_Bounds.boxMin, 0.0f);
+	}
+
 	for (auto& mesh : m_CI.data.meshes)
 	{
-		vbCI.data = mesh.vertices.data();
-		vbCI.size = mesh.vertices.size() * ModelLoader::GetSizeOfVertex();
-		m_VBs.emplace_back(CreateRef<graphics::Vertexbuffer>(&vbCI));
+		const void* vertexData = mesh.vertices.data();
+		if (m_CI.vertexFormat == ModelLoader::VertexFormat::QUANTISED)
+		{
+			quantisedVertices.resize(mesh.vertices.size());
+			ModelLoader::QuantiseVertices(mesh.vertices.data(), mesh.vertices.size(), m_Bounds.boxMin, m_Bounds.boxMax, quantisedVertices.data());
+			vertexData = quantisedVertices.data();
+		}
+
+		//The simplified index lists follow the full one in the same Allocation, as they index the same vertices.
+		std::vector<LevelOfDetail>& levels = m_LevelsOfDetail.emplace_back();
+		levels.push_back({ 0, static_cast<uint32_t>(mesh.indices.size()), 0.0f });
+		const uint32_t* indexData = mesh.indices.data();
+		std::vector<uint32_t> indices;
+		if (!mesh.levelsOfDetail.empty())
+		{
+			indices = mesh.indices;
+			for (const ModelLoader::LevelOfDetail& levelOfDetail : mesh.levelsOfDetail)
+			{
+				levels.push_back({ static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(levelOfDetail.indices.size()), levelOfDetail.error });
+				indices.insert(indices.end(), levelOfDetail.indices.begin(), levelOfDetail.indices.end());
+			}
+			indexData = indices.data();
+		}
+		const uint32_t indexCount = levels.back().firstIndex + levels.back().indexCount;
+		m_Allocations.emplace_back(m_MeshPool->Allocate(vertexData, static_cast<uint32_t>(mesh.vertices.size()), indexData, indexCount));
 
-		ibCI.data = mesh.indices.data();
-		ibCI.size = mesh.indices.size() * ModelLoader::GetSizeOfIndex();
-		m_IBs.emplace_back(CreateRef<graphics::Indexbuffer>(&ibCI));
+		if (m_LevelOfDetailErrors.size() < levels.size())
+			m_LevelOfDetailErrors.resize(levels.size(), 0.0f);
 
 		m_Materials.push_back(mesh.pMaterial);
 	}
+
+	for (const std::vector<LevelOfDetail>& levels : m_LevelsOfDetail)
+	{
+		for (size_t i = 0; i < m_LevelOfDetailErrors.size(); i++)
+			m_LevelOfDetailErrors[i] = std::max(m_LevelOfDetailErrors[i], levels[std::min(i, levels.size() - 1)].error);
+	}
 }
 
 Mesh::~Mesh()
 {
+	for (auto& allocation : m_Allocations)
+		m_MeshPool->Free(allocation);
+}
+
+uint32_t Mesh::GetTriangleCount(uint32_t level) const
+{
+	uint32_t triangleCount = 0;
+	for (size_t i = 0; i < m_LevelsOfDetail.size(); i++)
+		triangleCount += GetLevelOfDetail(i, level).indexCount / 3;
+	return triangleCount;
 }
\ No newline at end of file
@@ -1,8 +1,8 @@
 #pragma once
 
 #include "gear_core_common.h"
-#include "Graphics/Vertexbuffer.h"
-#include "Graphics/Indexbuffer.h"
+#include "Graphics/FrustumCulling.h"
+#include "Graphics/MeshPool.h"
 #include "Utils/ModelLoader.h"
 
 namespace gear 
@@ -18,12 +18,27 @@ namespace objects
 			void*					device;
 			std::string				filepath;
 			ModelLoader::ModelData	data;
+			Ref<graphics::MeshPool>	pMeshPool;	//Optional: If nullptr, the shared pool of the device is used.
+			ModelLoader::VertexFormat vertexFormat = ModelLoader::VertexFormat::FULL;	//QUANTISED requires a pipeline compiled with GEAR_QUANTISED_VERTEX.
+		};
+
+		//A range of the indices of a sub-mesh's Allocation. Level 0 is the full mesh.
+		struct LevelOfDetail
+		{
+			uint32_t	firstIndex;	//Relative to the firstIndex of the Allocation.
+			uint32_t	indexCount;
+			float		error;		//Object space distance from the full mesh.
 		};
 
 	private:
-		std::vector<Ref<graphics::Vertexbuffer>> m_VBs;
-		std::vector<Ref<graphics::Indexbuffer>> m_IBs;
+		Ref<graphics::MeshPool> m_MeshPool;
+		std::vector<Ref<graphics::MeshPool::Allocation>> m_Allocations;
 		std::vector<Ref<objects::Material>> m_Materials;
+		graphics::FrustumCulling::Bounds m_Bounds;
+		mars::Vec4 m_PositionScale = mars::Vec4(1.0f, 1.0f, 1.0f, 0.0f);
+		mars::Vec4 m_PositionOffset = mars::Vec4(0.0f, 0.0f, 0.0f, 0.0f);
+		std::vector<std::vector<LevelOfDetail>> m_LevelsOfDetail;
+		std::vector<float> m_LevelOfDetailErrors;
 
 	public:
 		CreateInfo m_CI;
@@ -32,10 +47,25 @@ namespace objects
 		Mesh(CreateInfo* pCreateInfo);
 		~Mesh();
 
-		inline const std::vector<Ref<graphics::Vertexbuffer>>& GetVertexBuffers() const { return m_VBs; }
-		inline const std::vector<Ref<graphics::Indexbuffer>>& GetIndexBuffers() const { return m_IBs; }
+		inline const Ref<graphics::MeshPool>& GetMeshPool() const { return m_MeshPool; }
+		//One range in the MeshPool per sub-mesh.
+		inline const std::vector<Ref<graphics::MeshPool::Allocation>>& GetAllocations() const { return m_Allocations; }
 		inline const std::vector<Ref<objects::Material>>& GetMaterials() const { return m_Materials; }
 		inline const ModelLoader::ModelData& GetModelData() const { return m_CI.data; }
+		//Object space bounds of all of the sub-meshes.
+		inline const graphics::FrustumCulling::Bounds& GetBounds() const { return m_Bounds; }
+		inline ModelLoader::VertexFormat GetVertexFormat() const { return m_CI.vertexFormat; }
+		//Dequantises the positions of QUANTISED vertices: position = positionOffset + quantisedPosition * positionScale.
+		//For FULL vertices, the scale is 1 and the offset is 0.
+		inline const mars::Vec4& GetPositionScale() const { return m_PositionScale; }
+		inline const mars::Vec4& GetPositionOffset() const { return m_PositionOffset; }
+
+		//Sub-meshes with fewer levels use their last level for the levels beyond it.
+		inline const LevelOfDetail& GetLevelOfDetail(size_t subMesh, uint32_t level) const { const auto& levels = m_LevelsOfDetail[subMesh]; return levels[std::min<size_t>(level, levels.size() - 1)]; }
+		inline uint32_t GetLevelOfDetailCount() const { return static_cast<uint32_t>(m_LevelOfDetailErrors.size()); }
+		//The largest error of any sub-mesh at the level.
+		inline float GetLevelOfDetailError(uint32_t level) const { return m_LevelOfDetailErrors.empty() ? 0.0f : m_LevelOfDetailErrors[std::min<size_t>(level, m_LevelOfDetailErrors.size() - 1)]; }
+		uint32_t GetTriangleCount(uint32_t level = 0) const;
 
 		inline void SetOverrideMaterial(size_t index, const Ref<objects::Material>& material) { m_Materials[index] = material; }
 	};
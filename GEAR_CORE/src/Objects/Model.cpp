@@ -16,6 +16,8 @@ Model::Model(CreateInfo* pCreateInfo)
 
 Model::~Model()
 {
+	for (auto& destroyCallback : m_DestroyCallbacks)
+		destroyCallback.second(this);
 }
 
 void Model::Update()
@@ -24,6 +26,11 @@ void Model::Update()
 	m_UB->texCoordScale0.y = m_CI.materialTextureScaling.y;
 	m_UB->texCoordScale1.x = m_CI.materialTextureScaling.x;
 	m_UB->texCoordScale1.y = m_CI.materialTextureScaling.y;
+	if (m_CI.pMesh)
+	{
+		m_UB->positionScale = m_CI.pMesh->GetPositionScale();
+		m_UB->positionOffset = m_CI.pMesh->GetPositionOffset();
+	}
 
 	m_UB->modl = TransformToMat4(m_CI.transform);
 	m_UB->SubmitData();
@@ -37,5 +44,6 @@ void Model::InitialiseUB()
 	ubCI.debugName = "GEAR_CORE_Model: " + m_CI.debugName;
 	ubCI.device = m_CI.device;
 	ubCI.data = zero;
+	ubCI.perFrame = true;
 	m_UB = CreateRef<Uniformbuffer<ModelUB>>(&ubCI);
 }
\ No newline at end of file
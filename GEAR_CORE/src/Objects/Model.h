@@ -14,6 +14,8 @@ namespace objects
 	class Model
 	{
 	public:
+		typedef std::function<void(const Model*)> DestroyCallback;
+
 		struct CreateInfo
 		{
 			std::string			debugName;
@@ -27,6 +29,9 @@ namespace objects
 	private:
 		typedef graphics::UniformBufferStructures::Model ModelUB;
 		Ref<graphics::Uniformbuffer<ModelUB>> m_UB;
+		uint32_t m_LevelOfDetail = 0;
+
+		mutable std::map<const void*, DestroyCallback> m_DestroyCallbacks;
 	
 	public:
 		CreateInfo m_CI;
@@ -40,12 +45,21 @@ namespace objects
 	
 		inline const Ref<objects::Mesh>& GetMesh() const { return m_CI.pMesh; }
 		inline const std::string& GetPipelineName() const { return m_CI.renderPipelineName; }
+
+		//The level of the Mesh to draw. It is clamped to the levels of each sub-mesh. Set by the Scene when selection is enabled.
+		inline void SetLevelOfDetail(uint32_t level) { m_LevelOfDetail = level; }
+		inline uint32_t GetLevelOfDetail() const { return m_LevelOfDetail; }
 	
 		inline Ref<graphics::Uniformbuffer<ModelUB>>& GetUB() { return m_UB; }
 		inline const Ref<graphics::Uniformbuffer<ModelUB>>& GetUB() const { return m_UB; }
 		inline const mars::Mat4& GetModlMatrix() const { return m_UB->modl; }
 	
 		inline std::string GetDebugName() const { return "GEAR_CORE_Model: " + m_CI.debugName; }
+
+		//Called by the destructor, so that the holders of resources for the Model can release them. There is one callback
+		//per holder, which must remove it if the holder is destroyed first.
+		inline void AddDestroyCallback(const void* holder, const DestroyCallback& callback) const { m_DestroyCallbacks[holder] = callback; }
+		inline void RemoveDestroyCallback(const void* holder) const { m_DestroyCallbacks.erase(holder); }
 	
 	private:
 		void InitialiseUB();
@@ -20,15 +20,20 @@ Skybox::Skybox(CreateInfo* pCreateInfo)
 	m_Cubemap = m_CI.filepaths.size() == 6;
 	m_HDR = stbi_is_hdr(m_CI.filepaths[0].c_str());
 
+	//The source is only sampled, so it can use the shared exponent format. The generated cubemaps are storage images.
+	const Image::Format sourceFormat = m_HDR ? (m_CI.compactHDR ? Image::Format::E5B9G9R9_UFLOAT_PACK32 : Image::Format::R32G32B32A32_SFLOAT) : Image::Format::R8G8B8A8_UNORM;
+	const Image::Format generatedFormat = m_HDR ? (m_CI.compactHDR ? Image::Format::R16G16B16A16_SFLOAT : Image::Format::R32G32B32A32_SFLOAT) : Image::Format::R8G8B8A8_UNORM;
+
 	m_TextureCI.debugName = "GEAR_CORE_Skybox: " + m_CI.debugName;
 	m_TextureCI.device = m_CI.device;
 	m_TextureCI.dataType = Texture::DataType::FILE;
 	m_TextureCI.file.filepaths = m_CI.filepaths.data();
 	m_TextureCI.file.count = m_CI.filepaths.size();
+	m_TextureCI.file.flipVertically = false;
 	m_TextureCI.mipLevels = 1;
 	m_TextureCI.arrayLayers = m_CI.filepaths.size() == 6 ? 6 : 1;
 	m_TextureCI.type = m_CI.filepaths.size() == 6 ? Image::Type::TYPE_CUBE : Image::Type::TYPE_2D;
-	m_TextureCI.format = m_HDR ? Image::Format::R32G32B32A32_SFLOAT : Image::Format::R8G8B8A8_UNORM;
+	m_TextureCI.format = sourceFormat;
 	m_TextureCI.samples = Image::SampleCountBit::SAMPLE_COUNT_1_BIT;
 	m_TextureCI.usage = Image::UsageBit(0);
 	m_TextureCI.generateMipMaps = false;
@@ -44,10 +49,11 @@ Skybox::Skybox(CreateInfo* pCreateInfo)
 		m_GeneratedCubemapCI.data.width = m_CI.generatedCubemapSize;
 		m_GeneratedCubemapCI.data.height = m_CI.generatedCubemapSize;
 		m_GeneratedCubemapCI.data.depth = 1;
+		m_GeneratedCubemapCI.data.mipLevels = 1;
 		m_GeneratedCubemapCI.mipLevels = GEAR_TEXTURE_MAX_MIP_LEVEL;
 		m_GeneratedCubemapCI.arrayLayers = 6;
 		m_GeneratedCubemapCI.type = Image::Type::TYPE_CUBE;
-		m_GeneratedCubemapCI.format = m_HDR ? Image::Format::R32G32B32A32_SFLOAT : Image::Format::R8G8B8A8_UNORM;
+		m_GeneratedCubemapCI.format = generatedFormat;
 		m_GeneratedCubemapCI.samples = Image::SampleCountBit::SAMPLE_COUNT_1_BIT;
 		m_GeneratedCubemapCI.usage = Image::UsageBit::STORAGE_BIT;
 		m_GeneratedCubemapCI.generateMipMaps = true;
@@ -66,10 +72,11 @@ Skybox::Skybox(CreateInfo* pCreateInfo)
 	m_GeneratedDiffuseCubemapCI.data.width = m_CI.generatedCubemapSize/16;
 	m_GeneratedDiffuseCubemapCI.data.height = m_CI.generatedCubemapSize/16;
 	m_GeneratedDiffuseCubemapCI.data.depth = 1;
+	m_GeneratedDiffuseCubemapCI.data.mipLevels = 1;
 	m_GeneratedDiffuseCubemapCI.mipLevels = 1;
 	m_GeneratedDiffuseCubemapCI.arrayLayers = 6;
 	m_GeneratedDiffuseCubemapCI.type = Image::Type::TYPE_CUBE;
-	m_GeneratedDiffuseCubemapCI.format = m_HDR ? Image::Format::R32G32B32A32_SFLOAT : Image::Format::R8G8B8A8_UNORM;
+	m_GeneratedDiffuseCubemapCI.format = generatedFormat;
 	m_GeneratedDiffuseCubemapCI.samples = Image::SampleCountBit::SAMPLE_COUNT_1_BIT;
 	m_GeneratedDiffuseCubemapCI.usage = Image::UsageBit::STORAGE_BIT;
 	m_GeneratedDiffuseCubemapCI.generateMipMaps = false;
@@ -83,10 +90,11 @@ Skybox::Skybox(CreateInfo* pCreateInfo)
 	m_GeneratedSpecularCubemapCI.data.width = m_CI.generatedCubemapSize;
 	m_GeneratedSpecularCubemapCI.data.height = m_CI.generatedCubemapSize;
 	m_GeneratedSpecularCubemapCI.data.depth = 1;
+	m_GeneratedSpecularCubemapCI.data.mipLevels = 1;
 	m_GeneratedSpecularCubemapCI.mipLevels = GEAR_TEXTURE_MAX_MIP_LEVEL;
 	m_GeneratedSpecularCubemapCI.arrayLayers = 6;
 	m_GeneratedSpecularCubemapCI.type = Image::Type::TYPE_CUBE;
-	m_GeneratedSpecularCubemapCI.format = m_HDR ? Image::Format::R32G32B32A32_SFLOAT : Image::Format::R8G8B8A8_UNORM;
+	m_GeneratedSpecularCubemapCI.format = generatedFormat;
 	m_GeneratedSpecularCubemapCI.samples = Image::SampleCountBit::SAMPLE_COUNT_1_BIT;
 	m_GeneratedSpecularCubemapCI.usage = Image::UsageBit::STORAGE_BIT;
 	m_GeneratedSpecularCubemapCI.generateMipMaps = true;
@@ -100,10 +108,11 @@ Skybox::Skybox(CreateInfo* pCreateInfo)
 	m_GeneratedSpecularBRDF_LUT_CI.data.width = m_CI.generatedCubemapSize;
 	m_GeneratedSpecularBRDF_LUT_CI.data.height = m_CI.generatedCubemapSize;
 	m_GeneratedSpecularBRDF_LUT_CI.data.depth = 1;
+	m_GeneratedSpecularBRDF_LUT_CI.data.mipLevels = 1;
 	m_GeneratedSpecularBRDF_LUT_CI.mipLevels = 1;
 	m_GeneratedSpecularBRDF_LUT_CI.arrayLayers = 1;
 	m_GeneratedSpecularBRDF_LUT_CI.type = Image::Type::TYPE_2D;
-	m_GeneratedSpecularBRDF_LUT_CI.format = m_HDR ? Image::Format::R32G32B32A32_SFLOAT : Image::Format::R8G8B8A8_UNORM;
+	m_GeneratedSpecularBRDF_LUT_CI.format = generatedFormat;
 	m_GeneratedSpecularBRDF_LUT_CI.samples = Image::SampleCountBit::SAMPLE_COUNT_1_BIT;
 	m_GeneratedSpecularBRDF_LUT_CI.usage = Image::UsageBit::STORAGE_BIT;
 	m_GeneratedSpecularBRDF_LUT_CI.generateMipMaps = false;
@@ -152,5 +161,6 @@ void Skybox::InitialiseUBs()
 	ubCI.debugName = "GEAR_CORE_Skybox_SkyboxInfo: " + m_CI.debugName;
 	ubCI.device = m_CI.device;
 	ubCI.data = zero;
+	ubCI.perFrame = true;
 	m_UB = CreateRef<Uniformbuffer<SkyboxInfoUB>>(&ubCI);
 }
\ No newline at end of file
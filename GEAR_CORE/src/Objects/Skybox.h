@@ -18,6 +18,7 @@ namespace objects
 			Transform					transform;
 			float						exposure = 1.0f;
 			float						gamma = 2.2f;
+			bool						compactHDR = true;	//Stores HDR images as E5B9G9R9_UFLOAT_PACK32 and the generated cubemaps as R16G16B16A16_SFLOAT, instead of R32G32B32A32_SFLOAT.
 		};
 
 	private:
@@ -5,6 +5,8 @@
 #include "INativeScript.h"
 
 #include "Core/Timer.h"
+#include "Graphics/FrustumCulling.h"
+#include "Graphics/LevelOfDetail.h"
 #include "Graphics/Renderer.h"
 
 using namespace arc;
@@ -62,10 +64,12 @@ void Scene::OnUpdate(Ref<graphics::Renderer>& renderer, core::Timer& timer)
 		}
 	}
 
+	Ref<Camera> camera;
 	auto& vCameraComponents = m_Registry.view<CameraComponent>();
 	for (auto& entity : vCameraComponents)
 	{
-		renderer->SubmitCamera(vCameraComponents.get<CameraComponent>(entity));
+		camera = vCameraComponents.get<CameraComponent>(entity);
+		renderer->SubmitCamera(camera);
 	}
 
 	std::vector<Ref<Light>> lights;
@@ -76,12 +80,44 @@ void Scene::OnUpdate(Ref<graphics::Renderer>& renderer, core::Timer& timer)
 	}
 	renderer->SubmitLights(lights);
 
+	//Cull the models against the camera that was submitted last, as that is the one the Renderer uses.
+	m_CullModels.clear();
+	m_CullBounds.clear();
 	auto& vModelComponents = m_Registry.view<ModelComponent>();
 	for (auto& entity : vModelComponents)
 	{
-		renderer->SubmitModel(vModelComponents.get<ModelComponent>(entity));
+		const Ref<Model>& model = vModelComponents.get<ModelComponent>(entity);
+		m_CullModels.push_back(model);
+		m_CullBounds.push_back(graphics::FrustumCulling::Transform(model->GetMesh()->GetBounds(), model->GetModlMatrix()));
 	}
 
+	size_t visibleCount = m_CullModels.size();
+	m_CullVisibility.assign(m_CullModels.size(), 1);
+	if (m_FrustumCulling && camera)
+		visibleCount = graphics::FrustumCulling::Cull(camera->GetFrustumPlanes(), m_CullBounds.data(), m_CullBounds.size(), m_CullVisibility.data());
+
+	graphics::LevelOfDetail::View view = {};
+	if (m_LevelOfDetail && camera)
+		view = graphics::LevelOfDetail::GetView(*camera, m_LevelOfDetailViewportHeight);
+
+	m_Statistics.submittedTriangles = 0;
+	m_Statistics.fullDetailTriangles = 0;
+	for (size_t i = 0; i < m_CullModels.size(); i++)
+	{
+		if (!m_CullVisibility[i])
+			continue;
+
+		const Ref<Model>& model = m_CullModels[i];
+		if (m_LevelOfDetail && camera)
+			model->SetLevelOfDetail(graphics::LevelOfDetail::Select(view, *model->GetMesh(), m_CullBounds[i], m_LevelOfDetailPixelThreshold));
+		renderer->SubmitModel(model);
+
+		m_Statistics.submittedTriangles += model->GetMesh()->GetTriangleCount(model->GetLevelOfDetail());
+		m_Statistics.fullDetailTriangles += model->GetMesh()->GetTriangleCount(0);
+	}
+	m_Statistics.visibleModels = static_cast<uint32_t>(visibleCount);
+	m_Statistics.culledModels = static_cast<uint32_t>(m_CullModels.size() - visibleCount);
+
 	auto& vSkyboxComponent = m_Registry.view<SkyboxComponent>();
 	for (auto& entity : vSkyboxComponent)
 	{
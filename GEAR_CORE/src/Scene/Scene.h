@@ -24,6 +24,15 @@ namespace scene
 			std::string filepath;
 			std::string nativeScriptDir;
 		};
+
+		//Models submitted to and culled from the Renderer in the last OnUpdate().
+		struct Statistics
+		{
+			uint32_t visibleModels;
+			uint32_t culledModels;
+			uint32_t submittedTriangles;	//At the selected level of detail of each model.
+			uint32_t fullDetailTriangles;	//Of the same models at level 0.
+		};
 	
 	public:
 		CreateInfo m_CI;
@@ -44,11 +53,28 @@ namespace scene
 		void SaveToFile();
 		inline void Play() { m_Playing = true; }
 		inline void Stop() { m_Playing = false; }
+
+		//Models outside of the camera's frustum are not submitted to the Renderer. Enabled by default.
+		inline void SetFrustumCulling(bool enable) { m_FrustumCulling = enable; }
+		//Visible models are drawn at the coarsest level of detail whose error is at most pixelThreshold pixels on a
+		//viewport of viewportHeight pixels. Disabled by default, in which case models keep the level that they have.
+		inline void SetLevelOfDetail(bool enable) { m_LevelOfDetail = enable; }
+		inline void SetLevelOfDetailThreshold(float pixelThreshold, float viewportHeight) { m_LevelOfDetailPixelThreshold = pixelThreshold; m_LevelOfDetailViewportHeight = viewportHeight; }
+		inline const Statistics& GetStatistics() const { return m_Statistics; }
 	
 	private:
 		entt::registry m_Registry;
 		bool m_Playing = false;
 
+		bool m_FrustumCulling = true;
+		std::vector<Ref<objects::Model>> m_CullModels;
+		std::vector<graphics::FrustumCulling::Bounds> m_CullBounds;
+		std::vector<uint8_t> m_CullVisibility;
+		bool m_LevelOfDetail = false;
+		float m_LevelOfDetailPixelThreshold = 1.0f;
+		float m_LevelOfDetailViewportHeight = 1080.0f;
+		Statistics m_Statistics = {};
+
 		friend class Entity;
 	};
 }
@@ -0,0 +1,498 @@
+#include "gear_core_common.h"
+#include "AssetDatabase.h"
+#include "Graphics/ImageDecoder.h"
+#include "Graphics/Texture.h"
+#include "Utils/MemoryMappedFile.h"
+#include "Utils/ModelLoader.h"
+
+#include <filesystem>
+
+using namespace gear;
+using namespace graphics;
+
+using namespace miru;
+using namespace miru::crossplatform;
+
+Ref<AssetDatabase> AssetDatabase::s_AssetDatabase = nullptr;
+
+AssetDatabase::AssetDatabase(CreateInfo* pCreateInfo)
+{
+	m_CI = *pCreateInfo;
+
+	m_ThreadPoolCI.debugName = "GEAR_CORE_ThreadPool_AssetDatabase: " + m_CI.debugName;
+	m_ThreadPoolCI.workerCount = m_CI.workerCount;
+	m_ThreadPool = CreateRef<core::ThreadPool>(&m_ThreadPoolCI);
+
+	std::error_code error;
+	std::filesystem::create_directories(m_CI.cacheDirectory, error);
+	Load();
+}
+
+AssetDatabase::~AssetDatabase()
+{
+	Wait();
+	Save();
+}
+
+std::string AssetDatabase::GetModel(const std::string& filepath, bool wait)
+{
+	const std::string settings = "optimise=" + std::to_string(ModelLoader::GetOptimiseMeshes() ? 1 : 0) + " version=" + std::to_string(GEAR_MODEL_COOKED_VERSION);
+	return Get(Type::MODEL, filepath, settings, wait);
+}
+
+std::string AssetDatabase::GetTexture(const std::string& filepath, Image::Format format, bool flipVertically, bool wait)
+{
+	if (!ImageDecoder::IsOutputFormat(format))
+	{
+		GEAR_WARN(ErrorCode::UTILS | ErrorCode::NOT_SUPPORTED, "Images can not be cooked to the format of %s.", filepath.c_str());
+		return "";
+	}
+	return Get(Type::TEXTURE, filepath, GetTextureSettings(format, flipVertically), wait);
+}
+
+std::vector<std::string> AssetDatabase::GetDependencies(const std::string& filepath)
+{
+	std::error_code error;
+	const std::filesystem::path canonicalFilepath = std::filesystem::weakly_canonical(filepath, error);
+	const std::string sourceFilepath = error ? filepath : canonicalFilepath.string();
+
+	std::vector<std::string> dependencies;
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	for (const auto& entry : m_Entries)
+	{
+		if (entry.second.filepath != sourceFilepath)
+			continue;
+		for (const Dependency& dependency : entry.second.dependencies)
+		{
+			if (std::find(dependencies.begin(), dependencies.end(), dependency.filepath) == dependencies.end())
+				dependencies.push_back(dependency.filepath);
+		}
+	}
+	return dependencies;
+}
+
+void AssetDatabase::Wait()
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	m_CookCondition.wait(lock, [this]() { return m_Statistics.pendingCooks == 0; });
+}
+
+bool AssetDatabase::Save()
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	if (!m_Modified)
+		return true;
+
+	auto WriteString = [](std::ofstream& stream, const std::string& string)
+	{
+		const uint32_t length = static_cast<uint32_t>(string.size());
+		stream.write((const char*)&length, sizeof(uint32_t));
+		stream.write(string.data(), length);
+	};
+
+	//The index is written next to the old one and then replaces it, so it is never seen half written.
+	const std::filesystem::path filepath = std::filesystem::path(m_CI.cacheDirectory) / GEAR_ASSET_DATABASE_FILENAME;
+	const std::filesystem::path tempFilepath = filepath.string() + ".tmp";
+	std::ofstream stream(tempFilepath, std::ios::binary);
+	if (!stream.is_open())
+	{
+		GEAR_WARN(ErrorCode::UTILS | ErrorCode::NO_FILE, "Unable to open %s.", tempFilepath.string().c_str());
+		return false;
+	}
+
+	const uint32_t header[3] = { GEAR_ASSET_DATABASE_MAGIC, GEAR_ASSET_DATABASE_VERSION, static_cast<uint32_t>(m_Entries.size()) };
+	stream.write((const char*)header, sizeof(header));
+	for (const auto& entry : m_Entries)
+	{
+		const Entry& e = entry.second;
+		const uint32_t type = static_cast<uint32_t>(e.type);
+		const uint32_t dependencyCount = static_cast<uint32_t>(e.dependencies.size());
+		stream.write((const char*)&type, sizeof(uint32_t));
+		WriteString(stream, e.filepath);
+		WriteString(stream, e.settings);
+		WriteString(stream, e.cookedFilepath);
+		stream.write((const char*)&e.sourceSize, sizeof(uint64_t));
+		stream.write((const char*)&e.sourceWriteTime, sizeof(int64_t));
+		stream.write((const char*)&e.sourceHash, sizeof(uint64_t));
+		stream.write((const char*)&dependencyCount, sizeof(uint32_t));
+		for (const Dependency& dependency : e.dependencies)
+		{
+			const uint32_t dependencyType = static_cast<uint32_t>(dependency.type);
+			stream.write((const char*)&dependencyType, sizeof(uint32_t));
+			WriteString(stream, dependency.filepath);
+			WriteString(stream, dependency.settings);
+		}
+	}
+	stream.close();
+	if (!stream)
+	{
+		GEAR_WARN(ErrorCode::UTILS | ErrorCode::INVALID_VALUE, "Unable to write %s.", tempFilepath.string().c_str());
+		return false;
+	}
+
+	std::error_code error;
+	std::filesystem::rename(tempFilepath, filepath, error);
+	if (error)
+	{
+		GEAR_WARN(ErrorCode::UTILS | ErrorCode::INVALID_VALUE, "Unable to write %s.", filepath.string().c_str());
+		return false;
+	}
+	m_Modified = false;
+	return true;
+}
+
+AssetDatabase::Statistics AssetDatabase::GetStatistics()
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	m_Statistics.entries = static_cast<uint32_t>(m_Entries.size());
+	return m_Statistics;
+}
+
+uint64_t AssetDatabase::Hash(const uint8_t* data, size_t size, uint64_t seed)
+{
+	//FNV-1a over 64-bit words. For a given state, each step is a bijection of the word, and the steps after it are
+	//bijections of the state, so changing one word always changes the hash. The final mix spreads the high bits down.
+	const uint64_t prime = 0x00000100000001B3ULL;
+	uint64_t hash = 0xCBF29CE484222325ULL ^ seed;
+	size_t i = 0;
+	for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+	{
+		uint64_t word;
+		memcpy(&word, data + i, sizeof(uint64_t));
+		hash = (hash ^ word) * prime;
+	}
+	uint64_t tail = 0;
+	if (i < size)
+		memcpy(&tail, data + i, size - i);
+	hash = (hash ^ tail) * prime;
+	hash = (hash ^ static_cast<uint64_t>(size)) * prime;
+
+	hash ^= hash >> 33;
+	hash *= 0xFF51AFD7ED558CCDULL;
+	hash ^= hash >> 33;
+	hash *= 0xC4CEB9FE1A85EC53ULL;
+	hash ^= hash >> 33;
+	return hash;
+}
+
+std::string AssetDatabase::Get(Type type, const std::string& filepath, const std::string& settings, bool wait)
+{
+	std::error_code error;
+	const std::filesystem::path canonicalFilepath = std::filesystem::weakly_canonical(filepath, error);
+	const std::string sourceFilepath = error ? filepath : canonicalFilepath.string();
+	const std::string key = GetKey(type, sourceFilepath, settings);
+
+	//The size and write time of the source decide whether its content has to be hashed again.
+	const uint64_t sourceSize = static_cast<uint64_t>(std::filesystem::file_size(sourceFilepath, error));
+	bool sourceExists = !error;
+	const int64_t sourceWriteTime = sourceExists ? static_cast<int64_t>(std::filesystem::last_write_time(sourceFilepath, error).time_since_epoch().count()) : 0;
+	sourceExists = sourceExists && !error;
+
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	auto it = m_Entries.find(key);
+	if (it == m_Entries.end())
+	{
+		Entry entry;
+		entry.type = type;
+		entry.filepath = sourceFilepath;
+		entry.settings = settings;
+		entry.sourceSize = 0;
+		entry.sourceWriteTime = 0;
+		entry.sourceHash = 0;
+		entry.cookFailed = false;
+		it = m_Entries.emplace(key, std::move(entry)).first;
+		m_Modified = true;
+	}
+	Entry* entry = &it->second;
+
+	if (!sourceExists)
+	{
+		//Without its source, an entry keeps using its cooked file.
+		if (!entry->cookedFilepath.empty() && std::filesystem::exists(entry->cookedFilepath, error))
+		{
+			m_Statistics.hits++;
+			return entry->cookedFilepath;
+		}
+		GEAR_WARN(ErrorCode::UTILS | ErrorCode::NO_FILE, "Unable to open %s.", filepath.c_str());
+		m_Statistics.misses++;
+		return "";
+	}
+
+	if (entry->sourceSize != sourceSize || entry->sourceWriteTime != sourceWriteTime)
+	{
+		//The content is hashed without holding the lock. Entries are never removed, so the entry stays valid.
+		lock.unlock();
+		const auto start = std::chrono::high_resolution_clock::now();
+		uint64_t sourceHash = 0;
+		const bool hashed = HashFile(sourceFilepath, sourceHash);
+		const double hashTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		lock.lock();
+
+		if (!hashed)
+		{
+			m_Statistics.misses++;
+			return "";
+		}
+		m_Statistics.hashedFiles++;
+		m_Statistics.hashedBytes += sourceSize;
+		m_Statistics.hashTime += hashTime;
+
+		if (entry->sourceHash != sourceHash)
+		{
+			//The old cooked file is removed, unless another entry was made from the same content.
+			const std::string oldCookedFilepath = entry->cookedFilepath;
+			entry->sourceHash = sourceHash;
+			entry->cookedFilepath.clear();
+			entry->dependencies.clear();
+			entry->cookFailed = false;
+
+			bool shared = oldCookedFilepath.empty();
+			for (auto other = m_Entries.begin(); other != m_Entries.end() && !shared; other++)
+				shared = other->second.cookedFilepath == oldCookedFilepath;
+			if (!shared)
+				std::filesystem::remove(oldCookedFilepath, error);
+		}
+		entry->sourceSize = sourceSize;
+		entry->sourceWriteTime = sourceWriteTime;
+		m_Modified = true;
+	}
+
+	if (!entry->cookedFilepath.empty() && !std::filesystem::exists(entry->cookedFilepath, error))
+		entry->cookedFilepath.clear();
+
+	std::string result;
+	if (!entry->cookedFilepath.empty())
+	{
+		m_Statistics.hits++;
+		result = entry->cookedFilepath;
+	}
+	else if (!entry->cookFailed)
+	{
+		m_Statistics.misses++;
+		if (!entry->cook.valid())
+		{
+			//The cooked file is written under a temporary name, and only replaces any existing file once it is complete.
+			const uint64_t sourceHash = entry->sourceHash;
+			const std::string cookedFilepath = GetCookedFilepath(m_CI.cacheDirectory, type, sourceFilepath, settings, sourceHash);
+			Ref<std::promise<bool>> promise = CreateRef<std::promise<bool>>();
+			entry->cook = promise->get_future().share();
+			m_Statistics.pendingCooks++;
+
+			m_ThreadPool->Submit([this, type, sourceFilepath, settings, key, sourceHash, cookedFilepath, promise]()
+				{
+					char suffix[32];
+					snprintf(suffix, sizeof(suffix), ".%016llx.tmp", static_cast<unsigned long long>(std::hash<std::thread::id>()(std::this_thread::get_id())));
+					const std::string tempFilepath = cookedFilepath + suffix;
+
+					const auto start = std::chrono::high_resolution_clock::now();
+					std::vector<Dependency> dependencies;
+					std::error_code error;
+					bool cooked = Cook(type, sourceFilepath, settings, tempFilepath, dependencies);
+					if (cooked)
+						std::filesystem::rename(tempFilepath, cookedFilepath, error);
+					if (!cooked || error)
+						std::filesystem::remove(tempFilepath, error);
+					cooked = cooked && std::filesystem::exists(cookedFilepath, error);
+					const double cookTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+					std::unique_lock<std::mutex> lock(m_Mutex);
+					Entry& entry = m_Entries.at(key);
+					entry.cook = {};
+					if (entry.sourceHash == sourceHash)
+					{
+						//A cook of content that has changed since is dropped, and the next request cooks the new content.
+						entry.cookedFilepath = cooked ? cookedFilepath : "";
+						entry.dependencies = std::move(dependencies);
+						entry.cookFailed = !cooked;
+					}
+					m_Statistics.cooks += cooked ? 1 : 0;
+					m_Statistics.failedCooks += cooked ? 0 : 1;
+					m_Statistics.cookTime += cookTime;
+					m_Statistics.pendingCooks--;
+					m_Modified = true;
+					lock.unlock();
+
+					m_CookCondition.notify_all();
+					promise->set_value(cooked);
+				});
+		}
+
+		if (wait)
+		{
+			std::shared_future<bool> cook = entry->cook;
+			lock.unlock();
+			cook.wait();
+			lock.lock();
+			result = entry->cookedFilepath;
+		}
+	}
+	else
+	{
+		m_Statistics.misses++;
+	}
+
+	//The dependencies are requested without waiting, so that any that are stale are cooked alongside.
+	const std::vector<Dependency> dependencies = result.empty() ? std::vector<Dependency>() : entry->dependencies;
+	lock.unlock();
+	for (const Dependency& dependency : dependencies)
+		Get(dependency.type, dependency.filepath, dependency.settings, false);
+
+	return result;
+}
+
+bool AssetDatabase::Cook(Type type, const std::string& filepath, const std::string& settings, const std::string& cookedFilepath, std::vector<Dependency>& dependencies)
+{
+	switch (type)
+	{
+	case Type::MODEL:
+	{
+		const ModelLoader::ModelData modelData = ModelLoader::ImportModelData(filepath);
+		if (modelData.meshes.empty() || !ModelLoader::WriteCookedModel(cookedFilepath, modelData))
+			return false;
+
+		//The textures are requested as ModelLoader::CreateMaterials() loads them. Their paths are relative to the working directory.
+		for (const ModelLoader::MeshData& mesh : modelData.meshes)
+		{
+			for (const auto& textureFilepath : mesh.material.textureFilepaths)
+			{
+				ImageDecoder::ImageInfo info;
+				if (!ImageDecoder::GetImageInfo(textureFilepath.second, info))
+					continue;
+
+				std::error_code error;
+				const std::filesystem::path canonicalFilepath = std::filesystem::weakly_canonical(textureFilepath.second, error);
+				Dependency dependency;
+				dependency.type = Type::TEXTURE;
+				dependency.filepath = error ? textureFilepath.second : canonicalFilepath.string();
+				dependency.settings = GetTextureSettings(Texture::GetDecodeFormat(Image::Format::R8G8B8A8_UNORM, info.hdr), false);
+
+				auto SameDependency = [&dependency](const Dependency& other) { return other.filepath == dependency.filepath && other.settings == dependency.settings; };
+				if (std::find_if(dependencies.begin(), dependencies.end(), SameDependency) == dependencies.end())
+					dependencies.push_back(dependency);
+			}
+		}
+		return true;
+	}
+	case Type::TEXTURE:
+	{
+		uint32_t format = 0, flipVertically = 0;
+		ImageDecoder::ImageInfo info;
+		if (sscanf(settings.c_str(), "format=%u flip=%u", &format, &flipVertically) != 2 || !ImageDecoder::GetImageInfo(filepath, info))
+			return false;
+
+		Texture::CookedHeader header;
+		header.format = static_cast<Image::Format>(format);
+		header.width = info.width;
+		header.height = info.height;
+		header.depth = 1;
+		header.mipLevels = 1;
+		header.arrayLayers = 1;
+		header.size = size_t(info.width) * size_t(info.height) * Texture::GetTexelSize(header.format);
+
+		std::vector<uint8_t> data(header.size);
+		if (!ImageDecoder::DecodeImage(filepath, info.width, info.height, header.format, flipVertically != 0, data.data()))
+			return false;
+		return Texture::WriteCookedTexture(cookedFilepath, header, data.data());
+	}
+	default:
+		return false;
+	}
+}
+
+void AssetDatabase::Load()
+{
+	const std::string filepath = (std::filesystem::path(m_CI.cacheDirectory) / GEAR_ASSET_DATABASE_FILENAME).string();
+	std::ifstream stream(filepath, std::ios::binary);
+	if (!stream.is_open())
+		return;
+
+	auto ReadString = [&stream](std::string& string) -> bool
+	{
+		uint32_t length = 0;
+		stream.read((char*)&length, sizeof(uint32_t));
+		if (!stream || length > 65536)
+			return false;
+		string.resize(length);
+		stream.read(&string[0], length);
+		return !!stream;
+	};
+
+	uint32_t header[3] = { 0, 0, 0 };
+	stream.read((char*)header, sizeof(header));
+	if (!stream || header[0] != GEAR_ASSET_DATABASE_MAGIC || header[1] != GEAR_ASSET_DATABASE_VERSION)
+	{
+		GEAR_WARN(ErrorCode::UTILS | ErrorCode::LOAD_FAILED, "%s is not valid. The assets will be cooked again.", filepath.c_str());
+		return;
+	}
+
+	std::map<std::string, Entry> entries;
+	for (uint32_t i = 0; i < header[2]; i++)
+	{
+		Entry entry;
+		uint32_t type = 0, dependencyCount = 0;
+		stream.read((char*)&type, sizeof(uint32_t));
+		bool valid = stream && ReadString(entry.filepath) && ReadString(entry.settings) && ReadString(entry.cookedFilepath);
+		stream.read((char*)&entry.sourceSize, sizeof(uint64_t));
+		stream.read((char*)&entry.sourceWriteTime, sizeof(int64_t));
+		stream.read((char*)&entry.sourceHash, sizeof(uint64_t));
+		stream.read((char*)&dependencyCount, sizeof(uint32_t));
+		valid = valid && stream && type <= static_cast<uint32_t>(Type::TEXTURE);
+		for (uint32_t j = 0; valid && j < dependencyCount; j++)
+		{
+			Dependency dependency;
+			uint32_t dependencyType = 0;
+			stream.read((char*)&dependencyType, sizeof(uint32_t));
+			valid = stream && dependencyType <= static_cast<uint32_t>(Type::TEXTURE) && ReadString(dependency.filepath) && ReadString(dependency.settings);
+			dependency.type = static_cast<Type>(dependencyType);
+			entry.dependencies.push_back(std::move(dependency));
+		}
+		if (!valid)
+		{
+			GEAR_WARN(ErrorCode::UTILS | ErrorCode::LOAD_FAILED, "%s is not valid. The assets will be cooked again.", filepath.c_str());
+			return;
+		}
+
+		entry.type = static_cast<Type>(type);
+		entry.cookFailed = false;
+		entries[GetKey(entry.type, entry.filepath, entry.settings)] = std::move(entry);
+	}
+
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	m_Entries = std::move(entries);
+}
+
+std::string AssetDatabase::GetKey(Type type, const std::string& filepath, const std::string& settings)
+{
+	return std::to_string(static_cast<uint32_t>(type)) + "|" + settings + "|" + filepath;
+}
+
+std::string AssetDatabase::GetTextureSettings(Image::Format format, bool flipVertically)
+{
+	return "format=" + std::to_string(static_cast<uint32_t>(format)) + " flip=" + std::to_string(flipVertically ? 1 : 0) + " version=" + std::to_string(GEAR_TEXTURE_COOKED_VERSION);
+}
+
+bool AssetDatabase::HashFile(const std::string& filepath, uint64_t& hash)
+{
+	std::error_code error;
+	if (std::filesystem::file_size(filepath, error) == 0 && !error)
+	{
+		hash = Hash(nullptr, 0);
+		return true;
+	}
+
+	file_utils::MemoryMappedFile file(filepath);
+	if (!file.IsMapped())
+		return false;
+
+	hash = Hash(file.GetData(), file.GetSize());
+	return true;
+}
+
+std::string AssetDatabase::GetCookedFilepath(const std::string& cacheDirectory, Type type, const std::string& filepath, const std::string& settings, uint64_t sourceHash)
+{
+	//The cooked file is named after the source and a hash of its content and settings.
+	char hash[17];
+	snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(Hash(reinterpret_cast<const uint8_t*>(settings.data()), settings.size(), sourceHash ^ static_cast<uint64_t>(type))));
+	const std::string extension = type == Type::MODEL ? GEAR_MODEL_COOKED_FILE_EXTENSION : GEAR_TEXTURE_COOKED_FILE_EXTENSION;
+	return (std::filesystem::path(cacheDirectory) / (std::filesystem::path(filepath).stem().string() + "_" + hash + extension)).string();
+}
\ No newline at end of file
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "gear_core_common.h"
+#include "Core/ThreadPool.h"
+
+namespace gear
+{
+	//Maps source files to the cooked files made from them in a cache directory. Each entry is keyed by the source file
+	//and its import settings, and records the hash of the source's content, so a cooked file is only handed out while
+	//it was made from the current content with the current settings. The source's size and write time are recorded
+	//too, and the content is only hashed again when they change. Stale and missing entries are cooked on a pool of
+	//worker threads. Cooked files are named after the hash of the content and settings, so copies of one source share
+	//them. The entries are kept in an index file in the cache directory between runs.
+	//Models are cooked to cooked model files, and images to cooked texture files holding their decoded texels.
+	class AssetDatabase
+	{
+	public:
+		struct CreateInfo
+		{
+			std::string	debugName;
+			std::string	cacheDirectory;
+			uint32_t	workerCount;	//0 uses the hardware thread count.
+		};
+
+		enum class Type : uint32_t
+		{
+			MODEL,
+			TEXTURE
+		};
+
+		struct Statistics
+		{
+			uint64_t	hits;			//Requests answered with a cooked file.
+			uint64_t	misses;			//Requests for stale or missing entries.
+			uint64_t	hashedFiles;
+			uint64_t	hashedBytes;
+			uint32_t	cooks;
+			uint32_t	failedCooks;
+			uint32_t	pendingCooks;
+			uint32_t	entries;
+			double		hashTime;		//In milliseconds.
+			double		cookTime;		//In milliseconds, summed over the workers.
+		};
+
+		#define GEAR_ASSET_DATABASE_FILENAME "GEAR_CORE_AssetDatabase.gadb"
+		#define GEAR_ASSET_DATABASE_MAGIC 0x42444147 //'GADB'
+		#define GEAR_ASSET_DATABASE_VERSION 1
+
+	private:
+		struct Dependency
+		{
+			Type		type;
+			std::string	filepath;
+			std::string	settings;
+		};
+
+		struct Entry
+		{
+			Type						type;
+			std::string					filepath;			//Canonical.
+			std::string					settings;
+			uint64_t					sourceSize;
+			int64_t						sourceWriteTime;
+			uint64_t					sourceHash;
+			std::string					cookedFilepath;		//Made from sourceHash. Empty if it has not been cooked.
+			std::vector<Dependency>		dependencies;		//Loaded with the cooked file, such as a model's textures.
+			std::shared_future<bool>	cook;				//Valid while the entry is being cooked.
+			bool						cookFailed;			//Cooking sourceHash failed, so it is not tried again until the source changes.
+		};
+
+		CreateInfo m_CI;
+
+		Ref<core::ThreadPool> m_ThreadPool;
+		core::ThreadPool::CreateInfo m_ThreadPoolCI;
+
+		std::mutex m_Mutex;
+		std::condition_variable m_CookCondition;
+		std::map<std::string, Entry> m_Entries;
+		Statistics m_Statistics = {};
+		bool m_Modified = false;
+
+		static Ref<AssetDatabase> s_AssetDatabase;
+
+	public:
+		AssetDatabase(CreateInfo* pCreateInfo);
+		~AssetDatabase();
+
+		const CreateInfo& GetCreateInfo() { return m_CI; }
+
+		//The shared database, which the ModelLoader and Texture load through. There is none until one is set.
+		inline static const Ref<AssetDatabase>& GetAssetDatabase() { return s_AssetDatabase; }
+		inline static void SetAssetDatabase(const Ref<AssetDatabase>& assetDatabase) { s_AssetDatabase = assetDatabase; }
+
+		//Returns the cooked model file of the model if it is up to date. Otherwise the model is queued to be cooked, and
+		//if wait is true this waits for it, else an empty string is returned and the caller should import the source.
+		//The model's textures are recorded as its dependencies when it is cooked, and they are requested with the model.
+		//This is thread safe, as are all the functions below.
+		std::string GetModel(const std::string& filepath, bool wait = true);
+		//As GetModel(), for the texels of the image decoded to the format, which must be an ImageDecoder output format.
+		std::string GetTexture(const std::string& filepath, miru::crossplatform::Image::Format format, bool flipVertically, bool wait = false);
+		std::vector<std::string> GetDependencies(const std::string& filepath);
+
+		//Blocks until every queued cook has finished.
+		void Wait();
+		//Writes the index file if any entry has changed. This is also done on destruction, after waiting for the cooks.
+		bool Save();
+
+		Statistics GetStatistics();
+
+		//Hashes the data with 64-bit words, so that any single word that differs gives a different hash.
+		static uint64_t Hash(const uint8_t* data, size_t size, uint64_t seed = 0);
+
+	private:
+		std::string Get(Type type, const std::string& filepath, const std::string& settings, bool wait);
+		bool Cook(Type type, const std::string& filepath, const std::string& settings, const std::string& cookedFilepath, std::vector<Dependency>& dependencies);
+		void Load();
+
+		static std::string GetKey(Type type, const std::string& filepath, const std::string& settings);
+		static std::string GetTextureSettings(miru::crossplatform::Image::Format format, bool flipVertically);
+		static bool HashFile(const std::string& filepath, uint64_t& hash);
+		static std::string GetCookedFilepath(const std::string& cacheDirectory, Type type, const std::string& filepath, const std::string& settings, uint64_t sourceHash);
+	};
+}
\ No newline at end of file
@@ -0,0 +1,88 @@
+#include "gear_core_common.h"
+#include "MemoryMappedFile.h"
+
+#if defined(GEAR_PLATFORM_WINDOWS_OR_XBOX)
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace gear;
+using namespace file_utils;
+
+MemoryMappedFile::MemoryMappedFile(const std::string& filepath)
+	:m_Filepath(filepath)
+{
+#if defined(GEAR_PLATFORM_WINDOWS_OR_XBOX)
+	HANDLE file = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		GEAR_WARN(ErrorCode::UTILS | ErrorCode::NO_FILE, "Unable to open %s.", filepath.c_str());
+		return;
+	}
+	m_File = file;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+		return;
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mapping)
+	{
+		GEAR_WARN(ErrorCode::UTILS | ErrorCode::LOAD_FAILED, "Unable to map %s.", filepath.c_str());
+		return;
+	}
+	m_Mapping = mapping;
+
+	m_Data = reinterpret_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	if (!m_Data)
+	{
+		GEAR_WARN(ErrorCode::UTILS | ErrorCode::LOAD_FAILED, "Unable to map %s.", filepath.c_str());
+		return;
+	}
+	m_Size = static_cast<size_t>(size.QuadPart);
+#else
+	m_File = open(filepath.c_str(), O_RDONLY);
+	if (m_File == -1)
+	{
+		GEAR_WARN(ErrorCode::UTILS | ErrorCode::NO_FILE, "Unable to open %s.", filepath.c_str());
+		return;
+	}
+
+	struct stat status;
+	if (fstat(m_File, &status) != 0 || status.st_size == 0)
+		return;
+
+	void* data = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, m_File, 0);
+	if (data == MAP_FAILED)
+	{
+		GEAR_WARN(ErrorCode::UTILS | ErrorCode::LOAD_FAILED, "Unable to map %s.", filepath.c_str());
+		return;
+	}
+	//The whole file is usually read, so ask for it to be read ahead.
+	madvise(data, static_cast<size_t>(status.st_size), MADV_WILLNEED);
+
+	m_Data = reinterpret_cast<const uint8_t*>(data);
+	m_Size = static_cast<size_t>(status.st_size);
+#endif
+}
+
+MemoryMappedFile::~MemoryMappedFile()
+{
+#if defined(GEAR_PLATFORM_WINDOWS_OR_XBOX)
+	if (m_Data)
+		UnmapViewOfFile(m_Data);
+	if (m_Mapping)
+		CloseHandle(m_Mapping);
+	if (m_File)
+		CloseHandle(m_File);
+#else
+	if (m_Data)
+		munmap(const_cast<uint8_t*>(m_Data), m_Size);
+	if (m_File != -1)
+		close(m_File);
+#endif
+}
\ No newline at end of file
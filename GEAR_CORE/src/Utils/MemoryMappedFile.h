@@ -0,0 +1,39 @@
+#pragma once
+
+#include "gear_core_common.h"
+
+namespace gear
+{
+namespace file_utils
+{
+	//Maps a whole file into memory for reading. The pages are read from the file by the OS as they are first accessed,
+	//so data can be copied straight out of the file into its destination without an intermediate read buffer.
+	class MemoryMappedFile
+	{
+	private:
+		std::string m_Filepath;
+		const uint8_t* m_Data = nullptr;
+		size_t m_Size = 0;
+
+		#if defined(GEAR_PLATFORM_WINDOWS_OR_XBOX)
+		void* m_File = nullptr;
+		void* m_Mapping = nullptr;
+		#else
+		int m_File = -1;
+		#endif
+
+	public:
+		MemoryMappedFile(const std::string& filepath);
+		~MemoryMappedFile();
+
+		MemoryMappedFile(const MemoryMappedFile&) = delete;
+		MemoryMappedFile& operator=(const MemoryMappedFile&) = delete;
+
+		//Empty files and files that could not be opened are not mapped.
+		inline bool IsMapped() const { return m_Data != nullptr; }
+		inline const uint8_t* GetData() const { return m_Data; }
+		inline size_t GetSize() const { return m_Size; }
+		inline const std::string& GetFilepath() const { return m_Filepath; }
+	};
+}
+}
\ No newline at end of file
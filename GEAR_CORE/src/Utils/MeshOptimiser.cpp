@@ -0,0 +1,943 @@
+#include "gear_core_common.h"
+#include "MeshOptimiser.h"
+#include "Utils/MeshletBuilder.h"
+
+#include <cfloat>
+#include <unordered_map>
+
+using namespace gear;
+
+MeshOptimiser::Result MeshOptimiser::Optimise(ModelLoader::MeshData& mesh, const Options& options)
+{
+	Result result;
+	result.before = AnalyseVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size(), options.cacheSize);
+	if (mesh.indices.empty() || mesh.indices.size() % 3 != 0)
+	{
+		result.after = result.before;
+		return result;
+	}
+
+	if (options.deduplicateVertices)
+		DeduplicateVertices(mesh);
+	if (options.reorderForVertexCache)
+		ReorderForVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size());
+	if (options.buildMeshlets)
+		MeshletBuilder::Build(mesh);
+	else if (options.reorderForOverdraw)
+		ReorderForOverdraw(mesh.indices.data(), mesh.indices.size(), mesh.vertices.data(), mesh.vertices.size(), options.overdrawThreshold, options.cacheSize);
+	if (options.reorderForVertexFetch)
+		ReorderForVertexFetch(mesh);
+	GenerateLevelsOfDetail(mesh, options);
+
+	result.after = AnalyseVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size(), options.cacheSize);
+	return result;
+}
+
+size_t MeshOptimiser::DeduplicateVertices(ModelLoader::MeshData& mesh)
+{
+	const size_t vertexCount = mesh.vertices.size();
+	if (vertexCount == 0)
+		return 0;
+
+	//The bone weights of each vertex, in bone order.
+	std::vector<uint32_t> weightOffsets(vertexCount + 1, 0);
+	std::vector<std::pair<uint32_t, float>> weights;
+	if (!mesh.bones.empty())
+	{
+		for (const auto& bone : mesh.bones)
+		{
+			for (const auto& vertexIDAndWeight : bone.vertexIDsAndWeights)
+			{
+				if (vertexIDAndWeight.first < vertexCount)
+					weightOffsets[vertexIDAndWeight.first + 1]++;
+			}
+		}
+		for (size_t i = 0; i < vertexCount; i++)
+			weightOffsets[i + 1] += weightOffsets[i];
+
+		weights.resize(weightOffsets[vertexCount]);
+		std::vector<uint32_t> cursors(weightOffsets.begin(), weightOffsets.end() - 1);
+		for (uint32_t i = 0; i < static_cast<uint32_t>(mesh.bones.size()); i++)
+		{
+			for (const auto& vertexIDAndWeight : mesh.bones[i].vertexIDsAndWeights)
+			{
+				if (vertexIDAndWeight.first < vertexCount)
+					weights[cursors[vertexIDAndWeight.first]++] = { i, vertexIDAndWeight.second };
+			}
+		}
+	}
+
+	auto Hash = [&](uint32_t vertex) -> uint64_t
+	{
+		//Mixes the vertex and its bone weights 32 bits at a time.
+		uint64_t hash = 0;
+		auto HashWords = [&hash](const void* data, size_t size)
+		{
+			const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+			for (size_t i = 0; i < size; i += sizeof(uint32_t))
+			{
+				uint32_t word;
+				memcpy(&word, bytes + i, sizeof(uint32_t));
+				hash = (hash ^ word) * 0x9E3779B97F4A7C15ull;
+				hash ^= hash >> 29;
+			}
+		};
+		static_assert(sizeof(ModelLoader::Vertex) % sizeof(uint32_t) == 0 && sizeof(std::pair<uint32_t, float>) % sizeof(uint32_t) == 0, "Vertex data must be a whole number of words.");
+		HashWords(&mesh.vertices[vertex], sizeof(ModelLoader::Vertex));
+		for (uint32_t i = weightOffsets[vertex]; i < weightOffsets[vertex + 1]; i++)
+			HashWords(&weights[i], sizeof(weights[i]));
+		return hash;
+	};
+	auto Equal = [&](uint32_t a, uint32_t b) -> bool
+	{
+		if (memcmp(&mesh.vertices[a], &mesh.vertices[b], sizeof(ModelLoader::Vertex)) != 0)
+			return false;
+		if (weightOffsets[a + 1] - weightOffsets[a] != weightOffsets[b + 1] - weightOffsets[b])
+			return false;
+		for (uint32_t i = 0; i < weightOffsets[a + 1] - weightOffsets[a]; i++)
+		{
+			const auto& weightA = weights[weightOffsets[a] + i];
+			const auto& weightB = weights[weightOffsets[b] + i];
+			if (weightA.first != weightB.first || weightA.second != weightB.second)
+				return false;
+		}
+		return true;
+	};
+
+	//Open addressing table of the first vertex of each kind, at most half full.
+	size_t tableSize = 1;
+	while (tableSize < vertexCount * 2)
+		tableSize *= 2;
+	std::vector<uint32_t> table(tableSize, UINT32_MAX);
+
+	std::vector<uint32_t> remap(vertexCount);
+	uint32_t newVertexCount = 0;
+	for (uint32_t i = 0; i < static_cast<uint32_t>(vertexCount); i++)
+	{
+		size_t slot = static_cast<size_t>(Hash(i)) & (tableSize - 1);
+		while (table[slot] != UINT32_MAX && !Equal(table[slot], i))
+			slot = (slot + 1) & (tableSize - 1);
+
+		if (table[slot] == UINT32_MAX)
+		{
+			table[slot] = i;
+			remap[i] = newVertexCount++;
+		}
+		else
+		{
+			remap[i] = remap[table[slot]];
+		}
+	}
+
+	if (newVertexCount != vertexCount)
+		RemapVertices(mesh, remap, newVertexCount);
+	return vertexCount - newVertexCount;
+}
+
+void MeshOptimiser::ReorderForVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount)
+{
+	//Scores from Tom Forsyth's 'Linear-Speed Vertex Cache Optimisation'.
+	constexpr uint32_t CacheSize = 32;
+	constexpr uint32_t MaxValence = 32;
+	static const std::pair<std::array<float, CacheSize>, std::array<float, MaxValence + 1>> scores = []()
+	{
+		std::pair<std::array<float, CacheSize>, std::array<float, MaxValence + 1>> scores;
+		for (uint32_t i = 0; i < CacheSize; i++)
+		{
+			//The vertices of the last triangle get a fixed score, so that the next triangle does not reuse too many of them.
+			scores.first[i] = i < 3 ? 0.75f : powf(1.0f - float(i - 3) / float(CacheSize - 3), 1.5f);
+		}
+		//Vertices with few triangles left are boosted, so that they are finished and do not leave lone triangles behind.
+		scores.second[0] = 0.0f;
+		for (uint32_t i = 1; i <= MaxValence; i++)
+			scores.second[i] = 2.0f * powf(float(i), -0.5f);
+		return scores;
+	}();
+
+	const size_t triangleCount = indexCount / 3;
+	if (triangleCount == 0)
+		return;
+
+	//The triangles that use each vertex.
+	std::vector<uint32_t> valences(vertexCount, 0);
+	for (size_t i = 0; i < indexCount; i++)
+		valences[indices[i]]++;
+	std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+	for (size_t i = 0; i < vertexCount; i++)
+		adjacencyOffsets[i + 1] = adjacencyOffsets[i] + valences[i];
+	std::vector<uint32_t> adjacency(indexCount);
+	{
+		std::vector<uint32_t> cursors(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (size_t i = 0; i < indexCount; i++)
+			adjacency[cursors[indices[i]]++] = static_cast<uint32_t>(i / 3);
+	}
+
+	std::vector<int32_t> cachePositions(vertexCount, -1);
+	auto VertexScore = [&](uint32_t vertex) -> float
+	{
+		const uint32_t valence = valences[vertex];
+		if (valence == 0)
+			return -1.0f;
+		const int32_t cachePosition = cachePositions[vertex];
+		return (cachePosition >= 0 ? scores.first[cachePosition] : 0.0f) + scores.second[std::min(valence, MaxValence)];
+	};
+
+	std::vector<float> vertexScores(vertexCount);
+	for (uint32_t i = 0; i < static_cast<uint32_t>(vertexCount); i++)
+		vertexScores[i] = VertexScore(i);
+
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<uint32_t> result;
+	result.reserve(indexCount);
+
+	std::vector<uint32_t> cache, newCache;
+	cache.reserve(CacheSize + 3);
+	newCache.reserve(CacheSize + 3);
+
+	size_t nextUnemitted = 0;
+	size_t bestTriangle = 0;
+	while (result.size() < indexCount)
+	{
+		//Dead end: None of the cached vertices have triangles left, so continue with the next triangle in the input order.
+		if (bestTriangle == SIZE_MAX)
+		{
+			while (emitted[nextUnemitted])
+				nextUnemitted++;
+			bestTriangle = nextUnemitted;
+		}
+
+		const uint32_t* triangle = &indices[bestTriangle * 3];
+		emitted[bestTriangle] = true;
+		result.insert(result.end(), triangle, triangle + 3);
+
+		//Remove the triangle from its vertices' lists of remaining triangles.
+		for (size_t i = 0; i < 3; i++)
+		{
+			const uint32_t vertex = triangle[i];
+			uint32_t* begin = &adjacency[adjacencyOffsets[vertex]];
+			uint32_t* end = begin + valences[vertex];
+			uint32_t* it = std::find(begin, end, static_cast<uint32_t>(bestTriangle));
+			if (it != end)
+			{
+				*it = *(end - 1);
+				valences[vertex]--;
+			}
+		}
+
+		//The triangle's vertices move to the front of the cache.
+		newCache.assign(triangle, triangle + 3);
+		for (uint32_t vertex : cache)
+		{
+			if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2])
+				newCache.push_back(vertex);
+		}
+		for (uint32_t vertex : cache)
+			cachePositions[vertex] = -1;
+		for (size_t i = 0; i < newCache.size(); i++)
+			cachePositions[newCache[i]] = i < CacheSize ? static_cast<int32_t>(i) : -1;
+
+		//Only the scores of vertices whose cache position changed need updating, and the best next triangle uses one of them.
+		for (uint32_t vertex : newCache)
+			vertexScores[vertex] = VertexScore(vertex);
+
+		float bestScore = -1.0f;
+		bestTriangle = SIZE_MAX;
+		for (uint32_t vertex : newCache)
+		{
+			for (uint32_t i = adjacencyOffsets[vertex]; i < adjacencyOffsets[vertex] + valences[vertex]; i++)
+			{
+				const uint32_t adjacentTriangle = adjacency[i];
+				const uint32_t* adjacentIndices = &indices[adjacentTriangle * 3];
+				const float score = vertexScores[adjacentIndices[0]] + vertexScores[adjacentIndices[1]] + vertexScores[adjacentIndices[2]];
+				if (score > bestScore)
+				{
+					bestScore = score;
+					bestTriangle = adjacentTriangle;
+				}
+			}
+		}
+
+		if (newCache.size() > CacheSize)
+			newCache.resize(CacheSize);
+		std::swap(cache, newCache);
+	}
+
+	memcpy(indices, result.data(), indexCount * sizeof(uint32_t));
+}
+
+void MeshOptimiser::ReorderForOverdraw(uint32_t* indices, size_t indexCount, const ModelLoader::Vertex* vertices, size_t vertexCount, float threshold, uint32_t cacheSize)
+{
+	const size_t triangleCount = indexCount / 3;
+	if (triangleCount == 0)
+		return;
+
+	//FIFO cache simulation: A vertex is in the cache if it was added in the last cacheSize misses.
+	std::vector<uint32_t> cacheTimestamps(vertexCount, 0);
+	uint32_t timestamp = cacheSize + 1;
+	auto Misses = [&](size_t triangle) -> uint32_t
+	{
+		uint32_t misses = 0;
+		for (size_t i = 0; i < 3; i++)
+		{
+			const uint32_t vertex = indices[triangle * 3 + i];
+			if (timestamp - cacheTimestamps[vertex] > cacheSize)
+			{
+				cacheTimestamps[vertex] = timestamp++;
+				misses++;
+			}
+		}
+		return misses;
+	};
+	auto ResetCache = [&]() { timestamp += cacheSize + 1; };
+
+	//Hard boundaries are where the cache restarts, which the vertex cache order leaves where it reaches a dead end.
+	std::vector<size_t> hardBoundaries;
+	for (size_t i = 0; i < triangleCount; i++)
+	{
+		if (Misses(i) == 3)
+			hardBoundaries.push_back(i);
+	}
+	hardBoundaries.push_back(triangleCount);
+	if (hardBoundaries.front() != 0)
+		hardBoundaries.insert(hardBoundaries.begin(), 0);
+
+	//Soft boundaries split a run of triangles wherever the ACMR so far is within the threshold of the run's ACMR.
+	std::vector<size_t> clusterStarts;
+	for (size_t i = 0; i + 1 < hardBoundaries.size(); i++)
+	{
+		const size_t start = hardBoundaries[i];
+		const size_t end = hardBoundaries[i + 1];
+
+		ResetCache();
+		uint32_t runMisses = 0;
+		for (size_t j = start; j < end; j++)
+			runMisses += Misses(j);
+		const float clusterThreshold = threshold * float(runMisses) / float(end - start);
+
+		ResetCache();
+		clusterStarts.push_back(start);
+		uint32_t clusterMisses = 0;
+		size_t clusterTriangles = 0;
+		for (size_t j = start; j < end; j++)
+		{
+			clusterMisses += Misses(j);
+			clusterTriangles++;
+			if (j + 1 < end && float(clusterMisses) / float(clusterTriangles) <= clusterThreshold)
+			{
+				clusterStarts.push_back(j + 1);
+				clusterMisses = 0;
+				clusterTriangles = 0;
+				ResetCache();
+			}
+		}
+	}
+	clusterStarts.push_back(triangleCount);
+
+	//Clusters facing away from the centre of the mesh are on its outside, so they are drawn first to occlude the rest.
+	double meshCentre[3] = { 0.0, 0.0, 0.0 };
+	for (size_t i = 0; i < indexCount; i++)
+	{
+		const mars::Vec4& position = vertices[indices[i]].position;
+		meshCentre[0] += position.x; meshCentre[1] += position.y; meshCentre[2] += position.z;
+	}
+	for (double& component : meshCentre)
+		component /= double(indexCount);
+
+	const size_t clusterCount = clusterStarts.size() - 1;
+	std::vector<float> sortKeys(clusterCount);
+	for (size_t i = 0; i < clusterCount; i++)
+	{
+		float centroid[3] = { 0.0f, 0.0f, 0.0f };
+		float normal[3] = { 0.0f, 0.0f, 0.0f };
+		float area = 0.0f;
+		for (size_t j = clusterStarts[i]; j < clusterStarts[i + 1]; j++)
+		{
+			const mars::Vec4& p0 = vertices[indices[j * 3 + 0]].position;
+			const mars::Vec4& p1 = vertices[indices[j * 3 + 1]].position;
+			const mars::Vec4& p2 = vertices[indices[j * 3 + 2]].position;
+			const float e1[3] = { p1.x - p0.x, p1.y - p0.y, p1.z - p0.z };
+			const float e2[3] = { p2.x - p0.x, p2.y - p0.y, p2.z - p0.z };
+			const float cross[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+			const float triangleArea = sqrtf(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]);
+
+			//The centroid is weighted by area, and the cross products are already scaled by it.
+			centroid[0] += (p0.x + p1.x + p2.x) * triangleArea / 3.0f;
+			centroid[1] += (p0.y + p1.y + p2.y) * triangleArea / 3.0f;
+			centroid[2] += (p0.z + p1.z + p2.z) * triangleArea / 3.0f;
+			normal[0] += cross[0]; normal[1] += cross[1]; normal[2] += cross[2];
+			area += triangleArea;
+		}
+
+		const float normalLength = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+		if (area == 0.0f || normalLength == 0.0f)
+		{
+			sortKeys[i] = 0.0f;
+			continue;
+		}
+		sortKeys[i] = 0.0f;
+		for (size_t j = 0; j < 3; j++)
+			sortKeys[i] += (centroid[j] / area - static_cast<float>(meshCentre[j])) * normal[j] / normalLength;
+	}
+
+	std::vector<uint32_t> clusterOrder(clusterCount);
+	for (uint32_t i = 0; i < static_cast<uint32_t>(clusterCount); i++)
+		clusterOrder[i] = i;
+	std::stable_sort(clusterOrder.begin(), clusterOrder.end(), [&](uint32_t a, uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+
+	std::vector<uint32_t> result;
+	result.reserve(indexCount);
+	for (uint32_t cluster : clusterOrder)
+		result.insert(result.end(), indices + clusterStarts[cluster] * 3, indices + clusterStarts[cluster + 1] * 3);
+	memcpy(indices, result.data(), indexCount * sizeof(uint32_t));
+}
+
+void MeshOptimiser::ReorderForVertexFetch(ModelLoader::MeshData& mesh)
+{
+	std::vector<uint32_t> remap(mesh.vertices.size(), UINT32_MAX);
+	uint32_t newVertexCount = 0;
+	for (uint32_t index : mesh.indices)
+	{
+		if (remap[index] == UINT32_MAX)
+			remap[index] = newVertexCount++;
+	}
+	RemapVertices(mesh, remap, newVertexCount);
+}
+
+//Sum of squared distances to a set of planes: Q(p) = p^T A p + 2 b^T p + c.
+struct Quadric
+{
+	double a00 = 0.0, a01 = 0.0, a02 = 0.0, a11 = 0.0, a12 = 0.0, a22 = 0.0;
+	double b0 = 0.0, b1 = 0.0, b2 = 0.0;
+	double c = 0.0;
+
+	void AddPlane(double nx, double ny, double nz, double d, double weight)
+	{
+		a00 += weight * nx * nx; a01 += weight * nx * ny; a02 += weight * nx * nz;
+		a11 += weight * ny * ny; a12 += weight * ny * nz; a22 += weight * nz * nz;
+		b0 += weight * nx * d; b1 += weight * ny * d; b2 += weight * nz * d;
+		c += weight * d * d;
+	}
+	void Add(const Quadric& other)
+	{
+		a00 += other.a00; a01 += other.a01; a02 += other.a02; a11 += other.a11; a12 += other.a12; a22 += other.a22;
+		b0 += other.b0; b1 += other.b1; b2 += other.b2;
+		c += other.c;
+	}
+	double Error(const mars::Vec4& p) const
+	{
+		const double x = p.x, y = p.y, z = p.z;
+		const double error = a00 * x * x + a11 * y * y + a22 * z * z + 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z)
+			+ 2.0 * (b0 * x + b1 * y + b2 * z) + c;
+		return std::max(error, 0.0);
+	}
+};
+
+//Distance from p to the closest point of the triangle abc, from Ericson's 'Real-Time Collision Detection'.
+static float PointTriangleDistance(const mars::Vec4& p, const mars::Vec4& a, const mars::Vec4& b, const mars::Vec4& c)
+{
+	auto Sub = [](const mars::Vec4& x, const mars::Vec4& y) -> std::array<float, 3> { return { x.x - y.x, x.y - y.y, x.z - y.z }; };
+	auto Dot = [](const std::array<float, 3>& x, const std::array<float, 3>& y) -> float { return x[0] * y[0] + x[1] * y[1] + x[2] * y[2]; };
+	auto Distance = [&](const std::array<float, 3>& ap, const std::array<float, 3>& ab, const std::array<float, 3>& ac, float v, float w) -> float
+	{
+		const std::array<float, 3> d = { ap[0] - ab[0] * v - ac[0] * w, ap[1] - ab[1] * v - ac[1] * w, ap[2] - ab[2] * v - ac[2] * w };
+		return std::sqrt(Dot(d, d));
+	};
+
+	const std::array<float, 3> ab = Sub(b, a), ac = Sub(c, a), ap = Sub(p, a);
+	const float d1 = Dot(ab, ap), d2 = Dot(ac, ap);
+	if (d1 <= 0.0f && d2 <= 0.0f)
+		return Distance(ap, ab, ac, 0.0f, 0.0f);
+
+	const std::array<float, 3> bp = Sub(p, b);
+	const float d3 = Dot(ab, bp), d4 = Dot(ac, bp);
+	if (d3 >= 0.0f && d4 <= d3)
+		return Distance(ap, ab, ac, 1.0f, 0.0f);
+
+	const float vc = d1 * d4 - d3 * d2;
+	if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+		return Distance(ap, ab, ac, d1 / (d1 - d3), 0.0f);
+
+	const std::array<float, 3> cp = Sub(p, c);
+	const float d5 = Dot(ab, cp), d6 = Dot(ac, cp);
+	if (d6 >= 0.0f && d5 <= d6)
+		return Distance(ap, ab, ac, 0.0f, 1.0f);
+
+	const float vb = d5 * d2 - d1 * d6;
+	if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+		return Distance(ap, ab, ac, 0.0f, d2 / (d2 - d6));
+
+	const float va = d3 * d6 - d5 * d4;
+	if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+	{
+		const float w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+		return Distance(ap, ab, ac, 1.0f - w, w);
+	}
+
+	const float denominator = 1.0f / (va + vb + vc);
+	return Distance(ap, ab, ac, vb * denominator, vc * denominator);
+}
+
+std::vector<uint32_t> MeshOptimiser::Simplify(const uint32_t* indices, size_t indexCount, const ModelLoader::Vertex* vertices, size_t vertexCount,
+	size_t targetIndexCount, float targetError, float* resultError)
+{
+	std::vector<uint32_t> result(indices, indices + indexCount);
+	if (resultError)
+		*resultError = 0.0f;
+	if (indexCount % 3 != 0 || indexCount <= targetIndexCount)
+		return result;
+
+	//Vertices that share a position are welded for the topology, so that seams are not mistaken for borders.
+	std::vector<uint32_t> positionIDs(vertexCount);
+	std::vector<bool> seam(vertexCount, false);
+	{
+		std::unordered_map<uint64_t, std::vector<uint32_t>> buckets;
+		buckets.reserve(vertexCount);
+		for (uint32_t i = 0; i < static_cast<uint32_t>(vertexCount); i++)
+		{
+			uint32_t bits[3];
+			memcpy(bits, &vertices[i].position.x, sizeof(bits));
+			const uint64_t hash = (uint64_t(bits[0]) * 73856093ull) ^ (uint64_t(bits[1]) * 19349663ull << 16) ^ (uint64_t(bits[2]) * 83492791ull << 32);
+
+			std::vector<uint32_t>& bucket = buckets[hash];
+			positionIDs[i] = i;
+			for (uint32_t other : bucket)
+			{
+				if (memcmp(&vertices[other].position.x, &vertices[i].position.x, sizeof(bits)) == 0)
+				{
+					positionIDs[i] = positionIDs[other];
+					seam[i] = true;
+					seam[other] = true;
+					break;
+				}
+			}
+			if (positionIDs[i] == i)
+				bucket.push_back(i);
+		}
+	}
+
+	//An edge is on an open border if the opposite half edge does not exist. The half edges are listed by the position
+	//that they start from.
+	std::vector<uint32_t> halfEdgeOffsets(vertexCount + 1, 0);
+	std::vector<uint32_t> halfEdges(indexCount);
+	for (size_t i = 0; i < indexCount; i++)
+		halfEdgeOffsets[positionIDs[indices[i]] + 1]++;
+	for (size_t i = 0; i < vertexCount; i++)
+		halfEdgeOffsets[i + 1] += halfEdgeOffsets[i];
+	{
+		std::vector<uint32_t> cursors(halfEdgeOffsets.begin(), halfEdgeOffsets.end() - 1);
+		for (size_t i = 0; i < indexCount; i += 3)
+		{
+			for (size_t j = 0; j < 3; j++)
+				halfEdges[cursors[positionIDs[indices[i + j]]]++] = positionIDs[indices[i + (j + 1) % 3]];
+		}
+	}
+	auto HasHalfEdge = [&](uint32_t a, uint32_t b) -> bool
+	{
+		const uint32_t* begin = halfEdges.data() + halfEdgeOffsets[positionIDs[a]];
+		const uint32_t* end = halfEdges.data() + halfEdgeOffsets[positionIDs[a] + 1];
+		return std::find(begin, end, positionIDs[b]) != end;
+	};
+	auto IsBorderEdge = [&](uint32_t a, uint32_t b) -> bool
+	{
+		return !HasHalfEdge(a, b) || !HasHalfEdge(b, a);
+	};
+
+	//Manifold vertices move onto any neighbour. Border vertices with one border edge in and one out move along the border.
+	//Seam vertices, and border vertices where several borders meet, are locked.
+	enum class Kind : uint8_t { MANIFOLD, BORDER, LOCKED };
+	std::vector<Kind> kinds(vertexCount, Kind::MANIFOLD);
+	std::vector<bool> borderHalfEdges(indexCount, false);	//Of the input triangles.
+	{
+		std::vector<uint8_t> borderEdgesOut(vertexCount, 0), borderEdgesIn(vertexCount, 0);
+		for (size_t i = 0; i < indexCount; i += 3)
+		{
+			for (size_t j = 0; j < 3; j++)
+			{
+				const uint32_t a = indices[i + j];
+				const uint32_t b = indices[i + (j + 1) % 3];
+				if (!HasHalfEdge(b, a))
+				{
+					borderHalfEdges[i + j] = true;
+					borderEdgesOut[a] = std::min(borderEdgesOut[a] + 1, 255);
+					borderEdgesIn[b] = std::min(borderEdgesIn[b] + 1, 255);
+				}
+			}
+		}
+		for (size_t i = 0; i < vertexCount; i++)
+		{
+			if (seam[i] || borderEdgesOut[i] > 1 || borderEdgesIn[i] > 1 || borderEdgesOut[i] != borderEdgesIn[i])
+				kinds[i] = Kind::LOCKED;
+			else if (borderEdgesOut[i] == 1)
+				kinds[i] = Kind::BORDER;
+		}
+	}
+
+	//The planes of the triangles around each position, and planes perpendicular to the triangles along the borders,
+	//which keep the borders in place.
+	std::vector<Quadric> quadrics(vertexCount);
+	for (size_t i = 0; i < indexCount; i += 3)
+	{
+		const mars::Vec4* p[3] = { &vertices[indices[i + 0]].position, &vertices[indices[i + 1]].position, &vertices[indices[i + 2]].position };
+		const double e1[3] = { p[1]->x - p[0]->x, p[1]->y - p[0]->y, p[1]->z - p[0]->z };
+		const double e2[3] = { p[2]->x - p[0]->x, p[2]->y - p[0]->y, p[2]->z - p[0]->z };
+		double n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+		const double length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+		if (length == 0.0)
+			continue;
+		n[0] /= length; n[1] /= length; n[2] /= length;
+
+		Quadric plane;
+		plane.AddPlane(n[0], n[1], n[2], -(n[0] * p[0]->x + n[1] * p[0]->y + n[2] * p[0]->z), 1.0);
+		for (size_t j = 0; j < 3; j++)
+			quadrics[positionIDs[indices[i + j]]].Add(plane);
+
+		for (size_t j = 0; j < 3; j++)
+		{
+			if (!borderHalfEdges[i + j])
+				continue;
+
+			const uint32_t a = indices[i + j];
+			const uint32_t b = indices[i + (j + 1) % 3];
+			const mars::Vec4& pa = vertices[a].position;
+			const mars::Vec4& pb = vertices[b].position;
+			const double edge[3] = { pb.x - pa.x, pb.y - pa.y, pb.z - pa.z };
+			double m[3] = { edge[1] * n[2] - edge[2] * n[1], edge[2] * n[0] - edge[0] * n[2], edge[0] * n[1] - edge[1] * n[0] };
+			const double mLength = std::sqrt(m[0] * m[0] + m[1] * m[1] + m[2] * m[2]);
+			if (mLength == 0.0)
+				continue;
+			m[0] /= mLength; m[1] /= mLength; m[2] /= mLength;
+
+			Quadric border;
+			border.AddPlane(m[0], m[1], m[2], -(m[0] * pa.x + m[1] * pa.y + m[2] * pa.z), 1.0);
+			quadrics[positionIDs[a]].Add(border);
+			quadrics[positionIDs[b]].Add(border);
+		}
+	}
+
+	struct Collapse
+	{
+		uint32_t	from;
+		uint32_t	to;
+		float		error;
+	};
+	std::vector<Collapse> collapses;
+	std::vector<uint32_t> order;
+	std::vector<uint32_t> histogram(65536);
+	auto SortKey = [](float error) -> uint32_t
+	{
+		uint32_t bits;
+		memcpy(&bits, &error, sizeof(float));
+		return bits >> 16;
+	};
+	std::vector<uint32_t> remap(vertexCount);
+	std::vector<uint32_t> representatives(vertexCount);	//The vertex that each vertex has been collapsed onto.
+	for (uint32_t i = 0; i < static_cast<uint32_t>(vertexCount); i++)
+		representatives[i] = i;
+	std::vector<bool> lockedThisPass(vertexCount);
+	std::vector<uint32_t> adjacencyOffsets(vertexCount + 1);
+	std::vector<uint32_t> adjacency;
+
+	const double maxError = double(targetError) * double(targetError);
+	while (result.size() > targetIndexCount)
+	{
+		const size_t triangleCount = result.size() / 3;
+
+		//The triangles around each vertex, to check collapses for flipped triangles.
+		std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+		for (uint32_t index : result)
+			adjacencyOffsets[index + 1]++;
+		for (size_t i = 0; i < vertexCount; i++)
+			adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+		adjacency.resize(result.size());
+		{
+			std::vector<uint32_t> cursors(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+			for (size_t i = 0; i < result.size(); i++)
+				adjacency[cursors[result[i]]++] = static_cast<uint32_t>(i / 3);
+		}
+
+		//Each edge is considered once in each direction that its vertices allow.
+		collapses.clear();
+		auto AddCollapse = [&](uint32_t from, uint32_t to)
+		{
+			if (kinds[from] == Kind::LOCKED || (kinds[from] == Kind::BORDER && (kinds[to] == Kind::MANIFOLD || !IsBorderEdge(from, to))))
+				return;
+
+			Quadric quadric = quadrics[positionIDs[from]];
+			quadric.Add(quadrics[positionIDs[to]]);
+			const double error = quadric.Error(vertices[to].position);
+			if (error <= maxError)
+				collapses.push_back({ from, to, static_cast<float>(error) });
+		};
+		for (size_t i = 0; i < result.size(); i += 3)
+		{
+			for (size_t j = 0; j < 3; j++)
+			{
+				const uint32_t a = result[i + j];
+				const uint32_t b = result[i + (j + 1) % 3];
+				//Manifold vertices have no border edges, so only edges between other vertices need looking up.
+				const bool interior = kinds[a] == Kind::MANIFOLD || kinds[b] == Kind::MANIFOLD;
+				if (interior ? a < b : (a < b || IsBorderEdge(a, b)))
+				{
+					AddCollapse(a, b);
+					AddCollapse(b, a);
+				}
+			}
+		}
+		if (collapses.empty())
+			break;
+
+		//Counting sort by the top 16 bits of the error, which keeps 7 bits of the mantissa. The bits of non-negative floats
+		//sort in the same order as the floats, and the order within a bucket does not matter at that precision.
+		std::fill(histogram.begin(), histogram.end(), 0);
+		for (const Collapse& collapse : collapses)
+			histogram[SortKey(collapse.error)]++;
+		uint32_t sum = 0;
+		for (uint32_t& count : histogram)
+		{
+			const uint32_t offset = sum;
+			sum += count;
+			count = offset;
+		}
+		order.resize(collapses.size());
+		for (uint32_t i = 0; i < static_cast<uint32_t>(collapses.size()); i++)
+			order[histogram[SortKey(collapses[i].error)]++] = i;
+
+		//Collapses are applied cheapest first, until half of the remaining reduction is reached, and at most one
+		//collapse is applied to each neighbourhood per pass, so that the flip checks see the current positions.
+		const size_t triangleGoal = std::max<size_t>((triangleCount - targetIndexCount / 3) / 2, 1);
+		size_t trianglesRemoved = 0;
+		for (uint32_t i = 0; i < static_cast<uint32_t>(vertexCount); i++)
+			remap[i] = i;
+		std::fill(lockedThisPass.begin(), lockedThisPass.end(), false);
+		for (uint32_t index : order)
+		{
+			const Collapse& collapse = collapses[index];
+			if (trianglesRemoved >= triangleGoal)
+				break;
+			if (lockedThisPass[collapse.from] || lockedThisPass[collapse.to])
+				continue;
+
+			bool flips = false;
+			const mars::Vec4& target = vertices[collapse.to].position;
+			for (uint32_t j = adjacencyOffsets[collapse.from]; !flips && j < adjacencyOffsets[collapse.from + 1]; j++)
+			{
+				const uint32_t* triangle = &result[adjacency[j] * 3];
+				if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to)
+					continue;
+
+				const mars::Vec4* p[3] = { &vertices[triangle[0]].position, &vertices[triangle[1]].position, &vertices[triangle[2]].position };
+				const mars::Vec4* q[3] = { p[0], p[1], p[2] };
+				for (size_t k = 0; k < 3; k++)
+				{
+					if (triangle[k] == collapse.from)
+						q[k] = &target;
+				}
+				auto Normal = [](const mars::Vec4* v[3], double n[3])
+				{
+					const double e1[3] = { v[1]->x - v[0]->x, v[1]->y - v[0]->y, v[1]->z - v[0]->z };
+					const double e2[3] = { v[2]->x - v[0]->x, v[2]->y - v[0]->y, v[2]->z - v[0]->z };
+					n[0] = e1[1] * e2[2] - e1[2] * e2[1]; n[1] = e1[2] * e2[0] - e1[0] * e2[2]; n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+				};
+				double before[3], after[3];
+				Normal(p, before);
+				Normal(q, after);
+				const double beforeLength = std::sqrt(before[0] * before[0] + before[1] * before[1] + before[2] * before[2]);
+				const double afterLength = std::sqrt(after[0] * after[0] + after[1] * after[1] + after[2] * after[2]);
+				//Flipped, or folded to a sliver, which could flip the next time that it is moved.
+				flips = before[0] * after[0] + before[1] * after[1] + before[2] * after[2] <= 0.25 * beforeLength * afterLength;
+
+				//Small turns can add up over several collapses, so the triangle must also face the same way as the normals of
+				//its vertices, where there are any.
+				double vertexNormal[3] = { 0.0, 0.0, 0.0 };
+				for (size_t k = 0; k < 3; k++)
+				{
+					const mars::Vec4& normal = vertices[triangle[k] == collapse.from ? collapse.to : triangle[k]].normal;
+					vertexNormal[0] += normal.x; vertexNormal[1] += normal.y; vertexNormal[2] += normal.z;
+				}
+				if (vertexNormal[0] != 0.0 || vertexNormal[1] != 0.0 || vertexNormal[2] != 0.0)
+					flips = flips || vertexNormal[0] * after[0] + vertexNormal[1] * after[1] + vertexNormal[2] * after[2] <= 0.0;
+			}
+			if (flips)
+				continue;
+
+			remap[collapse.from] = collapse.to;
+			quadrics[positionIDs[collapse.to]].Add(quadrics[positionIDs[collapse.from]]);
+			trianglesRemoved += kinds[collapse.from] == Kind::BORDER ? 1 : 2;
+
+			lockedThisPass[collapse.from] = true;
+			lockedThisPass[collapse.to] = true;
+			for (uint32_t j = adjacencyOffsets[collapse.from]; j < adjacencyOffsets[collapse.from + 1]; j++)
+			{
+				const uint32_t* triangle = &result[adjacency[j] * 3];
+				lockedThisPass[triangle[0]] = lockedThisPass[triangle[1]] = lockedThisPass[triangle[2]] = true;
+			}
+		}
+		if (trianglesRemoved == 0)
+			break;
+		for (uint32_t& representative : representatives)
+			representative = remap[representative];
+
+		//Triangles with two vertices at the same position have collapsed.
+		size_t writeIndex = 0;
+		for (size_t i = 0; i < result.size(); i += 3)
+		{
+			const uint32_t a = remap[result[i + 0]];
+			const uint32_t b = remap[result[i + 1]];
+			const uint32_t c = remap[result[i + 2]];
+			if (positionIDs[a] == positionIDs[b] || positionIDs[b] == positionIDs[c] || positionIDs[c] == positionIDs[a])
+				continue;
+			result[writeIndex++] = a;
+			result[writeIndex++] = b;
+			result[writeIndex++] = c;
+		}
+		result.resize(writeIndex);
+	}
+
+	//The error is the largest distance from an input vertex to the triangles within two rings of the vertex it was
+	//collapsed onto, which is at least its distance from the simplified surface.
+	if (resultError && result.size() < indexCount)
+	{
+		std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+		for (uint32_t index : result)
+			adjacencyOffsets[index + 1]++;
+		for (size_t i = 0; i < vertexCount; i++)
+			adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+		adjacency.resize(result.size());
+		std::vector<uint32_t> cursors(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (size_t i = 0; i < result.size(); i++)
+			adjacency[cursors[result[i]]++] = static_cast<uint32_t>(i / 3);
+
+		std::vector<bool> measured(vertexCount, false);
+		float error = 0.0f;
+		for (size_t i = 0; i < indexCount; i++)
+		{
+			const uint32_t vertex = indices[i];
+			const uint32_t representative = representatives[vertex];
+			if (representative == vertex || measured[vertex])
+				continue;
+			measured[vertex] = true;
+
+			//Only the largest distance is needed, so stop once the vertex is known to be within the current error.
+			const mars::Vec4& position = vertices[vertex].position;
+			float distance = FLT_MAX;
+			for (uint32_t j = adjacencyOffsets[representative]; distance > error && j < adjacencyOffsets[representative + 1]; j++)
+			{
+				const uint32_t* ring = &result[adjacency[j] * 3];
+				for (size_t k = 0; distance > error && k < 3; k++)
+				{
+					for (uint32_t l = adjacencyOffsets[ring[k]]; distance > error && l < adjacencyOffsets[ring[k] + 1]; l++)
+					{
+						const uint32_t* triangle = &result[adjacency[l] * 3];
+						distance = std::min(distance, PointTriangleDistance(position, vertices[triangle[0]].position, vertices[triangle[1]].position, vertices[triangle[2]].position));
+					}
+				}
+			}
+			//The representative lost all of its triangles, so fall back to the quadric error.
+			if (distance == FLT_MAX)
+				distance = static_cast<float>(std::sqrt(quadrics[positionIDs[representative]].Error(vertices[representative].position)));
+			error = std::max(error, distance);
+		}
+		*resultError = error;
+	}
+	return result;
+}
+
+void MeshOptimiser::GenerateLevelsOfDetail(ModelLoader::MeshData& mesh, const Options& options)
+{
+	mesh.levelsOfDetail.clear();
+	if (mesh.indices.empty() || mesh.indices.size() % 3 != 0 || mesh.vertices.empty())
+		return;
+
+	mars::Vec3 min(FLT_MAX, FLT_MAX, FLT_MAX), max(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	for (const ModelLoader::Vertex& vertex : mesh.vertices)
+	{
+		min.x = std::min(min.x, vertex.position.x); min.y = std::min(min.y, vertex.position.y); min.z = std::min(min.z, vertex.position.z);
+		max.x = std::max(max.x, vertex.position.x); max.y = std::max(max.y, vertex.position.y); max.z = std::max(max.z, vertex.position.z);
+	}
+	const float maxError = options.levelOfDetailMaxError * std::max(std::max(max.x - min.x, max.y - min.y), max.z - min.z);
+
+	//Each level is simplified from the full mesh, so that its error is measured against it.
+	size_t previousIndexCount = mesh.indices.size();
+	for (uint32_t i = 0; i < options.levelOfDetailCount; i++)
+	{
+		const size_t targetIndexCount = static_cast<size_t>(float(previousIndexCount / 3) * options.levelOfDetailReduction) * 3;
+		if (targetIndexCount < 3)
+			break;
+
+		ModelLoader::LevelOfDetail levelOfDetail;
+		levelOfDetail.indices = Simplify(mesh.indices.data(), mesh.indices.size(), mesh.vertices.data(), mesh.vertices.size(), targetIndexCount, maxError, &levelOfDetail.error);
+
+		//Stop once a level is not meaningfully smaller than the last.
+		if (levelOfDetail.indices.empty() || float(levelOfDetail.indices.size()) > 0.9f * float(previousIndexCount))
+			break;
+
+		ReorderForVertexCache(levelOfDetail.indices.data(), levelOfDetail.indices.size(), mesh.vertices.size());
+		previousIndexCount = levelOfDetail.indices.size();
+		mesh.levelsOfDetail.push_back(std::move(levelOfDetail));
+	}
+}
+
+MeshOptimiser::Statistics MeshOptimiser::AnalyseVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize)
+{
+	Statistics statistics;
+	statistics.vertexCount = static_cast<uint32_t>(vertexCount);
+	statistics.triangleCount = static_cast<uint32_t>(indexCount / 3);
+
+	std::vector<uint32_t> cacheTimestamps(vertexCount, 0);
+	std::vector<bool> used(vertexCount, false);
+	uint32_t timestamp = cacheSize + 1;
+	size_t misses = 0;
+	size_t usedVertexCount = 0;
+	for (size_t i = 0; i < indexCount; i++)
+	{
+		const uint32_t vertex = indices[i];
+		if (timestamp - cacheTimestamps[vertex] > cacheSize)
+		{
+			cacheTimestamps[vertex] = timestamp++;
+			misses++;
+		}
+		if (!used[vertex])
+		{
+			used[vertex] = true;
+			usedVertexCount++;
+		}
+	}
+
+	statistics.acmr = statistics.triangleCount ? float(misses) / float(statistics.triangleCount) : 0.0f;
+	statistics.atvr = usedVertexCount ? float(misses) / float(usedVertexCount) : 0.0f;
+	return statistics;
+}
+
+void MeshOptimiser::RemapVertices(ModelLoader::MeshData& mesh, const std::vector<uint32_t>& remap, size_t newVertexCount)
+{
+	std::vector<ModelLoader::Vertex> vertices(newVertexCount);
+	std::vector<bool> written(newVertexCount, false);
+	std::vector<bool> kept(mesh.vertices.size(), false);
+	for (size_t i = 0; i < mesh.vertices.size(); i++)
+	{
+		const uint32_t newIndex = remap[i];
+		if (newIndex != UINT32_MAX && !written[newIndex])
+		{
+			vertices[newIndex] = mesh.vertices[i];
+			written[newIndex] = true;
+			kept[i] = true;
+		}
+	}
+	mesh.vertices = std::move(vertices);
+
+	for (uint32_t& index : mesh.indices)
+		index = remap[index];
+
+	//The weights of removed vertices are dropped. Those of welded vertices are identical to the kept vertex's.
+	for (auto& bone : mesh.bones)
+	{
+		std::vector<std::pair<uint32_t, float>> vertexIDsAndWeights;
+		vertexIDsAndWeights.reserve(bone.vertexIDsAndWeights.size());
+		for (const auto& vertexIDAndWeight : bone.vertexIDsAndWeights)
+		{
+			if (vertexIDAndWeight.first < kept.size() && kept[vertexIDAndWeight.first])
+				vertexIDsAndWeights.push_back({ remap[vertexIDAndWeight.first], vertexIDAndWeight.second });
+		}
+		bone.vertexIDsAndWeights = std::move(vertexIDsAndWeights);
+	}
+}
\ No newline at end of file
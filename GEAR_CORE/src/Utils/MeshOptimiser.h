@@ -0,0 +1,83 @@
+#pragma once
+
+#include "gear_core_common.h"
+#include "Utils/ModelLoader.h"
+
+namespace gear
+{
+	//Optimises the indexed triangle lists of imported meshes for the GPU. The passes, in the order Optimise() runs them:
+	//DeduplicateVertices welds identical vertices, ReorderForVertexCache orders the triangles for the post-transform
+	//vertex cache, ReorderForOverdraw sorts clusters of those triangles so that outward facing clusters are drawn first,
+	//or MeshletBuilder::Build splits them into meshlets instead, and ReorderForVertexFetch renumbers the vertices in the
+	//order that they are first used. Finally, GenerateLevelsOfDetail builds a chain of simplified index lists into the
+	//same vertices.
+	//Bone weights are remapped along with the vertices. Everything runs on the CPU.
+	class MeshOptimiser
+	{
+	public:
+		struct Options
+		{
+			bool		deduplicateVertices = true;
+			bool		reorderForVertexCache = true;
+			bool		reorderForOverdraw = true;
+			bool		buildMeshlets = false;		//Replaces the overdraw pass, whose order the meshlets would not keep.
+			bool		reorderForVertexFetch = true;
+			float		overdrawThreshold = 1.05f;	//Allowed increase of the ACMR, from splitting the triangles into clusters for sorting.
+			uint32_t	cacheSize = 16;				//Size of the FIFO cache used to measure the ACMR and ATVR, and to find cluster boundaries.
+			uint32_t	levelOfDetailCount = 4;		//Simplified levels after the full mesh. 0 disables the chain.
+			float		levelOfDetailReduction = 0.5f;	//Target triangle count of each level, relative to the previous level.
+			float		levelOfDetailMaxError = 0.05f;	//Limit of the quadric error of each collapse, relative to the largest extent of the mesh.
+		};
+
+		//ACMR: Average cache miss ratio, the vertices transformed per triangle. 0.5 is the ideal for a large regular grid, 3 the worst.
+		//ATVR: Average transformed vertex ratio, the vertices transformed per unique vertex used. 1 is the ideal.
+		struct Statistics
+		{
+			uint32_t	vertexCount;
+			uint32_t	triangleCount;
+			float		acmr;
+			float		atvr;
+		};
+		struct Result
+		{
+			Statistics	before;
+			Statistics	after;
+		};
+
+	public:
+		//Meshes whose index count is not a multiple of 3 are left unchanged. The statistics after are of the final order.
+		static Result Optimise(ModelLoader::MeshData& mesh, const Options& options);
+
+		//Returns the number of vertices removed. Vertices are only welded if their bone weights are also identical.
+		static size_t DeduplicateVertices(ModelLoader::MeshData& mesh);
+		//Greedily emits the triangle whose vertices score highest, by their position in a simulated LRU cache and
+		//the number of triangles left to use them. Linear in the number of triangles.
+		static void ReorderForVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount);
+		//The indices should be ordered for the vertex cache first. They are split into clusters where the vertex cache
+		//restarts, and where the ACMR of a cluster is within the threshold of that of its run of triangles.
+		static void ReorderForOverdraw(uint32_t* indices, size_t indexCount, const ModelLoader::Vertex* vertices, size_t vertexCount, float threshold, uint32_t cacheSize);
+		//Unused vertices are removed.
+		static void ReorderForVertexFetch(ModelLoader::MeshData& mesh);
+
+		//Quadric error edge collapse. Returns at least targetIndexCount indices into the same vertices, unless reaching the
+		//target would exceed targetError. Vertices only move onto a neighbouring vertex. Vertices that share their position
+		//with another vertex, such as those on UV and normal seams, do not move, and vertices on open borders only move along
+		//the border. Collapses that would flip a triangle are rejected. targetError limits the square root of the quadric
+		//error of each collapse. resultError is set to the object space error of the result: the largest distance from an
+		//input vertex to the triangles around the vertex it was collapsed onto, which bounds its distance from the result.
+		//It is only measured at the input vertices. Points inside the input triangles, and points of the result far from
+		//any input vertex, can be further apart, so it is a lower bound of the Hausdorff distance between the surfaces.
+		static std::vector<uint32_t> Simplify(const uint32_t* indices, size_t indexCount, const ModelLoader::Vertex* vertices, size_t vertexCount,
+			size_t targetIndexCount, float targetError, float* resultError);
+		//Replaces mesh.levelsOfDetail with levels simplified from the full mesh, each reordered for the vertex cache.
+		//The chain ends early once a level can no longer be reduced within the error limit.
+		static void GenerateLevelsOfDetail(ModelLoader::MeshData& mesh, const Options& options);
+
+		static Statistics AnalyseVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize);
+
+	private:
+		//remap gives the new index of each vertex, or UINT32_MAX for vertices to remove.
+		//Vertices with the same new index must be identical, and the first of them is kept.
+		static void RemapVertices(ModelLoader::MeshData& mesh, const std::vector<uint32_t>& remap, size_t newVertexCount);
+	};
+}
\ No newline at end of file
@@ -0,0 +1,216 @@
+#include "gear_core_common.h"
+#include "MeshletBuilder.h"
+
+#include <cfloat>
+
+using namespace gear;
+
+static void TriangleNormal(const mars::Vec4& a, const mars::Vec4& b, const mars::Vec4& c, float normal[3])
+{
+	const float e1[3] = { b.x - a.x, b.y - a.y, b.z - a.z };
+	const float e2[3] = { c.x - a.x, c.y - a.y, c.z - a.z };
+	normal[0] = e1[1] * e2[2] - e1[2] * e2[1];
+	normal[1] = e1[2] * e2[0] - e1[0] * e2[2];
+	normal[2] = e1[0] * e2[1] - e1[1] * e2[0];
+	const float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+	for (size_t i = 0; i < 3; i++)
+		normal[i] = length > 0.0f ? normal[i] / length : 0.0f;
+}
+
+void MeshletBuilder::Build(ModelLoader::MeshData& mesh)
+{
+	mesh.meshlets.clear();
+	const size_t indexCount = mesh.indices.size();
+	const size_t vertexCount = mesh.vertices.size();
+	if (indexCount == 0 || indexCount % 3 != 0)
+		return;
+
+	const uint32_t* indices = mesh.indices.data();
+	const size_t triangleCount = indexCount / 3;
+
+	std::vector<float> normals(triangleCount * 3);
+	for (size_t i = 0; i < triangleCount; i++)
+		TriangleNormal(mesh.vertices[indices[i * 3 + 0]].position, mesh.vertices[indices[i * 3 + 1]].position, mesh.vertices[indices[i * 3 + 2]].position, &normals[i * 3]);
+
+	//The triangles around each vertex.
+	std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+	std::vector<uint32_t> adjacency(indexCount);
+	for (size_t i = 0; i < indexCount; i++)
+		adjacencyOffsets[indices[i] + 1]++;
+	for (size_t i = 0; i < vertexCount; i++)
+		adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+	{
+		std::vector<uint32_t> cursors(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (size_t i = 0; i < indexCount; i++)
+			adjacency[cursors[indices[i]]++] = static_cast<uint32_t>(i / 3);
+	}
+
+	std::vector<uint32_t> result;
+	result.reserve(indexCount);
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<uint32_t> meshletOfVertex(vertexCount, UINT32_MAX);	//The last meshlet that used each vertex.
+	std::vector<uint32_t> candidates;									//Triangles next to the current meshlet.
+	ModelLoader::Meshlet meshlet = {};
+	float meshletNormal[3] = { 0.0f, 0.0f, 0.0f };
+	size_t scan = 0;
+
+	auto NewVertexCount = [&](uint32_t triangle) -> uint32_t
+	{
+		const uint32_t meshletIndex = static_cast<uint32_t>(mesh.meshlets.size());
+		uint32_t count = 0;
+		for (size_t j = 0; j < 3; j++)
+			count += meshletOfVertex[indices[triangle * 3 + j]] != meshletIndex ? 1 : 0;
+		return count;
+	};
+	auto Emit = [&](uint32_t triangle)
+	{
+		const uint32_t meshletIndex = static_cast<uint32_t>(mesh.meshlets.size());
+		for (size_t j = 0; j < 3; j++)
+		{
+			const uint32_t vertex = indices[triangle * 3 + j];
+			result.push_back(vertex);
+			if (meshletOfVertex[vertex] == meshletIndex)
+				continue;
+
+			meshletOfVertex[vertex] = meshletIndex;
+			meshlet.vertexCount++;
+			for (uint32_t k = adjacencyOffsets[vertex]; k < adjacencyOffsets[vertex + 1]; k++)
+			{
+				if (!emitted[adjacency[k]])
+					candidates.push_back(adjacency[k]);
+			}
+		}
+		emitted[triangle] = true;
+		meshlet.indexCount += 3;
+		for (size_t j = 0; j < 3; j++)
+			meshletNormal[j] += normals[triangle * 3 + j];
+	};
+	auto Finish = [&]()
+	{
+		mesh.meshlets.push_back(meshlet);
+		meshlet = {};
+		meshlet.firstIndex = static_cast<uint32_t>(result.size());
+		meshletNormal[0] = meshletNormal[1] = meshletNormal[2] = 0.0f;
+		candidates.clear();
+	};
+
+	while (result.size() < indexCount)
+	{
+		//The neighbour that adds the fewest vertices, and then faces closest to the meshlet's mean normal.
+		uint32_t best = UINT32_MAX;
+		float bestScore = FLT_MAX;
+		const float normalLength = std::sqrt(meshletNormal[0] * meshletNormal[0] + meshletNormal[1] * meshletNormal[1] + meshletNormal[2] * meshletNormal[2]);
+		for (size_t i = 0; i < candidates.size();)
+		{
+			const uint32_t triangle = candidates[i];
+			if (emitted[triangle])
+			{
+				candidates[i] = candidates.back();
+				candidates.pop_back();
+				continue;
+			}
+			i++;
+
+			const uint32_t newVertexCount = NewVertexCount(triangle);
+			if (meshlet.vertexCount + newVertexCount > MaxVertices)
+				continue;
+
+			const float* normal = &normals[triangle * 3];
+			const float facing = normalLength > 0.0f ? (normal[0] * meshletNormal[0] + normal[1] * meshletNormal[1] + normal[2] * meshletNormal[2]) / normalLength : 1.0f;
+			const float score = float(newVertexCount) + (1.0f - facing);
+			if (score < bestScore)
+			{
+				best = triangle;
+				bestScore = score;
+			}
+		}
+
+		if (best == UINT32_MAX)
+		{
+			//The neighbours would exceed the vertex limit, or the meshlet has no neighbours left. A meshlet without
+			//neighbours continues from the next triangle in the input order, unless it is already a reasonable size.
+			if (!candidates.empty() || meshlet.indexCount >= MaxTriangles * 3 / 4)
+			{
+				Finish();
+				continue;
+			}
+			while (emitted[scan])
+				scan++;
+			best = static_cast<uint32_t>(scan);
+			if (meshlet.vertexCount + NewVertexCount(best) > MaxVertices)
+			{
+				Finish();
+				continue;
+			}
+		}
+
+		Emit(best);
+		if (meshlet.indexCount == MaxTriangles * 3)
+			Finish();
+	}
+	if (meshlet.indexCount > 0)
+		mesh.meshlets.push_back(meshlet);
+
+	mesh.indices = std::move(result);
+	for (ModelLoader::Meshlet& m : mesh.meshlets)
+		CalculateBounds(m, mesh.indices.data(), mesh.vertices.data());
+}
+
+void MeshletBuilder::CalculateBounds(ModelLoader::Meshlet& meshlet, const uint32_t* indices, const ModelLoader::Vertex* vertices)
+{
+	const uint32_t* begin = indices + meshlet.firstIndex;
+	const uint32_t* end = begin + meshlet.indexCount;
+	if (begin == end)
+	{
+		meshlet.boundingSphere = mars::Vec4(0.0f, 0.0f, 0.0f, 0.0f);
+		meshlet.cone = mars::Vec4(0.0f, 0.0f, 1.0f, 1.0f);
+		return;
+	}
+
+	float min[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+	float max[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	for (const uint32_t* index = begin; index < end; index++)
+	{
+		const mars::Vec4& position = vertices[*index].position;
+		min[0] = std::min(min[0], position.x); min[1] = std::min(min[1], position.y); min[2] = std::min(min[2], position.z);
+		max[0] = std::max(max[0], position.x); max[1] = std::max(max[1], position.y); max[2] = std::max(max[2], position.z);
+	}
+	const float centre[3] = { (min[0] + max[0]) * 0.5f, (min[1] + max[1]) * 0.5f, (min[2] + max[2]) * 0.5f };
+	float radiusSquared = 0.0f;
+	for (const uint32_t* index = begin; index < end; index++)
+	{
+		const mars::Vec4& position = vertices[*index].position;
+		const float d[3] = { position.x - centre[0], position.y - centre[1], position.z - centre[2] };
+		radiusSquared = std::max(radiusSquared, d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+	}
+	meshlet.boundingSphere = mars::Vec4(centre[0], centre[1], centre[2], std::sqrt(radiusSquared));
+
+	//The axis is the mean of the unit normals. The cone contains every normal, and the cutoff is the sine of its
+	//half angle: the meshlet is back facing when the view direction is within 90 degrees minus that angle of the axis.
+	float axis[3] = { 0.0f, 0.0f, 0.0f };
+	std::vector<float> normals;
+	normals.reserve(meshlet.indexCount);
+	for (const uint32_t* index = begin; index < end; index += 3)
+	{
+		float normal[3];
+		TriangleNormal(vertices[index[0]].position, vertices[index[1]].position, vertices[index[2]].position, normal);
+		if (normal[0] == 0.0f && normal[1] == 0.0f && normal[2] == 0.0f)
+			continue;
+		normals.insert(normals.end(), normal, normal + 3);
+		axis[0] += normal[0]; axis[1] += normal[1]; axis[2] += normal[2];
+	}
+	const float axisLength = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+	if (axisLength == 0.0f)
+	{
+		meshlet.cone = mars::Vec4(0.0f, 0.0f, 1.0f, 1.0f);
+		return;
+	}
+	axis[0] /= axisLength; axis[1] /= axisLength; axis[2] /= axisLength;
+
+	float minDot = 1.0f;
+	for (size_t i = 0; i < normals.size(); i += 3)
+		minDot = std::min(minDot, normals[i + 0] * axis[0] + normals[i + 1] * axis[1] + normals[i + 2] * axis[2]);
+
+	const float cutoff = minDot <= 0.1f ? 1.0f : std::sqrt(1.0f - minDot * minDot);
+	meshlet.cone = mars::Vec4(axis[0], axis[1], axis[2], cutoff);
+}
\ No newline at end of file
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "gear_core_common.h"
+#include "Utils/ModelLoader.h"
+
+namespace gear
+{
+	//Splits the triangles of a mesh into meshlets, small clusters that can be culled individually by their bounding
+	//sphere and normal cone. The triangles are reordered in place so that each meshlet is a contiguous range of the
+	//index buffer, which can be drawn with one indexed draw. Everything runs on the CPU.
+	class MeshletBuilder
+	{
+	public:
+		static constexpr uint32_t MaxVertices = 64;
+		static constexpr uint32_t MaxTriangles = 124;
+
+	public:
+		//Replaces mesh.meshlets. Meshlets are grown from the triangles in their current order, preferring neighbouring
+		//triangles that add the fewest vertices and face the same way, so the input should be ordered for the vertex cache.
+		//Meshes whose index count is not a multiple of 3 are left unchanged.
+		static void Build(ModelLoader::MeshData& mesh);
+
+		//Sets the bounding sphere and normal cone of the meshlet from its range of indices. The sphere is centred on the
+		//bounding box of the vertices. Cones wider than about 84 degrees from their axis are given a cutoff of 1.
+		static void CalculateBounds(ModelLoader::Meshlet& meshlet, const uint32_t* indices, const ModelLoader::Vertex* vertices);
+	};
+}
\ No newline at end of file
@@ -2,16 +2,62 @@
 #include "gear_core_common.h"
 #include "ModelLoader.h"
 #include "Objects/Material.h"
+#include "Graphics/TextureCache.h"
+#include "Graphics/ImageDecoder.h"
 #include "Objects/Transform.h"
 #include "Animation/Animation.h"
+#include "Utils/AssetDatabase.h"
+#include "Utils/MemoryMappedFile.h"
+#include "Utils/MeshOptimiser.h"
 #include "ARC/src/FileSystemHelpers.h"
 
+#include <filesystem>
+#include <unordered_map>
+
 using namespace gear;
 using namespace animation;
 
 void* ModelLoader::m_Device = nullptr;
+bool ModelLoader::m_OptimiseMeshes = true;
+uint32_t ModelLoader::m_ImportWorkerCount = 0;
+Ref<core::ThreadPool> ModelLoader::m_ImportThreadPool = nullptr;
+std::mutex ModelLoader::m_ImportThreadPoolMutex;
+
+//Filled by BuildNodeGraph before any mesh is converted, so that each node finds its mesh and node animation by name.
+struct ModelLoader::NodeGraphContext
+{
+	std::vector<std::pair<const aiNode*, const aiMesh*>>		meshes;					//In the order of ModelData::meshes.
+	std::unordered_map<std::string, size_t>						meshIndices;			//The last mesh of each node name.
+	std::unordered_map<std::string, std::pair<size_t, size_t>>	nodeAnimationIndices;	//The last animation and node animation of each node name.
+};
 
 ModelLoader::ModelData ModelLoader::LoadModelData(const std::string& filepath)
+{
+	ModelData modelData;
+	if (IsCookedModelFile(filepath))
+	{
+		modelData = LoadCookedModel(filepath);
+	}
+	else if (AssetDatabase::GetAssetDatabase())
+	{
+		//The asset database cooks the model if its content or the import settings have changed, and this waits for it.
+		const std::string cookedFilepath = AssetDatabase::GetAssetDatabase()->GetModel(filepath, true);
+		if (!cookedFilepath.empty())
+			modelData = LoadCookedModel(cookedFilepath);
+
+		if (modelData.meshes.empty())
+			modelData = ImportModelData(filepath);
+	}
+	else
+	{
+		modelData = ImportModelData(filepath);
+	}
+
+	CreateMaterials(modelData);
+	return modelData;
+}
+
+ModelLoader::ModelData ModelLoader::ImportModelData(const std::string& filepath)
 {
 	bool calculateTangentsAndBiNormals = true;
 	bool flipUVs = true;
@@ -34,212 +80,1019 @@ ModelLoader::ModelData ModelLoader::LoadModelData(const std::string& filepath)
 	scene->mMetaData->Get("UnitScaleFactor", scale);
 
 	ModelData modelData;
-	BuildNodeGraph(scene, scene->mRootNode, modelData.nodeGraph, modelData);
+	modelData.animations = ProcessAnimations(scene);
+
+	NodeGraphContext context;
+	for (size_t i = 0; i < modelData.animations.size(); i++)
+	{
+		const auto& nodeAnimations = modelData.animations[i].nodeAnimations;
+		for (size_t j = 0; j < nodeAnimations.size(); j++)
+			context.nodeAnimationIndices[nodeAnimations[j].name] = { i, j };
+	}
+	BuildNodeGraph(scene, scene->mRootNode, modelData.nodeGraph, context);
+
+	//The meshes only read the scene, and each writes its own MeshData.
+	modelData.meshes.resize(context.meshes.size());
+	auto ProcessMeshRange = [&](size_t begin, size_t end, uint32_t)
+	{
+		for (size_t i = begin; i < end; i++)
+			modelData.meshes[i] = ProcessMesh(context.meshes[i].first, context.meshes[i].second, scene);
+	};
+
+	Ref<core::ThreadPool> threadPool;
+	if (m_ImportWorkerCount != 1 && context.meshes.size() > 1)
+	{
+		std::unique_lock<std::mutex> lock(m_ImportThreadPoolMutex);
+		if (!m_ImportThreadPool)
+		{
+			core::ThreadPool::CreateInfo threadPoolCI;
+			threadPoolCI.debugName = "GEAR_CORE_ThreadPool_ModelLoader";
+			threadPoolCI.workerCount = m_ImportWorkerCount;
+			m_ImportThreadPool = CreateRef<core::ThreadPool>(&threadPoolCI);
+		}
+		threadPool = m_ImportThreadPool;
+	}
+	if (threadPool)
+		threadPool->ParallelFor(context.meshes.size(), ProcessMeshRange);
+	else
+		ProcessMeshRange(0, context.meshes.size(), 0);
 
 	return std::move(modelData);
 }
 
-void ModelLoader::BuildNodeGraph(const aiScene* scene, aiNode* node, Node& thisNode, ModelData& modelData)
+ModelLoader::ModelData ModelLoader::LoadCookedModel(const std::string& filepath)
 {
-	if (scene && node && modelData.animations.empty())
+	file_utils::MemoryMappedFile file(filepath);
+	if (!file.IsMapped())
+		return ModelData();
+
+	const uint8_t* data = file.GetData();
+	const size_t size = file.GetSize();
+
+	const CookedHeader& header = *reinterpret_cast<const CookedHeader*>(data);
+	bool valid = size >= sizeof(CookedHeader) && header.magic == GEAR_MODEL_COOKED_MAGIC && header.version == GEAR_MODEL_COOKED_VERSION
+		&& header.vertexSize == sizeof(Vertex) && header.indexSize == sizeof(uint32_t) && header.size == size;
+
+	//Every section must lie within the file.
+	const size_t recordSizes[] = { sizeof(Vertex), sizeof(uint32_t), sizeof(CookedMesh), sizeof(CookedLevelOfDetail), sizeof(Meshlet), sizeof(CookedMaterial), sizeof(CookedMaterialTexture),
+		sizeof(CookedBone), sizeof(CookedBoneWeight), sizeof(CookedNode), sizeof(CookedAnimation), sizeof(CookedNodeAnimation), sizeof(CookedKeyframe), sizeof(char) };
+	static_assert(std::size(recordSizes) == static_cast<size_t>(CookedSection::COUNT), "A record size is missing.");
+	for (size_t i = 0; valid && i < static_cast<size_t>(CookedSection::COUNT); i++)
 	{
-		if (node == scene->mRootNode) //Only process animations at the root node.
-		{
-			modelData.animations = ProcessAnimations(scene);
-		}
+		const auto& section = header.sections[i];
+		valid = section.offset % 16 == 0 && section.offset <= size && section.count <= (size - section.offset) / recordSizes[i];
 	}
 
-	if (node)
+	auto Section = [&](CookedSection section) -> const uint8_t* { return data + header.sections[static_cast<size_t>(section)].offset; };
+	auto Count = [&](CookedSection section) -> uint64_t { return header.sections[static_cast<size_t>(section)].count; };
+	auto InRange = [](uint64_t first, uint64_t count, uint64_t total) -> bool { return first <= total && count <= total - first; };
+	auto IndicesInRange = [](const std::vector<uint32_t>& indices, uint64_t vertexCount) -> bool
 	{
-		thisNode.name = node->mName.C_Str();
-		Convert_aiMatrix4x4ToMat4(node->mTransformation, thisNode.transform);
+		return std::all_of(indices.begin(), indices.end(), [vertexCount](uint32_t index) { return index < vertexCount; });
+	};
 
-		if(node->mNumMeshes > 0)
+	const char* strings = valid ? reinterpret_cast<const char*>(Section(CookedSection::STRINGS)) : nullptr;
+	const uint64_t stringsSize = valid ? Count(CookedSection::STRINGS) : 0;
+	valid = valid && (stringsSize == 0 || strings[stringsSize - 1] == '\0');
+	auto String = [&](uint32_t offset) -> std::string { return offset < stringsSize ? std::string(strings + offset) : std::string(); };
+
+	if (!valid)
+	{
+		GEAR_WARN(ErrorCode::UTILS | ErrorCode::LOAD_FAILED, "%s is not valid.", filepath.c_str());
+		return ModelData();
+	}
+
+	const Vertex* vertices = reinterpret_cast<const Vertex*>(Section(CookedSection::VERTICES));
+	const uint32_t* indices = reinterpret_cast<const uint32_t*>(Section(CookedSection::INDICES));
+	const CookedMesh* meshes = reinterpret_cast<const CookedMesh*>(Section(CookedSection::MESHES));
+	const CookedLevelOfDetail* levelsOfDetail = reinterpret_cast<const CookedLevelOfDetail*>(Section(CookedSection::LEVELS_OF_DETAIL));
+	const Meshlet* meshlets = reinterpret_cast<const Meshlet*>(Section(CookedSection::MESHLETS));
+	const CookedMaterial* materials = reinterpret_cast<const CookedMaterial*>(Section(CookedSection::MATERIALS));
+	const CookedMaterialTexture* materialTextures = reinterpret_cast<const CookedMaterialTexture*>(Section(CookedSection::MATERIAL_TEXTURES));
+	const CookedBone* bones = reinterpret_cast<const CookedBone*>(Section(CookedSection::BONES));
+	const CookedBoneWeight* boneWeights = reinterpret_cast<const CookedBoneWeight*>(Section(CookedSection::BONE_WEIGHTS));
+	const CookedNode* nodes = reinterpret_cast<const CookedNode*>(Section(CookedSection::NODES));
+	const CookedAnimation* animations = reinterpret_cast<const CookedAnimation*>(Section(CookedSection::ANIMATIONS));
+	const CookedNodeAnimation* nodeAnimations = reinterpret_cast<const CookedNodeAnimation*>(Section(CookedSection::NODE_ANIMATIONS));
+	const CookedKeyframe* keyframes = reinterpret_cast<const CookedKeyframe*>(Section(CookedSection::KEYFRAMES));
+
+	ModelData modelData;
+
+	//Meshes: The vertex and index ranges are copied straight out of the mapped file.
+	modelData.meshes.resize(Count(CookedSection::MESHES));
+	for (size_t i = 0; valid && i < modelData.meshes.size(); i++)
+	{
+		const CookedMesh& cookedMesh = meshes[i];
+		MeshData& mesh = modelData.meshes[i];
+		valid = InRange(cookedMesh.firstVertex, cookedMesh.vertexCount, Count(CookedSection::VERTICES))
+			&& InRange(cookedMesh.firstIndex, cookedMesh.indexCount, Count(CookedSection::INDICES))
+			&& InRange(cookedMesh.firstBone, cookedMesh.boneCount, Count(CookedSection::BONES))
+			&& InRange(cookedMesh.firstLevelOfDetail, cookedMesh.levelOfDetailCount, Count(CookedSection::LEVELS_OF_DETAIL))
+			&& InRange(cookedMesh.firstMeshlet, cookedMesh.meshletCount, Count(CookedSection::MESHLETS))
+			&& (cookedMesh.materialIndex == ~0U || cookedMesh.materialIndex < Count(CookedSection::MATERIALS));
+		if (!valid)
+			break;
+
+		mesh.meshName = String(cookedMesh.meshName);
+		mesh.nodeName = String(cookedMesh.nodeName);
+		mesh.vertices.assign(vertices + cookedMesh.firstVertex, vertices + cookedMesh.firstVertex + cookedMesh.vertexCount);
+		mesh.indices.assign(indices + cookedMesh.firstIndex, indices + cookedMesh.firstIndex + cookedMesh.indexCount);
+		valid = IndicesInRange(mesh.indices, cookedMesh.vertexCount);
+		if (!valid)
+			break;
+		mesh.levelsOfDetail.resize(cookedMesh.levelOfDetailCount);
+		for (size_t j = 0; valid && j < mesh.levelsOfDetail.size(); j++)
 		{
-			for (auto& mesh : ProcessMeshes(node, scene))
-				modelData.meshes.push_back(mesh);
+			const CookedLevelOfDetail& cookedLevelOfDetail = levelsOfDetail[cookedMesh.firstLevelOfDetail + j];
+			valid = InRange(cookedLevelOfDetail.firstIndex, cookedLevelOfDetail.indexCount, Count(CookedSection::INDICES));
+			if (!valid)
+				break;
+
+			mesh.levelsOfDetail[j].indices.assign(indices + cookedLevelOfDetail.firstIndex, indices + cookedLevelOfDetail.firstIndex + cookedLevelOfDetail.indexCount);
+			mesh.levelsOfDetail[j].error = cookedLevelOfDetail.error;
+			valid = IndicesInRange(mesh.levelsOfDetail[j].indices, cookedMesh.vertexCount);
 		}
+		if (!valid)
+			break;
+		mesh.meshlets.assign(meshlets + cookedMesh.firstMeshlet, meshlets + cookedMesh.firstMeshlet + cookedMesh.meshletCount);
+		for (const Meshlet& meshlet : mesh.meshlets)
+			valid = valid && InRange(meshlet.firstIndex, meshlet.indexCount, mesh.indices.size());
+		if (!valid)
+			break;
+		mesh.boundingBoxMin = mars::Vec3(cookedMesh.boundingBoxMin[0], cookedMesh.boundingBoxMin[1], cookedMesh.boundingBoxMin[2]);
+		mesh.boundingBoxMax = mars::Vec3(cookedMesh.boundingBoxMax[0], cookedMesh.boundingBoxMax[1], cookedMesh.boundingBoxMax[2]);
+		mesh.boundingSphere = mars::Vec4(cookedMesh.boundingSphere[0], cookedMesh.boundingSphere[1], cookedMesh.boundingSphere[2], cookedMesh.boundingSphere[3]);
 
-		for (size_t i = 0; i < modelData.meshes.size(); i++)
+		mesh.bones.resize(cookedMesh.boneCount);
+		for (size_t j = 0; valid && j < mesh.bones.size(); j++)
 		{
-			const auto& mesh = modelData.meshes[i];
-			if (mesh.nodeName.compare(thisNode.name) == 0)
-				thisNode.meshIndex = i;
+			const CookedBone& cookedBone = bones[cookedMesh.firstBone + j];
+			valid = InRange(cookedBone.firstWeight, cookedBone.weightCount, Count(CookedSection::BONE_WEIGHTS));
+			if (!valid)
+				break;
+
+			Bone& bone = mesh.bones[j];
+			bone.name = String(cookedBone.name);
+			memcpy((void*)bone.transform.GetData(), cookedBone.transform, sizeof(cookedBone.transform));
+			bone.vertexIDsAndWeights.reserve(cookedBone.weightCount);
+			for (uint64_t k = cookedBone.firstWeight; k < cookedBone.firstWeight + cookedBone.weightCount; k++)
+				bone.vertexIDsAndWeights.push_back({ boneWeights[k].vertexID, boneWeights[k].weight });
 		}
-		for (size_t i = 0; i < modelData.animations.size(); i++)
+		if (valid)
+			PackBoneInfluences(mesh);
+
+		if (valid && cookedMesh.materialIndex != ~0U)
 		{
-			const auto& animation = modelData.animations[i];
-			for (size_t j = 0; j < animation.nodeAnimations.size(); j++)
+			const CookedMaterial& cookedMaterial = materials[cookedMesh.materialIndex];
+			valid = InRange(cookedMaterial.firstTexture, cookedMaterial.textureCount, Count(CookedSection::MATERIAL_TEXTURES));
+			if (!valid)
+				break;
+
+			MaterialData& material = mesh.material;
+			for (uint64_t j = cookedMaterial.firstTexture; j < cookedMaterial.firstTexture + cookedMaterial.textureCount; j++)
+				material.textureFilepaths.push_back({ static_cast<objects::Material::TextureType>(materialTextures[j].type), String(materialTextures[j].filepath) });
+
+			auto Colour = [](const float colour[4]) -> mars::Vec4 { return mars::Vec4(colour[0], colour[1], colour[2], colour[3]); };
+			material.properties = {
+				String(cookedMaterial.name),
+				cookedMaterial.twoSided,
+				cookedMaterial.shadingModel,
+				cookedMaterial.wireframe,
+				cookedMaterial.blendFunc,
+				cookedMaterial.opacity,
+				cookedMaterial.shininess,
+				cookedMaterial.reflectivity,
+				cookedMaterial.shininessStrength,
+				cookedMaterial.refractiveIndex,
+				Colour(cookedMaterial.colours[0]),
+				Colour(cookedMaterial.colours[1]),
+				Colour(cookedMaterial.colours[2]),
+				Colour(cookedMaterial.colours[3]),
+				Colour(cookedMaterial.colours[4]),
+				Colour(cookedMaterial.colours[5])
+			};
+		}
+	}
+
+	//Animations
+	modelData.animations.resize(valid ? Count(CookedSection::ANIMATIONS) : 0);
+	for (size_t i = 0; valid && i < modelData.animations.size(); i++)
+	{
+		const CookedAnimation& cookedAnimation = animations[i];
+		valid = InRange(cookedAnimation.firstNodeAnimation, cookedAnimation.nodeAnimationCount, Count(CookedSection::NODE_ANIMATIONS));
+		if (!valid)
+			break;
+
+		Animation& animation = modelData.animations[i];
+		animation.sequenceType = static_cast<core::Sequence::Type>(cookedAnimation.sequenceType);
+		animation.duration = cookedAnimation.duration;
+		animation.framesPerSecond = cookedAnimation.framesPerSecond;
+		animation.nodeAnimations.resize(cookedAnimation.nodeAnimationCount);
+		for (size_t j = 0; valid && j < animation.nodeAnimations.size(); j++)
+		{
+			const CookedNodeAnimation& cookedNodeAnimation = nodeAnimations[cookedAnimation.firstNodeAnimation + j];
+			valid = InRange(cookedNodeAnimation.firstKeyframe, cookedNodeAnimation.keyframeCount, Count(CookedSection::KEYFRAMES));
+			if (!valid)
+				break;
+
+			NodeAnimation& nodeAnimation = animation.nodeAnimations[j];
+			nodeAnimation.name = String(cookedNodeAnimation.name);
+			nodeAnimation.type = static_cast<NodeAnimation::Type>(cookedNodeAnimation.type);
+			nodeAnimation.keyframes.reserve(cookedNodeAnimation.keyframeCount);
+			for (uint64_t k = cookedNodeAnimation.firstKeyframe; k < cookedNodeAnimation.firstKeyframe + cookedNodeAnimation.keyframeCount; k++)
 			{
-				const auto& nodeAnimation = animation.nodeAnimations[i];
-				if (nodeAnimation.name.compare(thisNode.name) == 0)
-				{
-					thisNode.animationIndex = i;
-					thisNode.nodeAnimationIndex = j;
-				}
+				const CookedKeyframe& cookedKeyframe = keyframes[k];
+				objects::Transform transform;
+				transform.translation = mars::Vec3(cookedKeyframe.translation[0], cookedKeyframe.translation[1], cookedKeyframe.translation[2]);
+				transform.orientation = mars::Quat(cookedKeyframe.orientation[0], cookedKeyframe.orientation[1], cookedKeyframe.orientation[2], cookedKeyframe.orientation[3]);
+				transform.scale = mars::Vec3(cookedKeyframe.scale[0], cookedKeyframe.scale[1], cookedKeyframe.scale[2]);
+				nodeAnimation.keyframes.push_back({ cookedKeyframe.timepoint, transform });
 			}
 		}
+	}
 
-		//Index children
-		aiNode** children = node->mChildren;
-		const unsigned int& childrenCount = node->mNumChildren;
-		thisNode.children.resize((size_t)childrenCount);
-		for (size_t i = 0; i < static_cast<size_t>(childrenCount); i++)
+	//Node graph: Each node is followed by its children and their descendants.
+	uint64_t nodeIndex = 0;
+	const uint64_t nodeCount = Count(CookedSection::NODES);
+	std::function<bool(Node&)> BuildNode = [&](Node& node) -> bool
+	{
+		if (nodeIndex >= nodeCount)
+			return false;
+
+		//Node indices must refer to a loaded mesh, animation and node animation of that animation, or be ~0U for none.
+		const CookedNode& cookedNode = nodes[nodeIndex++];
+		if ((cookedNode.meshIndex != ~0U && cookedNode.meshIndex >= Count(CookedSection::MESHES))
+			|| (cookedNode.animationIndex != ~0U && cookedNode.animationIndex >= Count(CookedSection::ANIMATIONS))
+			|| (cookedNode.nodeAnimationIndex != ~0U && (cookedNode.animationIndex == ~0U || cookedNode.nodeAnimationIndex >= modelData.animations[cookedNode.animationIndex].nodeAnimations.size())))
+			return false;
+
+		auto Index = [](uint32_t index) -> size_t { return index == ~0U ? ~size_t(0) : static_cast<size_t>(index); };
+		node.name = String(cookedNode.name);
+		memcpy((void*)node.transform.GetData(), cookedNode.transform, sizeof(cookedNode.transform));
+		node.meshIndex = Index(cookedNode.meshIndex);
+		node.animationIndex = Index(cookedNode.animationIndex);
+		node.nodeAnimationIndex = Index(cookedNode.nodeAnimationIndex);
+		if (cookedNode.childCount > nodeCount - nodeIndex)
+			return false;
+
+		node.children.resize(cookedNode.childCount);
+		for (auto& child : node.children)
 		{
-			BuildNodeGraph(scene, children[i],  thisNode.children[i], modelData);
+			if (!BuildNode(child))
+				return false;
 		}
+		return true;
+	};
+	valid = valid && (nodeCount == 0 || BuildNode(modelData.nodeGraph));
+
+	if (!valid)
+	{
+		GEAR_WARN(ErrorCode::UTILS | ErrorCode::LOAD_FAILED, "%s is not valid.", filepath.c_str());
+		return ModelData();
 	}
+	return modelData;
 }
 
-std::vector<ModelLoader::MeshData> ModelLoader::ProcessMeshes(aiNode* node, const aiScene* scene)
+bool ModelLoader::WriteCookedModel(const std::string& filepath, const ModelData& modelData)
 {
-	std::vector<MeshData> meshes;
-	meshes.reserve(node->mNumMeshes);
+	//Strings are stored once.
+	std::string strings;
+	std::map<std::string, uint32_t> stringOffsets;
+	auto AddString = [&](const std::string& string) -> uint32_t
+	{
+		auto it = stringOffsets.find(string);
+		if (it != stringOffsets.end())
+			return it->second;
+
+		const uint32_t offset = static_cast<uint32_t>(strings.size());
+		strings.append(string.c_str(), string.size() + 1);
+		stringOffsets[string] = offset;
+		return offset;
+	};
+
+	std::vector<CookedMesh> meshes;
+	std::vector<CookedLevelOfDetail> levelsOfDetail;
+	std::vector<Meshlet> meshlets;
+	std::vector<CookedMaterial> materials;
+	std::vector<CookedMaterialTexture> materialTextures;
+	std::vector<CookedBone> bones;
+	std::vector<CookedBoneWeight> boneWeights;
+	std::vector<CookedNode> nodes;
+	std::vector<CookedAnimation> animations;
+	std::vector<CookedNodeAnimation> nodeAnimations;
+	std::vector<CookedKeyframe> keyframes;
 
-	for (unsigned int i = 0; i < node->mNumMeshes; i++)
+	//Meshes: Materials are stored once per name.
+	std::map<std::string, uint32_t> materialIndices;
+	uint64_t vertexCount = 0;
+	uint64_t indexCount = 0;
+	for (const MeshData& mesh : modelData.meshes)
 	{
-		aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
+		CookedMesh cookedMesh = {};
+		cookedMesh.meshName = AddString(mesh.meshName);
+		cookedMesh.nodeName = AddString(mesh.nodeName);
+		cookedMesh.firstVertex = vertexCount;
+		cookedMesh.vertexCount = mesh.vertices.size();
+		cookedMesh.firstIndex = indexCount;
+		cookedMesh.indexCount = mesh.indices.size();
+		memcpy(cookedMesh.boundingBoxMin, &mesh.boundingBoxMin.x, sizeof(cookedMesh.boundingBoxMin));
+		memcpy(cookedMesh.boundingBoxMax, &mesh.boundingBoxMax.x, sizeof(cookedMesh.boundingBoxMax));
+		memcpy(cookedMesh.boundingSphere, &mesh.boundingSphere.x, sizeof(cookedMesh.boundingSphere));
+		vertexCount += mesh.vertices.size();
+		indexCount += mesh.indices.size();
+
+		cookedMesh.firstLevelOfDetail = static_cast<uint32_t>(levelsOfDetail.size());
+		cookedMesh.levelOfDetailCount = static_cast<uint32_t>(mesh.levelsOfDetail.size());
+		for (const LevelOfDetail& levelOfDetail : mesh.levelsOfDetail)
+		{
+			levelsOfDetail.push_back({ indexCount, levelOfDetail.indices.size(), levelOfDetail.error, 0 });
+			indexCount += levelOfDetail.indices.size();
+		}
 
-		MeshData meshData;
-		meshData.meshName = std::string(mesh->mName.C_Str());
-		meshData.nodeName = std::string(node->mName.C_Str());
+		cookedMesh.firstMeshlet = static_cast<uint32_t>(meshlets.size());
+		cookedMesh.meshletCount = static_cast<uint32_t>(mesh.meshlets.size());
+		meshlets.insert(meshlets.end(), mesh.meshlets.begin(), mesh.meshlets.end());
 
-		//Vertices
-		meshData.vertices.reserve(mesh->mNumVertices);
-		for (unsigned int i = 0; i < mesh->mNumVertices; i++)
+		cookedMesh.firstBone = bones.size();
+		cookedMesh.boneCount = static_cast<uint32_t>(mesh.bones.size());
+		for (const Bone& bone : mesh.bones)
 		{
-			Vertex vertex = {};
-			if (mesh->HasPositions())
-			{
-				vertex.position = mars::Vec4(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z, 1.0f);
-			}
-			if (mesh->HasTextureCoords(0))
-			{
-				vertex.texCoord = mars::Vec2(mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y);
-			}
-			if (mesh->HasNormals())
-			{
-				vertex.normal = mars::Vec4(mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z, 0.0f);
-			}
-			if (mesh->HasTangentsAndBitangents())
-			{
-				vertex.tangent = mars::Vec4(mesh->mTangents[i].x, mesh->mTangents[i].y, mesh->mTangents[i].z, 0.0f);
-				vertex.binormal = mars::Vec4(mesh->mBitangents[i].x, mesh->mBitangents[i].y, mesh->mBitangents[i].z, 0.0f);
-			}
-			if (mesh->HasVertexColors(0))
+			CookedBone cookedBone = {};
+			cookedBone.name = AddString(bone.name);
+			memcpy(cookedBone.transform, bone.transform.GetData(), sizeof(cookedBone.transform));
+			cookedBone.firstWeight = boneWeights.size();
+			cookedBone.weightCount = bone.vertexIDsAndWeights.size();
+			for (const auto& vertexIDAndWeight : bone.vertexIDsAndWeights)
+				boneWeights.push_back({ vertexIDAndWeight.first, vertexIDAndWeight.second });
+			bones.push_back(cookedBone);
+		}
+
+		const objects::Material::Properties& properties = mesh.material.properties;
+		auto it = materialIndices.find(properties.name);
+		if (it != materialIndices.end())
+		{
+			cookedMesh.materialIndex = it->second;
+		}
+		else
+		{
+			CookedMaterial cookedMaterial;
+			cookedMaterial.name = AddString(properties.name);
+			cookedMaterial.firstTexture = static_cast<uint32_t>(materialTextures.size());
+			cookedMaterial.textureCount = static_cast<uint32_t>(mesh.material.textureFilepaths.size());
+			cookedMaterial.twoSided = properties.twoSided;
+			cookedMaterial.shadingModel = properties.shadingModel;
+			cookedMaterial.wireframe = properties.wireframe;
+			cookedMaterial.blendFunc = properties.blendFunc;
+			cookedMaterial.opacity = properties.opacity;
+			cookedMaterial.shininess = properties.shininess;
+			cookedMaterial.reflectivity = properties.reflectivity;
+			cookedMaterial.shininessStrength = properties.shininessStrength;
+			cookedMaterial.refractiveIndex = properties.refractiveIndex;
+			const mars::Vec4* colours[6] = { &properties.colourDiffuse, &properties.colourAmbient, &properties.colourSpecular,
+				&properties.colourEmissive, &properties.colourTransparent, &properties.colourReflective };
+			for (size_t i = 0; i < 6; i++)
+				memcpy(cookedMaterial.colours[i], &colours[i]->x, sizeof(cookedMaterial.colours[i]));
+			for (const auto& textureFilepath : mesh.material.textureFilepaths)
+				materialTextures.push_back({ static_cast<uint32_t>(textureFilepath.first), AddString(textureFilepath.second) });
+
+			cookedMesh.materialIndex = static_cast<uint32_t>(materials.size());
+			materialIndices[properties.name] = cookedMesh.materialIndex;
+			materials.push_back(cookedMaterial);
+		}
+		meshes.push_back(cookedMesh);
+	}
+
+	//Animations
+	for (const Animation& animation : modelData.animations)
+	{
+		CookedAnimation cookedAnimation;
+		cookedAnimation.sequenceType = static_cast<uint32_t>(animation.sequenceType);
+		cookedAnimation.framesPerSecond = animation.framesPerSecond;
+		cookedAnimation.duration = animation.duration;
+		cookedAnimation.firstNodeAnimation = nodeAnimations.size();
+		cookedAnimation.nodeAnimationCount = animation.nodeAnimations.size();
+		for (const NodeAnimation& nodeAnimation : animation.nodeAnimations)
+		{
+			CookedNodeAnimation cookedNodeAnimation;
+			cookedNodeAnimation.name = AddString(nodeAnimation.name);
+			cookedNodeAnimation.type = static_cast<uint32_t>(nodeAnimation.type);
+			cookedNodeAnimation.firstKeyframe = keyframes.size();
+			cookedNodeAnimation.keyframeCount = nodeAnimation.keyframes.size();
+			for (const NodeAnimation::Keyframe& keyframe : nodeAnimation.keyframes)
 			{
-				vertex.colour = mars::Vec4(mesh->mColors[0][i].r, mesh->mColors[0][i].g, mesh->mColors[0][i].b, mesh->mColors[0][i].a);
+				const objects::Transform& transform = keyframe.second;
+				CookedKeyframe cookedKeyframe;
+				cookedKeyframe.timepoint = keyframe.first;
+				memcpy(cookedKeyframe.translation, &transform.translation.x, sizeof(cookedKeyframe.translation));
+				cookedKeyframe.orientation[0] = transform.orientation.s;
+				cookedKeyframe.orientation[1] = transform.orientation.i;
+				cookedKeyframe.orientation[2] = transform.orientation.j;
+				cookedKeyframe.orientation[3] = transform.orientation.k;
+				memcpy(cookedKeyframe.scale, &transform.scale.x, sizeof(cookedKeyframe.scale));
+				keyframes.push_back(cookedKeyframe);
 			}
-			meshData.vertices.push_back(vertex);
+			nodeAnimations.push_back(cookedNodeAnimation);
 		}
+		animations.push_back(cookedAnimation);
+	}
+
+	//Node graph: Each node is followed by its children and their descendants.
+	std::function<void(const Node&)> AddNode = [&](const Node& node)
+	{
+		auto Index = [](size_t index) -> uint32_t { return index == ~size_t(0) ? ~0U : static_cast<uint32_t>(index); };
+		CookedNode cookedNode;
+		cookedNode.name = AddString(node.name);
+		cookedNode.childCount = static_cast<uint32_t>(node.children.size());
+		cookedNode.meshIndex = Index(node.meshIndex);
+		cookedNode.animationIndex = Index(node.animationIndex);
+		cookedNode.nodeAnimationIndex = Index(node.nodeAnimationIndex);
+		memcpy(cookedNode.transform, node.transform.GetData(), sizeof(cookedNode.transform));
+		nodes.push_back(cookedNode);
+		for (const Node& child : node.children)
+			AddNode(child);
+	};
+	AddNode(modelData.nodeGraph);
+
+	//Layout the sections after the header.
+	CookedHeader header = {};
+	header.magic = GEAR_MODEL_COOKED_MAGIC;
+	header.version = GEAR_MODEL_COOKED_VERSION;
+	header.vertexSize = sizeof(Vertex);
+	header.indexSize = sizeof(uint32_t);
+
+	auto Align = [](uint64_t offset) -> uint64_t { return (offset + 15) & ~uint64_t(15); };
+	uint64_t offset = Align(sizeof(CookedHeader));
+	auto SetSection = [&](CookedSection section, uint64_t count, size_t recordSize)
+	{
+		header.sections[static_cast<size_t>(section)].offset = offset;
+		header.sections[static_cast<size_t>(section)].count = count;
+		offset = Align(offset + count * recordSize);
+	};
+	SetSection(CookedSection::VERTICES, vertexCount, sizeof(Vertex));
+	SetSection(CookedSection::INDICES, indexCount, sizeof(uint32_t));
+	SetSection(CookedSection::MESHES, meshes.size(), sizeof(CookedMesh));
+	SetSection(CookedSection::LEVELS_OF_DETAIL, levelsOfDetail.size(), sizeof(CookedLevelOfDetail));
+	SetSection(CookedSection::MESHLETS, meshlets.size(), sizeof(Meshlet));
+	SetSection(CookedSection::MATERIALS, materials.size(), sizeof(CookedMaterial));
+	SetSection(CookedSection::MATERIAL_TEXTURES, materialTextures.size(), sizeof(CookedMaterialTexture));
+	SetSection(CookedSection::BONES, bones.size(), sizeof(CookedBone));
+	SetSection(CookedSection::BONE_WEIGHTS, boneWeights.size(), sizeof(CookedBoneWeight));
+	SetSection(CookedSection::NODES, nodes.size(), sizeof(CookedNode));
+	SetSection(CookedSection::ANIMATIONS, animations.size(), sizeof(CookedAnimation));
+	SetSection(CookedSection::NODE_ANIMATIONS, nodeAnimations.size(), sizeof(CookedNodeAnimation));
+	SetSection(CookedSection::KEYFRAMES, keyframes.size(), sizeof(CookedKeyframe));
+	SetSection(CookedSection::STRINGS, strings.size(), sizeof(char));
+	header.size = offset;
+
+	std::error_code error;
+	const std::filesystem::path directory = std::filesystem::path(filepath).parent_path();
+	if (!directory.empty())
+		std::filesystem::create_directories(directory, error);
+
+	std::ofstream stream(filepath, std::ios::binary);
+	if (!stream.is_open())
+	{
+		GEAR_WARN(ErrorCode::UTILS | ErrorCode::NO_FILE, "Unable to open %s.", filepath.c_str());
+		return false;
+	}
+
+	const char padding[16] = {};
+	auto Write = [&](const void* data, size_t size) { stream.write(reinterpret_cast<const char*>(data), size); };
+	auto Pad = [&]() { Write(padding, static_cast<size_t>(Align(stream.tellp()) - static_cast<uint64_t>(stream.tellp()))); };
+	Write(&header, sizeof(CookedHeader));
+	Pad();
+	for (const MeshData& mesh : modelData.meshes)
+		Write(mesh.vertices.data(), mesh.vertices.size() * sizeof(Vertex));
+	Pad();
+	for (const MeshData& mesh : modelData.meshes)
+	{
+		Write(mesh.indices.data(), mesh.indices.size() * sizeof(uint32_t));
+		for (const LevelOfDetail& levelOfDetail : mesh.levelsOfDetail)
+			Write(levelOfDetail.indices.data(), levelOfDetail.indices.size() * sizeof(uint32_t));
+	}
+	Pad();
+	Write(meshes.data(), meshes.size() * sizeof(CookedMesh)); Pad();
+	Write(levelsOfDetail.data(), levelsOfDetail.size() * sizeof(CookedLevelOfDetail)); Pad();
+	Write(meshlets.data(), meshlets.size() * sizeof(Meshlet)); Pad();
+	Write(materials.data(), materials.size() * sizeof(CookedMaterial)); Pad();
+	Write(materialTextures.data(), materialTextures.size() * sizeof(CookedMaterialTexture)); Pad();
+	Write(bones.data(), bones.size() * sizeof(CookedBone)); Pad();
+	Write(boneWeights.data(), boneWeights.size() * sizeof(CookedBoneWeight)); Pad();
+	Write(nodes.data(), nodes.size() * sizeof(CookedNode)); Pad();
+	Write(animations.data(), animations.size() * sizeof(CookedAnimation)); Pad();
+	Write(nodeAnimations.data(), nodeAnimations.size() * sizeof(CookedNodeAnimation)); Pad();
+	Write(keyframes.data(), keyframes.size() * sizeof(CookedKeyframe)); Pad();
+	Write(strings.data(), strings.size()); Pad();
+
+	const bool written = static_cast<bool>(stream);
+	stream.close();
+	if (!written)
+	{
+		GEAR_WARN(ErrorCode::UTILS | ErrorCode::FUNC_FAILED, "Unable to write %s.", filepath.c_str());
+		std::filesystem::remove(filepath, error);
+	}
+	return written;
+}
 
-		//Indices
-		meshData.indices.reserve(mesh->mNumFaces * 3);
-		for (unsigned int i = 0; i < mesh->mNumFaces; i++)
+void ModelLoader::SetImportWorkerCount(uint32_t importWorkerCount)
+{
+	//Imports in progress keep their reference to the old pool.
+	std::unique_lock<std::mutex> lock(m_ImportThreadPoolMutex);
+	if (m_ImportWorkerCount != importWorkerCount)
+		m_ImportThreadPool = nullptr;
+	m_ImportWorkerCount = importWorkerCount;
+}
+
+bool ModelLoader::IsCookedModelFile(const std::string& filepath)
+{
+	const std::string extension = GEAR_MODEL_COOKED_FILE_EXTENSION;
+	return filepath.size() > extension.size() && filepath.compare(filepath.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+void ModelLoader::CreateMaterials(ModelData& modelData)
+{
+	//The textures of every new material are gathered first, so that they are all loaded in parallel.
+	std::map<std::string, const MaterialData*> newMaterials;
+	for (const MeshData& mesh : modelData.meshes)
+	{
+		const std::string& name = mesh.material.properties.name;
+		if (!mesh.pMaterial && !objects::Material::FindMaterial(name))
+			newMaterials.insert({ name, &mesh.material });
+	}
+
+	std::vector<graphics::Texture::CreateInfo> texCIs;
+	for (const auto& newMaterial : newMaterials)
+	{
+		for (const auto& textureFilepath : newMaterial.second->textureFilepaths)
 		{
-			aiFace face = mesh->mFaces[i];
-			for (unsigned int j = 0; j < face.mNumIndices; j++)
-				meshData.indices.push_back(face.mIndices[j]);
+			graphics::Texture::CreateInfo texCI;
+			texCI.device = m_Device;
+			texCI.dataType = graphics::Texture::DataType::FILE;
+			texCI.file.filepaths = &textureFilepath.second;
+			texCI.file.count = 1;
+			texCI.file.flipVertically = false;
+			texCI.mipLevels = 1;
+			texCI.arrayLayers = 1;
+			texCI.type = miru::crossplatform::Image::Type::TYPE_2D;
+			texCI.format = miru::crossplatform::Image::Format::R8G8B8A8_UNORM;
+			texCI.samples = miru::crossplatform::Image::SampleCountBit::SAMPLE_COUNT_1_BIT;
+			texCI.usage = miru::crossplatform::Image::UsageBit(0);
+			texCI.generateMipMaps = false;
+			texCIs.push_back(texCI);
 		}
+	}
+	std::vector<graphics::Texture::CreateInfo*> pTexCIs;
+	for (auto& texCI : texCIs)
+		pTexCIs.push_back(&texCI);
+	std::vector<Ref<graphics::Texture>> loadedTextures = graphics::TextureCache::GetTextureCache(m_Device)->GetTextures(pTexCIs);
+
+	size_t textureIndex = 0;
+	for (const auto& newMaterial : newMaterials)
+	{
+		std::map<objects::Material::TextureType, Ref<graphics::Texture>> textures;
+		for (const auto& textureFilepath : newMaterial.second->textureFilepaths)
+			textures[textureFilepath.first] = loadedTextures[textureIndex++];
+
+		objects::Material::CreateInfo materialCI;
+		materialCI.debugName = newMaterial.first;
+		materialCI.device = m_Device;
+		materialCI.pbrTextures = textures;
+		Ref<objects::Material> material = CreateRef<objects::Material>(&materialCI);
+		material->AddProperties(newMaterial.second->properties);
+		material->Update();
+
+		objects::Material::AddMaterial(newMaterial.first, material);
+	}
+
+	for (MeshData& mesh : modelData.meshes)
+	{
+		if (!mesh.pMaterial)
+			mesh.pMaterial = objects::Material::FindMaterial(mesh.material.properties.name);
+	}
+}
+
+void ModelLoader::CalculateBounds(MeshData& mesh)
+{
+	if (mesh.vertices.empty())
+	{
+		mesh.boundingBoxMin = mars::Vec3(0.0f, 0.0f, 0.0f);
+		mesh.boundingBoxMax = mars::Vec3(0.0f, 0.0f, 0.0f);
+		mesh.boundingSphere = mars::Vec4(0.0f, 0.0f, 0.0f, 0.0f);
+		return;
+	}
+
+	//The sphere is centred on the axis aligned bounding box, which is tight enough for culling.
+	const mars::Vec4& firstPosition = mesh.vertices[0].position;
+	mars::Vec3 min(firstPosition.x, firstPosition.y, firstPosition.z);
+	mars::Vec3 max = min;
+	for (const Vertex& vertex : mesh.vertices)
+	{
+		min.x = std::min(min.x, vertex.position.x);
+		min.y = std::min(min.y, vertex.position.y);
+		min.z = std::min(min.z, vertex.position.z);
+		max.x = std::max(max.x, vertex.position.x);
+		max.y = std::max(max.y, vertex.position.y);
+		max.z = std::max(max.z, vertex.position.z);
+	}
+	mesh.boundingBoxMin = min;
+	mesh.boundingBoxMax = max;
+	const mars::Vec3 centre((min.x + max.x) * 0.5f, (min.y + max.y) * 0.5f, (min.z + max.z) * 0.5f);
+
+	float radiusSquared = 0.0f;
+	for (const Vertex& vertex : mesh.vertices)
+	{
+		const float dx = vertex.position.x - centre.x;
+		const float dy = vertex.position.y - centre.y;
+		const float dz = vertex.position.z - centre.z;
+		radiusSquared = std::max(radiusSquared, dx * dx + dy * dy + dz * dz);
+	}
+	mesh.boundingSphere = mars::Vec4(centre, std::sqrt(radiusSquared));
+}
+
+void ModelLoader::PackBoneInfluences(MeshData& mesh)
+{
+	mesh.boneInfluences.clear();
+	if (mesh.bones.empty())
+		return;
+
+	if (mesh.bones.size() > 256)
+	{
+		GEAR_WARN(ErrorCode::UTILS | ErrorCode::NOT_SUPPORTED, "%s has %zu bones. The weights of bones after the first 256 are dropped.", mesh.meshName.c_str(), mesh.bones.size());
+	}
 
-		//Bones
-		meshData.bones.reserve(mesh->mNumBones);
-		for (unsigned int i = 0; i < mesh->mNumBones; i++)
+	//The four largest weights of each vertex, in descending order. Earlier bones are kept on ties.
+	struct Influences
+	{
+		uint32_t	indices[4];
+		float		weights[4];
+	};
+	std::vector<Influences> influences(mesh.vertices.size(), Influences{ { 0, 0, 0, 0 }, { 0.0f, 0.0f, 0.0f, 0.0f } });
+	const uint32_t boneCount = static_cast<uint32_t>(std::min<size_t>(mesh.bones.size(), 256));
+	for (uint32_t i = 0; i < boneCount; i++)
+	{
+		for (const auto& vertexIDAndWeight : mesh.bones[i].vertexIDsAndWeights)
 		{
-			mars::Mat4 transform;
-			aiMatrix4x4 aiTransform = mesh->mBones[i]->mOffsetMatrix;
-			Convert_aiMatrix4x4ToMat4(aiTransform, transform);
+			const float weight = vertexIDAndWeight.second;
+			if (vertexIDAndWeight.first >= influences.size() || !(weight > influences[vertexIDAndWeight.first].weights[3]))
+				continue;
 
-			std::vector<std::pair<uint32_t, float>> vertexIDsAndWeights;
-			for (unsigned int j = 0; j < mesh->mBones[i]->mNumWeights; j++)
+			Influences& influence = influences[vertexIDAndWeight.first];
+			size_t slot = 3;
+			for (; slot > 0 && influence.weights[slot - 1] < weight; slot--)
 			{
-				const aiVertexWeight& weight = mesh->mBones[i]->mWeights[j];
-				vertexIDsAndWeights.push_back({ weight.mVertexId, weight.mWeight });
+				influence.indices[slot] = influence.indices[slot - 1];
+				influence.weights[slot] = influence.weights[slot - 1];
 			}
-			meshData.bones.push_back({});
-			meshData.bones.back().transform = std::move(transform);
-			meshData.bones.back().vertexIDsAndWeights = std::move(vertexIDsAndWeights);
+			influence.indices[slot] = i;
+			influence.weights[slot] = weight;
 		}
+	}
 
-		//Materials
-		aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
-		aiString materialName;
-		material->Get(AI_MATKEY_NAME, materialName);
+	//The weights are renormalised, and the rounding error is given to the largest, so that they sum to exactly 1.
+	mesh.boneInfluences.resize(influences.size());
+	for (size_t i = 0; i < influences.size(); i++)
+	{
+		const Influences& influence = influences[i];
+		BoneInfluence& boneInfluence = mesh.boneInfluences[i];
+		const float total = influence.weights[0] + influence.weights[1] + influence.weights[2] + influence.weights[3];
+		int32_t sum = 0;
+		for (size_t j = 0; j < 4; j++)
+		{
+			const int32_t weight = total > 0.0f ? static_cast<int32_t>(influence.weights[j] / total * 65535.0f + 0.5f) : 0;
+			boneInfluence.indices[j] = weight ? static_cast<uint8_t>(influence.indices[j]) : 0;
+			boneInfluence.weights[j] = static_cast<uint16_t>(weight);
+			sum += weight;
+		}
+		if (!sum)
+			continue;
 
-		Ref<objects::Material> mat = objects::Material::FindMaterial(materialName.C_Str());
-		if (mat != nullptr)
+		//The correction can reorder weights that were equal.
+		boneInfluence.weights[0] = static_cast<uint16_t>(boneInfluence.weights[0] + 65535 - sum);
+		for (size_t j = 1; j < 4 && boneInfluence.weights[j] > boneInfluence.weights[j - 1]; j++)
 		{
-			meshData.pMaterial = mat;
+			std::swap(boneInfluence.weights[j], boneInfluence.weights[j - 1]);
+			std::swap(boneInfluence.indices[j], boneInfluence.indices[j - 1]);
 		}
-		else
+	}
+}
+
+//Tangent frames are stored as a quaternion whose sign marks a reflected binormal. w is kept at least one snorm16 step
+//from zero, so that its sign survives quantisation.
+static void EncodeTangentFrame(const mars::Vec4& normal, const mars::Vec4& tangent, const mars::Vec4& binormal, int16_t tangentFrame[4])
+{
+	auto Dot = [](const float a[3], const float b[3]) -> float { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; };
+	auto Normalise = [&](float v[3]) -> bool
+	{
+		const float length = std::sqrt(Dot(v, v));
+		if (length < 1e-12f)
+			return false;
+		v[0] /= length; v[1] /= length; v[2] /= length;
+		return true;
+	};
+	auto Cross = [](const float a[3], const float b[3], float c[3]) { c[0] = a[1] * b[2] - a[2] * b[1]; c[1] = a[2] * b[0] - a[0] * b[2]; c[2] = a[0] * b[1] - a[1] * b[0]; };
+
+	float n[3] = { normal.x, normal.y, normal.z };
+	if (!Normalise(n))
+	{
+		n[0] = 0.0f; n[1] = 0.0f; n[2] = 1.0f;
+	}
+
+	//Meshes without tangents get any tangent perpendicular to the normal.
+	float t[3] = { tangent.x, tangent.y, tangent.z };
+	const float nDotT = Dot(n, t);
+	t[0] -= n[0] * nDotT; t[1] -= n[1] * nDotT; t[2] -= n[2] * nDotT;
+	if (!Normalise(t))
+	{
+		const float axis[3] = { std::abs(n[0]) < 0.9f ? 1.0f : 0.0f, std::abs(n[0]) < 0.9f ? 0.0f : 1.0f, 0.0f };
+		Cross(n, axis, t);
+		Normalise(t);
+	}
+
+	//The columns tangent, binormal and normal form a rotation.
+	float b[3];
+	Cross(n, t, b);
+	const float originalBinormal[3] = { binormal.x, binormal.y, binormal.z };
+	const bool reflected = Dot(b, originalBinormal) < 0.0f;
+
+	const float m00 = t[0], m01 = b[0], m02 = n[0];
+	const float m10 = t[1], m11 = b[1], m12 = n[1];
+	const float m20 = t[2], m21 = b[2], m22 = n[2];
+	float q[4]; //xyzw
+	const float trace = m00 + m11 + m22;
+	if (trace > 0.0f)
+	{
+		const float s = std::sqrt(trace + 1.0f) * 2.0f;
+		q[0] = (m21 - m12) / s; q[1] = (m02 - m20) / s; q[2] = (m10 - m01) / s; q[3] = 0.25f * s;
+	}
+	else if (m00 > m11 && m00 > m22)
+	{
+		const float s = std::sqrt(1.0f + m00 - m11 - m22) * 2.0f;
+		q[0] = 0.25f * s; q[1] = (m01 + m10) / s; q[2] = (m02 + m20) / s; q[3] = (m21 - m12) / s;
+	}
+	else if (m11 > m22)
+	{
+		const float s = std::sqrt(1.0f + m11 - m00 - m22) * 2.0f;
+		q[0] = (m01 + m10) / s; q[1] = 0.25f * s; q[2] = (m12 + m21) / s; q[3] = (m02 - m20) / s;
+	}
+	else
+	{
+		const float s = std::sqrt(1.0f + m22 - m00 - m11) * 2.0f;
+		q[0] = (m02 + m20) / s; q[1] = (m12 + m21) / s; q[2] = 0.25f * s; q[3] = (m10 - m01) / s;
+	}
+
+	const float length = std::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+	const float sign = q[3] < 0.0f ? -1.0f : 1.0f;
+	for (float& component : q)
+		component *= sign / length;
+
+	constexpr float bias = 1.0f / 32767.0f;
+	if (q[3] < bias)
+	{
+		const float scale = std::sqrt(1.0f - bias * bias) / std::max(std::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2]), 1e-12f);
+		q[0] *= scale; q[1] *= scale; q[2] *= scale; q[3] = bias;
+	}
+
+	for (size_t i = 0; i < 4; i++)
+		tangentFrame[i] = static_cast<int16_t>(std::round(std::min(std::max(reflected ? -q[i] : q[i], -1.0f), 1.0f) * 32767.0f));
+}
+
+static void DecodeTangentFrame(const int16_t tangentFrame[4], mars::Vec4& normal, mars::Vec4& tangent, mars::Vec4& binormal)
+{
+	float q[4];
+	for (size_t i = 0; i < 4; i++)
+		q[i] = std::max(static_cast<float>(tangentFrame[i]) / 32767.0f, -1.0f);
+	const float length = std::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+	const float x = q[0] / length, y = q[1] / length, z = q[2] / length, w = q[3] / length;
+
+	const float reflection = w < 0.0f ? -1.0f : 1.0f;
+	tangent = mars::Vec4(1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y + w * z), 2.0f * (x * z - w * y), 0.0f);
+	binormal = mars::Vec4(2.0f * (x * y - w * z), 1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z + w * x), 0.0f) * reflection;
+	normal = mars::Vec4(2.0f * (x * z + w * y), 2.0f * (y * z - w * x), 1.0f - 2.0f * (x * x + y * y), 0.0f);
+}
+
+void ModelLoader::QuantiseVertices(const Vertex* vertices, size_t count, const mars::Vec3& boundingBoxMin, const mars::Vec3& boundingBoxMax, QuantisedVertex* quantisedVertices)
+{
+	//Texture coordinates are converted to halves four at a time.
+	std::vector<float> texCoords((count * 2 + 3) & ~size_t(3), 0.0f);
+	std::vector<uint16_t> halfTexCoords(texCoords.size());
+	for (size_t i = 0; i < count; i++)
+	{
+		texCoords[i * 2 + 0] = vertices[i].texCoord.x;
+		texCoords[i * 2 + 1] = vertices[i].texCoord.y;
+	}
+	graphics::ImageDecoder::ConvertRGBA32FToRGBA16F(texCoords.data(), halfTexCoords.data(), texCoords.size() / 4);
+
+	const float min[3] = { boundingBoxMin.x, boundingBoxMin.y, boundingBoxMin.z };
+	const float extent[3] = { boundingBoxMax.x - boundingBoxMin.x, boundingBoxMax.y - boundingBoxMin.y, boundingBoxMax.z - boundingBoxMin.z };
+	for (size_t i = 0; i < count; i++)
+	{
+		const Vertex& vertex = vertices[i];
+		QuantisedVertex& quantisedVertex = quantisedVertices[i];
+
+		const float position[3] = { vertex.position.x, vertex.position.y, vertex.position.z };
+		for (size_t j = 0; j < 3; j++)
 		{
-			std::map<objects::Material::TextureType, Ref<graphics::Texture>> textures;
-			for (unsigned int i = 0; i < AI_TEXTURE_TYPE_MAX; i++)
-			{
-				std::vector<std::string> filepaths = GetMaterialFilePath(material, (aiTextureType)i);
-				if (!filepaths.empty())
-				{
-					objects::Material::TextureType type;
-					for (auto& filepath : filepaths)
-					{
-						switch (i)
-						{
-						case aiTextureType::aiTextureType_BASE_COLOR:
-							type = objects::Material::TextureType::ALBEDO; break;
-						case aiTextureType::aiTextureType_NORMAL_CAMERA:
-							type = objects::Material::TextureType::NORMAL; break;
-						case aiTextureType::aiTextureType_EMISSION_COLOR:
-							type = objects::Material::TextureType::EMISSIVE; break;
-						case aiTextureType::aiTextureType_METALNESS:
-							type = objects::Material::TextureType::METALLIC; break;
-						case aiTextureType::aiTextureType_DIFFUSE_ROUGHNESS:
-							type = objects::Material::TextureType::ROUGHNESS; break;
-						case aiTextureType::aiTextureType_AMBIENT_OCCLUSION:
-							type = objects::Material::TextureType::AMBIENT_OCCLUSION; break;
-						case aiTextureType::aiTextureType_NORMALS:
-							type = objects::Material::TextureType::NORMAL; break;
-						default:
-							type = objects::Material::TextureType::UNKNOWN; break;
-						}
-
-						if (arc::FileExist(filepath))
-						{
-							graphics::Texture::CreateInfo texCI;
-							texCI.device = m_Device;
-							texCI.dataType = graphics::Texture::DataType::FILE;
-							texCI.file.filepaths = &filepath;
-							texCI.file.count = 1;
-							texCI.mipLevels = 1;
-							texCI.arrayLayers = 1;
-							texCI.type = miru::crossplatform::Image::Type::TYPE_2D;
-							texCI.format = miru::crossplatform::Image::Format::R8G8B8A8_UNORM;
-							texCI.samples = miru::crossplatform::Image::SampleCountBit::SAMPLE_COUNT_1_BIT;
-							texCI.usage = miru::crossplatform::Image::UsageBit(0);
-							texCI.generateMipMaps = false;
-							textures[type] = CreateRef<graphics::Texture>(&texCI);
-						}
-					}
-				}
-			}
+			const float unorm = extent[j] > 0.0f ? (position[j] - min[j]) / extent[j] : 0.0f;
+			quantisedVertex.position[j] = static_cast<uint16_t>(std::round(std::min(std::max(unorm, 0.0f), 1.0f) * 65535.0f));
+		}
+		quantisedVertex.position[3] = 0;
 
-			objects::Material::CreateInfo materialCI;
-			materialCI.debugName = materialName.C_Str();
-			materialCI.device = m_Device;
-			materialCI.pbrTextures = textures;
-			meshData.pMaterial = CreateRef<objects::Material>(&materialCI);
-			AddMaterialProperties(material, meshData.pMaterial);
+		EncodeTangentFrame(vertex.normal, vertex.tangent, vertex.binormal, quantisedVertex.tangentFrame);
 
-			objects::Material::AddMaterial(materialName.C_Str(), meshData.pMaterial);
+		quantisedVertex.texCoord[0] = halfTexCoords[i * 2 + 0];
+		quantisedVertex.texCoord[1] = halfTexCoords[i * 2 + 1];
+
+		const float colour[4] = { vertex.colour.x, vertex.colour.y, vertex.colour.z, vertex.colour.w };
+		for (size_t j = 0; j < 4; j++)
+			quantisedVertex.colour[j] = static_cast<uint8_t>(std::round(std::min(std::max(colour[j], 0.0f), 1.0f) * 255.0f));
+	}
+}
+
+void ModelLoader::DequantiseVertices(const QuantisedVertex* quantisedVertices, size_t count, const mars::Vec3& boundingBoxMin, const mars::Vec3& boundingBoxMax, Vertex* vertices)
+{
+	std::vector<uint16_t> halfTexCoords((count * 2 + 3) & ~size_t(3), 0);
+	std::vector<float> texCoords(halfTexCoords.size());
+	for (size_t i = 0; i < count; i++)
+	{
+		halfTexCoords[i * 2 + 0] = quantisedVertices[i].texCoord[0];
+		halfTexCoords[i * 2 + 1] = quantisedVertices[i].texCoord[1];
+	}
+	graphics::ImageDecoder::ConvertRGBA16FToRGBA32F(halfTexCoords.data(), texCoords.data(), halfTexCoords.size() / 4);
+
+	const mars::Vec3 scale = (boundingBoxMax - boundingBoxMin) / 65535.0f;
+	for (size_t i = 0; i < count; i++)
+	{
+		const QuantisedVertex& quantisedVertex = quantisedVertices[i];
+		Vertex& vertex = vertices[i];
+
+		vertex.position = mars::Vec4(
+			boundingBoxMin.x + scale.x * static_cast<float>(quantisedVertex.position[0]),
+			boundingBoxMin.y + scale.y * static_cast<float>(quantisedVertex.position[1]),
+			boundingBoxMin.z + scale.z * static_cast<float>(quantisedVertex.position[2]),
+			1.0f);
+		vertex.texCoord = mars::Vec2(texCoords[i * 2 + 0], texCoords[i * 2 + 1]);
+		DecodeTangentFrame(quantisedVertex.tangentFrame, vertex.normal, vertex.tangent, vertex.binormal);
+		vertex.colour = mars::Vec4(quantisedVertex.colour[0] / 255.0f, quantisedVertex.colour[1] / 255.0f, quantisedVertex.colour[2] / 255.0f, quantisedVertex.colour[3] / 255.0f);
+	}
+}
+
+void ModelLoader::BuildNodeGraph(const aiScene* scene, const aiNode* node, Node& thisNode, NodeGraphContext& context)
+{
+	if (node)
+	{
+		thisNode.name = node->mName.C_Str();
+		Convert_aiMatrix4x4ToMat4(node->mTransformation, thisNode.transform);
+
+		//The meshes are only gathered here, in the order they are stored in, and converted once the graph is built.
+		for (unsigned int i = 0; i < node->mNumMeshes; i++)
+		{
+			context.meshIndices[thisNode.name] = context.meshes.size();
+			context.meshes.push_back({ node, scene->mMeshes[node->mMeshes[i]] });
+		}
+
+		auto meshIndex = context.meshIndices.find(thisNode.name);
+		if (meshIndex != context.meshIndices.end())
+			thisNode.meshIndex = meshIndex->second;
+
+		auto nodeAnimationIndex = context.nodeAnimationIndices.find(thisNode.name);
+		if (nodeAnimationIndex != context.nodeAnimationIndices.end())
+		{
+			thisNode.animationIndex = nodeAnimationIndex->second.first;
+			thisNode.nodeAnimationIndex = nodeAnimationIndex->second.second;
+		}
+
+		//Index children
+		aiNode** children = node->mChildren;
+		const unsigned int& childrenCount = node->mNumChildren;
+		thisNode.children.resize((size_t)childrenCount);
+		for (size_t i = 0; i < static_cast<size_t>(childrenCount); i++)
+		{
+			BuildNodeGraph(scene, children[i],  thisNode.children[i], context);
+		}
+	}
+}
+
+ModelLoader::MeshData ModelLoader::ProcessMesh(const aiNode* node, const aiMesh* mesh, const aiScene* scene)
+{
+	MeshData meshData;
+	meshData.meshName = std::string(mesh->mName.C_Str());
+	meshData.nodeName = std::string(node->mName.C_Str());
+
+	//Vertices
+	meshData.vertices.reserve(mesh->mNumVertices);
+	for (unsigned int i = 0; i < mesh->mNumVertices; i++)
+	{
+		Vertex vertex = {};
+		if (mesh->HasPositions())
+		{
+			vertex.position = mars::Vec4(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z, 1.0f);
+		}
+		if (mesh->HasTextureCoords(0))
+		{
+			vertex.texCoord = mars::Vec2(mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y);
+		}
+		if (mesh->HasNormals())
+		{
+			vertex.normal = mars::Vec4(mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z, 0.0f);
+		}
+		if (mesh->HasTangentsAndBitangents())
+		{
+			vertex.tangent = mars::Vec4(mesh->mTangents[i].x, mesh->mTangents[i].y, mesh->mTangents[i].z, 0.0f);
+			vertex.binormal = mars::Vec4(mesh->mBitangents[i].x, mesh->mBitangents[i].y, mesh->mBitangents[i].z, 0.0f);
+		}
+		if (mesh->HasVertexColors(0))
+		{
+			vertex.colour = mars::Vec4(mesh->mColors[0][i].r, mesh->mColors[0][i].g, mesh->mColors[0][i].b, mesh->mColors[0][i].a);
+		}
+		meshData.vertices.push_back(vertex);
+	}
+
+	//Indices
+	meshData.indices.reserve(mesh->mNumFaces * 3);
+	for (unsigned int i = 0; i < mesh->mNumFaces; i++)
+	{
+		const aiFace& face = mesh->mFaces[i];
+		for (unsigned int j = 0; j < face.mNumIndices; j++)
+			meshData.indices.push_back(face.mIndices[j]);
+	}
+
+	//Bones
+	meshData.bones.reserve(mesh->mNumBones);
+	for (unsigned int i = 0; i < mesh->mNumBones; i++)
+	{
+		mars::Mat4 transform;
+		aiMatrix4x4 aiTransform = mesh->mBones[i]->mOffsetMatrix;
+		Convert_aiMatrix4x4ToMat4(aiTransform, transform);
+
+		std::vector<std::pair<uint32_t, float>> vertexIDsAndWeights;
+		for (unsigned int j = 0; j < mesh->mBones[i]->mNumWeights; j++)
+		{
+			const aiVertexWeight& weight = mesh->mBones[i]->mWeights[j];
+			vertexIDsAndWeights.push_back({ weight.mVertexId, weight.mWeight });
 		}
-		meshes.push_back(meshData);
+		meshData.bones.push_back({});
+		meshData.bones.back().name = std::string(mesh->mBones[i]->mName.C_Str());
+		meshData.bones.back().transform = std::move(transform);
+		meshData.bones.back().vertexIDsAndWeights = std::move(vertexIDsAndWeights);
+	}
+
+	//Materials
+	meshData.material = GetMaterialData(scene->mMaterials[mesh->mMaterialIndex]);
+
+	if (m_OptimiseMeshes)
+	{
+		MeshOptimiser::Options options;
+		options.buildMeshlets = true;
+		MeshOptimiser::Optimise(meshData, options);
 	}
-	return std::move(meshes);
+
+	PackBoneInfluences(meshData);
+	CalculateBounds(meshData);
+	return meshData;
 }
+
 std::vector<animation::Animation> ModelLoader::ProcessAnimations(const aiScene* scene)
 {
 	std::vector<animation::Animation> animations;
 	animations.reserve(scene->mNumAnimations);
 
+	auto AddTranslation = [](Animation& animation, const std::string& name, const aiNodeAnim* nodeAnim)
+	{
+		animation.nodeAnimations.push_back({ name, NodeAnimation::Type::TRANSLATION, {} });
+		NodeAnimation::Keyframes& keyframes = animation.nodeAnimations.back().keyframes;
+		keyframes.reserve(nodeAnim->mNumPositionKeys);
+		for (unsigned int k = 0; k < nodeAnim->mNumPositionKeys; k++)
+		{
+			objects::Transform transform;
+			transform.translation = mars::Vec3(nodeAnim->mPositionKeys[k].mValue.x, nodeAnim->mPositionKeys[k].mValue.y, nodeAnim->mPositionKeys[k].mValue.z);
+			keyframes.push_back({ nodeAnim->mPositionKeys[k].mTime, transform });
+		}
+	};
+	auto AddRotation = [](Animation& animation, const std::string& name, const aiNodeAnim* nodeAnim)
+	{
+		animation.nodeAnimations.push_back({ name, NodeAnimation::Type::ROTATION, {} });
+		NodeAnimation::Keyframes& keyframes = animation.nodeAnimations.back().keyframes;
+		keyframes.reserve(nodeAnim->mNumRotationKeys);
+		for (unsigned int k = 0; k < nodeAnim->mNumRotationKeys; k++)
+		{
+			objects::Transform transform;
+			transform.orientation = mars::Quat(nodeAnim->mRotationKeys[k].mValue.w, nodeAnim->mRotationKeys[k].mValue.x, nodeAnim->mRotationKeys[k].mValue.y, nodeAnim->mRotationKeys[k].mValue.z);
+			keyframes.push_back({ nodeAnim->mRotationKeys[k].mTime, transform });
+		}
+	};
+	auto AddScale = [](Animation& animation, const std::string& name, const aiNodeAnim* nodeAnim)
+	{
+		animation.nodeAnimations.push_back({ name, NodeAnimation::Type::SCALE, {} });
+		NodeAnimation::Keyframes& keyframes = animation.nodeAnimations.back().keyframes;
+		keyframes.reserve(nodeAnim->mNumScalingKeys);
+		for (unsigned int k = 0; k < nodeAnim->mNumScalingKeys; k++)
+		{
+			objects::Transform transform;
+			transform.scale = mars::Vec3(nodeAnim->mScalingKeys[k].mValue.x, nodeAnim->mScalingKeys[k].mValue.y, nodeAnim->mScalingKeys[k].mValue.z);
+			keyframes.push_back({ nodeAnim->mScalingKeys[k].mTime, transform });
+		}
+	};
+
 	for (unsigned int i = 0; i < scene->mNumAnimations; i++)
 	{
 		Animation animation;
@@ -250,78 +1103,35 @@ std::vector<animation::Animation> ModelLoader::ProcessAnimations(const aiScene*
 		animation.framesPerSecond = static_cast<uint32_t>(_animation->mTicksPerSecond);
 		animation.nodeAnimations.reserve(_animation->mNumChannels);
 
+		//FBX pivots are split by Assimp into a node per component, each with a channel of that component. Other nodes,
+		//such as the bones of a skeleton, have one channel of all three, which is split into a channel per component.
 		for (unsigned int j = 0; j < _animation->mNumChannels; j++)
 		{
-			aiNodeAnim*& nodeAnim = _animation->mChannels[j];
-
-			animation.nodeAnimations.push_back({});
-			NodeAnimation& node = animation.nodeAnimations.back();
-			node.name = std::string(nodeAnim->mNodeName.C_Str());
-			NodeAnimation::Keyframes& keyframes = node.keyframes;
+			const aiNodeAnim* nodeAnim = _animation->mChannels[j];
+			const std::string name = std::string(nodeAnim->mNodeName.C_Str());
 
-			if (node.name.find("Translation") != std::string::npos)
+			if (name.find("Translation") != std::string::npos)
 			{
-				node.type = NodeAnimation::Type::TRANSLATION;
-				keyframes.reserve(nodeAnim->mNumPositionKeys);
-				for (unsigned int k = 0; k < nodeAnim->mNumPositionKeys; k++)
-				{
-					double timepoint = nodeAnim->mPositionKeys[k].mTime;
-					mars::Vec3 translation = mars::Vec3(
-						nodeAnim->mPositionKeys[k].mValue.x,
-						nodeAnim->mPositionKeys[k].mValue.y,
-						nodeAnim->mPositionKeys[k].mValue.z);
-
-					objects::Transform transform;
-					transform.translation = translation;
-					NodeAnimation::Keyframe kf = { timepoint , transform };
-					keyframes.push_back(kf);
-				}
+				AddTranslation(animation, name, nodeAnim);
 			}
-			else if (node.name.find("Rotation") != std::string::npos)
+			else if (name.find("Rotation") != std::string::npos)
 			{
-				node.type = NodeAnimation::Type::ROTATION;
-				keyframes.reserve(nodeAnim->mNumRotationKeys);
-				for (unsigned int k = 0; k < nodeAnim->mNumRotationKeys; k++)
-				{
-					double timepoint = nodeAnim->mRotationKeys[k].mTime;
-					mars::Quat orientation = mars::Quat(
-						nodeAnim->mRotationKeys[k].mValue.w,
-						nodeAnim->mRotationKeys[k].mValue.x,
-						nodeAnim->mRotationKeys[k].mValue.y,
-						nodeAnim->mRotationKeys[k].mValue.z);
-
-					objects::Transform transform;
-					transform.orientation = orientation;
-					NodeAnimation::Keyframe kf = { timepoint , transform };
-					keyframes.push_back(kf);
-				}
+				AddRotation(animation, name, nodeAnim);
 			}
-			else if (node.name.find("Scaling") != std::string::npos)
+			else if (name.find("Scaling") != std::string::npos)
 			{
-				node.type = NodeAnimation::Type::SCALE;
-				keyframes.reserve(nodeAnim->mNumScalingKeys);
-				for (unsigned int k = 0; k < nodeAnim->mNumScalingKeys; k++)
-				{
-					double timepoint = nodeAnim->mScalingKeys[k].mTime;
-					mars::Vec3 scale = mars::Vec3(
-						nodeAnim->mScalingKeys[k].mValue.x,
-						nodeAnim->mScalingKeys[k].mValue.y,
-						nodeAnim->mScalingKeys[k].mValue.z);
-
-					objects::Transform transform;
-					transform.scale = scale;
-					NodeAnimation::Keyframe kf = { timepoint , transform };
-					keyframes.push_back(kf);
-				}
+				AddScale(animation, name, nodeAnim);
 			}
 			else
 			{
-				continue;
+				AddTranslation(animation, name, nodeAnim);
+				AddRotation(animation, name, nodeAnim);
+				AddScale(animation, name, nodeAnim);
 			}
-			animations.push_back(animation);
 		}
+		animations.push_back(std::move(animation));
 	}
-	return std::move(animations);
+	return animations;
 }
 
 std::vector<std::string> ModelLoader::GetMaterialFilePath(aiMaterial* material, aiTextureType type)
@@ -347,8 +1157,43 @@ std::vector<std::string> ModelLoader::GetMaterialFilePath(aiMaterial* material,
 	}
 	return result;
 }
-void ModelLoader::AddMaterialProperties(aiMaterial* aiMaterial, Ref<objects::Material> material)
+ModelLoader::MaterialData ModelLoader::GetMaterialData(aiMaterial* aiMaterial)
 {
+	MaterialData materialData;
+	for (unsigned int i = 0; i < AI_TEXTURE_TYPE_MAX; i++)
+	{
+		std::vector<std::string> filepaths = GetMaterialFilePath(aiMaterial, (aiTextureType)i);
+		if (!filepaths.empty())
+		{
+			objects::Material::TextureType type;
+			for (auto& filepath : filepaths)
+			{
+				switch (i)
+				{
+				case aiTextureType::aiTextureType_BASE_COLOR:
+					type = objects::Material::TextureType::ALBEDO; break;
+				case aiTextureType::aiTextureType_NORMAL_CAMERA:
+					type = objects::Material::TextureType::NORMAL; break;
+				case aiTextureType::aiTextureType_EMISSION_COLOR:
+					type = objects::Material::TextureType::EMISSIVE; break;
+				case aiTextureType::aiTextureType_METALNESS:
+					type = objects::Material::TextureType::METALLIC; break;
+				case aiTextureType::aiTextureType_DIFFUSE_ROUGHNESS:
+					type = objects::Material::TextureType::ROUGHNESS; break;
+				case aiTextureType::aiTextureType_AMBIENT_OCCLUSION:
+					type = objects::Material::TextureType::AMBIENT_OCCLUSION; break;
+				case aiTextureType::aiTextureType_NORMALS:
+					type = objects::Material::TextureType::NORMAL; break;
+				default:
+					type = objects::Material::TextureType::UNKNOWN; break;
+				}
+
+				if (arc::FileExist(filepath))
+					materialData.textureFilepaths.push_back({ type, filepath });
+			}
+		}
+	}
+
 	aiString name;
 	int twoSided;
 	int shadingModel;
@@ -385,7 +1230,7 @@ void ModelLoader::AddMaterialProperties(aiMaterial* aiMaterial, Ref<objects::Mat
 	aiMaterial->Get(AI_MATKEY_COLOR_REFLECTIVE, colourReflective);
 	//aiMaterial->Get(AI_MATKEY_GLOBAL_BACKGROUND_IMAGE, colour_diffuse);
 
-	material->AddProperties({
+	materialData.properties = {
 		name.C_Str(),
 		twoSided,
 		shadingModel,
@@ -402,6 +1247,6 @@ void ModelLoader::AddMaterialProperties(aiMaterial* aiMaterial, Ref<objects::Mat
 		mars::Vec4(colourEmissive.r, colourEmissive.g, colourEmissive.b, 1),
 		mars::Vec4(colourTransparent.r, colourTransparent.g, colourTransparent.b, 1),
 		mars::Vec4(colourReflective.r, colourReflective.g, colourReflective.b, 1)
-		});
-	material->Update();
-}
+		};
+	return materialData;
+}
\ No newline at end of file
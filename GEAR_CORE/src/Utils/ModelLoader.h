@@ -1,18 +1,22 @@
 #pragma once
 #include "gear_core_common.h"
 #include "Animation/Animation.h"
+#include "Core/ThreadPool.h"
+#include "Objects/Material.h"
 
 namespace gear 
 {
-	//Forward Declaration
-	namespace objects
-	{
-		class Material;
-	}
-		
+	//Imports models with Assimp, or loads them from cooked model files. A cooked model file holds the vertices and indices
+	//of every mesh in the layout of Vertex and uint32_t, followed by fixed size records of the meshes, materials, bones,
+	//node graph and animations. It is loaded by copying ranges straight out of the memory mapped file.
 	class ModelLoader
 	{
 	public:
+		enum class VertexFormat : uint32_t
+		{
+			FULL,		//Vertex
+			QUANTISED	//QuantisedVertex
+		};
 		struct Vertex
 		{
 			mars::Vec4 position;
@@ -22,11 +26,55 @@ namespace gear
 			mars::Vec4 binormal;
 			mars::Vec4 colour;
 		};
+		//The position is unorm16 within the bounds it was quantised to. The tangent frame is a snorm16 quaternion, whose
+		//w is negative when the binormal is reflected. The texture coordinate is half floats and the colour is unorm8.
+		//The shader fetches it as uint2, uint2, uint and uint attributes and unpacks it.
+		struct QuantisedVertex
+		{
+			uint16_t	position[4];		//w is unused.
+			int16_t		tangentFrame[4];	//xyzw
+			uint16_t	texCoord[2];
+			uint8_t		colour[4];
+		};
 		struct Bone
 		{
-			mars::Mat4								transform;
+			std::string								name;		//Of the node that animates the bone.
+			mars::Mat4								transform;	//From the mesh's space to the bone's space in the bind pose.
 			std::vector<std::pair<uint32_t, float>> vertexIDsAndWeights;
 		};
+		//The four largest weights of a vertex and the indices of their bones, in descending order of weight. The weights
+		//are unorm16 and sum to 65535, unless the vertex has no bones, in which case they are all 0. Unused slots have
+		//a weight and index of 0.
+		struct BoneInfluence
+		{
+			uint8_t		indices[4];
+			uint16_t	weights[4];
+		};
+		//Describes the Material of a mesh, which is created from it when the model is loaded.
+		struct MaterialData
+		{
+			std::vector<std::pair<objects::Material::TextureType, std::string>>	textureFilepaths;
+			objects::Material::Properties										properties;	//properties.name is the name of the Material.
+		};
+
+		//A simplified version of a mesh, whose indices refer to the same vertices.
+		struct LevelOfDetail
+		{
+			std::vector<uint32_t>	indices;
+			float					error;	//Largest object space distance of a vertex of the full mesh from this level. See MeshOptimiser::Simplify.
+		};
+
+		//A cluster of at most MeshletBuilder::MaxVertices vertices and MaxTriangles triangles, whose indices are contiguous
+		//in MeshData::indices. The bounds are in object space.
+		struct Meshlet
+		{
+			uint32_t	firstIndex;
+			uint32_t	indexCount;
+			uint32_t	vertexCount;	//Unique vertices used.
+			uint32_t	pad;
+			mars::Vec4	boundingSphere;	//Centre (xyz) and radius (w).
+			mars::Vec4	cone;			//Normalised mean of the triangle normals (xyz) and the cutoff (w). A cutoff of 1 is never culled.
+		};
 
 		struct MeshData
 		{
@@ -34,8 +82,15 @@ namespace gear
 			std::string				nodeName;
 			std::vector<Vertex>		vertices;
 			std::vector<uint32_t>	indices;
+			std::vector<LevelOfDetail> levelsOfDetail;	//Coarser levels after the full mesh, which is level 0.
+			std::vector<Meshlet>	meshlets;			//Of the full mesh. Empty if the indices have not been split into meshlets.
 			std::vector<Bone>		bones;
+			std::vector<BoneInfluence> boneInfluences;	//One per vertex, packed from the bones. Empty if the mesh has no bones.
+			MaterialData			material;
 			Ref<objects::Material>	pMaterial;
+			mars::Vec3				boundingBoxMin;	//Object space axis aligned bounding box.
+			mars::Vec3				boundingBoxMax;
+			mars::Vec4				boundingSphere;	//Object space centre (xyz) and radius (w).
 		};
 		struct Node
 		{
@@ -54,21 +109,181 @@ namespace gear
 			Node								nodeGraph;
 		};
 	
+		//Header of a cooked model file. Each section is an array of the records below, aligned to 16 bytes in the file.
+		//Names and filepaths are offsets into the null terminated strings of the STRINGS section.
+		enum class CookedSection : uint32_t
+		{
+			VERTICES,			//Vertex: The vertices of every mesh.
+			INDICES,			//uint32_t: The indices of every mesh and its levels of detail, relative to the mesh's first vertex.
+			MESHES,				//CookedMesh
+			LEVELS_OF_DETAIL,	//CookedLevelOfDetail
+			MESHLETS,			//Meshlet: The meshlets of every mesh.
+			MATERIALS,			//CookedMaterial
+			MATERIAL_TEXTURES,	//CookedMaterialTexture
+			BONES,				//CookedBone
+			BONE_WEIGHTS,		//CookedBoneWeight: The bone influences are packed from these when the model is loaded.
+			NODES,				//CookedNode: The node graph in depth first order.
+			ANIMATIONS,			//CookedAnimation
+			NODE_ANIMATIONS,	//CookedNodeAnimation
+			KEYFRAMES,			//CookedKeyframe
+			STRINGS,			//char
+			COUNT
+		};
+		struct CookedHeader
+		{
+			uint32_t	magic;
+			uint32_t	version;
+			uint32_t	vertexSize;	//Size of a Vertex and an index, which must match to load the streams.
+			uint32_t	indexSize;
+			struct
+			{
+				uint64_t	offset;	//In bytes from the start of the file.
+				uint64_t	count;	//In records.
+			}			sections[static_cast<size_t>(CookedSection::COUNT)];
+			uint64_t	size;		//Of the whole file.
+		};
+		struct CookedNode
+		{
+			uint32_t	name;
+			uint32_t	childCount;
+			uint32_t	meshIndex;			//~0 for none.
+			uint32_t	animationIndex;		//~0 for none.
+			uint32_t	nodeAnimationIndex;	//~0 for none.
+			float		transform[16];
+		};
+		#define GEAR_MODEL_COOKED_FILE_EXTENSION ".gmesh"
+		#define GEAR_MODEL_COOKED_MAGIC 0x48534D47 //'GMSH'
+		#define GEAR_MODEL_COOKED_VERSION 5
+
+	private:
+		struct CookedMesh
+		{
+			uint32_t	meshName;
+			uint32_t	nodeName;
+			uint32_t	materialIndex;	//~0 for none.
+			uint32_t	boneCount;
+			uint64_t	firstBone;
+			uint64_t	firstVertex;
+			uint64_t	vertexCount;
+			uint64_t	firstIndex;
+			uint64_t	indexCount;
+			float		boundingBoxMin[3];
+			float		boundingBoxMax[3];
+			float		boundingSphere[4];
+			uint32_t	firstLevelOfDetail;
+			uint32_t	levelOfDetailCount;
+			uint32_t	firstMeshlet;
+			uint32_t	meshletCount;
+		};
+		struct CookedLevelOfDetail
+		{
+			uint64_t	firstIndex;
+			uint64_t	indexCount;
+			float		error;
+			uint32_t	pad;
+		};
+		struct CookedMaterial
+		{
+			uint32_t	name;
+			uint32_t	firstTexture;
+			uint32_t	textureCount;
+			int32_t		twoSided;
+			int32_t		shadingModel;
+			int32_t		wireframe;
+			int32_t		blendFunc;
+			float		opacity;
+			float		shininess;
+			float		reflectivity;
+			float		shininessStrength;
+			float		refractiveIndex;
+			float		colours[6][4];	//Diffuse, ambient, specular, emissive, transparent and reflective.
+		};
+		struct CookedMaterialTexture
+		{
+			uint32_t	type;
+			uint32_t	filepath;
+		};
+		struct CookedBone
+		{
+			uint32_t	name;
+			uint32_t	pad;
+			float		transform[16];
+			uint64_t	firstWeight;
+			uint64_t	weightCount;
+		};
+		struct CookedBoneWeight
+		{
+			uint32_t	vertexID;
+			float		weight;
+		};
+		struct CookedAnimation
+		{
+			uint32_t	sequenceType;
+			uint32_t	framesPerSecond;
+			double		duration;
+			uint64_t	firstNodeAnimation;
+			uint64_t	nodeAnimationCount;
+		};
+		struct CookedNodeAnimation
+		{
+			uint32_t	name;
+			uint32_t	type;
+			uint64_t	firstKeyframe;
+			uint64_t	keyframeCount;
+		};
+		struct CookedKeyframe
+		{
+			double		timepoint;
+			float		translation[3];
+			float		orientation[4];
+			float		scale[3];
+		};
+
 	public:
+		//Loads a cooked model file, or imports any other file with Assimp, and creates the materials of its meshes.
+		//Other files are loaded through the AssetDatabase if there is one, which cooks them into its cache directory.
 		static ModelData LoadModelData(const std::string& filepath);
+		//Imports the file with Assimp. The materials are described but not created. The meshes are converted, optimised and
+		//split into meshlets in parallel on the import thread pool.
+		static ModelData ImportModelData(const std::string& filepath);
+		//Loads a cooked model file. The materials are described but not created. Files with out of range sections, ranges
+		//or vertex indices are rejected with a warning and an empty ModelData is returned.
+		static ModelData LoadCookedModel(const std::string& filepath);
+		//Writes the meshes, their MaterialData, the node graph and animations to a cooked model file, creating its directory.
+		static bool WriteCookedModel(const std::string& filepath, const ModelData& modelData);
+		static bool IsCookedModelFile(const std::string& filepath);
+		//Creates the Material of every mesh from its MaterialData, reusing loaded materials of the same name.
+		static void CreateMaterials(ModelData& modelData);
+		static void CalculateBounds(MeshData& mesh);
+		//Packs the four largest weights of each vertex into mesh.boneInfluences. Only the first 256 bones can be indexed,
+		//and the weights of any others are dropped.
+		static void PackBoneInfluences(MeshData& mesh);
+
+		//The positions must lie within boundingBoxMin and boundingBoxMax, which the shader dequantises them with.
+		//Normals, tangents and binormals are orthonormalised into a tangent frame around the normal.
+		static void QuantiseVertices(const Vertex* vertices, size_t count, const mars::Vec3& boundingBoxMin, const mars::Vec3& boundingBoxMax, QuantisedVertex* quantisedVertices);
+		static void DequantiseVertices(const QuantisedVertex* quantisedVertices, size_t count, const mars::Vec3& boundingBoxMin, const mars::Vec3& boundingBoxMax, Vertex* vertices);
 	
 		inline static void SetDevice(void* device) { m_Device = device; }
+		//Imported meshes are welded and reordered by the MeshOptimiser and split into meshlets by the MeshletBuilder, unless this is disabled.
+		inline static void SetOptimiseMeshes(bool optimiseMeshes) { m_OptimiseMeshes = optimiseMeshes; }
+		inline static bool GetOptimiseMeshes() { return m_OptimiseMeshes; }
+		//The number of threads that imported meshes are converted on. 0 uses the hardware thread count, and 1 converts them on the calling thread.
+		static void SetImportWorkerCount(uint32_t importWorkerCount);
+		inline static uint32_t GetImportWorkerCount() { return m_ImportWorkerCount; }
 		inline constexpr static size_t GetSizeOfVertex() { return sizeof(Vertex); }
+		inline constexpr static size_t GetSizeOfVertex(VertexFormat vertexFormat) { return vertexFormat == VertexFormat::QUANTISED ? sizeof(QuantisedVertex) : sizeof(Vertex); }
 		inline constexpr static size_t GetSizeOfIndex() { return sizeof(uint32_t); }
 	
 	private:
-		static void BuildNodeGraph(const aiScene* scene, aiNode* node, Node& thisNode, ModelData& modelData);
+		struct NodeGraphContext;
+		static void BuildNodeGraph(const aiScene* scene, const aiNode* node, Node& thisNode, NodeGraphContext& context);
 
-		static std::vector<MeshData> ProcessMeshes(aiNode* node, const aiScene* scene);
+		static MeshData ProcessMesh(const aiNode* node, const aiMesh* mesh, const aiScene* scene);
 		static std::vector<animation::Animation> ProcessAnimations(const aiScene* scene);
 
 		static std::vector<std::string> GetMaterialFilePath(aiMaterial* material, aiTextureType type);
-		static void AddMaterialProperties(aiMaterial* aiMaterial, Ref<objects::Material> material);
+		static MaterialData GetMaterialData(aiMaterial* material);
 
 		inline static void Convert_aiMatrix4x4ToMat4(const aiMatrix4x4& in, mars::Mat4& out)
 		{
@@ -77,5 +292,9 @@ namespace gear
 
 	private:
 		static void* m_Device;
+		static bool m_OptimiseMeshes;
+		static uint32_t m_ImportWorkerCount;
+		static Ref<core::ThreadPool> m_ImportThreadPool;
+		static std::mutex m_ImportThreadPoolMutex;
 	};
 }
\ No newline at end of file
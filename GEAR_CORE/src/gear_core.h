@@ -3,6 +3,7 @@
 //Animation
 #include "Animation/Animation.h"
 #include "Animation/Animator.h"
+#include "Animation/Skinner.h"
 
 //Audio
 #include "Audio/AudioInterfaces.h"
@@ -15,20 +16,32 @@
 #include "Core/EnumStringMaps.h"
 #include "Core/PlatformMacros.h"
 #include "Core/Sequencer.h"
+#include "Core/ThreadPool.h"
 #include "Core/Timer.h"
 #include "Core/TypeLibrary.h"
 
 //Graphics
 #include "Graphics/AllocatorManager.h"
+#include "Graphics/BufferCopyBatch.h"
+#include "Graphics/ClusterCulling.h"
+#include "Graphics/DescriptorAllocator.h"
 #include "Graphics/Framebuffer.h"
+#include "Graphics/FrustumCulling.h"
+#include "Graphics/ImageDecoder.h"
 #include "Graphics/ImageProcessing.h"
 #include "Graphics/Indexbuffer.h"
+#include "Graphics/LevelOfDetail.h"
+#include "Graphics/MeshPool.h"
 #include "Graphics/Renderer.h"
 #include "Graphics/RenderPipeline.h"
 #include "Graphics/RenderSurface.h"
 #include "Graphics/Storagebuffer.h"
 #include "Graphics/Texture.h"
+#include "Graphics/TextureCache.h"
+#include "Graphics/TextureCompressor.h"
+#include "Graphics/TextureStreamer.h"
 #include "Graphics/Uniformbuffer.h"
+#include "Graphics/UniformRing.h"
 #include "Graphics/Vertexbuffer.h"
 #include "Graphics/Window.h"
 
@@ -55,5 +68,9 @@
 #include "Scene/Scene.h"
 
 //Utils
+#include "Utils/AssetDatabase.h"
 #include "Utils/FileUtils.h"
+#include "Utils/MemoryMappedFile.h"
+#include "Utils/MeshletBuilder.h"
+#include "Utils/MeshOptimiser.h"
 #include "Utils/ModelLoader.h"
\ No newline at end of file
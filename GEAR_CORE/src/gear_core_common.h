@@ -13,16 +13,21 @@
 #include <sstream>
 #include <string>
 #include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
 #include <chrono>
 
 //STL
 #include <vector>
 #include <array>
 #include <deque>
+#include <list>
 #include <set>
 #include <map>
 #include <algorithm>
 #include <future>
+#include <functional>
 
 //Smart Poiners
 #include <memory>
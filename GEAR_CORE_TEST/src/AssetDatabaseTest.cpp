@@ -0,0 +1,107 @@
+#include "Test.h"
+
+#include <filesystem>
+
+using namespace gear;
+using namespace graphics;
+using namespace test;
+
+using namespace miru;
+using namespace miru::crossplatform;
+
+//Compares loading GEAR_TEST's drone and its images from their sources, against cooking them into an empty cache,
+//loading them through the database once they are cooked, and only reading the bytes of the cooked files.
+GEAR_TEST_CASE(AssetDatabaseWarmStart, BENCHMARK)
+{
+	const std::string cacheDirectory = context.GetTemporaryFilepath("AssetDatabaseWarmStart");
+	std::error_code error;
+	std::filesystem::remove_all(cacheDirectory, error);
+
+	AssetDatabase::CreateInfo assetDatabaseCI;
+	assetDatabaseCI.debugName = "GEAR_CORE_TEST_AssetDatabase";
+	assetDatabaseCI.cacheDirectory = cacheDirectory;
+	assetDatabaseCI.workerCount = 0;
+	Scope<AssetDatabase> assetDatabase = CreateScope<AssetDatabase>(&assetDatabaseCI);
+
+	const std::string modelFilepath = context.GetResourceFilepath("res/obj/Drone_Animated_03.fbx");
+	std::vector<std::pair<std::string, Image::Format>> images;
+	for (const auto& image : std::vector<std::pair<std::string, Image::Format>>{
+		{ "res/img/kloppenheim_06_2k.hdr", Image::Format::E5B9G9R9_UFLOAT_PACK32 },
+		{ "res/img/drone/Totally_LP_defaultMat_BaseColor.png", Image::Format::R8G8B8A8_UNORM },
+		{ "res/img/drone/Totally_LP_defaultMat_Metallic.png", Image::Format::R32G32B32A32_SFLOAT },
+		{ "res/img/drone/Totally_LP_defaultMat_Normal.png", Image::Format::R8G8B8A8_UNORM },
+		{ "res/img/drone/Totally_LP_defaultMat_Roughness.png", Image::Format::R32G32B32A32_SFLOAT },
+		{ "res/img/drone/Totally_LP_defaultMat_Occlusion.png", Image::Format::R32G32B32A32_SFLOAT },
+		{ "res/img/drone/Totally_LP_defaultMat_Emissive.png", Image::Format::R8G8B8A8_UNORM } })
+	{
+		//The image is decoded to the format that a Texture of the format would decode it to.
+		ImageDecoder::ImageInfo info;
+		const std::string filepath = context.GetResourceFilepath(image.first);
+		if (GEAR_TEST_CHECK(ImageDecoder::GetImageInfo(filepath, info), "Unable to read %s.", filepath.c_str()))
+			images.push_back({ filepath, Texture::GetDecodeFormat(image.second, info.hdr) });
+	}
+
+	auto start = std::chrono::high_resolution_clock::now();
+	const size_t sourceMeshCount = ModelLoader::ImportModelData(modelFilepath).meshes.size();
+	size_t sourceSize = 0;
+	for (const auto& image : images)
+	{
+		ImageDecoder::ImageInfo info;
+		ImageDecoder::GetImageInfo(image.first, info);
+		std::vector<uint8_t> data(size_t(info.width) * size_t(info.height) * Texture::GetTexelSize(image.second));
+		GEAR_TEST_CHECK(ImageDecoder::DecodeImage(image.first, info.width, info.height, image.second, false, data.data()), "Unable to decode %s.", image.first.c_str());
+		sourceSize += data.size();
+	}
+	const double sourceTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	//The cache is empty, so every asset is cooked.
+	start = std::chrono::high_resolution_clock::now();
+	std::vector<std::string> cookedFilepaths = { assetDatabase->GetModel(modelFilepath, true) };
+	for (const auto& image : images)
+		cookedFilepaths.push_back(assetDatabase->GetTexture(image.first, image.second, false, true));
+	assetDatabase->Wait();
+	const double cookTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	const AssetDatabase::Statistics cookStatistics = assetDatabase->GetStatistics();
+	const size_t cookedCount = std::count_if(cookedFilepaths.begin(), cookedFilepaths.end(), [](const std::string& filepath) { return !filepath.empty(); });
+	GEAR_TEST_CHECK(cookedCount == cookedFilepaths.size(), "%zu of %zu asset(s) were cooked.", cookedCount, cookedFilepaths.size());
+	GEAR_TEST_CHECK(cookStatistics.cooks >= cookedFilepaths.size(), "%u cook(s) for %zu asset(s) in an empty cache.", cookStatistics.cooks, cookedFilepaths.size());
+
+	//Every request is now answered from the cache. The model's dependencies are requested too, so they add hits of their own.
+	start = std::chrono::high_resolution_clock::now();
+	const size_t cookedMeshCount = ModelLoader::LoadCookedModel(assetDatabase->GetModel(modelFilepath, true)).meshes.size();
+	size_t cookedSize = 0;
+	for (const auto& image : images)
+	{
+		Texture::CookedHeader header;
+		std::vector<uint8_t> data;
+		const std::string cookedFilepath = assetDatabase->GetTexture(image.first, image.second, false, true);
+		GEAR_TEST_CHECK(Texture::ReadCookedTexture(cookedFilepath, header, data), "Unable to read %s.", cookedFilepath.c_str());
+		cookedSize += data.size();
+	}
+	const double warmTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	const AssetDatabase::Statistics warmStatistics = assetDatabase->GetStatistics();
+	GEAR_TEST_CHECK(warmStatistics.cooks == cookStatistics.cooks, "%u asset(s) were cooked again.", warmStatistics.cooks - cookStatistics.cooks);
+	GEAR_TEST_CHECK(warmStatistics.hits - cookStatistics.hits >= cookedFilepaths.size(), "%llu hit(s) for %zu cooked asset(s).", warmStatistics.hits - cookStatistics.hits, cookedFilepaths.size());
+	GEAR_TEST_CHECK(cookedMeshCount == sourceMeshCount && sourceMeshCount > 0, "%zu cooked mesh(es), %zu imported.", cookedMeshCount, sourceMeshCount);
+	GEAR_TEST_CHECK(cookedSize >= sourceSize, "%zu bytes of cooked texels, %zu decoded.", cookedSize, sourceSize);
+
+	start = std::chrono::high_resolution_clock::now();
+	size_t fileSize = 0;
+	for (const std::string& cookedFilepath : cookedFilepaths)
+	{
+		std::ifstream stream(cookedFilepath, std::ios::binary | std::ios::ate);
+		std::vector<char> data(stream.is_open() ? static_cast<size_t>(stream.tellg()) : 0);
+		stream.seekg(0);
+		stream.read(data.data(), data.size());
+		fileSize += data.size();
+	}
+	const double readTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	printf("    %zu asset(s). Source load: %.3f ms, cooking: %.3f ms (%u cooked), cooked load: %.3f ms, reading %zu bytes: %.3f ms.\n",
+		cookedFilepaths.size(), sourceTime, cookTime, cookStatistics.cooks, warmTime, fileSize, readTime);
+
+	assetDatabase.reset();
+	std::filesystem::remove_all(cacheDirectory, error);
+}
\ No newline at end of file
@@ -0,0 +1,230 @@
+#include "Test.h"
+
+using namespace gear;
+using namespace graphics;
+using namespace test;
+
+using namespace miru;
+using namespace miru::crossplatform;
+
+typedef CommandPool::QueueType QueueType;
+
+//Compile() only describes the barriers, so the buffers are keys that are never dereferenced, and no device is needed.
+static Ref<Buffer> GetBufferKey(size_t index)
+{
+	static uint64_t keys[16];
+	return Ref<Buffer>(Ref<Buffer>(), reinterpret_cast<Buffer*>(&keys[index]));
+}
+
+static FrameGraph::CreateInfo GetFrameGraphCreateInfo(bool join)
+{
+	FrameGraph::CreateInfo frameGraphCI;
+	frameGraphCI.debugName = "GEAR_CORE_TEST_FrameGraph";
+	frameGraphCI.cmdBuffers[QueueType::GRAPHICS] = { nullptr, { 0, 1, 2, 3 } };
+	frameGraphCI.cmdBuffers[QueueType::COMPUTE] = { nullptr, { 0, 1, 2, 3 } };
+	frameGraphCI.cmdBuffers[QueueType::TRANSFER] = { nullptr, { 0, 1, 2, 3 } };
+	frameGraphCI.queueOwnershipTransfers = false;
+	frameGraphCI.join = join;
+	return frameGraphCI;
+}
+
+static FrameGraph::PassCreateInfo GetPassCreateInfo(const std::string& debugName, QueueType queueType, const std::vector<FrameGraph::ResourceUsage>& reads, const std::vector<FrameGraph::ResourceUsage>& writes, bool hasSideEffects)
+{
+	FrameGraph::PassCreateInfo passCI;
+	passCI.debugName = debugName;
+	passCI.queueType = queueType;
+	passCI.task = GPUTask::Task::NONE;
+	passCI.pTaskInfo = nullptr;
+	passCI.hostTask = nullptr;
+	passCI.reads = reads;
+	passCI.writes = writes;
+	passCI.hasSideEffects = hasSideEffects;
+	return passCI;
+}
+
+static FrameGraph::ResourceUsage GetBufferUsage(const Ref<Buffer>& buffer, Barrier::AccessBit access, PipelineStageBit pipelineStage)
+{
+	return { nullptr, buffer, access, Image::Layout::UNKNOWN, pipelineStage };
+}
+
+static size_t GetSubmissionIndexOfPass(const FrameGraph& frameGraph, size_t passIndex)
+{
+	const std::vector<FrameGraph::Submission>& submissions = frameGraph.GetSubmissions();
+	for (size_t i = 0; i < submissions.size(); i++)
+	{
+		const std::vector<size_t>& passIndices = submissions[i].passIndices;
+		if (std::find(passIndices.begin(), passIndices.end(), passIndex) != passIndices.end())
+			return i;
+	}
+	return SIZE_MAX;
+}
+
+static size_t CountBarriers(const std::vector<FrameGraph::TransitionInfo>& transitions, const Ref<Buffer>& buffer, Barrier::AccessBit srcAccess, Barrier::AccessBit dstAccess)
+{
+	size_t count = 0;
+	for (const FrameGraph::TransitionInfo& transition : transitions)
+	{
+		for (const FrameGraph::BarrierInfo& barrier : transition.barriers)
+			count += barrier.buffer == buffer && barrier.srcState.access == srcAccess && barrier.dstState.access == dstAccess ? 1 : 0;
+	}
+	return count;
+}
+
+static size_t CountMemoryBarriers(const std::vector<FrameGraph::TransitionInfo>& transitions)
+{
+	size_t count = 0;
+	for (const FrameGraph::TransitionInfo& transition : transitions)
+	{
+		for (const FrameGraph::BarrierInfo& barrier : transition.barriers)
+		{
+			count += !barrier.texture && !barrier.buffer && transition.srcPipelineStage == PipelineStageBit::ALL_COMMANDS_BIT
+				&& transition.dstPipelineStage == PipelineStageBit::ALL_COMMANDS_BIT ? 1 : 0;
+		}
+	}
+	return count;
+}
+
+//Passes are kept by side effects, by writing exported resources, or by producing for a pass that is kept.
+//The culled passes are left out of the submissions.
+GEAR_TEST_CASE(FrameGraphCullsPassesWithoutConsumers, UNIT)
+{
+	const Ref<Buffer> exported = GetBufferKey(0), unread = GetBufferKey(1), consumed = GetBufferKey(2), unused = GetBufferKey(3);
+
+	FrameGraph::CreateInfo frameGraphCI = GetFrameGraphCreateInfo(false);
+	FrameGraph frameGraph(&frameGraphCI);
+	frameGraph.ExportResource(exported, { Barrier::AccessBit::VERTEX_ATTRIBUTE_READ_BIT, Image::Layout::UNKNOWN, PipelineStageBit::VERTEX_INPUT_BIT, QueueType::GRAPHICS });
+	frameGraph.AddPass(GetPassCreateInfo("Export", QueueType::TRANSFER, {}, { GetBufferUsage(exported, Barrier::AccessBit::TRANSFER_WRITE_BIT, PipelineStageBit::TRANSFER_BIT) }, false));
+	frameGraph.AddPass(GetPassCreateInfo("Unread", QueueType::COMPUTE,
+		{ GetBufferUsage(exported, Barrier::AccessBit::SHADER_READ_BIT, PipelineStageBit::COMPUTE_SHADER_BIT) },
+		{ GetBufferUsage(unread, Barrier::AccessBit::SHADER_WRITE_BIT, PipelineStageBit::COMPUTE_SHADER_BIT) }, false));
+	frameGraph.AddPass(GetPassCreateInfo("Producer", QueueType::GRAPHICS, {}, { GetBufferUsage(consumed, Barrier::AccessBit::SHADER_WRITE_BIT, PipelineStageBit::FRAGMENT_SHADER_BIT) }, false));
+	frameGraph.AddPass(GetPassCreateInfo("SideEffects", QueueType::GRAPHICS, { GetBufferUsage(consumed, Barrier::AccessBit::SHADER_READ_BIT, PipelineStageBit::FRAGMENT_SHADER_BIT) }, {}, true));
+	frameGraph.AddPass(GetPassCreateInfo("Unused", QueueType::GRAPHICS, {}, { GetBufferUsage(unused, Barrier::AccessBit::SHADER_WRITE_BIT, PipelineStageBit::FRAGMENT_SHADER_BIT) }, false));
+	frameGraph.Compile();
+
+	const std::vector<bool> expectedCulled = { false, true, false, false, true };
+	for (size_t i = 0; i < expectedCulled.size(); i++)
+	{
+		GEAR_TEST_CHECK(frameGraph.IsPassCulled(i) == expectedCulled[i], "Pass %zu is %s.", i, frameGraph.IsPassCulled(i) ? "culled" : "kept");
+		GEAR_TEST_CHECK((GetSubmissionIndexOfPass(frameGraph, i) == SIZE_MAX) == expectedCulled[i], "Pass %zu is %s a submission.", i, expectedCulled[i] ? "in" : "not in");
+	}
+	GEAR_TEST_CHECK(frameGraph.GetCulledPassCount() == 2, "%zu of %zu pass(es) were culled, expected 2.", frameGraph.GetCulledPassCount(), frameGraph.GetPassCount());
+}
+
+//Hazards on the same queue are recorded before the pass, and reads after reads need no barrier. Between queues
+//without ownership transfers, the barrier is recorded on the more capable queue, which waits on or is waited on by the other.
+GEAR_TEST_CASE(FrameGraphPlacesBarriersOnHazardsAndQueueChanges, UNIT)
+{
+	const Ref<Buffer> vertices = GetBufferKey(0), image = GetBufferKey(1), results = GetBufferKey(2);
+
+	FrameGraph::CreateInfo frameGraphCI = GetFrameGraphCreateInfo(false);
+	FrameGraph frameGraph(&frameGraphCI);
+	frameGraph.AddPass(GetPassCreateInfo("Upload", QueueType::TRANSFER, {}, { GetBufferUsage(vertices, Barrier::AccessBit::TRANSFER_WRITE_BIT, PipelineStageBit::TRANSFER_BIT) }, false));
+	frameGraph.AddPass(GetPassCreateInfo("Draw", QueueType::GRAPHICS,
+		{ GetBufferUsage(vertices, Barrier::AccessBit::VERTEX_ATTRIBUTE_READ_BIT, PipelineStageBit::VERTEX_INPUT_BIT) },
+		{ GetBufferUsage(image, Barrier::AccessBit::SHADER_WRITE_BIT, PipelineStageBit::FRAGMENT_SHADER_BIT) }, false));
+	frameGraph.AddPass(GetPassCreateInfo("Post Process", QueueType::GRAPHICS, { GetBufferUsage(image, Barrier::AccessBit::SHADER_READ_BIT, PipelineStageBit::FRAGMENT_SHADER_BIT) }, {}, true));
+	frameGraph.AddPass(GetPassCreateInfo("Overlay", QueueType::GRAPHICS, { GetBufferUsage(image, Barrier::AccessBit::SHADER_READ_BIT, PipelineStageBit::FRAGMENT_SHADER_BIT) }, {}, true));
+	frameGraph.AddPass(GetPassCreateInfo("Simulate", QueueType::COMPUTE, {}, { GetBufferUsage(results, Barrier::AccessBit::SHADER_WRITE_BIT, PipelineStageBit::COMPUTE_SHADER_BIT) }, false));
+	frameGraph.AddPass(GetPassCreateInfo("Readback", QueueType::TRANSFER, { GetBufferUsage(results, Barrier::AccessBit::TRANSFER_READ_BIT, PipelineStageBit::TRANSFER_BIT) }, {}, true));
+	frameGraph.Compile();
+
+	const std::vector<FrameGraph::Submission>& submissions = frameGraph.GetSubmissions();
+	const size_t upload = GetSubmissionIndexOfPass(frameGraph, 0), draw = GetSubmissionIndexOfPass(frameGraph, 1), simulate = GetSubmissionIndexOfPass(frameGraph, 4), readback = GetSubmissionIndexOfPass(frameGraph, 5);
+	if (!GEAR_TEST_CHECK(upload != SIZE_MAX && draw != SIZE_MAX && simulate != SIZE_MAX && readback != SIZE_MAX, "%zu pass(es) were culled.", frameGraph.GetCulledPassCount()))
+		return;
+
+	//The passes on the graphics queue are merged into one submission, which waits on the upload.
+	const FrameGraph::Submission& graphics = submissions[draw];
+	GEAR_TEST_CHECK(graphics.passIndices.size() == 3 && GetSubmissionIndexOfPass(frameGraph, 3) == draw, "%zu graphics pass(es) in the draw submission, expected 3.", graphics.passIndices.size());
+	GEAR_TEST_CHECK(graphics.dependencies.count(upload) == 1 && submissions[upload].signalSemaphore, "The draw submission waits on %zu submission(s), but not on the upload.", graphics.dependencies.size());
+	if (graphics.preBarriers.size() != 3)
+		return;
+
+	//Transfer to graphics: Recorded by the graphics queue before the draw.
+	const size_t drawBarrierCount = CountBarriers(graphics.preBarriers[0], vertices, Barrier::AccessBit::TRANSFER_WRITE_BIT, Barrier::AccessBit::VERTEX_ATTRIBUTE_READ_BIT);
+	const size_t uploadBarrierCount = CountBarriers(submissions[upload].postBarriers, vertices, Barrier::AccessBit::TRANSFER_WRITE_BIT, Barrier::AccessBit::VERTEX_ATTRIBUTE_READ_BIT);
+	GEAR_TEST_CHECK(drawBarrierCount == 1 && uploadBarrierCount == 0, "%zu upload to draw barrier(s) before the draw and %zu after the upload, expected 1 and 0.", drawBarrierCount, uploadBarrierCount);
+
+	//Read after write on the same queue, then read after read.
+	const size_t postProcessBarrierCount = CountBarriers(graphics.preBarriers[1], image, Barrier::AccessBit::SHADER_WRITE_BIT, Barrier::AccessBit::SHADER_READ_BIT);
+	GEAR_TEST_CHECK(postProcessBarrierCount == 1, "%zu draw to post process barrier(s), expected 1.", postProcessBarrierCount);
+	for (const FrameGraph::TransitionInfo& transition : graphics.preBarriers[1])
+	{
+		GEAR_TEST_CHECK(transition.srcPipelineStage == PipelineStageBit::FRAGMENT_SHADER_BIT && transition.dstPipelineStage == PipelineStageBit::FRAGMENT_SHADER_BIT,
+			"The post process barrier is from stage 0x%x to 0x%x.", static_cast<uint32_t>(transition.srcPipelineStage), static_cast<uint32_t>(transition.dstPipelineStage));
+	}
+	GEAR_TEST_CHECK(graphics.preBarriers[2].empty(), "%zu barrier(s) between two reads.", graphics.preBarriers[2].size());
+
+	//Compute to transfer: Recorded by the compute queue after the simulation.
+	const FrameGraph::Submission& readbackSubmission = submissions[readback];
+	const size_t simulateBarrierCount = CountBarriers(submissions[simulate].postBarriers, results, Barrier::AccessBit::SHADER_WRITE_BIT, Barrier::AccessBit::TRANSFER_READ_BIT);
+	const size_t readbackTransitionCount = readbackSubmission.preBarriers.empty() ? 0 : readbackSubmission.preBarriers[0].size();
+	GEAR_TEST_CHECK(simulateBarrierCount == 1 && readbackTransitionCount == 0, "%zu simulation to readback barrier(s) after the simulation and %zu transition(s) before the readback, expected 1 and 0.", simulateBarrierCount, readbackTransitionCount);
+	GEAR_TEST_CHECK(readbackSubmission.dependencies.count(simulate) == 1, "The readback waits on %zu submission(s), but not on the simulation.", readbackSubmission.dependencies.size());
+}
+
+//Queues that no GPU submission waits on are joined by a GRAPHICS submission at the end of the graph, and the last
+//GRAPHICS submission ends with the only full memory barrier, so that later graphics work is ordered after the graph.
+GEAR_TEST_CASE(FrameGraphJoinsOtherQueuesOnGraphics, UNIT)
+{
+	const FrameGraph::ResourceState vertexReadState = { Barrier::AccessBit::VERTEX_ATTRIBUTE_READ_BIT, Image::Layout::UNKNOWN, PipelineStageBit::VERTEX_INPUT_BIT, QueueType::GRAPHICS };
+	const Ref<Buffer> vertices = GetBufferKey(0), results = GetBufferKey(1);
+
+	//The exported buffer is transitioned by a graphics epilogue that waits on the upload, and the compute queue is joined.
+	{
+		FrameGraph::CreateInfo frameGraphCI = GetFrameGraphCreateInfo(true);
+		FrameGraph frameGraph(&frameGraphCI);
+		frameGraph.ExportResource(vertices, vertexReadState);
+		frameGraph.AddPass(GetPassCreateInfo("Upload", QueueType::TRANSFER, {}, { GetBufferUsage(vertices, Barrier::AccessBit::TRANSFER_WRITE_BIT, PipelineStageBit::TRANSFER_BIT) }, false));
+		frameGraph.AddPass(GetPassCreateInfo("Simulate", QueueType::COMPUTE, {}, { GetBufferUsage(results, Barrier::AccessBit::SHADER_WRITE_BIT, PipelineStageBit::COMPUTE_SHADER_BIT) }, true));
+		frameGraph.Compile();
+
+		const std::vector<FrameGraph::Submission>& submissions = frameGraph.GetSubmissions();
+		const std::vector<size_t>& executionOrder = frameGraph.GetExecutionOrder();
+		const size_t upload = GetSubmissionIndexOfPass(frameGraph, 0), simulate = GetSubmissionIndexOfPass(frameGraph, 1);
+		if (!GEAR_TEST_CHECK(upload != SIZE_MAX && simulate != SIZE_MAX && executionOrder.size() == 4, "%zu submission(s), expected the upload, simulation, epilogue and join.", executionOrder.size()))
+			return;
+
+		const FrameGraph::Submission& epilogue = submissions[executionOrder[2]];
+		const FrameGraph::Submission& join = submissions[executionOrder[3]];
+		GEAR_TEST_CHECK(epilogue.queueType == QueueType::GRAPHICS && epilogue.dependencies == std::set<size_t>{ upload }, "The epilogue waits on %zu submission(s), expected only the upload.", epilogue.dependencies.size());
+		const size_t exportBarrierCount = CountBarriers(epilogue.postBarriers, vertices, Barrier::AccessBit::TRANSFER_WRITE_BIT, vertexReadState.access);
+		GEAR_TEST_CHECK(exportBarrierCount == 1, "%zu transition(s) of the exported buffer by the epilogue, expected 1.", exportBarrierCount);
+		GEAR_TEST_CHECK(join.queueType == QueueType::GRAPHICS && join.passIndices.empty() && join.dependencies == std::set<size_t>{ simulate }, "The join waits on %zu submission(s), expected only the simulation.", join.dependencies.size());
+		GEAR_TEST_CHECK(submissions[upload].signalSemaphore && submissions[simulate].signalSemaphore && !join.signalSemaphore, 
+			"Semaphores signalled: Upload: %d, simulation: %d, join: %d.", submissions[upload].signalSemaphore, submissions[simulate].signalSemaphore, join.signalSemaphore);
+
+		const size_t epilogueMemoryBarrierCount = CountMemoryBarriers(epilogue.postBarriers);
+		const size_t joinMemoryBarrierCount = CountMemoryBarriers(join.postBarriers);
+		const size_t lastMemoryBarrierCount = join.postBarriers.empty() ? 0 : CountMemoryBarriers({ join.postBarriers.back() });
+		GEAR_TEST_CHECK(epilogueMemoryBarrierCount == 0 && joinMemoryBarrierCount == 1 && lastMemoryBarrierCount == 1, 
+			"%zu memory barrier(s) in the epilogue and %zu in the join, expected the join to end with its only one.", epilogueMemoryBarrierCount, joinMemoryBarrierCount);
+	}
+
+	//Every other queue is waited on by a graphics pass, so no join is added, but the last graphics submission still ends with the memory barrier.
+	{
+		FrameGraph::CreateInfo frameGraphCI = GetFrameGraphCreateInfo(true);
+		FrameGraph frameGraph(&frameGraphCI);
+		frameGraph.AddPass(GetPassCreateInfo("Upload", QueueType::TRANSFER, {}, { GetBufferUsage(vertices, Barrier::AccessBit::TRANSFER_WRITE_BIT, PipelineStageBit::TRANSFER_BIT) }, false));
+		frameGraph.AddPass(GetPassCreateInfo("Draw", QueueType::GRAPHICS, { GetBufferUsage(vertices, vertexReadState.access, vertexReadState.pipelineStage) }, {}, true));
+		frameGraph.Compile();
+
+		const std::vector<FrameGraph::Submission>& submissions = frameGraph.GetSubmissions();
+		const size_t draw = GetSubmissionIndexOfPass(frameGraph, 1);
+		GEAR_TEST_CHECK(submissions.size() == 2 && draw != SIZE_MAX && frameGraph.GetExecutionOrder().back() == draw, "%zu submission(s), expected the upload and the draw.", submissions.size());
+		const size_t memoryBarrierCount = draw != SIZE_MAX ? CountMemoryBarriers(submissions[draw].postBarriers) : 0;
+		GEAR_TEST_CHECK(memoryBarrierCount == 1, "%zu memory barrier(s) after the draw, expected 1.", memoryBarrierCount);
+	}
+
+	//Graphics work alone is ordered by submission, so nothing is added.
+	{
+		FrameGraph::CreateInfo frameGraphCI = GetFrameGraphCreateInfo(true);
+		FrameGraph frameGraph(&frameGraphCI);
+		frameGraph.AddPass(GetPassCreateInfo("Draw", QueueType::GRAPHICS, {}, { GetBufferUsage(results, Barrier::AccessBit::SHADER_WRITE_BIT, PipelineStageBit::FRAGMENT_SHADER_BIT) }, true));
+		frameGraph.Compile();
+
+		const std::vector<FrameGraph::Submission>& submissions = frameGraph.GetSubmissions();
+		GEAR_TEST_CHECK(submissions.size() == 1 && submissions[0].postBarriers.empty(), "%zu submission(s) for a single graphics pass.", submissions.size());
+	}
+}
\ No newline at end of file
@@ -0,0 +1,276 @@
+#include "Test.h"
+
+using namespace gear;
+using namespace graphics;
+using namespace test;
+
+using namespace miru;
+using namespace miru::crossplatform;
+
+typedef UniformBufferStructures::CullInfo CullInfo;
+typedef UniformBufferStructures::DrawInstance DrawInstance;
+typedef UniformBufferStructures::DrawIndexedIndirectCommand DrawIndexedIndirectCommand;
+
+static const uint32_t BatchCount = 3;
+
+//A 90 degree frustum at the origin looking down -Z, from 0.1 to 100. Planes are inward facing.
+static void SetFrustum(CullInfo& cullInfo)
+{
+	const float s = 1.0f / std::sqrt(2.0f);
+	cullInfo.frustumPlanes[0] = mars::Vec4(s, 0.0f, -s, 0.0f);
+	cullInfo.frustumPlanes[1] = mars::Vec4(-s, 0.0f, -s, 0.0f);
+	cullInfo.frustumPlanes[2] = mars::Vec4(0.0f, s, -s, 0.0f);
+	cullInfo.frustumPlanes[3] = mars::Vec4(0.0f, -s, -s, 0.0f);
+	cullInfo.frustumPlanes[4] = mars::Vec4(0.0f, 0.0f, -1.0f, -0.1f);
+	cullInfo.frustumPlanes[5] = mars::Vec4(0.0f, 0.0f, 1.0f, 100.0f);
+}
+
+//A grid of spheres, which are inside, outside and straddling every plane. Every third instance is scaled by 3, so that
+//the world space radius is tested too. The bounding spheres are offset from their origins. The batches are interleaved.
+static void BuildScene(CullInfo& cullInfo, std::vector<DrawInstance>& instances, std::vector<uint32_t>& batchOffsets)
+{
+	SetFrustum(cullInfo);
+
+	instances.clear();
+	for (int z = -2; z <= 24; z++)
+	{
+		for (int y = -6; y <= 6; y++)
+		{
+			for (int x = -6; x <= 6; x++)
+			{
+				const uint32_t index = static_cast<uint32_t>(instances.size());
+				const float scale = index % 3 == 0 ? 3.0f : 1.0f;
+
+				DrawInstance instance = {};
+				instance.modl = mars::Mat4::Identity();
+				instance.modl.a = instance.modl.f = instance.modl.k = scale;
+				instance.modl.d = static_cast<float>(x) * 4.0f;
+				instance.modl.h = static_cast<float>(y) * 4.0f;
+				instance.modl.l = static_cast<float>(-z) * 4.5f;
+				instance.boundingSphere = mars::Vec4(0.25f, -0.5f, 0.0f, 1.0f);
+				instance.indexCount = 3 * (index % 7 + 1);
+				instance.firstIndex = index * 3;
+				instance.vertexOffset = static_cast<int32_t>(index % 5);
+				instance.materialID = index % 4;
+				instance.batchIndex = index % BatchCount;
+				instances.push_back(instance);
+			}
+		}
+	}
+
+	//Each batch owns a range large enough for all of its instances, as in Renderer::BuildDrawInstances().
+	std::vector<uint32_t> batchSizes(BatchCount, 0);
+	for (const DrawInstance& instance : instances)
+		batchSizes[instance.batchIndex]++;
+	batchOffsets.resize(BatchCount);
+	uint32_t batchOffset = 0;
+	for (uint32_t i = 0; i < BatchCount; i++)
+	{
+		batchOffsets[i] = batchOffset;
+		batchOffset += batchSizes[i];
+	}
+	for (DrawInstance& instance : instances)
+		instance.batchOffset = batchOffsets[instance.batchIndex];
+
+	cullInfo.instanceCount = static_cast<uint32_t>(instances.size());
+	cullInfo.batchCount = BatchCount;
+}
+
+//A straightforward frustum cull of the scene, independent of Renderer::CullDrawInstances(). Returns the visible instances of each batch.
+static std::vector<std::set<uint32_t>> FrustumCull(const CullInfo& cullInfo, const std::vector<DrawInstance>& instances)
+{
+	std::vector<std::set<uint32_t>> visibleInstances(BatchCount);
+	for (uint32_t i = 0; i < static_cast<uint32_t>(instances.size()); i++)
+	{
+		const DrawInstance& instance = instances[i];
+		const float scale = instance.modl.a;
+		const mars::Vec3 centre(
+			instance.boundingSphere.x * scale + instance.modl.d,
+			instance.boundingSphere.y * scale + instance.modl.h,
+			instance.boundingSphere.z * scale + instance.modl.l);
+		const float radius = instance.boundingSphere.w * scale;
+
+		bool visible = true;
+		for (const mars::Vec4& plane : cullInfo.frustumPlanes)
+		{
+			if (plane.x * centre.x + plane.y * centre.y + plane.z * centre.z + plane.w < -radius)
+				visible = false;
+		}
+		if (visible)
+			visibleInstances[instance.batchIndex].insert(i);
+	}
+	return visibleInstances;
+}
+
+//Checks the compacted draw commands of each batch against the expected visible instances. The order within a batch is not checked.
+static void CheckDrawCommands(TestContext& context, const char* source, const std::vector<DrawInstance>& instances, const std::vector<uint32_t>& batchOffsets,
+	const std::vector<std::set<uint32_t>>& expected, const DrawIndexedIndirectCommand* drawCommands, const uint32_t* drawCounts)
+{
+	for (uint32_t batch = 0; batch < BatchCount; batch++)
+	{
+		if (!GEAR_TEST_CHECK(drawCounts[batch] == expected[batch].size(), "%s: Batch %u has %u draws. Expected %zu.", source, batch, drawCounts[batch], expected[batch].size()))
+			continue;
+
+		std::set<uint32_t> visibleInstances;
+		for (uint32_t i = 0; i < drawCounts[batch]; i++)
+		{
+			const DrawIndexedIndirectCommand& command = drawCommands[batchOffsets[batch] + i];
+			if (!GEAR_TEST_CHECK(command.firstInstance < instances.size(), "%s: Batch %u draws instance %u, which does not exist.", source, batch, command.firstInstance))
+				continue;
+
+			const DrawInstance& instance = instances[command.firstInstance];
+			GEAR_TEST_CHECK(command.indexCount == instance.indexCount && command.instanceCount == 1 && command.firstIndex == instance.firstIndex && command.vertexOffset == instance.vertexOffset,
+				"%s: The draw of instance %u does not match the instance.", source, command.firstInstance);
+			GEAR_TEST_CHECK(instance.batchIndex == batch, "%s: Instance %u is drawn by batch %u, but it belongs to batch %u.", source, command.firstInstance, batch, instance.batchIndex);
+			visibleInstances.insert(command.firstInstance);
+		}
+		GEAR_TEST_CHECK(visibleInstances == expected[batch], "%s: The visible instances of batch %u do not match the frustum cull.", source, batch);
+	}
+}
+
+GEAR_TEST_CASE(CullDrawInstancesMatchesFrustumCull, UNIT)
+{
+	CullInfo cullInfo = {};
+	std::vector<DrawInstance> instances;
+	std::vector<uint32_t> batchOffsets;
+	BuildScene(cullInfo, instances, batchOffsets);
+	const std::vector<std::set<uint32_t>> expected = FrustumCull(cullInfo, instances);
+
+	size_t visibleCount = 0;
+	for (const std::set<uint32_t>& visibleInstances : expected)
+		visibleCount += visibleInstances.size();
+	GEAR_TEST_CHECK(visibleCount > 0 && visibleCount < instances.size(), "The scene must have visible and culled instances. %zu of %zu are visible.", visibleCount, instances.size());
+
+	std::vector<DrawIndexedIndirectCommand> drawCommands(instances.size(), DrawIndexedIndirectCommand{});
+	std::vector<uint32_t> drawCounts(BatchCount, 0);
+	Renderer::CullDrawInstances(cullInfo, instances.data(), drawCommands.data(), drawCounts.data());
+	CheckDrawCommands(context, "CPU", instances, batchOffsets, expected, drawCommands.data(), drawCounts.data());
+}
+
+GEAR_TEST_CASE(GPUDrivenCullMatchesFrustumCull, DEVICE)
+{
+	if (!GraphicsAPI::IsVulkan())
+	{
+		printf("    GPU-driven culling requires Vulkan. Skipped.\n");
+		return;
+	}
+	Device& device = *context.device;
+
+	CullInfo cullInfo = {};
+	std::vector<DrawInstance> instances;
+	std::vector<uint32_t> batchOffsets;
+	BuildScene(cullInfo, instances, batchOffsets);
+	const std::vector<std::set<uint32_t>> expected = FrustumCull(cullInfo, instances);
+
+	RenderPipeline::LoadInfo cullPipelineLI;
+	cullPipelineLI.device = device.device;
+	cullPipelineLI.filepath = "res/pipelines/GPUDrivenCull.grpf.json";
+	cullPipelineLI.viewportWidth = 0.0f;
+	cullPipelineLI.viewportHeight = 0.0f;
+	cullPipelineLI.renderPass = nullptr;
+	cullPipelineLI.subpassIndex = 0;
+	Ref<RenderPipeline> cullPipeline = CreateRef<RenderPipeline>(&cullPipelineLI);
+
+	Uniformbuffer<CullInfo>::CreateInfo cullInfoCI;
+	cullInfoCI.debugName = "GEAR_CORE_TEST_CullInfo";
+	cullInfoCI.device = device.device;
+	cullInfoCI.data = &cullInfo;
+	cullInfoCI.perFrame = false;
+	Ref<Uniformbuffer<CullInfo>> cullInfoUB = CreateRef<Uniformbuffer<CullInfo>>(&cullInfoCI);
+
+	GrowableStoragebuffer<DrawInstance>::CreateInfo drawInstancesCI;
+	drawInstancesCI.debugName = "GEAR_CORE_TEST_DrawInstances";
+	drawInstancesCI.device = device.device;
+	drawInstancesCI.count = instances.size();
+	drawInstancesCI.additionalUsage = Buffer::UsageBit(0);
+	Ref<GrowableStoragebuffer<DrawInstance>> drawInstances = CreateRef<GrowableStoragebuffer<DrawInstance>>(&drawInstancesCI);
+	std::copy(instances.begin(), instances.end(), drawInstances->GetData());
+	drawInstances->SubmitData();
+
+	//The commands are filled with a pattern, so that writes outside of the visible ranges are detected.
+	GrowableStoragebuffer<DrawIndexedIndirectCommand>::CreateInfo drawCommandsCI;
+	drawCommandsCI.debugName = "GEAR_CORE_TEST_DrawCommands";
+	drawCommandsCI.device = device.device;
+	drawCommandsCI.count = instances.size();
+	drawCommandsCI.additionalUsage = Buffer::UsageBit::INDIRECT_BIT;
+	Ref<GrowableStoragebuffer<DrawIndexedIndirectCommand>> drawCommands = CreateRef<GrowableStoragebuffer<DrawIndexedIndirectCommand>>(&drawCommandsCI);
+	const DrawIndexedIndirectCommand pattern = { 0xDEADBEEF, 0xDEADBEEF, 0xDEADBEEF, -1, 0xDEADBEEF };
+	std::fill(drawCommands->GetData(), drawCommands->GetData() + drawCommands->GetCount(), pattern);
+	drawCommands->SubmitData();
+
+	GrowableStoragebuffer<uint32_t>::CreateInfo drawCountsCI;
+	drawCountsCI.debugName = "GEAR_CORE_TEST_DrawCounts";
+	drawCountsCI.device = device.device;
+	drawCountsCI.count = BatchCount;
+	drawCountsCI.additionalUsage = Buffer::UsageBit(0);
+	Ref<GrowableStoragebuffer<uint32_t>> drawCounts = CreateRef<GrowableStoragebuffer<uint32_t>>(&drawCountsCI);
+	drawCounts->SubmitData();
+
+	DescriptorAllocator::CreateInfo descAllocatorCI;
+	descAllocatorCI.debugName = "GEAR_CORE_TEST_DescriptorAllocator";
+	descAllocatorCI.device = device.device;
+	descAllocatorCI.initialSetsPerPool = 1;
+	descAllocatorCI.frameLatency = 1;
+	Ref<DescriptorAllocator> descAllocator = CreateRef<DescriptorAllocator>(&descAllocatorCI);
+	Ref<DescriptorSet> descSetCull = descAllocator->Acquire(cullPipeline->GetDescriptorSetLayouts()[0], {
+		{ 0, { { cullInfoUB->GetBufferView() } }, {} },
+		{ 1, { { drawInstances->GetBufferView() } }, {} },
+		{ 2, { { drawCommands->GetBufferView() } }, {} },
+		{ 3, { { drawCounts->GetBufferView() } }, {} } },
+		"GEAR_CORE_TEST_DescriptorSet_GPUDrivenCull");
+
+	auto CreateBarrier = [](const Ref<Buffer>& buffer, Barrier::AccessBit srcAccess, Barrier::AccessBit dstAccess) -> Ref<Barrier>
+	{
+		Barrier::CreateInfo barrierCI;
+		barrierCI.type = Barrier::Type::BUFFER;
+		barrierCI.srcAccess = srcAccess;
+		barrierCI.dstAccess = dstAccess;
+		barrierCI.srcQueueFamilyIndex = MIRU_QUEUE_FAMILY_IGNORED;
+		barrierCI.dstQueueFamilyIndex = MIRU_QUEUE_FAMILY_IGNORED;
+		barrierCI.pBuffer = buffer;
+		barrierCI.offset = 0;
+		barrierCI.size = buffer->GetCreateInfo().size;
+		return Barrier::Create(&barrierCI);
+	};
+
+	device.Submit([&](const Ref<CommandBuffer>& cmdBuffer)
+	{
+		cullInfoUB->Upload(cmdBuffer, 0, true);
+		drawInstances->Upload(cmdBuffer);
+		drawCommands->Upload(cmdBuffer);
+		drawCounts->Upload(cmdBuffer);
+		cmdBuffer->PipelineBarrier(0, PipelineStageBit::TRANSFER_BIT, PipelineStageBit::COMPUTE_SHADER_BIT, DependencyBit::NONE_BIT, {
+			CreateBarrier(cullInfoUB->GetBuffer(), Barrier::AccessBit::TRANSFER_WRITE_BIT, Barrier::AccessBit::UNIFORM_READ_BIT),
+			CreateBarrier(drawInstances->GetBuffer(), Barrier::AccessBit::TRANSFER_WRITE_BIT, Barrier::AccessBit::SHADER_READ_BIT),
+			CreateBarrier(drawCommands->GetBuffer(), Barrier::AccessBit::TRANSFER_WRITE_BIT, Barrier::AccessBit::SHADER_WRITE_BIT),
+			CreateBarrier(drawCounts->GetBuffer(), Barrier::AccessBit::TRANSFER_WRITE_BIT, Barrier::AccessBit::SHADER_READ_BIT | Barrier::AccessBit::SHADER_WRITE_BIT) });
+
+		const Ref<Pipeline>& pipeline = cullPipeline->GetPipeline();
+		cmdBuffer->BindPipeline(0, pipeline);
+		cmdBuffer->BindDescriptorSets(0, { descSetCull }, pipeline);
+		cmdBuffer->Dispatch(0, (cullInfo.instanceCount + 63) / 64, 1, 1);
+
+		cmdBuffer->PipelineBarrier(0, PipelineStageBit::COMPUTE_SHADER_BIT, PipelineStageBit::TRANSFER_BIT, DependencyBit::NONE_BIT, {
+			CreateBarrier(drawCommands->GetBuffer(), Barrier::AccessBit::SHADER_WRITE_BIT, Barrier::AccessBit::TRANSFER_READ_BIT),
+			CreateBarrier(drawCounts->GetBuffer(), Barrier::AccessBit::SHADER_WRITE_BIT, Barrier::AccessBit::TRANSFER_READ_BIT) });
+		drawCommands->Download(cmdBuffer);
+		drawCounts->Download(cmdBuffer);
+	});
+	drawCommands->AccessData();
+	drawCounts->AccessData();
+
+	CheckDrawCommands(context, "GPU", instances, batchOffsets, expected, drawCommands->GetData(), drawCounts->GetData());
+
+	//Commands past each batch's count must be left untouched.
+	for (uint32_t batch = 0; batch < BatchCount; batch++)
+	{
+		const uint32_t batchEnd = batch + 1 < BatchCount ? batchOffsets[batch + 1] : static_cast<uint32_t>(instances.size());
+		for (uint32_t i = batchOffsets[batch] + (*drawCounts)[batch]; i < batchEnd; i++)
+		{
+			if (!GEAR_TEST_CHECK(memcmp(&(*drawCommands)[i], &pattern, sizeof(pattern)) == 0, "GPU: Command %u of batch %u is past the batch's count, but it was written.", i - batchOffsets[batch], batch))
+				break;
+		}
+	}
+
+	descAllocator->Release(descSetCull);
+}
\ No newline at end of file
@@ -0,0 +1,314 @@
+#include "Test.h"
+
+using namespace gear;
+using namespace test;
+
+using namespace mars;
+
+typedef std::array<float, 22> VertexKey;
+typedef std::array<VertexKey, 3> TriangleKey;
+
+//Compares every member of a Vertex, but not any padding between them.
+static VertexKey GetVertexKey(const ModelLoader::Vertex& vertex)
+{
+	return {
+		vertex.position.x, vertex.position.y, vertex.position.z, vertex.position.w,
+		vertex.texCoord.x, vertex.texCoord.y,
+		vertex.normal.x, vertex.normal.y, vertex.normal.z, vertex.normal.w,
+		vertex.tangent.x, vertex.tangent.y, vertex.tangent.z, vertex.tangent.w,
+		vertex.binormal.x, vertex.binormal.y, vertex.binormal.z, vertex.binormal.w,
+		vertex.colour.x, vertex.colour.y, vertex.colour.z, vertex.colour.w };
+}
+
+//The triangles of the mesh by the contents of their vertices, each rotated to start at its smallest vertex so that the
+//winding is kept, and sorted.
+static std::vector<TriangleKey> GetTriangleKeys(const ModelLoader::MeshData& mesh)
+{
+	std::vector<TriangleKey> triangles;
+	triangles.reserve(mesh.indices.size() / 3);
+	for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+	{
+		TriangleKey triangle = { GetVertexKey(mesh.vertices[mesh.indices[i + 0]]), GetVertexKey(mesh.vertices[mesh.indices[i + 1]]), GetVertexKey(mesh.vertices[mesh.indices[i + 2]]) };
+		std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+		triangles.push_back(triangle);
+	}
+	std::sort(triangles.begin(), triangles.end());
+	return triangles;
+}
+
+//The bone weights of each vertex, sorted by bone. Returns false if a weight refers past the vertices.
+static bool GetVertexWeights(const ModelLoader::MeshData& mesh, std::vector<std::vector<std::pair<uint32_t, float>>>& vertexWeights)
+{
+	vertexWeights.assign(mesh.vertices.size(), {});
+	for (uint32_t i = 0; i < static_cast<uint32_t>(mesh.bones.size()); i++)
+	{
+		for (const auto& vertexIDAndWeight : mesh.bones[i].vertexIDsAndWeights)
+		{
+			if (vertexIDAndWeight.first >= mesh.vertices.size())
+				return false;
+			vertexWeights[vertexIDAndWeight.first].push_back({ i, vertexIDAndWeight.second });
+		}
+	}
+	for (auto& weights : vertexWeights)
+		std::sort(weights.begin(), weights.end());
+	return true;
+}
+
+//A grid of quads whose triangles each have their own three vertices, in a scrambled order, followed by an unused
+//vertex. The bone weights of a vertex depend only on its position, so the duplicates of a vertex can be welded.
+static const uint32_t GridSize = 8;
+static const uint32_t GridBoneCount = 4;
+
+static std::vector<std::pair<uint32_t, float>> GetGridWeights(const Vec4& position)
+{
+	const uint32_t x = static_cast<uint32_t>(position.x), y = static_cast<uint32_t>(position.y);
+	std::vector<std::pair<uint32_t, float>> weights = { { x % GridBoneCount, 0.75f } };
+	if (y % GridBoneCount != x % GridBoneCount)
+		weights.push_back({ y % GridBoneCount, 0.25f });
+	std::sort(weights.begin(), weights.end());
+	return weights;
+}
+
+static ModelLoader::MeshData CreateGrid()
+{
+	ModelLoader::MeshData mesh;
+	mesh.meshName = "Grid";
+	mesh.bones.resize(GridBoneCount);
+	auto AddVertex = [&](uint32_t x, uint32_t y)
+	{
+		ModelLoader::Vertex vertex;
+		vertex.position = Vec4(float(x), float(y), 0.0f, 1.0f);
+		vertex.texCoord = Vec2(float(x) / float(GridSize), float(y) / float(GridSize));
+		vertex.normal = Vec4(0.0f, 0.0f, 1.0f, 0.0f);
+		vertex.tangent = Vec4(1.0f, 0.0f, 0.0f, 0.0f);
+		vertex.binormal = Vec4(0.0f, 1.0f, 0.0f, 0.0f);
+		vertex.colour = Vec4(1.0f, 1.0f, 1.0f, 1.0f);
+
+		const uint32_t vertexID = static_cast<uint32_t>(mesh.vertices.size());
+		for (const auto& weight : GetGridWeights(vertex.position))
+			mesh.bones[weight.first].vertexIDsAndWeights.push_back({ vertexID, weight.second });
+		mesh.vertices.push_back(vertex);
+		mesh.indices.push_back(vertexID);
+	};
+
+	const uint32_t quadCount = GridSize * GridSize;
+	for (uint32_t i = 0; i < quadCount; i++)
+	{
+		//7 is coprime to the quad count, so every quad is visited once.
+		const uint32_t quad = (i * 7) % quadCount;
+		const uint32_t x = quad % GridSize, y = quad / GridSize;
+		AddVertex(x, y); AddVertex(x + 1, y); AddVertex(x + 1, y + 1);
+		AddVertex(x, y); AddVertex(x + 1, y + 1); AddVertex(x, y + 1);
+	}
+
+	AddVertex(GridSize + 1, GridSize + 1);
+	mesh.indices.pop_back();
+	return mesh;
+}
+
+//Optimises the bundled models, which must keep the same triangles, the same winding and the same bone weights on each
+//vertex.
+GEAR_TEST_CASE(OptimiseKeepsTriangles, UNIT)
+{
+	const bool optimiseMeshes = ModelLoader::GetOptimiseMeshes();
+	ModelLoader::SetOptimiseMeshes(false);
+	context.ForEachModel([&](const std::string& filepath, ModelLoader::ModelData& modelData)
+	{
+		for (ModelLoader::MeshData& mesh : modelData.meshes)
+		{
+			const std::vector<TriangleKey> triangles = GetTriangleKeys(mesh);
+			std::map<VertexKey, std::vector<std::pair<uint32_t, float>>> weightsByVertex;
+			std::vector<std::vector<std::pair<uint32_t, float>>> vertexWeights;
+			GetVertexWeights(mesh, vertexWeights);
+			for (size_t i = 0; i < mesh.vertices.size(); i++)
+				weightsByVertex[GetVertexKey(mesh.vertices[i])] = vertexWeights[i];
+
+			const MeshOptimiser::Result result = MeshOptimiser::Optimise(mesh, MeshOptimiser::Options());
+			GEAR_TEST_CHECK(result.after.triangleCount == result.before.triangleCount, "%s: %s: %u triangles, %u before.", filepath.c_str(), mesh.meshName.c_str(), result.after.triangleCount, result.before.triangleCount);
+			GEAR_TEST_CHECK(result.after.vertexCount <= result.before.vertexCount, "%s: %s: %u vertices, %u before.", filepath.c_str(), mesh.meshName.c_str(), result.after.vertexCount, result.before.vertexCount);
+			GEAR_TEST_CHECK(GetTriangleKeys(mesh) == triangles, "%s: %s: The triangles have changed.", filepath.c_str(), mesh.meshName.c_str());
+
+			uint32_t mismatchedVertices = 0;
+			if (GEAR_TEST_CHECK(GetVertexWeights(mesh, vertexWeights), "%s: %s: A bone weight refers past the vertices.", filepath.c_str(), mesh.meshName.c_str()))
+			{
+				for (size_t i = 0; i < mesh.vertices.size(); i++)
+					mismatchedVertices += weightsByVertex[GetVertexKey(mesh.vertices[i])] != vertexWeights[i] ? 1 : 0;
+			}
+			GEAR_TEST_CHECK(mismatchedVertices == 0, "%s: %s: %u vertices have different bone weights.", filepath.c_str(), mesh.meshName.c_str(), mismatchedVertices);
+		}
+	});
+	ModelLoader::SetOptimiseMeshes(optimiseMeshes);
+}
+
+//Reordering for the vertex fetch must renumber the used vertices in the order that they are first used, with each
+//used vertex given exactly one new index, and remove the unused vertex.
+GEAR_TEST_CASE(ReorderForVertexFetchIsBijection, UNIT)
+{
+	//The vertices are reversed, so that the renumbering is not the identity.
+	ModelLoader::MeshData mesh = CreateGrid();
+	std::reverse(mesh.vertices.begin(), mesh.vertices.end());
+	for (uint32_t& index : mesh.indices)
+		index = static_cast<uint32_t>(mesh.vertices.size()) - 1 - index;
+	mesh.bones.clear();
+
+	const std::vector<ModelLoader::Vertex> vertices = mesh.vertices;
+	const std::vector<uint32_t> indices = mesh.indices;
+	const std::vector<TriangleKey> triangles = GetTriangleKeys(mesh);
+
+	MeshOptimiser::ReorderForVertexFetch(mesh);
+	if (!GEAR_TEST_CHECK(mesh.indices.size() == indices.size(), "%zu indices, %zu before.", mesh.indices.size(), indices.size()))
+		return;
+
+	//Each old index must map to one new index, and each new index must come from one old index.
+	std::vector<uint32_t> remap(vertices.size(), UINT32_MAX);
+	std::vector<uint32_t> inverseRemap(mesh.vertices.size(), UINT32_MAX);
+	uint32_t conflicts = 0, outOfOrder = 0, nextIndex = 0;
+	for (size_t i = 0; i < indices.size(); i++)
+	{
+		const uint32_t oldIndex = indices[i], newIndex = mesh.indices[i];
+		if (newIndex >= mesh.vertices.size())
+		{
+			conflicts++;
+			continue;
+		}
+		conflicts += (remap[oldIndex] != UINT32_MAX && remap[oldIndex] != newIndex) || (inverseRemap[newIndex] != UINT32_MAX && inverseRemap[newIndex] != oldIndex) ? 1 : 0;
+		if (remap[oldIndex] == UINT32_MAX)
+			outOfOrder += newIndex != nextIndex++ ? 1 : 0;
+		remap[oldIndex] = newIndex;
+		inverseRemap[newIndex] = oldIndex;
+	}
+	const size_t usedVertexCount = std::count_if(remap.begin(), remap.end(), [](uint32_t index) { return index != UINT32_MAX; });
+
+	GEAR_TEST_CHECK(conflicts == 0, "%u indices break the one to one mapping.", conflicts);
+	GEAR_TEST_CHECK(outOfOrder == 0, "%u vertices are not numbered in the order of first use.", outOfOrder);
+	GEAR_TEST_CHECK(mesh.vertices.size() == usedVertexCount && usedVertexCount == vertices.size() - 1, "%zu vertices, %zu used of %zu.", mesh.vertices.size(), usedVertexCount, vertices.size());
+	GEAR_TEST_CHECK(GetTriangleKeys(mesh) == triangles, "The %zu triangles have changed.", triangles.size());
+
+	uint32_t movedVertices = 0;
+	for (size_t i = 0; i < inverseRemap.size(); i++)
+		movedVertices += inverseRemap[i] == UINT32_MAX || GetVertexKey(mesh.vertices[i]) != GetVertexKey(vertices[inverseRemap[i]]) ? 1 : 0;
+	GEAR_TEST_CHECK(movedVertices == 0, "%u new vertices differ from the vertex they were mapped from.", movedVertices);
+}
+
+//The bone weights must follow the vertices through welding and every reordering, and those of the unused vertex
+//must be dropped.
+GEAR_TEST_CASE(OptimiseRemapsBoneIDs, UNIT)
+{
+	ModelLoader::MeshData mesh = CreateGrid();
+	MeshOptimiser::Options options;
+	options.levelOfDetailCount = 0;
+	MeshOptimiser::Optimise(mesh, options);
+
+	const size_t gridVertexCount = (GridSize + 1) * (GridSize + 1);
+	GEAR_TEST_CHECK(mesh.vertices.size() == gridVertexCount, "%zu vertices after welding, expected %zu.", mesh.vertices.size(), gridVertexCount);
+
+	std::vector<std::vector<std::pair<uint32_t, float>>> vertexWeights;
+	if (!GEAR_TEST_CHECK(GetVertexWeights(mesh, vertexWeights), "A bone weight refers past the %zu vertices.", mesh.vertices.size()))
+		return;
+
+	uint32_t mismatchedVertices = 0;
+	for (size_t i = 0; i < mesh.vertices.size(); i++)
+		mismatchedVertices += vertexWeights[i] != GetGridWeights(mesh.vertices[i].position) ? 1 : 0;
+	GEAR_TEST_CHECK(mismatchedVertices == 0, "%u of %zu vertices have the bone weights of another vertex.", mismatchedVertices, mesh.vertices.size());
+}
+
+static float PointSegmentDistance(const Vec3& p, const Vec3& a, const Vec3& b)
+{
+	const Vec3 ab = b - a;
+	const float lengthSquared = Vec3::Dot(ab, ab);
+	const float t = lengthSquared > 0.0f ? std::clamp(Vec3::Dot(p - a, ab) / lengthSquared, 0.0f, 1.0f) : 0.0f;
+	const Vec3 d = p - (a + ab * t);
+	return std::sqrt(Vec3::Dot(d, d));
+}
+
+static float PointTriangleDistance(const Vec3& p, const Vec3& a, const Vec3& b, const Vec3& c)
+{
+	const Vec3 normal = Vec3::Cross(b - a, c - a);
+	const float lengthSquared = Vec3::Dot(normal, normal);
+	if (lengthSquared > 0.0f)
+	{
+		const float planeDistance = Vec3::Dot(p - a, normal) / lengthSquared;
+		const Vec3 q = p - normal * planeDistance;
+		if (Vec3::Dot(Vec3::Cross(b - a, q - a), normal) >= 0.0f && Vec3::Dot(Vec3::Cross(c - b, q - b), normal) >= 0.0f && Vec3::Dot(Vec3::Cross(a - c, q - c), normal) >= 0.0f)
+			return std::abs(planeDistance) * std::sqrt(lengthSquared);
+	}
+	return std::min({ PointSegmentDistance(p, a, b), PointSegmentDistance(p, b, c), PointSegmentDistance(p, c, a) });
+}
+
+//The triangles that face away from the sum of their vertex normals.
+static uint32_t CountFlippedTriangles(const ModelLoader::MeshData& mesh, const std::vector<uint32_t>& indices)
+{
+	auto Position = [&](uint32_t index) { const Vec4& position = mesh.vertices[index].position; return Vec3(position.x, position.y, position.z); };
+	uint32_t flippedTriangles = 0;
+	for (size_t i = 0; i + 2 < indices.size(); i += 3)
+	{
+		const uint32_t* triangle = &indices[i];
+		const Vec3 normal = Vec3::Cross(Position(triangle[1]) - Position(triangle[0]), Position(triangle[2]) - Position(triangle[0]));
+		Vec3 vertexNormal(0.0f, 0.0f, 0.0f);
+		for (size_t j = 0; j < 3; j++)
+			vertexNormal = vertexNormal + Vec3(mesh.vertices[triangle[j]].normal.x, mesh.vertices[triangle[j]].normal.y, mesh.vertices[triangle[j]].normal.z);
+		flippedTriangles += Vec3::Dot(normal, vertexNormal) <= 0.0f ? 1 : 0;
+	}
+	return flippedTriangles;
+}
+
+//Each level of detail's reported error must bound the distance of every vertex of the full mesh from the level, which
+//is what the error measures, found by brute force. That is O(vertices * triangles), so it is skipped for large meshes.
+//No level may have more triangles facing away from their vertex normals than the full mesh.
+GEAR_TEST_CASE(LevelOfDetailErrorBoundsVertices, UNIT)
+{
+	context.ForEachModel([&](const std::string& filepath, ModelLoader::ModelData& modelData)
+	{
+		for (const ModelLoader::MeshData& mesh : modelData.meshes)
+		{
+			auto Position = [&](uint32_t index) { const Vec4& position = mesh.vertices[index].position; return Vec3(position.x, position.y, position.z); };
+			const bool bruteForce = mesh.vertices.size() * mesh.indices.size() < 100000000;
+			const uint32_t fullFlippedTriangles = CountFlippedTriangles(mesh, mesh.indices);
+
+			for (size_t level = 0; level < mesh.levelsOfDetail.size(); level++)
+			{
+				const ModelLoader::LevelOfDetail& levelOfDetail = mesh.levelsOfDetail[level];
+				GEAR_TEST_CHECK(levelOfDetail.indices.size() < mesh.indices.size(), "%s: %s: Level %zu has %zu indices, the full mesh %zu.", filepath.c_str(), mesh.meshName.c_str(), level + 1, levelOfDetail.indices.size(), mesh.indices.size());
+
+				float measuredError = 0.0f;
+				for (size_t i = 0; bruteForce && i < mesh.vertices.size(); i++)
+				{
+					float distance = std::numeric_limits<float>::max();
+					for (size_t j = 0; j < levelOfDetail.indices.size(); j += 3)
+						distance = std::min(distance, PointTriangleDistance(Position(static_cast<uint32_t>(i)), Position(levelOfDetail.indices[j + 0]), Position(levelOfDetail.indices[j + 1]), Position(levelOfDetail.indices[j + 2])));
+					measuredError = std::max(measuredError, distance);
+				}
+				GEAR_TEST_CHECK(measuredError <= levelOfDetail.error * 1.001f + 1e-6f, "%s: %s: Level %zu reports an error of %f, but a vertex is %f from it.", filepath.c_str(), mesh.meshName.c_str(), level + 1, levelOfDetail.error, measuredError);
+
+				const uint32_t flippedTriangles = CountFlippedTriangles(mesh, levelOfDetail.indices);
+				GEAR_TEST_CHECK(flippedTriangles <= fullFlippedTriangles, "%s: %s: Level %zu has %u flipped triangle(s), the full mesh %u.", filepath.c_str(), mesh.meshName.c_str(), level + 1, flippedTriangles, fullFlippedTriangles);
+
+				printf("    %s: %s: Level %zu: %zu of %zu triangles, error: %f, measured: %s.\n", filepath.c_str(), mesh.meshName.c_str(), level + 1,
+					levelOfDetail.indices.size() / 3, mesh.indices.size() / 3, levelOfDetail.error, bruteForce ? std::to_string(measuredError).c_str() : "skipped");
+			}
+		}
+	});
+}
+
+//Times the MeshOptimiser on the bundled models, imported without optimisation.
+GEAR_TEST_CASE(MeshOptimiserBundledModels, BENCHMARK)
+{
+	const bool optimiseMeshes = ModelLoader::GetOptimiseMeshes();
+	ModelLoader::SetOptimiseMeshes(false);
+	context.ForEachModel([&](const std::string& filepath, ModelLoader::ModelData& modelData)
+	{
+		for (ModelLoader::MeshData& mesh : modelData.meshes)
+		{
+			const auto start = std::chrono::high_resolution_clock::now();
+			const MeshOptimiser::Result result = MeshOptimiser::Optimise(mesh, MeshOptimiser::Options());
+			const double optimiseTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+			GEAR_TEST_CHECK(result.after.triangleCount == result.before.triangleCount, "%s: %s: %u triangles, %u before.", filepath.c_str(), mesh.meshName.c_str(), result.after.triangleCount, result.before.triangleCount);
+			GEAR_TEST_CHECK(result.after.vertexCount <= result.before.vertexCount, "%s: %s: %u vertices, %u before.", filepath.c_str(), mesh.meshName.c_str(), result.after.vertexCount, result.before.vertexCount);
+			printf("    %s: %s: %u -> %u vertices, %u triangles. ACMR: %.3f -> %.3f, ATVR: %.3f -> %.3f, %.3f ms.\n",
+				filepath.c_str(), mesh.meshName.c_str(), result.before.vertexCount, result.after.vertexCount, result.after.triangleCount,
+				result.before.acmr, result.after.acmr, result.before.atvr, result.after.atvr, optimiseTime);
+		}
+	});
+	ModelLoader::SetOptimiseMeshes(optimiseMeshes);
+}
\ No newline at end of file
@@ -0,0 +1,103 @@
+#include "Test.h"
+
+using namespace gear;
+using namespace graphics;
+using namespace test;
+
+using namespace mars;
+
+//The meshlets of the bundled models must be contiguous, cover every index, and keep within the limits. The cluster
+//culler must never cull a triangle that faces the view. The models are viewed from six sides, outside of their bounds.
+GEAR_TEST_CASE(MeshletsWithinLimitsAndCulledConservatively, UNIT)
+{
+	context.ForEachModel([&](const std::string& filepath, ModelLoader::ModelData& modelData)
+	{
+		for (const ModelLoader::MeshData& mesh : modelData.meshes)
+		{
+			GEAR_TEST_CHECK(!mesh.meshlets.empty(), "%s: %s: No meshlets.", filepath.c_str(), mesh.meshName.c_str());
+
+			size_t coveredIndexCount = 0;
+			uint32_t meshletsOutsideLimits = 0;
+			std::vector<uint32_t> meshletOfVertex(mesh.vertices.size(), UINT32_MAX);
+			for (uint32_t i = 0; i < static_cast<uint32_t>(mesh.meshlets.size()); i++)
+			{
+				const ModelLoader::Meshlet& meshlet = mesh.meshlets[i];
+				uint32_t vertexCount = 0;
+				for (size_t j = meshlet.firstIndex; j < meshlet.firstIndex + meshlet.indexCount && j < mesh.indices.size(); j++)
+				{
+					vertexCount += meshletOfVertex[mesh.indices[j]] != i ? 1 : 0;
+					meshletOfVertex[mesh.indices[j]] = i;
+				}
+				meshletsOutsideLimits += meshlet.firstIndex != coveredIndexCount || meshlet.indexCount % 3 != 0 || meshlet.vertexCount != vertexCount
+					|| meshlet.vertexCount > MeshletBuilder::MaxVertices || meshlet.indexCount > MeshletBuilder::MaxTriangles * 3 ? 1 : 0;
+				coveredIndexCount += meshlet.indexCount;
+			}
+			GEAR_TEST_CHECK(meshletsOutsideLimits == 0, "%s: %s: %u of %zu meshlet(s) are not contiguous, or exceed %u vertices or %u triangles.",
+				filepath.c_str(), mesh.meshName.c_str(), meshletsOutsideLimits, mesh.meshlets.size(), MeshletBuilder::MaxVertices, MeshletBuilder::MaxTriangles);
+			GEAR_TEST_CHECK(coveredIndexCount == mesh.indices.size(), "%s: %s: The meshlets cover %zu of %zu indices.", filepath.c_str(), mesh.meshName.c_str(), coveredIndexCount, mesh.indices.size());
+
+			const Vec4& sphere = mesh.boundingSphere;
+			const std::array<Vec4, 6> noPlanes = { Vec4(0.0f, 0.0f, 0.0f, 1.0f), Vec4(0.0f, 0.0f, 0.0f, 1.0f), Vec4(0.0f, 0.0f, 0.0f, 1.0f), Vec4(0.0f, 0.0f, 0.0f, 1.0f), Vec4(0.0f, 0.0f, 0.0f, 1.0f), Vec4(0.0f, 0.0f, 0.0f, 1.0f) };
+			const Vec3 directions[6] = { Vec3(1.0f, 0.0f, 0.0f), Vec3(-1.0f, 0.0f, 0.0f), Vec3(0.0f, 1.0f, 0.0f), Vec3(0.0f, -1.0f, 0.0f), Vec3(0.0f, 0.0f, 1.0f), Vec3(0.0f, 0.0f, -1.0f) };
+			auto Position = [&](uint32_t index) { const Vec4& p = mesh.vertices[index].position; return Vec3(p.x, p.y, p.z); };
+
+			std::vector<uint8_t> visible(mesh.meshlets.size());
+			size_t culledTriangles = 0;
+			uint32_t wronglyCulledTriangles = 0;
+			for (const Vec3& direction : directions)
+			{
+				const Vec3 position = Vec3(sphere.x, sphere.y, sphere.z) + direction * (sphere.w * 2.0f);
+				const ClusterCulling::View view = ClusterCulling::GetView(noPlanes, position, Mat4::Identity(), true);
+				ClusterCulling::Cull(view, mesh.meshlets.data(), mesh.meshlets.size(), visible.data());
+				for (size_t i = 0; i < mesh.meshlets.size(); i++)
+				{
+					if (visible[i])
+						continue;
+
+					const ModelLoader::Meshlet& meshlet = mesh.meshlets[i];
+					culledTriangles += meshlet.indexCount / 3;
+					for (size_t j = meshlet.firstIndex; j + 2 < meshlet.firstIndex + meshlet.indexCount; j += 3)
+					{
+						const Vec3 a = Position(mesh.indices[j + 0]);
+						const Vec3 normal = Vec3::Cross(Position(mesh.indices[j + 1]) - a, Position(mesh.indices[j + 2]) - a);
+						wronglyCulledTriangles += Vec3::Dot(normal, position - a) > 0.0f ? 1 : 0;
+					}
+				}
+			}
+			GEAR_TEST_CHECK(wronglyCulledTriangles == 0, "%s: %s: %u front facing triangle(s) culled.", filepath.c_str(), mesh.meshName.c_str(), wronglyCulledTriangles);
+
+			const size_t triangleCount = mesh.indices.size() / 3;
+			printf("    %s: %s: %zu triangles in %zu meshlet(s). Back face culling: %.1f%% of triangles culled.\n", filepath.c_str(), mesh.meshName.c_str(), triangleCount, mesh.meshlets.size(),
+				triangleCount ? 100.0 * double(culledTriangles) / double(triangleCount * 6) : 0.0);
+		}
+	});
+}
+
+//With meshlets, the optimiser must renumber the vertices in the meshlets' order, and report the statistics of it.
+GEAR_TEST_CASE(OptimiseWithMeshletsReportsFinalOrder, UNIT)
+{
+	const bool optimiseMeshes = ModelLoader::GetOptimiseMeshes();
+	ModelLoader::SetOptimiseMeshes(false);
+	context.ForEachModel([&](const std::string& filepath, ModelLoader::ModelData& modelData)
+	{
+		for (ModelLoader::MeshData& mesh : modelData.meshes)
+		{
+			MeshOptimiser::Options options;
+			options.buildMeshlets = true;
+			const MeshOptimiser::Result result = MeshOptimiser::Optimise(mesh, options);
+			const MeshOptimiser::Statistics statistics = MeshOptimiser::AnalyseVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size(), options.cacheSize);
+			GEAR_TEST_CHECK(!mesh.meshlets.empty(), "%s: %s: No meshlets.", filepath.c_str(), mesh.meshName.c_str());
+			GEAR_TEST_CHECK(result.after.acmr == statistics.acmr && result.after.atvr == statistics.atvr, "%s: %s: Reported ACMR %.3f, ATVR %.3f, but the final order has %.3f, %.3f.",
+				filepath.c_str(), mesh.meshName.c_str(), result.after.acmr, result.after.atvr, statistics.acmr, statistics.atvr);
+
+			uint32_t nextIndex = 0, outOfOrder = 0;
+			for (uint32_t index : mesh.indices)
+			{
+				outOfOrder += index > nextIndex ? 1 : 0;
+				nextIndex = std::max(nextIndex, index + 1);
+			}
+			GEAR_TEST_CHECK(outOfOrder == 0 && nextIndex == mesh.vertices.size(), "%s: %s: %u vertices are not numbered in the order of first use.", filepath.c_str(), mesh.meshName.c_str(), outOfOrder);
+		}
+	});
+	ModelLoader::SetOptimiseMeshes(optimiseMeshes);
+}
\ No newline at end of file
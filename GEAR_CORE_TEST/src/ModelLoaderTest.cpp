@@ -0,0 +1,275 @@
+#include "Test.h"
+
+#include <cfloat>
+
+using namespace gear;
+using namespace test;
+
+using namespace mars;
+
+//A quad of two triangles, with one coarser level of detail of one triangle.
+static ModelLoader::ModelData CreateQuad()
+{
+	ModelLoader::ModelData modelData;
+	modelData.nodeGraph.name = "Quad";
+	modelData.nodeGraph.transform = Mat4::Identity();
+	modelData.nodeGraph.meshIndex = 0;
+	modelData.meshes.resize(1);
+
+	ModelLoader::MeshData& mesh = modelData.meshes[0];
+	mesh.meshName = "Quad";
+	mesh.nodeName = "Quad";
+	for (const Vec2& corner : { Vec2(0.0f, 0.0f), Vec2(1.0f, 0.0f), Vec2(1.0f, 1.0f), Vec2(0.0f, 1.0f) })
+	{
+		ModelLoader::Vertex vertex;
+		vertex.position = Vec4(corner.x, corner.y, 0.0f, 1.0f);
+		vertex.texCoord = corner;
+		vertex.normal = Vec4(0.0f, 0.0f, 1.0f, 0.0f);
+		vertex.tangent = Vec4(1.0f, 0.0f, 0.0f, 0.0f);
+		vertex.binormal = Vec4(0.0f, 1.0f, 0.0f, 0.0f);
+		vertex.colour = Vec4(1.0f, 1.0f, 1.0f, 1.0f);
+		mesh.vertices.push_back(vertex);
+	}
+	mesh.indices = { 0, 1, 2, 0, 2, 3 };
+	mesh.levelsOfDetail.push_back({ { 0, 1, 2 }, 0.5f });
+	mesh.boundingBoxMin = Vec3(0.0f, 0.0f, 0.0f);
+	mesh.boundingBoxMax = Vec3(1.0f, 1.0f, 0.0f);
+	mesh.boundingSphere = Vec4(0.5f, 0.5f, 0.0f, sqrtf(0.5f));
+	return modelData;
+}
+
+static std::vector<char> ReadFile(const std::string& filepath)
+{
+	std::ifstream stream(filepath, std::ios::binary | std::ios::ate);
+	std::vector<char> data(stream.is_open() ? static_cast<size_t>(stream.tellg()) : 0);
+	stream.seekg(0);
+	stream.read(data.data(), data.size());
+	return data;
+}
+
+static void WriteFile(const std::string& filepath, const std::vector<char>& data)
+{
+	std::ofstream stream(filepath, std::ios::binary);
+	stream.write(data.data(), data.size());
+}
+
+//A cooked file whose base or level of detail indices refer past the mesh's vertices, or whose node refers past the
+//meshes, animations or node animations, must be rejected, rather than loaded and later read out of bounds.
+GEAR_TEST_CASE(CookedModelRejectsOutOfRangeIndices, UNIT)
+{
+	const std::string filepath = context.GetTemporaryFilepath("CookedModelRejectsOutOfRangeIndices" GEAR_MODEL_COOKED_FILE_EXTENSION);
+	const ModelLoader::ModelData modelData = CreateQuad();
+	if (!GEAR_TEST_CHECK(ModelLoader::WriteCookedModel(filepath, modelData), "Unable to write %s.", filepath.c_str()))
+		return;
+
+	const ModelLoader::ModelData loadedData = ModelLoader::LoadCookedModel(filepath);
+	if (GEAR_TEST_CHECK(loadedData.meshes.size() == 1, "%zu mesh(es) loaded from the valid file.", loadedData.meshes.size()))
+	{
+		const ModelLoader::MeshData& mesh = loadedData.meshes[0];
+		GEAR_TEST_CHECK(mesh.indices == modelData.meshes[0].indices, "%zu indices differ.", mesh.indices.size());
+		GEAR_TEST_CHECK(mesh.levelsOfDetail.size() == 1 && mesh.levelsOfDetail[0].indices == modelData.meshes[0].levelsOfDetail[0].indices, "%zu level(s) of detail differ.", mesh.levelsOfDetail.size());
+	}
+
+	//The indices of the mesh are followed by those of its level of detail.
+	const std::vector<char> data = ReadFile(filepath);
+	const ModelLoader::CookedHeader& header = *reinterpret_cast<const ModelLoader::CookedHeader*>(data.data());
+	const auto& indexSection = header.sections[static_cast<size_t>(ModelLoader::CookedSection::INDICES)];
+	const uint32_t vertexCount = static_cast<uint32_t>(modelData.meshes[0].vertices.size());
+	for (uint64_t index : { uint64_t(1), modelData.meshes[0].indices.size() + 1 })
+	{
+		std::vector<char> corruptData = data;
+		reinterpret_cast<uint32_t*>(corruptData.data() + indexSection.offset)[index] = vertexCount;
+		WriteFile(filepath, corruptData);
+
+		const ModelLoader::ModelData corruptModelData = ModelLoader::LoadCookedModel(filepath);
+		GEAR_TEST_CHECK(corruptModelData.meshes.empty(), "Index %llu of %llu is out of range, but %zu mesh(es) were loaded.", index, indexSection.count, corruptModelData.meshes.size());
+	}
+
+	//The quad has one mesh and no animations.
+	const auto& nodeSection = header.sections[static_cast<size_t>(ModelLoader::CookedSection::NODES)];
+	const std::vector<std::pair<const char*, std::function<void(ModelLoader::CookedNode&)>>> corruptNodes = {
+		{ "mesh", [](ModelLoader::CookedNode& node) { node.meshIndex = 1; } },
+		{ "animation", [](ModelLoader::CookedNode& node) { node.animationIndex = 0; } },
+		{ "node animation", [](ModelLoader::CookedNode& node) { node.nodeAnimationIndex = 0; } } };
+	for (const auto& corruptNode : corruptNodes)
+	{
+		std::vector<char> corruptData = data;
+		corruptNode.second(*reinterpret_cast<ModelLoader::CookedNode*>(corruptData.data() + nodeSection.offset));
+		WriteFile(filepath, corruptData);
+
+		const ModelLoader::ModelData corruptModelData = ModelLoader::LoadCookedModel(filepath);
+		GEAR_TEST_CHECK(corruptModelData.meshes.empty(), "The node's %s index is out of range, but %zu mesh(es) were loaded.", corruptNode.first, corruptModelData.meshes.size());
+	}
+	std::remove(filepath.c_str());
+}
+
+//Compares a cold Assimp import of the drone with loading the cooked model file written from it. Both must hold the
+//same meshes.
+GEAR_TEST_CASE(ModelLoadAssimpAgainstCooked, BENCHMARK)
+{
+	const std::string filepath = context.GetResourceFilepath("res/obj/Drone_Animated_03.fbx");
+	const std::string cookedFilepath = context.GetTemporaryFilepath("Drone_Animated_03" GEAR_MODEL_COOKED_FILE_EXTENSION);
+
+	auto start = std::chrono::high_resolution_clock::now();
+	const ModelLoader::ModelData importedData = ModelLoader::ImportModelData(filepath);
+	const double importTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	if (!GEAR_TEST_CHECK(!importedData.meshes.empty(), "Unable to import %s.", filepath.c_str()))
+		return;
+	if (!GEAR_TEST_CHECK(ModelLoader::WriteCookedModel(cookedFilepath, importedData), "Unable to write %s.", cookedFilepath.c_str()))
+		return;
+
+	start = std::chrono::high_resolution_clock::now();
+	const ModelLoader::ModelData cookedData = ModelLoader::LoadCookedModel(cookedFilepath);
+	const double cookedTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	std::remove(cookedFilepath.c_str());
+
+	size_t vertexCount = 0;
+	GEAR_TEST_CHECK(cookedData.meshes.size() == importedData.meshes.size(), "%zu cooked mesh(es), %zu imported.", cookedData.meshes.size(), importedData.meshes.size());
+	for (size_t i = 0; i < std::min(cookedData.meshes.size(), importedData.meshes.size()); i++)
+	{
+		const ModelLoader::MeshData& cookedMesh = cookedData.meshes[i];
+		const ModelLoader::MeshData& importedMesh = importedData.meshes[i];
+		const bool sameVertices = cookedMesh.vertices.size() == importedMesh.vertices.size()
+			&& memcmp(cookedMesh.vertices.data(), importedMesh.vertices.data(), importedMesh.vertices.size() * sizeof(ModelLoader::Vertex)) == 0;
+		GEAR_TEST_CHECK(sameVertices, "%s: The vertices differ.", importedMesh.meshName.c_str());
+		GEAR_TEST_CHECK(cookedMesh.indices == importedMesh.indices, "%s: The indices differ.", importedMesh.meshName.c_str());
+		GEAR_TEST_CHECK(cookedMesh.levelsOfDetail.size() == importedMesh.levelsOfDetail.size(), "%s: %zu cooked level(s) of detail, %zu imported.", importedMesh.meshName.c_str(), cookedMesh.levelsOfDetail.size(), importedMesh.levelsOfDetail.size());
+		GEAR_TEST_CHECK(cookedMesh.meshlets.size() == importedMesh.meshlets.size(), "%s: %zu cooked meshlet(s), %zu imported.", importedMesh.meshName.c_str(), cookedMesh.meshlets.size(), importedMesh.meshlets.size());
+		vertexCount += cookedMesh.vertices.size();
+	}
+
+	printf("    %zu mesh(es), %zu vertices. Assimp import: %.3f ms, cooked load: %.3f ms (%.1fx).\n",
+		cookedData.meshes.size(), vertexCount, importTime, cookedTime, importTime / std::max(cookedTime, 0.001));
+}
+
+//Quantises and dequantises the vertices of the bundled models. Positions are unorm16 within the bounds, so each axis
+//must be within half a step, extent / 131070, of the original, allowing for the float rounding of the bounds. The
+//snorm16 tangent frame quaternion must keep the normal within a few steps, and the half texture coordinates within one
+//half float step.
+GEAR_TEST_CASE(VertexQuantisationRoundTrip, UNIT)
+{
+	context.ForEachModel([&](const std::string& filepath, ModelLoader::ModelData& modelData)
+	{
+		for (const ModelLoader::MeshData& mesh : modelData.meshes)
+		{
+			std::vector<ModelLoader::QuantisedVertex> quantisedVertices(mesh.vertices.size());
+			std::vector<ModelLoader::Vertex> dequantisedVertices(mesh.vertices.size());
+			ModelLoader::QuantiseVertices(mesh.vertices.data(), mesh.vertices.size(), mesh.boundingBoxMin, mesh.boundingBoxMax, quantisedVertices.data());
+			ModelLoader::DequantiseVertices(quantisedVertices.data(), quantisedVertices.size(), mesh.boundingBoxMin, mesh.boundingBoxMax, dequantisedVertices.data());
+
+			const Vec3 extent = mesh.boundingBoxMax - mesh.boundingBoxMin;
+			const float positionBounds[3] = { extent.x / 131070.0f, extent.y / 131070.0f, extent.z / 131070.0f };
+			const float roundingBound = 4.0f * FLT_EPSILON * std::max({ std::abs(mesh.boundingBoxMin.x), std::abs(mesh.boundingBoxMin.y), std::abs(mesh.boundingBoxMin.z),
+				std::abs(mesh.boundingBoxMax.x), std::abs(mesh.boundingBoxMax.y), std::abs(mesh.boundingBoxMax.z) });
+			const float normalBound = 4.0f / 32767.0f;
+
+			uint32_t positionFailures = 0, normalFailures = 0, texCoordFailures = 0;
+			float positionError = 0.0f, normalError = 0.0f, texCoordError = 0.0f;
+			for (size_t i = 0; i < mesh.vertices.size(); i++)
+			{
+				const ModelLoader::Vertex& original = mesh.vertices[i];
+				const ModelLoader::Vertex& dequantised = dequantisedVertices[i];
+
+				const float* originalPosition = &original.position.x;
+				const float* dequantisedPosition = &dequantised.position.x;
+				for (size_t j = 0; j < 3; j++)
+				{
+					const float error = std::abs(originalPosition[j] - dequantisedPosition[j]);
+					positionFailures += error > positionBounds[j] + roundingBound ? 1 : 0;
+					positionError = std::max(positionError, error / std::max(positionBounds[j], FLT_MIN));
+				}
+
+				const float normalLength = sqrtf(original.normal.x * original.normal.x + original.normal.y * original.normal.y + original.normal.z * original.normal.z);
+				if (normalLength > 0.0f)
+				{
+					const float cosine = (original.normal.x * dequantised.normal.x + original.normal.y * dequantised.normal.y + original.normal.z * dequantised.normal.z) / normalLength;
+					const float error = acosf(std::min(std::max(cosine, -1.0f), 1.0f));
+					normalFailures += error > normalBound ? 1 : 0;
+					normalError = std::max(normalError, error);
+				}
+
+				for (const std::pair<float, float>& texCoord : { std::make_pair(original.texCoord.x, dequantised.texCoord.x), std::make_pair(original.texCoord.y, dequantised.texCoord.y) })
+				{
+					const float error = std::abs(texCoord.first - texCoord.second);
+					texCoordFailures += error > std::abs(texCoord.first) / 1024.0f + 1e-7f ? 1 : 0;
+					texCoordError = std::max(texCoordError, error);
+				}
+			}
+
+			GEAR_TEST_CHECK(positionFailures == 0, "%s: %s: %u position component(s) beyond half a step. Largest error: %.3f half steps.", filepath.c_str(), mesh.meshName.c_str(), positionFailures, positionError);
+			GEAR_TEST_CHECK(normalFailures == 0, "%s: %s: %u normal(s) beyond %.4f degrees. Largest error: %.4f degrees.", filepath.c_str(), mesh.meshName.c_str(), normalFailures, normalBound * 180.0f / 3.14159265f, normalError * 180.0f / 3.14159265f);
+			GEAR_TEST_CHECK(texCoordFailures == 0, "%s: %s: %u texture coordinate(s) beyond one half float step. Largest error: %f.", filepath.c_str(), mesh.meshName.c_str(), texCoordFailures, texCoordError);
+			printf("    %s: %s: %zu -> %zu bytes per vertex. Position error: %.3f half steps, normal error: %.4f degrees, texture coordinate error: %f.\n",
+				filepath.c_str(), mesh.meshName.c_str(), ModelLoader::GetSizeOfVertex(ModelLoader::VertexFormat::FULL), ModelLoader::GetSizeOfVertex(ModelLoader::VertexFormat::QUANTISED),
+				positionError, normalError * 180.0f / 3.14159265f, texCoordError);
+		}
+	});
+}
+
+//Imports generated OBJ files of one 8x8 quad grid per node, with the meshes converted on the calling thread and on
+//the import thread pool. Every node must find the mesh of its own name, and both imports must agree.
+GEAR_TEST_CASE(ImportSerialAgainstParallel, BENCHMARK)
+{
+	for (size_t nodeCount : { 64, 256, 1024, 4096 })
+	{
+		const std::string filepath = context.GetTemporaryFilepath("ImportSerialAgainstParallel_" + std::to_string(nodeCount) + ".obj");
+		{
+			const size_t gridSize = 8;
+			std::ofstream file(filepath);
+			file << "vn 0 0 1\n";
+			for (size_t node = 0; node < nodeCount; node++)
+			{
+				file << "o node_" << node << "\n";
+				for (size_t y = 0; y <= gridSize; y++)
+					for (size_t x = 0; x <= gridSize; x++)
+						file << "v " << float(node) + float(x) / float(gridSize) << " " << float(y) / float(gridSize) << " 0\n";
+
+				const size_t firstVertex = node * (gridSize + 1) * (gridSize + 1) + 1;
+				for (size_t y = 0; y < gridSize; y++)
+				{
+					for (size_t x = 0; x < gridSize; x++)
+					{
+						const size_t v = firstVertex + y * (gridSize + 1) + x;
+						file << "f " << v << "//1 " << v + 1 << "//1 " << v + gridSize + 2 << "//1\n";
+						file << "f " << v << "//1 " << v + gridSize + 2 << "//1 " << v + gridSize + 1 << "//1\n";
+					}
+				}
+			}
+		}
+
+		const uint32_t importWorkerCount = ModelLoader::GetImportWorkerCount();
+		ModelLoader::SetImportWorkerCount(1);
+		auto start = std::chrono::high_resolution_clock::now();
+		const ModelLoader::ModelData serialData = ModelLoader::ImportModelData(filepath);
+		const double serialTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+		ModelLoader::SetImportWorkerCount(importWorkerCount);
+		start = std::chrono::high_resolution_clock::now();
+		const ModelLoader::ModelData parallelData = ModelLoader::ImportModelData(filepath);
+		const double parallelTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		std::remove(filepath.c_str());
+
+		uint32_t nodesWithMeshes = 0, mismatchedNodes = 0;
+		std::function<void(const ModelLoader::Node&)> CheckNode = [&](const ModelLoader::Node& node)
+		{
+			if (node.meshIndex < parallelData.meshes.size())
+			{
+				nodesWithMeshes++;
+				mismatchedNodes += parallelData.meshes[node.meshIndex].nodeName != node.name ? 1 : 0;
+			}
+			for (const ModelLoader::Node& child : node.children)
+				CheckNode(child);
+		};
+		CheckNode(parallelData.nodeGraph);
+
+		size_t differentMeshes = 0;
+		for (size_t i = 0; i < std::min(serialData.meshes.size(), parallelData.meshes.size()); i++)
+			differentMeshes += serialData.meshes[i].meshName != parallelData.meshes[i].meshName || serialData.meshes[i].indices != parallelData.meshes[i].indices ? 1 : 0;
+
+		GEAR_TEST_CHECK(parallelData.meshes.size() == nodeCount, "%zu mesh(es) imported from %zu node(s).", parallelData.meshes.size(), nodeCount);
+		GEAR_TEST_CHECK(nodesWithMeshes == nodeCount && mismatchedNodes == 0, "%u of %u node(s) with meshes found the mesh of another node.", mismatchedNodes, nodesWithMeshes);
+		GEAR_TEST_CHECK(serialData.meshes.size() == parallelData.meshes.size() && differentMeshes == 0, "%zu serial and %zu parallel mesh(es), %zu differ.", serialData.meshes.size(), parallelData.meshes.size(), differentMeshes);
+		printf("    %zu node(s), %zu mesh(es). Serial: %.3f ms, parallel: %.3f ms (%.1fx), %.3f ms per 1000 nodes.\n",
+			nodeCount, parallelData.meshes.size(), serialTime, parallelTime, serialTime / std::max(parallelTime, 0.001), parallelTime * 1000.0 / double(nodeCount));
+	}
+}
\ No newline at end of file
@@ -0,0 +1,447 @@
+#include "Test.h"
+
+using namespace gear;
+using namespace animation;
+using namespace graphics;
+using namespace objects;
+using namespace test;
+
+using namespace miru;
+using namespace miru::crossplatform;
+
+using namespace mars;
+
+//The kernels sum the same products in different orders, so they are compared relative to the size of the values.
+static const float Tolerance = 1e-4f;
+
+//A cylinder along +Y, bent by a chain of bones, with up to four influences per vertex. Bone b runs from y = b to b + 1,
+//and each vertex is weighted by its distance from the centres of the nearest bones. Each bone is bent about its joint
+//by a little more than its parent, and the palette holds the posed transform times the inverse of the bind transform.
+static void CreateBentCylinder(uint32_t ringCount, uint32_t ringVertexCount, uint32_t boneCount, ModelLoader::ModelData& modelData, std::vector<std::vector<Skinner::BoneMatrix>>& palettes)
+{
+	modelData = {};
+	modelData.nodeGraph.name = "Bent Cylinder";
+	modelData.nodeGraph.meshIndex = 0;
+	modelData.meshes.resize(1);
+	ModelLoader::MeshData& mesh = modelData.meshes[0];
+	mesh.meshName = "Bent Cylinder";
+	mesh.vertices.resize(ringCount * ringVertexCount);
+	mesh.bones.resize(boneCount);
+	for (uint32_t r = 0; r < ringCount; r++)
+	{
+		const float y = float(r) / float(ringCount - 1) * float(boneCount);
+		for (uint32_t s = 0; s < ringVertexCount; s++)
+		{
+			const uint32_t vertexID = r * ringVertexCount + s;
+			const float angle = 2.0f * 3.14159265f * float(s) / float(ringVertexCount);
+			ModelLoader::Vertex& vertex = mesh.vertices[vertexID];
+			vertex.position = Vec4(cosf(angle), y, sinf(angle), 1.0f);
+			vertex.texCoord = Vec2(float(s) / float(ringVertexCount), float(r) / float(ringCount));
+			vertex.normal = Vec4(cosf(angle), 0.0f, sinf(angle), 0.0f);
+			vertex.tangent = Vec4(-sinf(angle), 0.0f, cosf(angle), 0.0f);
+			vertex.binormal = Vec4(0.0f, 1.0f, 0.0f, 0.0f);
+			vertex.colour = Vec4(1.0f, 1.0f, 1.0f, 1.0f);
+
+			for (int32_t b = int32_t(y) - 2; b <= int32_t(y) + 2; b++)
+			{
+				const float weight = 2.0f - std::abs(y - (float(b) + 0.5f));
+				if (b >= 0 && b < int32_t(boneCount) && weight > 0.0f)
+					mesh.bones[b].vertexIDsAndWeights.push_back({ vertexID, weight });
+			}
+		}
+	}
+	ModelLoader::PackBoneInfluences(mesh);
+
+	palettes.assign(1, std::vector<Skinner::BoneMatrix>(boneCount));
+	std::vector<Skinner::BoneMatrix>& palette = palettes[0];
+	float jointX = 0.0f, jointY = 0.0f;
+	for (uint32_t b = 0; b < boneCount; b++)
+	{
+		const float c = cosf(0.05f * float(b + 1)), s = sinf(0.05f * float(b + 1));
+		palette[b] = { { { c, s, 0.0f, 0.0f }, { -s, c, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f, 0.0f }, { jointX + s * float(b), jointY - c * float(b), 0.0f, 1.0f } } };
+		jointX -= s;
+		jointY += c;
+	}
+}
+
+//Skins the vertices with the scalar reference kernel of the method.
+static void SkinReference(const ModelLoader::MeshData& mesh, const std::vector<Skinner::BoneMatrix>& palette, Skinner::Method method, std::vector<ModelLoader::Vertex>& reference)
+{
+	reference.resize(mesh.vertices.size());
+	if (method == Skinner::Method::DUAL_QUATERNION)
+	{
+		std::vector<Skinner::DualQuaternion> dualQuaternions(palette.size());
+		Skinner::ConvertToDualQuaternions(palette.data(), palette.size(), dualQuaternions.data());
+		Skinner::SkinDualQuaternionReference(mesh.vertices.data(), mesh.boneInfluences.data(), mesh.vertices.size(), dualQuaternions.data(), reference.data());
+	}
+	else
+	{
+		Skinner::SkinLinearBlendReference(mesh.vertices.data(), mesh.boneInfluences.data(), mesh.vertices.size(), palette.data(), reference.data());
+	}
+}
+
+//Returns the number of vertices with an attribute outside of the tolerance of the reference, and the largest difference.
+static size_t CompareVertices(const ModelLoader::Vertex* skinned, const ModelLoader::Vertex* reference, size_t count, float& maxError)
+{
+	size_t mismatches = 0;
+	maxError = 0.0f;
+	for (size_t i = 0; i < count; i++)
+	{
+		const float* a = &skinned[i].position.x;
+		const float* b = &reference[i].position.x;
+		bool mismatch = false;
+		for (size_t j = 0; j < sizeof(ModelLoader::Vertex) / sizeof(float); j++)
+		{
+			const float error = std::abs(a[j] - b[j]);
+			mismatch |= !(error <= Tolerance * std::max(1.0f, std::abs(b[j])));
+			maxError = std::max(maxError, error);
+		}
+		mismatches += mismatch ? 1 : 0;
+	}
+	return mismatches;
+}
+
+static const char* GetMethodName(Skinner::Method method)
+{
+	return method == Skinner::Method::DUAL_QUATERNION ? "Dual quaternion" : "Linear blend";
+}
+
+//The SIMD kernels, and the Skinner's parallel ranges of them, must match the scalar references.
+GEAR_TEST_CASE(SkinningKernelsMatchReference, UNIT)
+{
+	ModelLoader::ModelData modelData;
+	std::vector<std::vector<Skinner::BoneMatrix>> palettes;
+	CreateBentCylinder(64, 129, 16, modelData, palettes);
+	const ModelLoader::MeshData& mesh = modelData.meshes[0];
+	const std::vector<Skinner::BoneMatrix>& palette = palettes[0];
+	const size_t vertexCount = mesh.vertices.size();
+
+	Skinner::CreateInfo skinnerCI;
+	skinnerCI.debugName = "GEAR_CORE_TEST_Skinner";
+	skinnerCI.workerCount = 4;
+	Skinner skinner(&skinnerCI);
+
+	std::vector<Skinner::DualQuaternion> dualQuaternions(palette.size());
+	Skinner::ConvertToDualQuaternions(palette.data(), palette.size(), dualQuaternions.data());
+
+	std::vector<ModelLoader::Vertex> reference, skinned(vertexCount), parallel(vertexCount);
+	for (Skinner::Method method : { Skinner::Method::LINEAR_BLEND, Skinner::Method::DUAL_QUATERNION })
+	{
+		SkinReference(mesh, palette, method, reference);
+		if (method == Skinner::Method::DUAL_QUATERNION)
+			Skinner::SkinDualQuaternion(mesh.vertices.data(), mesh.boneInfluences.data(), vertexCount, dualQuaternions.data(), skinned.data());
+		else
+			Skinner::SkinLinearBlend(mesh.vertices.data(), mesh.boneInfluences.data(), vertexCount, palette.data(), skinned.data());
+		skinner.Skin(mesh.vertices.data(), mesh.boneInfluences.data(), vertexCount, palette.data(), palette.size(), method, parallel.data());
+
+		float error = 0.0f;
+		size_t mismatches = CompareVertices(skinned.data(), reference.data(), vertexCount, error);
+		GEAR_TEST_CHECK(mismatches == 0, "%s: %zu of %zu SIMD vertices differ from the reference. Largest difference: %g.", GetMethodName(method), mismatches, vertexCount, error);
+		mismatches = CompareVertices(parallel.data(), reference.data(), vertexCount, error);
+		GEAR_TEST_CHECK(mismatches == 0, "%s: %zu of %zu parallel vertices differ from the reference. Largest difference: %g.", GetMethodName(method), mismatches, vertexCount, error);
+
+		//The far end of the cylinder is bent away from its bind pose.
+		const Vec4& end = reference.back().position;
+		const Vec4& bindEnd = mesh.vertices.back().position;
+		GEAR_TEST_CHECK(std::abs(end.x - bindEnd.x) > 1.0f, "%s: The end of the cylinder was not moved: %f.", GetMethodName(method), end.x - bindEnd.x);
+	}
+}
+
+//Skin(Mesh&) writes into the staging memory of the Mesh's MeshPool. Each frame, the pooled vertices are uploaded, read
+//back from the block's vertex buffer and compared with the reference. The upload buffers must be reused across frames.
+GEAR_TEST_CASE(SkinIntoMeshPoolMatchesReference, DEVICE)
+{
+	Device& device = *context.device;
+
+	MeshPool::CreateInfo meshPoolCI;
+	meshPoolCI.debugName = "GEAR_CORE_TEST_SkinningMeshPool";
+	meshPoolCI.device = device.device;
+	meshPoolCI.vertexStride = ModelLoader::GetSizeOfVertex(ModelLoader::VertexFormat::FULL);
+	meshPoolCI.indexStride = ModelLoader::GetSizeOfIndex();
+	meshPoolCI.verticesPerBlock = 64 * 1024;
+	meshPoolCI.indicesPerBlock = 1024;
+	meshPoolCI.frameLatency = 3;
+	meshPoolCI.compactionThreshold = 0.5f;
+	Ref<MeshPool> meshPool = CreateRef<MeshPool>(&meshPoolCI);
+
+	Mesh::CreateInfo meshCI;
+	meshCI.debugName = "GEAR_CORE_TEST_BentCylinder";
+	meshCI.device = device.device;
+	meshCI.pMeshPool = meshPool;
+	meshCI.vertexFormat = ModelLoader::VertexFormat::FULL;
+	std::vector<std::vector<Skinner::BoneMatrix>> palettes;
+	CreateBentCylinder(64, 129, 16, meshCI.data, palettes);
+	Mesh mesh(&meshCI);
+
+	const ModelLoader::MeshData& meshData = mesh.GetModelData().meshes[0];
+	const Ref<MeshPool::Allocation>& allocation = mesh.GetAllocations()[0];
+	const size_t size = meshData.vertices.size() * meshPoolCI.vertexStride;
+
+	Buffer::CreateInfo readbackCI;
+	readbackCI.debugName = "GEAR_CORE_TEST_SkinningReadback";
+	readbackCI.device = device.device;
+	readbackCI.usage = Buffer::UsageBit::TRANSFER_DST_BIT;
+	readbackCI.size = size;
+	readbackCI.data = nullptr;
+	readbackCI.pAllocator = AllocatorManager::GetAllocator(AllocatorManager::AllocatorType::CPU);
+	Ref<Buffer> readback = Buffer::Create(&readbackCI);
+
+	Skinner::CreateInfo skinnerCI;
+	skinnerCI.debugName = "GEAR_CORE_TEST_Skinner";
+	skinnerCI.workerCount = 0;
+	Skinner skinner(&skinnerCI);
+
+	//The first upload also holds the bind pose and the indices, which the later frames' buffers may have to grow past.
+	{
+		BufferCopyBatch copyBatch;
+		meshPool->Upload(copyBatch);
+		device.Submit([&](const Ref<CommandBuffer>& cmdBuffer) { copyBatch.Record(cmdBuffer, 0); });
+		meshPool->NextFrame();
+	}
+	const uint32_t baseUploadBuffers = meshPool->GetStatistics().uploadBuffers;
+
+	std::vector<ModelLoader::Vertex> reference, pooled(meshData.vertices.size());
+	const uint32_t frameCount = 4 * meshPoolCI.frameLatency;
+	double uploadTime = 0.0;
+	for (uint32_t frame = 0; frame < frameCount; frame++)
+	{
+		const Skinner::Method method = frame % 2 ? Skinner::Method::DUAL_QUATERNION : Skinner::Method::LINEAR_BLEND;
+		skinner.Skin(mesh, palettes, method);
+		SkinReference(meshData, palettes[0], method, reference);
+
+		BufferCopyBatch copyBatch;
+		meshPool->Upload(copyBatch);
+		const MeshPool::Statistics statistics = meshPool->GetStatistics();
+		uploadTime += statistics.uploadTime;
+		GEAR_TEST_CHECK(statistics.uploadedSize == size, "Frame %u: %llu bytes uploaded, expected only the %zu bytes of the vertices.", frame, statistics.uploadedSize, size);
+
+		const Ref<Buffer>& vertexBuffer = meshPool->GetVertexBufferView(allocation->blockIndex)->GetCreateInfo().pBuffer;
+		device.Submit([&](const Ref<CommandBuffer>& cmdBuffer)
+		{
+			copyBatch.Record(cmdBuffer, 0);
+
+			Barrier::CreateInfo barrierCI;
+			barrierCI.type = Barrier::Type::BUFFER;
+			barrierCI.srcAccess = Barrier::AccessBit::TRANSFER_WRITE_BIT;
+			barrierCI.dstAccess = Barrier::AccessBit::TRANSFER_READ_BIT;
+			barrierCI.srcQueueFamilyIndex = MIRU_QUEUE_FAMILY_IGNORED;
+			barrierCI.dstQueueFamilyIndex = MIRU_QUEUE_FAMILY_IGNORED;
+			barrierCI.pBuffer = vertexBuffer;
+			barrierCI.offset = 0;
+			barrierCI.size = vertexBuffer->GetCreateInfo().size;
+			cmdBuffer->PipelineBarrier(0, PipelineStageBit::TRANSFER_BIT, PipelineStageBit::TRANSFER_BIT, DependencyBit::NONE_BIT, { Barrier::Create(&barrierCI) });
+			cmdBuffer->CopyBuffer(0, vertexBuffer, readback, { { allocation->vertexOffset * meshPoolCI.vertexStride, 0, size } });
+		});
+		readbackCI.pAllocator->AccessData(readback->GetAllocation(), size, pooled.data());
+		meshPool->NextFrame();
+
+		float error = 0.0f;
+		const size_t mismatches = CompareVertices(pooled.data(), reference.data(), pooled.size(), error);
+		GEAR_TEST_CHECK(mismatches == 0, "Frame %u: %s: %zu of %zu pooled vertices differ from the reference. Largest difference: %g.", frame, GetMethodName(method), mismatches, pooled.size(), error);
+	}
+
+	//Each of the frames' upload buffers is created or grown at most once.
+	const uint32_t uploadBuffers = meshPool->GetStatistics().uploadBuffers - baseUploadBuffers;
+	GEAR_TEST_CHECK(uploadBuffers <= meshPoolCI.frameLatency, "%u upload buffer(s) created over %u frames with a latency of %u.", uploadBuffers, frameCount, meshPoolCI.frameLatency);
+	printf("    %zu vertices over %u frames: %u upload buffer(s) created, %.3f ms per frame writing the staging data to the upload buffer.\n",
+		pooled.size(), frameCount, uploadBuffers, uploadTime / double(frameCount));
+
+	device.context->DeviceWaitIdle();
+}
+
+//Frames in flight draw the vertices uploaded for them, while the next frames are skinned and uploaded. With a latency of
+//frameLatency, a frame's fence is waited on frameLatency - 1 frames later, so its range must keep its vertices until then.
+//The bones are moved every frame, so that a range rewritten by a later frame does not match.
+GEAR_TEST_CASE(SkinnedRangesOutliveFramesInFlight, DEVICE)
+{
+	Device& device = *context.device;
+
+	MeshPool::CreateInfo meshPoolCI;
+	meshPoolCI.debugName = "GEAR_CORE_TEST_SkinningMeshPool";
+	meshPoolCI.device = device.device;
+	meshPoolCI.vertexStride = ModelLoader::GetSizeOfVertex(ModelLoader::VertexFormat::FULL);
+	meshPoolCI.indexStride = ModelLoader::GetSizeOfIndex();
+	meshPoolCI.verticesPerBlock = 64 * 1024;
+	meshPoolCI.indicesPerBlock = 1024;
+	meshPoolCI.frameLatency = 3;
+	meshPoolCI.compactionThreshold = 0.5f;
+	Ref<MeshPool> meshPool = CreateRef<MeshPool>(&meshPoolCI);
+
+	Mesh::CreateInfo meshCI;
+	meshCI.debugName = "GEAR_CORE_TEST_BentCylinder";
+	meshCI.device = device.device;
+	meshCI.pMeshPool = meshPool;
+	meshCI.vertexFormat = ModelLoader::VertexFormat::FULL;
+	std::vector<std::vector<Skinner::BoneMatrix>> palettes;
+	CreateBentCylinder(64, 129, 16, meshCI.data, palettes);
+	Mesh mesh(&meshCI);
+
+	const ModelLoader::MeshData& meshData = mesh.GetModelData().meshes[0];
+	const Ref<MeshPool::Allocation>& allocation = mesh.GetAllocations()[0];
+	const size_t size = meshData.vertices.size() * meshPoolCI.vertexStride;
+
+	Buffer::CreateInfo readbackCI;
+	readbackCI.debugName = "GEAR_CORE_TEST_SkinningReadback";
+	readbackCI.device = device.device;
+	readbackCI.usage = Buffer::UsageBit::TRANSFER_DST_BIT;
+	readbackCI.size = size;
+	readbackCI.data = nullptr;
+	readbackCI.pAllocator = AllocatorManager::GetAllocator(AllocatorManager::AllocatorType::CPU);
+	Ref<Buffer> readback = Buffer::Create(&readbackCI);
+
+	Skinner::CreateInfo skinnerCI;
+	skinnerCI.debugName = "GEAR_CORE_TEST_Skinner";
+	skinnerCI.workerCount = 0;
+	Skinner skinner(&skinnerCI);
+
+	{
+		BufferCopyBatch copyBatch;
+		meshPool->Upload(copyBatch);
+		device.Submit([&](const Ref<CommandBuffer>& cmdBuffer) { copyBatch.Record(cmdBuffer, 0); });
+		meshPool->NextFrame();
+	}
+
+	struct FrameInFlight
+	{
+		uint32_t							frame;
+		Ref<Buffer>							vertexBuffer;
+		uint32_t							vertexOffset;
+		std::vector<ModelLoader::Vertex>	reference;
+	};
+	std::deque<FrameInFlight> framesInFlight;
+	std::vector<ModelLoader::Vertex> pooled(meshData.vertices.size());
+	const uint32_t frameCount = 4 * meshPoolCI.frameLatency;
+	for (uint32_t frame = 0; frame < frameCount; frame++)
+	{
+		std::vector<std::vector<Skinner::BoneMatrix>> framePalettes = palettes;
+		for (Skinner::BoneMatrix& bone : framePalettes[0])
+			bone.columns[3][0] += float(frame + 1);
+
+		framesInFlight.push_back({ frame, nullptr, 0, {} });
+		skinner.Skin(mesh, framePalettes, Skinner::Method::LINEAR_BLEND);
+		SkinReference(meshData, framePalettes[0], Skinner::Method::LINEAR_BLEND, framesInFlight.back().reference);
+
+		BufferCopyBatch copyBatch;
+		meshPool->Upload(copyBatch);
+		device.Submit([&](const Ref<CommandBuffer>& cmdBuffer) { copyBatch.Record(cmdBuffer, 0); });
+		framesInFlight.back().vertexBuffer = meshPool->GetVertexBufferView(allocation->blockIndex)->GetCreateInfo().pBuffer;
+		framesInFlight.back().vertexOffset = allocation->vertexOffset;
+
+		//The oldest frame's fence is waited on before the next frame is skinned.
+		if (framesInFlight.size() < meshPoolCI.frameLatency)
+		{
+			meshPool->NextFrame();
+			continue;
+		}
+		const FrameInFlight& oldest = framesInFlight.front();
+		device.Submit([&](const Ref<CommandBuffer>& cmdBuffer)
+		{
+			Barrier::CreateInfo barrierCI;
+			barrierCI.type = Barrier::Type::BUFFER;
+			barrierCI.srcAccess = Barrier::AccessBit::TRANSFER_WRITE_BIT;
+			barrierCI.dstAccess = Barrier::AccessBit::TRANSFER_READ_BIT;
+			barrierCI.srcQueueFamilyIndex = MIRU_QUEUE_FAMILY_IGNORED;
+			barrierCI.dstQueueFamilyIndex = MIRU_QUEUE_FAMILY_IGNORED;
+			barrierCI.pBuffer = oldest.vertexBuffer;
+			barrierCI.offset = 0;
+			barrierCI.size = oldest.vertexBuffer->GetCreateInfo().size;
+			cmdBuffer->PipelineBarrier(0, PipelineStageBit::TRANSFER_BIT, PipelineStageBit::TRANSFER_BIT, DependencyBit::NONE_BIT, { Barrier::Create(&barrierCI) });
+			cmdBuffer->CopyBuffer(0, oldest.vertexBuffer, readback, { { oldest.vertexOffset * meshPoolCI.vertexStride, 0, size } });
+		});
+		readbackCI.pAllocator->AccessData(readback->GetAllocation(), size, pooled.data());
+
+		float error = 0.0f;
+		const size_t mismatches = CompareVertices(pooled.data(), oldest.reference.data(), pooled.size(), error);
+		GEAR_TEST_CHECK(mismatches == 0, "Frame %u: %zu of %zu vertices at offset %u were rewritten by the %u frame(s) after it. Largest difference: %g.",
+			oldest.frame, mismatches, pooled.size(), oldest.vertexOffset, meshPoolCI.frameLatency - 1, error);
+		framesInFlight.pop_front();
+		meshPool->NextFrame();
+	}
+
+	device.context->DeviceWaitIdle();
+}
+
+//The SIMD kernels against the scalar references on one core, and the Skinner's pool straight into a Mesh's staging
+//memory, on a 262144 vertex cylinder with 64 bones. With a device, the pooled vertices are also uploaded, and the copy
+//of the staging data into the upload buffer is timed.
+GEAR_TEST_CASE(SkinningKernels, BENCHMARK)
+{
+	ModelLoader::ModelData modelData;
+	std::vector<std::vector<Skinner::BoneMatrix>> palettes;
+	CreateBentCylinder(1024, 256, 64, modelData, palettes);
+	const ModelLoader::MeshData& mesh = modelData.meshes[0];
+	const std::vector<Skinner::BoneMatrix>& palette = palettes[0];
+	const size_t vertexCount = mesh.vertices.size();
+
+	std::vector<Skinner::DualQuaternion> dualQuaternions(palette.size());
+	Skinner::ConvertToDualQuaternions(palette.data(), palette.size(), dualQuaternions.data());
+
+	Skinner::CreateInfo skinnerCI;
+	skinnerCI.debugName = "GEAR_CORE_TEST_Skinner";
+	skinnerCI.workerCount = 0;
+	Skinner skinner(&skinnerCI);
+	const uint32_t workerCount = std::max(skinner.GetThreadPool()->GetWorkerCount(), 1U);
+
+	Scope<Mesh> skinnedMesh;
+	if (context.device)
+	{
+		Mesh::CreateInfo meshCI;
+		meshCI.debugName = "GEAR_CORE_TEST_BentCylinder";
+		meshCI.device = context.device->device;
+		meshCI.data = modelData;
+		meshCI.vertexFormat = ModelLoader::VertexFormat::FULL;
+		skinnedMesh = CreateScope<Mesh>(&meshCI);
+	}
+
+	auto Time = [](const std::function<void()>& function) -> double
+	{
+		const uint32_t iterations = 10;
+		const auto start = std::chrono::high_resolution_clock::now();
+		for (uint32_t i = 0; i < iterations; i++)
+			function();
+		return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count() / double(iterations);
+	};
+
+	std::vector<ModelLoader::Vertex> skinned(vertexCount), reference(vertexCount);
+	for (Skinner::Method method : { Skinner::Method::LINEAR_BLEND, Skinner::Method::DUAL_QUATERNION })
+	{
+		const bool dualQuaternion = method == Skinner::Method::DUAL_QUATERNION;
+		const double simdTime = Time([&]()
+			{
+				if (dualQuaternion)
+					Skinner::SkinDualQuaternion(mesh.vertices.data(), mesh.boneInfluences.data(), vertexCount, dualQuaternions.data(), skinned.data());
+				else
+					Skinner::SkinLinearBlend(mesh.vertices.data(), mesh.boneInfluences.data(), vertexCount, palette.data(), skinned.data());
+			});
+		const double scalarTime = Time([&]()
+			{
+				if (dualQuaternion)
+					Skinner::SkinDualQuaternionReference(mesh.vertices.data(), mesh.boneInfluences.data(), vertexCount, dualQuaternions.data(), reference.data());
+				else
+					Skinner::SkinLinearBlendReference(mesh.vertices.data(), mesh.boneInfluences.data(), vertexCount, palette.data(), reference.data());
+			});
+
+		float error = 0.0f;
+		const size_t mismatches = CompareVertices(skinned.data(), reference.data(), vertexCount, error);
+		GEAR_TEST_CHECK(mismatches == 0, "%s: %zu of %zu SIMD vertices differ from the reference. Largest difference: %g.", GetMethodName(method), mismatches, vertexCount, error);
+		printf("    %s: %zu vertices, %zu bones. SIMD: %.1f, scalar: %.1f Mvertices/s per core (%.1fx).\n",
+			GetMethodName(method), vertexCount, palette.size(), double(vertexCount) / simdTime * 1e-6, double(vertexCount) / scalarTime * 1e-6, scalarTime / std::max(simdTime, 1e-9));
+
+		if (!skinnedMesh)
+			continue;
+
+		const Ref<MeshPool>& meshPool = skinnedMesh->GetMeshPool();
+		const double parallelTime = Time([&]() { skinner.Skin(*skinnedMesh, palettes, method); });
+		BufferCopyBatch copyBatch;
+		meshPool->Upload(copyBatch);
+		context.device->Submit([&](const Ref<CommandBuffer>& cmdBuffer) { copyBatch.Record(cmdBuffer, 0); });
+		meshPool->NextFrame();
+
+		const MeshPool::Statistics statistics = meshPool->GetStatistics();
+		printf("    %s: Into the MeshPool on %u worker(s): %.1f Mvertices/s, %.1f per core. Writing %llu bytes of staging data to the upload buffer: %.3f ms.\n",
+			GetMethodName(method), workerCount, double(vertexCount) / parallelTime * 1e-6, double(vertexCount) / parallelTime * 1e-6 / double(workerCount), statistics.uploadedSize, statistics.uploadTime);
+	}
+
+	if (context.device)
+		context.device->context->DeviceWaitIdle();
+}
\ No newline at end of file
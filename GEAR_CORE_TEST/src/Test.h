@@ -0,0 +1,77 @@
+#pragma once
+
+#include "gear_core.h"
+
+namespace gear
+{
+namespace test
+{
+	//Options of the run, parsed from the command line by main().
+	struct Options
+	{
+		bool									benchmark;			//-benchmark: Also runs the benchmarks.
+		miru::crossplatform::GraphicsAPI::API	api;				//-vk or -dx12: Also runs the tests that need a device.
+		std::string								filter;				//-filter:<name>: Only runs the tests whose names contain it.
+		std::string								resourceDirectory;	//-res:<directory>: The directory that holds GEAR_TEST's res folder.
+	};
+
+	//The device shared by the tests that need one. Submit() records a CommandBuffer on the graphics queue, submits it
+	//and waits for it to complete.
+	struct Device
+	{
+		Ref<miru::crossplatform::Context>		context;
+		void*									device;
+		Ref<miru::crossplatform::CommandPool>	cmdPool;
+		Ref<miru::crossplatform::CommandBuffer>	cmdBuffer;
+		Ref<miru::crossplatform::Fence>			fence;
+
+		void Submit(const std::function<void(const Ref<miru::crossplatform::CommandBuffer>&)>& record);
+	};
+
+	//The state of the running test. Failed checks are counted and reported, and fail the run.
+	struct TestContext
+	{
+		const Options&	options;
+		Device*			device;		//nullptr, unless a graphics API has been passed.
+		uint32_t		checks;
+		uint32_t		failures;
+
+		//Returns the condition. The message is a printf format, which is only printed when the condition is false.
+		bool Check(bool condition, const char* file, int line, const char* expression, const char* format, ...);
+		//Returns the filepath of a file in GEAR_TEST's res folder, e.g. "res/obj/quad.fbx".
+		std::string GetResourceFilepath(const std::string& filepath) const;
+		//Returns the filepath of a file in GEAR_CORE_TEST's directory in the system's temporary directory, which is created.
+		std::string GetTemporaryFilepath(const std::string& filename) const;
+		//Imports quad.fbx, cube.fbx, sphere.fbx and Drone_Animated_03.fbx from GEAR_TEST's res folder with the current
+		//import settings, and calls the function with each. A model that fails to import is a failed check.
+		void ForEachModel(const std::function<void(const std::string& filepath, ModelLoader::ModelData& modelData)>& function);
+	};
+
+	struct Registration
+	{
+		enum class Type : uint32_t
+		{
+			UNIT,		//Always run.
+			DEVICE,		//Run when a graphics API has been passed.
+			BENCHMARK	//Run with -benchmark. Benchmarks check their results too.
+		};
+		typedef void(*Function)(TestContext&);
+
+		std::string	name;
+		Type		type;
+		Function	function;
+
+		Registration(const char* name, Type type, Function function);
+		static std::vector<Registration*>& GetRegistrations();
+	};
+}
+}
+
+//Defines a test, which is registered before main() is entered. The body is given a TestContext& named context.
+#define GEAR_TEST_CASE(name, type)																					\
+	static void name(gear::test::TestContext& context);																\
+	static gear::test::Registration name##_Registration(#name, gear::test::Registration::Type::type, name);		\
+	static void name(gear::test::TestContext& context)
+
+//Records a failure if the condition is false, and evaluates to the condition.
+#define GEAR_TEST_CHECK(condition, format, ...) context.Check(static_cast<bool>(condition), __FILE__, __LINE__, #condition, format, __VA_ARGS__)
\ No newline at end of file
@@ -0,0 +1,120 @@
+#include "Test.h"
+
+using namespace gear;
+using namespace graphics;
+using namespace test;
+
+using namespace miru;
+using namespace miru::crossplatform;
+
+typedef UniformBufferStructures::Model ModelUB;
+
+static const uint32_t ModelCount = 10000;
+static const uint32_t FrameCount = 60;
+
+static void SetModel(ModelUB& model, uint32_t index, uint32_t frame)
+{
+	model.modl = {};
+	model.modl.a = model.modl.f = model.modl.k = model.modl.p = 1.0f;
+	model.modl.d = static_cast<float>(index);
+	model.modl.h = static_cast<float>(frame);
+}
+
+//Compares the dedicated buffers of each Model with the UniformRing on a 10k model scene, in which every model changes
+//every frame. The dedicated path records a copy per model, which is submitted and waited on. The ring path writes the
+//models and submits the block to the frame's host visible buffer.
+GEAR_TEST_CASE(UniformRingTenThousandModels, BENCHMARK)
+{
+	if (!context.device)
+	{
+		printf("    Requires a device. Skipped.\n");
+		return;
+	}
+	Device& device = *context.device;
+
+	//Before: Dedicated upload and device buffers per model.
+	{
+		auto createStart = std::chrono::high_resolution_clock::now();
+		std::vector<Ref<Uniformbuffer<ModelUB>>> models;
+		models.reserve(ModelCount);
+		for (uint32_t i = 0; i < ModelCount; i++)
+		{
+			Uniformbuffer<ModelUB>::CreateInfo ubCI;
+			ubCI.debugName = "GEAR_CORE_TEST_Model_" + std::to_string(i);
+			ubCI.device = device.device;
+			ubCI.data = nullptr;
+			ubCI.perFrame = false;
+			models.push_back(CreateRef<Uniformbuffer<ModelUB>>(&ubCI));
+			models.back()->GetBufferView();
+		}
+		const double createTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - createStart).count();
+
+		double uploadTime = 0.0;
+		BufferCopyBatch::Statistics copyStatistics = {};
+		for (uint32_t frame = 0; frame < FrameCount; frame++)
+		{
+			auto uploadStart = std::chrono::high_resolution_clock::now();
+			BufferCopyBatch copyBatch;
+			for (uint32_t i = 0; i < ModelCount; i++)
+			{
+				SetModel(*models[i], i, frame);
+				models[i]->SubmitData();
+				models[i]->Upload(copyBatch);
+			}
+			device.Submit([&](const Ref<CommandBuffer>& cmdBuffer) { copyBatch.Record(cmdBuffer, 0); });
+			uploadTime += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - uploadStart).count();
+			copyStatistics = copyBatch.GetStatistics();
+		}
+
+		GEAR_TEST_CHECK(copyStatistics.copyCommands == ModelCount, "%u copy commands, expected one per model.", copyStatistics.copyCommands);
+		printf("    Before: %u buffer(s), %u view(s) created in %.3f ms. %u copy command(s), %llu bytes, %.3f ms per frame.\n",
+			2 * ModelCount, ModelCount, createTime, copyStatistics.copyCommands, copyStatistics.bytes, uploadTime / FrameCount);
+	}
+
+	//After: Slots in the device's UniformRing.
+	{
+		const Ref<UniformRing>& uniformRing = UniformRing::GetUniformRing(device.device);
+		uniformRing->SetFramesInFlight(2);
+		const UniformRing::Statistics baseStatistics = uniformRing->GetStatistics();
+
+		auto createStart = std::chrono::high_resolution_clock::now();
+		std::vector<Ref<Uniformbuffer<ModelUB>>> models;
+		models.reserve(ModelCount);
+		for (uint32_t i = 0; i < ModelCount; i++)
+		{
+			Uniformbuffer<ModelUB>::CreateInfo ubCI;
+			ubCI.debugName = "GEAR_CORE_TEST_Model_" + std::to_string(i);
+			ubCI.device = device.device;
+			ubCI.data = nullptr;
+			ubCI.perFrame = true;
+			models.push_back(CreateRef<Uniformbuffer<ModelUB>>(&ubCI));
+			models.back()->GetBufferView();
+		}
+		const double createTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - createStart).count();
+
+		double uploadTime = 0.0;
+		UniformRing::Statistics statistics = {};
+		for (uint32_t frame = 0; frame < FrameCount; frame++)
+		{
+			auto uploadStart = std::chrono::high_resolution_clock::now();
+			for (uint32_t i = 0; i < ModelCount; i++)
+			{
+				SetModel(*models[i], i, frame);
+				models[i]->SubmitData();
+			}
+			uniformRing->Submit(frame);
+			uploadTime += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - uploadStart).count();
+			statistics = uniformRing->GetStatistics();
+		}
+
+		const uint32_t blocks = statistics.blocks - baseStatistics.blocks;
+		GEAR_TEST_CHECK(statistics.allocations - baseStatistics.allocations == ModelCount, "%u allocation(s), expected %u.", statistics.allocations - baseStatistics.allocations, ModelCount);
+		GEAR_TEST_CHECK(statistics.submitCalls <= statistics.blocks, "%u submit call(s) for %u block(s).", statistics.submitCalls, statistics.blocks);
+		GEAR_TEST_CHECK(statistics.submittedSize >= uint64_t(ModelCount) * sizeof(ModelUB), "%llu bytes submitted.", statistics.submittedSize);
+		printf("    After: %u block(s), %u buffer(s), %u view(s) created in %.3f ms. %u submit call(s), %llu bytes, %.3f ms per frame.\n",
+			blocks, 2 * blocks, 2 * ModelCount, createTime, statistics.submitCalls, statistics.submittedSize, uploadTime / FrameCount);
+
+		models.clear();
+		GEAR_TEST_CHECK(uniformRing->GetStatistics().allocations == baseStatistics.allocations, "%u allocation(s) left after the models were destroyed.", uniformRing->GetStatistics().allocations);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,209 @@
+#include "Test.h"
+
+#include <cstdarg>
+#include <filesystem>
+
+using namespace gear;
+using namespace graphics;
+using namespace test;
+
+using namespace miru;
+using namespace miru::crossplatform;
+
+void Device::Submit(const std::function<void(const Ref<CommandBuffer>&)>& record)
+{
+	fence->Reset();
+	cmdBuffer->Reset(0, false);
+	cmdBuffer->Begin(0, CommandBuffer::UsageBit::ONE_TIME_SUBMIT);
+	record(cmdBuffer);
+	cmdBuffer->End(0);
+	cmdBuffer->Submit({ 0 }, {}, {}, {}, fence);
+	fence->Wait();
+}
+
+bool TestContext::Check(bool condition, const char* file, int line, const char* expression, const char* format, ...)
+{
+	checks++;
+	if (condition)
+		return true;
+
+	failures++;
+	printf("    %s(%d): CHECK(%s) failed: ", file, line, expression);
+	va_list args;
+	va_start(args, format);
+	vprintf(format, args);
+	va_end(args);
+	printf("\n");
+	return false;
+}
+
+std::string TestContext::GetResourceFilepath(const std::string& filepath) const
+{
+	return options.resourceDirectory + filepath;
+}
+
+std::string TestContext::GetTemporaryFilepath(const std::string& filename) const
+{
+	const std::filesystem::path directory = std::filesystem::temp_directory_path() / "GEAR_CORE_TEST";
+	std::error_code error;
+	std::filesystem::create_directories(directory, error);
+	return (directory / filename).string();
+}
+
+void TestContext::ForEachModel(const std::function<void(const std::string& filepath, ModelLoader::ModelData& modelData)>& function)
+{
+	for (const char* filepath : { "res/obj/quad.fbx", "res/obj/cube.fbx", "res/obj/sphere.fbx", "res/obj/Drone_Animated_03.fbx" })
+	{
+		ModelLoader::ModelData modelData = ModelLoader::ImportModelData(GetResourceFilepath(filepath));
+		if (Check(!modelData.meshes.empty(), __FILE__, __LINE__, "!modelData.meshes.empty()", "Unable to import %s.", filepath))
+			function(filepath, modelData);
+	}
+}
+
+Registration::Registration(const char* name, Type type, Function function)
+	: name(name), type(type), function(function)
+{
+	GetRegistrations().push_back(this);
+}
+
+std::vector<Registration*>& Registration::GetRegistrations()
+{
+	static std::vector<Registration*> registrations;
+	return registrations;
+}
+
+static Scope<Device> CreateDevice(GraphicsAPI::API api)
+{
+	GraphicsAPI::SetAPI(api);
+
+	Scope<Device> device = CreateScope<Device>();
+
+	Context::CreateInfo contextCI;
+	#ifdef _DEBUG
+	contextCI.applicationName = "GEAR_CORE_TEST(x64) Debug";
+	contextCI.instanceLayers = { "VK_LAYER_KHRONOS_validation" };
+	contextCI.instanceExtensions = {};
+	contextCI.deviceLayers = { "VK_LAYER_KHRONOS_validation" };
+	contextCI.deviceExtensions = {};
+	#else
+	contextCI.applicationName = "GEAR_CORE_TEST(x64)";
+	contextCI.instanceLayers = {};
+	contextCI.instanceExtensions = {};
+	contextCI.deviceLayers = {};
+	contextCI.deviceExtensions = {};
+	#endif
+	contextCI.api_version_major = GraphicsAPI::IsD3D12() ? 11 : 1;
+	contextCI.api_version_minor = 1;
+	contextCI.deviceDebugName = "GEAR_CORE_TEST_Context";
+	device->context = Context::Create(&contextCI);
+	if (!device->context)
+		return nullptr;
+	device->device = device->context->GetDevice();
+
+	AllocatorManager::CreateInfo mbmCI;
+	mbmCI.pContext = device->context;
+	mbmCI.defaultBlockSize = Allocator::BlockSize::BLOCK_SIZE_128MB;
+	AllocatorManager::Initialise(&mbmCI);
+
+	CommandPool::CreateInfo cmdPoolCI;
+	cmdPoolCI.debugName = "GEAR_CORE_TEST_CommandPool";
+	cmdPoolCI.pContext = device->context;
+	cmdPoolCI.flags = CommandPool::FlagBit::RESET_COMMAND_BUFFER_BIT;
+	cmdPoolCI.queueType = CommandPool::QueueType::GRAPHICS;
+	device->cmdPool = CommandPool::Create(&cmdPoolCI);
+
+	CommandBuffer::CreateInfo cmdBufferCI;
+	cmdBufferCI.debugName = "GEAR_CORE_TEST_CommandBuffer";
+	cmdBufferCI.pCommandPool = device->cmdPool;
+	cmdBufferCI.level = CommandBuffer::Level::PRIMARY;
+	cmdBufferCI.commandBufferCount = 1;
+	cmdBufferCI.allocateNewCommandPoolPerBuffer = false;
+	device->cmdBuffer = CommandBuffer::Create(&cmdBufferCI);
+
+	Fence::CreateInfo fenceCI;
+	fenceCI.debugName = "GEAR_CORE_TEST_Fence";
+	fenceCI.device = device->device;
+	fenceCI.signaled = false;
+	fenceCI.timeout = UINT64_MAX;
+	device->fence = Fence::Create(&fenceCI);
+
+	return device;
+}
+
+//Runs the unit tests, and the device tests and benchmarks that are enabled by the arguments. Returns the number of failed tests.
+int main(int argc, const char** argv)
+{
+	Options options;
+	options.benchmark = false;
+	options.api = GraphicsAPI::API::UNKNOWN;
+	options.filter = "";
+	options.resourceDirectory = "../GEAR_TEST/";
+	for (int i = 0; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (!_stricmp(argv[i], "-benchmark"))
+			options.benchmark = true;
+		if (!_stricmp(argv[i], "-vk") || !_stricmp(argv[i], "-vulkan"))
+			options.api = GraphicsAPI::API::VULKAN;
+		if (!_stricmp(argv[i], "-dx12") || !_stricmp(argv[i], "-d3d12"))
+			options.api = GraphicsAPI::API::D3D12;
+		if (arg.find("-filter:") == 0)
+			options.filter = arg.substr(std::string("-filter:").size());
+		if (arg.find("-res:") == 0)
+			options.resourceDirectory = arg.substr(std::string("-res:").size());
+	}
+	if (!options.resourceDirectory.empty() && options.resourceDirectory.back() != '/' && options.resourceDirectory.back() != '\\')
+		options.resourceDirectory += "/";
+
+	Scope<Device> device;
+	if (options.api != GraphicsAPI::API::UNKNOWN)
+	{
+		device = CreateDevice(options.api);
+		if (!device)
+		{
+			printf("GEAR_CORE_TEST: Failed to create the device.\n");
+			return 1;
+		}
+	}
+
+	uint32_t passed = 0;
+	uint32_t failed = 0;
+	uint32_t skipped = 0;
+	for (const Registration* registration : Registration::GetRegistrations())
+	{
+		const bool enabled = registration->type == Registration::Type::UNIT
+			|| (registration->type == Registration::Type::DEVICE && device)
+			|| (registration->type == Registration::Type::BENCHMARK && options.benchmark);
+		if (!enabled || registration->name.find(options.filter) == std::string::npos)
+		{
+			skipped++;
+			continue;
+		}
+
+		printf("[ RUN    ] %s\n", registration->name.c_str());
+		TestContext context = { options, device.get(), 0, 0 };
+		auto start = std::chrono::high_resolution_clock::now();
+		registration->function(context);
+		const double time = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		if (context.failures == 0)
+		{
+			printf("[     OK ] %s: %u checks (%.1f ms)\n", registration->name.c_str(), context.checks, time);
+			passed++;
+		}
+		else
+		{
+			printf("[ FAILED ] %s: %u of %u checks failed (%.1f ms)\n", registration->name.c_str(), context.failures, context.checks, time);
+			failed++;
+		}
+	}
+
+	if (device)
+	{
+		device->context->DeviceWaitIdle();
+		MeshPool::ReleaseMeshPools(device->device);
+		UniformRing::ReleaseUniformRing(device->device);
+	}
+
+	printf("\nGEAR_CORE_TEST: %u passed, %u failed, %u skipped.\n", passed, failed, skipped);
+	return static_cast<int>(failed);
+}
\ No newline at end of file
@@ -14,6 +14,10 @@ The GEAR_MIPMAP takes image files and builds mipmapped versions.
 -f:, -F:[filepath]                    : Filepath to a image file to be generated. This argument must be set.
 -o:, -O:[directory]                   : Directory for the output image files. Default is the filepath directory.
 -levels: -LEVELS:[unsigned int]       : The number of levels to generate. Optional.
+-cook, -COOK                          : Also saves all the levels to one cooked texture file for Texture to upload directly. Optional.
+-compress: -COMPRESS:[BC1|BC3|BC4|BC5|BC7] : Block compresses the levels on the CPU and saves them to a cooked texture file. Optional.
+-benchmark, -BENCHMARK                : Prints the PSNR and throughput of the CPU encoder for each block compressed format, and of the
+                                        conversion to each compact HDR storage format. Optional.
 -vk, -VK -vulkan -VULKAN              : Use Vulkan for mipmap generation.
 -dx12, -DX12, -d3d12 -D3D12           : Use Direct3D 12 for mipmap generation.
 )";
@@ -29,6 +29,8 @@ int main(int argc, const char** argv)
 	bool logo = true;
 	bool pause = false;
 	bool help = false;
+	bool cook = false;
+	bool benchmark = false;
 	for (int i = 0; i < argc; i++)
 	{
 		if (!_stricmp(argv[i], "-h") || !_stricmp(argv[i], "-help"))
@@ -41,6 +43,10 @@ int main(int argc, const char** argv)
 			logo = false;
 		if (!_stricmp(argv[i], "-nooutput"))
 			output = false;
+		if (!_stricmp(argv[i], "-cook"))
+			cook = true;
+		if (!_stricmp(argv[i], "-benchmark"))
+			benchmark = true;
 	}
 	if (logo)
 		GEAR_MIPMAP_PRINTF("GEAR_MIPMAP: Copyright  2020 Andrew Richards.\n\n");
@@ -53,6 +59,9 @@ int main(int argc, const char** argv)
 	//Get Filepath, Directories and others
 	std::string filepath, outputDir;
 	uint32_t levels = 1;
+	bool compress = false;
+	Image::Format compressFormat = Image::Format::UNKNOWN;
+	const std::vector<Image::Format> compressFormats = { Image::Format::BC1_RGBA_UNORM_BLOCK, Image::Format::BC3_UNORM_BLOCK, Image::Format::BC4_UNORM_BLOCK, Image::Format::BC5_UNORM_BLOCK, Image::Format::BC7_UNORM_BLOCK };
 	const size_t tagSize = std::string("-X:").size();
 	for (int i = 0; i < argc; i++)
 	{
@@ -72,6 +81,18 @@ int main(int argc, const char** argv)
 			tempFilepath.erase(0, std::string("-levels:").size());
 			levels = static_cast<uint32_t>(atoi(tempFilepath.c_str()));
 		}
+		if (tempFilepath.find("-compress:") != std::string::npos || tempFilepath.find("-COMPRESS:") != std::string::npos)
+		{
+			tempFilepath.erase(0, std::string("-compress:").size());
+			for (auto& format : compressFormats)
+			{
+				if (!_stricmp(tempFilepath.c_str(), TextureCompressor::GetFormatName(format).c_str()))
+				{
+					compress = true;
+					compressFormat = format;
+				}
+			}
+		}
 	}
 	if (filepath.empty())
 	{
@@ -163,6 +184,7 @@ int main(int argc, const char** argv)
 	texCI.data.width = imageWidth;
 	texCI.data.height = imageHeight;
 	texCI.data.depth = 1;
+	texCI.data.mipLevels = 1;
 	texCI.mipLevels = levels;
 	texCI.arrayLayers = 1;
 	texCI.type = miru::crossplatform::Image::Type::TYPE_2D;
@@ -257,6 +279,81 @@ int main(int argc, const char** argv)
 		}
 	}
 
+	//Compress and save out cooked texture
+	if ((cook || compress || benchmark) && error == ErrorCode::GEAR_MIPMAP_OK)
+	{
+		TextureCompressor::CreateInfo compressorCI;
+		compressorCI.debugName = "GEAR_MIPMAP_TextureCompressor";
+		compressorCI.workerCount = 0;
+		compressorCI.cacheDirectory = outputDir;
+		TextureCompressor compressor(&compressorCI);
+
+		if (benchmark)
+		{
+			for (auto& format : compressFormats)
+			{
+				std::vector<uint8_t> compressedData;
+				TextureCompressor::Statistics statistics;
+				if (compressor.Encode(format, imageDataArray.data(), imageWidth, imageHeight, 1, levels, compressedData, &statistics, true))
+				{
+					GEAR_MIPMAP_PRINTF("%s: PSNR: %.2f dB, Throughput: %.2f MTexels/s, Encode time: %.3f ms, Size: %zu bytes.\n",
+						TextureCompressor::GetFormatName(format).c_str(), statistics.psnr, statistics.megaTexelsPerSecond, statistics.encodeTime, compressedData.size());
+				}
+			}
+
+			//Compact HDR storage of level 0, compared to R32G32B32A32_SFLOAT.
+			const size_t texelCount = size_t(imageWidth) * size_t(imageHeight);
+			std::vector<float> floatData(texelCount * 4);
+			std::vector<float> decodedData(texelCount * 4);
+			std::vector<uint16_t> halfData(texelCount * 4);
+			std::vector<uint32_t> sharedExponentData(texelCount);
+			ImageDecoder::ConvertRGBA8ToRGBA32F(imageDataArray.data(), floatData.data(), texelCount);
+
+			auto BenchmarkHDRStorage = [&](const char* formatName, size_t size, const std::function<void()>& convert, const std::function<void()>& decode)
+			{
+				auto start = std::chrono::high_resolution_clock::now();
+				convert();
+				auto end = std::chrono::high_resolution_clock::now();
+				decode();
+				const double convertTime = std::chrono::duration<double, std::milli>(end - start).count();
+				const double psnr = TextureCompressor::ComputePSNR((const uint8_t*)floatData.data(), (const uint8_t*)decodedData.data(), texelCount, true, 3);
+				GEAR_MIPMAP_PRINTF("%s: PSNR: %.2f dB, Throughput: %.2f MTexels/s, Convert time: %.3f ms, Size: %zu bytes (%.0f%% of R32G32B32A32_SFLOAT).\n",
+					formatName, psnr, double(texelCount) / (convertTime * 1000.0), convertTime, size, 100.0 * double(size) / double(floatData.size() * sizeof(float)));
+			};
+			BenchmarkHDRStorage("R16G16B16A16_SFLOAT", halfData.size() * sizeof(uint16_t),
+				[&]() { ImageDecoder::ConvertRGBA32FToRGBA16F(floatData.data(), halfData.data(), texelCount); },
+				[&]() { ImageDecoder::ConvertRGBA16FToRGBA32F(halfData.data(), decodedData.data(), texelCount); });
+			BenchmarkHDRStorage("E5B9G9R9_UFLOAT_PACK32", sharedExponentData.size() * sizeof(uint32_t),
+				[&]() { ImageDecoder::ConvertRGBA32FToRGB9E5(floatData.data(), sharedExponentData.data(), texelCount); },
+				[&]() { ImageDecoder::ConvertRGB9E5ToRGBA32F(sharedExponentData.data(), decodedData.data(), texelCount); });
+		}
+
+		Texture::CookedHeader header;
+		header.format = texCI.format;
+		header.width = imageWidth;
+		header.height = imageHeight;
+		header.depth = 1;
+		header.mipLevels = levels;
+		header.arrayLayers = 1;
+		header.size = Texture::GetMipChainSize(header.format, header.width, header.height, header.depth, header.arrayLayers, header.mipLevels);
+
+		std::vector<uint8_t> compressedData;
+		const uint8_t* cookedData = imageDataArray.data();
+		if (compress && compressor.Encode(compressFormat, imageDataArray.data(), imageWidth, imageHeight, 1, levels, compressedData))
+		{
+			header.format = compressFormat;
+			header.size = compressedData.size();
+			cookedData = compressedData.data();
+		}
+
+		std::string outputFilpath = outputDir + filepath.substr(fileNamePos, extPos - fileNamePos) + GEAR_TEXTURE_COOKED_FILE_EXTENSION;
+		if ((cook || compress) && !Texture::WriteCookedTexture(outputFilpath, header, cookedData))
+		{
+			error = ErrorCode::GEAR_MIPMAP_IMAGE_FILE_SAVE_ERROR;
+			GEAR_MIPMAP_ERROR_CODE(error, ("GEAR_MIPMAP can not save cooked texture file: " + outputFilpath + ".").c_str());
+		}
+	}
+
 	if (pause)
 	{
 		system("PAUSE");
@@ -55,6 +55,7 @@ void GEAR_TEST::Run()
 	windowCI.vSync = true;
 	windowCI.samples = Image::SampleCountBit::SAMPLE_COUNT_2_BIT;
 	windowCI.graphicsDebugger = debug::GraphicsDebugger::DebuggerType::RENDER_DOC;
+	windowCI.framesInFlight = 3;
 	Ref<Window> window = CreateRef<Window>(&windowCI);
 
 	AllocatorManager::CreateInfo mbmCI;
@@ -84,6 +85,13 @@ void GEAR_TEST::Run()
 	text->AddLine(font, "FPS: " + window->GetFPSString<uint32_t>(), { 0, render_doc_offset + 2 * textRowHeight }, Vec4(1.0f, 1.0f, 1.0f, 1.0f));
 	text->AddLine(font, "MSAA: " + window->GetAntiAliasingValue() + "x", { 0, render_doc_offset + 3 * textRowHeight }, Vec4(1.0f, 1.0f, 1.0f, 1.0f));
 
+	//Models and images are loaded through the asset database, which cooks them into the cache on first use and after they change.
+	AssetDatabase::CreateInfo assetDatabaseCI;
+	assetDatabaseCI.debugName = "GEAR_TEST_AssetDatabase";
+	assetDatabaseCI.cacheDirectory = "res/cache/assets";
+	assetDatabaseCI.workerCount = 0;
+	AssetDatabase::SetAssetDatabase(CreateRef<AssetDatabase>(&assetDatabaseCI));
+
 	Skybox::CreateInfo skyboxCI;
 	skyboxCI.debugName = "Skybox-HDR";
 	skyboxCI.device = window->GetDevice();
@@ -104,6 +112,7 @@ void GEAR_TEST::Run()
 		texCI.dataType = Texture::DataType::FILE;
 		texCI.file.filepaths = &filepath;
 		texCI.file.count = 1;
+		texCI.file.flipVertically = false;
 		texCI.mipLevels = GEAR_TEXTURE_MAX_MIP_LEVEL;
 		texCI.arrayLayers = 1;
 		texCI.type = miru::crossplatform::Image::Type::TYPE_2D;
@@ -249,6 +258,7 @@ void GEAR_TEST::Run()
 	meshCI.debugName = "Drone Mesh";
 	meshCI.device = window->GetDevice();
 	meshCI.filepath = "res/obj/Drone_Animated_03.fbx";
+	meshCI.vertexFormat = ModelLoader::VertexFormat::QUANTISED;
 	Ref<Mesh> droneMesh = CreateRef<Mesh>(&meshCI);
 	droneMesh->SetOverrideMaterial(0, droneMaterial);
 
@@ -258,7 +268,7 @@ void GEAR_TEST::Run()
 	modelCI.transform.translation = Vec3(0.0, 0.5, -1.0);
 	modelCI.transform.orientation = Quat(sqrtf(2) / 2, -sqrtf(2) / 2, 0, 0);
 	modelCI.transform.scale = Vec3(0.01f, 0.01f, 0.01f);
-	modelCI.renderPipelineName = "PBROpaque";
+	modelCI.renderPipelineName = "PBROpaqueQuantised";
 	Entity drone = activeScene->CreateEntity();
 	drone.AddComponent<ModelComponent>(CreateRef<Model>(&modelCI));
 
@@ -286,22 +296,28 @@ void GEAR_TEST::Run()
 	Entity cameraEntity = activeScene->CreateEntity();
 	cameraEntity.AddComponent<CameraComponent>(std::move(CreateRef<Camera>(&cameraCI)));
 	cameraEntity.AddComponent<NativeScriptComponent>("TestScript");
+	activeScene->SetLevelOfDetail(true);
+	activeScene->SetLevelOfDetailThreshold(1.0f, (float)window->GetHeight());
 
 	Animator::CreateInfo animatorCI;
 	animatorCI.debugName = "Drone Animator";
 	animatorCI.pMesh = droneMesh;
 	Ref<Sequencer> sequencer = CreateRef<Animator>(&animatorCI);
 
-	Ref<Renderer> m_Renderer = CreateRef<Renderer>(window->GetContext());
+	Ref<Renderer> m_Renderer = CreateRef<Renderer>(window->GetContext(), window->GetFramesInFlight());
 	m_Renderer->InitialiseRenderPipelines(
 		{
 			"res/pipelines/PBROpaque.grpf.json",
+			"res/pipelines/PBROpaqueBindless.grpf.json",
+			"res/pipelines/PBROpaqueGPUDriven.grpf.json",
+			"res/pipelines/PBROpaqueQuantised.grpf.json",
 			"res/pipelines/HDR.grpf.json",
 			"res/pipelines/Cube.grpf.json",
 			"res/pipelines/Font.grpf.json",
 			"res/pipelines/DebugCoordinateAxes.grpf.json"
 		},
 		(float)window->GetWidth(), (float)window->GetHeight(), window->GetCreateInfo().samples, window->GetRenderPass());
+	m_Renderer->SetClusterCulling(true);
 
 	AllocatorManager::PrintMemoryBlockStatus();
 
@@ -315,6 +331,14 @@ void GEAR_TEST::Run()
 	bool initMouse = true;
 	core::Timer timer;
 
+	//Recording benchmark: B cycles the Renderer's recording worker count through powers of 2.
+	//F toggles printing the statistics every 120 frames, which include the benchmark's average recording time.
+	bool recordingBenchmarkKeyHeld = false;
+	bool printStatistics = false;
+	bool printStatisticsKeyHeld = false;
+	double recordingTimeSum = 0.0;
+	uint32_t recordingFrameCount = 0;
+
 	bool windowResize = false;
 	while (!window->Closed())
 	{
@@ -331,6 +355,7 @@ void GEAR_TEST::Run()
 		if (window->Resized())
 		{
 			m_Renderer->ResizeRenderPipelineViewports((uint32_t)window->GetWidth(), (uint32_t)window->GetHeight());
+			activeScene->SetLevelOfDetailThreshold(1.0f, (float)window->GetHeight());
 			//text->m_CI.viewportWidth = (uint32_t)window->GetWidth();
 			//text->m_CI.viewportHeight = (uint32_t)window->GetHeight();
 			//text->Update();
@@ -349,6 +374,23 @@ void GEAR_TEST::Run()
 			m_Renderer->ReloadTextures();
 		}
 
+		if (window->IsKeyPressed(GLFW_KEY_B) && !recordingBenchmarkKeyHeld)
+		{
+			uint32_t workerCount = m_Renderer->GetRecordingWorkerCount();
+			m_Renderer->SetRecordingWorkerCount(workerCount * 2 > core::ThreadPool::GetHardwareThreadCount() ? 1 : workerCount * 2);
+			recordingTimeSum = 0.0;
+			recordingFrameCount = 0;
+		}
+		recordingBenchmarkKeyHeld = window->IsKeyPressed(GLFW_KEY_B);
+
+		if (window->IsKeyPressed(GLFW_KEY_F) && !printStatisticsKeyHeld)
+		{
+			printStatistics = !printStatistics;
+			recordingTimeSum = 0.0;
+			recordingFrameCount = 0;
+		}
+		printStatisticsKeyHeld = window->IsKeyPressed(GLFW_KEY_F);
+
 		if (window->IsKeyPressed(GLFW_KEY_S) && window->IsKeyPressed(GLFW_KEY_LEFT_CONTROL))
 		{
 			activeScene->SaveToFile();
@@ -417,12 +459,43 @@ void GEAR_TEST::Run()
 		activeScene->OnUpdate(m_Renderer, timer);
 
 		m_Renderer->SubmitFramebuffer(window->GetFramebuffers());
-		m_Renderer->Upload(true, false, true, true);
+		m_Renderer->Upload();
 		m_Renderer->Flush();
 
+		recordingTimeSum += m_Renderer->GetStatistics().recordingTime;
+		if (++recordingFrameCount == 120)
+		{
+			if (printStatistics)
+			{
+				const Renderer::Statistics& statistics = m_Renderer->GetStatistics();
+				GEAR_PRINTF("Recording: %u worker(s), %u draw calls, %.3f ms average.\n", statistics.recordingWorkerCount, statistics.drawCalls, recordingTimeSum / recordingFrameCount);
+				GEAR_PRINTF("Binds saved: %u pipeline, %u descriptor set, %u vertex buffer, %u index buffer.\n", statistics.pipelineBindsSaved, statistics.descriptorSetBindsSaved, statistics.vertexBufferBindsSaved, statistics.indexBufferBindsSaved);
+				GEAR_PRINTF("GPU-driven: %u instance(s) in %u batch(es), %u indirect draw calls.\n", statistics.gpuDrivenInstances, statistics.gpuDrivenBatches, statistics.indirectDrawCalls);
+				GEAR_PRINTF("Upload: %llu bytes in %u copy command(s).\n", statistics.uploadBytes, statistics.uploadCopyCommands);
+				const TextureStreamer::Statistics& textureStreamerStatistics = m_Renderer->GetTextureStreamer()->GetStatistics();
+				GEAR_PRINTF("TextureStreamer: %u queued, %u in flight, %u completed texture(s), %llu byte budget, %.3f ms upload time.\n", textureStreamerStatistics.queuedTextures, textureStreamerStatistics.inFlightTextures, textureStreamerStatistics.completedTextures, textureStreamerStatistics.budget, textureStreamerStatistics.uploadTime);
+				GEAR_PRINTF("Frustum culling: %u visible, %u culled model(s).\n", activeScene->GetStatistics().visibleModels, activeScene->GetStatistics().culledModels);
+				GEAR_PRINTF("Level of detail: %u of %u triangle(s) submitted.\n", activeScene->GetStatistics().submittedTriangles, activeScene->GetStatistics().fullDetailTriangles);
+				GEAR_PRINTF("Cluster culling: %u of %u meshlet(s) culled, %u triangle(s) not drawn.\n", statistics.clustersCulled, statistics.clusters, statistics.clusterTrianglesCulled);
+				const MeshPool::Statistics meshPoolStatistics = MeshPool::GetMeshPool(window->GetDevice())->GetStatistics();
+				GEAR_PRINTF("MeshPool: %u allocation(s) in %u block(s), %u compaction(s).\n", meshPoolStatistics.allocations, meshPoolStatistics.blocks, meshPoolStatistics.compactions);
+				const MeshPool::Statistics quantisedMeshPoolStatistics = droneMesh->GetMeshPool()->GetStatistics();
+				GEAR_PRINTF("MeshPool (quantised): %u allocation(s) in %u block(s), %u compaction(s).\n", quantisedMeshPoolStatistics.allocations, quantisedMeshPoolStatistics.blocks, quantisedMeshPoolStatistics.compactions);
+				const UniformRing::Statistics uniformRingStatistics = UniformRing::GetUniformRing(window->GetDevice())->GetStatistics();
+				GEAR_PRINTF("UniformRing: %u allocation(s) in %u block(s), %llu bytes in %u submit(s), %.3f ms.\n", uniformRingStatistics.allocations, uniformRingStatistics.blocks, uniformRingStatistics.submittedSize, uniformRingStatistics.submitCalls, uniformRingStatistics.submitTime);
+				const TextureCache::Statistics textureCacheStatistics = TextureCache::GetTextureCache(window->GetDevice())->GetStatistics();
+				GEAR_PRINTF("TextureCache: %u texture(s), %u unused, %llu resident bytes, %llu hit(s), %llu miss(es), %llu eviction(s).\n", textureCacheStatistics.textures, textureCacheStatistics.unusedTextures, textureCacheStatistics.residentBytes, textureCacheStatistics.hits, textureCacheStatistics.misses, textureCacheStatistics.evictions);
+				const AssetDatabase::Statistics assetDatabaseStatistics = AssetDatabase::GetAssetDatabase()->GetStatistics();
+				GEAR_PRINTF("AssetDatabase: %u entries, %llu hit(s), %llu miss(es), %llu file(s) hashed in %.3f ms, %u cooked, %u failed, %u pending.\n", assetDatabaseStatistics.entries, assetDatabaseStatistics.hits, assetDatabaseStatistics.misses, assetDatabaseStatistics.hashedFiles, assetDatabaseStatistics.hashTime, assetDatabaseStatistics.cooks, assetDatabaseStatistics.failedCooks, assetDatabaseStatistics.pendingCooks);
+			}
+			recordingTimeSum = 0.0;
+			recordingFrameCount = 0;
+		}
+
 		m_Renderer->Present(window->GetSwapchain(), windowResize);
 		window->Update();
 		window->CalculateFPS();
 	}
 	window->GetContext()->DeviceWaitIdle();
+	AssetDatabase::SetAssetDatabase(nullptr);
 }
\ No newline at end of file